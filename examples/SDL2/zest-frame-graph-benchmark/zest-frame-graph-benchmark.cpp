@@ -0,0 +1,222 @@
+#define ZEST_IMPLEMENTATION
+#define ZEST_VULKAN_IMPLEMENTATION
+#include <zest.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+	Headless benchmark for the CPU side of frame graphs. Synthetic command graphs of 10 to 10,000 passes
+	are built, compiled and executed on a headless context and the time spent in each phase is reported
+	using zest_GetLastFrameGraphTimings. There are no windows or shaders involved so it can run on a
+	software Vulkan driver in CI.
+
+	Usage: zest-frame-graph-benchmark [iterations] [max passes] [scaling limit]
+
+	Each shape is run at every size and the cost per pass is compared with the 100 pass run of the same
+	shape. If it grows by more than the scaling limit (default 3x) the compile is scaling worse than
+	linearly and the benchmark exits with 1 so that it can be used to catch regressions.
+ */
+
+#define BENCHMARK_MAX_PASSES 10000
+#define BENCHMARK_BASELINE_PASSES 100
+#define BENCHMARK_NAME_LENGTH 24
+
+//The graphs are built in layers. Each pass in a layer reads fan_in outputs from the layer before it and
+//writes a single transient buffer, and a final pass reads the whole last layer and writes in to an
+//imported buffer so that the graph has an output. Outputs that nothing picks up get culled along with
+//any passes that only feed them.
+typedef struct benchmark_shape_t {
+	const char *name;
+	zest_uint width;				//Passes per layer, 1 for a straight chain
+	zest_uint fan_in;				//Inputs read by each pass from the previous layer, no more than width
+	zest_uint compute_percent;		//Passes that go on the compute queue, the rest go on the graphics queue
+} benchmark_shape_t;
+
+typedef struct benchmark_result_t {
+	zest_frame_graph_timings_t timings;
+	zest_uint final_passes;
+	zest_uint culled_passes;
+	zest_uint submissions;
+	zest_bool failed;
+} benchmark_result_t;
+
+typedef struct benchmark_app_t {
+	zest_device device;
+	zest_context context;
+	zest_buffer sink_buffer;
+	char (*pass_names)[BENCHMARK_NAME_LENGTH];
+	char (*resource_names)[BENCHMARK_NAME_LENGTH];
+	zest_resource_node *outputs;
+	zest_uint random_state;
+} benchmark_app_t;
+
+void EmptyTask(const zest_command_list command_list, void *user_data) {
+	//Nothing is recorded, the benchmark only measures the frame graph itself.
+}
+
+zest_uint Random(benchmark_app_t *app) {
+	//Fixed seed LCG so that every run builds the same graphs
+	app->random_state = app->random_state * 1664525u + 1013904223u;
+	return app->random_state >> 8;
+}
+
+void InitBenchmark(benchmark_app_t *app) {
+	zest_device_builder device_builder = zest_BeginVulkanDeviceBuilder(0);
+	zest_DeviceBuilderLogToConsole(device_builder);
+	app->device = zest_EndDeviceBuilder(device_builder);
+
+	zest_create_context_info_t create_info = zest_CreateContextInfo();
+	create_info.flags |= zest_context_init_flag_headless;
+	app->context = zest_CreateHeadlessContext(app->device, &create_info);
+
+	zest_buffer_info_t buffer_info = zest_CreateBufferInfo(zest_buffer_type_storage, zest_memory_usage_gpu_only);
+	app->sink_buffer = zest_CreateBuffer(app->device, 1024, &buffer_info);
+
+	//Resource and pass names are referenced by the graph rather than copied so they're made once here
+	app->pass_names = (char(*)[BENCHMARK_NAME_LENGTH])malloc(BENCHMARK_NAME_LENGTH * (BENCHMARK_MAX_PASSES + 1));
+	app->resource_names = (char(*)[BENCHMARK_NAME_LENGTH])malloc(BENCHMARK_NAME_LENGTH * BENCHMARK_MAX_PASSES);
+	app->outputs = (zest_resource_node*)malloc(sizeof(zest_resource_node) * BENCHMARK_MAX_PASSES);
+	for (int i = 0; i != BENCHMARK_MAX_PASSES; ++i) {
+		snprintf(app->pass_names[i], BENCHMARK_NAME_LENGTH, "Pass %i", i);
+		snprintf(app->resource_names[i], BENCHMARK_NAME_LENGTH, "Buffer %i", i);
+	}
+	snprintf(app->pass_names[BENCHMARK_MAX_PASSES], BENCHMARK_NAME_LENGTH, "Resolve");
+}
+
+void ShutdownBenchmark(benchmark_app_t *app) {
+	free(app->pass_names);
+	free(app->resource_names);
+	free(app->outputs);
+	zest_FreeBuffer(app->sink_buffer);
+	zest_DestroyDevice(app->device);
+}
+
+benchmark_result_t RunGraph(benchmark_app_t *app, const benchmark_shape_t *shape, zest_uint pass_count) {
+	benchmark_result_t result = {};
+	zest_buffer_resource_info_t buffer_info = {};
+	buffer_info.size = 256;
+	app->random_state = pass_count;
+
+	if (!zest_BeginCommandGraph(app->context, shape->name, 0)) {
+		result.failed = ZEST_TRUE;
+		return result;
+	}
+
+	zest_resource_node sink = zest_ImportBufferResource("Sink", app->sink_buffer, 0);
+	zest_uint width = shape->width;
+	for (zest_uint i = 0; i != pass_count; ++i) {
+		zest_uint layer_start = (i / width) * width;
+		if (Random(app) % 100 < shape->compute_percent) {
+			zest_BeginComputePass(app->pass_names[i]);
+		} else {
+			zest_BeginRenderPass(app->pass_names[i]);
+		}
+		if (layer_start) {
+			//Consecutive outputs from a random start so that a pass never reads the same buffer twice
+			zest_uint previous_start = layer_start - width;
+			zest_uint first_input = Random(app) % width;
+			for (zest_uint input = 0; input != shape->fan_in; ++input) {
+				zest_ConnectInput(app->outputs[previous_start + (first_input + input) % width]);
+			}
+		}
+		app->outputs[i] = zest_AddTransientBufferResource(app->resource_names[i], &buffer_info);
+		zest_ConnectOutput(app->outputs[i]);
+		zest_SetPassTask(EmptyTask, 0);
+		zest_EndPass();
+	}
+
+	zest_BeginRenderPass(app->pass_names[BENCHMARK_MAX_PASSES]);
+	zest_uint last_layer_start = ((pass_count - 1) / width) * width;
+	for (zest_uint i = last_layer_start; i != pass_count; ++i) {
+		zest_ConnectInput(app->outputs[i]);
+	}
+	zest_ConnectOutput(sink);
+	zest_SetPassTask(EmptyTask, 0);
+	zest_EndPass();
+
+	zest_frame_graph frame_graph = zest_EndFrameGraph();
+	result.failed = (zest_GetFrameGraphResult(frame_graph) & ZEST_FGS_FATAL) != 0;
+	result.final_passes = zest_GetFrameGraphFinalPassCount(frame_graph);
+	result.culled_passes = zest_GetFrameGraphCulledPassesCount(frame_graph);
+	result.submissions = zest_GetFrameGraphSubmissionCount(frame_graph);
+	//The graph is freed by the flush so the timings are read back from the context afterwards
+	result.failed |= zest_FlushFrameGraphAndWait(frame_graph) != zest_semaphore_status_success;
+	result.timings = zest_GetLastFrameGraphTimings(app->context);
+	return result;
+}
+
+void AddTimings(zest_frame_graph_timings_t *total, const zest_frame_graph_timings_t *timings) {
+	total->culling += timings->culling;
+	total->dependencies += timings->dependencies;
+	total->waves += timings->waves;
+	total->transient_planning += timings->transient_planning;
+	total->barriers += timings->barriers;
+	total->render_passes += timings->render_passes;
+	total->compile += timings->compile;
+	total->transient_placement += timings->transient_placement;
+	total->recording += timings->recording;
+	total->execute += timings->execute;
+}
+
+int main(int argc, char *argv[]) {
+	int iterations = argc > 1 ? atoi(argv[1]) : 10;
+	zest_uint max_passes = argc > 2 ? (zest_uint)atoi(argv[2]) : BENCHMARK_MAX_PASSES;
+	double scaling_limit = argc > 3 ? atof(argv[3]) : 3.0;
+	if (iterations < 1) iterations = 1;
+	if (max_passes > BENCHMARK_MAX_PASSES) max_passes = BENCHMARK_MAX_PASSES;
+
+	benchmark_shape_t shapes[] = {
+		{ "Chain",					1,  1, 0  },
+		{ "Fan in 4",				16, 4, 0  },
+		{ "Async compute 50%",		16, 2, 50 },
+		{ "Fan out 64, compute 25%",	64, 1, 25 },
+	};
+	zest_uint sizes[] = { 10, 100, 1000, 10000 };
+
+	benchmark_app_t app = {};
+	InitBenchmark(&app);
+
+	int exit_code = 0;
+	for (int shape_index = 0; shape_index != sizeof(shapes) / sizeof(shapes[0]); ++shape_index) {
+		benchmark_shape_t *shape = &shapes[shape_index];
+		double baseline_per_pass = 0;
+		printf("\n%s (average of %i, microseconds)\n", shape->name, iterations);
+		printf("%8s %6s %6s %6s | %8s %8s %8s %8s %8s %8s %9s | %8s %9s %9s | %8s\n",
+			"passes", "final", "culled", "subs",
+			"cull", "deps", "waves", "plan", "barriers", "rpasses", "compile",
+			"place", "record", "execute", "us/pass");
+		for (int size_index = 0; size_index != sizeof(sizes) / sizeof(sizes[0]); ++size_index) {
+			zest_uint pass_count = sizes[size_index];
+			if (pass_count > max_passes) break;
+			//Warm up so that arenas and pools are already allocated
+			benchmark_result_t result = RunGraph(&app, shape, pass_count);
+			zest_frame_graph_timings_t total = {};
+			for (int i = 0; i != iterations && !result.failed; ++i) {
+				result = RunGraph(&app, shape, pass_count);
+				AddTimings(&total, &result.timings);
+			}
+			if (result.failed) {
+				printf("%8u failed to compile or execute\n", pass_count);
+				exit_code = 1;
+				continue;
+			}
+			double per_pass = (double)(total.compile + total.execute) / iterations / pass_count;
+			printf("%8u %6u %6u %6u | %8llu %8llu %8llu %8llu %8llu %8llu %9llu | %8llu %9llu %9llu | %8.2f",
+				pass_count, result.final_passes, result.culled_passes, result.submissions,
+				total.culling / iterations, total.dependencies / iterations, total.waves / iterations,
+				total.transient_planning / iterations, total.barriers / iterations, total.render_passes / iterations,
+				total.compile / iterations, total.transient_placement / iterations, total.recording / iterations,
+				total.execute / iterations, per_pass);
+			if (pass_count == BENCHMARK_BASELINE_PASSES) {
+				baseline_per_pass = per_pass;
+			} else if (baseline_per_pass > 0 && pass_count > BENCHMARK_BASELINE_PASSES && per_pass > baseline_per_pass * scaling_limit) {
+				printf("  <- %.1fx the per pass cost at %u passes", per_pass / baseline_per_pass, BENCHMARK_BASELINE_PASSES);
+				exit_code = 1;
+			}
+			printf("\n");
+		}
+	}
+
+	ShutdownBenchmark(&app);
+	return exit_code;
+}
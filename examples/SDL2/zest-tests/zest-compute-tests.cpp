@@ -802,4 +802,506 @@ int test__headless_flush_and_wait(ZestTests *tests, Test *test) {
 	test->result |= zest_GetValidationErrorCount(tests->device);
 	test->frame_count++;
 	return test->result;
-}
\ No newline at end of file
+}
+/*
+Test parallel recording: A batch of independent compute passes is recorded on the device worker
+threads, one command buffer per group of passes that share resources. The write/verify chain
+must still produce the right result alongside the side passes and there should be no
+validation errors.
+*/
+typedef struct parallel_write_data_t {
+	ZestTests *tests;
+	const char *buffer_name;
+} parallel_write_data_t;
+
+void zest_WriteNamedBufferCompute(const zest_command_list command_list, void *user_data) {
+	parallel_write_data_t *data = (parallel_write_data_t *)user_data;
+	zest_resource_node write_buffer = zest_GetPassOutputResource(command_list, data->buffer_name);
+	ZEST_ASSERT_HANDLE(write_buffer);
+
+	const zest_uint local_size_x = 8;
+	zest_compute compute = zest_GetCompute(data->tests->compute_write);
+	zest_cmd_BindComputePipeline(command_list, compute);
+
+	TestPushConstants push;
+	push.index1 = zest_GetTransientBufferBindlessIndex(command_list, write_buffer);
+	zest_cmd_SendPushConstants(command_list, &push, sizeof(TestPushConstants));
+
+	zest_uint group_count_x = (1000 + local_size_x - 1) / local_size_x;
+	zest_cmd_DispatchCompute(command_list, group_count_x, 1, 1);
+}
+
+int test__parallel_recording(ZestTests *tests, Test *test) {
+	if (!zest_IsValidHandle((void*)&tests->compute_write)) {
+		zest_shader_handle shader = zest_CreateShaderFromFile(tests->device, "examples/SDL2/zest-tests/shaders/buffer_write.comp", "buffer_write.spv", zest_compute_shader, NULL, 1);
+		tests->compute_write = zest_CreateCompute(tests->device, "Buffer Write", shader);
+		if (!zest_IsValidHandle((void*)&tests->compute_write)) {
+			test->frame_count++;
+			test->result = 1;
+			return test->result;
+		}
+	}
+	if (!zest_IsValidHandle((void*)&tests->compute_verify)) {
+		zest_shader_handle shader = zest_CreateShaderFromFile(tests->device, "examples/SDL2/zest-tests/shaders/buffer_verify.comp", "buffer_verify.spv", zest_compute_shader, NULL, 1);
+		tests->compute_verify = zest_CreateCompute(tests->device, "Buffer Verify", shader);
+		if (!zest_IsValidHandle((void*)&tests->compute_verify)) {
+			test->frame_count++;
+			test->result = 1;
+			return test->result;
+		}
+	}
+	if (!tests->cpu_buffer) {
+		zest_buffer_info_t storage_buffer_info = zest_CreateBufferInfo(zest_buffer_type_storage, zest_memory_usage_gpu_to_cpu);
+		tests->cpu_buffer = zest_CreateBuffer(tests->device, sizeof(TestResults), &storage_buffer_info);
+		tests->cpu_buffer_index = zest_AcquireStorageBufferIndex(tests->device, tests->cpu_buffer);
+	}
+
+	zest_buffer_resource_info_t info = {};
+	info.size = sizeof(TestData) * 1000;
+
+	const char *side_buffers[4] = { "Side Buffer 0", "Side Buffer 1", "Side Buffer 2", "Side Buffer 3" };
+	const char *side_passes[4] = { "Side Pass 0", "Side Pass 1", "Side Pass 2", "Side Pass 3" };
+	parallel_write_data_t side_data[4];
+
+	zest_EnableParallelRecording(tests->context, ZEST_TRUE);
+	if (!zest_ParallelRecordingEnabled(tests->context)) {
+		test->result = 1;
+	}
+
+	if (zest_BeginCommandGraph(tests->context, "Parallel Recording", 0)) {
+		zest_resource_node buffer_a = zest_AddTransientBufferResource("Write Buffer", &info);
+		zest_resource_node verify_buffer = zest_ImportBufferResource("Verify Buffer", tests->cpu_buffer, 0);
+
+		zest_BeginComputePass("Write A");
+		zest_ConnectOutput(buffer_a);
+		zest_SetPassTask(zest_WriteBufferCompute, tests);
+		zest_EndPass();
+
+		//Side passes share nothing with the verify chain or each other so each one can be
+		//recorded by a different worker.
+		for (int i = 0; i != 4; ++i) {
+			side_data[i].tests = tests;
+			side_data[i].buffer_name = side_buffers[i];
+			zest_resource_node side_buffer = zest_AddTransientBufferResource(side_buffers[i], &info);
+			zest_FlagResourceAsEssential(side_buffer);
+			zest_BeginComputePass(side_passes[i]);
+			zest_ConnectOutput(side_buffer);
+			zest_SetPassTask(zest_WriteNamedBufferCompute, &side_data[i]);
+			zest_EndPass();
+		}
+
+		zest_BeginComputePass("Verify Pass");
+		zest_ConnectInput(buffer_a);
+		zest_ConnectOutput(verify_buffer);
+		zest_SetPassTask(zest_VerifyBufferCompute, tests);
+		zest_EndPass();
+
+		zest_frame_graph frame_graph = zest_EndFrameGraph();
+		test->result |= zest_GetFrameGraphResult(frame_graph);
+		zest_semaphore_status status = zest_FlushFrameGraphAndWait(frame_graph);
+		if (status != zest_semaphore_status_success) {
+			test->result = 1;
+		}
+	}
+
+	zest_EnableParallelRecording(tests->context, ZEST_FALSE);
+
+	TestData *test_data = (TestData *)zest_BufferData(tests->cpu_buffer);
+	if (test_data->vec.x != 1.f) {
+		test->result = 1;
+	}
+
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+/*
+Test job system: zest_ParallelFor must visit every index exactly once and jobs queued from inside other
+jobs must be finished by the time zest_WaitJobs returns.
+*/
+#define JOB_TEST_COUNT 100000
+#define JOB_TEST_NESTED 16
+
+typedef struct job_test_data_t {
+	zest_device device;
+	zest_uint *visits;
+	zest_uint worker_count;
+	volatile int nested_runs;
+	volatile int bad_worker_index;
+} job_test_data_t;
+
+void zest_JobTestParallelFor(void *user_data, zest_uint begin, zest_uint end, zest_uint worker_index) {
+	job_test_data_t *data = (job_test_data_t *)user_data;
+	if (worker_index >= data->worker_count) {
+		data->bad_worker_index = 1;
+	}
+	for (zest_uint i = begin; i != end; ++i) {
+		data->visits[i]++;
+	}
+}
+
+void zest_JobTestNestedChild(void *user_data, zest_uint worker_index) {
+	job_test_data_t *data = (job_test_data_t *)user_data;
+	zest__atomic_fetch_add(&data->nested_runs, 1);
+}
+
+void zest_JobTestNestedParent(void *user_data, zest_uint worker_index) {
+	job_test_data_t *data = (job_test_data_t *)user_data;
+	zest_job_t jobs[JOB_TEST_NESTED];
+	for (int i = 0; i != JOB_TEST_NESTED; ++i) {
+		jobs[i].callback = zest_JobTestNestedChild;
+		jobs[i].data = data;
+	}
+	zest_job_counter_t counter = {};
+	zest_RunJobs(data->device, jobs, JOB_TEST_NESTED, &counter);
+	zest_WaitJobs(data->device, &counter);
+}
+
+int test__job_system(ZestTests *tests, Test *test) {
+	job_test_data_t data = {};
+	data.device = tests->device;
+	data.worker_count = zest_GetJobWorkerCount(tests->device);
+	data.visits = (zest_uint *)zest_AllocateMemory(tests->device, sizeof(zest_uint) * JOB_TEST_COUNT);
+	memset(data.visits, 0, sizeof(zest_uint) * JOB_TEST_COUNT);
+
+	zest_ParallelFor(tests->device, JOB_TEST_COUNT, 0, zest_JobTestParallelFor, &data);
+	zest_ParallelFor(tests->device, JOB_TEST_COUNT, 7, zest_JobTestParallelFor, &data);
+	for (int i = 0; i != JOB_TEST_COUNT; ++i) {
+		if (data.visits[i] != 2) {
+			test->result = 1;
+			break;
+		}
+	}
+	if (data.bad_worker_index) {
+		test->result = 1;
+	}
+
+	zest_job_t jobs[JOB_TEST_NESTED];
+	for (int i = 0; i != JOB_TEST_NESTED; ++i) {
+		jobs[i].callback = zest_JobTestNestedParent;
+		jobs[i].data = &data;
+	}
+	zest_job_counter_t counter = {};
+	zest_RunJobs(tests->device, jobs, JOB_TEST_NESTED, &counter);
+	zest_WaitJobs(tests->device, &counter);
+	if (data.nested_runs != JOB_TEST_NESTED * JOB_TEST_NESTED || counter.pending != 0) {
+		test->result = 1;
+	}
+
+	zest_FreeMemory(tests->device, data.visits);
+	test->frame_count++;
+	return test->result;
+}
+
+/*
+Test zloc thread caches: jobs hammer one allocator through their own caches with a mix of cached and
+uncached sizes. Once every cache is flushed the pool must be back to a single free block, and the small
+allocations should mostly have been served without taking the allocator lock.
+*/
+#define CACHE_TEST_JOBS 64
+#define CACHE_TEST_ALLOCATIONS 128
+
+typedef struct cache_test_data_t {
+	zloc_allocator *allocator;
+	volatile int hits;
+	volatile int misses;
+	volatile int corrupted;
+} cache_test_data_t;
+
+void zest_CacheTestJob(void *user_data, zest_uint worker_index) {
+	cache_test_data_t *data = (cache_test_data_t *)user_data;
+	zloc_thread_cache_t cache;
+	zloc_InitialiseThreadCache(&cache, data->allocator);
+	unsigned char *allocations[CACHE_TEST_ALLOCATIONS];
+	zest_uint seed = worker_index * 7919 + 1;
+	for (int round = 0; round != 8; ++round) {
+		for (int i = 0; i != CACHE_TEST_ALLOCATIONS; ++i) {
+			seed = seed * 1103515245 + 12345;
+			zest_size size = 8 + (seed >> 16) % 1800;
+			allocations[i] = (unsigned char *)zloc_CacheAllocate(&cache, size);
+			allocations[i][0] = (unsigned char)i;
+			allocations[i][size - 1] = (unsigned char)i;
+		}
+		for (int i = 0; i != CACHE_TEST_ALLOCATIONS; ++i) {
+			if (allocations[i][0] != (unsigned char)i) {
+				data->corrupted = 1;
+			}
+			zloc_CacheFree(&cache, allocations[i]);
+		}
+	}
+	zloc_FlushThreadCache(&cache);
+	zest__atomic_fetch_add(&data->hits, (int)cache.stats.hits);
+	zest__atomic_fetch_add(&data->misses, (int)cache.stats.misses);
+}
+
+int test__thread_allocator_cache(ZestTests *tests, Test *test) {
+	zest_size pool_size = 16 * 1024 * 1024;
+	void *memory = zest_AllocateMemory(tests->device, pool_size);
+	cache_test_data_t data = {};
+	data.allocator = zloc_InitialiseAllocatorWithPool(memory, pool_size);
+
+	zest_job_t jobs[CACHE_TEST_JOBS];
+	for (int i = 0; i != CACHE_TEST_JOBS; ++i) {
+		jobs[i].callback = zest_CacheTestJob;
+		jobs[i].data = &data;
+	}
+	zest_job_counter_t counter = {};
+	zest_RunJobs(tests->device, jobs, CACHE_TEST_JOBS, &counter);
+	zest_WaitJobs(tests->device, &counter);
+
+	zloc_pool_stats_t stats = zloc_CreateMemorySnapshot(zloc_GetPool(data.allocator));
+	if (data.corrupted || stats.used_blocks != 0 || stats.free_blocks != 1) {
+		test->result = 1;
+	}
+	if (data.hits <= data.misses) {
+		test->result = 1;
+	}
+
+	zest_FreeMemory(tests->device, memory);
+	test->frame_count++;
+	return test->result;
+}
+
+/*
+Concurrent pool growth: job threads allocate from the context allocator until it has to add pools. Only
+one thread may add a pool at a time and the others must then allocate from it, so every block is still
+intact afterwards and the pool count stays in bounds.
+*/
+#define POOL_GROWTH_JOBS 32
+#define POOL_GROWTH_ALLOCATIONS 4
+#define POOL_GROWTH_BLOCK_SIZE (256 * 1024)
+
+typedef struct pool_growth_test_data_t {
+	zest_context context;
+	unsigned char *allocations[POOL_GROWTH_JOBS * POOL_GROWTH_ALLOCATIONS];
+	volatile int job_index;
+} pool_growth_test_data_t;
+
+void zest_PoolGrowthTestJob(void *user_data, zest_uint worker_index) {
+	pool_growth_test_data_t *data = (pool_growth_test_data_t *)user_data;
+	int job = zest__atomic_fetch_add(&data->job_index, 1);
+	for (int i = 0; i != POOL_GROWTH_ALLOCATIONS; ++i) {
+		int slot = job * POOL_GROWTH_ALLOCATIONS + i;
+		unsigned char *allocation = (unsigned char *)ZEST__ALLOCATE(data->context->allocator, POOL_GROWTH_BLOCK_SIZE);
+		memset(allocation, slot & 0xFF, POOL_GROWTH_BLOCK_SIZE);
+		data->allocations[slot] = allocation;
+	}
+}
+
+int test__concurrent_pool_growth(ZestTests *tests, Test *test) {
+	pool_growth_test_data_t data = {};
+	data.context = tests->context;
+	zest_uint pool_count = zest_GetMemoryUsage(tests->context).host_context_pool_count;
+
+	zest_job_t jobs[POOL_GROWTH_JOBS];
+	for (int i = 0; i != POOL_GROWTH_JOBS; ++i) {
+		jobs[i].callback = zest_PoolGrowthTestJob;
+		jobs[i].data = &data;
+	}
+	zest_job_counter_t counter = {};
+	zest_RunJobs(tests->device, jobs, POOL_GROWTH_JOBS, &counter);
+	zest_WaitJobs(tests->device, &counter);
+
+	zest_uint grown_pool_count = zest_GetMemoryUsage(tests->context).host_context_pool_count;
+	//8MB pools and 32MB of blocks, so the context has to grow, but by a handful of pools rather than one per thread
+	if (grown_pool_count <= pool_count || grown_pool_count - pool_count > 8) {
+		test->result = 1;
+	}
+	for (int slot = 0; slot != POOL_GROWTH_JOBS * POOL_GROWTH_ALLOCATIONS; ++slot) {
+		unsigned char *allocation = data.allocations[slot];
+		if (!allocation || allocation[0] != (slot & 0xFF) || allocation[POOL_GROWTH_BLOCK_SIZE - 1] != (slot & 0xFF)) {
+			test->result = 1;
+		}
+		ZEST__FREE(tests->context->allocator, allocation);
+	}
+
+	test->frame_count++;
+	return test->result;
+}
+
+/*
+Frame graph structure reuse: a cached command graph is rebuilt under a new cache key with only the size of
+its transient buffer changed. The structure is the same so the cached compile must be reused and
+re-keyed rather than compiled again, meaning the old key no longer resolves and the new key returns
+the same graph. Adding a pass changes the structure, which must still go through a full compile.
+*/
+zest_frame_graph tst__build_structure_reuse_graph(ZestTests *tests, zest_frame_graph_cache_key_t *cache_key, zest_size size, zest_bool extra_pass) {
+	zest_frame_graph frame_graph = 0;
+	zest_buffer_resource_info_t info = {};
+	info.size = size;
+	if (zest_BeginCommandGraph(tests->context, "Structure Reuse", cache_key)) {
+		zest_resource_node buffer = zest_AddTransientBufferResource("Write Buffer", &info);
+		zest_FlagResourceAsEssential(buffer);
+
+		zest_BeginComputePass("Write Pass");
+		zest_ConnectOutput(buffer);
+		zest_SetPassTask(zest_WriteBufferCompute, tests);
+		zest_EndPass();
+
+		if (extra_pass) {
+			zest_resource_node second_buffer = zest_AddTransientBufferResource("Second Write Buffer", &info);
+			zest_FlagResourceAsEssential(second_buffer);
+
+			zest_BeginComputePass("Second Write Pass");
+			zest_ConnectOutput(second_buffer);
+			zest_SetPassTask(zest_WriteBufferCompute, tests);
+			zest_EndPass();
+		}
+
+		frame_graph = zest_EndFrameGraph();
+	}
+	return frame_graph;
+}
+
+int test__frame_graph_structure_reuse(ZestTests *tests, Test *test) {
+	if (!zest_IsValidHandle((void *)&tests->compute_write)) {
+		zest_shader_handle shader = zest_CreateShaderFromFile(tests->device, "examples/SDL2/zest-tests/shaders/buffer_write.comp", "buffer_write.spv", zest_compute_shader, NULL, 1);
+		tests->compute_write = zest_CreateCompute(tests->device, "Buffer Write", shader);
+		if (!zest_IsValidHandle((void *)&tests->compute_write)) {
+			test->frame_count++;
+			test->result = 1;
+			return test->result;
+		}
+	}
+
+	zest_size first_size = sizeof(TestData) * 1000;
+	zest_size second_size = sizeof(TestData) * 2000;
+	zest_frame_graph_cache_key_t first_key = zest_InitialiseCacheKey(tests->context, &first_size, sizeof(zest_size));
+	zest_frame_graph_cache_key_t second_key = zest_InitialiseCacheKey(tests->context, &second_size, sizeof(zest_size));
+
+	zest_frame_graph first_graph = tst__build_structure_reuse_graph(tests, &first_key, first_size, ZEST_FALSE);
+	if (!first_graph) {
+		test->frame_count++;
+		test->result = 1;
+		return test->result;
+	}
+	test->result |= zest_GetFrameGraphResult(first_graph);
+	test->result |= ZEST__FLAGGED(first_graph->flags, zest_frame_graph_reused_compile);
+	test->result |= zest_FlushFrameGraphAndWait(first_graph) != zest_semaphore_status_success;
+	zest_frame_graph_cache_stats_t before = zest_GetFrameGraphCacheStats(tests->context);
+
+	//Only the buffer size differs so the cached compile is reused and moved to the new key
+	zest_frame_graph second_graph = tst__build_structure_reuse_graph(tests, &second_key, second_size, ZEST_FALSE);
+	if (!second_graph) {
+		test->frame_count++;
+		test->result = 1;
+		return test->result;
+	}
+	test->result |= zest_GetFrameGraphResult(second_graph);
+	test->result |= second_graph != first_graph;
+	test->result |= !ZEST__FLAGGED(second_graph->flags, zest_frame_graph_reused_compile);
+	test->result |= zest_FlushFrameGraphAndWait(second_graph) != zest_semaphore_status_success;
+	test->result |= zest_GetCachedFrameGraph(tests->context, &second_key) != second_graph;
+	test->result |= zest_GetCachedFrameGraph(tests->context, &first_key) != 0;
+	zest_frame_graph_cache_stats_t stats = zest_GetFrameGraphCacheStats(tests->context);
+	test->result |= stats.compile_reuses - before.compile_reuses != 1 || stats.compiles != before.compiles;
+
+	//An extra pass is a structural change so the graph has to be compiled from scratch
+	zest_frame_graph third_graph = tst__build_structure_reuse_graph(tests, &first_key, first_size, ZEST_TRUE);
+	if (third_graph) {
+		test->result |= zest_GetFrameGraphResult(third_graph);
+		test->result |= ZEST__FLAGGED(third_graph->flags, zest_frame_graph_reused_compile);
+		test->result |= zest_GetFrameGraphFinalPassCount(third_graph) != 2;
+		test->result |= zest_FlushFrameGraphAndWait(third_graph) != zest_semaphore_status_success;
+		before = stats;
+		stats = zest_GetFrameGraphCacheStats(tests->context);
+		test->result |= stats.compile_reuses != before.compile_reuses || stats.compiles - before.compiles != 1;
+	} else {
+		test->result = 1;
+	}
+
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+/*
+Frame graph cache LRU: three structurally different command graphs are cached with room for two, so
+the least recently used has to be evicted each time a new one is cached. Looking a graph up counts as
+using it, so it should survive the next eviction. Each graph should be compacted in to a block that's
+smaller than the frame graph allocator, and a byte budget that's too small for anything should empty
+the cache.
+*/
+void tst__build_cache_variant(ZestTests *tests, Test *test, zest_frame_graph_cache_key_t *cache_key, const char *name) {
+	zest_buffer_resource_info_t info = {};
+	info.size = sizeof(TestData) * 1000;
+	if (zest_BeginCommandGraph(tests->context, name, cache_key)) {
+		zest_resource_node buffer = zest_AddTransientBufferResource("Write Buffer", &info);
+		zest_FlagResourceAsEssential(buffer);
+
+		zest_BeginComputePass(name);
+		zest_ConnectOutput(buffer);
+		zest_SetPassTask(zest_WriteBufferCompute, tests);
+		zest_EndPass();
+
+		zest_frame_graph frame_graph = zest_EndFrameGraph();
+		test->result |= zest_GetFrameGraphResult(frame_graph);
+		test->result |= zest_FlushFrameGraphAndWait(frame_graph) != zest_semaphore_status_success;
+	} else {
+		test->result = 1;
+	}
+}
+
+int test__frame_graph_cache_lru(ZestTests *tests, Test *test) {
+	if (!zest_IsValidHandle((void *)&tests->compute_write)) {
+		zest_shader_handle shader = zest_CreateShaderFromFile(tests->device, "examples/SDL2/zest-tests/shaders/buffer_write.comp", "buffer_write.spv", zest_compute_shader, NULL, 1);
+		tests->compute_write = zest_CreateCompute(tests->device, "Buffer Write", shader);
+		if (!zest_IsValidHandle((void *)&tests->compute_write)) {
+			test->frame_count++;
+			test->result = 1;
+			return test->result;
+		}
+	}
+
+	const char *names[3] = { "Cache Variant A", "Cache Variant B", "Cache Variant C" };
+	zest_uint variants[3] = { 0, 1, 2 };
+	zest_frame_graph_cache_key_t keys[3];
+	for (int i = 0; i != 3; ++i) {
+		keys[i] = zest_InitialiseCacheKey(tests->context, &variants[i], sizeof(zest_uint));
+	}
+
+	zest_FlushCachedFrameGraphs(tests->context);
+	zest_frame_graph_cache_stats_t before = zest_GetFrameGraphCacheStats(tests->context);
+	zest_SetFrameGraphCacheBudget(tests->context, 0, 2);
+
+	for (int i = 0; i != 3; ++i) {
+		test->result |= zest_GetCachedFrameGraph(tests->context, &keys[i]) != 0;
+		tst__build_cache_variant(tests, test, &keys[i], names[i]);
+	}
+
+	//A was the least recently used when C was cached
+	zest_frame_graph_cache_stats_t stats = zest_GetFrameGraphCacheStats(tests->context);
+	test->result |= stats.cached_count != 2;
+	test->result |= stats.evictions - before.evictions != 1;
+	test->result |= stats.compiles - before.compiles != 3;
+	test->result |= stats.misses - before.misses != 3;
+	test->result |= zest_GetCachedFrameGraph(tests->context, &keys[0]) != 0;
+
+	//Use B so that C is the one evicted when A comes back
+	test->result |= zest_GetCachedFrameGraph(tests->context, &keys[1]) == 0;
+	tst__build_cache_variant(tests, test, &keys[0], names[0]);
+	test->result |= zest_GetCachedFrameGraph(tests->context, &keys[0]) == 0;
+	test->result |= zest_GetCachedFrameGraph(tests->context, &keys[1]) == 0;
+	test->result |= zest_GetCachedFrameGraph(tests->context, &keys[2]) != 0;
+
+	//Each graph only takes up the part of its block that it used
+	stats = zest_GetFrameGraphCacheStats(tests->context);
+	test->result |= stats.cached_count != 2;
+	test->result |= stats.cached_bytes == 0;
+	test->result |= stats.cached_bytes >= tests->context->create_info.frame_graph_allocator_size * 2;
+	test->result |= stats.hits - before.hits != 3;
+
+	//A budget too small for any graph empties the cache
+	zest_SetFrameGraphCacheBudget(tests->context, 1, 0);
+	stats = zest_GetFrameGraphCacheStats(tests->context);
+	test->result |= stats.cached_count != 0;
+	test->result |= stats.cached_bytes != 0;
+
+	zest_create_context_info_t defaults = zest_CreateContextInfo();
+	zest_SetFrameGraphCacheBudget(tests->context, defaults.frame_graph_cache_budget, defaults.max_cached_frame_graphs);
+
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
@@ -551,4 +551,83 @@ int test__stress_multi_queue_sync(ZestTests *tests, Test *test) {
 	return test->result;
 }
 
-//Next test, infinite loop of passes
\ No newline at end of file
+//Next test, infinite loop of passes
+/*
+Hash map benchmark: time inserting, looking up and removing keys in the sorted zest_hash_map and the open
+addressing zest_map_t at 10, 1k and 100k entries. Both must agree on every lookup and removing half of the
+keys must leave exactly the other half behind.
+*/
+zest_hash_map(zest_uint) bench_sorted_map_t;
+
+int test__hash_map_benchmark(ZestTests *tests, Test *test) {
+	zloc_allocator *allocator = tests->context->allocator;
+	zest_uint counts[3] = { 10, 1000, 100000 };
+	for (int c = 0; c != 3; ++c) {
+		zest_uint count = counts[c];
+		//Enough lookups that the small maps still take a measurable amount of time
+		zest_uint lookups = ZEST__MAX(count * 4, 400000u);
+		zest_key *keys = (zest_key *)zest_AllocateMemory(tests->device, sizeof(zest_key) * count);
+		for (zest_uint i = 0; i != count; ++i) {
+			keys[i] = zest_Hash(&i, sizeof(zest_uint), ZEST_HASH_SEED);
+		}
+		bench_sorted_map_t sorted = {};
+		zest_map_t open;
+		zest__initialise_map(allocator, &open, sizeof(zest_uint), 0);
+
+		zest_microsecs start = zest_Microsecs();
+		for (zest_uint i = 0; i != count; ++i) {
+			zest_map_insert_key(allocator, sorted, keys[i], i);
+		}
+		zest_microsecs sorted_insert = zest_Microsecs() - start;
+		start = zest_Microsecs();
+		for (zest_uint i = 0; i != count; ++i) {
+			zest__insert_key(&open, keys[i], &i);
+		}
+		zest_microsecs open_insert = zest_Microsecs() - start;
+
+		zest_uint sorted_sum = 0;
+		zest_uint open_sum = 0;
+		start = zest_Microsecs();
+		for (zest_uint i = 0; i != lookups; ++i) {
+			sorted_sum += *zest_map_at_key(sorted, keys[i % count]);
+		}
+		zest_microsecs sorted_lookup = zest_Microsecs() - start;
+		start = zest_Microsecs();
+		for (zest_uint i = 0; i != lookups; ++i) {
+			open_sum += *(zest_uint *)zest__at_key(&open, keys[i % count]);
+		}
+		zest_microsecs open_lookup = zest_Microsecs() - start;
+		test->result |= sorted_sum != open_sum;
+
+		start = zest_Microsecs();
+		for (zest_uint i = 0; i < count; i += 2) {
+			zest_key key = keys[i];
+			zest_map_remove_key(allocator, sorted, key);
+		}
+		zest_microsecs sorted_remove = zest_Microsecs() - start;
+		start = zest_Microsecs();
+		for (zest_uint i = 0; i < count; i += 2) {
+			zest__remove_key(&open, keys[i]);
+		}
+		zest_microsecs open_remove = zest_Microsecs() - start;
+
+		for (zest_uint i = 0; i != count; ++i) {
+			zest_bool expected = (i & 1) == 1;
+			zest_uint *value = (zest_uint *)zest__at_key(&open, keys[i]);
+			if ((zest_bool)zest_map_valid_key(sorted, keys[i]) != expected || (value != NULL) != expected || (value && *value != i)) {
+				test->result = 1;
+				break;
+			}
+		}
+		test->result |= open.current_size != count / 2;
+
+		ZEST_PRINT("Hash map %u entries: insert %llu/%lluus, %u lookups %llu/%lluus, remove half %llu/%lluus (sorted/open addressing)",
+			count, sorted_insert, open_insert, lookups, sorted_lookup, open_lookup, sorted_remove, open_remove);
+
+		zest_map_free(allocator, sorted);
+		zest__free_map(&open);
+		zest_FreeMemory(tests->device, keys);
+	}
+	test->frame_count++;
+	return test->result;
+}
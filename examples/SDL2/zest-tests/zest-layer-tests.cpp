@@ -404,3 +404,1242 @@ int test__instance_layer_fif(ZestTests *tests, Test *test) {
 	test->frame_count++;
 	return test->result;
 }
+
+/*
+Delta Upload: A frame in flight layer with delta uploads keeps its instances across
+zest_ResetInstanceLayer and only copies the pages that changed. The first upload of each frame in
+flight is a full one, after that changing two instances that are far apart should upload exactly
+two pages in two regions, and the other frame in flight's device buffer should pick up the same
+two changes when the layer flips to it. Every upload is read back to check that the device buffer
+matches what was written.
+*/
+#define DELTA_TEST_INSTANCES 4096
+#define DELTA_TEST_PAGE_SIZE 256
+
+int UploadDeltaLayer(ZestTests *tests, zest_layer layer, const zest_uint *changed, zest_uint changed_count) {
+	int result = 0;
+	zest_size data_size = DELTA_TEST_INSTANCES * sizeof(TestData);
+	zest_buffer_info_t readback_info = zest_CreateBufferInfo(zest_buffer_type_storage, zest_memory_usage_gpu_to_cpu);
+	zest_buffer readback = zest_CreateBuffer(tests->device, data_size, &readback_info);
+	memset(zest_BufferData(readback), 0, data_size);
+
+	if (zest_BeginCommandGraph(tests->context, "Layer Delta Upload", 0)) {
+		zest_resource_node layer_resource = zest_AddTransientLayerResource("Layer Data", layer, ZEST_FALSE);
+		zest_resource_node readback_resource = zest_ImportBufferResource("Readback", readback, 0);
+
+		zest_BeginTransferPass("Upload Layer");
+		zest_ConnectOutput(layer_resource);
+		zest_SetPassTask(zest_UploadInstanceLayerData, layer);
+		zest_EndPass();
+
+		zest_BeginTransferPass("Readback Layer");
+		zest_ConnectInput(layer_resource);
+		zest_ConnectOutput(readback_resource);
+		zest_SetPassTask(zest_ReadbackLayerBuffer, layer);
+		zest_EndPass();
+
+		zest_frame_graph frame_graph = zest_EndFrameGraph();
+		result |= zest_GetFrameGraphResult(frame_graph);
+		result |= zest_FlushFrameGraphAndWait(frame_graph) != zest_semaphore_status_success;
+
+		TestData *data = (TestData *)zest_BufferData(readback);
+		for (zest_uint i = 0; i != DELTA_TEST_INSTANCES; ++i) {
+			zest_uint batch = 0;
+			for (zest_uint c = 0; c != changed_count; ++c) {
+				if (changed[c] == i) batch = 1;
+			}
+			if (!LayerTestInstanceMatches(&data[i], i, batch)) {
+				ZEST_PRINT("\tDelta upload: mismatch at index %u", i);
+				result = 1;
+				break;
+			}
+		}
+	} else {
+		result = 1;
+	}
+	zest_FreeBuffer(readback);
+	return result;
+}
+
+int test__instance_layer_delta_upload(ZestTests *tests, Test *test) {
+	zest_layer_handle layer_handle = zest_CreateFIFInstanceLayer(tests->context, "Delta Layer", sizeof(TestData), DELTA_TEST_INSTANCES);
+	zest_layer layer = zest_GetLayer(layer_handle);
+	zest_EnableInstanceLayerDeltaUploads(layer, DELTA_TEST_PAGE_SIZE);
+	zest_pipeline_template pipeline = zest_CreatePipelineTemplate(tests->device, "Layer Delta Pipeline");
+	zest_size full_size = DELTA_TEST_INSTANCES * sizeof(TestData);
+
+	zest_StartInstanceDrawing(layer, pipeline);
+	for (zest_uint i = 0; i != DELTA_TEST_INSTANCES; ++i) {
+		SetLayerTestInstance((TestData *)zest_NextInstance(layer), i, 0);
+	}
+	zest_EndInstanceInstructions(layer);
+
+	//First upload to each frame in flight is a full one
+	test->result |= UploadDeltaLayer(tests, layer, 0, 0);
+	test->result |= zest_GetLayerLastUploadSize(layer) != full_size;
+	for (int fif = 1; fif != ZEST_MAX_FIF; ++fif) {
+		zest_ResetInstanceLayer(layer);
+		test->result |= zest_GetInstanceLayerCount(layer) != DELTA_TEST_INSTANCES;
+		test->result |= zest_GetLayerInstructionCount(layer) != 1;
+		test->result |= UploadDeltaLayer(tests, layer, 0, 0);
+		test->result |= zest_GetLayerLastUploadSize(layer) != full_size;
+	}
+
+	//Two changes on pages that aren't next to each other
+	zest_uint changed[2] = { 10, 3000 };
+	zest_ResetInstanceLayer(layer);
+	for (int c = 0; c != 2; ++c) {
+		SetLayerTestInstance((TestData *)zest_UpdateInstance(layer, changed[c]), changed[c], 1);
+	}
+	test->result |= UploadDeltaLayer(tests, layer, changed, 2);
+	test->result |= zest_GetLayerLastUploadSize(layer) != DELTA_TEST_PAGE_SIZE * 2;
+
+	//The other frames in flight get the same two pages when the layer flips to them
+	for (int fif = 1; fif != ZEST_MAX_FIF; ++fif) {
+		zest_ResetInstanceLayer(layer);
+		test->result |= UploadDeltaLayer(tests, layer, changed, 2);
+		test->result |= zest_GetLayerLastUploadSize(layer) != DELTA_TEST_PAGE_SIZE * 2;
+	}
+
+	zest_FreeLayer(layer_handle);
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+/*
+Direct Write: A direct frame in flight layer on a device with host visible device memory writes its
+instances straight in to the buffer the GPU reads, so it shouldn't need an upload pass at all. The
+layer starts small so that writing to it has to grow the buffer, then the device buffer is read back
+without any upload to check every instance. On devices without host visible device memory the layer
+falls back to staging and the upload pass is added as normal.
+*/
+#define DIRECT_TEST_INSTANCES 1000
+
+int ReadbackDirectLayer(ZestTests *tests, zest_layer layer, zest_uint instance_count) {
+	int result = 0;
+	zest_size data_size = instance_count * sizeof(TestData);
+	zest_buffer_info_t readback_info = zest_CreateBufferInfo(zest_buffer_type_storage, zest_memory_usage_gpu_to_cpu);
+	zest_buffer readback = zest_CreateBuffer(tests->device, data_size, &readback_info);
+	memset(zest_BufferData(readback), 0, data_size);
+
+	if (zest_BeginCommandGraph(tests->context, "Layer Direct Write", 0)) {
+		zest_resource_node layer_resource = zest_AddTransientLayerResource("Layer Data", layer, ZEST_FALSE);
+		zest_resource_node readback_resource = zest_ImportBufferResource("Readback", readback, 0);
+
+		if (zest_InstanceLayerNeedsUpload(layer)) {
+			zest_BeginTransferPass("Upload Layer");
+			zest_ConnectOutput(layer_resource);
+			zest_SetPassTask(zest_UploadInstanceLayerData, layer);
+			zest_EndPass();
+		}
+
+		zest_BeginTransferPass("Readback Layer");
+		zest_ConnectInput(layer_resource);
+		zest_ConnectOutput(readback_resource);
+		zest_SetPassTask(zest_ReadbackLayerBuffer, layer);
+		zest_EndPass();
+
+		zest_frame_graph frame_graph = zest_EndFrameGraph();
+		result |= zest_GetFrameGraphResult(frame_graph);
+		result |= zest_FlushFrameGraphAndWait(frame_graph) != zest_semaphore_status_success;
+
+		TestData *data = (TestData *)zest_BufferData(readback);
+		for (zest_uint i = 0; i != instance_count; ++i) {
+			if (!LayerTestInstanceMatches(&data[i], i, 0)) {
+				ZEST_PRINT("\tDirect write: mismatch at index %u", i);
+				result = 1;
+				break;
+			}
+		}
+	} else {
+		result = 1;
+	}
+	zest_FreeBuffer(readback);
+	return result;
+}
+
+int test__instance_layer_direct_write(ZestTests *tests, Test *test) {
+	zest_layer_handle layer_handle = zest_CreateDirectFIFInstanceLayer(tests->context, "Direct Layer", sizeof(TestData), 16);
+	zest_layer layer = zest_GetLayer(layer_handle);
+	zest_pipeline_template pipeline = zest_CreatePipelineTemplate(tests->device, "Layer Direct Pipeline");
+	zest_bool direct = zest_DeviceHasHostVisibleDeviceMemory(tests->device);
+	if (!direct) {
+		ZEST_PRINT("\tNo host visible device memory, testing the staging fallback");
+	}
+
+	zest_StartInstanceDrawing(layer, pipeline);
+	for (zest_uint i = 0; i != DIRECT_TEST_INSTANCES; ++i) {
+		SetLayerTestInstance((TestData *)zest_NextInstance(layer), i, 0);
+	}
+	zest_EndInstanceInstructions(layer);
+	test->result |= zest_GetInstanceLayerCount(layer) != DIRECT_TEST_INSTANCES;
+	test->result |= zest_InstanceLayerNeedsUpload(layer) == direct;
+
+	test->result |= ReadbackDirectLayer(tests, layer, DIRECT_TEST_INSTANCES);
+	if (direct) {
+		//Nothing should be copied even if the upload task runs anyway
+		test->result |= zest_GetLayerLastUploadSize(layer) != 0;
+	}
+
+	zest_FreeLayer(layer_handle);
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+/*
+Parallel Writing: The first batch of instances is reserved with zest_ReserveInstances and filled in
+by zest_ParallelFor, then eight writers of different sizes are filled from the job system and merged
+with zest_EndParallelInstances. The layer starts small so both paths have to grow the buffer. Every
+batch should land in order in one instruction whichever threads did the writing.
+*/
+#define PARALLEL_TEST_RESERVED 500
+#define PARALLEL_TEST_WRITERS 8
+
+typedef struct parallel_layer_test_t {
+	TestData *reserved;
+	zest_instance_writer_t *writers;
+	zest_uint writer_sizes[PARALLEL_TEST_WRITERS];
+} parallel_layer_test_t;
+
+void ParallelLayerTestReserved(void *data, zest_uint begin, zest_uint end, zest_uint worker_index) {
+	parallel_layer_test_t *test_data = (parallel_layer_test_t *)data;
+	for (zest_uint i = begin; i != end; ++i) {
+		SetLayerTestInstance(&test_data->reserved[i], i, 0);
+	}
+}
+
+void ParallelLayerTestWriters(void *data, zest_uint begin, zest_uint end, zest_uint worker_index) {
+	parallel_layer_test_t *test_data = (parallel_layer_test_t *)data;
+	for (zest_uint w = begin; w != end; ++w) {
+		for (zest_uint i = 0; i != test_data->writer_sizes[w]; ++i) {
+			SetLayerTestInstance((TestData *)zest_NextWriterInstance(&test_data->writers[w]), i, w + 1);
+		}
+	}
+}
+
+int test__instance_layer_parallel_write(ZestTests *tests, Test *test) {
+	zest_layer_handle layer_handle = zest_CreateInstanceLayer(tests->context, "Parallel Layer", sizeof(TestData), 16);
+	zest_layer layer = zest_GetLayer(layer_handle);
+	zest_pipeline_template pipeline = zest_CreatePipelineTemplate(tests->device, "Layer Parallel Pipeline");
+	parallel_layer_test_t test_data = {};
+	zest_uint batch_sizes[PARALLEL_TEST_WRITERS + 1] = { PARALLEL_TEST_RESERVED };
+	zest_uint total_instances = PARALLEL_TEST_RESERVED;
+	for (zest_uint w = 0; w != PARALLEL_TEST_WRITERS; ++w) {
+		test_data.writer_sizes[w] = (w * 37) % 100 + 1;
+		batch_sizes[w + 1] = test_data.writer_sizes[w];
+		total_instances += test_data.writer_sizes[w];
+	}
+
+	zest_StartInstanceDrawing(layer, pipeline);
+	test_data.reserved = (TestData *)zest_ReserveInstances(layer, PARALLEL_TEST_RESERVED);
+	if (!test_data.reserved) {
+		ZEST_PRINT("\tParallel: unable to reserve instances");
+		test->result = 1;
+	} else {
+		zest_ParallelFor(tests->device, PARALLEL_TEST_RESERVED, 32, ParallelLayerTestReserved, &test_data);
+	}
+
+	test_data.writers = zest_BeginParallelInstances(layer, PARALLEL_TEST_WRITERS);
+	zest_ParallelFor(tests->device, PARALLEL_TEST_WRITERS, 1, ParallelLayerTestWriters, &test_data);
+	zest_uint merged = zest_EndParallelInstances(layer);
+	zest_EndInstanceInstructions(layer);
+
+	if (merged != total_instances - PARALLEL_TEST_RESERVED || zest_GetInstanceLayerCount(layer) != total_instances) {
+		ZEST_PRINT("\tParallel: merged %u, instance count %u, expected %u", merged, zest_GetInstanceLayerCount(layer), total_instances);
+		test->result = 1;
+	}
+	zest_layer_instruction_t *instruction = zest_GetLayerInstruction(layer, 0);
+	if (zest_GetLayerInstructionCount(layer) != 1 || !instruction || instruction->total_instances != total_instances) {
+		ZEST_PRINT("\tParallel: expected a single instruction with every instance");
+		test->result = 1;
+	}
+
+	test->result |= VerifyLayerUpload(tests, layer, total_instances, PARALLEL_TEST_WRITERS + 1, batch_sizes);
+
+	zest_FreeLayer(layer_handle);
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+/*
+Draw State Elision: Draw six single instance instructions that alternate between two pipelines and
+two sets of push constants through zest_DrawInstanceLayer. Each pipeline should only be looked up once,
+binds that wouldn't change the bound pipeline or push constants should be skipped and the layer
+viewport and scissor should only be set once. The counters from zest_GetLayerDrawStats are checked
+against the number of draws and state changes the instructions need.
+*/
+int test__instance_layer_draw_state(ZestTests *tests, Test *test) {
+	zest_layer_handle layer_handle = zest_CreateInstanceLayer(tests->context, "Draw State Layer", sizeof(TestData), 8);
+	zest_layer layer = zest_GetLayer(layer_handle);
+	zest_pipeline_template pipeline_a = create_instance_pipeline_template(tests, "Layer Draw State Pipeline A");
+	zest_pipeline_template pipeline_b = create_instance_pipeline_template(tests, "Layer Draw State Pipeline B");
+	zest_pipeline_template pipelines[6] = { pipeline_a, pipeline_a, pipeline_b, pipeline_a, pipeline_b, pipeline_b };
+	TestPushConstants pushes[2] = { { 1, 2, 3, 4, 5 }, { 6, 7, 8, 9, 10 } };
+
+	for (zest_uint i = 0; i != 6; ++i) {
+		zest_StartInstanceDrawing(layer, pipelines[i]);
+		zest_SetLayerPushConstants(layer, &pushes[i / 3], sizeof(TestPushConstants));
+		TestData *instance = (TestData *)zest_NextInstance(layer);
+		SetLayerTestInstance(instance, i, 0);
+	}
+	zest_EndInstanceInstructions(layer);
+
+	zest_image_resource_info_t image_info = { zest_format_r8g8b8a8_unorm };
+	zest_execution_timeline timeline = zest_CreateExecutionTimeline(tests->device);
+	if (zest_BeginCommandGraph(tests->context, "Layer Draw State", 0)) {
+		zest_resource_node layer_resource = zest_AddTransientLayerResource("Layer Data", layer, ZEST_FALSE);
+		zest_resource_node render_target = zest_AddTransientImageResource("Draw Target", &image_info);
+
+		zest_BeginTransferPass("Upload Layer");
+		zest_ConnectOutput(layer_resource);
+		zest_SetPassTask(zest_UploadInstanceLayerData, layer);
+		zest_EndPass();
+
+		zest_BeginRenderPass("Draw Layer");
+		zest_ConnectInput(layer_resource);
+		zest_ConnectOutput(render_target);
+		zest_SetPassTask(zest_DrawInstanceLayer, layer);
+		zest_EndPass();
+
+		zest_SignalTimeline(timeline);
+		zest_frame_graph frame_graph = zest_EndFrameGraph();
+		if (zest_FlushFrameGraph(frame_graph) != zest_semaphore_status_success) {
+			test->result = 1;
+		}
+		test->result |= zest_GetFrameGraphResult(frame_graph);
+	} else {
+		test->result = 1;
+	}
+
+	//Binds: A, B, A, B. Push constants change once. Viewport and scissor are the layer's throughout.
+	zest_layer_draw_stats_t stats = zest_GetLayerDrawStats(layer);
+	if (stats.draws != 6 || stats.pipeline_lookups != 2 || stats.pipeline_binds != 4 || stats.push_constant_updates != 2
+		|| stats.viewport_updates != 1 || stats.scissor_updates != 1 || stats.elided != 2 + 4 + 5 + 5) {
+		ZEST_PRINT("\tDraw State: draws %u, lookups %u, pipeline binds %u, push constants %u, viewports %u, scissors %u, elided %u",
+			stats.draws, stats.pipeline_lookups, stats.pipeline_binds, stats.push_constant_updates, stats.viewport_updates, stats.scissor_updates, stats.elided);
+		test->result = 1;
+	}
+
+	zest_FreeLayer(layer_handle);
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+/*
+Multi Draw Indirect: Record three instance mesh instructions across two meshes in to a layer with
+multi draw indirect enabled and check that the indirect buffer holds a command for each instruction
+with the mesh's index range and vertex offset, and the instruction's instance range.
+*/
+int test__instance_mesh_layer_indirect(ZestTests *tests, Test *test) {
+	zest_vec3 positions[4] = { { 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, { 1.f, 1.f, 0.f }, { 0.f, 1.f, 0.f } };
+	zest_mesh triangle = zest_NewMesh(tests->context, sizeof(zest_vec3));
+	zest_mesh quad = zest_NewMesh(tests->context, sizeof(zest_vec3));
+	for (int i = 0; i != 3; ++i) zest_PushMeshVertexData(triangle, &positions[i]);
+	for (int i = 0; i != 4; ++i) zest_PushMeshVertexData(quad, &positions[i]);
+	zest_PushMeshTriangle(triangle, 0, 1, 2);
+	zest_PushMeshTriangle(quad, 0, 1, 2);
+	zest_PushMeshTriangle(quad, 0, 2, 3);
+
+	zest_layer_handle layer_handle = zest_CreateInstanceMeshLayer(tests->context, "Indirect Mesh Layer", sizeof(TestData),
+		zest_MeshVertexDataSize(triangle) + zest_MeshVertexDataSize(quad), zest_MeshIndexDataSize(triangle) + zest_MeshIndexDataSize(quad));
+	zest_layer layer = zest_GetLayer(layer_handle);
+	zest_uint meshes[2] = { zest_AddMeshToLayer(layer, triangle, 0), zest_AddMeshToLayer(layer, quad, 0) };
+	zest_EnableLayerMultiDrawIndirect(layer);
+	zest_pipeline_template pipeline = zest_CreatePipelineTemplate(tests->device, "Layer Indirect Pipeline");
+
+	const zest_uint draw_meshes[3] = { 0, 1, 0 };
+	const zest_uint draw_instances[3] = { 3, 5, 2 };
+	for (zest_uint draw = 0; draw != 3; ++draw) {
+		zest_StartInstanceMeshDrawing(layer, meshes[draw_meshes[draw]], pipeline);
+		for (zest_uint i = 0; i != draw_instances[draw]; ++i) {
+			SetLayerTestInstance((TestData *)zest_NextInstance(layer), i, draw);
+		}
+	}
+	zest_EndInstanceInstructions(layer);
+
+	zest_buffer indirect = zest_GetLayerIndirectBuffer(layer);
+	if (!indirect || zest_GetLayerInstructionCount(layer) != 3) {
+		ZEST_PRINT("\tIndirect: expected an indirect buffer and 3 instructions");
+		test->result = 1;
+	} else {
+		zest_draw_indexed_indirect_command_t *commands = (zest_draw_indexed_indirect_command_t *)zest_BufferData(indirect);
+		zest_uint first_instance = 0;
+		for (zest_uint draw = 0; draw != 3; ++draw) {
+			const zest_mesh_offset_data_t *offsets = zest_GetLayerMeshOffsets(layer, meshes[draw_meshes[draw]]);
+			zest_draw_indexed_indirect_command_t *command = &commands[draw];
+			if (command->index_count != offsets->index_count || command->first_index != offsets->index_offset
+				|| command->vertex_offset != (int32_t)offsets->vertex_offset || command->instance_count != draw_instances[draw]
+				|| command->first_instance != first_instance) {
+				ZEST_PRINT("\tIndirect: command %u doesn't match its instruction", draw);
+				test->result = 1;
+			}
+			first_instance += draw_instances[draw];
+		}
+		//The quad comes after the triangle in the layer's vertex and index buffers
+		if (commands[1].first_index != 3 || commands[1].vertex_offset != 3 || commands[1].index_count != 6) {
+			test->result = 1;
+		}
+	}
+
+	zest_FreeLayer(layer_handle);
+	zest_FreeMesh(triangle);
+	zest_FreeMesh(quad);
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+//Copies the culled instances out of the cull pass's transient buffer
+void zest_ReadbackCulledInstances(const zest_command_list command_list, void *user_data) {
+	zest_layer layer = (zest_layer)user_data;
+	zest_buffer src = zest_GetPassInputBuffer(command_list, "Layer Culled Instances");
+	zest_buffer dst = zest_GetPassOutputBuffer(command_list, "Readback");
+	zest_size size = zest_GetLayerVertexMemoryInUse(layer);
+	if (src && dst && size) {
+		zest_cmd_CopyBuffer(command_list, src, dst, size);
+	}
+}
+
+/*
+GPU Culling: Record three instance mesh instructions with instances inside and outside of a box
+shaped view, run the layer's cull pass and check that the shader counted only the visible instances
+in to each indirect command and compacted them to the start of each draw's range. The last draw uses
+a mesh with no bounds so none of its instances are culled.
+*/
+int test__instance_mesh_layer_gpu_culling(ZestTests *tests, Test *test) {
+	zest_vec3 positions[4] = { { 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, { 1.f, 1.f, 0.f }, { 0.f, 1.f, 0.f } };
+	zest_mesh triangle = zest_NewMesh(tests->context, sizeof(zest_vec3));
+	zest_mesh quad = zest_NewMesh(tests->context, sizeof(zest_vec3));
+	for (int i = 0; i != 3; ++i) zest_PushMeshVertexData(triangle, &positions[i]);
+	for (int i = 0; i != 4; ++i) zest_PushMeshVertexData(quad, &positions[i]);
+	zest_PushMeshTriangle(triangle, 0, 1, 2);
+	zest_PushMeshTriangle(quad, 0, 1, 2);
+	zest_PushMeshTriangle(quad, 0, 2, 3);
+
+	zest_layer_handle layer_handle = zest_CreateInstanceMeshLayer(tests->context, "Culled Mesh Layer", sizeof(TestData),
+		zest_MeshVertexDataSize(triangle) * 2 + zest_MeshVertexDataSize(quad), zest_MeshIndexDataSize(triangle) * 2 + zest_MeshIndexDataSize(quad));
+	zest_layer layer = zest_GetLayer(layer_handle);
+	zest_uint meshes[3] = { zest_AddMeshToLayer(layer, triangle, 0), zest_AddMeshToLayer(layer, quad, 0), zest_AddMeshToLayer(layer, triangle, 0) };
+	if (!zest_EnableLayerGPUCulling(layer, offsetof(TestData, vec), ZEST_INVALID)) {
+		ZEST_PRINT("\tGPU Culling: unable to enable culling");
+		test->result = 1;
+	}
+	//Only the first two meshes are given bounds, they both fit in a unit box at the origin
+	zest_bounding_box_t bounds = { { 0.f, 0.f, 0.f }, { 1.f, 1.f, 0.f } };
+	zest_SetLayerMeshBounds(layer, meshes[0], bounds);
+	zest_SetLayerMeshBounds(layer, meshes[1], bounds);
+
+	//A view that holds everything from -10 to 10 on each axis
+	zest_layer_cull_view_t view = {};
+	view.planes[0] = zest_Vec4Set(1.f, 0.f, 0.f, 10.f);
+	view.planes[1] = zest_Vec4Set(-1.f, 0.f, 0.f, 10.f);
+	view.planes[2] = zest_Vec4Set(0.f, 1.f, 0.f, 10.f);
+	view.planes[3] = zest_Vec4Set(0.f, -1.f, 0.f, 10.f);
+	view.planes[4] = zest_Vec4Set(0.f, 0.f, 1.f, 10.f);
+	view.planes[5] = zest_Vec4Set(0.f, 0.f, -1.f, 10.f);
+	zest_SetLayerCullView(layer, &view);
+
+	//The x position of each instance, w holds the instance's index so the survivors can be found
+	const zest_uint draw_instances[3] = { 4, 3, 2 };
+	const float draw_x[9] = { 0.f, 50.f, 1.f, -50.f, -50.f, 2.f, 3.f, 50.f, -50.f };
+	const zest_uint visible_counts[3] = { 2, 2, 2 };
+	const zest_uint visible_masks[3] = { (1 << 0) | (1 << 2), (1 << 5) | (1 << 6), (1 << 7) | (1 << 8) };
+	zest_pipeline_template pipeline = zest_CreatePipelineTemplate(tests->device, "Layer Cull Pipeline");
+	zest_uint instance_index = 0;
+	for (zest_uint draw = 0; draw != 3; ++draw) {
+		zest_StartInstanceMeshDrawing(layer, meshes[draw], pipeline);
+		for (zest_uint i = 0; i != draw_instances[draw]; ++i) {
+			TestData *instance = (TestData *)zest_NextInstance(layer);
+			instance->vec = zest_Vec4Set(draw_x[instance_index], 0.f, 0.f, (float)instance_index);
+			instance_index++;
+		}
+	}
+	zest_EndInstanceInstructions(layer);
+
+	zest_size data_size = instance_index * sizeof(TestData);
+	zest_buffer_info_t readback_info = zest_CreateBufferInfo(zest_buffer_type_storage, zest_memory_usage_gpu_to_cpu);
+	zest_buffer readback = zest_CreateBuffer(tests->device, data_size, &readback_info);
+	memset(zest_BufferData(readback), 0, data_size);
+
+	zest_execution_timeline timeline = zest_CreateExecutionTimeline(tests->device);
+	if (!test->result && zest_BeginCommandGraph(tests->context, "Layer Cull", 0)) {
+		zest_resource_node layer_resource = zest_AddTransientLayerResource("Layer Data", layer, ZEST_FALSE);
+		zest_resource_node readback_resource = zest_ImportBufferResource("Readback", readback, 0);
+
+		zest_BeginTransferPass("Upload Layer");
+		zest_ConnectOutput(layer_resource);
+		zest_SetPassTask(zest_UploadInstanceLayerData, layer);
+		zest_EndPass();
+
+		zest_resource_node culled = zest_AddLayerCullPass(layer, layer_resource, 0);
+
+		zest_BeginTransferPass("Readback Culled");
+		zest_ConnectInput(culled);
+		zest_ConnectOutput(readback_resource);
+		zest_SetPassTask(zest_ReadbackCulledInstances, layer);
+		zest_EndPass();
+
+		zest_SignalTimeline(timeline);
+		zest_frame_graph frame_graph = zest_EndFrameGraph();
+		zest_semaphore_status status = zest_FlushFrameGraph(frame_graph);
+		if (status != zest_semaphore_status_success || zest_GetFrameGraphResult(frame_graph) != 0) {
+			ZEST_PRINT("\tGPU Culling: flush status %i, frame graph result %i", (int)status, (int)zest_GetFrameGraphResult(frame_graph));
+			test->result = 1;
+		}
+
+		zest_draw_indexed_indirect_command_t *commands = (zest_draw_indexed_indirect_command_t *)zest_BufferData(zest_GetLayerIndirectBuffer(layer));
+		TestData *data = (TestData *)zest_BufferData(readback);
+		zest_uint first_instance = 0;
+		for (zest_uint draw = 0; draw != 3 && !test->result; ++draw) {
+			if (commands[draw].instance_count != visible_counts[draw]) {
+				ZEST_PRINT("\tGPU Culling: draw %u has %u visible instances, expected %u", draw, commands[draw].instance_count, visible_counts[draw]);
+				test->result = 1;
+				break;
+			}
+			//The order that the survivors are written in depends on the order the shader invocations ran
+			zest_uint found = 0;
+			for (zest_uint i = 0; i != visible_counts[draw]; ++i) {
+				found |= 1 << (zest_uint)data[first_instance + i].vec.w;
+			}
+			if (found != visible_masks[draw]) {
+				ZEST_PRINT("\tGPU Culling: draw %u kept the wrong instances", draw);
+				test->result = 1;
+			}
+			first_instance += draw_instances[draw];
+		}
+	} else if (!test->result) {
+		ZEST_PRINT("\tGPU Culling: BeginCommandGraph failed");
+		test->result = 1;
+	}
+
+	zest_FreeExecutionTimeline(timeline);
+	zest_FreeBuffer(readback);
+	zest_FreeLayer(layer_handle);
+	zest_FreeMesh(triangle);
+	zest_FreeMesh(quad);
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+/*
+Instance Store: Instances added to a store keep their ids while other instances come and go. Removing
+an instance moves the last one in to its slot so the instances stay packed, an id that was removed
+is no longer valid and adding again reuses the freed id with a new generation. After each change the
+layer should hold a single instruction covering the whole store and the device buffer is read back to
+check that the moved and changed instances were uploaded. The store then carries over to the next
+frame in flight with zest_ResetInstanceLayer.
+*/
+#define STORE_TEST_INSTANCES 5
+
+int test__instance_layer_store(ZestTests *tests, Test *test) {
+	zest_layer_handle layer_handle = zest_CreateFIFInstanceLayer(tests->context, "Store Layer", sizeof(TestData), STORE_TEST_INSTANCES);
+	zest_layer layer = zest_GetLayer(layer_handle);
+	zest_pipeline_template pipeline = zest_CreatePipelineTemplate(tests->device, "Layer Store Pipeline");
+	zest_EnableInstanceStore(layer, pipeline);
+	zest_uint batch_sizes[1] = { STORE_TEST_INSTANCES };
+
+	zest_instance_id ids[STORE_TEST_INSTANCES] = {};
+	for (zest_uint i = 0; i != STORE_TEST_INSTANCES; ++i) {
+		SetLayerTestInstance((TestData *)zest_AddStoreInstance(layer, &ids[i]), i, 0);
+		test->result |= ids[i] == 0;
+	}
+	test->result |= zest_GetInstanceLayerCount(layer) != STORE_TEST_INSTANCES;
+	test->result |= zest_GetLayerInstructionCount(layer) != 1;
+
+	//The last instance moves in to the removed one's slot
+	zest_RemoveStoreInstance(layer, ids[1]);
+	test->result |= zest_StoreInstanceIsValid(layer, ids[1]);
+	test->result |= zest_GetStoreInstanceSlot(layer, ids[1]) != ZEST_INVALID;
+	test->result |= zest_GetStoreInstanceSlot(layer, ids[4]) != 1;
+	test->result |= zest_GetInstanceLayerCount(layer) != STORE_TEST_INSTANCES - 1;
+	SetLayerTestInstance((TestData *)zest_UpdateStoreInstance(layer, ids[4]), 1, 0);
+
+	//The freed id is used again but the old one still isn't valid
+	zest_instance_id reused_id = 0;
+	SetLayerTestInstance((TestData *)zest_AddStoreInstance(layer, &reused_id), 4, 0);
+	test->result |= ZEST_HANDLE_INDEX(reused_id) != ZEST_HANDLE_INDEX(ids[1]);
+	test->result |= reused_id == ids[1];
+	test->result |= zest_StoreInstanceIsValid(layer, ids[1]);
+	test->result |= zest_GetStoreInstanceSlot(layer, reused_id) != 4;
+	test->result |= zest_GetLayerInstructionCount(layer) != 1;
+	if (test->result) {
+		ZEST_PRINT("\tInstance Store: ids or slots were wrong after removing and adding");
+	}
+	test->result |= VerifyLayerUpload(tests, layer, STORE_TEST_INSTANCES, 1, batch_sizes);
+
+	//Removing the last instance doesn't move anything and the rest carry over to the next frame in flight
+	zest_ResetInstanceLayer(layer);
+	test->result |= zest_GetInstanceLayerCount(layer) != STORE_TEST_INSTANCES;
+	zest_RemoveStoreInstance(layer, reused_id);
+	test->result |= zest_GetStoreInstanceSlot(layer, ids[4]) != 1;
+	test->result |= zest_GetLayerInstructionCount(layer) != 1;
+	batch_sizes[0] = STORE_TEST_INSTANCES - 1;
+	test->result |= VerifyLayerUpload(tests, layer, STORE_TEST_INSTANCES - 1, 1, batch_sizes);
+
+	zest_FreeLayer(layer_handle);
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+/*
+Indirect Delta Reset: A frame in flight mesh layer with delta uploads and multi draw indirect keeps its
+instructions across zest_ResetInstanceLayer, so each frame in flight's indirect buffer has to be written
+for the instructions that carry over to it. Record two draws and flip through every frame in flight
+checking the commands, then record different draws and check that every frame in flight picks them up
+in place of the old commands.
+*/
+int tst__check_layer_indirect_commands(zest_layer layer, const zest_uint *meshes, const zest_uint *draw_instances, zest_uint draw_count) {
+	zest_buffer indirect = zest_GetLayerIndirectBuffer(layer);
+	if (!indirect || zest_GetLayerInstructionCount(layer) != draw_count) {
+		return 1;
+	}
+	zest_draw_indexed_indirect_command_t *commands = (zest_draw_indexed_indirect_command_t *)zest_BufferData(indirect);
+	zest_uint first_instance = 0;
+	for (zest_uint draw = 0; draw != draw_count; ++draw) {
+		const zest_mesh_offset_data_t *offsets = zest_GetLayerMeshOffsets(layer, meshes[draw]);
+		zest_draw_indexed_indirect_command_t *command = &commands[draw];
+		if (command->index_count != offsets->index_count || command->first_index != offsets->index_offset
+			|| command->vertex_offset != (int32_t)offsets->vertex_offset || command->instance_count != draw_instances[draw]
+			|| command->first_instance != first_instance) {
+			return 1;
+		}
+		first_instance += draw_instances[draw];
+	}
+	return 0;
+}
+
+int test__instance_layer_indirect_delta_reset(ZestTests *tests, Test *test) {
+	zest_vec3 positions[4] = { { 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, { 1.f, 1.f, 0.f }, { 0.f, 1.f, 0.f } };
+	zest_mesh triangle = zest_NewMesh(tests->context, sizeof(zest_vec3));
+	zest_mesh quad = zest_NewMesh(tests->context, sizeof(zest_vec3));
+	for (int i = 0; i != 3; ++i) zest_PushMeshVertexData(triangle, &positions[i]);
+	for (int i = 0; i != 4; ++i) zest_PushMeshVertexData(quad, &positions[i]);
+	zest_PushMeshTriangle(triangle, 0, 1, 2);
+	zest_PushMeshTriangle(quad, 0, 1, 2);
+	zest_PushMeshTriangle(quad, 0, 2, 3);
+
+	zest_layer_handle layer_handle = zest_CreateFIFInstanceMeshLayer(tests->context, "Indirect Delta Layer", sizeof(TestData),
+		zest_MeshVertexDataSize(triangle) + zest_MeshVertexDataSize(quad), zest_MeshIndexDataSize(triangle) + zest_MeshIndexDataSize(quad));
+	zest_layer layer = zest_GetLayer(layer_handle);
+	zest_uint meshes[2] = { zest_AddMeshToLayer(layer, triangle, 0), zest_AddMeshToLayer(layer, quad, 0) };
+	zest_EnableInstanceLayerDeltaUploads(layer, 256);
+	zest_EnableLayerMultiDrawIndirect(layer);
+	zest_pipeline_template pipeline = zest_CreatePipelineTemplate(tests->device, "Layer Indirect Delta Pipeline");
+
+	zest_uint draw_meshes[2] = { meshes[0], meshes[1] };
+	zest_uint draw_instances[2] = { 3, 5 };
+	for (zest_uint draw = 0; draw != 2; ++draw) {
+		zest_StartInstanceMeshDrawing(layer, draw_meshes[draw], pipeline);
+		for (zest_uint i = 0; i != draw_instances[draw]; ++i) {
+			SetLayerTestInstance((TestData *)zest_NextInstance(layer), i, draw);
+		}
+	}
+	zest_EndInstanceInstructions(layer);
+	test->result |= tst__check_layer_indirect_commands(layer, draw_meshes, draw_instances, 2);
+	for (int fif = 0; fif != ZEST_MAX_FIF; ++fif) {
+		zest_ResetInstanceLayer(layer);
+		if (tst__check_layer_indirect_commands(layer, draw_meshes, draw_instances, 2)) {
+			ZEST_PRINT("\tIndirect Delta Reset: commands weren't written for the carried over instructions");
+			test->result = 1;
+		}
+	}
+
+	//A single quad draw replaces the old commands in every frame in flight
+	zest_ResetInstanceLayerDrawing(layer);
+	draw_meshes[0] = meshes[1];
+	draw_instances[0] = 7;
+	zest_StartInstanceMeshDrawing(layer, draw_meshes[0], pipeline);
+	for (zest_uint i = 0; i != draw_instances[0]; ++i) {
+		SetLayerTestInstance((TestData *)zest_NextInstance(layer), i, 0);
+	}
+	zest_EndInstanceInstructions(layer);
+	test->result |= tst__check_layer_indirect_commands(layer, draw_meshes, draw_instances, 1);
+	for (int fif = 0; fif != ZEST_MAX_FIF; ++fif) {
+		zest_ResetInstanceLayer(layer);
+		if (tst__check_layer_indirect_commands(layer, draw_meshes, draw_instances, 1)) {
+			ZEST_PRINT("\tIndirect Delta Reset: old commands were left after drawing something else");
+			test->result = 1;
+		}
+	}
+
+	zest_FreeLayer(layer_handle);
+	zest_FreeMesh(triangle);
+	zest_FreeMesh(quad);
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+/*
+Indirect Store Update: An instance store in a frame in flight mesh layer with multi draw indirect is
+drawn with a single indirect command that has to follow the store. Update an instance after flipping
+to each frame in flight and check that the command still covers every instance and that the device
+buffer has them all, then remove one and check that every frame in flight's command drops it.
+*/
+int test__instance_layer_indirect_store_update(ZestTests *tests, Test *test) {
+	zest_vec3 positions[3] = { { 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, { 1.f, 1.f, 0.f } };
+	zest_mesh triangle = zest_NewMesh(tests->context, sizeof(zest_vec3));
+	for (int i = 0; i != 3; ++i) zest_PushMeshVertexData(triangle, &positions[i]);
+	zest_PushMeshTriangle(triangle, 0, 1, 2);
+
+	zest_layer_handle layer_handle = zest_CreateFIFInstanceMeshLayer(tests->context, "Indirect Store Layer", sizeof(TestData),
+		zest_MeshVertexDataSize(triangle), zest_MeshIndexDataSize(triangle));
+	zest_layer layer = zest_GetLayer(layer_handle);
+	//The store draws the layer's first mesh
+	zest_uint meshes[1] = { zest_AddMeshToLayer(layer, triangle, 0) };
+	zest_pipeline_template pipeline = zest_CreatePipelineTemplate(tests->device, "Layer Indirect Store Pipeline");
+	zest_EnableInstanceStore(layer, pipeline);
+	zest_EnableLayerMultiDrawIndirect(layer);
+
+	zest_instance_id ids[STORE_TEST_INSTANCES] = {};
+	for (zest_uint i = 0; i != STORE_TEST_INSTANCES; ++i) {
+		SetLayerTestInstance((TestData *)zest_AddStoreInstance(layer, &ids[i]), i, 0);
+	}
+	zest_uint instance_counts[1] = { STORE_TEST_INSTANCES };
+	test->result |= tst__check_layer_indirect_commands(layer, meshes, instance_counts, 1);
+
+	for (int fif = 0; fif != ZEST_MAX_FIF; ++fif) {
+		zest_ResetInstanceLayer(layer);
+		SetLayerTestInstance((TestData *)zest_UpdateStoreInstance(layer, ids[2]), 2, 0);
+		if (tst__check_layer_indirect_commands(layer, meshes, instance_counts, 1)) {
+			ZEST_PRINT("\tIndirect Store Update: the command doesn't cover the store after an update");
+			test->result = 1;
+		}
+		test->result |= VerifyLayerUpload(tests, layer, STORE_TEST_INSTANCES, 1, instance_counts);
+	}
+
+	//The last instance is removed so the rest keep their slots
+	zest_RemoveStoreInstance(layer, ids[STORE_TEST_INSTANCES - 1]);
+	instance_counts[0] = STORE_TEST_INSTANCES - 1;
+	for (int fif = 0; fif != ZEST_MAX_FIF; ++fif) {
+		zest_ResetInstanceLayer(layer);
+		if (tst__check_layer_indirect_commands(layer, meshes, instance_counts, 1)) {
+			ZEST_PRINT("\tIndirect Store Update: the command still draws the removed instance");
+			test->result = 1;
+		}
+	}
+
+	zest_FreeLayer(layer_handle);
+	zest_FreeMesh(triangle);
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+/*
+Mesh Bulk Build: A grid mesh built with zest_AppendMeshVertices and zest_AppendMeshIndexes, one row of
+indexes at a time with a base vertex, should come out the same as one built a vertex and triangle at a
+time. The grid is big enough for zest_CalculateMeshNormals and zest_CalculateMeshTangents to split it
+in to several jobs. It lies flat with its uvs following x and y so every normal should point along z and
+every tangent along x, and a copy with its u coordinates mirrored should get tangents that point the
+other way with a negative bitangent sign.
+*/
+#define MESH_TEST_GRID 128
+
+struct MeshTestVertex {
+	zest_vec3 pos;
+	zest_vec3 normal;
+	zest_vec2 uv;
+	zest_vec4 tangent;
+};
+
+int MeshTestAttributesMatch(zest_mesh mesh, float tangent_x, float sign) {
+	MeshTestVertex *vertices = (MeshTestVertex *)zest_MeshVertexData(mesh);
+	for (zest_uint i = 0; i != zest_MeshVertexCount(mesh); ++i) {
+		MeshTestVertex *v = &vertices[i];
+		if (fabsf(v->normal.x) > 0.0001f || fabsf(v->normal.y) > 0.0001f || fabsf(v->normal.z - 1.f) > 0.0001f ||
+			fabsf(v->tangent.x - tangent_x) > 0.0001f || fabsf(v->tangent.y) > 0.0001f || fabsf(v->tangent.z) > 0.0001f || v->tangent.w != sign) {
+			ZEST_PRINT("\tMesh Bulk Build: vertex %u has normal %f %f %f and tangent %f %f %f %f", i, v->normal.x, v->normal.y, v->normal.z, v->tangent.x, v->tangent.y, v->tangent.z, v->tangent.w);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void CalculateMeshTestAttributes(zest_mesh mesh) {
+	zest_CalculateMeshNormals(mesh, offsetof(MeshTestVertex, pos), offsetof(MeshTestVertex, normal));
+	zest_CalculateMeshTangents(mesh, offsetof(MeshTestVertex, pos), offsetof(MeshTestVertex, normal), offsetof(MeshTestVertex, uv), offsetof(MeshTestVertex, tangent), zest_format_r32g32b32a32_sfloat);
+}
+
+int test__mesh_bulk_build(ZestTests *tests, Test *test) {
+	const zest_uint size = MESH_TEST_GRID;
+	MeshTestVertex *grid = (MeshTestVertex *)malloc(sizeof(MeshTestVertex) * size * size);
+	for (zest_uint y = 0; y != size; ++y) {
+		for (zest_uint x = 0; x != size; ++x) {
+			MeshTestVertex vertex = {};
+			vertex.pos = zest_Vec3Set((float)x, (float)y, 0.f);
+			vertex.uv = zest_Vec2Set((float)x / size, (float)y / size);
+			grid[y * size + x] = vertex;
+		}
+	}
+	//The indexes of one row of quads, relative to the first vertex in the row
+	zest_uint row[(MESH_TEST_GRID - 1) * 6];
+	for (zest_uint x = 0; x != size - 1; ++x) {
+		zest_uint quad[6] = { x, x + 1, x + size + 1, x, x + size + 1, x + size };
+		memcpy(row + x * 6, quad, sizeof(quad));
+	}
+
+	zest_mesh bulk = zest_NewMesh(tests->context, sizeof(MeshTestVertex));
+	zest_ReserveMeshIndexes(bulk, (size - 1) * (size - 1) * 6);
+	test->result |= zest_AppendMeshVertices(bulk, grid, size * size) != 0;
+	for (zest_uint y = 0; y != size - 1; ++y) {
+		zest_AppendMeshIndexes(bulk, row, (size - 1) * 6, y * size);
+	}
+
+	zest_mesh single = zest_NewMesh(tests->context, sizeof(MeshTestVertex));
+	for (zest_uint i = 0; i != size * size; ++i) {
+		zest_PushMeshVertexData(single, &grid[i]);
+	}
+	for (zest_uint y = 0; y != size - 1; ++y) {
+		for (zest_uint i = 0; i != (size - 1) * 6; i += 3) {
+			zest_PushMeshTriangle(single, row[i] + y * size, row[i + 1] + y * size, row[i + 2] + y * size);
+		}
+	}
+
+	test->result |= zest_MeshVertexCount(bulk) != zest_MeshVertexCount(single);
+	test->result |= zest_MeshIndexCount(bulk) != zest_MeshIndexCount(single);
+	if (!test->result) {
+		test->result |= memcmp(zest_MeshIndexData(bulk), zest_MeshIndexData(single), zest_MeshIndexDataSize(bulk)) != 0;
+	}
+	if (test->result) {
+		ZEST_PRINT("\tMesh Bulk Build: the bulk and single built meshes are different");
+	}
+
+	CalculateMeshTestAttributes(bulk);
+	CalculateMeshTestAttributes(single);
+	test->result |= MeshTestAttributesMatch(bulk, 1.f, 1.f);
+	//However the work was split up the results should be the same
+	test->result |= memcmp(zest_MeshVertexData(bulk), zest_MeshVertexData(single), zest_MeshVertexDataSize(bulk)) != 0;
+
+	//Mirror the uvs
+	MeshTestVertex *vertices = (MeshTestVertex *)zest_MeshVertexData(bulk);
+	for (zest_uint i = 0; i != zest_MeshVertexCount(bulk); ++i) {
+		vertices[i].uv.x = 1.f - vertices[i].uv.x;
+	}
+	CalculateMeshTestAttributes(bulk);
+	test->result |= MeshTestAttributesMatch(bulk, -1.f, -1.f);
+
+	zest_FreeMesh(bulk);
+	zest_FreeMesh(single);
+	free(grid);
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+/*
+Mesh Pool: Add three meshes to an instance mesh layer, remove the middle one and check that its space
+is only reused once the frames in flight are done with it, and that the next mesh added gets its index
+back. Then remove the first mesh, defragment so the last one moves down in to the gap and check that it
+keeps its old range until the defragment pass has run and the frames in flight are done, then that the used
+space shrinks, and add meshes until the layer's buffers have to grow. The vertices of each mesh are read
+back from the layer's vertex buffer after every move to make sure they were copied to the right place.
+*/
+zest_mesh CreateMeshPoolTestMesh(ZestTests *tests, zest_uint vertex_count, float z) {
+	zest_mesh mesh = zest_NewMesh(tests->context, sizeof(zest_vec3));
+	for (zest_uint i = 0; i != vertex_count; ++i) {
+		zest_vec3 position = zest_Vec3Set((float)i, (float)(i & 1), z);
+		zest_PushMeshVertexData(mesh, &position);
+	}
+	for (zest_uint i = 1; i + 1 < vertex_count; ++i) {
+		zest_PushMeshTriangle(mesh, 0, i, i + 1);
+	}
+	return mesh;
+}
+
+int MeshPoolTestMeshMatches(ZestTests *tests, zest_layer layer, zest_uint mesh_index, float z) {
+	const zest_mesh_offset_data_t *offsets = zest_GetLayerMeshOffsets(layer, mesh_index);
+	zest_size size = offsets->vertex_count * sizeof(zest_vec3);
+	zest_buffer_info_t readback_info = zest_CreateBufferInfo(zest_buffer_type_storage, zest_memory_usage_gpu_to_cpu);
+	zest_buffer readback = zest_CreateBuffer(tests->device, size, &readback_info);
+	zest_queue queue = zest_imm_BeginCommandBuffer(tests->device, zest_queue_transfer);
+	zest_imm_CopyBufferRegion(queue, zest_GetLayerMeshVertexBuffer(layer), offsets->vertex_offset * sizeof(zest_vec3), readback, 0, size);
+	zest_imm_EndCommandBuffer(queue);
+	int result = 0;
+	zest_vec3 *positions = (zest_vec3 *)zest_BufferData(readback);
+	for (zest_uint i = 0; i != offsets->vertex_count; ++i) {
+		if (positions[i].x != (float)i || positions[i].y != (float)(i & 1) || positions[i].z != z) {
+			ZEST_PRINT("\tMesh Pool: vertex %u of mesh %u is %f %f %f", i, mesh_index, positions[i].x, positions[i].y, positions[i].z);
+			result = 1;
+			break;
+		}
+	}
+	zest_FreeBufferNow(readback);
+	return result;
+}
+
+void WaitForMeshPoolFrees(ZestTests *tests) {
+	for (int i = 0; i != ZEST_MAX_FIF; ++i) {
+		zest_UpdateDevice(tests->device);
+	}
+}
+
+int tst__run_mesh_defragment_pass(ZestTests *tests, Test *test, zest_layer layer) {
+	if (!zest_BeginCommandGraph(tests->context, "Mesh Defragment", 0)) return 1;
+	zest_AddLayerMeshDefragmentPass(layer);
+	zest_frame_graph frame_graph = zest_EndFrameGraph();
+	test->result |= zest_GetFrameGraphResult(frame_graph);
+	return zest_FlushFrameGraph(frame_graph) != zest_semaphore_status_success;
+}
+
+int test__mesh_pool(ZestTests *tests, Test *test) {
+	zest_mesh triangle = CreateMeshPoolTestMesh(tests, 3, 1.f);
+	zest_mesh quad = CreateMeshPoolTestMesh(tests, 4, 2.f);
+	zest_mesh last = CreateMeshPoolTestMesh(tests, 3, 3.f);
+	zest_size vertex_size = sizeof(zest_vec3);
+
+	zest_layer_handle layer_handle = zest_CreateInstanceMeshLayer(tests->context, "Mesh Pool Layer", sizeof(TestData), vertex_size * 10, sizeof(zest_uint) * 12);
+	zest_layer layer = zest_GetLayer(layer_handle);
+	zest_uint meshes[3] = { zest_AddMeshToLayer(layer, triangle, 0), zest_AddMeshToLayer(layer, quad, 0), zest_AddMeshToLayer(layer, last, 0) };
+	zest_layer_mesh_pool_stats_t stats = zest_GetLayerMeshPoolStats(layer);
+	test->result |= stats.mesh_count != 3 || stats.vertex_used != vertex_size * 10 || stats.index_used != sizeof(zest_uint) * 12;
+
+	//The quad's space can't be used until the frames in flight are done with it
+	zest_RemoveMeshFromLayer(layer, meshes[1]);
+	stats = zest_GetLayerMeshPoolStats(layer);
+	test->result |= zest_LayerHasMesh(layer, meshes[1]);
+	test->result |= stats.mesh_count != 2 || stats.pending_frees != 1 || stats.vertex_free != 0;
+	WaitForMeshPoolFrees(tests);
+	zest_uint reused = zest_AddMeshToLayer(layer, quad, 0);
+	stats = zest_GetLayerMeshPoolStats(layer);
+	test->result |= reused != meshes[1] || zest_GetLayerMeshOffsets(layer, reused)->vertex_offset != 3 || zest_GetLayerMeshOffsets(layer, reused)->index_offset != 3;
+	test->result |= stats.vertex_capacity != vertex_size * 10 || stats.pending_frees != 0 || stats.vertex_free_ranges != 0;
+	if (test->result) {
+		ZEST_PRINT("\tMesh Pool: the removed mesh's index or space wasn't reused");
+	}
+	test->result |= MeshPoolTestMeshMatches(tests, layer, reused, 2.f);
+
+	//The last mesh moves down in to the first mesh's space and its old space comes off the end
+	zest_RemoveMeshFromLayer(layer, meshes[0]);
+	WaitForMeshPoolFrees(tests);
+	zest_size moved = zest_DefragmentLayerMeshes(layer, (zest_size)-1);
+	test->result |= moved != vertex_size * 3 + sizeof(zest_uint) * 3;
+	//Nothing moves until the copies are made and the frames in flight are done with the old range
+	test->result |= zest_GetLayerMeshOffsets(layer, meshes[2])->vertex_offset != 7 || zest_GetLayerMeshOffsets(layer, meshes[2])->index_offset != 9;
+	test->result |= zest_DefragmentLayerMeshes(layer, (zest_size)-1) != 0;
+	test->result |= tst__run_mesh_defragment_pass(tests, test, layer);
+	test->result |= MeshPoolTestMeshMatches(tests, layer, meshes[2], 3.f);
+	WaitForMeshPoolFrees(tests);
+	test->result |= zest_DefragmentLayerMeshes(layer, (zest_size)-1) != 0;
+	test->result |= zest_GetLayerMeshOffsets(layer, meshes[2])->vertex_offset != 0 || zest_GetLayerMeshOffsets(layer, meshes[2])->index_offset != 0;
+	test->result |= MeshPoolTestMeshMatches(tests, layer, meshes[2], 3.f);
+	test->result |= MeshPoolTestMeshMatches(tests, layer, reused, 2.f);
+	WaitForMeshPoolFrees(tests);
+	test->result |= zest_DefragmentLayerMeshes(layer, (zest_size)-1) != 0;
+	stats = zest_GetLayerMeshPoolStats(layer);
+	test->result |= stats.vertex_used != vertex_size * 7 || stats.index_used != sizeof(zest_uint) * 9;
+	test->result |= stats.vertex_free_ranges != 0 || stats.index_free_ranges != 0 || stats.pending_frees != 0;
+	if (test->result) {
+		ZEST_PRINT("\tMesh Pool: defragmenting didn't move the last mesh down");
+	}
+
+	//The first quad fits in what's left and the second one makes the buffers grow
+	zest_uint added[2] = { zest_AddMeshToLayer(layer, quad, 0), zest_AddMeshToLayer(layer, quad, 0) };
+	stats = zest_GetLayerMeshPoolStats(layer);
+	test->result |= added[0] != meshes[0] || added[1] != 3;
+	test->result |= stats.vertex_capacity < vertex_size * 15 || stats.index_capacity < sizeof(zest_uint) * 21 || stats.mesh_count != 4;
+	test->result |= MeshPoolTestMeshMatches(tests, layer, meshes[2], 3.f);
+	test->result |= MeshPoolTestMeshMatches(tests, layer, reused, 2.f);
+	test->result |= MeshPoolTestMeshMatches(tests, layer, added[1], 2.f);
+
+	zest_FreeLayer(layer_handle);
+	zest_FreeMesh(triangle);
+	zest_FreeMesh(quad);
+	zest_FreeMesh(last);
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+/*
+Indirect Defragment: An instance store in a multi draw indirect mesh layer draws the layer's first mesh, which is
+put at the end of the layer's buffers behind a removed mesh. Defragmenting moves it down in to the gap and once
+the move is done the store's indirect command has to point at the new range without the store being touched,
+and still does after the old range is reused by another mesh and the layer flips through the frames in flight.
+*/
+int test__mesh_pool_indirect_defragment(ZestTests *tests, Test *test) {
+	zest_mesh filler = CreateMeshPoolTestMesh(tests, 4, 1.f);
+	zest_mesh middle = CreateMeshPoolTestMesh(tests, 3, 2.f);
+	zest_mesh drawn = CreateMeshPoolTestMesh(tests, 3, 3.f);
+	zest_size vertex_size = sizeof(zest_vec3);
+
+	zest_layer_handle layer_handle = zest_CreateFIFInstanceMeshLayer(tests->context, "Indirect Defragment Layer", sizeof(TestData), vertex_size * 10, sizeof(zest_uint) * 12);
+	zest_layer layer = zest_GetLayer(layer_handle);
+	zest_uint filler_index = zest_AddMeshToLayer(layer, filler, 0);
+	zest_AddMeshToLayer(layer, middle, 0);
+	//The filler's range is still pending so the mesh that takes its index goes at the end of the buffers
+	zest_RemoveMeshFromLayer(layer, filler_index);
+	zest_uint meshes[1] = { zest_AddMeshToLayer(layer, drawn, 0) };
+	test->result |= meshes[0] != 0 || zest_GetLayerMeshOffsets(layer, meshes[0])->vertex_offset != 7;
+
+	zest_pipeline_template pipeline = zest_CreatePipelineTemplate(tests->device, "Layer Indirect Defragment Pipeline");
+	zest_EnableInstanceStore(layer, pipeline);
+	zest_EnableLayerMultiDrawIndirect(layer);
+	zest_uint instance_counts[1] = { STORE_TEST_INSTANCES };
+	for (zest_uint i = 0; i != STORE_TEST_INSTANCES; ++i) {
+		SetLayerTestInstance((TestData *)zest_AddStoreInstance(layer, 0), i, 0);
+	}
+	for (int fif = 0; fif != ZEST_MAX_FIF; ++fif) {
+		zest_ResetInstanceLayer(layer);
+	}
+	test->result |= tst__check_layer_indirect_commands(layer, meshes, instance_counts, 1);
+
+	WaitForMeshPoolFrees(tests);
+	test->result |= zest_DefragmentLayerMeshes(layer, (zest_size)-1) == 0;
+	test->result |= tst__run_mesh_defragment_pass(tests, test, layer);
+	WaitForMeshPoolFrees(tests);
+	test->result |= zest_DefragmentLayerMeshes(layer, (zest_size)-1) != 0;
+	const zest_mesh_offset_data_t *offsets = zest_GetLayerMeshOffsets(layer, meshes[0]);
+	test->result |= offsets->vertex_offset != 0 || offsets->index_offset != 0;
+	if (tst__check_layer_indirect_commands(layer, meshes, instance_counts, 1)) {
+		ZEST_PRINT("\tIndirect Defragment: the store's command still points at the mesh's old range");
+		test->result = 1;
+	}
+	test->result |= MeshPoolTestMeshMatches(tests, layer, meshes[0], 3.f);
+
+	//Another mesh takes the old range and the store keeps drawing the moved mesh in every frame in flight
+	WaitForMeshPoolFrees(tests);
+	zest_uint reused = zest_AddMeshToLayer(layer, middle, 0);
+	test->result |= zest_GetLayerMeshOffsets(layer, reused)->vertex_offset != 7;
+	for (int fif = 0; fif != ZEST_MAX_FIF; ++fif) {
+		zest_ResetInstanceLayer(layer);
+		if (tst__check_layer_indirect_commands(layer, meshes, instance_counts, 1)) {
+			ZEST_PRINT("\tIndirect Defragment: a frame in flight's command doesn't point at the moved mesh");
+			test->result = 1;
+		}
+	}
+	test->result |= VerifyLayerUpload(tests, layer, STORE_TEST_INSTANCES, 1, instance_counts);
+
+	zest_FreeLayer(layer_handle);
+	zest_FreeMesh(filler);
+	zest_FreeMesh(middle);
+	zest_FreeMesh(drawn);
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+/*
+Mesh LOD: A grid mesh, a simplified copy of it and a triangle are added to a layer as a LOD chain. Instances
+of the chain are written at different distances from the LOD view and should be sorted in to a draw for each
+level in the order they were written, with the one that's too small for every level dropped. Before the view
+is set every instance should use the first level. The simplified grid should have fewer vertices and no
+collapsed triangles.
+*/
+#define LOD_TEST_GRID 8
+
+zest_mesh CreateLODTestGrid(ZestTests *tests) {
+	zest_mesh grid = zest_NewMesh(tests->context, sizeof(zest_vec3));
+	for (zest_uint y = 0; y != LOD_TEST_GRID; ++y) {
+		for (zest_uint x = 0; x != LOD_TEST_GRID; ++x) {
+			zest_vec3 position = zest_Vec3Set((float)x / LOD_TEST_GRID, (float)y / LOD_TEST_GRID, 0.f);
+			zest_PushMeshVertexData(grid, &position);
+		}
+	}
+	for (zest_uint y = 0; y != LOD_TEST_GRID - 1; ++y) {
+		for (zest_uint x = 0; x != LOD_TEST_GRID - 1; ++x) {
+			zest_uint i = y * LOD_TEST_GRID + x;
+			zest_PushMeshTriangle(grid, i, i + 1, i + LOD_TEST_GRID + 1);
+			zest_PushMeshTriangle(grid, i, i + LOD_TEST_GRID + 1, i + LOD_TEST_GRID);
+		}
+	}
+	return grid;
+}
+
+//Instances are at these distances along x from the LOD view, with a radius of 1 and a scale of 1 their
+//screen sizes are 1 / distance. w holds the instance's index.
+#define LOD_TEST_INSTANCES 6
+static const float lod_test_distances[LOD_TEST_INSTANCES] = { 1.f, 5.f, 20.f, 100.f, 1.5f, 8.f };
+static const float lod_test_screen_sizes[3] = { .5f, .1f, .02f };
+
+void WriteLODTestInstances(zest_layer layer) {
+	for (zest_uint i = 0; i != LOD_TEST_INSTANCES; ++i) {
+		TestData *instance = (TestData *)zest_NextInstance(layer);
+		instance->vec = zest_Vec4Set(lod_test_distances[i], 0.f, 0.f, (float)i);
+	}
+}
+
+int test__instance_mesh_layer_lod(ZestTests *tests, Test *test) {
+	zest_mesh grid = CreateLODTestGrid(tests);
+	zest_mesh simplified = zest_CreateSimplifiedMesh(grid, 0, 2.f / LOD_TEST_GRID);
+	zest_mesh triangle = CreateMeshPoolTestMesh(tests, 3, 0.f);
+	test->result |= zest_MeshVertexCount(simplified) != (LOD_TEST_GRID / 2) * (LOD_TEST_GRID / 2);
+	test->result |= zest_MeshIndexCount(simplified) == 0 || zest_MeshIndexCount(simplified) >= zest_MeshIndexCount(grid);
+	zest_uint *indexes = (zest_uint *)zest_MeshIndexData(simplified);
+	for (zest_uint i = 0; i + 2 < zest_MeshIndexCount(simplified); i += 3) {
+		test->result |= indexes[i] == indexes[i + 1] || indexes[i + 1] == indexes[i + 2] || indexes[i] == indexes[i + 2];
+	}
+	if (test->result) {
+		ZEST_PRINT("\tMesh LOD: the simplified mesh has %u vertices and %u indexes", zest_MeshVertexCount(simplified), zest_MeshIndexCount(simplified));
+	}
+
+	zest_layer_handle layer_handle = zest_CreateInstanceMeshLayer(tests->context, "LOD Mesh Layer", sizeof(TestData),
+		zest_MeshVertexDataSize(grid) + zest_MeshVertexDataSize(simplified) + zest_MeshVertexDataSize(triangle),
+		zest_MeshIndexDataSize(grid) + zest_MeshIndexDataSize(simplified) + zest_MeshIndexDataSize(triangle));
+	zest_layer layer = zest_GetLayer(layer_handle);
+	zest_uint meshes[3] = { zest_AddMeshToLayer(layer, grid, 0), zest_AddMeshToLayer(layer, simplified, 0), zest_AddMeshToLayer(layer, triangle, 0) };
+	zest_EnableLayerMeshLODs(layer, offsetof(TestData, vec), ZEST_INVALID);
+	zest_uint chain = zest_AddLayerMeshLODChain(layer, meshes, lod_test_screen_sizes, 3);
+	zest_pipeline_template pipeline = zest_CreatePipelineTemplate(tests->device, "Layer LOD Pipeline");
+
+	//No view yet so everything is drawn with the first level
+	zest_StartInstanceMeshLODDrawing(layer, chain, pipeline);
+	WriteLODTestInstances(layer);
+	zest_EndInstanceInstructions(layer);
+	test->result |= zest_GetLayerInstructionCount(layer) != 1 || zest_GetInstanceLayerCount(layer) != LOD_TEST_INSTANCES;
+	test->result |= zest_GetLayerInstruction(layer, 0)->mesh_index != meshes[0];
+	zest_ResetInstanceLayerDrawing(layer);
+
+	zest_SetLayerLODView(layer, zest_Vec3Set(0.f, 0.f, 0.f), 1.f);
+	zest_StartInstanceMeshLODDrawing(layer, chain, pipeline);
+	WriteLODTestInstances(layer);
+	//An ordinary draw after the chain carries on after the instances that were kept
+	zest_StartInstanceMeshDrawing(layer, meshes[2], pipeline);
+	SetLayerTestInstance((TestData *)zest_NextInstance(layer), 0, 0);
+	zest_EndInstanceInstructions(layer);
+
+	const zest_uint level_counts[3] = { 2, 2, 1 };
+	const float level_instances[5] = { 0.f, 4.f, 1.f, 5.f, 2.f };
+	test->result |= zest_GetLayerInstructionCount(layer) != 4 || zest_GetInstanceLayerCount(layer) != LOD_TEST_INSTANCES;
+	if (!test->result) {
+		TestData *instances = (TestData *)zest_BufferData(zest_GetLayerStagingVertexBuffer(layer));
+		zest_uint start = 0;
+		for (zest_uint level = 0; level != 3; ++level) {
+			zest_layer_instruction_t *instruction = zest_GetLayerInstruction(layer, level);
+			if (instruction->mesh_index != meshes[level] || instruction->lod_level != level || instruction->start_index != start || instruction->total_instances != level_counts[level]) {
+				ZEST_PRINT("\tMesh LOD: level %u has %u instances from %u, expected %u from %u", level, instruction->total_instances, instruction->start_index, level_counts[level], start);
+				test->result = 1;
+			}
+			start += level_counts[level];
+		}
+		for (zest_uint i = 0; i != 5; ++i) {
+			test->result |= instances[i].vec.w != level_instances[i];
+		}
+		zest_layer_instruction_t *after = zest_GetLayerInstruction(layer, 3);
+		test->result |= after->start_index != 5 || after->total_instances != 1 || after->mesh_index != meshes[2];
+		test->result |= !LayerTestInstanceMatches(&instances[5], 0, 0);
+		if (test->result) {
+			ZEST_PRINT("\tMesh LOD: the instances weren't sorted in to their levels");
+		}
+	}
+
+	zest_FreeLayer(layer_handle);
+	zest_FreeMesh(grid);
+	zest_FreeMesh(simplified);
+	zest_FreeMesh(triangle);
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+//Copies the whole culled buffer including the space after the instances that LOD levels are compacted in to
+void zest_ReadbackLODCulledInstances(const zest_command_list command_list, void *user_data) {
+	zest_buffer src = zest_GetPassInputBuffer(command_list, "Layer Culled Instances");
+	zest_buffer dst = zest_GetPassOutputBuffer(command_list, "Readback");
+	if (src && dst) {
+		zest_cmd_CopyBuffer(command_list, src, dst, LOD_TEST_INSTANCES * 3 * sizeof(TestData));
+	}
+}
+
+/*
+GPU Mesh LOD: The same LOD chain as the Mesh LOD test in a layer with GPU culling. The chain gets a draw for
+each level and the cull pass should give each level the instances with a screen size in its range,
+compacted after the layer's instances for the levels after the first. The instance that's too small for
+every level shouldn't be in any draw.
+*/
+int test__instance_mesh_layer_gpu_lod(ZestTests *tests, Test *test) {
+	zest_mesh grid = CreateLODTestGrid(tests);
+	zest_mesh simplified = zest_CreateSimplifiedMesh(grid, 0, 2.f / LOD_TEST_GRID);
+	zest_mesh triangle = CreateMeshPoolTestMesh(tests, 3, 0.f);
+	zest_layer_handle layer_handle = zest_CreateInstanceMeshLayer(tests->context, "GPU LOD Mesh Layer", sizeof(TestData),
+		zest_MeshVertexDataSize(grid) + zest_MeshVertexDataSize(simplified) + zest_MeshVertexDataSize(triangle),
+		zest_MeshIndexDataSize(grid) + zest_MeshIndexDataSize(simplified) + zest_MeshIndexDataSize(triangle));
+	zest_layer layer = zest_GetLayer(layer_handle);
+	zest_uint meshes[3] = { zest_AddMeshToLayer(layer, grid, 0), zest_AddMeshToLayer(layer, simplified, 0), zest_AddMeshToLayer(layer, triangle, 0) };
+	if (!zest_EnableLayerGPUCulling(layer, offsetof(TestData, vec), ZEST_INVALID)) {
+		ZEST_PRINT("\tGPU Mesh LOD: unable to enable culling");
+		test->result = 1;
+	}
+	zest_EnableLayerMeshLODs(layer, offsetof(TestData, vec), ZEST_INVALID);
+	zest_uint chain = zest_AddLayerMeshLODChain(layer, meshes, lod_test_screen_sizes, 3);
+	zest_SetLayerLODView(layer, zest_Vec3Set(0.f, 0.f, 0.f), 1.f);
+
+	zest_pipeline_template pipeline = zest_CreatePipelineTemplate(tests->device, "Layer GPU LOD Pipeline");
+	zest_StartInstanceMeshLODDrawing(layer, chain, pipeline);
+	WriteLODTestInstances(layer);
+	zest_EndInstanceInstructions(layer);
+	test->result |= zest_GetLayerInstructionCount(layer) != 3;
+
+	zest_size data_size = LOD_TEST_INSTANCES * 3 * sizeof(TestData);
+	zest_buffer_info_t readback_info = zest_CreateBufferInfo(zest_buffer_type_storage, zest_memory_usage_gpu_to_cpu);
+	zest_buffer readback = zest_CreateBuffer(tests->device, data_size, &readback_info);
+	memset(zest_BufferData(readback), 0, data_size);
+
+	const zest_uint level_counts[3] = { 2, 2, 1 };
+	const zest_uint level_masks[3] = { (1 << 0) | (1 << 4), (1 << 1) | (1 << 5), 1 << 2 };
+	zest_execution_timeline timeline = zest_CreateExecutionTimeline(tests->device);
+	if (!test->result && zest_BeginCommandGraph(tests->context, "Layer GPU LOD", 0)) {
+		zest_resource_node layer_resource = zest_AddTransientLayerResource("Layer Data", layer, ZEST_FALSE);
+		zest_resource_node readback_resource = zest_ImportBufferResource("Readback", readback, 0);
+
+		zest_BeginTransferPass("Upload Layer");
+		zest_ConnectOutput(layer_resource);
+		zest_SetPassTask(zest_UploadInstanceLayerData, layer);
+		zest_EndPass();
+
+		zest_resource_node culled = zest_AddLayerCullPass(layer, layer_resource, 0);
+
+		zest_BeginTransferPass("Readback Culled");
+		zest_ConnectInput(culled);
+		zest_ConnectOutput(readback_resource);
+		zest_SetPassTask(zest_ReadbackLODCulledInstances, layer);
+		zest_EndPass();
+
+		zest_SignalTimeline(timeline);
+		zest_frame_graph frame_graph = zest_EndFrameGraph();
+		zest_semaphore_status status = zest_FlushFrameGraph(frame_graph);
+		if (status != zest_semaphore_status_success || zest_GetFrameGraphResult(frame_graph) != 0) {
+			ZEST_PRINT("\tGPU Mesh LOD: flush status %i, frame graph result %i", (int)status, (int)zest_GetFrameGraphResult(frame_graph));
+			test->result = 1;
+		}
+
+		zest_draw_indexed_indirect_command_t *commands = (zest_draw_indexed_indirect_command_t *)zest_BufferData(zest_GetLayerIndirectBuffer(layer));
+		TestData *data = (TestData *)zest_BufferData(readback);
+		for (zest_uint level = 0; level != 3 && !test->result; ++level) {
+			//The first level keeps the chain's start and the others go after the layer's instances
+			zest_uint first_instance = level * LOD_TEST_INSTANCES;
+			if (commands[level].instance_count != level_counts[level] || commands[level].first_instance != first_instance) {
+				ZEST_PRINT("\tGPU Mesh LOD: level %u has %u instances from %u, expected %u from %u", level, commands[level].instance_count, commands[level].first_instance, level_counts[level], first_instance);
+				test->result = 1;
+				break;
+			}
+			zest_uint found = 0;
+			for (zest_uint i = 0; i != level_counts[level]; ++i) {
+				found |= 1 << (zest_uint)data[first_instance + i].vec.w;
+			}
+			if (found != level_masks[level]) {
+				ZEST_PRINT("\tGPU Mesh LOD: level %u kept the wrong instances", level);
+				test->result = 1;
+			}
+		}
+	} else if (!test->result) {
+		ZEST_PRINT("\tGPU Mesh LOD: BeginCommandGraph failed");
+		test->result = 1;
+	}
+
+	zest_FreeExecutionTimeline(timeline);
+	zest_FreeBuffer(readback);
+	zest_FreeLayer(layer_handle);
+	zest_FreeMesh(grid);
+	zest_FreeMesh(simplified);
+	zest_FreeMesh(triangle);
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
@@ -593,3 +593,188 @@ int test__shader_cache_invalidation(ZestTests *tests, Test *test) {
 	test->frame_count++;
 	return test->result;
 }
+
+//Persisted pipeline cache - a saved cache reloads when its header matches the device. A header written for a
+//different vendor, device, driver version or cache UUID is rejected so the driver starts with an empty cache.
+int test__pipeline_cache_persistence(ZestTests *tests, Test *test) {
+	zest_device device = tests->device;
+	int failed_count = 0;
+	//Save to the working directory rather than over the real cache in the shader cache folder
+	zest_device_init_flags saved_flags = device->init_flags;
+	zest_text_t saved_path = device->cached_shaders_path;
+	device->init_flags |= zest_device_init_flag_cache_pipelines;
+	device->cached_shaders_path = ZEST__ZERO_INIT(zest_text_t);
+	const char *path = ZEST_PIPELINE_CACHE_FILE_NAME;
+	const zest_size header_size = sizeof(zest_pipeline_cache_header_t);
+
+	//Build a pipeline so there's something in the cache to save
+	zest_command_list_t command_list = create_test_command_list(tests);
+	command_list.rendering_info.sample_count = zest_sample_count_1_bit;
+	zest_pipeline_template pipeline = create_basic_pipeline_template(tests, "Pipeline Cache Persistence");
+	if (!zest_GetPipeline(pipeline, &command_list)) {
+		failed_count++;
+	}
+
+	if (!zest_SavePipelineCache(device)) {
+		failed_count++;
+	}
+	zest_byte *saved = NULL;
+	zest_size saved_size = 0;
+	FILE *file = fopen(path, "rb");
+	if (file) {
+		fseek(file, 0, SEEK_END);
+		saved_size = (zest_size)ftell(file);
+		fseek(file, 0, SEEK_SET);
+		saved = (zest_byte *)malloc(saved_size);
+		if (fread(saved, 1, saved_size, file) != saved_size) {
+			saved_size = 0;
+		}
+		fclose(file);
+	}
+
+	if (saved_size <= header_size) {
+		failed_count++;
+	} else {
+		//The matching header loads and hands back exactly the data that was saved
+		zest_file loaded = zest__load_pipeline_cache(device);
+		if (!loaded || zest_vec_size(loaded) != saved_size - header_size || memcmp(loaded, saved + header_size, saved_size - header_size) != 0) {
+			failed_count++;
+		}
+		zest_vec_free(device->allocator, loaded);
+
+		//Change one identity field at a time
+		for (int field = 0; field != 4; ++field) {
+			zest_pipeline_cache_header_t header;
+			memcpy(&header, saved, header_size);
+			switch (field) {
+				case 0: header.vendor_id ^= 1; break;
+				case 1: header.device_id ^= 1; break;
+				case 2: header.driver_version ^= 1; break;
+				case 3: header.cache_uuid[15] ^= 0xFF; break;
+			}
+			file = fopen(path, "wb");
+			if (!file) {
+				failed_count++;
+				continue;
+			}
+			fwrite(&header, 1, header_size, file);
+			fwrite(saved + header_size, 1, saved_size - header_size, file);
+			fclose(file);
+			zest_file rejected = zest__load_pipeline_cache(device);
+			if (rejected) {
+				failed_count++;
+				zest_vec_free(device->allocator, rejected);
+			}
+		}
+	}
+
+	free(saved);
+	remove(path);
+	device->cached_shaders_path = saved_path;
+	device->init_flags = saved_flags;
+
+	test->result = failed_count > 0 ? 1 : 0;
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+//Background pipeline compilation - a precompiled pipeline has to land in the same cache slot that
+//zest_GetPipeline looks in, otherwise the first draw still stalls to build it again. Fallback cycles
+//are rejected.
+int test__pipeline_background_compile(ZestTests *tests, Test *test) {
+	zest_context context = tests->context;
+	zest_command_list_t command_list = create_test_command_list(tests);
+	//The frame graph always fills in the sample count
+	command_list.rendering_info.sample_count = zest_sample_count_1_bit;
+	int failed_count = 0;
+
+	zest_pipeline_template pipeline = create_basic_pipeline_template(tests, "Background Pipeline");
+	zest_pipeline_template fallback = create_basic_pipeline_template(tests, "Background Pipeline Fallback");
+	zest_SetPipelineFallback(pipeline, fallback);
+	//A fallback that leads back to the pipeline is a cycle that zest_RequestPipeline could never get out of
+	zest_SetPipelineFallback(fallback, pipeline);
+	if (fallback->fallback || zest_GetValidationErrorCount(tests->device) != 1) {
+		failed_count++;
+	}
+	zest_ResetValidationErrors(tests->device);
+	zest_rendering_info_t rendering_info = zest_CreateRenderingInfo(zest_format_b8g8r8a8_unorm, zest_format_undefined);
+
+	if (zest_PrecompilePipeline(context, pipeline, &rendering_info)) {
+		zest_WaitForPipelines(context);
+		if (zest_GetPipelineStatus(context, pipeline, &rendering_info) != zest_pipeline_status_ready) {
+			failed_count++;
+		}
+		if (zest_GetPendingPipelineCount(context) != 0) {
+			failed_count++;
+		}
+		zest_pipeline requested = zest_RequestPipeline(pipeline, &command_list);
+		zest_pipeline fetched = zest_GetPipeline(pipeline, &command_list);
+		if (!requested || requested != fetched) {
+			failed_count++;
+		}
+		if (zest_GetPipelineStatus(context, fallback, &rendering_info) != zest_pipeline_status_not_requested) {
+			failed_count++;
+		}
+	} else if (!zest_RequestPipeline(pipeline, &command_list)) {
+		//Legacy render passes build on demand
+		failed_count++;
+	}
+
+	test->result = failed_count > 0 ? 1 : 0;
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+//Batch shader creation - identical sources are compiled once and a broken shader only fails itself
+int test__shader_batch_compile(ZestTests *tests, Test *test) {
+	static const char *source_red =
+		"#version 450\n"
+		"layout(location = 0) out vec4 out_colour;\n"
+		"void main() { out_colour = vec4(1.0, 0.0, 0.0, 1.0); }\n";
+	static const char *source_green =
+		"#version 450\n"
+		"layout(location = 0) out vec4 out_colour;\n"
+		"void main() { out_colour = vec4(0.0, 1.0, 0.0, 1.0); }\n";
+	static const char *source_broken =
+		"#version 450\n"
+		"void main() { not_a_variable = 1.0; }\n";
+
+	zest_device device = tests->device;
+	int failed_count = 0;
+
+	zest_shader_source_t sources[4] = {};
+	sources[0] = { "batch_red", NULL, source_red, zest_fragment_shader, NULL, ZEST_TRUE };
+	sources[1] = { "batch_green", NULL, source_green, zest_fragment_shader, NULL, ZEST_TRUE };
+	sources[2] = { "batch_red_again", NULL, source_red, zest_fragment_shader, NULL, ZEST_TRUE };
+	sources[3] = { "batch_broken", NULL, source_broken, zest_fragment_shader, NULL, ZEST_TRUE };
+	zest_shader_handle handles[4];
+	zest_shader_batch_stats_t stats;
+
+	if (zest_CreateShaders(device, sources, 4, handles, &stats)) {
+		failed_count++;
+	}
+	if (stats.shader_count != 4 || stats.compiled_count != 2 || stats.duplicate_count != 1 || stats.failed_count != 1 || stats.cache_hit_count != 0) {
+		failed_count++;
+	}
+	if (!handles[0].value || !handles[1].value || !handles[2].value || handles[3].value) {
+		failed_count++;
+	} else {
+		zest_shader red = zest_GetShader(handles[0]);
+		zest_shader red_again = zest_GetShader(handles[2]);
+		if (red->binary_size == 0 || red->binary_size != red_again->binary_size || memcmp(red->binary, red_again->binary, red->binary_size) != 0) {
+			failed_count++;
+		}
+	}
+	for (int i = 0; i != 3; ++i) {
+		if (handles[i].value) {
+			zest_FreeShader(handles[i]);
+		}
+	}
+
+	test->result = failed_count > 0 ? 1 : 0;
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
@@ -2902,3 +2902,851 @@ int test__pooled_image_allocations(ZestTests *tests, Test *test) {
 	test->frame_count++;
 	return test->result;
 }
+
+int test__image_streaming(ZestTests *tests, Test *test) {
+	int failed_count = 0;
+	zest_device device = tests->device;
+
+	//A small ring and budget so that the test fills the ring and spreads the uploads over several updates
+	const zest_uint size = 64;
+	const zest_size image_bytes = size * size * 4;
+	zest_image_streamer_info_t streamer_info = zest_CreateImageStreamerInfo();
+	streamer_info.ring_size = image_bytes * 6;
+	streamer_info.frame_budget = image_bytes * 2;
+	zest_image_streamer streamer = zest_CreateImageStreamer(device, &streamer_info);
+	if (!streamer) {
+		test->result = 1;
+		test->frame_count++;
+		return test->result;
+	}
+
+	const int image_count = 12;
+	zest_image_handle images[image_count] = { 0 };
+	zest_stream_ticket tickets[image_count] = { 0 };
+	zest_byte *pixels = (zest_byte*)malloc(image_bytes);
+	zest_image_info_t info = zest_CreateImageInfo(size, size);
+	info.flags = zest_image_preset_texture_mipmaps;
+	info.format = zest_format_r8g8b8a8_unorm;
+
+	//Queue images until the ring is full. Nothing is submitted yet so none of them can complete
+	int queued = 0;
+	for (; queued < image_count; queued++) {
+		for (zest_size i = 0; i < image_bytes; ++i) {
+			pixels[i] = (zest_byte)(i * 7 + queued * 31);
+		}
+		images[queued] = zest_StreamImageWithPixels(streamer, pixels, image_bytes, &info, &tickets[queued]);
+		if (!tickets[queued]) break;
+		if (!images[queued].value) failed_count++;
+		if (queued && tickets[queued] != tickets[queued - 1] + 1) failed_count++;
+		if (zest_ImageStreamIsComplete(streamer, tickets[queued])) failed_count++;
+	}
+	zest_image_streamer_stats_t stats = zest_GetImageStreamerStats(streamer);
+	//A full ring must refuse the upload without creating an image rather than wait
+	if (queued == image_count || images[queued].value) failed_count++;
+	if (stats.ring_full_count != 1) failed_count++;
+	if (stats.queued_uploads != (zest_uint)queued) failed_count++;
+
+	//Each update submits no more than the budget, so the queue drains over several updates
+	zest_uint submitted = zest_UpdateImageStreamer(streamer);
+	stats = zest_GetImageStreamerStats(streamer);
+	if (submitted != 2 || stats.last_update_bytes > streamer_info.frame_budget) failed_count++;
+	if (stats.queued_uploads != (zest_uint)queued - 2) failed_count++;
+	if (!zest_GetImageStreamerTimeline(streamer)->current_value) failed_count++;
+
+	//Poll without waiting until the first batch is done. Once it retires its ring space is reused
+	zest_microsecs poll_start = zest_Microsecs();
+	while (!zest_ImageStreamIsComplete(streamer, tickets[1]) && zest_Microsecs() - poll_start < ZEST_SECONDS_IN_MICROSECONDS(10)) {
+		zest_UpdateImageStreamer(streamer);
+	}
+	if (!zest_ImageStreamIsComplete(streamer, tickets[0])) failed_count++;
+	for (; queued < image_count; queued++) {
+		for (zest_size i = 0; i < image_bytes; ++i) {
+			pixels[i] = (zest_byte)(i * 7 + queued * 31);
+		}
+		images[queued] = zest_StreamImageWithPixels(streamer, pixels, image_bytes, &info, &tickets[queued]);
+		if (!tickets[queued]) {
+			zest_FlushImageStreamer(streamer, ZEST_SECONDS_IN_MICROSECONDS(10));
+			images[queued] = zest_StreamImageWithPixels(streamer, pixels, image_bytes, &info, &tickets[queued]);
+			if (!tickets[queued]) failed_count++;
+		}
+	}
+
+	if (zest_FlushImageStreamer(streamer, ZEST_SECONDS_IN_MICROSECONDS(10)) != zest_semaphore_status_success) failed_count++;
+	stats = zest_GetImageStreamerStats(streamer);
+	if (stats.queued_uploads || stats.batches_in_flight || stats.outstanding_uploads) failed_count++;
+	if (stats.total_uploads != image_count || stats.total_bytes != image_bytes * image_count) failed_count++;
+
+	//Every image must be ready to sample with its own pixels in the base level
+	zest_byte *readback = (zest_byte*)malloc(image_bytes);
+	for (int i = 0; i < image_count; i++) {
+		if (!zest_ImageStreamIsComplete(streamer, tickets[i])) failed_count++;
+		zest_image image = zest_GetImage(images[i]);
+		if (!image) {
+			failed_count++;
+			continue;
+		}
+		if (image->layout != zest_image_layout_shader_read_only_optimal) failed_count++;
+		if (!zest_CopyImageToBitmap(device, image, readback)) {
+			failed_count++;
+			continue;
+		}
+		for (zest_size p = 0; p < image_bytes; ++p) {
+			if (readback[p] != (zest_byte)(p * 7 + i * 31)) {
+				failed_count++;
+				break;
+			}
+		}
+	}
+	free(readback);
+	free(pixels);
+
+	for (int i = 0; i < image_count; i++) {
+		zest_FreeImageNow(images[i]);
+	}
+	zest_FreeImageStreamer(streamer);
+
+	test->result = failed_count > 0 ? 1 : 0;
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+/*
+Readbacks: standalone buffer and image readbacks are submitted without waiting and their callbacks
+only fire once polled after the GPU is done. Readback passes in a command graph fire when the graph is
+flushed. Callbacks fire in ticket order with exactly the bytes of the requested region.
+*/
+struct ReadbackCapture {
+	zest_byte *data;
+	zest_size size;
+	int order;
+	int *fired;
+};
+
+void tst__readback_capture(const void *data, zest_size size, void *user_data) {
+	ReadbackCapture *capture = (ReadbackCapture *)user_data;
+	capture->data = (zest_byte*)malloc(size);
+	memcpy(capture->data, data, size);
+	capture->size = size;
+	capture->order = (*capture->fired)++;
+}
+
+int test__readbacks(ZestTests *tests, Test *test) {
+	int failed_count = 0;
+	zest_device device = tests->device;
+	zest_context context = tests->context;
+	int fired = 0;
+	ReadbackCapture captures[4] = {};
+	for (int i = 0; i != 4; ++i) {
+		captures[i].order = -1;
+		captures[i].fired = &fired;
+	}
+
+	const zest_size buffer_bytes = 1024;
+	zest_byte *bytes = (zest_byte*)malloc(buffer_bytes);
+	for (zest_size i = 0; i < buffer_bytes; ++i) {
+		bytes[i] = (zest_byte)(i * 13 + 5);
+	}
+	zest_buffer buffer = zest_CreateStagingBuffer(device, buffer_bytes, bytes);
+
+	const zest_uint size = 32;
+	zest_byte *pixels = (zest_byte*)malloc(size * size * 4);
+	for (zest_uint i = 0; i < size * size * 4; ++i) {
+		pixels[i] = (zest_byte)(i * 3 + 1);
+	}
+	zest_image_info_t info = zest_CreateImageInfo(size, size);
+	info.flags = zest_image_preset_texture | zest_image_flag_transfer_src;
+	info.format = zest_format_r8g8b8a8_unorm;
+	zest_image_handle image_handle = zest_CreateImageWithPixels(device, pixels, size * size * 4, &info);
+	zest_image image = zest_GetImage(image_handle);
+
+	//Standalone readbacks go straight to the GPU but nothing fires until they are polled
+	zest_readback_ticket buffer_ticket = zest_ReadbackBuffer(context, buffer, 64, 256, tst__readback_capture, &captures[0]);
+	zest_image_readback_region_t region = {};
+	region.x = 8;
+	region.y = 4;
+	region.width = 16;
+	region.height = 8;
+	zest_readback_ticket image_ticket = zest_ReadbackImage(context, image, &region, tst__readback_capture, &captures[1]);
+	if (!buffer_ticket || image_ticket != buffer_ticket + 1) failed_count++;
+	if (fired) failed_count++;
+	zest_readback_stats_t stats = zest_GetReadbackStats(context);
+	if (stats.pending_readbacks != 2 || stats.pending_bytes != 256 + 16 * 8 * 4) failed_count++;
+
+	if (zest_FlushReadbacks(context, ZEST_SECONDS_IN_MICROSECONDS(10)) != zest_semaphore_status_success) failed_count++;
+	if (!zest_ReadbackIsComplete(context, buffer_ticket) || !zest_ReadbackIsComplete(context, image_ticket)) failed_count++;
+	if (captures[0].order != 0 || captures[1].order != 1) failed_count++;
+	if (captures[0].size != 256 || !captures[0].data || memcmp(captures[0].data, bytes + 64, 256)) failed_count++;
+	if (captures[1].size == 16 * 8 * 4 && captures[1].data) {
+		for (zest_uint y = 0; y < region.height; ++y) {
+			zest_byte *expected = pixels + ((y + region.y) * size + region.x) * 4;
+			if (memcmp(captures[1].data + y * region.width * 4, expected, region.width * 4)) {
+				failed_count++;
+				break;
+			}
+		}
+	} else {
+		failed_count++;
+	}
+	//The image must be left in the layout it was found in
+	if (image->layout != zest_image_layout_shader_read_only_optimal) failed_count++;
+
+	//Readback passes record the copy when the graph executes and fire once the graph's work is done
+	if (zest_BeginCommandGraph(context, "Readback Passes", 0)) {
+		zest_resource_node buffer_node = zest_ImportBufferResource("Readback Buffer", buffer, 0);
+		zest_resource_node image_node = zest_ImportImageResource("Readback Image", image, 0);
+		zest_AddBufferReadbackPass("Buffer Readback", buffer_node, 0, 0, tst__readback_capture, &captures[2]);
+		zest_AddImageReadbackPass("Image Readback", image_node, 0, tst__readback_capture, &captures[3]);
+		zest_frame_graph frame_graph = zest_EndFrameGraph();
+		test->result |= zest_GetFrameGraphResult(frame_graph);
+		if (zest_FlushFrameGraph(frame_graph) != zest_semaphore_status_success) failed_count++;
+	} else {
+		failed_count++;
+	}
+	if (fired != 4) failed_count++;
+	if (captures[2].size != buffer_bytes || !captures[2].data || memcmp(captures[2].data, bytes, buffer_bytes)) failed_count++;
+	if (captures[3].size != size * size * 4 || !captures[3].data || memcmp(captures[3].data, pixels, size * size * 4)) failed_count++;
+
+	stats = zest_GetReadbackStats(context);
+	if (stats.pending_readbacks || stats.total_readbacks != 4 || stats.ring_full_count) failed_count++;
+	if (stats.completed_ticket != image_ticket + 2) failed_count++;
+
+	for (int i = 0; i != 4; ++i) {
+		free(captures[i].data);
+	}
+	free(pixels);
+	free(bytes);
+	zest_FreeImageNow(image_handle);
+	zest_FreeBuffer(buffer);
+
+	test->result |= failed_count > 0 ? 1 : 0;
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+/*
+Virtual textures: the coarsest mip level is loaded by the first update. Feedback (written here by a copy
+in place of a shader) asks for a page, which loads it along with the coarser pages above it, coarsest
+first, until the cache is full of visible pages. Later feedback evicts the least recently used page. The
+page table points missing pages at the nearest resident page above them.
+*/
+struct VirtualTextureTest {
+	int loads;
+	zest_uint feedback[256];
+};
+
+zest_bool tst__load_virtual_page(zest_virtual_texture virtual_texture, zest_uint mip_level, zest_uint page_x, zest_uint page_y, void *pixels, zest_size size, void *user_data) {
+	VirtualTextureTest *vt_test = (VirtualTextureTest *)user_data;
+	zest_byte *texels = (zest_byte *)pixels;
+	for (zest_size i = 0; i < size; i += 4) {
+		texels[i + 0] = (zest_byte)mip_level;
+		texels[i + 1] = (zest_byte)page_x;
+		texels[i + 2] = (zest_byte)page_y;
+		texels[i + 3] = 255;
+	}
+	vt_test->loads++;
+	return ZEST_TRUE;
+}
+
+void tst__write_virtual_feedback(const zest_command_list command_list, void *user_data) {
+	zest_buffer *buffers = (zest_buffer *)user_data;
+	zest_cmd_CopyBuffer(command_list, buffers[0], buffers[1], buffers[0]->size);
+}
+
+int tst__run_virtual_texture_frame(ZestTests *tests, Test *test, zest_virtual_texture virtual_texture, zest_buffer *feedback_buffers) {
+	if (!zest_BeginCommandGraph(tests->context, "Virtual Texture", 0)) return 1;
+	zest_virtual_texture_resources_t resources = zest_ImportVirtualTexture(virtual_texture);
+	zest_AddVirtualTextureUploadPass(virtual_texture, &resources);
+	zest_BeginTransferPass("Fake Feedback"); {
+		zest_ConnectOutput(resources.feedback);
+		zest_SetPassTask(tst__write_virtual_feedback, feedback_buffers);
+		zest_DoNotCull();
+		zest_EndPass();
+	}
+	zest_AddVirtualTextureFeedbackPass(virtual_texture, &resources);
+	zest_frame_graph frame_graph = zest_EndFrameGraph();
+	test->result |= zest_GetFrameGraphResult(frame_graph);
+	return zest_FlushFrameGraph(frame_graph) != zest_semaphore_status_success;
+}
+
+int test__virtual_textures(ZestTests *tests, Test *test) {
+	int failed_count = 0;
+	zest_device device = tests->device;
+	zest_context context = tests->context;
+	VirtualTextureTest vt_test = {};
+
+	//16x8 pages of 64 texels gives 4 mip levels with 2 pages at the top, 4 cache slots means 2 free ones
+	zest_virtual_texture_info_t info = zest_CreateVirtualTextureInfo(1024, 512);
+	info.page_size = 64;
+	info.page_border = 2;
+	info.cache_pages_x = 2;
+	info.cache_pages_y = 2;
+	info.upload_budget = 4;
+	info.load_page = tst__load_virtual_page;
+	info.user_data = &vt_test;
+	zest_virtual_texture virtual_texture = zest_CreateVirtualTexture(context, &info);
+	if (!virtual_texture) {
+		test->result = 1;
+		return test->result;
+	}
+	zest_virtual_texture_shader_info_t shader_info = zest_GetVirtualTextureShaderInfo(virtual_texture);
+	if (shader_info.mip_count != 4 || shader_info.pages_x != 16 || shader_info.pages_y != 8) failed_count++;
+	//Flat page indexes: mip 0 starts at 0, mip 1 at 128, mip 2 at 160 and mip 3 at 168
+	const zest_uint mip1 = 128, mip2 = 160;
+	zest_buffer feedback_buffers[2];
+	feedback_buffers[0] = zest_CreateStagingBuffer(device, 170 * sizeof(zest_uint), 0);
+	feedback_buffers[1] = zest_GetVirtualTextureFeedbackBuffer(virtual_texture);
+
+	//The first update only loads the coarsest level
+	if (zest_UpdateVirtualTexture(virtual_texture) != 2) failed_count++;
+	if (!zest_VirtualPageIsResident(virtual_texture, 3, 0, 0) || !zest_VirtualPageIsResident(virtual_texture, 3, 1, 0)) failed_count++;
+	zest_uint *feedback = (zest_uint *)zest_BufferData(feedback_buffers[0]);
+	memset(feedback, 0, 170 * sizeof(zest_uint));
+	feedback[2 * 16 + 3] = 1;
+	failed_count += tst__run_virtual_texture_frame(tests, test, virtual_texture, feedback_buffers);
+
+	//Page 3,2 of mip 0 needs 1,1 of mip 1 and 0,0 of mip 2 above it, only the coarser two fit
+	zest_virtual_texture_stats_t stats = zest_GetVirtualTextureStats(virtual_texture);
+	if (stats.feedback_count != 1 || stats.visible_pages != 4 || stats.requested_pages != 3) failed_count++;
+	if (zest_UpdateVirtualTexture(virtual_texture) != 2) failed_count++;
+	if (!zest_VirtualPageIsResident(virtual_texture, 2, 0, 0) || !zest_VirtualPageIsResident(virtual_texture, 1, 1, 1)) failed_count++;
+	if (zest_VirtualPageIsResident(virtual_texture, 0, 3, 2)) failed_count++;
+	stats = zest_GetVirtualTextureStats(virtual_texture);
+	if (stats.resident_pages != 4 || stats.cache_full_count != 1 || stats.requested_pages != 1 || stats.total_evictions) failed_count++;
+
+	//Now only 0,0 of mip 1 is visible so the least recently used page, 1,1 of mip 1, makes way for it
+	memset(feedback, 0, 170 * sizeof(zest_uint));
+	feedback[mip1] = 1;
+	failed_count += tst__run_virtual_texture_frame(tests, test, virtual_texture, feedback_buffers);
+	if (zest_UpdateVirtualTexture(virtual_texture) != 1) failed_count++;
+	if (!zest_VirtualPageIsResident(virtual_texture, 1, 0, 0) || zest_VirtualPageIsResident(virtual_texture, 1, 1, 1)) failed_count++;
+	if (!zest_VirtualPageIsResident(virtual_texture, 2, 0, 0)) failed_count++;
+	stats = zest_GetVirtualTextureStats(virtual_texture);
+	if (stats.total_evictions != 1 || stats.total_loads != 5 || vt_test.loads != 5) failed_count++;
+	if (stats.cache_bytes != 4 * 68 * 68 * 4 || stats.virtual_bytes != 170 * 64 * 64 * 4) failed_count++;
+	memset(feedback, 0, 170 * sizeof(zest_uint));
+	failed_count += tst__run_virtual_texture_frame(tests, test, virtual_texture, feedback_buffers);
+
+	//Read back mip 1 of the page table and the cache slot that 0,0 of mip 1 went in to
+	int fired = 0;
+	ReadbackCapture captures[2] = {};
+	captures[0].fired = &fired;
+	captures[1].fired = &fired;
+	zest_image_readback_region_t region = {};
+	region.mip_level = 1;
+	zest_ReadbackImage(context, zest_GetImage(zest_GetVirtualTexturePageTable(virtual_texture)), &region, tst__readback_capture, &captures[0]);
+	if (zest_FlushReadbacks(context, ZEST_SECONDS_IN_MICROSECONDS(10)) != zest_semaphore_status_success) failed_count++;
+	if (captures[0].size == 8 * 4 * 4 && captures[0].data) {
+		zest_uint *texels = (zest_uint *)captures[0].data;
+		//0,0 is resident at mip 1, 1,1 falls back to 0,0 of mip 2 and 7,3 falls back to the pinned 1,0 of mip 3
+		zest_uint resident = texels[0];
+		zest_uint fallback = texels[1 * 8 + 1];
+		zest_uint pinned = texels[3 * 8 + 7];
+		if ((resident >> 16 & 0xFF) != 1 || (resident >> 24) != 255) failed_count++;
+		if ((fallback >> 16 & 0xFF) != 2 || (fallback >> 24) != 255) failed_count++;
+		if ((pinned >> 16 & 0xFF) != 3 || (pinned >> 24) != 255) failed_count++;
+		//1,1 of mip 1 was evicted so its slot is the one 0,0 of mip 1 now uses
+		region = {};
+		region.x = (resident & 0xFF) * 68 + 2;
+		region.y = (resident >> 8 & 0xFF) * 68 + 2;
+		region.width = 64;
+		region.height = 64;
+		zest_ReadbackImage(context, zest_GetImage(zest_GetVirtualTexturePageCache(virtual_texture)), &region, tst__readback_capture, &captures[1]);
+		if (zest_FlushReadbacks(context, ZEST_SECONDS_IN_MICROSECONDS(10)) != zest_semaphore_status_success) failed_count++;
+		zest_byte expected[4] = { 1, 0, 0, 255 };
+		if (captures[1].size != 64 * 64 * 4 || !captures[1].data || memcmp(captures[1].data, expected, 4) || memcmp(captures[1].data + 64 * 64 * 4 - 4, expected, 4)) failed_count++;
+	} else {
+		failed_count++;
+	}
+
+	free(captures[0].data);
+	free(captures[1].data);
+	zest_FreeBuffer(feedback_buffers[0]);
+	zest_FreeVirtualTexture(virtual_texture);
+
+	test->result |= failed_count > 0 ? 1 : 0;
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+//Upload a whole mip chain in one go and check that every level holds what was uploaded rather than a blit of mip 0
+int test__image_mip_chain_upload(ZestTests *tests, Test *test) {
+	int failed_count = 0;
+	zest_device device = tests->device;
+	zest_context context = tests->context;
+
+	//Block compressed levels round up to whole blocks, so the 2x2 and 1x1 levels of BC1 are still 8 bytes
+	zest_extent3d_t extent = { 64, 64, 1 };
+	if (zest_GetImageMipLevelSize(zest_format_bc1_rgba_unorm_block, extent, 0, 1) != 16 * 16 * 8) failed_count++;
+	if (zest_GetImageMipLevelSize(zest_format_bc1_rgba_unorm_block, extent, 5, 1) != 8) failed_count++;
+	if (zest_GetImageMipLevelSize(zest_format_bc1_rgba_unorm_block, extent, 6, 6) != 6 * 8) failed_count++;
+	if (zest_GetImageMipLevelSize(zest_format_r8g8b8a8_unorm, extent, 3, 2) != 8 * 8 * 4 * 2) failed_count++;
+	if (zest_IsImageFormatSupported(device, zest_format_undefined, zest_image_preset_texture)) failed_count++;
+	if (!zest_IsImageFormatSupported(device, zest_format_r8g8b8a8_unorm, zest_image_preset_texture)) failed_count++;
+
+	//Give each mip its own color so a generated level would be easy to spot
+	zest_image_info_t info = zest_CreateImageInfo(64, 64);
+	info.mip_levels = 7;
+	info.format = zest_format_r8g8b8a8_unorm;
+	info.flags = zest_image_preset_texture | zest_image_flag_transfer_src;
+	zest_size chain_size = zest_GetImageMipChainSize(&info);
+	if (chain_size != (64 * 64 + 32 * 32 + 16 * 16 + 8 * 8 + 4 * 4 + 2 * 2 + 1) * 4) failed_count++;
+	zest_uint *pixels = (zest_uint*)malloc(chain_size);
+	zest_uint *level = pixels;
+	for (zest_uint mip = 0; mip != info.mip_levels; ++mip) {
+		zest_uint texels = (64 >> mip) * (64 >> mip);
+		for (zest_uint i = 0; i != texels; ++i) {
+			level[i] = 0xFF000000 | (mip * 30 + 10);
+		}
+		level += texels;
+	}
+	zest_image_handle image_handle = zest_CreateImageWithMipChain(device, pixels, chain_size, &info);
+	zest_image image = zest_GetImage(image_handle);
+	if (!image_handle.value || zest_ImageInfo(image)->mip_levels != 7) failed_count++;
+
+	int fired = 0;
+	ReadbackCapture capture = {};
+	capture.fired = &fired;
+	zest_image_readback_region_t region = {};
+	region.mip_level = 3;
+	region.width = 8;
+	region.height = 8;
+	if (image_handle.value) {
+		zest_ReadbackImage(context, image, &region, tst__readback_capture, &capture);
+		if (zest_FlushReadbacks(context, ZEST_SECONDS_IN_MICROSECONDS(10)) != zest_semaphore_status_success) failed_count++;
+		zest_uint expected = 0xFF000000 | (3 * 30 + 10);
+		if (capture.size != 8 * 8 * 4 || !capture.data || memcmp(capture.data, &expected, 4) || memcmp(capture.data + 8 * 8 * 4 - 4, &expected, 4)) failed_count++;
+		if (image->layout != zest_image_layout_shader_read_only_optimal) failed_count++;
+	}
+	free(capture.data);
+	free(pixels);
+	zest_FreeImage(image_handle);
+
+	//A compressed cube map with pre-built mips, which can't go through the mip generation path at all
+	zest_format compressed_format = zest_format_bc1_rgba_unorm_block;
+	if (!zest_IsImageFormatSupported(device, compressed_format, zest_image_preset_texture)) {
+		compressed_format = zest_format_etc2_r8g8b8a8_unorm_block;
+	}
+	if (zest_IsImageFormatSupported(device, compressed_format, zest_image_preset_texture)) {
+		zest_image_info_t cube_info = zest_CreateImageInfo(32, 32);
+		cube_info.mip_levels = 6;
+		cube_info.layer_count = 6;
+		cube_info.format = compressed_format;
+		cube_info.flags = zest_image_preset_texture | zest_image_flag_cubemap;
+		zest_size cube_size = zest_GetImageMipChainSize(&cube_info);
+		zest_byte *blocks = (zest_byte*)calloc(1, cube_size);
+		zest_image_handle cube_handle = zest_CreateImageWithMipChain(device, blocks, cube_size, &cube_info);
+		if (!cube_handle.value) {
+			failed_count++;
+		} else {
+			const zest_image_info_t *created = zest_ImageInfo(zest_GetImage(cube_handle));
+			if (created->mip_levels != 6 || created->layer_count != 6 || created->format != compressed_format) failed_count++;
+		}
+		free(blocks);
+		zest_FreeImage(cube_handle);
+	}
+
+	test->result |= failed_count > 0 ? 1 : 0;
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+//A KTX2 file laid out the way the loader expects it: header, level index, data format descriptor and then the
+//level data, built in memory so the tests don't depend on any asset files
+#define KTX2_TEST_MAX_LEVELS 8
+
+struct Ktx2TestFile {
+	zest_uint vk_format;
+	zest_uint width;
+	zest_uint height;
+	zest_uint layer_count;
+	zest_uint face_count;
+	zest_uint level_count;
+	zest_uint supercompression;
+	const zest_byte *dfd;
+	zest_uint dfd_length;
+	const zest_byte *levels[KTX2_TEST_MAX_LEVELS];
+	zest_u64 level_sizes[KTX2_TEST_MAX_LEVELS];
+	zest_u64 uncompressed_sizes[KTX2_TEST_MAX_LEVELS];
+};
+
+//Returns a malloc'd file and its size in file_size
+zest_byte *tst__build_ktx2(const Ktx2TestFile *ktx, zest_size *file_size) {
+	static const zest_byte identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+	zest_size dfd_offset = 80 + ktx->level_count * 24;
+	zest_size size = dfd_offset + ktx->dfd_length;
+	for (zest_uint i = 0; i != ktx->level_count; ++i) {
+		size += ktx->level_sizes[i];
+	}
+	zest_byte *file = (zest_byte*)calloc(1, size);
+	zest_uint header[13] = { ktx->vk_format, 1, ktx->width, ktx->height, 0, ktx->layer_count, ktx->face_count, ktx->level_count, ktx->supercompression,
+		ktx->dfd_length ? (zest_uint)dfd_offset : 0, ktx->dfd_length, 0, 0 };
+	memcpy(file, identifier, sizeof(identifier));
+	memcpy(file + 12, header, sizeof(header));
+	memcpy(file + dfd_offset, ktx->dfd, ktx->dfd_length);
+	zest_u64 offset = dfd_offset + ktx->dfd_length;
+	for (zest_uint i = 0; i != ktx->level_count; ++i) {
+		zest_u64 index[3] = { offset, ktx->level_sizes[i], ktx->uncompressed_sizes[i] ? ktx->uncompressed_sizes[i] : ktx->level_sizes[i] };
+		memcpy(file + 80 + i * 24, index, sizeof(index));
+		memcpy(file + offset, ktx->levels[i], ktx->level_sizes[i]);
+		offset += ktx->level_sizes[i];
+	}
+	*file_size = size;
+	return file;
+}
+
+void tst__write_file(const char *path, const zest_byte *data, zest_size size) {
+	FILE *file = fopen(path, "wb");
+	if (file) {
+		fwrite(data, 1, size, file);
+		fclose(file);
+	}
+}
+
+zest_bool tst__ktx2_loads(zest_device device, const char *path, const zest_ktx2_load_info_t *info) {
+	zest_image_collection_t collection = zest__load_ktx2(device, path, info);
+	zest_bool loaded = (collection.flags & zest_image_collection_flag_initialised) != 0;
+	zest_FreeBitmapArray(&collection.bitmap_array);
+	zest_FreeImageCollection(&collection);
+	return loaded;
+}
+
+//An 8x8 RGBA file with four levels, each filled with its own color
+zest_byte *tst__build_raw_ktx2(zest_uint *pixels, zest_size *file_size) {
+	Ktx2TestFile ktx = {};
+	ktx.vk_format = zest_format_r8g8b8a8_unorm;
+	ktx.width = 8;
+	ktx.height = 8;
+	ktx.face_count = 1;
+	ktx.level_count = 4;
+	zest_uint *level = pixels;
+	for (zest_uint mip = 0; mip != ktx.level_count; ++mip) {
+		zest_uint texels = (8 >> mip) * (8 >> mip);
+		for (zest_uint i = 0; i != texels; ++i) {
+			level[i] = 0xFF000000 | (mip * 40 + 20);
+		}
+		ktx.levels[mip] = (const zest_byte*)level;
+		ktx.level_sizes[mip] = texels * 4;
+		level += texels;
+	}
+	return tst__build_ktx2(&ktx, file_size);
+}
+
+//Load a raw KTX2 file with no transcoding: every level has to come through untouched, both through the
+//loader and once it's uploaded, and zest_LoadKTX has to hand KTX2 files to the KTX2 loader.
+int test__ktx2_raw_load(ZestTests *tests, Test *test) {
+	int failed_count = 0;
+	zest_device device = tests->device;
+	zest_context context = tests->context;
+	const char *path = "zest_test_raw.ktx2";
+
+	zest_uint pixels[64 + 16 + 4 + 1];
+	zest_size file_size = 0;
+	zest_byte *file = tst__build_raw_ktx2(pixels, &file_size);
+	tst__write_file(path, file, file_size);
+
+	zest_ktx2_load_info_t info = zest_CreateKTX2LoadInfo();
+	zest_image_collection_t collection = zest__load_ktx2(device, path, &info);
+	zest_bitmap_array_t *bitmap_array = &collection.bitmap_array;
+	if (!(collection.flags & zest_image_collection_flag_initialised) || collection.format != zest_format_r8g8b8a8_unorm || bitmap_array->size_of_array != 4) {
+		failed_count++;
+	} else {
+		if (bitmap_array->meta[2].width != 2 || bitmap_array->meta[2].height != 2) failed_count++;
+		if (bitmap_array->total_mem_size != sizeof(pixels) || memcmp(bitmap_array->data, pixels, sizeof(pixels))) failed_count++;
+	}
+	zest_FreeBitmapArray(bitmap_array);
+	zest_FreeImageCollection(&collection);
+
+	zest_image_handle image_handle = zest_LoadKTX2(device, "Raw KTX2", path, &info);
+	zest_image image = zest_GetImage(image_handle);
+	if (!image_handle.value || zest_ImageInfo(image)->mip_levels != 4) {
+		failed_count++;
+	} else {
+		int fired = 0;
+		ReadbackCapture capture = {};
+		capture.fired = &fired;
+		zest_image_readback_region_t region = {};
+		region.mip_level = 2;
+		region.width = 2;
+		region.height = 2;
+		zest_ReadbackImage(context, image, &region, tst__readback_capture, &capture);
+		if (zest_FlushReadbacks(context, ZEST_SECONDS_IN_MICROSECONDS(10)) != zest_semaphore_status_success) failed_count++;
+		zest_uint expected = 0xFF000000 | (2 * 40 + 20);
+		if (capture.size != 2 * 2 * 4 || !capture.data || memcmp(capture.data, &expected, 4) || memcmp(capture.data + 12, &expected, 4)) failed_count++;
+		free(capture.data);
+	}
+	zest_FreeImage(image_handle);
+
+	zest_image_handle forwarded_handle = zest_LoadKTX(device, "Forwarded KTX2", path);
+	if (!forwarded_handle.value || zest_ImageInfo(zest_GetImage(forwarded_handle))->mip_levels != 4) failed_count++;
+	zest_FreeImage(forwarded_handle);
+
+	free(file);
+	remove(path);
+
+	test->result |= failed_count > 0 ? 1 : 0;
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+//Truncated and malformed KTX2 files must be rejected before anything is read out of bounds, including
+//offsets and lengths that only fit in the file if their sum wraps around
+int test__ktx2_malformed(ZestTests *tests, Test *test) {
+	int failed_count = 0;
+	zest_device device = tests->device;
+	const char *path = "zest_test_malformed.ktx2";
+	zest_ktx2_load_info_t info = zest_CreateKTX2LoadInfo();
+
+	zest_uint pixels[64 + 16 + 4 + 1];
+	zest_size file_size = 0;
+	zest_byte *file = tst__build_raw_ktx2(pixels, &file_size);
+	zest_byte *bad = (zest_byte*)malloc(file_size);
+	zest_u64 wrap_offset = 0xFFFFFFFFFFFFFFF0ull;
+	zest_u64 wrap_length = 0x20;
+	zest_uint huge = 0x80000000;
+
+	//The untouched file loads, so each failure below is down to the one thing that was broken
+	tst__write_file(path, file, file_size);
+	if (!tst__ktx2_loads(device, path, &info)) failed_count++;
+
+	//Cut off in the header, then in the level data
+	tst__write_file(path, file, 40);
+	if (tst__ktx2_loads(device, path, &info)) failed_count++;
+	tst__write_file(path, file, file_size - 8);
+	if (tst__ktx2_loads(device, path, &info)) failed_count++;
+
+	//Not a KTX2 identifier
+	memcpy(bad, file, file_size);
+	bad[5] = '1';
+	tst__write_file(path, bad, file_size);
+	if (tst__ktx2_loads(device, path, &info)) failed_count++;
+
+	//A level offset and length that add up to less than the file size
+	memcpy(bad, file, file_size);
+	memcpy(bad + 80, &wrap_offset, 8);
+	memcpy(bad + 88, &wrap_length, 8);
+	tst__write_file(path, bad, file_size);
+	if (tst__ktx2_loads(device, path, &info)) failed_count++;
+
+	//The same for the supercompression global data
+	memcpy(bad, file, file_size);
+	memcpy(bad + 64, &wrap_offset, 8);
+	memcpy(bad + 72, &wrap_length, 8);
+	tst__write_file(path, bad, file_size);
+	if (tst__ktx2_loads(device, path, &info)) failed_count++;
+
+	//Sizes too big for the level sizes to be worked out safely
+	memcpy(bad, file, file_size);
+	memcpy(bad + 20, &huge, 4);
+	tst__write_file(path, bad, file_size);
+	if (tst__ktx2_loads(device, path, &info)) failed_count++;
+	memcpy(bad, file, file_size);
+	memcpy(bad + 32, &huge, 4);
+	tst__write_file(path, bad, file_size);
+	if (tst__ktx2_loads(device, path, &info)) failed_count++;
+
+	//Supercompressed (zstd) but there's no transcoder to decompress it
+	memcpy(bad, file, file_size);
+	zest_uint zstd = zest_ktx2_supercompression_zstd;
+	memcpy(bad + 44, &zstd, 4);
+	tst__write_file(path, bad, file_size);
+	if (tst__ktx2_loads(device, path, &info)) failed_count++;
+
+	if (zest_LoadKTX2(device, "Malformed KTX2", path, &info).value) failed_count++;
+
+	free(bad);
+	free(file);
+	remove(path);
+
+	test->result |= failed_count > 0 ? 1 : 0;
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+struct Ktx2TranscodeCapture {
+	volatile int calls;
+	volatile int bad_jobs;
+	zest_bool fail_level_1;
+};
+
+//Stands in for a real transcoder: checks what the loader passed and fills each level with a color per mip
+zest_bool tst__stub_ktx2_transcoder(const zest_ktx2_transcode_job_t *job, void *user_data) {
+	Ktx2TranscodeCapture *capture = (Ktx2TranscodeCapture*)user_data;
+	zest__atomic_fetch_add(&capture->calls, 1);
+	zest_uint width = 16 >> job->mip_level;
+	if (job->source != zest_ktx2_source_uastc || job->supercompression != zest_ktx2_supercompression_zstd ||
+		job->dst_format != zest_format_r8g8b8a8_unorm || job->width != width || job->height != width ||
+		job->dst_size != width * width * 4 || job->src_size != 16 || job->src[0] != job->mip_level) {
+		zest__atomic_fetch_add(&capture->bad_jobs, 1);
+	}
+	if (capture->fail_level_1 && job->mip_level == 1) {
+		return ZEST_FALSE;
+	}
+	zest_uint color = 0xFF000000 | (job->mip_level * 50 + 30);
+	for (zest_size i = 0; i != job->dst_size / 4; ++i) {
+		memcpy(job->dst + i * 4, &color, 4);
+	}
+	return ZEST_TRUE;
+}
+
+//A zstd supercompressed UASTC file goes through a stub transcoder once per level, and a level that fails to
+//transcode fails the whole load
+int test__ktx2_transcoder(ZestTests *tests, Test *test) {
+	int failed_count = 0;
+	zest_device device = tests->device;
+	zest_context context = tests->context;
+	const char *path = "zest_test_uastc.ktx2";
+
+	//Data format descriptor: total size, then a basic block with the UASTC color model and one RGBA sample
+	zest_byte dfd[44] = {};
+	zest_uint dfd_total = sizeof(dfd);
+	zest_uint block_size = (24 + 16) << 16 | 2;
+	memcpy(dfd, &dfd_total, 4);
+	memcpy(dfd + 8, &block_size, 4);
+	dfd[12] = 166;		//KHR_DF_MODEL_UASTC
+	dfd[14] = 1;		//Linear transfer
+	dfd[28 + 3] = 3;	//KHR_DF_CHANNEL_UASTC_RGBA
+
+	zest_byte levels[5][16];
+	Ktx2TestFile ktx = {};
+	ktx.width = 16;
+	ktx.height = 16;
+	ktx.face_count = 1;
+	ktx.level_count = 5;
+	ktx.supercompression = zest_ktx2_supercompression_zstd;
+	ktx.dfd = dfd;
+	ktx.dfd_length = sizeof(dfd);
+	for (zest_uint mip = 0; mip != ktx.level_count; ++mip) {
+		memset(levels[mip], mip, sizeof(levels[mip]));
+		ktx.levels[mip] = levels[mip];
+		ktx.level_sizes[mip] = sizeof(levels[mip]);
+	}
+	zest_size file_size = 0;
+	zest_byte *file = tst__build_ktx2(&ktx, &file_size);
+	tst__write_file(path, file, file_size);
+
+	Ktx2TranscodeCapture capture = {};
+	zest_ktx2_load_info_t info = zest_CreateKTX2LoadInfo();
+	info.transcoder = tst__stub_ktx2_transcoder;
+	info.user_data = &capture;
+	info.target_format = zest_format_r8g8b8a8_unorm;
+	zest_image_handle image_handle = zest_LoadKTX2(device, "Transcoded KTX2", path, &info);
+	zest_image image = zest_GetImage(image_handle);
+	if (capture.calls != 5 || capture.bad_jobs != 0) failed_count++;
+	if (!image_handle.value || zest_ImageInfo(image)->mip_levels != 5 || zest_ImageInfo(image)->format != zest_format_r8g8b8a8_unorm) {
+		failed_count++;
+	} else {
+		int fired = 0;
+		ReadbackCapture readback = {};
+		readback.fired = &fired;
+		zest_image_readback_region_t region = {};
+		region.mip_level = 1;
+		region.width = 8;
+		region.height = 8;
+		zest_ReadbackImage(context, image, &region, tst__readback_capture, &readback);
+		if (zest_FlushReadbacks(context, ZEST_SECONDS_IN_MICROSECONDS(10)) != zest_semaphore_status_success) failed_count++;
+		zest_uint expected = 0xFF000000 | (1 * 50 + 30);
+		if (readback.size != 8 * 8 * 4 || !readback.data || memcmp(readback.data, &expected, 4) || memcmp(readback.data + 8 * 8 * 4 - 4, &expected, 4)) failed_count++;
+		free(readback.data);
+	}
+	zest_FreeImage(image_handle);
+
+	capture = {};
+	capture.fail_level_1 = ZEST_TRUE;
+	if (tst__ktx2_loads(device, path, &info) || capture.calls != 5) failed_count++;
+
+	free(file);
+	remove(path);
+
+	test->result |= failed_count > 0 ? 1 : 0;
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
+
+//Create a batch of small textures, storage images and a render target in one call and check that they're all
+//usable, that the pooled textures share memory pools and that a bad info in the batch creates nothing.
+int test__batched_image_creation(ZestTests *tests, Test *test) {
+	int failed_count = 0;
+	zest_device device = tests->device;
+
+	const zest_uint batch_count = 256;
+	zest_image_info_t *infos = (zest_image_info_t*)malloc(sizeof(zest_image_info_t) * batch_count);
+	zest_image_handle *handles = (zest_image_handle*)malloc(sizeof(zest_image_handle) * batch_count);
+	for (zest_uint i = 0; i != batch_count; ++i) {
+		zest_uint size = 16 << (i % 4);
+		infos[i] = zest_CreateImageInfo(size, size);
+		infos[i].format = i % 2 ? zest_format_r8g8b8a8_unorm : zest_format_r8g8b8a8_srgb;
+		infos[i].flags = zest_image_preset_texture;
+	}
+	infos[10].flags = zest_image_preset_storage;
+	infos[10].format = zest_format_r8g8b8a8_unorm;
+	infos[11].flags = zest_image_preset_storage;
+	infos[11].format = zest_format_r8g8b8a8_unorm;
+	infos[12].flags = zest_image_preset_texture_mipmaps;
+	infos[13] = zest_CreateImageInfo(1024, 1024);
+	infos[13].format = zest_format_r16g16b16a16_sfloat;
+	infos[13].flags = zest_image_preset_color_attachment;
+
+	if (!zest_CreateImages(device, infos, batch_count, handles)) failed_count++;
+	void *first_pool = 0;
+	int shared_pool_count = 0;
+	for (zest_uint i = 0; i != batch_count; ++i) {
+		if (!handles[i].value) {
+			failed_count++;
+			continue;
+		}
+		zest_image image = zest_GetImage(handles[i]);
+		const zest_image_info_t *info = zest_ImageInfo(image);
+		if (info->extent.width != infos[i].extent.width || info->format != infos[i].format) failed_count++;
+		if (!image->default_view || !image->buffer) failed_count++;
+		if (ZEST__FLAGGED(info->flags, zest_image_flag_storage) && image->layout != zest_image_layout_general) failed_count++;
+		if (i == 12 && info->mip_levels != 5) failed_count++;
+		if (i >= 20 && ZEST__NOT_FLAGGED(info->flags, zest_image_flag_dedicated_memory)) {
+			zest_buffer buffer = (zest_buffer)image->buffer;
+			if (!first_pool) first_pool = buffer->memory_pool;
+			if (buffer->memory_pool == first_pool) shared_pool_count++;
+		}
+	}
+	//The small textures are packed together rather than each getting a pool or an allocation
+	if (shared_pool_count < 2) failed_count++;
+
+	//Images in a batch are freed one by one like any other image
+	for (zest_uint i = 0; i != batch_count; i += 2) {
+		zest_FreeImageNow(handles[i]);
+		handles[i] = ZEST__ZERO_INIT(zest_image_handle);
+	}
+	zest_image_info_t single = zest_CreateImageInfo(64, 64);
+	single.flags = zest_image_preset_texture;
+	zest_image_handle reused = zest_CreateImage(device, &single);
+	if (!reused.value) failed_count++;
+	zest_FreeImageNow(reused);
+	for (zest_uint i = 1; i < batch_count; i += 2) {
+		zest_FreeImageNow(handles[i]);
+	}
+
+	//One invalid info means none of the batch is created
+	zest_uint errors_before = zest_GetValidationErrorCount(device);
+	infos[5].extent.width = 0;
+	if (zest_CreateImages(device, infos, 8, handles)) failed_count++;
+	for (zest_uint i = 0; i != 8; ++i) {
+		if (handles[i].value) failed_count++;
+	}
+	if (zest_GetValidationErrorCount(device) == errors_before) failed_count++;
+	zest_ResetValidationErrors(device);
+
+	if (!zest_CreateImages(device, infos, 0, handles)) failed_count++;
+
+	free(infos);
+	free(handles);
+
+	test->result |= failed_count > 0 ? 1 : 0;
+	test->result |= zest_GetValidationErrorCount(tests->device);
+	test->frame_count++;
+	return test->result;
+}
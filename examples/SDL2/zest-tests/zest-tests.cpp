@@ -1,6 +1,7 @@
 #define ZEST_IMPLEMENTATION
 #define ZEST_VULKAN_IMPLEMENTATION
 #define ZEST_TEST_MODE
+#define ZEST_KTX_IMPLEMENTATION
 #include "zest-tests.h"
 #include "zest.h"
 #include "imgui_internal.h"
@@ -38,6 +39,7 @@ void InitialiseTests(ZestTests *tests) {
 	RegisterTest(tests, { "Stress Test Transient Images", test__stress_transient_images, 0, ZEST_MAX_FIF, 0, 0, tests->simple_create_info });
 	RegisterTest(tests, { "Stress Test All Transients", test__stress_all_transients, 0, ZEST_MAX_FIF, 0, 0, tests->simple_create_info });
 	RegisterTest(tests, { "Stress Test Multi Queue", test__stress_multi_queue_sync, 0, ZEST_MAX_FIF, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Hash Map Benchmark", test__hash_map_benchmark, 0, 1, 0, 0, tests->headless_create_info });
 	RegisterTest(tests, { "Pipeline Test State Depth", test__pipeline_state_depth, 0, ZEST_MAX_FIF, 0, 0, tests->simple_create_info });
 	RegisterTest(tests, { "Pipeline Test State Blending", test__pipeline_state_blending, 0, 1, 0, 0, tests->simple_create_info });
 	RegisterTest(tests, { "Pipeline Test State Culling", test__pipeline_state_culling, 0, 1, 0, 0, tests->simple_create_info });
@@ -48,6 +50,9 @@ void InitialiseTests(ZestTests *tests) {
 	RegisterTest(tests, { "Pipeline Test State MultiBlend", test__pipeline_state_multiblend, 0, 1, 0, 0, tests->simple_create_info });
 	RegisterTest(tests, { "Pipeline Test State Rasterization", test__pipeline_state_rasterization, 0, 1, 0, 0, tests->simple_create_info });
 	RegisterTest(tests, { "Shader Cache Invalidation", test__shader_cache_invalidation, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Pipeline Cache Persistence", test__pipeline_cache_persistence, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Pipeline Test Background Compile", test__pipeline_background_compile, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Shader Batch Compile", test__shader_batch_compile, 0, 1, 0, 0, tests->simple_create_info });
 	RegisterTest(tests, { "Resource Test Image Format Support", test__image_format_support, 0, 1, 0, 0, tests->simple_create_info });
 	RegisterTest(tests, { "Resource Test Image Creation Destruction", test__image_creation_destruction, 0, 1, 0, 0, tests->simple_create_info });
 	RegisterTest(tests, { "Resource Test Image Format Edge Cases", test__image_format_validation_edge_cases, 0, 1, 0, 0, tests->simple_create_info });
@@ -88,6 +93,12 @@ void InitialiseTests(ZestTests *tests) {
 	RegisterTest(tests, { "Compute Test WAW Barrier", test__compute_waw_barrier, 0, 1, 0, 0, tests->headless_create_info });
 	RegisterTest(tests, { "Compute Test Flush Compile Failure No Hang", test__flush_compile_failure_no_hang, 0, 1, 0, 0, tests->headless_create_info });
 	RegisterTest(tests, { "Compute Test Headless Flush And Wait", test__headless_flush_and_wait, 0, 1, 0, 0, tests->headless_create_info });
+	RegisterTest(tests, { "Compute Test Parallel Recording", test__parallel_recording, 0, 1, 0, 0, tests->headless_create_info });
+	RegisterTest(tests, { "Job System Parallel For", test__job_system, 0, 1, 0, 0, tests->headless_create_info });
+	RegisterTest(tests, { "Thread Allocator Cache", test__thread_allocator_cache, 0, 1, 0, 0, tests->headless_create_info });
+	RegisterTest(tests, { "Concurrent Pool Growth", test__concurrent_pool_growth, 0, 1, 0, 0, tests->headless_create_info });
+	RegisterTest(tests, { "Frame Graph Structure Reuse", test__frame_graph_structure_reuse, 0, 1, 0, 0, tests->headless_create_info });
+	RegisterTest(tests, { "Frame Graph Cache LRU", test__frame_graph_cache_lru, 0, 1, 0, 0, tests->headless_create_info });
 	//Registered last: this test perturbs the bindless index free list (it creates transient
 	//images), which the Acquire/Release Indexes test is sensitive to as it releases hardcoded
 	//index values.
@@ -104,6 +115,14 @@ void InitialiseTests(ZestTests *tests) {
 	RegisterTest(tests, { "Resource Test Dedicated Buffer", test__dedicated_buffer, 0, 1, 0, 0, tests->simple_create_info });
 	RegisterTest(tests, { "Resource Test Buffer Grow Contract", test__buffer_grow_contract, 0, 1, 0, 0, tests->simple_create_info });
 	RegisterTest(tests, { "Resource Test Pooled Image Allocations", test__pooled_image_allocations, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Resource Test Image Streaming", test__image_streaming, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Resource Test Readbacks", test__readbacks, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Resource Test Virtual Textures", test__virtual_textures, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Resource Test Image Mip Chain Upload", test__image_mip_chain_upload, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Resource Test KTX2 Raw Load", test__ktx2_raw_load, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Resource Test KTX2 Malformed Files", test__ktx2_malformed, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Resource Test KTX2 Transcoder", test__ktx2_transcoder, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Resource Test Batched Image Creation", test__batched_image_creation, 0, 1, 0, 0, tests->simple_create_info });
 	RegisterTest(tests, { "Cached Transient Placement", test__cached_transient_placement, 0, ZEST_MAX_FIF * 4, 0, 0, tests->simple_create_info });
 	RegisterTest(tests, { "Unbacked Transient Barrier", test__unbacked_transient_barrier, 0, ZEST_MAX_FIF * 4, 0, 0, tests->simple_create_info });
 	//Arena sharing tests: cached graphs no longer pin their transient arenas, so the pool must stay
@@ -118,6 +137,20 @@ void InitialiseTests(ZestTests *tests) {
 	RegisterTest(tests, { "Layer Test Buffer Growth", test__instance_layer_grow, 0, 1, 0, 0, tests->simple_create_info });
 	RegisterTest(tests, { "Layer Test Instance Draw", test__instance_layer_draw, 0, 1, 0, 0, tests->simple_create_info });
 	RegisterTest(tests, { "Layer Test Frame In Flight", test__instance_layer_fif, 0, ZEST_MAX_FIF * 2, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Layer Test Delta Upload", test__instance_layer_delta_upload, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Layer Test Direct Write", test__instance_layer_direct_write, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Layer Test Parallel Writing", test__instance_layer_parallel_write, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Layer Test Draw State Elision", test__instance_layer_draw_state, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Layer Test Multi Draw Indirect", test__instance_mesh_layer_indirect, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Layer Test GPU Culling", test__instance_mesh_layer_gpu_culling, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Layer Test Instance Store", test__instance_layer_store, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Layer Test Indirect Delta Reset", test__instance_layer_indirect_delta_reset, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Layer Test Indirect Store Update", test__instance_layer_indirect_store_update, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Mesh Test Bulk Build", test__mesh_bulk_build, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Mesh Test Pool", test__mesh_pool, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Mesh Test Indirect Defragment", test__mesh_pool_indirect_defragment, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Layer Test Mesh LOD", test__instance_mesh_layer_lod, 0, 1, 0, 0, tests->simple_create_info });
+	RegisterTest(tests, { "Layer Test GPU Mesh LOD", test__instance_mesh_layer_gpu_lod, 0, 1, 0, 0, tests->simple_create_info });
 	//Device reset tests run their own reset cycles internally, which rebuilds the bindless index
 	//free lists among other things, so they stay last where they can't disturb any test that is
 	//sensitive to accumulated device state.
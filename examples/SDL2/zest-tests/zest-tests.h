@@ -7,7 +7,7 @@
 #include <imgui/misc/freetype/imgui_freetype.h>
 #include <imgui/backends/imgui_impl_sdl2.h>
 
-#define TEST_COUNT 128
+#define TEST_COUNT 160
 #define MAX_TEST_RESOURCES 500
 
 struct ZestTests;
@@ -86,6 +86,8 @@ int RunSuite(zest_window_data_t *window_data, const char **instance_extensions,
 
 int test__blank_screen(ZestTests *tests, Test *test);
 int test__shader_cache_invalidation(ZestTests *tests, Test *test);
+int test__pipeline_background_compile(ZestTests *tests, Test *test);
+int test__shader_batch_compile(ZestTests *tests, Test *test);
 
 /* Test ideas:
  Core Tests:
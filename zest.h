@@ -21,7 +21,7 @@
     [Pocket_Hasher]                     XXHash code for use in hash map
     [Pocket_hash_map]                   Simple hash map
     [Pocket_text_buffer]                Very simple struct and functions for storing strings
-    [Threading]                         Some thread helpers, unused as yet.
+    [Threading]                         Thread helpers and the device job system.
     [Structs]                           All the structs are defined here.
         [Vectors]
         [frame_graph_types]
@@ -457,6 +457,40 @@ ZLOC_API void zloc_SetLinearAllocatorUserData(zloc_linear_allocator_t *allocator
 ZLOC_API void zloc_AddNextLinearAllocator(zloc_linear_allocator_t *allocator, zloc_linear_allocator_t *next);
 ZLOC_API zloc_size zloc_GetLinearAllocatorCapacity(zloc_linear_allocator_t *allocator);
 
+//Thread cache
+/*
+	An optional front end for an allocator that is owned by a single thread. Small allocations are served from
+	size classed free lists without touching the allocator lock, and the lists are refilled and drained in
+	batches of ZLOC_THREAD_CACHE_BATCH so that the lock is taken once per batch rather than once per block.
+	Blocks sitting in a cache are still marked as used in the pool, so flush the cache before the thread stops
+	using the allocator (and before the allocator is freed).
+*/
+#ifndef ZLOC_THREAD_CACHE_BATCH
+#define ZLOC_THREAD_CACHE_BATCH 16
+#endif
+#define ZLOC_THREAD_CACHE_SMALLEST_CLASS 16
+#define ZLOC_THREAD_CACHE_CLASSES 7				//16, 32, 64 ... 1024 bytes. Anything bigger goes to the allocator.
+typedef struct zloc_thread_cache_stats_t {
+	zloc_size hits;						//Allocations served from the cache
+	zloc_size misses;					//Allocations that had to refill the cache first
+	zloc_size bypassed;					//Allocations and frees too big for the cache that went straight to the allocator
+	zloc_size refills;
+	zloc_size drains;
+	zloc_size lock_acquisitions;		//Times the cache took the allocator lock to refill, drain or flush
+	zloc_size lock_spins;				//Failed attempts at taking the lock, ie. how contended the allocator is
+} zloc_thread_cache_stats_t;
+
+typedef struct zloc_thread_cache_t {
+	zloc_allocator *allocator;
+	void *free_lists[ZLOC_THREAD_CACHE_CLASSES];
+	int counts[ZLOC_THREAD_CACHE_CLASSES];
+	zloc_thread_cache_stats_t stats;
+} zloc_thread_cache_t;
+ZLOC_API void zloc_InitialiseThreadCache(zloc_thread_cache_t *cache, zloc_allocator *allocator);
+ZLOC_API void *zloc_CacheAllocate(zloc_thread_cache_t *cache, zloc_size size);
+ZLOC_API int zloc_CacheFree(zloc_thread_cache_t *cache, void *allocation);
+ZLOC_API void zloc_FlushThreadCache(zloc_thread_cache_t *cache);
+
 //--End of user functions
 
 //Private inline functions, user doesn't need to call these
@@ -1197,7 +1231,7 @@ static const char *zest_message_queue_unavailable = "Frame Graph [%s]: A pass re
 #endif
 
 #ifndef ZEST__FREE
-#define ZEST__FREE(allocator, memory) zloc_Free(allocator, memory)
+#define ZEST__FREE(allocator, memory) zest__free(allocator, memory)
 #endif
 
 #ifndef ZEST__ALLOCATE
@@ -1271,6 +1305,7 @@ typedef zest_uint zest_id;
 typedef zest_uint zest_millisecs;
 typedef zest_uint zest_thread_access;
 typedef zest_uint zest_instruction_id;
+typedef zest_u64 zest_instance_id;
 typedef zest_ull zest_microsecs;
 typedef zest_ull zest_key;
 typedef zest_ull zest_size;
@@ -2008,6 +2043,8 @@ typedef enum zest_struct_type {
 	zest_struct_type_resource_store = 48 << 16,
 	zest_struct_type_pipeline_layout = 50 << 16,
 	zest_struct_type_shader_options = 51 << 16,
+	zest_struct_type_image_streamer = 52 << 16,
+	zest_struct_type_virtual_texture = 53 << 16,
 } zest_struct_type;
 
 typedef enum zest_platform_memory_context {
@@ -2097,6 +2134,8 @@ typedef enum zest_context_flag_bits {
 	zest_context_flag_cpu_profiling_enabled = 1 << 18,
 	zest_context_flag_device_lost = 1 << 19,
 	zest_context_flag_warned_headless_flush = 1 << 20,
+	zest_context_flag_parallel_recording = 1 << 21,
+	zest_context_flag_recording_in_parallel = 1 << 22,
 } zest_context_flag_bits;
 
 typedef zest_uint zest_context_flags;
@@ -2123,6 +2162,8 @@ typedef enum zest_device_init_flag_bits {
 	zest_device_init_flag_force_legacy_render_pass = 1 << 8,	//Vulkan backend only, set with zest_DeviceBuilderForceLegacyRenderPass
 	zest_device_init_flag_using_legacy_render_pass = 1 << 9,
 	zest_device_init_flag_enable_memory_budget = 1 << 10,	//Opt in with zest_DeviceBuilderEnableMemoryBudget
+	zest_device_init_flag_cache_pipelines = 1 << 11,		//Opt in with zest_DeviceBuilderCachePipelines
+	zest_device_init_flag_thread_allocator_caches = 1 << 12,	//Opt in with zest_DeviceBuilderThreadAllocatorCaches
 } zest_device_init_flag_bits;
 
 typedef zest_uint zest_device_init_flags;
@@ -2325,6 +2366,8 @@ typedef enum zest_device_capability_bits {
 	zest_capability_fragment_stores_and_atomics        = 1 << 11,
 	// Auto-enabled (listed out of group order to keep the existing bit values stable).
 	zest_capability_nonuniform_sampled_image_indexing  = 1 << 12,
+	zest_capability_draw_indirect_count                = 1 << 13,
+	zest_capability_shader_draw_parameters             = 1 << 14,
 } zest_device_capability_bits;
 
 // Populated once during device creation and queryable thereafter via
@@ -2348,7 +2391,9 @@ typedef struct zest_device_capabilities_t {
 	zest_capability_anisotropic_filtering | \
 	zest_capability_wireframe | \
 	zest_capability_image_cube_array | \
-	zest_capability_nonuniform_sampled_image_indexing )
+	zest_capability_nonuniform_sampled_image_indexing | \
+	zest_capability_draw_indirect_count | \
+	zest_capability_shader_draw_parameters )
 #define ZEST_CAPABILITY_OPT_IN_MASK ( \
 	zest_capability_tessellation | \
 	zest_capability_geometry_shader | \
@@ -2370,6 +2415,7 @@ typedef enum {
 	zest_memory_usage_gpu_only,
 	zest_memory_usage_cpu_to_gpu,
 	zest_memory_usage_gpu_to_cpu,
+	zest_memory_usage_gpu_host_visible,	//Device local memory the CPU can write to directly (ReBAR/SAM or integrated GPUs). Check zest_DeviceHasHostVisibleDeviceMemory first
 } zest_memory_usage;
 
 typedef enum zest_camera_flag_bits {
@@ -2392,10 +2438,15 @@ typedef enum zest_compute_flag_bits {
 typedef enum zest_layer_flag_bits {
 	zest_layer_flag_none = 0,
 	zest_layer_flag_static = 1 << 0,    // Layer only uploads new buffer data when required
-	zest_layer_flag_device_local_direct = 1 << 1,    // Upload directly to device buffer (has issues so is disabled by default for now)
+	zest_layer_flag_device_local_direct = 1 << 1,    // Instances are written straight in to host visible device memory, see zest_CreateDirectFIFInstanceLayer
 	zest_layer_flag_manual_fif = 1 << 2,    // Manually set the frame in flight for the layer
 	zest_layer_flag_using_global_bindless_layout = 1 << 3,    // Flagged if the layer is automatically setting the descriptor array index for the device buffers
 	zest_layer_flag_dont_reset_instructions = 1 << 4,    // Flagged if the layer is automatically setting the descriptor array index for the device buffers
+	zest_layer_flag_delta_upload = 1 << 5,    // Only the pages of instance data that changed are uploaded, see zest_EnableInstanceLayerDeltaUploads
+	zest_layer_flag_multi_draw_indirect = 1 << 6,    // Instance mesh layer instructions are drawn from an indirect buffer, see zest_EnableLayerMultiDrawIndirect
+	zest_layer_flag_gpu_culling = 1 << 7,    // Instances are culled by a compute pass before they're drawn, see zest_EnableLayerGPUCulling
+	zest_layer_flag_instance_store = 1 << 8,    // Instances live in slots that persist between frames, see zest_EnableInstanceStore
+	zest_layer_flag_mesh_lods = 1 << 9,         // Instances can be drawn with a LOD chain, see zest_EnableLayerMeshLODs
 } zest_layer_flag_bits;
 
 typedef enum zest_draw_buffer_result {
@@ -2480,6 +2531,8 @@ typedef enum zest_frame_graph_flag_bits {
 	zest_frame_graph_present_after_execute = 1 << 3,
 	zest_frame_graph_is_cached = 1 << 4,
 	zest_frame_graph_is_command_graph = 1 << 5,		//For one off frame graphs that can be flushed immediately
+	zest_frame_graph_reused_compile = 1 << 6,			//A cached graph was reused for a new cache key instead of compiling, see zest__reuse_cached_frame_graph
+	zest_frame_graph_has_readbacks = 1 << 7,		//The graph has readback passes so it always signals a timeline, see zest_AddImageReadbackPass
 } zest_frame_graph_flag_bits;
 
 typedef zest_uint zest_frame_graph_flags;
@@ -2515,6 +2568,7 @@ typedef enum zest_resource_purpose {
 	zest_purpose_depth_stencil_attachment_read_write, // Common
 	zest_purpose_input_attachment,                    // Needs shader stage (typically fragment)
 	zest_purpose_transfer_image,
+	zest_purpose_transfer_image_write,                // Copy or blit destination
 	zest_purpose_present_src,                         // For swapchain final layout
 } zest_resource_purpose;
 
@@ -2731,6 +2785,7 @@ typedef struct zest_image_view_t zest_image_view_t;
 typedef struct zest_image_view_array_t zest_image_view_array_t;
 typedef struct zest_sampler_t zest_sampler_t;
 typedef struct zest_layer_t zest_layer_t;
+typedef struct zest_instance_writer_t zest_instance_writer_t;
 typedef struct zest_pipeline_t zest_pipeline_t;
 typedef struct zest_pipeline_template_t zest_pipeline_template_t;
 typedef struct zest_pipeline_layout_t zest_pipeline_layout_t;
@@ -2770,10 +2825,22 @@ typedef struct zest_execution_timeline_t zest_execution_timeline_t;
 typedef struct zest_swapchain_t zest_swapchain_t;
 typedef struct zest_resource_group_t zest_resource_group_t;
 typedef struct zest_rendering_info_t zest_rendering_info_t;
+typedef struct zest_shader_compile_job_t zest_shader_compile_job_t;
 typedef struct zest_mesh_t zest_mesh_t;
 typedef struct zest_mesh_offset_data_t zest_mesh_offset_data_t;
 typedef struct zest_command_list_t zest_command_list_t;
 typedef struct zest_resource_store_t zest_resource_store_t; 
+typedef struct zest_image_streamer_t zest_image_streamer_t;
+typedef struct zest_image_stream_request_t zest_image_stream_request_t;
+typedef struct zest_image_stream_batch_t zest_image_stream_batch_t;
+typedef struct zest_readback_copy_t zest_readback_copy_t;
+typedef struct zest_readback_t zest_readback_t;
+typedef struct zest_readback_pass_t zest_readback_pass_t;
+typedef struct zest_readback_ring_t zest_readback_ring_t;
+typedef struct zest_virtual_texture_t zest_virtual_texture_t;
+typedef struct zest_virtual_page_slot_t zest_virtual_page_slot_t;
+typedef struct zest_virtual_page_upload_t zest_virtual_page_upload_t;
+typedef struct zest_virtual_texture_pass_t zest_virtual_texture_pass_t;
 
 //Backends
 typedef struct zest_device_backend_t zest_device_backend_t;
@@ -2801,6 +2868,8 @@ typedef struct zest_frame_graph_semaphores_backend_t zest_frame_graph_semaphores
 typedef struct zest_execution_timeline_backend_t zest_execution_timeline_backend_t;
 typedef struct zest_execution_barriers_backend_t zest_execution_barriers_backend_t;
 typedef struct zest_set_layout_builder_backend_t zest_set_layout_builder_backend_t;
+typedef struct zest_image_streamer_backend_t zest_image_streamer_backend_t;
+typedef struct zest_readback_backend_t zest_readback_backend_t;
 
 //Generate handles for the struct types. These are all pointers to memory where the object is stored.
 ZEST__MAKE_HANDLE(zest_context)
@@ -2840,6 +2909,8 @@ ZEST__MAKE_HANDLE(zest_resource_group);
 ZEST__MAKE_HANDLE(zest_render_pass)
 ZEST__MAKE_HANDLE(zest_mesh)
 ZEST__MAKE_HANDLE(zest_command_list)
+ZEST__MAKE_HANDLE(zest_image_streamer)
+ZEST__MAKE_HANDLE(zest_virtual_texture)
 
 ZEST__MAKE_HANDLE(zest_device_backend)
 ZEST__MAKE_HANDLE(zest_context_backend)
@@ -2865,6 +2936,8 @@ ZEST__MAKE_HANDLE(zest_execution_backend)
 ZEST__MAKE_HANDLE(zest_execution_timeline_backend)
 ZEST__MAKE_HANDLE(zest_execution_barriers_backend)
 ZEST__MAKE_HANDLE(zest_set_layout_builder_backend)
+ZEST__MAKE_HANDLE(zest_image_streamer_backend)
+ZEST__MAKE_HANDLE(zest_readback_backend)
 
 ZEST__MAKE_USER_HANDLE(zest_image)
 ZEST__MAKE_USER_HANDLE(zest_image_view)
@@ -2896,6 +2969,62 @@ ZEST__MAKE_USER_HANDLE(zest_compute)
 #define ZEST_MAX_THREADS 64
 #endif
 
+//Copies of at least this size are split in to chunks across the device job system.
+#ifndef ZEST_PARALLEL_COPY_THRESHOLD
+#define ZEST_PARALLEL_COPY_THRESHOLD (4 * 1024 * 1024)
+#endif
+
+#ifndef ZEST_PARALLEL_COPY_CHUNK_SIZE
+#define ZEST_PARALLEL_COPY_CHUNK_SIZE (1024 * 1024)
+#endif
+
+//Scratch memory given to each pipeline compiled in the background for the vertex and blend state arrays
+#ifndef ZEST_PIPELINE_SCRATCH_SIZE
+#define ZEST_PIPELINE_SCRATCH_SIZE (64 * 1024)
+#endif
+
+//The default size of the pages that instance layers with delta uploads track changes in, see zest_EnableInstanceLayerDeltaUploads
+#ifndef ZEST_LAYER_DELTA_PAGE_SIZE
+#define ZEST_LAYER_DELTA_PAGE_SIZE 4096
+#endif
+
+//The number of vertices or triangles in each job when zest_CalculateMeshNormals and zest_CalculateMeshTangents split
+//a mesh across the job system. Meshes smaller than this are done on the calling thread. Must be a multiple of 4.
+#ifndef ZEST_MESH_ATTRIBUTE_BATCH
+#define ZEST_MESH_ATTRIBUTE_BATCH 1024
+#endif
+
+//The most templates zest_RequestPipeline tries, the requested one and its chain of fallbacks, see
+//zest_SetPipelineFallback
+#ifndef ZEST_MAX_PIPELINE_FALLBACK_DEPTH
+#define ZEST_MAX_PIPELINE_FALLBACK_DEPTH 8
+#endif
+
+//The most levels that a LOD chain in an instance mesh layer can have, see zest_AddLayerMeshLODChain
+#ifndef ZEST_MAX_MESH_LODS
+#define ZEST_MAX_MESH_LODS 8
+#endif
+
+//The number of upload batches an image streamer can have on the GPU at once, see zest_CreateImageStreamer
+#ifndef ZEST_STREAM_BATCHES_IN_FLIGHT
+#define ZEST_STREAM_BATCHES_IN_FLIGHT 4
+#endif
+
+//The number of standalone readbacks (zest_ReadbackImage/zest_ReadbackBuffer) that can be on the GPU at once
+#ifndef ZEST_READBACK_SUBMITS_IN_FLIGHT
+#define ZEST_READBACK_SUBMITS_IN_FLIGHT 8
+#endif
+
+//The most mip levels that zest_CreateImageWithMipChain can upload, enough for a 65536 pixel wide image
+#ifndef ZEST_MAX_IMAGE_MIP_LEVELS
+#define ZEST_MAX_IMAGE_MIP_LEVELS 17
+#endif
+
+//The most mip levels that a virtual texture can have, see zest_CreateVirtualTexture
+#ifndef ZEST_MAX_VIRTUAL_TEXTURE_MIPS
+#define ZEST_MAX_VIRTUAL_TEXTURE_MIPS 16
+#endif
+
 // Platform-specific synchronization wrapper
 typedef struct zest_sync_t {
 	#ifdef _WIN32
@@ -3070,6 +3199,22 @@ ZEST_PRIVATE inline void zest__sync_signal_full(zest_sync_t *sync) {
 	#endif
 }
 
+ZEST_PRIVATE inline void zest__sync_broadcast_empty(zest_sync_t *sync) {
+	#ifdef _WIN32
+	WakeAllConditionVariable(&sync->empty_condition);
+	#else
+	pthread_cond_broadcast(&sync->empty_condition);
+	#endif
+}
+
+ZEST_PRIVATE inline void zest__sync_broadcast_full(zest_sync_t *sync) {
+	#ifdef _WIN32
+	WakeAllConditionVariable(&sync->full_condition);
+	#else
+	pthread_cond_broadcast(&sync->full_condition);
+	#endif
+}
+
 ZEST_PRIVATE inline unsigned int zest_HardwareConcurrency(void) {
 	#ifdef _WIN32
 	SYSTEM_INFO sysinfo;
@@ -3092,6 +3237,87 @@ ZEST_API unsigned int zest_HardwareConcurrencySafe(void);
 // Usually hardware threads - 1 to leave a core for the OS/main thread
 ZEST_API unsigned int zest_GetDefaultThreadCount(void);
 
+#ifdef _WIN32
+typedef HANDLE zest_thread_handle;
+#else
+typedef pthread_t zest_thread_handle;
+#endif
+
+//A job handed to the device job system. worker_index is 0 when the job runs on a thread outside of
+//the pool (the thread waiting on it for example) and 1..thread_count when it runs on one of the pool
+//threads. All threads outside the pool share index 0, so per worker scratch indexed by it is only
+//safe if one thread at a time dispatches work that uses that scratch.
+typedef void (*zest_job_callback)(void *data, zest_uint worker_index);
+
+//Called by zest_ParallelFor for each batch of indexes in the half open range [begin, end).
+typedef void (*zest_parallel_for_callback)(void *data, zest_uint begin, zest_uint end, zest_uint worker_index);
+
+typedef struct zest_job_t {
+	zest_job_callback callback;
+	void *data;
+} zest_job_t;
+
+//Tracks the number of jobs in a dispatch that haven't finished yet. Zero initialise, pass it to
+//zest_RunJobs and then zest_WaitJobs on it. It can be reused as soon as zest_WaitJobs returns.
+typedef struct zest_job_counter_t {
+	volatile int pending;
+} zest_job_counter_t;
+
+#ifndef ZEST_JOB_DEQUE_SIZE
+#define ZEST_JOB_DEQUE_SIZE ZEST_MAX_QUEUE_ENTRIES
+#endif
+
+//The number of allocators (the device plus contexts) each job thread can cache at once when the device is
+//built with zest_DeviceBuilderThreadAllocatorCaches. Allocators beyond this just skip the cache.
+#ifndef ZEST_JOB_ALLOCATOR_CACHES
+#define ZEST_JOB_ALLOCATOR_CACHES 4
+#endif
+
+typedef struct zest_job_entry_t {
+	zest_job_callback callback;
+	void *data;
+	zest_job_counter_t *counter;
+} zest_job_entry_t;
+
+//A ring of jobs owned by one worker. The owner pushes and pops at the bottom (newest first, so nested
+//jobs run while their data is still warm) and idle workers steal from the top (oldest first). top and
+//bottom only ever increase and are guarded by the deque's own lock, so the only contention is between
+//the owner and whoever happens to be stealing from it.
+typedef struct zest_job_deque_t {
+	zest_sync_t sync;
+	zest_job_entry_t entries[ZEST_JOB_DEQUE_SIZE];
+	int top;
+	int bottom;
+} zest_job_deque_t;
+
+typedef struct zest_job_system_t zest_job_system_t;
+
+//allocator_caches are only touched by the worker's own thread. They're flushed at the end of every job so
+//no blocks are held between jobs, and their stats are added to allocator_cache_stats (under the worker's
+//deque lock) so that zest_GetAllocatorCacheStats can read them from another thread.
+typedef struct zest_job_worker_t {
+	zest_job_system_t *jobs;
+	zest_uint worker_index;
+	zloc_thread_cache_t allocator_caches[ZEST_JOB_ALLOCATOR_CACHES];
+	zloc_thread_cache_stats_t allocator_cache_stats;
+} zest_job_worker_t;
+
+//Work stealing job system owned by a device and started the first time it's needed. There is one
+//deque per pool thread plus deque 0 which is shared by every thread outside the pool. sync is only
+//used to put idle threads to sleep: pool threads wait on the full condition for jobs to be queued and
+//threads in zest_WaitJobs wait on the empty condition for either a queued job or a finished counter.
+typedef struct zest_job_system_t {
+	zest_sync_t sync;
+	zest_job_deque_t *deques;
+	zest_uint deque_count;
+	zest_thread_handle threads[ZEST_MAX_THREADS];
+	zest_job_worker_t workers[ZEST_MAX_THREADS];
+	zest_uint thread_count;
+	zest_bool allocator_caches;
+	volatile int queued;
+	volatile int shutdown;
+} zest_job_system_t;
+
 // --Private structs with inline functions
 typedef struct zest_queue_family_indices {
 	zest_uint graphics_family_index;
@@ -3399,7 +3625,7 @@ ZEST_PRIVATE zest_uint zest__map_get_index(zest_hash_pair *map, zest_key key) {
 #define zest_map_get_index_by_key(hash_map, key) zest__map_get_index(hash_map.map, key);
 #define zest_map_get_index_by_name(hash_map, name) zest__map_get_index(hash_map.map, zest_map_hash(hash_map, name));
 #define zest_map_remove(allocator, hash_map, name) { zest_key key = zest_map_hash(hash_map, name); zest_hash_pair *it = zest__lower_bound(hash_map.map, key); zest_uint index = it->index; zest_vec_erase(hash_map.map, it); zest_vec_push(allocator, hash_map.free_slots, index); }
-#define zest_map_remove_key(allocator, hash_map, name) { zest_hash_pair *it = zest__lower_bound(hash_map.map, key); zest_uint index = it->index; zest_vec_erase(hash_map.map, it); zest_vec_push(allocator, hash_map.free_slots, index); }
+#define zest_map_remove_key(allocator, hash_map, key) { zest_hash_pair *it = zest__lower_bound(hash_map.map, key); zest_uint index = it->index; zest_vec_erase(hash_map.map, it); zest_vec_push(allocator, hash_map.free_slots, index); }
 #define zest_map_last_index(hash_map) (hash_map.last_index)
 #define zest_map_size(hash_map) (hash_map.map ? zest__vec_header(hash_map.data)->current_size : 0)
 #define zest_map_clear(hash_map) zest_vec_clear(hash_map.map); zest_vec_clear(hash_map.data); zest_vec_clear(hash_map.free_slots)
@@ -3409,34 +3635,46 @@ ZEST_PRIVATE zest_uint zest__map_get_index(zest_hash_pair *map, zest_key key) {
 #define zest_map_foreach(index, hash_map) zest_vec_foreach(index, hash_map.map)
 // --End pocket hash map
 
-//Another hash map with open addressing probing. This is very simple and designed for frame graphs only but
-//but the frame graph only has to hash a few things and there's negligable difference between this and the above
-//hash map when the numbers are small so therefore this is currently unused. The above hash map uses binary 
-//search and has the advantage of not needing the data table to be larger to avoid collisions and there's not 
-//much overhead if the table runs out of space and needs to be resized. 
-
-//If the below hash map runs out of space then everything needs to be re-hashed again so it needs to be oversized 
-//to begin with. Because it's for the frame graph only there's no need to be able to remove things from the table
-//but it wouldn't be too hard to add I think.
+//Open addressing hash map for lookups that are hot or can get big, like the pipeline cache and frame graph
+//resource names. The hash map above has to binary search its sorted keys and memmove them on every insert
+//which is fine for a handful of entries but not for thousands. Here the key picks a slot and we probe
+//linearly from there. Each slot has a control byte holding 7 bits of the key so that most probes are
+//rejected without touching the keys at all. Removing an entry shifts the ones after it back into place
+//so there are no tombstones to clean up. The table doubles in size when it gets 7/8 full.
+//Values live in the table so pointers to them are only valid until the next insert or remove. To iterate,
+//loop from 0 to current_size and call zest__map_at_index. This uses a packed list of the filled slots
+//kept in insertion order, except that a remove moves the last entry into the gap.
 typedef struct zest_map_t {
-	void *table;				//Table containing all the data
-	zest_uint *filled_slots;	//A parallel table so that elements can be iterated over easily
-	zest_uint element_size;		//The size of each data element stored in the table
-	zest_uint current_size;		//The current number of used slots in the table
-	zest_uint capacity;			//The total capacity of the table
-	zest_uint collisions;		//Keep a count of all the collisions that happened
+	zloc_allocator *allocator;					//Allocator for the table, NULL if linear_allocator is used instead
+	zloc_linear_allocator_t *linear_allocator;	//For maps that only live as long as a frame graph
+	zest_key *keys;
+	void *values;
+	zest_uint *filled_slots;		//The filled slots, packed so that they can be iterated over
+	zest_uint *filled_index;		//For each filled slot, where it is in filled_slots
+	zest_byte *control;				//0 for an empty slot otherwise 0x80 | the top 7 bits of the key
+	zest_uint element_size;			//The size of each value stored in the table
+	zest_uint current_size;			//The number of entries in the table
+	zest_uint capacity;				//The number of slots in the table, always a power of 2
+	zest_uint collisions;			//Extra probes made by inserts, a measure of clustering
 } zest_map_t;
 
-void zest__initialise_map(zest_context context, zest_map_t *map, zest_uint element_size, zest_uint capacity);
-zest_bool zest__insert_key(zest_map_t *map, zest_key key, void *value);
-zest_bool zest__insert(zest_map_t *map, const char *name, void *value);
-void *zest__at_key(zest_map_t *map, zest_key key);
-void *zest__at_index(zest_map_t *map, zest_uint index);
-void *zest__at(zest_map_t *map, const char *name);
-zest_bool zest__find_key(zest_map_t *map, zest_key key, void **out_value);
-zest_bool zest__find(zest_map_t *map, const char *name, void **out_value);
-zest_bool zest__ensure_capacity(zest_map_t *map, zest_uint required_capacity);
-void zest__free_map(zest_context context, zest_map_t *map);
+ZEST_PRIVATE void zest__initialise_map(zloc_allocator *allocator, zest_map_t *map, zest_uint element_size, zest_uint capacity);
+ZEST_PRIVATE void zest__initialise_linear_map(zloc_linear_allocator_t *allocator, zest_map_t *map, zest_uint element_size, zest_uint capacity);
+ZEST_PRIVATE zest_bool zest__insert_key(zest_map_t *map, zest_key key, const void *value);
+ZEST_PRIVATE zest_bool zest__insert(zest_map_t *map, const char *name, const void *value);
+ZEST_PRIVATE void *zest__at_key(zest_map_t *map, zest_key key);
+ZEST_PRIVATE void *zest__at(zest_map_t *map, const char *name);
+//The value and key of the index'th entry where index is less than current_size
+ZEST_PRIVATE void *zest__map_at_index(zest_map_t *map, zest_uint index);
+ZEST_PRIVATE zest_key zest__map_key_at_index(zest_map_t *map, zest_uint index);
+ZEST_PRIVATE zest_bool zest__find_key(zest_map_t *map, zest_key key, void **out_value);
+ZEST_PRIVATE zest_bool zest__find(zest_map_t *map, const char *name, void **out_value);
+ZEST_PRIVATE zest_bool zest__remove_key(zest_map_t *map, zest_key key);
+ZEST_PRIVATE zest_bool zest__remove(zest_map_t *map, const char *name);
+ZEST_PRIVATE zest_bool zest__ensure_capacity(zest_map_t *map, zest_uint required_capacity);
+ZEST_PRIVATE void zest__clear_map(zest_map_t *map);
+//Free the table. The map keeps its allocator and element size so it can be used again afterwards.
+ZEST_PRIVATE void zest__free_map(zest_map_t *map);
 
 // --Begin Pocket_text_buffer
 typedef struct zest_text_t {
@@ -3842,6 +4080,112 @@ typedef struct zest_image_info_t {
 	zest_image_flags flags;
 } zest_image_info_t;
 
+//Identifies an upload queued with an image streamer. Tickets count up from 1 in the order that uploads are
+//queued and complete in the same order. 0 means the upload could not be queued.
+typedef zest_u64 zest_stream_ticket;
+
+//Use zest_CreateImageStreamerInfo to get the defaults.
+typedef struct zest_image_streamer_info_t {
+	zest_size ring_size;                //Size of the persistent staging ring that pixels are copied in to
+	zest_size frame_budget;             //The most bytes submitted by each zest_UpdateImageStreamer
+} zest_image_streamer_info_t;
+
+typedef struct zest_image_streamer_stats_t {
+	zest_uint queued_uploads;           //Uploads in the ring that haven't been submitted yet
+	zest_size queued_bytes;
+	zest_uint batches_in_flight;        //Batches submitted that the GPU hasn't finished
+	zest_uint outstanding_uploads;      //Queued and in flight uploads still holding ring space
+	zest_stream_ticket completed_ticket;//Every upload up to and including this ticket is ready to sample
+	zest_u64 total_uploads;             //Uploads submitted since the streamer was created
+	zest_u64 total_bytes;
+	zest_size last_update_bytes;        //Bytes submitted by the last zest_UpdateImageStreamer
+	zest_uint ring_full_count;          //Times an upload was refused because the ring was full
+	zest_bool ownership_transfer;       //Uploads run on a separate transfer family and are handed to graphics
+} zest_image_streamer_stats_t;
+
+//Identifies a readback. Tickets count up from 1 in the order that copies are recorded and the callbacks fire in
+//the same order. 0 means the readback could not be recorded.
+typedef zest_u64 zest_readback_ticket;
+
+//Called once the GPU has finished a readback copy. data points in to the readback ring and is only valid until
+//the callback returns, so copy out anything that you want to keep.
+typedef void (*zest_readback_callback)(const void *data, zest_size size, void *user_data);
+
+//The part of an image to read back. Texels are tightly packed in the data passed to the callback, row by row then
+//layer by layer. A width or height of 0 reads to the edge of the mip level and a layer_count of 0 reads one layer.
+typedef struct zest_image_readback_region_t {
+	zest_uint mip_level;
+	zest_uint base_layer;
+	zest_uint layer_count;
+	zest_uint x, y;                     //Offset in texels, must be a multiple of the block size for compressed formats
+	zest_uint width, height;
+} zest_image_readback_region_t;
+
+typedef struct zest_readback_stats_t {
+	zest_uint pending_readbacks;        //Recorded readbacks whose callbacks haven't fired yet
+	zest_size pending_bytes;
+	zest_readback_ticket completed_ticket;//Every readback up to and including this ticket has fired its callback
+	zest_u64 total_readbacks;           //Readbacks recorded since the context was created
+	zest_u64 total_bytes;
+	zest_uint ring_full_count;          //Times a readback was skipped because the ring was full
+	zest_size ring_size;
+} zest_readback_stats_t;
+
+//Fill in one page of a virtual texture. pixels has room for the page plus its border on every side, so it's
+//(page_size + 2 * page_border) texels square, tightly packed in the virtual texture's format. The first texel is
+//(page_x * page_size - page_border, page_y * page_size - page_border) of the mip level. Return ZEST_FALSE if the
+//page isn't ready yet and it will be loaded the next time that the feedback asks for it.
+typedef zest_bool (*zest_virtual_page_loader)(zest_virtual_texture virtual_texture, zest_uint mip_level, zest_uint page_x, zest_uint page_y, void *pixels, zest_size size, void *user_data);
+
+//Use zest_CreateVirtualTextureInfo to get the defaults.
+typedef struct zest_virtual_texture_info_t {
+	zest_uint width;                    //Size of mip level 0 in texels, the page size times a power of 2
+	zest_uint height;
+	zest_uint page_size;                //Width and height of a page in texels
+	zest_uint page_border;              //Texels repeated around each page in the cache so that filtering doesn't pick up its neighbours
+	zest_format format;
+	zest_uint cache_pages_x;            //Size of the physical page cache in pages, at most 256 each way
+	zest_uint cache_pages_y;
+	zest_uint upload_budget;            //The most pages staged for one upload pass
+	zest_virtual_page_loader load_page;
+	void *user_data;
+} zest_virtual_texture_info_t;
+
+//The frame graph resources of a virtual texture, see zest_ImportVirtualTexture
+typedef struct zest_virtual_texture_resources_t {
+	zest_resource_node page_table;
+	zest_resource_node page_cache;
+	zest_resource_node feedback;
+} zest_virtual_texture_resources_t;
+
+//Everything that a shader needs to sample a virtual texture. Pass it in your push constants or a uniform buffer.
+typedef struct zest_virtual_texture_shader_info_t {
+	zest_uint page_table_index;         //Bindless 2d texture index of the page table
+	zest_uint page_cache_index;         //Bindless 2d texture index of the page cache
+	zest_uint feedback_index;           //Bindless storage buffer index of the feedback buffer
+	zest_uint page_size;
+	zest_uint page_border;
+	zest_uint pages_x;                  //Pages across and down mip level 0
+	zest_uint pages_y;
+	zest_uint mip_count;
+	float cache_texel_width;            //1 / the size of the page cache in texels
+	float cache_texel_height;
+} zest_virtual_texture_shader_info_t;
+
+typedef struct zest_virtual_texture_stats_t {
+	zest_uint resident_pages;           //Pages in the cache including the pinned coarsest mip level
+	zest_uint cache_pages;              //Pages that the cache can hold
+	zest_uint visible_pages;            //Pages that the last feedback asked for, plus the coarser pages above them
+	zest_uint requested_pages;          //Pages that the last feedback asked for that still need loading
+	zest_uint last_update_loads;        //Pages loaded by the last zest_UpdateVirtualTexture
+	zest_u64 total_loads;
+	zest_u64 total_evictions;
+	zest_u64 feedback_count;            //Feedback readbacks processed
+	zest_uint cache_full_count;         //Times a load was put off because every page in the cache was visible
+	zest_size cache_bytes;              //Memory used by the page cache image
+	zest_size virtual_bytes;            //Memory that every mip level would use if it was all resident
+} zest_virtual_texture_stats_t;
+
 typedef struct zest_sampler_info_t {
 	zest_filter_type mag_filter;
 	zest_filter_type min_filter;
@@ -3962,6 +4306,9 @@ typedef struct zest_create_context_info_t {
 	zest_format color_format;                   		//The format to use for the swapchain
 	zest_context_init_flags flags;                      //Set flags to apply different initialisation options
 	zest_size memory_pool_size;
+	zest_size frame_graph_cache_budget;                 //Bytes that cached frame graphs can use before the least recently used are evicted, 0 for no limit
+	zest_uint max_cached_frame_graphs;                  //The number of frame graphs that can be cached before the least recently used are evicted, 0 for no limit
+	zest_size readback_ring_size;                       //Size of the host cached ring that readbacks copy in to. Only allocated once something is read back
 } zest_create_context_info_t;
 
 zest_hash_map(zest_context_queue) zest_map_queue_value;
@@ -4021,14 +4368,30 @@ typedef struct zest_report_t {
 typedef struct zest_cached_frame_graph_t {
 	void *memory;
 	zest_frame_graph frame_graph;
+	zest_size size;						//Size of the promoted block in memory
+	zest_u64 last_used;					//Cache tick when the graph was last looked up or cached, for LRU eviction
+	zest_uint last_used_frame;			//Context frame the graph was last used in, frame graphs used this frame can't be evicted
 } zest_cached_frame_graph_t;
 
+typedef struct zest_frame_graph_cache_stats_t {
+	zest_u64 hits;						//zest_GetCachedFrameGraph calls that returned a graph
+	zest_u64 misses;					//zest_GetCachedFrameGraph calls that didn't
+	zest_u64 compiles;					//Graphs that were compiled and then cached
+	zest_u64 compile_reuses;			//Graphs that reused the whole compile of a cached graph with the same structure
+	zest_u64 evictions;					//Cached graphs that were freed to stay within the budget
+	zest_u64 uncacheable;				//Graphs that outgrew their block and couldn't be cached that time
+	zest_uint cached_count;				//The number of graphs in the cache now
+	zest_size cached_bytes;				//The memory used by the graphs in the cache now
+	zest_size budget;					//See zest_SetFrameGraphCacheBudget
+	zest_uint max_graphs;
+} zest_frame_graph_cache_stats_t;
+
 zest_hash_map(zest_report_t) zest_map_reports;
 zest_hash_map(zest_buffer_allocator) zest_map_buffer_allocators;
 zest_hash_map(zest_cached_frame_graph_t) zest_map_cached_frame_graphs;
 zest_hash_map(zest_frame_graph_semaphores) zest_map_frame_graph_semaphores;
 zest_hash_map(zest_context_queue) zest_map_frame_graph_queues;
-zest_hash_map(zest_pipeline) zest_map_cached_pipelines;
+zest_hash_map(zest_uint) zest_map_shader_batch_keys;
 
 typedef struct zest_descriptor_binding_desc_t {
 	zest_uint binding;                      // The binding slot (register in HLSL, binding in GLSL, [[id(n)]] in MSL)
@@ -4290,6 +4653,47 @@ typedef struct zest_rendering_info_t {
 	zest_key render_pass_key;
 } zest_rendering_info_t;
 
+//Describes one shader for zest_CreateShaders. Set either file or shader_code.
+typedef struct zest_shader_source_t {
+	const char *name;
+	const char *file;                       //Read the source from this file, same as zest_CreateShaderFromFile
+	const char *shader_code;                //Or pass the source directly
+	zest_shader_type type;
+	zest_shader_options options;
+	zest_bool disable_caching;
+} zest_shader_source_t;
+
+typedef struct zest_shader_batch_stats_t {
+	zest_uint shader_count;
+	zest_uint compiled_count;               //Shaders that went through the compiler
+	zest_uint cache_hit_count;              //Shaders loaded from the shader cache
+	zest_uint duplicate_count;              //Shaders with the same source, type and macros as an earlier one in the batch
+	zest_uint failed_count;
+	zest_microsecs compile_time;            //Time spent in the compiler summed over every thread
+	zest_microsecs elapsed_time;            //Wall clock time for the whole batch
+} zest_shader_batch_stats_t;
+
+typedef enum zest_pipeline_status {
+	zest_pipeline_status_not_requested,		//Nothing has asked for the pipeline yet
+	zest_pipeline_status_pending,			//The pipeline is being compiled on the job system
+	zest_pipeline_status_ready,				//The pipeline is cached and zest_GetPipeline will return it straight away
+	zest_pipeline_status_failed,			//The pipeline failed to compile and the template has been marked as invalid
+} zest_pipeline_status;
+
+//A graphics pipeline being compiled on the job system. The shaders and rendering info are resolved on the
+//main thread before the job is queued so that the job only touches the pipeline and its own scratch memory.
+typedef struct zest_pipeline_request_t {
+	zest_pipeline pipeline;
+	zest_shader vert_shader;
+	zest_shader frag_shader;
+	zest_rendering_info_t rendering_info;
+	zloc_linear_allocator_t scratch;
+	void *scratch_memory;
+	volatile int state;						//zest_pipeline_status, pending until the job finishes
+} zest_pipeline_request_t;
+
+zest_hash_map(zest_pipeline_request_t*) zest_map_pipeline_requests;
+
 typedef zest_buffer(*zest_resource_buffer_provider)(zest_context context, zest_resource_node resource);
 typedef zest_image_view(*zest_resource_image_provider)(zest_context context, zest_resource_node resource);
 
@@ -4315,11 +4719,28 @@ typedef struct zest_frame_graph_cache_key_t {
 	zest_size user_state_size;
 } zest_frame_graph_cache_key_t;
 
+//CPU time in microseconds spent in each phase of the last compile and execution of a frame graph,
+//see zest_GetFrameGraphTimings. Compile phases stay as they were for a cached graph, the execution
+//phases are updated every time the graph is executed.
+typedef struct zest_frame_graph_timings_t {
+	zest_microsecs culling;				//Culling passes and resources that don't contribute to an output
+	zest_microsecs dependencies;		//Grouping passes, producers/consumers and the adjacency list
+	zest_microsecs waves;				//Execution waves, submission batches and semaphores
+	zest_microsecs transient_planning;	//Transient lifetimes, aliasing and the placement schedule
+	zest_microsecs barriers;			//Resource barrier generation
+	zest_microsecs render_passes;		//Preparing render passes and the queue layout signature
+	zest_microsecs compile;				//The whole compile. 0 if the compile stopped early with an error
+	zest_microsecs transient_placement;	//Placing transient resources in memory before recording
+	zest_microsecs recording;			//Recording and submitting the command buffers
+	zest_microsecs execute;				//The whole execution
+} zest_frame_graph_timings_t;
+
 typedef struct zest_frame_graph_builder_t {
 	zest_context context;
 	zloc_linear_allocator_t *allocator;
 	zest_frame_graph frame_graph;
 	zest_pass_node current_pass;
+	zest_bool owns_allocator;			//The allocator is a block of its own that's freed when the builder is cleaned up
 }zest_frame_graph_builder_t;
 
 typedef struct zest_descriptor_indices_t {
@@ -4420,6 +4841,7 @@ typedef struct zest_pipeline_template_t {
 	zest_pipeline_layout layout;
 
 	zest_color_blend_attachment_t color_blend_attachment;
+	zest_pipeline_template fallback;                                             //Used by zest_RequestPipeline while this pipeline compiles
 } zest_pipeline_template_t;
 
 typedef struct zest_pipeline_layout_info_t {
@@ -4484,6 +4906,16 @@ typedef struct zest_layer_buffers_t {
 	zest_size vertex_memory_in_use;
 	zest_size index_memory_in_use;
 	zest_uint descriptor_array_index;
+	//Delta uploads: a bit for each page of instance data that has changed since it was last uploaded
+	//to this device buffer. all_pages_dirty is set when the device buffer was reallocated.
+	zest_uint *dirty_pages;
+	zest_bool all_pages_dirty;
+	//Multi draw indirect: a command for each draw instruction followed by a draw count for each run of
+	//instructions that share the same state. indirect_capacity is the number of commands there's room for.
+	//Layers with GPU culling also keep a zest_layer_cull_draw_t for each instruction after the draw counts
+	//and then the zest_layer_cull_view_t that the cull shader reads.
+	zest_buffer indirect_commands;
+	zest_uint indirect_capacity;
 } zest_layer_buffers_t;
 
 typedef struct zest_layer_instruction_t {
@@ -4500,8 +4932,90 @@ typedef struct zest_layer_instruction_t {
 	zest_pipeline_template pipeline_template;   //The pipeline template to draw the instances.
 	void *asset;                                //Optional pointer to either texture, font etc
 	zest_draw_mode draw_mode;
+	zest_uint lod_level;                        //The level of the LOD chain if the instruction was made by zest_StartInstanceMeshLODDrawing
+	//With GPU culling each level of a LOD chain gets a draw and the cull shader picks which instances go in it.
+	//lod_radius is 0 for draws that aren't picked by the shader.
+	float lod_radius;
+	float lod_min;
+	float lod_max;
 } zest_layer_instruction_t ZEST_ALIGN_AFFIX(16);
 
+//Counts of what the last zest_DrawInstanceLayer or zest_DrawInstanceMeshLayer call for a layer recorded.
+//Binds that would not have changed anything are skipped and counted in elided instead.
+typedef struct zest_layer_draw_stats_t {
+	zest_uint draws;
+	zest_uint pipeline_binds;
+	zest_uint push_constant_updates;
+	zest_uint viewport_updates;
+	zest_uint scissor_updates;
+	zest_uint pipeline_lookups;                 //Times a pipeline template had to be looked up in the pipeline cache
+	zest_uint elided;                           //Pipeline, push constant, viewport and scissor binds that were skipped
+} zest_layer_draw_stats_t;
+
+#define ZEST_LAYER_DRAW_PIPELINE_SLOTS 4
+
+//The state bound so far while drawing a layer's instructions. The last few templates that were
+//resolved are kept so that alternating between pipelines doesn't look them up every time.
+typedef struct zest_layer_draw_state_t {
+	zest_pipeline_template templates[ZEST_LAYER_DRAW_PIPELINE_SLOTS];
+	zest_pipeline pipelines[ZEST_LAYER_DRAW_PIPELINE_SLOTS];
+	zest_uint next_slot;
+	zest_pipeline bound_pipeline;
+	const char *push_constant;
+	const zest_viewport_t *viewport;
+	const zest_scissor_rect_t *scissor;
+	zest_uint push_constant_size;
+} zest_layer_draw_state_t;
+
+//The view that a layer with GPU culling is culled against, see zest_SetLayerCullView
+typedef struct zest_layer_cull_view_t {
+	zest_vec4 planes[6];                        //Frustum planes, use zest_CalculateFrustumPlanes
+	zest_matrix4 hiz_view_proj;                 //Projection * view of the frame that the hi-z pyramid was built from
+	zest_vec2 hiz_size;                         //Size of the first mip of the hi-z pyramid
+	zest_uint hiz_mip_count;
+	zest_uint hiz_sampler_index;                //Bindless index of a nearest sampler to read the pyramid with
+} zest_layer_cull_view_t;
+
+//What the cull shader needs to know about each draw instruction of a layer with GPU culling
+typedef struct zest_layer_cull_draw_t {
+	zest_uint first_instance;
+	zest_uint instance_count;
+	float radius;                               //Bounding radius of the mesh, negative if it's never culled
+	zest_uint target_instance;                  //Where the visible instances are compacted to in the culled buffer
+	float lod_radius;                           //Radius for working out the screen size of LOD draws, 0 for other draws
+	float lod_min;                              //LOD draws take the instances with a screen size from lod_min up to lod_max,
+	float lod_max;                              //negative if there's no upper limit
+	zest_uint padding;
+} zest_layer_cull_draw_t;
+
+typedef struct zest_layer_cull_push_t {
+	zest_uint instances_index;
+	zest_uint culled_index;
+	zest_uint commands_index;
+	zest_uint hiz_index;
+	zest_uint hiz_sampler_index;
+	zest_uint instance_words;
+	zest_uint position_word;
+	zest_uint scale_word;
+	zest_uint draws_word;
+	zest_uint view_word;
+	zest_uint lod_word;
+} zest_layer_cull_push_t;
+
+//How the space in an instance mesh layer's vertex and index buffers is used, see zest_GetLayerMeshPoolStats
+typedef struct zest_layer_mesh_pool_stats_t {
+	zest_size vertex_capacity;
+	zest_size vertex_used;                      //Bytes up to the end of the last mesh
+	zest_size vertex_free;                      //Bytes in gaps below vertex_used that can be reused or defragmented
+	zest_uint vertex_free_ranges;
+	zest_size index_capacity;
+	zest_size index_used;
+	zest_size index_free;
+	zest_uint index_free_ranges;
+	zest_uint pending_frees;                    //Removed or moved meshes waiting for the frames in flight to finish
+	zest_uint mesh_count;
+} zest_layer_mesh_pool_stats_t;
+
 zest_hash_map(zest_render_pass) zest_map_render_passes;
 zest_hash_map(zest_sampler_handle) zest_map_samplers;
 zest_hash_map(zest_descriptor_pool) zest_map_descriptor_pool;
@@ -4516,12 +5030,30 @@ typedef struct zest_transient_memory_info_t {
 	zest_uint category;
 } zest_transient_memory_info_t;
 
+//Written at the front of the pipeline cache file. The cache data is only handed back to the driver when
+//every field matches the device it's loaded on, anything else (a driver update, a different GPU, a
+//truncated or corrupt file) and the cache starts empty and is rewritten on the next save.
+typedef struct zest_pipeline_cache_header_t {
+	zest_uint magic;
+	zest_uint version;
+	zest_uint vendor_id;
+	zest_uint device_id;
+	zest_uint driver_version;
+	zest_uint data_size;
+	zest_ull data_hash;
+	zest_byte cache_uuid[16];
+} zest_pipeline_cache_header_t;
+
 // -- Platform_callbacks_struct
 typedef struct zest_platform_t {
 	//Frame Graph Platform Commands
 	zest_bool                  (*begin_command_buffer)(const zest_command_list command_list);
 	void                       (*end_command_buffer)(const zest_command_list command_list);
 	zest_bool                  (*set_next_command_buffer)(const zest_command_list command_list, zest_context_queue queue);
+	//Parallel recording: make sure a command pool exists for each recording task and then hand out command
+	//buffers from the task's own pool so that tasks never share a pool.
+	zest_bool                  (*prepare_worker_command_pools)(zest_context context, zest_context_queue queue, zest_uint worker_count);
+	zest_bool                  (*set_worker_command_buffer)(const zest_command_list command_list, zest_context_queue queue, zest_uint worker_index);
 	void                       (*acquire_barrier)(const zest_command_list command_list, zest_execution_details_t *exe_details);
 	void                       (*release_barrier)(const zest_command_list command_list, zest_execution_details_t *exe_details);
 	void*                      (*new_execution_backend)(zloc_linear_allocator_t *allocator);
@@ -4557,6 +5089,9 @@ typedef struct zest_platform_t {
 	//Fills budget from the backend. Only called when the device enabled the memory budget query;
 	//backends that cannot report it leave budget->supported as ZEST_FALSE.
 	void                       (*get_memory_budget)(zest_device device, zest_memory_budget_t *budget);
+	//Find the heap that memory with all of property_flags comes from. Returns ZEST_FALSE if the device has
+	//no memory type with those properties.
+	zest_bool                  (*find_memory_heap)(zest_device device, zest_memory_property_flags property_flags, zest_uint *heap_index, zest_size *heap_size);
 	zest_bool                  (*map_memory)(zest_device_memory_pool memory_allocation, zest_size size, zest_size offset);
 	void 		               (*unmap_memory)(zest_device_memory_pool memory_allocation);
 	void					   (*flush_used_buffers)(zest_context context, zest_uint fif);
@@ -4564,6 +5099,9 @@ typedef struct zest_platform_t {
 	//Images
 	zest_bool 				   (*is_image_format_supported)(zest_device device, zest_format format, zest_image_flags flags);
 	zest_bool 				   (*create_image)(zest_device device, zest_context context, zest_image image, zest_uint layer_count, zest_sample_count_flags num_samples, zest_image_flags flags);
+	//Create and bind a batch of standalone images (see zest_CreateImages). On failure the images are left for
+	//zest__cleanup_image to free whatever backing they did get.
+	zest_bool 				   (*create_images)(zest_device device, zest_image *images, zest_uint count);
 	//Transient arena hooks: create an image without binding memory (reporting its requirements so
 	//the placement pass can pack it), bind it to an arena backing at an offset, and manage the
 	//backings themselves (one device memory allocation per category, plus a buffer for the buffer
@@ -4583,6 +5121,8 @@ typedef struct zest_platform_t {
 	zest_bool 				   (*generate_mipmaps)(zest_queue queue, zest_image image);
 	//Pipelines
 	zest_bool                  (*build_pipeline)(zest_pipeline pipeline, zest_command_list command_list);
+	//Called from a job system thread so it must not use the device or context allocators
+	zest_bool                  (*build_pipeline_background)(zest_pipeline pipeline, const zest_rendering_info_t *rendering_info, zest_shader vert_shader, zest_shader frag_shader, zloc_linear_allocator_t *scratch);
 	zest_bool                  (*build_pipeline_layout)(zest_device device, zest_pipeline_layout layout, zest_pipeline_layout_info_t *info);
 	zest_bool				   (*finish_compute)(zest_device device, zest_compute compute);
 	//Semaphores
@@ -4590,6 +5130,31 @@ typedef struct zest_platform_t {
 	void                       (*wait_for_fif_semaphore)(zest_context context, zest_uint fif);
 	void                       (*queue_wait_idle)(zest_context context, zest_context_queue queue);
 	zest_semaphore_status      (*wait_for_timeline)(zest_execution_timeline timeline, zest_microsecs timeout);
+	//The value that the GPU has signalled the timeline to so far, without waiting
+	zest_u64                   (*get_timeline_value)(zest_execution_timeline timeline);
+	//Image streaming
+	zest_bool                  (*create_image_streamer_backend)(zest_image_streamer streamer);
+	void                       (*cleanup_image_streamer_backend)(zest_image_streamer streamer);
+	//Record and submit a batch of uploads without waiting on them. Sets batch->timeline_value to the value the
+	//streamer timeline reaches once every image in the batch is ready to sample. Returns ZEST_FALSE if the queues
+	//are busy or the submit failed, in which case nothing was submitted.
+	zest_bool                  (*submit_image_stream_batch)(zest_image_streamer streamer, zest_image_stream_batch_t *batch, zest_image_stream_request_t *requests, zest_uint request_count);
+	//Readbacks
+	zest_bool                  (*create_readback_backend)(zest_context context);
+	void                       (*cleanup_readback_backend)(zest_context context);
+	//Record a readback copy in to a frame graph command list. The source is already in a transfer read state.
+	void                       (*cmd_readback)(const zest_command_list command_list, zest_readback_copy_t *copy);
+	//Record and submit a standalone readback on the graphics queue with the command buffer in slot and signal the
+	//context readback timeline to signal_value once the copy is done. Never waits on the GPU.
+	zest_bool                  (*submit_readback)(zest_context context, zest_readback_copy_t *copy, zest_uint slot, zest_u64 signal_value);
+	//Make GPU writes to a range of a host cached buffer visible to the CPU
+	void                       (*invalidate_buffer)(zest_buffer buffer, zest_size offset, zest_size size);
+	//Virtual textures
+	//Clear the feedback buffer and copy the pages and page table staged for frame in flight fif in to their images.
+	//The images are in the transfer read state of the pass and are left that way.
+	void                       (*cmd_update_virtual_texture)(const zest_command_list command_list, zest_virtual_texture virtual_texture, zest_virtual_texture_resources_t *resources, zest_uint fif);
+	//Make shader writes to a buffer visible to a transfer that reads it next
+	void                       (*cmd_shader_write_barrier)(const zest_command_list command_list, zest_buffer buffer);
 	//Set layouts
 	zest_bool                  (*create_set_layout)(zest_device device, zest_context context, zest_set_layout_builder_t *builder, zest_set_layout layout, zest_bool is_bindless);
 	zest_bool                  (*create_set_pool)(zest_device device, zest_context context, zest_descriptor_pool pool, zest_set_layout layout, zest_uint max_set_count, zest_bool bindless);
@@ -4607,14 +5172,24 @@ typedef struct zest_platform_t {
 	zest_bool				   (*initialise_context_queue_backend)(zest_context context, zest_context_queue context_queue);
 	zest_shader_handle		   (*get_db_overlay_vertex_shader)(zest_device device);
 	zest_shader_handle		   (*get_db_overlay_fragment_shader)(zest_device device);
+	zest_shader_handle		   (*get_layer_cull_shader)(zest_device device);
 	//Device/OS
 	void                  	   (*wait_for_idle_device)(zest_device device);
 	zest_bool 				   (*initialise_device)(zest_device device);
+	//Persistent pipeline cache: fill in the fields of the header that identify the device and driver, and
+	//copy out the current cache data. Pass NULL data to get the size.
+	void                       (*get_pipeline_cache_identity)(zest_device device, zest_pipeline_cache_header_t *header);
+	zest_size                  (*get_pipeline_cache_data)(zest_device device, void *data, zest_size size);
 	zest_bool				   (*query_device_capabilities)(zest_device device);
 	zest_bool				   (*create_window_surface)(zest_context context);
 	//Shader Compiling
 	zest_bool				   (*validate_shader)(zest_device device, const char *shader_code, zest_shader_type type, const char *name);
 	zest_bool				   (*compile_shader)(zest_shader shader, const char *code, zest_uint code_length, zest_shader_type type, const char *name, const char *entry_point, zest_shader_options options);
+	//Batch compiling: make sure there are count compilers, compile a job on a job thread with one of them
+	//(no allocator use) and then copy the result in to the shader back on the main thread.
+	zest_bool				   (*prepare_shader_compilers)(zest_device device, zest_uint count);
+	void					   (*compile_shader_job)(zest_device device, zest_shader_compile_job_t *job, zest_uint compiler_index);
+	zest_bool				   (*finish_shader_job)(zest_shader shader, zest_shader_compile_job_t *job);
 	//Create backends
 	void*                      (*new_frame_graph_semaphores_backend)(zest_context context);
 	void*                      (*new_execution_barriers_backend)(zloc_linear_allocator_t *allocator);
@@ -4696,6 +5271,7 @@ typedef struct zest_platform_t {
 	void                       (*draw_layer_instruction)(const zest_command_list command_list, zest_uint vertex_count, zest_layer_instruction_t *instruction);
 	void                       (*draw_indexed)(const zest_command_list command_list, zest_uint index_count, zest_uint instance_count, zest_uint first_index, int32_t vertex_offset, zest_uint first_instance);
 	void                       (*draw_indexed_indirect)(const zest_command_list command_list, zest_buffer buffer, zest_size offset, zest_uint draw_count, zest_uint stride);
+	void                       (*draw_indexed_indirect_count)(const zest_command_list command_list, zest_buffer buffer, zest_size offset, zest_buffer count_buffer, zest_size count_offset, zest_uint max_draw_count, zest_uint stride);
 	void                       (*draw_indirect)(const zest_command_list command_list, zest_buffer buffer, zest_size offset, zest_uint draw_count, zest_uint stride);
 	void                       (*set_depth_bias)(const zest_command_list command_list, float factor, float clamp, float slope);
 
@@ -4760,8 +5336,12 @@ ZEST_PRIVATE zest_bool zest__create_folder(zest_device device, const char *path)
 //Buffer_and_Memory_Management
 ZEST_PRIVATE void zest__add_host_memory_pool(zest_device device, zest_size size);
 ZEST_PRIVATE void zest__add_context_memory_pool(zest_context context, zest_size size);
+ZEST_PRIVATE volatile zloc_thread_access *zest__pool_growth_access(zloc_allocator *allocator);
+ZEST_PRIVATE void zest__lock_pool_growth(zloc_allocator *allocator);
+ZEST_PRIVATE void zest__unlock_pool_growth(zloc_allocator *allocator);
 ZEST_PRIVATE void zest__add_memory_pool(zloc_allocator *allocator, zest_size requested_size);
 ZEST_PRIVATE void *zest__allocate(zloc_allocator *allocator, zest_size size);
+ZEST_PRIVATE void zest__free(zloc_allocator *allocator, void *memory);
 ZEST_PRIVATE void *zest__allocate_aligned(zloc_allocator *allocator, zest_size size, zest_size alignment);
 ZEST_PRIVATE void *zest__reallocate(zloc_allocator *allocator, void *memory, zest_size size);
 ZEST_PRIVATE void *zest__linear_allocate(zloc_linear_allocator_t *allocator, zest_size size);
@@ -4772,6 +5352,8 @@ ZEST_PRIVATE zest_buffer_allocator zest__create_buffer_allocator(zest_device dev
 ZEST_PRIVATE void zest__destroy_buffer_allocator(zest_buffer_allocator buffer_allocator);
 ZEST_PRIVATE zest_bool zest__add_gpu_memory_pool(zest_buffer_allocator allocator, zest_size minimum_size, zest_device_memory_pool *memory_pool);
 ZEST_PRIVATE zest_device_memory zest__create_device_memory(zest_device device, zest_size size, zest_buffer_info_t *buffer_info, zest_uint backend_memory_bits);
+ZEST_PRIVATE zest_buffer_allocator zest__get_buffer_allocator(zest_device device, zest_size size, zest_buffer_info_t *buffer_info);
+ZEST_PRIVATE zest_bool zest__allocate_image_buffers(zest_device device, zest_buffer_info_t *buffer_info, const zest_size *sizes, zest_uint count, zest_buffer *buffers);
 ZEST_PRIVATE void zest__add_remote_range_pool(zest_buffer_allocator buffer_allocator, zest_device_memory_pool buffer_pool);
 ZEST_PRIVATE zest_bool zest__reallocate_buffer(zest_buffer *buffer, zest_size new_size);
 ZEST_PRIVATE void zest__cleanup_buffers_in_allocators(zest_device device);
@@ -4784,6 +5366,39 @@ ZEST_PRIVATE void zest__release_queue(zest_queue queue);
 ZEST_PRIVATE zest_bool zest__initialise_timeline(zest_device device, zest_execution_timeline_t *timeline);
 //End Queue_management
 
+//Image_streaming
+ZEST_PRIVATE zest_queue_manager zest__find_stream_transfer_manager(zest_device device);
+ZEST_PRIVATE zest_bool zest__ring_allocate(zest_size ring_size, zest_size *head, zest_size *tail, zest_size size, zest_size alignment, zest_size *offset);
+ZEST_PRIVATE zest_bool zest__stream_ring_allocate(zest_image_streamer streamer, zest_size size, zest_size alignment, zest_size *offset);
+ZEST_PRIVATE void zest__retire_image_stream_batches(zest_image_streamer streamer);
+ZEST_PRIVATE zest_uint zest__submit_image_stream_batch(zest_image_streamer streamer, zest_size budget);
+ZEST_PRIVATE zest_size zest__image_stream_size(zest_image_info_t *info, zest_size *bytes_per_block);
+ZEST_PRIVATE void zest__free_image_streamer(zest_image_streamer streamer);
+//End Image_streaming
+
+//Readbacks
+ZEST_PRIVATE zest_bool zest__prepare_readback_ring(zest_context context);
+ZEST_PRIVATE zest_readback_t *zest__push_readback(zest_context context, zest_size size, zest_size alignment, zest_readback_callback callback, void *user_data);
+ZEST_PRIVATE zest_size zest__image_readback_size(zest_image_info_t *info, zest_image_readback_region_t *region, zest_size *bytes_per_block);
+ZEST_PRIVATE zest_readback_ticket zest__submit_readback(zest_context context, zest_readback_copy_t *copy, zest_size alignment, zest_readback_callback callback, void *user_data);
+ZEST_PRIVATE void zest__readback_pass_task(const zest_command_list command_list, void *user_data);
+ZEST_PRIVATE void zest__stamp_submitted_readbacks(zest_context context, zest_execution_timeline timeline);
+ZEST_PRIVATE void zest__discard_unsubmitted_readbacks(zest_context context);
+ZEST_PRIVATE void zest__cleanup_readbacks(zest_context context);
+//End Readbacks
+
+//Virtual_textures
+ZEST_PRIVATE void zest__virtual_page_coords(zest_virtual_texture virtual_texture, zest_uint page, zest_uint *mip_level, zest_uint *page_x, zest_uint *page_y);
+ZEST_PRIVATE void zest__unlink_virtual_page_slot(zest_virtual_texture virtual_texture, zest_uint slot);
+ZEST_PRIVATE void zest__touch_virtual_page_slot(zest_virtual_texture virtual_texture, zest_uint slot);
+ZEST_PRIVATE zest_uint zest__acquire_virtual_page_slot(zest_virtual_texture virtual_texture);
+ZEST_PRIVATE void zest__rebuild_virtual_page_table(zest_virtual_texture virtual_texture);
+ZEST_PRIVATE void zest__virtual_texture_feedback(const void *data, zest_size size, void *user_data);
+ZEST_PRIVATE void zest__virtual_texture_upload_task(const zest_command_list command_list, void *user_data);
+ZEST_PRIVATE void zest__virtual_texture_feedback_task(const zest_command_list command_list, void *user_data);
+ZEST_PRIVATE void zest__free_virtual_texture(zest_virtual_texture virtual_texture);
+//End Virtual_textures
+
 //Context_functions
 ZEST_PRIVATE zest_bool zest__initialise_context(zest_context context, zest_create_context_info_t *create_info);
 ZEST_PRIVATE zest_context_queue zest__create_context_queue(zest_context context, zest_uint family_index);
@@ -4827,10 +5442,28 @@ ZEST_PRIVATE void zest__start_instance_instructions(zest_layer layer);
 ZEST_PRIVATE void zest__end_instance_instructions(zest_layer layer);
 ZEST_PRIVATE void zest__reset_instance_layer_drawing(zest_layer layer);
 ZEST_PRIVATE void zest__set_layer_push_constants(zest_layer layer, void *push_constants, zest_size size);
+ZEST_PRIVATE void zest__update_layer_buffer_descriptor(zest_layer layer, zest_uint fif);
+ZEST_PRIVATE void zest__mark_layer_pages_dirty(zest_layer layer, zest_size offset, zest_size size);
+ZEST_PRIVATE zest_bool zest__next_dirty_layer_range(zest_layer_buffers_t *buffers, zest_size page_size, zest_size limit, zest_size *page, zest_size *offset, zest_size *size);
+ZEST_PRIVATE zest_size zest__add_dirty_layer_copies(zest_context context, zest_layer layer, zest_buffer_uploader_t *uploader, zest_buffer staging_buffer, zest_buffer device_buffer, zest_size memory_in_use);
+ZEST_PRIVATE void zest__carry_over_instance_layer(zest_layer layer, zest_uint from_fif, zest_uint to_fif);
+ZEST_PRIVATE zest_uint zest__store_instance_slot(zest_layer layer, zest_instance_id id);
+ZEST_PRIVATE void zest__sync_instance_store(zest_layer layer);
+ZEST_PRIVATE zest_bool zest__reserve_direct_layer_memory(zest_device device, zest_size size);
+ZEST_PRIVATE void zest__create_fif_instance_device_buffers(zest_layer layer);
+ZEST_PRIVATE zest_bool zest__create_direct_instance_buffers(zest_layer layer);
+ZEST_PRIVATE zest_bool zest__grow_direct_instance_buffer(zest_layer layer, zest_uint fif, zest_size new_size);
+ZEST_PRIVATE void zest__demote_direct_instance_layer(zest_layer layer);
+ZEST_PRIVATE void zest__begin_layer_draw_state(zest_layer layer, zest_layer_draw_state_t *state);
+ZEST_PRIVATE zest_pipeline zest__bind_layer_draw_pipeline(zest_command_list command_list, zest_layer layer, zest_layer_draw_state_t *state, zest_pipeline_template pipeline_template);
+ZEST_PRIVATE void zest__set_layer_draw_viewport(zest_command_list command_list, zest_layer layer, zest_layer_draw_state_t *state, const zest_viewport_t *viewport, const zest_scissor_rect_t *scissor);
+ZEST_PRIVATE void zest__send_layer_draw_push_constants(zest_command_list command_list, zest_layer layer, zest_layer_draw_state_t *state, const char *push_constant);
 
 // --Image_internal_functions
 ZEST_PRIVATE zest_image_handle zest__new_image(zest_device device);
 ZEST_PRIVATE zest_image_handle zest__create_image(zest_device device, zest_image_info_t *create_info);
+ZEST_PRIVATE zest_bool zest__validate_image_info(zest_device device, zest_image_info_t *create_info);
+ZEST_PRIVATE void zest__set_image_info(zest_image image, zest_image_info_t *create_info);
 ZEST_PRIVATE void zest__release_all_global_texture_indexes(zest_device device, zest_image image);
 ZEST_PRIVATE void zest__release_all_image_indexes(zest_device device);
 ZEST_PRIVATE void zest__cleanup_image_view(zest_image_view layout);
@@ -4840,9 +5473,17 @@ ZEST_PRIVATE zest_image zest__get_image_unsafe(zest_image_handle handle);
 // --General_layer_internal_functions
 ZEST_PRIVATE zest_layer_handle zest__create_instance_layer(zest_context context, const char *name, zest_size instance_type_size, zest_uint initial_instance_count);
 ZEST_PRIVATE void zest__draw_instance_mesh_layer(zest_command_list command_list, zest_layer layer, zest_pipeline_template pipeline_template);
+ZEST_PRIVATE void zest__draw_instance_mesh_layer_indirect(zest_command_list command_list, zest_layer layer, zest_layer_draw_state_t *state, zest_pipeline_template pipeline_template);
+ZEST_PRIVATE zest_bool zest__reserve_layer_indirect_commands(zest_layer layer, zest_uint count);
+ZEST_PRIVATE void zest__write_layer_indirect_command(zest_layer layer, zest_uint index);
+ZEST_PRIVATE zest_bool zest__layer_cull_is_active(zest_layer layer, zest_frame_graph frame_graph);
+ZEST_PRIVATE void zest__layer_cull_task(const zest_command_list command_list, void *user_data);
+ZEST_PRIVATE void zest__end_lod_instructions(zest_layer layer);
 
 // --Mesh_layer_internal_functions
 ZEST_PRIVATE void zest__initialise_mesh_layer(zest_context context, zest_layer mesh_layer, zest_size vertex_struct_size, zest_size initial_vertex_capacity);
+ZEST_PRIVATE void zest__complete_mesh_moves(zest_layer layer);
+ZEST_PRIVATE void zest__layer_mesh_defragment_task(const zest_command_list command_list, void *user_data);
 
 // --Misc_Helper_Functions
 ZEST_PRIVATE zest_image_view_type zest__get_image_view_type(zest_image image);
@@ -4860,6 +5501,13 @@ ZEST_PRIVATE zloc_linear_allocator_t *zest__get_scratch_arena(zest_device device
 // --Pipeline_Helper_Functions
 ZEST_PRIVATE zest_pipeline zest__create_pipeline(zest_context context);
 ZEST_PRIVATE zest_bool zest__cache_pipeline(zest_pipeline_template pipeline_template, zest_command_list context, zest_key key, zest_pipeline *out_pipeline);
+ZEST_PRIVATE zest_key zest__pipeline_cache_key(zest_device device, zest_pipeline_template pipeline_template, const zest_rendering_info_t *rendering_info);
+ZEST_PRIVATE zest_bool zest__queue_pipeline_request(zest_context context, zest_pipeline_template pipeline_template, const zest_rendering_info_t *rendering_info, zest_key key);
+ZEST_PRIVATE void zest__build_pipeline_task(void *data, zest_uint worker_index);
+ZEST_PRIVATE void zest__collect_pipeline_requests(zest_context context);
+ZEST_PRIVATE void zest__drain_pipeline_requests(zest_context context);
+ZEST_PRIVATE zest_pipeline zest__request_pipeline(zest_pipeline_template pipeline_template, const zest_command_list command_list);
+ZEST_PRIVATE void zest__drain_device_pipeline_requests(zest_device device);
 ZEST_PRIVATE void zest__cleanup_pipeline_template(zest_pipeline_template pipeline);
 ZEST_PRIVATE void zest__cleanup_pipeline_layout(zest_pipeline_layout layout);
 // --End Pipeline Helper Functions
@@ -4891,8 +5539,24 @@ ZEST_PRIVATE zest_key zest__shader_cache_key(const char *shader_code, zest_shade
 //Build "<cached_shaders_path><name>.<key>" into out. Pass a key of 0 for shaders with no source to hash.
 ZEST_PRIVATE void zest__build_shader_cache_path(zest_device device, zest_text_t *out, const char *name, zest_key key);
 ZEST_API void zest__cache_shader(zest_device device, zest_shader shader);
+ZEST_PRIVATE void zest__compile_shader_batch_task(void *data, zest_uint worker_index);
+ZEST_PRIVATE zest_bool zest__load_cached_shader(zest_device device, zest_shader shader);
 // --End Shader functions
 
+// --Pipeline_cache_functions
+#define ZEST__PIPELINE_CACHE_MAGIC 0x4F53505A	//"ZPSO"
+//Bump when the layout of zest_pipeline_cache_header_t changes so older files are ignored.
+#define ZEST__PIPELINE_CACHE_VERSION 1
+#ifndef ZEST_PIPELINE_CACHE_FILE_NAME
+#define ZEST_PIPELINE_CACHE_FILE_NAME "pipeline_cache.bin"
+#endif
+//Build "<cached_shaders_path><ZEST_PIPELINE_CACHE_FILE_NAME>" into out.
+ZEST_PRIVATE void zest__build_pipeline_cache_path(zest_device device, zest_text_t *out);
+//Read and validate the pipeline cache file for this device. Returns the cache data without the header or
+//NULL if there's no file or it doesn't belong to this device and driver. Free with zest_vec_free.
+ZEST_PRIVATE zest_file zest__load_pipeline_cache(zest_device device);
+// --End Pipeline_cache_functions
+
 // --Descriptor_set_functions
 ZEST_PRIVATE zest_set_layout zest__new_descriptor_set_layout(zest_device device, zest_context context, const char *name);
 ZEST_PRIVATE zest_descriptor_pool zest__create_descriptor_pool(zest_device device, zloc_allocator *allocator, zest_uint max_sets);
@@ -4930,6 +5594,26 @@ ZEST_PRIVATE void zest__free_device_buffer_allocators(zest_device device);
 ZEST_PRIVATE void zest__free_context_buffer_allocators(zest_context context);
 //-- end of internal functions
 
+// --Job_system_functions
+//Returns the device job system, starting the threads on first use. Returns NULL if the device was
+//created with a thread count of 0 or the threads could not be started.
+ZEST_PRIVATE zest_job_system_t *zest__get_job_system(zest_device device);
+ZEST_PRIVATE void zest__destroy_job_system(zest_device device);
+ZEST_PRIVATE zest_bool zest__push_job(zest_job_system_t *jobs, zest_uint worker_index, zest_job_entry_t *entry);
+ZEST_PRIVATE zest_bool zest__pop_job(zest_job_deque_t *deque, zest_job_entry_t *entry);
+ZEST_PRIVATE zest_bool zest__steal_job(zest_job_deque_t *deque, zest_job_entry_t *entry);
+//Run one job from the worker's own deque or, failing that, one stolen from another worker.
+ZEST_PRIVATE zest_bool zest__run_next_job(zest_job_system_t *jobs, zest_uint worker_index);
+ZEST_PRIVATE void zest__execute_job(zest_job_system_t *jobs, zest_job_entry_t *entry, zest_uint worker_index);
+ZEST_PRIVATE zest_uint zest__job_worker_index(zest_job_system_t *jobs);
+//The calling thread's cache for allocator if it's a job thread with allocator caches, otherwise NULL.
+ZEST_PRIVATE zloc_thread_cache_t *zest__get_thread_cache(zloc_allocator *allocator);
+ZEST_PRIVATE void zest__flush_thread_caches(zest_job_worker_t *worker);
+ZEST_PRIVATE void zest__add_thread_cache_stats(zloc_thread_cache_stats_t *total, const zloc_thread_cache_stats_t *stats);
+//memcpy that splits large copies (eg. in to staging buffers) across the job system.
+ZEST_PRIVATE void zest__parallel_copy(zest_device device, void *dst, const void *src, zest_size size);
+// --End Job_system_functions
+
 // Enum_to_string_functions - Helper functions to convert enums to strings 
 ZEST_PRIVATE const char *zest__image_layout_to_string(zest_image_layout layout);
 ZEST_PRIVATE const char *zest__memory_property_to_string(zest_memory_property_flags property_flags);
@@ -4958,9 +5642,19 @@ ZEST_PRIVATE void zest__add_pass_buffer_usage(zest_pass_node pass_node, zest_res
 ZEST_PRIVATE void zest__add_pass_image_usage(zest_pass_node pass_node, zest_resource_node image_resource, zest_resource_purpose purpose, zest_pipeline_stage_flags relevant_pipeline_stages, zest_bool is_output, zest_load_op load_op, zest_store_op store_op, zest_load_op stencil_load_op, zest_store_op stencil_store_op, zest_clear_value_t clear_value);
 ZEST_PRIVATE zest_frame_graph zest__new_frame_graph(zest_context context, const char *name, zest_bool is_command_graph);
 ZEST_PRIVATE zest_frame_graph zest__compile_frame_graph();
+ZEST_PRIVATE zest_microsecs zest__lap_microsecs(zest_microsecs *lap_start);
 ZEST_PRIVATE void zest__prepare_render_pass(zest_pass_group_t *pass, zest_execution_details_t *exe_details, zest_uint current_pass_index);
 ZEST_PRIVATE void zest__cleanup_frame_graph_builder();
 ZEST_PRIVATE zest_bool zest__execute_frame_graph(zest_context context, zest_frame_graph frame_graph);
+ZEST_PRIVATE void zest__bind_frame_graph_descriptor_sets(zest_frame_graph frame_graph, zest_command_list command_list, zest_submission_batch_t *batch, zest_bool using_legacy_render_pass);
+ZEST_PRIVATE zest_bool zest__reserve_pass_group_gpu_profile(zest_context context, zest_submission_batch_t *batch, zest_pass_group_t *grouped_pass, zest_uint *query_index);
+ZEST_PRIVATE void zest__record_pass_group(zest_context context, zest_frame_graph frame_graph, zest_command_list command_list, zest_pass_group_t *grouped_pass, zest_bool gpu_profile_active, zest_uint gpu_profile_query_index, zest_bool using_legacy_render_pass);
+ZEST_PRIVATE zest_uint zest__partition_batch_pass_groups(zest_frame_graph frame_graph, zest_submission_batch_t *batch, zest_uint group_count, zloc_linear_allocator_t *allocator, zest_uint **task_of_group);
+ZEST_PRIVATE void zest__record_pass_group_task(void *data, zest_uint worker_index);
+//Lock recording_sync if pass groups are currently being recorded in parallel. Returns whether it was locked.
+ZEST_PRIVATE zest_bool zest__lock_recording(zest_context context);
+ZEST_PRIVATE void zest__unlock_recording(zest_context context, zest_bool locked);
+ZEST_PRIVATE zest_bool zest__record_batch_in_parallel(zest_context context, zest_frame_graph frame_graph, zest_submission_batch_t *batch, zest_uint group_count, zest_uint task_count, zest_uint *task_of_group);
 ZEST_PRIVATE void zest__add_image_barriers(zest_frame_graph frame_graph, zloc_linear_allocator_t *allocator, zest_resource_node resource, zest_execution_barriers_t *barriers,
 										zest_resource_state_t *current_state, zest_resource_state_t *prev_state, zest_resource_state_t *next_state);
 ZEST_PRIVATE zest_resource_usage_t zest__configure_image_usage(zest_resource_node resource, zest_resource_purpose purpose, zest_format format, zest_load_op load_op, zest_load_op stencil_load_op, zest_pipeline_stage_flags relevant_pipeline_stages);
@@ -4968,7 +5662,13 @@ ZEST_PRIVATE zest_image_usage_flags zest__get_image_usage_from_state(zest_resour
 ZEST_PRIVATE zest_submission_batch_t *zest__get_submission_batch(zest_uint submission_id);
 ZEST_PRIVATE void zest__set_rg_error_status(zest_frame_graph frame_graph, zest_frame_graph_result result);
 ZEST_PRIVATE void zest__cache_frame_graph(zest_frame_graph frame_graph);
+ZEST_PRIVATE void zest__free_cached_frame_graph(zest_context context, zest_cached_frame_graph_t *cached_graph);
+ZEST_PRIVATE void zest__touch_cached_frame_graph(zest_context context, zest_cached_frame_graph_t *cached_graph);
+ZEST_PRIVATE void zest__evict_cached_frame_graphs(zest_context context, zest_key keep_key);
 ZEST_PRIVATE zest_key zest__hash_frame_graph_cache_key(zest_frame_graph_cache_key_t *cache_key);
+ZEST_PRIVATE zest_key zest__hash_frame_graph_structure(zest_frame_graph frame_graph);
+ZEST_PRIVATE zest_frame_graph zest__find_cached_frame_graph_with_structure(zest_context context, zest_frame_graph frame_graph);
+ZEST_PRIVATE void zest__reuse_cached_frame_graph(zest_context context, zest_frame_graph cached_graph, zest_frame_graph frame_graph);
 ZEST_PRIVATE zest_bool zest__using_legacy_render_pass(zest_device device);
 // --- End Internal_render_graph_functions ---
 
@@ -5030,6 +5730,19 @@ ZEST_API void zest_SetDeviceBuilderCacheShaderPath(zest_device_builder builder,
 //definitions, so an edited shader always compiles rather than reusing the previous binary. Editing shaders
 //leaves the superseded files behind; the cache folder is safe to delete at any time.
 ZEST_API void zest_DeviceBuilderCacheShaders(zest_device_builder builder);
+//Persist the backend pipeline cache to disk so pipelines built in earlier runs don't have to be compiled
+//from scratch again. Off by default. The cache is loaded when the device is created, saved when it's
+//destroyed (or whenever you call zest_SavePipelineCache) and lives in the shader cache folder (see
+//zest_SetDeviceBuilderCacheShaderPath). A cache saved by a different GPU or driver version is ignored.
+ZEST_API void zest_DeviceBuilderCachePipelines(zest_device_builder builder);
+//Give every job system thread its own small block cache in front of the device and context allocators so
+//that jobs which allocate a lot (eg. parallel recording) don't all queue on the one allocator lock. Blocks
+//up to 1KB are taken from and returned to the allocator in batches and the caches are flushed at the end
+//of each job. Off by default. See zest_GetAllocatorCacheStats.
+ZEST_API void zest_DeviceBuilderThreadAllocatorCaches(zest_device_builder builder);
+//Set the number of threads in the device job system. The default is zest_GetDefaultThreadCount (hardware
+//threads - 1). Pass 0 to run all jobs on the calling thread.
+ZEST_API void zest_SetDeviceBuilderThreadCount(zest_device_builder builder, zest_uint thread_count);
 //Request an optional device feature. If the chosen GPU supports it, Zest will enable it and
 //zest_DeviceFeatureEnabled will return true. If it isn't supported the request is ignored (logged),
 //device creation still succeeds, and you should branch on zest_DeviceFeatureEnabled at runtime.
@@ -5139,6 +5852,11 @@ ZEST_API zest_shader_handle zest_CreateShader(zest_device device, const char *sh
 //Creates a shader from a file containing shader source code. The source language is defined by the device's
 //backend (GLSL for the Vulkan backend).
 ZEST_API zest_shader_handle zest_CreateShaderFromFile(zest_device device, const char *file, const char *name, zest_shader_type type, zest_shader_options options, zest_bool disable_caching);
+//Create a batch of shaders at once, eg. at startup. Shaders found in the shader cache are loaded from it, shaders
+//with the same source, type and macros are only compiled once and the rest are compiled in parallel on the device
+//job system with a compiler per job. out_handles receives a handle for each source, or a zero handle if that
+//shader failed to compile (the error is in the log). stats can be NULL. Returns ZEST_FALSE if any shader failed.
+ZEST_API zest_bool zest_CreateShaders(zest_device device, const zest_shader_source_t *sources, zest_uint count, zest_shader_handle *out_handles, zest_shader_batch_stats_t *stats);
 //Get a shader pointer that you can use to pass in to functions. Curently there's no real use for this so may
 //remove in the future.
 ZEST_API zest_shader zest_GetShader(zest_shader_handle shader_handle);
@@ -5252,6 +5970,32 @@ ZEST_API zest_color_blend_attachment_t zest_PreMultiplyBlendStateForSwap(void);
 ZEST_API zest_color_blend_attachment_t zest_MaxAlphaBlendState(void);
 ZEST_API zest_color_blend_attachment_t zest_ImGuiBlendState(void);
 ZEST_API zest_pipeline zest_GetPipeline(zest_pipeline_template pipeline_template, const zest_command_list command_list);
+//-- Background pipeline compilation
+//Pipelines are otherwise compiled the first time zest_GetPipeline is called with a template and set of attachment
+//formats, which stalls that frame. These functions compile them on the device job system instead. They need dynamic
+//rendering; with legacy render passes zest_PrecompilePipeline returns ZEST_FALSE and zest_RequestPipeline behaves
+//like zest_GetPipeline.
+//Queue a pipeline to be compiled in the background for the attachment formats in rendering_info (see
+//zest_CreateRenderingInfo). Call it at load time for the pipelines you know you'll need.
+ZEST_API zest_bool zest_PrecompilePipeline(zest_context context, zest_pipeline_template pipeline_template, const zest_rendering_info_t *rendering_info);
+//Non blocking version of zest_GetPipeline for use in pass callbacks. Returns the pipeline if it's ready, otherwise
+//queues it for compilation if it isn't already and returns the fallback pipeline (or NULL if there isn't one) so
+//you can draw with that or skip the draw this frame.
+ZEST_API zest_pipeline zest_RequestPipeline(zest_pipeline_template pipeline_template, const zest_command_list command_list);
+//Set the template that zest_RequestPipeline uses while pipeline_template is compiling or if it failed to compile.
+//The fallback must be compatible with the pass, usually a cheaper or already compiled version of the same shader.
+//Fallbacks can have their own fallbacks, up to ZEST_MAX_PIPELINE_FALLBACK_DEPTH, but a fallback that leads back to
+//pipeline_template is rejected.
+ZEST_API void zest_SetPipelineFallback(zest_pipeline_template pipeline_template, zest_pipeline_template fallback);
+ZEST_API zest_pipeline_status zest_GetPipelineStatus(zest_context context, zest_pipeline_template pipeline_template, const zest_rendering_info_t *rendering_info);
+//The number of pipelines that are still compiling in the background
+ZEST_API zest_uint zest_GetPendingPipelineCount(zest_context context);
+//Block until every pipeline queued for compilation has finished, eg. at the end of a loading screen. Don't call
+//it from inside a pass callback.
+ZEST_API void zest_WaitForPipelines(zest_context context);
+//Rendering info for a pass with a single color attachment and an optional depth attachment (pass
+//zest_format_undefined for either to leave it out), to pass to zest_PrecompilePipeline.
+ZEST_API zest_rendering_info_t zest_CreateRenderingInfo(zest_format color_format, zest_format depth_format);
 //Copy the zest_pipeline_template_create_info_t from an existing pipeline. This can be useful if you want to create a new pipeline based
 //on an existing pipeline with just a few tweaks like setting a different shader to use.
 ZEST_API zest_pipeline_template zest_CopyPipelineTemplate(const char *name, zest_pipeline_template pipeline_template);
@@ -5345,6 +6089,8 @@ ZEST_API void zest_FreeBufferNow(zest_buffer buffer);
 //how many buffers you need to upload data for and then call zest_cmd_UploadBuffer passing the zest_buffer_uploader_t to copy all the buffers in
 //one go. For examples see the builtin draw layers that do this like: zest__update_instance_layer_buffers_callback
 ZEST_API void zest_AddCopyCommand(zest_context context, zest_buffer_uploader_t *uploader, zest_buffer source_buffer, zest_buffer target_buffer, zest_size size);
+//Same as zest_AddCopyCommand but copies a region starting at an offset in to each buffer
+ZEST_API void zest_AddCopyCommandRegion(zest_context context, zest_buffer_uploader_t *uploader, zest_buffer source_buffer, zest_buffer target_buffer, zest_size src_offset, zest_size dst_offset, zest_size size);
 //For host visible buffers, you can use this to get a pointer to the mapped memory range
 
 //Get the default pool size that is set for a specific pool hash.
@@ -5395,12 +6141,19 @@ ZEST_API void zest_SetStagingBufferPoolSize(zest_device device, zest_size minimu
 //Helper functions for creating the builtin layers. these can be called separately outside of a command queue setup context
 ZEST_API zest_layer_handle zest_CreateMeshLayer(zest_context context, const char *name, zest_size vertex_type_size);
 ZEST_API zest_layer_handle zest_CreateInstanceMeshLayer(zest_context context, const char *name, zest_size instance_struct_size, zest_size vertex_capacity, zest_size index_capacity);
+//Same as zest_CreateInstanceMeshLayer but with a device buffer for each frame in flight like zest_CreateFIFInstanceLayer,
+//so the instances can persist with delta uploads or an instance store.
+ZEST_API zest_layer_handle zest_CreateFIFInstanceMeshLayer(zest_context context, const char *name, zest_size instance_struct_size, zest_size vertex_capacity, zest_size index_capacity);
 
 // --- Dynamic resource callbacks ---
 ZEST_PRIVATE zest_image_view zest__swapchain_resource_provider(zest_context context, zest_resource_node resource);
 ZEST_PRIVATE zest_buffer zest__instance_layer_resource_provider(zest_context context, zest_resource_node resource);
 ZEST_PRIVATE zest_buffer zest__instance_layer_resource_provider_prev_fif(zest_context context, zest_resource_node resource);
 ZEST_PRIVATE zest_buffer zest__instance_layer_resource_provider_current_fif(zest_context context, zest_resource_node resource);
+ZEST_PRIVATE zest_buffer zest__layer_culled_instances_provider(zest_context context, zest_resource_node resource);
+ZEST_PRIVATE zest_buffer zest__layer_cull_commands_provider(zest_context context, zest_resource_node resource);
+ZEST_PRIVATE zest_buffer zest__layer_mesh_vertices_provider(zest_context context, zest_resource_node resource);
+ZEST_PRIVATE zest_buffer zest__layer_mesh_indexes_provider(zest_context context, zest_resource_node resource);
 
 // --- Frame_graph_api
 // -- Creating and Executing the render graph
@@ -5412,6 +6165,8 @@ ZEST_PRIVATE zest_buffer zest__instance_layer_resource_provider_current_fif(zest
 ZEST_API zest_bool zest_BeginFrameGraph(zest_context context, const char *name, zest_frame_graph_cache_key_t *cache_key);
 ZEST_API zest_bool zest_BeginCommandGraph(zest_context context, const char *name, zest_frame_graph_cache_key_t *cache_key);
 ZEST_API zest_frame_graph_cache_key_t zest_InitialiseCacheKey(zest_context context, const void *user_state, zest_size user_state_size);
+//Compile the graph, or on a cache miss reuse a cached compile with the same structure when only sizes, callbacks
+//and the like differ. Any structural change is a full compile, there's no partial recompile.
 ZEST_API zest_frame_graph zest_EndFrameGraph(void);
 ZEST_API zest_semaphore_status zest_FlushFrameGraph(zest_frame_graph frame_graph);
 //Flush a command graph and wait for its GPU work to complete before returning. If the graph has no
@@ -5476,6 +6231,17 @@ ZEST_API void zest_SetResourceImageProvider(zest_resource_node resource_node, ze
 ZEST_API void zest_SetResourceClearColor(zest_resource_node resource, float red, float green, float blue, float alpha);
 ZEST_API zest_frame_graph zest_GetCachedFrameGraph(zest_context context, zest_frame_graph_cache_key_t *cache_key);
 ZEST_API void zest_FlushCachedFrameGraphs(zest_context context);
+//Set how much memory and how many graphs the frame graph cache can hold before the least recently used
+//graphs are evicted. Pass 0 for either for no limit.
+ZEST_API void zest_SetFrameGraphCacheBudget(zest_context context, zest_size budget, zest_uint max_graphs);
+ZEST_API zest_frame_graph_cache_stats_t zest_GetFrameGraphCacheStats(zest_context context);
+//Record the pass groups in each submission batch on the device job system (see
+//zest_SetDeviceBuilderThreadCount). Pass groups that share a resource are kept together and recorded
+//in order by the same worker, the rest are recorded at the same time into their own command buffers which
+//are then submitted in the compiled order. Only enable this if your pass callbacks are thread safe. It has
+//no effect when legacy render passes are in use or the device has no worker threads.
+ZEST_API void zest_EnableParallelRecording(zest_context context, zest_bool enabled);
+ZEST_API zest_bool zest_ParallelRecordingEnabled(zest_context context);
 
 // --- Helper functions for acquiring bindless desriptor array indexes---
 ZEST_API zest_uint zest_GetTransientSampledImageBindlessIndex(const zest_command_list command_list, zest_resource_node resource, zest_binding_number_type binding_number);
@@ -5536,6 +6302,8 @@ ZEST_API zest_uint zest_GetFrameGraphPassTransientCreateCount(zest_frame_graph f
 ZEST_API zest_uint zest_GetFrameGraphPassTransientFreeCount(zest_frame_graph frame_graph, zest_key output_key);
 ZEST_API zest_uint zest_GetFrameGraphCulledResourceCount(zest_frame_graph frame_graph);
 ZEST_API zest_uint zest_GetFrameGraphCulledPassesCount(zest_frame_graph frame_graph);
+ZEST_API zest_frame_graph_timings_t zest_GetFrameGraphTimings(zest_frame_graph frame_graph);
+ZEST_API zest_frame_graph_timings_t zest_GetLastFrameGraphTimings(zest_context context);
 ZEST_API zest_uint zest_GetFrameGraphSubmissionCount(zest_frame_graph frame_graph);
 ZEST_API zest_uint zest_GetFrameGraphSubmissionBatchCount(zest_frame_graph frame_graph, zest_uint submission_index);
 ZEST_API zest_uint zest_GetSubmissionBatchPassCount(const zest_submission_batch_t *batch);
@@ -5737,7 +6505,20 @@ ZEST_API zest_image_info_t zest_CreateImageInfo(zest_uint width, zest_uint heigh
 ZEST_API zest_image_info_t zest_CreateImageInfo3D(zest_uint width, zest_uint height, zest_uint depth);
 ZEST_API zest_image_view_create_info_t zest_CreateViewImageInfo(zest_image image);
 ZEST_API zest_image_handle zest_CreateImage(zest_device device, zest_image_info_t *create_info);
+//Create count images in one go, for example all of the textures in a level at load time. Rather than each image
+//doing its own allocation and bind, the dedicated allocation query is made once per format/flags combination,
+//pooled images are packed into the shared image memory pools together (largest first, adding at most one pool per
+//memory class when they run out) and every image is bound with a single call. Images over the dedicated image
+//threshold still get their own allocation. Either every image is created and handles is filled in, or nothing is
+//created, handles is zeroed and ZEST_FALSE is returned. Each image is freed individually as normal.
+ZEST_API zest_bool zest_CreateImages(zest_device device, zest_image_info_t *create_infos, zest_uint count, zest_image_handle *handles);
 ZEST_API zest_image_handle zest_CreateImageWithPixels(zest_device device, void *pixels, zest_size size, zest_image_info_t *create_info);
+//Create an image and upload a complete, pre-built mip chain in one submission. pixels holds each mip level one
+//after the other starting with level 0, and each level holds all of its array layers (or cube faces) tightly
+//packed, which is the layout KTX2 files use. Nothing is blitted on the GPU so this is the way to upload block
+//compressed textures with mips. size must match zest_GetImageMipChainSize and create_info must not have
+//zest_image_flag_generate_mipmaps set.
+ZEST_API zest_image_handle zest_CreateImageWithMipChain(zest_device device, void *pixels, zest_size size, zest_image_info_t *create_info);
 ZEST_API zest_image zest_GetImage(zest_image_handle handle);
 ZEST_API void zest_FreeImage(zest_image_handle image_handle);
 ZEST_API void zest_FreeImageNow(zest_image_handle image_handle);
@@ -5753,6 +6534,14 @@ ZEST_API void zest_SetObjectName(zest_device device, zest_object_type object_typ
 ZEST_API void zest_SetImageName(zest_device device, zest_image image, const char *name);
 ZEST_API void zest_SetBufferPoolName(zest_device device, zest_device_memory_pool pool, const char *name);
 ZEST_API void zest_GetFormatPixelData(zest_format format, int *channels, int *bytes_per_pixel, int *block_width, int *block_height, int *bytes_per_block);
+//The tightly packed size in bytes of one mip level of an image including all of its layers. Block compressed
+//formats are rounded up to whole blocks.
+ZEST_API zest_size zest_GetImageMipLevelSize(zest_format format, zest_extent3d_t extent, zest_uint mip_level, zest_uint layer_count);
+//The tightly packed size in bytes of every mip level and layer described by the image info.
+ZEST_API zest_size zest_GetImageMipChainSize(const zest_image_info_t *create_info);
+//Returns ZEST_TRUE if the device can create images of the format with the usage flags. Use this to choose
+//which block compressed format to transcode textures to.
+ZEST_API zest_bool zest_IsImageFormatSupported(zest_device device, zest_format format, zest_image_flags flags);
 ZEST_API zest_bool zest_CopyBitmapToImage(zest_device device, void *bitmap, zest_size image_size, zest_image dst_image, zest_uint width, zest_uint height);
 ZEST_API zest_bool zest_CopyImageToBitmap(zest_device device, zest_image src_image, void *pixels);
 //Get the extent of the image
@@ -5771,6 +6560,95 @@ ZEST_API zest_vec4 zest_RegionUV(zest_atlas_region_t *region);
 ZEST_API void zest_BindAtlasRegionToImage(zest_atlas_region_t *region, zest_uint sampler_index, zest_image image, zest_binding_number_type binding_number);
 //-- End Images and textures
 
+//-- Image_streaming
+//An image streamer uploads pixels without blocking. Pixels are copied in to a persistent staging ring, then each
+//call to zest_UpdateImageStreamer submits up to frame_budget bytes of them as one batch on the transfer queue and
+//hands the images over to the graphics queue which generates the mips. Nothing waits on the GPU: poll the tickets
+//or wait on the streamer timeline in a frame graph before sampling the images. Use it from one thread at a time.
+ZEST_API zest_image_streamer_info_t zest_CreateImageStreamerInfo(void);
+ZEST_API zest_image_streamer zest_CreateImageStreamer(zest_device device, zest_image_streamer_info_t *info);
+//Waits for anything in flight and frees the streamer. Uploads that were never submitted are dropped.
+ZEST_API void zest_FreeImageStreamer(zest_image_streamer streamer);
+//Create an image and queue its pixels for upload. Returns an empty handle and a 0 ticket if the ring doesn't have
+//room for the pixels yet, in which case try again after the next zest_UpdateImageStreamer. The pixels are copied
+//so they can be freed as soon as this returns.
+ZEST_API zest_image_handle zest_StreamImageWithPixels(zest_image_streamer streamer, void *pixels, zest_size size, zest_image_info_t *create_info, zest_stream_ticket *ticket);
+//Queue pixels for the base level of an existing image. The image must not be in use by the GPU until the upload
+//completes. Returns 0 if the ring is full.
+ZEST_API zest_stream_ticket zest_StreamPixelsToImage(zest_image_streamer streamer, zest_image_handle image_handle, const void *pixels, zest_size size);
+//Retire finished batches and submit the next one. Call once per frame. Returns the number of uploads submitted.
+ZEST_API zest_uint zest_UpdateImageStreamer(zest_image_streamer streamer);
+//Returns ZEST_TRUE once the upload is finished and the image is ready to sample. Never waits.
+ZEST_API zest_bool zest_ImageStreamIsComplete(zest_image_streamer streamer, zest_stream_ticket ticket);
+//Submit everything that's queued, ignoring the frame budget, and wait for it all to finish. For loading screens
+//and shutdown, not for use while rendering.
+ZEST_API zest_semaphore_status zest_FlushImageStreamer(zest_image_streamer streamer, zest_microsecs timeout);
+//The timeline that the streamer signals as batches finish. Pass it to zest_WaitOnTimeline in a frame graph to
+//have the GPU wait for every submitted upload instead of polling tickets on the CPU.
+ZEST_API zest_execution_timeline zest_GetImageStreamerTimeline(zest_image_streamer streamer);
+ZEST_API zest_image_streamer_stats_t zest_GetImageStreamerStats(zest_image_streamer streamer);
+//-- End Image_streaming
+
+//-- Readbacks
+//Readbacks copy images and buffers back to the CPU without stalling. Copies land in a host cached ring owned by the
+//context (readback_ring_size in zest_create_context_info_t) and each callback fires from zest_PollReadbacks once the
+//GPU work that made the copy has finished, which for a frame graph is normally ZEST_MAX_FIF frames later.
+//zest_BeginFrame and a waited zest_FlushFrameGraph poll for you. Callbacks fire in ticket order on the polling thread.
+//Add a transfer pass to the frame graph being built that reads back a region of an image resource every time the
+//graph executes. Pass 0 for region to read all of mip 0, layer 0. If the ring is full the readback is skipped
+//for that execution and counted in the ring_full_count stat.
+ZEST_API zest_pass_node zest_AddImageReadbackPass(const char *name, zest_resource_node image, zest_image_readback_region_t *region, zest_readback_callback callback, void *user_data);
+//Add a transfer pass that reads back size bytes from offset in a buffer resource. A size of 0 reads to the end of the buffer.
+ZEST_API zest_pass_node zest_AddBufferReadbackPass(const char *name, zest_resource_node buffer, zest_size offset, zest_size size, zest_readback_callback callback, void *user_data);
+//Read back a region of an image outside of a frame graph. The copy is submitted on the graphics queue straight away
+//and nothing waits on it, so the image must not be written to by the GPU until the callback fires. Pass 0 for region
+//to read all of mip 0, layer 0. Returns 0 if the ring is full or ZEST_READBACK_SUBMITS_IN_FLIGHT copies are already
+//in flight, in which case poll and try again.
+ZEST_API zest_readback_ticket zest_ReadbackImage(zest_context context, zest_image image, zest_image_readback_region_t *region, zest_readback_callback callback, void *user_data);
+//Read back size bytes from offset in a buffer outside of a frame graph. A size of 0 reads to the end of the buffer.
+ZEST_API zest_readback_ticket zest_ReadbackBuffer(zest_context context, zest_buffer buffer, zest_size offset, zest_size size, zest_readback_callback callback, void *user_data);
+//Fire the callback of every readback that the GPU has finished, oldest first. Never waits. Returns the number of
+//callbacks fired.
+ZEST_API zest_uint zest_PollReadbacks(zest_context context);
+//Returns ZEST_TRUE once the readback's callback has fired. Polls if it hasn't yet but never waits.
+ZEST_API zest_bool zest_ReadbackIsComplete(zest_context context, zest_readback_ticket ticket);
+//Wait for every submitted readback and fire the callbacks. For shutdown and tests, not for use while rendering.
+ZEST_API zest_semaphore_status zest_FlushReadbacks(zest_context context, zest_microsecs timeout);
+ZEST_API zest_readback_stats_t zest_GetReadbackStats(zest_context context);
+//-- End Readbacks
+
+//-- Virtual_textures
+//A virtual texture keeps only the pages that are on screen in video memory. Shaders look up each page in a page
+//table image to find where it sits in a page cache image and write the pages that they wanted in to a feedback
+//buffer. The feedback is read back a few frames later and zest_UpdateVirtualTexture loads the missing pages through
+//your load_page callback, evicting the least recently used pages when the cache is full. Pages that aren't loaded
+//yet fall back to the nearest coarser mip level, the coarsest of which is always resident.
+ZEST_API zest_virtual_texture_info_t zest_CreateVirtualTextureInfo(zest_uint width, zest_uint height);
+//Create a virtual texture along with its page table, page cache and feedback buffer and their bindless indexes.
+ZEST_API zest_virtual_texture zest_CreateVirtualTexture(zest_context context, zest_virtual_texture_info_t *info);
+//Free a virtual texture. The images and buffers are freed once the frames in flight are done with them.
+ZEST_API void zest_FreeVirtualTexture(zest_virtual_texture virtual_texture);
+//Load up to upload_budget of the pages asked for by the latest feedback, coarsest mip levels first, and stage them
+//along with the page table for this frame's upload pass. Call once a frame after zest_BeginFrame. Pages that are still
+//waiting for an upload pass count towards the budget and are kept. Returns the number of pages loaded.
+ZEST_API zest_uint zest_UpdateVirtualTexture(zest_virtual_texture virtual_texture);
+//Import the page table, page cache and feedback buffer in to the frame graph being built.
+ZEST_API zest_virtual_texture_resources_t zest_ImportVirtualTexture(zest_virtual_texture virtual_texture);
+//Add the transfer pass that clears the feedback buffer and copies the pages staged by zest_UpdateVirtualTexture in to
+//the cache. Add it before the passes that sample the virtual texture, which should connect the page table and page
+//cache as inputs and the feedback buffer as an output.
+ZEST_API zest_pass_node zest_AddVirtualTextureUploadPass(zest_virtual_texture virtual_texture, zest_virtual_texture_resources_t *resources);
+//Add the pass that reads back the feedback buffer. Add it after the passes that sample the virtual texture.
+ZEST_API zest_pass_node zest_AddVirtualTextureFeedbackPass(zest_virtual_texture virtual_texture, zest_virtual_texture_resources_t *resources);
+ZEST_API zest_virtual_texture_shader_info_t zest_GetVirtualTextureShaderInfo(zest_virtual_texture virtual_texture);
+ZEST_API zest_image_handle zest_GetVirtualTexturePageTable(zest_virtual_texture virtual_texture);
+ZEST_API zest_image_handle zest_GetVirtualTexturePageCache(zest_virtual_texture virtual_texture);
+ZEST_API zest_buffer zest_GetVirtualTextureFeedbackBuffer(zest_virtual_texture virtual_texture);
+//Returns ZEST_TRUE if the page is in the cache
+ZEST_API zest_bool zest_VirtualPageIsResident(zest_virtual_texture virtual_texture, zest_uint mip_level, zest_uint page_x, zest_uint page_y);
+ZEST_API zest_virtual_texture_stats_t zest_GetVirtualTextureStats(zest_virtual_texture virtual_texture);
+//-- End Virtual_textures
+
 // --Sampler_functions
 //Gets a sampler from the sampler storage in the renderer. If no match is found for the info that you pass into the sampler
 //then a new one will be created.
@@ -5801,6 +6679,17 @@ ZEST_API zest_layer zest_GetLayer(zest_layer_handle layer_handle);
 //id can be shared with any other frame in flight layer that will flip their frame in flight index at the same
 //time, like when ever the update loop is run.
 ZEST_API zest_layer_handle zest_CreateFIFInstanceLayer(zest_context context, const char *name, zest_size type_size, zest_uint max_instances);
+//Same as zest_CreateFIFInstanceLayer but the buffers for each frame in flight are placed in device local memory
+//that the CPU can write to, so instances are written straight in to the buffer the GPU reads and there's
+//nothing to upload. If the device has no host visible device memory (see zest_DeviceHasHostVisibleDeviceMemory)
+//or there isn't enough of it left, now or when the layer needs to grow, the layer falls back to a staging
+//buffer and an upload like a normal frame in flight layer. Use zest_InstanceLayerNeedsUpload to decide
+//whether to add the transfer pass to the frame graph.
+ZEST_API zest_layer_handle zest_CreateDirectFIFInstanceLayer(zest_context context, const char *name, zest_size type_size, zest_uint max_instances);
+//ZEST_FALSE if the layer writes its instances directly in to device memory, in which case the
+//zest_UploadInstanceLayerData transfer pass can be left out of the frame graph. Include the result in
+//your frame graph cache key as a direct layer can fall back to uploading if it runs out of memory to grow.
+ZEST_API zest_bool zest_InstanceLayerNeedsUpload(zest_layer layer);
 //Set the layer frame in flight to the next layer. Use this if you're manually setting the current fif for the layer so
 //that you can avoid uploading the staging buffers every frame and only do so when it's neccessary.
 ZEST_API void zest_ResetLayer(zest_layer layer);
@@ -5830,6 +6719,58 @@ ZEST_API void zest_ResetInstanceLayerDrawing(zest_layer layer);
 ZEST_API zest_uint zest_GetInstanceLayerCount(zest_layer layer);
 //Move the pointer in memory to the next instance to write to.
 ZEST_API void *zest_NextInstance(zest_layer layer);
+//Only upload the parts of a frame in flight layer that changed. Instances are kept when zest_ResetInstanceLayer
+//flips the layer to the next frame in flight, and instances written with zest_NextInstance or changed with
+//zest_UpdateInstance/zest_MarkInstancesChanged are tracked in pages of page_size bytes (0 for
+//ZEST_LAYER_DELTA_PAGE_SIZE). zest_UploadInstanceLayerData then copies each run of changed pages in its own
+//region. Call zest_ResetInstanceLayerDrawing to start writing the layer from scratch.
+ZEST_API void zest_EnableInstanceLayerDeltaUploads(zest_layer layer, zest_size page_size);
+//Get a pointer to an instance that's already in a layer so that it can be changed. With delta uploads the
+//instance is marked as changed so it's uploaded.
+ZEST_API void *zest_UpdateInstance(zest_layer layer, zest_uint index);
+//Mark a range of instances as changed if you wrote to them directly through the staging buffer
+ZEST_API void zest_MarkInstancesChanged(zest_layer layer, zest_uint first_instance, zest_uint instance_count);
+//The number of bytes that were copied to the device the last time the layer was uploaded
+ZEST_API zest_size zest_GetLayerLastUploadSize(zest_layer layer);
+//Add count instances to the current instruction and return a pointer to the first one so that they can be
+//filled in afterwards, for example by several threads that each write their own slice with zest_ParallelFor.
+//The buffer is grown first if needed so the pointer stays valid until something else adds instances to the
+//layer. Returns NULL if the buffer could not be grown.
+ZEST_API void *zest_ReserveInstances(zest_layer layer, zest_uint count);
+//Start writing instances to a layer from several threads when you don't know how many each one will write.
+//Each writer collects its instances separately and zest_EndParallelInstances appends them to the current
+//instruction in writer order, so the result is the same however the threads were scheduled. A writer must
+//only be used by one thread at a time. Give each writer a fixed piece of the work (a zest_ParallelFor batch
+//for example) rather than a thread, as which thread picks up which work isn't deterministic.
+ZEST_API zest_instance_writer_t *zest_BeginParallelInstances(zest_layer layer, zest_uint writer_count);
+//Get a pointer to the next instance of a writer to write to. Can be called from any thread. Returns NULL if the
+//writer couldn't grow, in which case it keeps the instances it already has.
+ZEST_API void *zest_NextWriterInstance(zest_instance_writer_t *writer);
+//Append the instances of every writer to the layer in writer order and return how many were added. Call
+//from the thread that owns the layer after all the writers are finished.
+ZEST_API zest_uint zest_EndParallelInstances(zest_layer layer);
+//Keep the instances of a frame in flight layer in slots that persist from frame to frame instead of writing them all
+//again each frame. Instances are added and removed with ids that stay the same for as long as the instance exists,
+//and only the instances that were added, removed or changed are copied and uploaded. The layer is drawn with
+//zest_DrawInstanceLayer as normal, every instance in the store is drawn with the pipeline passed in and the push
+//constants that were set on the layer. Call zest_ResetInstanceLayer at the start of any frame that changes the store.
+//The layer must be made with zest_CreateFIFInstanceLayer, zest_CreateDirectFIFInstanceLayer or
+//zest_CreateFIFInstanceMeshLayer, delta uploads are enabled if they aren't already.
+ZEST_API void zest_EnableInstanceStore(zest_layer layer, zest_pipeline_template pipeline);
+//Add an instance to a store and return a pointer to write it to. The id of the instance is written to id. Returns
+//NULL if the layer's buffers couldn't be grown to fit it.
+ZEST_API void *zest_AddStoreInstance(zest_layer layer, zest_instance_id *id);
+//Get a pointer to an instance in a store so that it can be changed. It's marked as changed so it's uploaded and the
+//store's instruction (and indirect command with multi draw indirect) is written again for the current frame in flight.
+ZEST_API void *zest_UpdateStoreInstance(zest_layer layer, zest_instance_id id);
+//Remove an instance from a store. The last instance in the store is moved in to its slot so that the instances stay
+//packed, which is the only other instance that has to be uploaded again.
+ZEST_API void zest_RemoveStoreInstance(zest_layer layer, zest_instance_id id);
+//ZEST_TRUE if the id is for an instance that's still in the store
+ZEST_API zest_bool zest_StoreInstanceIsValid(zest_layer layer, zest_instance_id id);
+//The slot that an instance is in, which is its index in the layer's instance buffer. This changes when another
+//instance is removed so look it up again rather than keeping it. Returns ZEST_INVALID if the id isn't valid.
+ZEST_API zest_uint zest_GetStoreInstanceSlot(zest_layer layer, zest_instance_id id);
 //Free a layer and all it's resources
 ZEST_API void zest_FreeLayer(zest_layer_handle layer);
 //Set the viewport of a layer. This is important to set right as when the layer is drawn it needs to be clipped correctly and in a lot of cases match how the
@@ -5857,6 +6798,10 @@ ZEST_API zest_buffer zest_GetLayerVertexBuffer(zest_layer layer);
 ZEST_API zest_buffer zest_GetLayerStagingVertexBuffer(zest_layer layer);
 ZEST_API zest_buffer zest_GetLayerStagingIndexBuffer(zest_layer layer);
 ZEST_API const zest_mesh_offset_data_t *zest_GetLayerMeshOffsets(zest_layer layer, zest_uint mesh_index);
+//The vertex and index buffers that an instance mesh layer's meshes are stored in. These are replaced when the layer
+//grows so don't hold on to them after adding meshes.
+ZEST_API zest_buffer zest_GetLayerMeshVertexBuffer(zest_layer layer);
+ZEST_API zest_buffer zest_GetLayerMeshIndexBuffer(zest_layer layer);
 ZEST_API void zest_UploadLayerStagingData(zest_layer layer, const zest_command_list command_list);
 ZEST_API void zest_DrawInstanceLayer(const zest_command_list command_list, void *user_data);
 ZEST_API zest_layer_instruction_t *zest_GetLayerInstruction(zest_layer layer, zest_instruction_id instruction);
@@ -5866,6 +6811,9 @@ ZEST_API char *zest_GetLayerInstructionPushConstants(zest_layer layer, zest_uint
 ZEST_API zest_uint zest_GetLayerInstructionCount(zest_layer layer);
 ZEST_API zest_scissor_rect_t zest_GetLayerScissor(zest_layer layer);
 ZEST_API zest_viewport_t zest_GetLayerViewport(zest_layer layer);
+//Get the number of draws and state changes that were recorded the last time the layer was drawn, along with
+//how many redundant pipeline, push constant, viewport and scissor binds were skipped.
+ZEST_API zest_layer_draw_stats_t zest_GetLayerDrawStats(zest_layer layer);
 //-- End Draw Layers
 
 
@@ -5923,6 +6871,51 @@ ZEST_API void zest_DrawInstanceMeshLayer(const zest_command_list command_list, v
 //Draw an instance mesh layer with a specific pipeline. So every instruction in the layer will be draw with the 
 //pipeline that you pass in to the layer.
 ZEST_API void zest_DrawInstanceMeshLayerWithPipeline(const zest_command_list command_list, zest_layer layer, zest_pipeline_template pipeline);
+//Draw an instance mesh layer with indirect draws. A zest_draw_indexed_indirect_command_t is written to a host visible
+//indirect buffer for every draw instruction as it's recorded, and zest_DrawInstanceMeshLayer then draws each run of
+//instructions that share the same pipeline, push constants and viewport with a single multi draw call. The draw count is
+//read from the buffer when zest_capability_draw_indirect_count is enabled. Without zest_capability_multi_draw_indirect
+//each instruction is still drawn indirectly, but one at a time.
+//first_instance in each command is the instruction's start index so instance attributes are fetched as normal. gl_DrawID
+//(zest_capability_shader_draw_parameters) is the index of the instruction within its run.
+ZEST_API void zest_EnableLayerMultiDrawIndirect(zest_layer layer);
+//Get the indirect buffer that the layer's commands are written to for the current frame in flight, or 0 if the layer
+//doesn't use multi draw indirect. Command n is for draw instruction n.
+ZEST_API zest_buffer zest_GetLayerIndirectBuffer(zest_layer layer);
+//Cull the instances of an instance mesh layer on the GPU instead of the CPU. Every instance is written to the layer as
+//normal and a compute pass added with zest_AddLayerCullPass tests each one against the view set with
+//zest_SetLayerCullView. The instances that pass are compacted in to a new buffer and the shader counts them in to the
+//layer's indirect commands, which zest_DrawInstanceMeshLayer then draws from. This also enables multi draw indirect.
+//position_offset is the byte offset of a vec3 position in the instance struct and scale_offset is the offset of a vec3
+//scale, or ZEST_INVALID if the instances aren't scaled. Returns ZEST_FALSE if the cull shader couldn't be created.
+ZEST_API zest_bool zest_EnableLayerGPUCulling(zest_layer layer, zest_uint position_offset, zest_uint scale_offset);
+//Set the bounds of a mesh in the layer for GPU culling, for example with zest_GetMeshBoundingBox. Instances of meshes
+//without bounds are never culled.
+ZEST_API void zest_SetLayerMeshBounds(zest_layer layer, zest_uint mesh_index, zest_bounding_box_t bounds);
+//Set the view that the layer is culled against. Call this every frame, cached frame graphs read it when they execute.
+//Nothing is culled until it's set.
+ZEST_API void zest_SetLayerCullView(zest_layer layer, const zest_layer_cull_view_t *view);
+//Add the compute pass that culls the layer. Call it while building a frame graph after the pass that uploads the layer,
+//passing in the resource from zest_AddTransientLayerResource. hiz_pyramid is optional: an image resource where each mip
+//holds the farthest depth of the mip above it, built from the last frame's depth buffer. Instances that are behind it
+//are culled as well. Returns the resource with the culled instances.
+ZEST_API zest_resource_node zest_AddLayerCullPass(zest_layer layer, zest_resource_node layer_resource, zest_resource_node hiz_pyramid);
+//Connect the outputs of the layer's cull pass as inputs to the current pass, call this in the pass that draws the layer.
+ZEST_API void zest_ConnectLayerCullInputs(zest_layer layer);
+//Let an instance mesh layer pick a level of detail for each instance from LOD chains. position_offset is the byte
+//offset of a vec3 position in the instance struct and scale_offset the offset of a vec3 scale, or ZEST_INVALID if the
+//instances aren't scaled. If the layer also has GPU culling they must be the same offsets that culling uses.
+ZEST_API void zest_EnableLayerMeshLODs(zest_layer layer, zest_uint position_offset, zest_uint scale_offset);
+//Add a LOD chain of meshes that are already in the layer, from the most to the least detailed, and return its index for
+//zest_StartInstanceMeshLODDrawing. min_screen_sizes is the smallest screen size that each level is drawn at and each
+//must be smaller than the one before. Instances smaller than the last level aren't drawn so pass 0 for the last level to
+//always draw them. The screen size of an instance is the radius of the first level's bounds (see
+//zest_SetLayerMeshBounds, 1 if it has none) times the instance's scale, over its distance from the LOD view.
+ZEST_API zest_uint zest_AddLayerMeshLODChain(zest_layer layer, const zest_uint *mesh_indexes, const float *min_screen_sizes, zest_uint level_count);
+//Set where the layer's LODs are picked from, usually the camera position. The screen size is multiplied by lod_scale,
+//so viewport height / (2 * tan(fov / 2)) makes it the radius in pixels. Every instance uses the first level of its
+//chain until this is set. Cached frame graphs read it when they execute.
+ZEST_API void zest_SetLayerLODView(zest_layer layer, zest_vec3 position, float lod_scale);
 
 //-----------------------------------------------
 //        Draw_instance_mesh_layers
@@ -5931,6 +6924,11 @@ ZEST_API void zest_DrawInstanceMeshLayerWithPipeline(const zest_command_list com
 //        but this can all be expanded on for general 3d models in the future.
 //-----------------------------------------------
 ZEST_API zest_instruction_id zest_StartInstanceMeshDrawing(zest_layer layer, zest_uint mesh_index, zest_pipeline_template pipeline);
+//Start drawing instances of a LOD chain made with zest_AddLayerMeshLODChain. Write the instances with zest_NextInstance
+//as normal. When the instruction ends the instances are sorted in to a draw for each level on the CPU, or if the layer
+//has GPU culling the cull pass picks the level of each instance and compacts them in to a draw for each level. Without
+//the cull pass the GPU culled layer draws every instance with the first level.
+ZEST_API zest_instruction_id zest_StartInstanceMeshLODDrawing(zest_layer layer, zest_uint lod_chain, zest_pipeline_template pipeline);
 //Push an index to a mesh to build triangles
 ZEST_API void zest_PushMeshIndex(zest_mesh mesh, zest_uint index);
 //Rather then PushMeshIndex you can call this to add three indexes at once to build a triangle in the mesh
@@ -5951,12 +6949,56 @@ ZEST_API void zest_CopyMeshVertexData(zest_mesh mesh, const void* vertex_data, z
 ZEST_API void zest_CopyMeshIndexData(zest_mesh mesh, const zest_uint *index_data, zest_uint count);
 //Reserve capacity for vertices in the mesh
 ZEST_API void zest_ReserveMeshVertices(zest_mesh mesh, zest_uint count);
+//Reserve capacity for indexes in the mesh
+ZEST_API void zest_ReserveMeshIndexes(zest_mesh mesh, zest_uint count);
+//Add an array of vertices to the end of the mesh, growing the vertex data at most once. Returns the index of the first
+//vertex added which you can pass to zest_AppendMeshIndexes as the base vertex.
+ZEST_API zest_uint zest_AppendMeshVertices(zest_mesh mesh, const void *vertices, zest_uint count);
+//Add an array of indexes to the end of the mesh, growing the index data at most once. base_vertex is added to each
+//index so that index data written for a mesh on its own can be appended to a bigger one.
+ZEST_API void zest_AppendMeshIndexes(zest_mesh mesh, const zest_uint *indexes, zest_uint count, zest_uint base_vertex);
+//Calculate smooth normals for every vertex in a mesh from its triangles. Each vertex gets the normalised sum of the
+//normals of the triangles that use it. position_offset and normal_offset are the byte offsets of vec3s in the vertex
+//struct. The triangles are worked out 4 at a time with SIMD and large meshes are split across the job system.
+ZEST_API void zest_CalculateMeshNormals(zest_mesh mesh, zest_uint position_offset, zest_uint normal_offset);
+//Calculate tangents for every vertex in a mesh from its positions, normals and uvs, so calculate the normals first.
+//These follow the MikkTSpace conventions that normal maps are usually baked with: triangles are weighted by their
+//angle at the vertex, the tangent is made orthogonal to the normal and w is the sign of the bitangent, which is
+//cross(normal, tangent) * w. Vertices that are shared across a uv seam are not split though, so split them in the
+//mesh first for an exact match. uv_offset is the byte offset of a vec2 and tangent_format can be
+//zest_format_r32g32b32a32_sfloat for a vec4 or zest_format_r16g16b16a16_snorm for a tangent packed in to a zest_u64
+//with zest_Pack16bit4SNorm. Large meshes are split across the job system.
+ZEST_API void zest_CalculateMeshTangents(zest_mesh mesh, zest_uint position_offset, zest_uint normal_offset, zest_uint uv_offset, zest_uint tangent_offset, zest_format tangent_format);
+//Create a simplified copy of a mesh for a lower level of detail by clustering its vertices in to a grid of cells that
+//are cell_size wide. Each cell becomes one vertex at the average position of the vertices in it, which keeps the other
+//attributes of the first of them, and triangles that collapse are removed. position_offset is the byte offset of a vec3
+//in the vertex struct. Free the new mesh with zest_FreeMesh when you're done with it.
+ZEST_API zest_mesh zest_CreateSimplifiedMesh(zest_mesh mesh, zest_uint position_offset, float cell_size);
 //Clear all vertices from the mesh (keeps capacity)
 ZEST_API void zest_ClearMeshVertices(zest_mesh mesh);
 //Initialise a new bounding box to 0
 ZEST_API zest_bounding_box_t zest_NewBoundingBox(void);
-//Add a mesh to an instanced mesh layer. Existing vertex data in the layer will be deleted.
+//Add a mesh to an instanced mesh layer and return its index. Space left by removed meshes is reused and the layer's
+//buffers are grown if there isn't room. All the meshes in a layer must use the same vertex struct. Returns
+//ZEST_INVALID if the buffers couldn't be grown.
 ZEST_API zest_uint zest_AddMeshToLayer(zest_layer layer, zest_mesh src_mesh, zest_uint texture_index);
+//Remove a mesh from an instance mesh layer. Its space in the vertex and index buffers is reused by meshes added later,
+//once the frames in flight that might still draw it are done. Other meshes keep their index and the removed index is
+//given to the next mesh that's added.
+ZEST_API void zest_RemoveMeshFromLayer(zest_layer layer, zest_uint mesh_index);
+//ZEST_TRUE if mesh_index is a mesh in the layer that hasn't been removed
+ZEST_API zest_bool zest_LayerHasMesh(zest_layer layer, zest_uint mesh_index);
+//Plan moves of meshes down in to the gaps left by removed meshes so that the free space ends up at the end of the
+//layer's buffers. Stops once max_bytes are planned so it can be called every frame with a small budget to defragment
+//a bit at a time. The copies are made by the pass from zest_AddLayerMeshDefragmentPass and the meshes switch to their
+//new ranges once the frames in flight are done with it. Mesh indexes don't change. Returns the number of bytes
+//planned, 0 when there's nothing to do or the last batch hasn't finished yet.
+ZEST_API zest_size zest_DefragmentLayerMeshes(zest_layer layer, zest_size max_bytes);
+//Add the transfer pass that copies the meshes planned by zest_DefragmentLayerMeshes. It does nothing in frames
+//without a new batch, so it can be left in a cached frame graph.
+ZEST_API zest_pass_node zest_AddLayerMeshDefragmentPass(zest_layer layer);
+//Get how much of an instance mesh layer's vertex and index buffers are used and free
+ZEST_API zest_layer_mesh_pool_stats_t zest_GetLayerMeshPoolStats(zest_layer layer);
 //Get the vertex count in the mesh
 ZEST_API zest_uint zest_MeshVertexCount(zest_mesh mesh);
 //Get the index count in the mesh
@@ -6094,6 +7136,10 @@ ZEST_API zest_bool zest_DeviceHasMemoryBudget(zest_device device);
 //These are driver estimates that move over time - re-query rather than caching. See
 //zest_memory_budget_t for exactly what budget and usage do and do not measure.
 ZEST_API zest_memory_budget_t zest_GetDeviceMemoryBudget(zest_device device);
+//ZEST_TRUE if the device has memory that's both device local and host visible, either because resizable
+//BAR is enabled or because it's an integrated GPU. Direct instance layers need it, see
+//zest_CreateDirectFIFInstanceLayer.
+ZEST_API zest_bool zest_DeviceHasHostVisibleDeviceMemory(zest_device device);
 //Fill usages (up to max_usages) with per pool allocator usage covering both device and context owned
 //GPU pools. Returns the total number of pool allocators which may be more than max_usages. Pass NULL
 //usages to just get the count.
@@ -6103,6 +7149,33 @@ ZEST_PRIVATE void zest__fill_buffer_pool_usage(zest_buffer_allocator buffer_allo
 //every context (e.g. a memory overview that includes headless worker contexts).
 ZEST_API zest_uint zest_GetDeviceContextCount(zest_device device);
 ZEST_API zest_context zest_GetDeviceContext(zest_device device, zest_uint index);
+//Write the pipeline cache to disk now rather than waiting for zest_DestroyDevice, eg. after a loading screen
+//has built all of its pipelines. Does nothing and returns ZEST_FALSE unless the device was built with
+//zest_DeviceBuilderCachePipelines.
+ZEST_API zest_bool zest_SavePipelineCache(zest_device device);
+//-- Job system
+//The device owns a work stealing job system which zest uses internally (parallel recording, large staging
+//copies) and which you can use for your own work rather than starting a second pool that competes with it
+//for cores. The threads are started the first time any of these functions are called.
+//Queue jobs on the calling thread's deque. counter->pending is increased by job_count and decreased as
+//each job finishes. Jobs may queue more jobs. If the deque is full the job is run straight away instead.
+ZEST_API void zest_RunJobs(zest_device device, const zest_job_t *jobs, zest_uint job_count, zest_job_counter_t *counter);
+//Run (or steal) queued jobs on the calling thread until every job counted by counter has finished. Safe to
+//call from inside a job.
+ZEST_API void zest_WaitJobs(zest_device device, zest_job_counter_t *counter);
+//Call callback over [0, count) in batches of batch_size and wait for them all to finish. Batches are
+//claimed on demand so uneven work balances itself. Pass 0 for batch_size to pick one from the worker count.
+ZEST_API void zest_ParallelFor(zest_device device, zest_uint count, zest_uint batch_size, zest_parallel_for_callback callback, void *data);
+//The number of distinct worker_index values job callbacks can receive (pool threads + 1). Use it to size
+//per worker scratch data.
+ZEST_API zest_uint zest_GetJobWorkerCount(zest_device device);
+//The worker_index of the calling thread: 1..thread_count on a pool thread, otherwise 0.
+ZEST_API zest_uint zest_GetCurrentJobWorkerIndex(zest_device device);
+//Totals of the job thread allocator caches since the job system started: how many allocations were
+//served by a cache (hits) rather than having to refill from the allocator, and how often taking the
+//allocator lock had to spin because another thread held it. All zero unless the device was built with
+//zest_DeviceBuilderThreadAllocatorCaches.
+ZEST_API zloc_thread_cache_stats_t zest_GetAllocatorCacheStats(zest_device device);
 ZEST_API zest_bool zest_ContextIsHeadless(zest_context context);
 //Number of transient arenas the context owns. In a steady state this should stay bounded (roughly
 //one arena per category per frame in flight); unbounded growth means arena checkouts are not being
@@ -6263,6 +7336,10 @@ ZEST_API void zest_cmd_DrawLayerInstruction(const zest_command_list command_list
 ZEST_API void zest_cmd_DrawIndexed(const zest_command_list command_list, zest_uint index_count, zest_uint instance_count, zest_uint first_index, int32_t vertex_offset, zest_uint first_instance);
 //Send a draw indirect commands
 ZEST_API void zest_cmd_DrawIndexedIndirect(const zest_command_list command_list, zest_buffer buffer, zest_size offset, zest_uint draw_count, zest_uint stride);
+//Send draw indirect commands where the number of draws is read from count_buffer at count_offset (in bytes) and is
+//clamped to max_draw_count. offset is the index of the first command in buffer, the same as zest_cmd_DrawIndexedIndirect.
+//The device must have zest_capability_draw_indirect_count enabled.
+ZEST_API void zest_cmd_DrawIndexedIndirectCount(const zest_command_list command_list, zest_buffer buffer, zest_size offset, zest_buffer count_buffer, zest_size count_offset, zest_uint max_draw_count, zest_uint stride);
 ZEST_API void zest_cmd_DrawIndirect(const zest_command_list command_list, zest_buffer buffer, zest_size offset, zest_uint draw_count, zest_uint stride);
 //Set the depth bias for when depth bias is enabled in the pipeline
 ZEST_API void zest_cmd_SetDepthBias(const zest_command_list command_list, float factor, float clamp, float slope);
@@ -6506,6 +7583,18 @@ void *zloc_AllocateAligned(zloc_allocator *allocator, zloc_size size, zloc_size
 	return zloc__block_user_ptr(block);
 }
 
+//The allocator must already be locked
+static inline void zloc__free_block(zloc_allocator *allocator, zloc_header *block) {
+	if (zloc__prev_is_free_block(block)) {
+		ZLOC_ASSERT(block->prev_physical_block);		//Must be a valid previous physical block
+		block = zloc__merge_with_prev_block(allocator, block);
+	}
+	if (zloc__next_block_is_free(block)) {
+		zloc__merge_with_next_block(allocator, block);
+	}
+	zloc__push_block(allocator, block);
+}
+
 int zloc_Free(zloc_allocator *allocator, void* allocation) {
 	if (!allocation) return 0;
 	zloc__lock_thread_access;
@@ -6514,18 +7603,145 @@ int zloc_Free(zloc_allocator *allocator, void* allocation) {
 	//Asserting here means that there's probably been a mix up between a context allocator and a device allocator.
 	ZLOC_ASSERT(block->allocator == allocator);
 	#endif
-	if (zloc__prev_is_free_block(block)) {
-		ZLOC_ASSERT(block->prev_physical_block);		//Must be a valid previous physical block
-		block = zloc__merge_with_prev_block(allocator, block);
+	zloc__free_block(allocator, block);
+	zloc__unlock_thread_access;
+	return 1;
+}
+
+//Same as zloc__lock_thread_access but counts how often the lock was already taken
+static inline void zloc__lock_thread_cache(zloc_thread_cache_t *cache) {
+	cache->stats.lock_acquisitions++;
+	#if defined(ZLOC_THREAD_SAFE)
+	while (0 != zloc__compare_and_exchange(&cache->allocator->access, 1, 0)) {
+		cache->stats.lock_spins++;
 	}
-	if (zloc__next_block_is_free(block)) {
-		zloc__merge_with_next_block(allocator, block);
+	#endif
+}
+
+static inline void zloc__unlock_thread_cache(zloc_thread_cache_t *cache) {
+	#if defined(ZLOC_THREAD_SAFE)
+	cache->allocator->access = 0;
+	#endif
+}
+
+//The smallest class that a block of this size can be handed out for, or -1 if it's too big to cache
+static inline int zloc__thread_cache_alloc_class(zloc_size size) {
+	zloc_size class_size = ZLOC_THREAD_CACHE_SMALLEST_CLASS;
+	for (int size_class = 0; size_class != ZLOC_THREAD_CACHE_CLASSES; ++size_class) {
+		if (size <= class_size) return size_class;
+		class_size <<= 1;
+	}
+	return -1;
+}
+
+//The largest class that a freed block is big enough for. Blocks of twice the largest class or more are not
+//cached so that a cache can never sit on large blocks that the rest of the allocator could be using.
+static inline int zloc__thread_cache_free_class(zloc_size size) {
+	if (size < ZLOC_THREAD_CACHE_SMALLEST_CLASS) return -1;
+	zloc_size class_size = ZLOC_THREAD_CACHE_SMALLEST_CLASS;
+	for (int size_class = 0; size_class != ZLOC_THREAD_CACHE_CLASSES; ++size_class) {
+		if (size < class_size << 1) return size_class;
+		class_size <<= 1;
+	}
+	return -1;
+}
+
+static inline void *zloc__thread_cache_pop(zloc_thread_cache_t *cache, int size_class) {
+	void *allocation = cache->free_lists[size_class];
+	cache->free_lists[size_class] = *(void**)allocation;
+	cache->counts[size_class]--;
+	return allocation;
+}
+
+static inline void zloc__thread_cache_push(zloc_thread_cache_t *cache, int size_class, void *allocation) {
+	*(void**)allocation = cache->free_lists[size_class];
+	cache->free_lists[size_class] = allocation;
+	cache->counts[size_class]++;
+}
+
+void zloc_InitialiseThreadCache(zloc_thread_cache_t *cache, zloc_allocator *allocator) {
+	ZLOC_ASSERT(allocator->block_extension_size == 0);	//Remote allocators can't be cached
+	memset(cache, 0, sizeof(zloc_thread_cache_t));
+	cache->allocator = allocator;
+}
+
+void *zloc_CacheAllocate(zloc_thread_cache_t *cache, zloc_size size) {
+	size = zloc__adjust_size(size, zloc__MINIMUM_BLOCK_SIZE, zloc__MEMORY_ALIGNMENT);
+	int size_class = zloc__thread_cache_alloc_class(size);
+	if (size_class == -1) {
+		cache->stats.bypassed++;
+		return zloc_Allocate(cache->allocator, size);
+	}
+	if (cache->free_lists[size_class]) {
+		cache->stats.hits++;
+		return zloc__thread_cache_pop(cache, size_class);
+	}
+	//Take a whole batch while we have the lock. Every block is at least the class size so any of them can
+	//be handed out for any request in the class.
+	cache->stats.misses++;
+	cache->stats.refills++;
+	zloc_allocator *allocator = cache->allocator;
+	zloc_size class_size = (zloc_size)ZLOC_THREAD_CACHE_SMALLEST_CLASS << size_class;
+	zloc__lock_thread_cache(cache);
+	for (int i = 0; i != ZLOC_THREAD_CACHE_BATCH; ++i) {
+		zloc_header *block = zloc__find_free_block(allocator, class_size, 0);
+		if (!block) break;
+		zloc__thread_cache_push(cache, size_class, zloc__block_user_ptr(block));
+	}
+	zloc__unlock_thread_cache(cache);
+	if (!cache->free_lists[size_class]) {
+		//Out of memory
+		return 0;
+	}
+	return zloc__thread_cache_pop(cache, size_class);
+}
+
+int zloc_CacheFree(zloc_thread_cache_t *cache, void *allocation) {
+	if (!allocation) return 0;
+	zloc_header *block = zloc__block_from_allocation(allocation);
+	#ifdef ZLOC_SAFEGUARDS
+	//Asserting here means that the block belongs to a different allocator to the one the cache was made for.
+	ZLOC_ASSERT(block->allocator == cache->allocator);
+	#endif
+	int size_class = zloc__thread_cache_free_class(zloc__block_size(block));
+	if (size_class == -1) {
+		cache->stats.bypassed++;
+		return zloc_Free(cache->allocator, allocation);
+	}
+	zloc__thread_cache_push(cache, size_class, allocation);
+	if (cache->counts[size_class] > ZLOC_THREAD_CACHE_BATCH * 2) {
+		//Hand a batch back so that a thread that mostly frees doesn't hoard the pool
+		cache->stats.drains++;
+		zloc_allocator *allocator = cache->allocator;
+		zloc__lock_thread_cache(cache);
+		for (int i = 0; i != ZLOC_THREAD_CACHE_BATCH; ++i) {
+			zloc__free_block(allocator, zloc__block_from_allocation(zloc__thread_cache_pop(cache, size_class)));
+		}
+		zloc__unlock_thread_cache(cache);
 	}
-	zloc__push_block(allocator, block);
-	zloc__unlock_thread_access;
 	return 1;
 }
 
+void zloc_FlushThreadCache(zloc_thread_cache_t *cache) {
+	zloc_allocator *allocator = cache->allocator;
+	if (!allocator) return;
+	zloc_bool locked = 0;
+	for (int size_class = 0; size_class != ZLOC_THREAD_CACHE_CLASSES; ++size_class) {
+		if (!cache->free_lists[size_class]) continue;
+		if (!locked) {
+			zloc__lock_thread_cache(cache);
+			locked = 1;
+		}
+		while (cache->free_lists[size_class]) {
+			zloc__free_block(allocator, zloc__block_from_allocation(zloc__thread_cache_pop(cache, size_class)));
+		}
+	}
+	if (locked) {
+		cache->stats.drains++;
+		zloc__unlock_thread_cache(cache);
+	}
+}
+
 ZLOC_API void* zloc_PromoteLinearBlock(zloc_allocator *allocator, void* linear_alloc_mem, zloc_size used_size) {
 	if (!allocator || !linear_alloc_mem || used_size == 0) {
 		return 0;
@@ -6929,6 +8145,13 @@ zloc_size zloc_GetLinearAllocatorCapacity(zloc_linear_allocator_t *allocator) {
 zest__platform_setup zest__platform_setup_callbacks[zest_max_platforms] = { 0 };
 //The thread local frame graph setup context
 static ZEST_THREAD_LOCAL zest_frame_graph_builder zest__frame_graph_builder = NULL;
+//Set while this thread records pass groups in parallel with other threads, see zest__linear_allocate
+static ZEST_THREAD_LOCAL zest_sync_t *zest__linear_allocator_guard = NULL;
+//Set on job system threads so jobs that queue more jobs push them on to their own deque.
+static ZEST_THREAD_LOCAL zest_job_system_t *zest__current_job_system = NULL;
+static ZEST_THREAD_LOCAL zest_uint zest__current_job_worker = 0;
+//Set on job system threads when the device was built with zest_DeviceBuilderThreadAllocatorCaches.
+static ZEST_THREAD_LOCAL zest_job_worker_t *zest__current_cache_worker = NULL;
 
 // --[Struct_definitions]
 typedef struct zest_mesh_t {
@@ -7069,6 +8292,7 @@ typedef struct zest_device_t {
 	void *memory_pools[ZEST_MAX_DEVICE_MEMORY_POOLS];
 	zest_size memory_pool_sizes[ZEST_MAX_DEVICE_MEMORY_POOLS];
 	zest_uint memory_pool_count;
+	volatile zloc_thread_access pool_growth_access;		//Held while a pool is added, see zest__lock_pool_growth
 	zloc_allocator *allocator;
 	const char **extensions;
 	zest_platform_memory_info_t platform_memory_info;
@@ -7114,6 +8338,8 @@ typedef struct zest_device_t {
 	zest_map_buffer_allocators buffer_allocators;
 	zest_uint dedicated_buffer_count;
 	zest_size dedicated_buffer_total_size;
+	zest_size direct_layer_memory;			//Host visible device memory in use by direct instance layers
+	zest_compute_handle layer_cull_compute;	//Created the first time a layer enables GPU culling
 
 	//Default images for unbound descriptor indexes
 	zest_image default_image_2d;
@@ -7131,6 +8357,7 @@ typedef struct zest_device_t {
 
 	//Threading
 	zest_uint thread_count;
+	zest_job_system_t *job_system;
 
 	//Slang
 	void *slang_info;
@@ -7156,6 +8383,62 @@ typedef struct zest_db_overlay_t {
 	zest_uint index_count;
 } zest_db_overlay_t;
 
+//Everything the backend needs to record a readback copy
+typedef struct zest_readback_copy_t {
+	zest_image image;                   //Source image, or 0 when reading back a buffer
+	zest_image_layout image_layout;     //Layout that the image is in when the copy is recorded
+	zest_image_readback_region_t region;
+	zest_buffer buffer;                 //Source buffer, or 0 when reading back an image
+	zest_size buffer_offset;
+	zest_size ring_offset;              //Where the copy lands in the readback ring
+	zest_size size;
+} zest_readback_copy_t;
+
+typedef struct zest_readback_t {
+	zest_readback_ticket ticket;
+	zest_size ring_offset;
+	zest_size size;
+	zest_execution_timeline timeline;   //0 until the frame graph that recorded the copy has been submitted
+	zest_u64 timeline_value;            //The copy is done once the timeline reaches this value
+	zest_readback_callback callback;
+	void *user_data;
+} zest_readback_t;
+
+//Task data for readback passes, allocated with the frame graph so that it lives as long as a cached graph does
+typedef struct zest_readback_pass_t {
+	zest_resource_node resource;
+	zest_image_readback_region_t region;
+	zest_size buffer_offset;
+	zest_size size;
+	zest_readback_callback callback;
+	void *user_data;
+} zest_readback_pass_t;
+
+//Task data for the virtual texture passes, allocated with the frame graph
+typedef struct zest_virtual_texture_pass_t {
+	zest_virtual_texture virtual_texture;
+	zest_virtual_texture_resources_t resources;
+	zest_readback_pass_t readback;      //Only used by the feedback pass
+} zest_virtual_texture_pass_t;
+
+typedef struct zest_readback_ring_t {
+	zest_buffer buffer;                 //Host cached, created the first time that something is read back
+	zest_size size;
+	zest_size head;
+	zest_size tail;
+	zest_readback_t *pending;           //Oldest first
+	zest_uint pending_start;            //First entry in pending whose callback hasn't fired
+	zest_readback_ticket next_ticket;
+	zest_readback_ticket completed_ticket;
+	zest_execution_timeline timeline;   //Signalled by standalone readbacks
+	zest_readback_backend backend;
+	zest_u64 submit_values[ZEST_READBACK_SUBMITS_IN_FLIGHT];	//Timeline value at which each standalone command buffer is free again
+	zest_uint next_submit;
+	zest_u64 total_readbacks;
+	zest_u64 total_bytes;
+	zest_uint ring_full_count;
+} zest_readback_ring_t;
+
 typedef struct zest_context_t {
 	int magic;
 
@@ -7203,6 +8486,7 @@ typedef struct zest_context_t {
 	void *memory_pools[ZEST_MAX_DEVICE_MEMORY_POOLS];
 	zest_size memory_pool_sizes[ZEST_MAX_DEVICE_MEMORY_POOLS];
 	zest_uint memory_pool_count;
+	volatile zloc_thread_access pool_growth_access;		//Held while a pool is added, see zest__lock_pool_growth
 	zloc_allocator *allocator;
 	zest_resource_store_t resource_stores[zest_max_context_handle_type];
 	zest_context_destruction_queue_t deferred_resource_freeing_list;
@@ -7211,11 +8495,25 @@ typedef struct zest_context_t {
 	//GPU buffer allocation
 	zest_map_buffer_allocators buffer_allocators;
 
-	//Cached pipelines
-	zest_map_cached_pipelines cached_pipelines;
+	//Cached pipelines (zest_pipeline values), keyed by zest__pipeline_cache_key
+	zest_map_t cached_pipelines;
+	//Pipelines being compiled on the job system, moved in to cached_pipelines once they're finished
+	zest_map_pipeline_requests pipeline_requests;
+	zest_job_counter_t pipeline_jobs;
+	//While pass groups are being recorded on worker threads (zest_context_flag_recording_in_parallel)
+	//recording_sync guards the state that pass callbacks share: the pipeline cache, bindless descriptor
+	//updates and the deferred release lists. linear_allocator_sync guards the frame graph linear
+	//allocators and is never held while taking another lock.
+	zest_sync_t recording_sync;
+	zest_sync_t linear_allocator_sync;
 
 	//Frame Graph Cache Storage
 	zest_map_cached_frame_graphs cached_frame_graphs;
+	zest_frame_graph_cache_stats_t frame_graph_cache_stats;
+	zest_u64 frame_graph_cache_tick;
+	//Graphs with a cache key are built in a block of their own this size so that caching them only
+	//has to promote that block. It grows when a graph doesn't fit so that it can be cached next time.
+	zest_size frame_graph_block_size;
 	//Transient memory arenas shared by all graphs on this context. Every graph checks arenas out
 	//for the duration of one execution and returns them FIF-deferred; cached graphs keep only
 	//their image slots bound, detecting foreign reuse of the backing via backing ids.
@@ -7248,6 +8546,11 @@ typedef struct zest_context_t {
 	//be 0, so we cannot use 0 as an "uninitialised" sentinel or we would miss a real change.
 	zest_u64 last_queue_layout_signature;
 	zest_bool has_queue_layout_signature;
+	//Copy of the timings of the last frame graph executed in this context. Graphs live in frame
+	//memory so this is the only way to get at them once a command graph has been flushed.
+	zest_frame_graph_timings_t last_frame_graph_timings;
+	//GPU to CPU copies waiting for their callbacks, see zest_PollReadbacks
+	zest_readback_ring_t readbacks;
 } zest_context_t;
 
 typedef struct zest_pipeline_layout_t {
@@ -7332,8 +8635,23 @@ typedef struct zest_pass_group_t {
 
 zest_hash_map(zest_pass_group_t) zest_map_passes;
 zest_hash_map(zest_resource_versions_t) zest_map_resource_versions;
-zest_hash_map(zest_resource_node) zest_map_resources;
 zest_hash_map(zest_key) zest_map_imported_resource;
+//Used when partitioning a batch for parallel recording: resource node -> first pass group that uses it
+zest_hash_map(zest_uint) zest_map_resource_owners;
+
+//One unit of work when a submission batch is recorded in parallel. Each task records a run of pass groups
+//that share resources, in execution order, each into its own command list in frame_graph->batch_command_lists.
+typedef struct zest_pass_group_recording_t {
+	zest_context context;
+	zest_frame_graph frame_graph;
+	zest_frame_graph_builder builder;		//The dispatching thread's builder, shared with the workers
+	zest_submission_batch_t *batch;
+	zest_uint slot;							//Worker command pool to record with, unique within the dispatch
+	zest_uint *group_positions;				//Positions in batch->pass_indices
+	zest_uint *gpu_profile_query_indexes;	//Reserved up front as the profiler is not thread safe
+	zest_bool *gpu_profile_active;
+	zest_bool failed;
+} zest_pass_group_recording_t;
 
 typedef struct zest_frame_graph_semaphores_t {
 	int magic;
@@ -7348,13 +8666,14 @@ typedef struct zest_frame_graph_t {
 	zest_uint culled_passes_count;
 	zest_uint culled_resources_count;
 	const char *name;
+	zest_frame_graph_timings_t timings;
 
 	zest_bucket_array_t potential_passes;
 	zest_map_passes final_passes;
 	zest_bucket_array_t resources;
 	//For detecting resources with the same name - enforced in all builds because name-based identity
 	//(pass maps and the zest_GetPass*Resource callbacks) requires uniqueness to stay correct.
-	zest_map_resources resource_names;
+	zest_map_t resource_names;				//zest_resource_node by name, used to catch duplicate names
 #ifdef ZEST_DEBUGGING
 	zest_map_imported_resource imported_resources;
 #endif
@@ -7392,8 +8711,14 @@ typedef struct zest_frame_graph_t {
 
 	void *user_data;
 	zest_command_list_t command_list;
+	//When a batch was recorded in parallel this holds a command list per pass group in execution
+	//order and these are submitted instead of command_list. Reset for every batch.
+	zest_command_list_t *batch_command_lists;
 	zest_key cache_key;
 	zest_size cached_size;
+	//Hash of the pass and resource declarations that decide the compiled structure, taken before
+	//compiling. Graphs with the same structure hash only differ by sizes, callbacks and the like.
+	zest_key structure_hash;
 
 	zest_uint timestamp_count;
 	zest_query_state query_state[ZEST_MAX_FIF];                      //For checking if the timestamp query is ready
@@ -7487,6 +8812,29 @@ typedef struct zest_shader_t {
 	zest_compute *dependent_computes;                //Compute pipelines that reference this shader (vec)
 } zest_shader_t;
 
+//One unique shader in a zest_CreateShaders batch. The compile step runs on a job thread and may only read
+//the shader's code, name and type and the options. result is backend owned until finish_shader_job.
+typedef struct zest_shader_compile_job_t {
+	zest_shader shader;
+	zest_shader_options options;
+	void *result;
+	zest_microsecs compile_time;
+	zest_bool succeeded;
+} zest_shader_compile_job_t;
+
+typedef struct zest_shader_batch_t {
+	zest_device device;
+	zest_shader_compile_job_t *jobs;
+	zest_uint job_count;
+	volatile int next_job;
+} zest_shader_batch_t;
+
+//Each job system job gets its own compiler so that two compiles never share one
+typedef struct zest_shader_batch_slot_t {
+	zest_shader_batch_t *batch;
+	zest_uint compiler_index;
+} zest_shader_batch_slot_t;
+
 typedef struct zest_sampler_t {
 	int magic;
 	zest_sampler_handle handle;
@@ -7526,6 +8874,101 @@ typedef struct zest_image_view_t {
 
 static const zest_image_t zest__image_zero = { 0 };
 
+typedef struct zest_image_stream_request_t {
+	zest_image image;
+	zest_size ring_offset;              //Offset of the pixels from the start of the staging ring
+	zest_size size;
+	zest_stream_ticket ticket;
+} zest_image_stream_request_t;
+
+typedef struct zest_image_stream_batch_t {
+	zest_uint index;                    //Slot in the streamer, used by the backend to pick command buffers
+	zest_uint request_count;
+	zest_size bytes;
+	zest_size ring_end;                 //The ring tail moves here once the batch is done
+	zest_stream_ticket last_ticket;
+	zest_u64 timeline_value;            //Value the streamer timeline reaches when the batch is done
+} zest_image_stream_batch_t;
+
+typedef struct zest_image_streamer_t {
+	int magic;
+	zest_device device;
+	zest_image_streamer_backend backend;
+	zest_queue_manager transfer_manager;
+	zest_queue_manager graphics_manager;
+	zest_execution_timeline timeline;
+	zest_buffer staging_ring;
+	zest_size ring_size;
+	zest_size ring_head;
+	zest_size ring_tail;
+	zest_size frame_budget;
+	zest_image_stream_request_t *queued_uploads;
+	zest_uint queued_start;             //First entry in queued_uploads that hasn't been submitted
+	zest_uint outstanding_uploads;
+	zest_image_stream_batch_t batches[ZEST_STREAM_BATCHES_IN_FLIGHT];
+	zest_uint oldest_batch;
+	zest_uint batches_in_flight;
+	zest_stream_ticket next_ticket;
+	zest_stream_ticket completed_ticket;
+	zest_u64 total_uploads;
+	zest_u64 total_bytes;
+	zest_size last_update_bytes;
+	zest_uint ring_full_count;
+} zest_image_streamer_t;
+
+typedef struct zest_virtual_page_slot_t {
+	zest_uint page;                     //Flat index of the virtual page in the slot, ZEST_INVALID when it's free
+	zest_uint prev;                     //Least recently used list, ZEST_INVALID at either end
+	zest_uint next;
+	zest_u64 last_used;                 //Feedback serial that last asked for the page
+	zest_bool pinned;                   //Pages of the coarsest mip level are never evicted
+} zest_virtual_page_slot_t;
+
+typedef struct zest_virtual_page_upload_t {
+	zest_uint slot;
+	zest_size staging_offset;           //Offset of the page from the start of the frame's staging space
+} zest_virtual_page_upload_t;
+
+typedef struct zest_virtual_texture_t {
+	int magic;
+	zest_context context;
+	zest_virtual_texture_info_t info;
+	zest_image_handle page_table;       //One texel per page and one mip level per virtual mip level
+	zest_image_handle page_cache;
+	zest_buffer feedback;               //One zest_uint per page, non zero when a shader asked for the page
+	zest_buffer staging;                //Pages and the page table for each frame in flight
+	zest_size page_bytes;               //Size of one page including its border
+	zest_size page_stride;              //Space that each page takes up in the staging buffer
+	zest_size page_table_offset;        //Offset of the page table in each frame's staging space
+	zest_size frame_staging_size;
+	zest_uint slot_size;                //page_size + 2 * page_border
+	zest_uint pages_x;
+	zest_uint pages_y;
+	zest_uint mip_count;
+	zest_uint mip_offsets[ZEST_MAX_VIRTUAL_TEXTURE_MIPS + 1];	//Flat index of the first page of each mip level
+	zest_uint total_pages;
+	zest_uint *page_slots;              //Cache slot of every virtual page or ZEST_INVALID
+	zest_uint *page_table_texels;       //CPU copy of every mip level of the page table
+	zest_byte *needed;                  //Scratch for working out which pages the feedback asks for
+	zest_virtual_page_slot_t *slots;
+	zest_uint *free_slots;
+	zest_uint lru_head;                 //Least recently used, evicted first
+	zest_uint lru_tail;
+	zest_uint *requests;                //Missing pages from the latest feedback, coarsest mip level first
+	zest_uint request_start;            //First entry in requests that hasn't been looked at
+	zest_u64 feedback_serial;
+	zest_bool page_table_dirty;
+	zest_virtual_page_upload_t *uploads[ZEST_MAX_FIF];
+	zest_bool upload_page_table[ZEST_MAX_FIF];
+	zest_virtual_texture_shader_info_t shader_info;
+	zest_uint resident_pages;
+	zest_uint visible_pages;
+	zest_uint last_update_loads;
+	zest_u64 total_loads;
+	zest_u64 total_evictions;
+	zest_uint cache_full_count;
+} zest_virtual_texture_t;
+
 typedef struct zest_swapchain_t {
 	int magic;
 	zest_context context;
@@ -7679,8 +9122,50 @@ typedef struct zest_mesh_offset_data_t {
 	zest_uint vertex_count;
 	zest_uint index_count;
 	zest_uint texture_index;
+	float cull_radius;						//See zest_SetLayerMeshBounds, negative if the mesh isn't culled
+	zest_bool is_free;						//The mesh was removed, see zest_RemoveMeshFromLayer
 } zest_mesh_offset_data_t;
 
+//A range of vertices or indexes in an instance mesh layer's buffers
+typedef struct zest_mesh_pool_range_t {
+	zest_uint offset;
+	zest_uint count;
+} zest_mesh_pool_range_t;
+
+//A chain of meshes in an instance mesh layer from the most to the least detailed, see zest_AddLayerMeshLODChain
+typedef struct zest_mesh_lod_level_t {
+	zest_uint mesh_index;
+	float min_screen_size;
+} zest_mesh_lod_level_t;
+
+typedef struct zest_mesh_lod_chain_t {
+	zest_mesh_lod_level_t levels[ZEST_MAX_MESH_LODS];
+	zest_uint level_count;
+} zest_mesh_lod_chain_t;
+
+typedef struct zest_mesh_pool_free_t {
+	zest_mesh_pool_range_t vertices;
+	zest_mesh_pool_range_t indexes;
+	zest_uint frame;						//Device frame it was freed on
+} zest_mesh_pool_free_t;
+
+//A mesh being copied down in to a gap by zest_DefragmentLayerMeshes
+typedef struct zest_mesh_pool_move_t {
+	zest_uint mesh_index;
+	zest_mesh_pool_range_t from;
+	zest_uint to;
+	zest_bool indexes;						//Move in the index buffer rather than the vertex buffer
+} zest_mesh_pool_move_t;
+
+//Collects the instances written by one thread so that several threads can fill a layer at once, see
+//zest_BeginParallelInstances
+typedef struct zest_instance_writer_t {
+	zest_layer layer;
+	zest_byte *data;
+	zest_size capacity;
+	zest_uint instance_count;
+} zest_instance_writer_t;
+
 typedef struct zest_layer_t {
 	int magic;
 	zest_layer_handle handle;
@@ -7703,6 +9188,21 @@ typedef struct zest_layer_t {
 	zest_size used_vertex_data;
 	zest_size used_index_data;
 	zest_mesh_offset_data_t *mesh_offsets;
+	zest_mesh_pool_range_t *free_vertex_ranges;	//zest_vec of gaps left by removed meshes, sorted by offset
+	zest_mesh_pool_range_t *free_index_ranges;
+	zest_mesh_pool_free_t *pending_mesh_frees;	//Ranges waiting for the frames in flight to be done with them
+	zest_mesh_pool_move_t *mesh_moves;			//Copies planned by zest_DefragmentLayerMeshes for the defragment pass
+	zest_bool mesh_moves_recorded;				//The defragment pass has recorded the copies in mesh_moves
+	zest_uint mesh_moves_frame;					//Device frame the copies were recorded on
+	zest_uint *free_mesh_indexes;
+	zest_size mesh_vertex_struct_size;
+	//Mesh LODs, see zest_EnableLayerMeshLODs
+	zest_mesh_lod_chain_t *lod_chains;
+	zest_vec4 lod_view;							//xyz is where LODs are picked from and w is the lod_scale
+	zest_bool lod_drawing;						//The current instruction was started with zest_StartInstanceMeshLODDrawing
+	zest_uint lod_chain;
+	zest_uint *lod_levels;						//Scratch for sorting instances in to levels on the CPU
+	zest_byte *lod_scratch;
 
 	zest_layer_instruction_t current_instruction;
 
@@ -7725,6 +9225,31 @@ typedef struct zest_layer_t {
 	zest_uint instruction_index;
 	zest_draw_mode last_draw_mode;
 
+	zest_size delta_page_size;
+	zest_size last_upload_size;
+	zest_size direct_memory_size;			//Host visible device memory reserved by a direct layer
+	zest_instance_writer_t *instance_writers;	//zest_vec, kept between frames so the writers' memory is reused
+	zest_uint instance_writer_count;			//Writers in use since the last zest_BeginParallelInstances
+	zest_uint push_constant_size;				//Largest push constant size set on the layer, only this much is sent when drawing
+	zest_layer_draw_stats_t draw_stats;
+
+	//GPU culling, see zest_EnableLayerGPUCulling
+	zest_layer_cull_view_t cull_view;
+	zest_uint cull_position_offset;				//Also where LODs read the position and scale from
+	zest_uint cull_scale_offset;
+	const char *cull_hiz_name;
+	zest_frame_graph cull_frame_graph;			//The frame graph that last executed the layer's cull pass
+	zest_resource_node culled_instances_node;
+	zest_resource_node cull_commands_node;
+
+	//Persistent instance store, see zest_EnableInstanceStore. Instances are kept packed at the start of the
+	//buffer and ids point to their slots so that removing one only moves the last instance in to its place.
+	zest_uint *store_slots;						//zest_vec, the slot of each id or ZEST_INVALID if the id is free
+	zest_uint *store_generations;				//zest_vec, bumped each time an id is freed so that old ids are spotted
+	zest_uint *store_ids;						//zest_vec, the id index of the instance in each slot
+	zest_uint *store_free_ids;					//zest_vec, id indexes that can be used again
+	zest_layer_instruction_t store_instruction;
+
 	zest_resource_node vertex_buffer_node;
 	zest_resource_node index_buffer_node;
 
@@ -7855,6 +9380,14 @@ zest_microsecs zest_Microsecs(void) {
 }
 #endif
 
+//Returns the time since lap_start and moves lap_start on to now, for timing consecutive phases
+zest_microsecs zest__lap_microsecs(zest_microsecs *lap_start) {
+	zest_microsecs now = zest_Microsecs();
+	zest_microsecs elapsed = now - *lap_start;
+	*lap_start = now;
+	return elapsed;
+}
+
 #ifdef _WIN32
 FILE* zest__open_file(const char* file_name, const char* mode) {
     FILE* file = NULL;
@@ -8873,6 +10406,8 @@ zest_context zest_CreateContext(zest_device device, zest_window_data_t *window_d
 	context->magic = zest_INIT_MAGIC(zest_struct_type_context);
 
 	context->device = device;
+	zest__sync_init(&context->recording_sync);
+	zest__sync_init(&context->linear_allocator_sync);
 
 	context->create_info = *info;
     context->fence_wait_timeout_ns = info->semaphore_wait_timeout_ms * 1000 * 1000;
@@ -9010,6 +10545,21 @@ void zest_DeviceBuilderCacheShaders(zest_device_builder builder) {
 	ZEST__FLAG(builder->flags, zest_device_init_flag_cache_shaders);
 }
 
+void zest_DeviceBuilderCachePipelines(zest_device_builder builder) {
+	ZEST_ASSERT_HANDLE(builder);	//Not a valid zest_device_builder handle. Make sure you call zest_Begin[Platform]DeviceBuilder
+	ZEST__FLAG(builder->flags, zest_device_init_flag_cache_pipelines);
+}
+
+void zest_DeviceBuilderThreadAllocatorCaches(zest_device_builder builder) {
+	ZEST_ASSERT_HANDLE(builder);	//Not a valid zest_device_builder handle. Make sure you call zest_Begin[Platform]DeviceBuilder
+	ZEST__FLAG(builder->flags, zest_device_init_flag_thread_allocator_caches);
+}
+
+void zest_SetDeviceBuilderThreadCount(zest_device_builder builder, zest_uint thread_count) {
+	ZEST_ASSERT_HANDLE(builder);	//Not a valid zest_device_builder handle. Make sure you call zest_Begin[Platform]DeviceBuilder
+	builder->thread_count = ZEST__MIN(thread_count, ZEST_MAX_THREADS);
+}
+
 zest_device zest_EndDeviceBuilder(zest_device_builder builder) {
 	ZEST_ASSERT_HANDLE(builder);	//Not a valid zest_device_builder handle. Make sure you call zest_Begin[Platform]DeviceBuilder
 
@@ -9334,6 +10884,8 @@ zest_bool zest_BeginFrame(zest_context context) {
 	}
 
 	zest__do_context_scheduled_tasks(context);
+	//The frame in flight wait above retires the readbacks made by the frame graph that last used this slot
+	zest_PollReadbacks(context);
 	ZEST_CPU_PROFILE_END(context);
 
 	if (ZEST__FLAGGED(context->flags, zest_context_flag_gpu_profiling_enabled)) {
@@ -9737,6 +11289,14 @@ void zest__set_default_pool_sizes(zest_device device) {
 	usage.memory_pool_type = zest_memory_pool_type_buffers;
     zest_SetDevicePoolSize(device, "GPU Read Buffers (large)", usage, zloc__KILOBYTE(64), zloc__MEGABYTE(32));
 
+	//Host visible device memory is only used for direct instance layers. On devices without resizable
+	//BAR the heap is small (usually 256MB) so the pools are kept modest.
+    usage.property_flags = zest_memory_property_device_local_bit | zest_memory_property_host_visible_bit | zest_memory_property_host_coherent_bit;
+	usage.memory_pool_type = zest_memory_pool_type_small_buffers;
+    zest_SetDevicePoolSize(device, "Small Host Visible Device Buffers", usage, zloc__KILOBYTE(1), zloc__MEGABYTE(4));
+	usage.memory_pool_type = zest_memory_pool_type_buffers;
+    zest_SetDevicePoolSize(device, "Host Visible Device Buffers", usage, zloc__KILOBYTE(64), zloc__MEGABYTE(16));
+
     ZEST_APPEND_LOG(device->log_path.str, "Set device pool sizes");
 }
 
@@ -9746,6 +11306,9 @@ End of Device creation functions
 
 void zest__destroy_device(zest_device device) {
 	zest_WaitForIdleDevice(device);
+	if (ZEST__FLAGGED(device->init_flags, zest_device_init_flag_cache_pipelines)) {
+		zest_SavePipelineCache(device);
+	}
 	zest__cleanup_device(device);
 	if (device->live_timeline_count > 0) {
 		ZEST_ALERT("%i execution timeline%s created with zest_CreateExecutionTimeline %s never freed with zest_FreeExecutionTimeline. Each one holds a backend semaphore and a heap allocation for as long as the device lives.", device->live_timeline_count, device->live_timeline_count == 1 ? "" : "s", device->live_timeline_count == 1 ? "was" : "were");
@@ -9964,6 +11527,9 @@ const char *zest__memory_property_to_string(zest_memory_property_flags property_
 		case zest_memory_property_host_visible_bit | zest_memory_property_host_cached_bit: 
 			return "Host Visible, Host Cached"; 
 			break;
+		case zest_memory_property_device_local_bit | zest_memory_property_host_visible_bit | zest_memory_property_host_coherent_bit: 
+			return "Device Local, Host Visible, Host Coherent"; 
+			break;
 		default:
 			return "Unknown";
 	}
@@ -10066,67 +11632,475 @@ unsigned int zest_GetDefaultThreadCount(void) {
     return count > 1 ? count - 1 : 1;
 }
 
-// --Buffer & Memory Management
-void *zest_AllocateMemory(zest_device device, zest_size size) {
-    return ZEST__ALLOCATE_ALIGNED(device->allocator, size, 16);
+#ifdef _WIN32
+static unsigned __stdcall zest__job_thread(void *data) {
+#else
+static void *zest__job_thread(void *data) {
+#endif
+	zest_job_worker_t *worker = (zest_job_worker_t*)data;
+	zest_job_system_t *jobs = worker->jobs;
+	zest__current_job_system = jobs;
+	zest__current_job_worker = worker->worker_index;
+	zest__current_cache_worker = jobs->allocator_caches ? worker : NULL;
+	for (;;) {
+		if (zest__run_next_job(jobs, worker->worker_index)) {
+			continue;
+		}
+		//Nothing to do so sleep until more work is queued. queued is checked under the lock and pushes
+		//signal under the lock after bumping it, so a push can't slip in between the check and the wait.
+		zest__sync_lock(&jobs->sync);
+		while (zest__atomic_load(&jobs->queued) == 0 && !jobs->shutdown) {
+			zest__sync_wait_full(&jobs->sync);
+		}
+		zest_bool shutdown = jobs->shutdown;
+		zest__sync_unlock(&jobs->sync);
+		if (shutdown) break;
+	}
+	zest__current_job_system = NULL;
+	zest__current_job_worker = 0;
+	zest__current_cache_worker = NULL;
+	return 0;
 }
 
-void zest_FreeMemory(zest_device device, void *allocation) {
-    ZEST__FREE(device->allocator, allocation);
+zest_job_system_t *zest__get_job_system(zest_device device) {
+	if (device->job_system) {
+		return device->job_system;
+	}
+	zest_uint thread_count = ZEST__MIN(device->thread_count, ZEST_MAX_THREADS);
+	if (thread_count == 0) {
+		return NULL;
+	}
+	zest_job_system_t *jobs = (zest_job_system_t*)ZEST__ALLOCATE(device->allocator, sizeof(zest_job_system_t));
+	memset(jobs, 0, sizeof(zest_job_system_t));
+	jobs->deques = (zest_job_deque_t*)ZEST__ALLOCATE(device->allocator, sizeof(zest_job_deque_t) * (thread_count + 1));
+	memset(jobs->deques, 0, sizeof(zest_job_deque_t) * (thread_count + 1));
+	jobs->deque_count = thread_count + 1;
+	jobs->allocator_caches = ZEST__FLAGGED(device->init_flags, zest_device_init_flag_thread_allocator_caches);
+	zest__sync_init(&jobs->sync);
+	for (zest_uint i = 0; i != jobs->deque_count; ++i) {
+		zest__sync_init(&jobs->deques[i].sync);
+	}
+	device->job_system = jobs;
+	for (zest_uint i = 0; i != thread_count; ++i) {
+		zest_job_worker_t *worker = &jobs->workers[i];
+		worker->jobs = jobs;
+		worker->worker_index = i + 1;
+		//thread_count is bumped before the thread starts so that a new thread stealing from the other
+		//deques never sees a count that doesn't include itself. It's put back if the thread fails.
+		jobs->thread_count++;
+		#ifdef _WIN32
+		uintptr_t handle = _beginthreadex(NULL, 0, zest__job_thread, worker, 0, NULL);
+		if (handle == 0) { jobs->thread_count--; break; }
+		jobs->threads[i] = (HANDLE)handle;
+		#else
+		if (pthread_create(&jobs->threads[i], NULL, zest__job_thread, worker) != 0) { jobs->thread_count--; break; }
+		#endif
+	}
+	if (jobs->thread_count == 0) {
+		ZEST_REPORT(device, zest_report_memory, "Unable to start any job system threads, jobs will run on the calling thread.");
+		zest__destroy_job_system(device);
+		device->thread_count = 0;
+		return NULL;
+	}
+	return jobs;
 }
 
-void* zest__allocate_aligned(zloc_allocator *allocator, zest_size size, zest_size alignment) {
-    void* allocation = zloc_AllocateAligned(allocator, size, alignment);
-	/*
-	ptrdiff_t offset_from_allocator = (ptrdiff_t)allocation - (ptrdiff_t)allocator;
-	zloc_header *block = zloc__block_from_allocation(allocation);
-	if (offset_from_allocator == 30681568 && block->size == 72) {
-		int d = 0;
+void zest__destroy_job_system(zest_device device) {
+	zest_job_system_t *jobs = device->job_system;
+	if (!jobs) return;
+	zest__sync_lock(&jobs->sync);
+	jobs->shutdown = 1;
+	zest__sync_broadcast_full(&jobs->sync);
+	zest__sync_broadcast_empty(&jobs->sync);
+	zest__sync_unlock(&jobs->sync);
+	for (zest_uint i = 0; i != jobs->thread_count; ++i) {
+		#ifdef _WIN32
+		WaitForSingleObject(jobs->threads[i], INFINITE);
+		CloseHandle(jobs->threads[i]);
+		#else
+		pthread_join(jobs->threads[i], NULL);
+		#endif
 	}
-	*/
-    if (!allocation) {
-		zest__add_memory_pool(allocator, size);
-        allocation = zloc_AllocateAligned(allocator, size, alignment);
-        ZEST_ASSERT(allocation);    //Unable to allocate even after adding a pool
-    }
-    return allocation;
+	for (zest_uint i = 0; i != jobs->deque_count; ++i) {
+		zest__sync_cleanup(&jobs->deques[i].sync);
+	}
+	zest__sync_cleanup(&jobs->sync);
+	ZEST__FREE(device->allocator, jobs->deques);
+	ZEST__FREE(device->allocator, jobs);
+	device->job_system = NULL;
 }
 
-void zest__add_memory_pool(zloc_allocator *allocator, zest_size requested_size) {
-	void *user_data = (zest_device)allocator->user_data;
-	zest_struct_type struct_type = ZEST_STRUCT_TYPE(user_data);
-	zest_size min_pool_size = zest_GetNextPower(requested_size);
-	switch (struct_type) {
-		case zest_struct_type_device: {
-			zest_device device = (zest_device)allocator->user_data;
-			zest_size pool_size = ZEST__MAX(device->setup_info.memory_pool_size, min_pool_size);
-			if (ZEST__FLAGGED(device->init_flags, zest_device_init_flag_output_memory_pool_info)) {
-				ZEST_REPORT(device, zest_report_memory, "Adding a new device memory pool of size %llu", pool_size);
-			}
-			zest__add_host_memory_pool(device, pool_size);
-			break;
-		}
-		case zest_struct_type_context: {
-			zest_context context = (zest_context)allocator->user_data;
-			zest_size pool_size = ZEST__MAX(context->create_info.memory_pool_size, min_pool_size);
-			if (ZEST__FLAGGED(context->device->init_flags, zest_device_init_flag_output_memory_pool_info)) {
-				ZEST_REPORT(context->device, zest_report_memory, "Adding a new context memory pool of size %llu", pool_size);
-			}
-			zest__add_context_memory_pool(context, pool_size);
-			break;
-		}
-		default:
-			break;
+zest_uint zest__job_worker_index(zest_job_system_t *jobs) {
+	return zest__current_job_system == jobs ? zest__current_job_worker : 0;
+}
+
+zest_bool zest__push_job(zest_job_system_t *jobs, zest_uint worker_index, zest_job_entry_t *entry) {
+	zest_job_deque_t *deque = &jobs->deques[worker_index];
+	zest__sync_lock(&deque->sync);
+	if (deque->bottom - deque->top >= ZEST_JOB_DEQUE_SIZE) {
+		zest__sync_unlock(&deque->sync);
+		return ZEST_FALSE;
 	}
+	deque->entries[deque->bottom % ZEST_JOB_DEQUE_SIZE] = *entry;
+	deque->bottom++;
+	zest__sync_unlock(&deque->sync);
+	zest__atomic_fetch_add(&jobs->queued, 1);
+	return ZEST_TRUE;
 }
 
-void zest__add_host_memory_pool(zest_device device, zest_size size) {
-	ZEST_ASSERT(device->memory_pool_count < 32);    //Reached the max number of memory pools
-	zest_size pool_size = device->setup_info.memory_pool_size;
-	if (pool_size <= size) {
-		pool_size = zest_GetNextPower(size);
+zest_bool zest__pop_job(zest_job_deque_t *deque, zest_job_entry_t *entry) {
+	zest__sync_lock(&deque->sync);
+	if (deque->bottom == deque->top) {
+		zest__sync_unlock(&deque->sync);
+		return ZEST_FALSE;
 	}
-	device->memory_pools[device->memory_pool_count] = ZEST__ALLOCATE_POOL(pool_size);
+	deque->bottom--;
+	*entry = deque->entries[deque->bottom % ZEST_JOB_DEQUE_SIZE];
+	zest__sync_unlock(&deque->sync);
+	return ZEST_TRUE;
+}
+
+zest_bool zest__steal_job(zest_job_deque_t *deque, zest_job_entry_t *entry) {
+	zest__sync_lock(&deque->sync);
+	if (deque->bottom == deque->top) {
+		zest__sync_unlock(&deque->sync);
+		return ZEST_FALSE;
+	}
+	*entry = deque->entries[deque->top % ZEST_JOB_DEQUE_SIZE];
+	deque->top++;
+	zest__sync_unlock(&deque->sync);
+	return ZEST_TRUE;
+}
+
+void zest__execute_job(zest_job_system_t *jobs, zest_job_entry_t *entry, zest_uint worker_index) {
+	entry->callback(entry->data, worker_index);
+	if (zest__current_cache_worker && zest__current_cache_worker->jobs == jobs) {
+		//Flush before the counter drops so that once zest_WaitJobs returns nothing is left cached for the
+		//caller to trip over, eg. when freeing a context straight after.
+		zest__flush_thread_caches(zest__current_cache_worker);
+	}
+	if (entry->counter && zest__atomic_fetch_add(&entry->counter->pending, -1) == 1) {
+		//Wake anything in zest_WaitJobs. They all recheck their own counter so a broadcast is fine.
+		zest__sync_lock(&jobs->sync);
+		zest__sync_broadcast_empty(&jobs->sync);
+		zest__sync_unlock(&jobs->sync);
+	}
+}
+
+zest_bool zest__run_next_job(zest_job_system_t *jobs, zest_uint worker_index) {
+	if (zest__atomic_load(&jobs->queued) == 0) {
+		return ZEST_FALSE;
+	}
+	zest_job_entry_t entry;
+	zest_bool found = zest__pop_job(&jobs->deques[worker_index], &entry);
+	zest_uint deque_count = jobs->thread_count + 1;
+	for (zest_uint i = 1; !found && i != deque_count; ++i) {
+		found = zest__steal_job(&jobs->deques[(worker_index + i) % deque_count], &entry);
+	}
+	if (!found) {
+		return ZEST_FALSE;
+	}
+	zest__atomic_fetch_add(&jobs->queued, -1);
+	zest__execute_job(jobs, &entry, worker_index);
+	return ZEST_TRUE;
+}
+
+void zest_RunJobs(zest_device device, const zest_job_t *jobs, zest_uint job_count, zest_job_counter_t *counter) {
+	ZEST_ASSERT_HANDLE(device);		//Not a valid device handle
+	ZEST_ASSERT(counter);			//You must pass a counter to wait on
+	if (!job_count) return;
+	zest_job_system_t *job_system = zest__get_job_system(device);
+	if (!job_system) {
+		for (zest_uint i = 0; i != job_count; ++i) {
+			jobs[i].callback(jobs[i].data, 0);
+		}
+		return;
+	}
+	zest_uint worker_index = zest__job_worker_index(job_system);
+	//Count everything up front so that a job finishing early can't take the counter to zero while the
+	//rest are still being queued.
+	zest__atomic_fetch_add(&counter->pending, (int)job_count);
+	zest_uint queued = 0;
+	for (zest_uint i = 0; i != job_count; ++i) {
+		zest_job_entry_t entry = { jobs[i].callback, jobs[i].data, counter };
+		if (zest__push_job(job_system, worker_index, &entry)) {
+			queued++;
+		} else {
+			zest__execute_job(job_system, &entry, worker_index);
+		}
+	}
+	if (queued) {
+		zest__sync_lock(&job_system->sync);
+		if (queued > 1) {
+			zest__sync_broadcast_full(&job_system->sync);
+		} else {
+			zest__sync_signal_full(&job_system->sync);
+		}
+		zest__sync_broadcast_empty(&job_system->sync);
+		zest__sync_unlock(&job_system->sync);
+	}
+}
+
+void zest_WaitJobs(zest_device device, zest_job_counter_t *counter) {
+	ZEST_ASSERT_HANDLE(device);		//Not a valid device handle
+	ZEST_ASSERT(counter);			//You must pass the counter that was passed to zest_RunJobs
+	zest_job_system_t *jobs = device->job_system;
+	if (!jobs) {
+		//Without a job system zest_RunJobs runs everything straight away.
+		return;
+	}
+	zest_uint worker_index = zest__job_worker_index(jobs);
+	while (zest__atomic_load(&counter->pending) > 0) {
+		if (zest__run_next_job(jobs, worker_index)) {
+			continue;
+		}
+		//The remaining jobs are running on other threads. Sleep until one of them finishes or more work
+		//is queued that this thread can help with.
+		zest__sync_lock(&jobs->sync);
+		while (zest__atomic_load(&counter->pending) > 0 && zest__atomic_load(&jobs->queued) == 0 && !jobs->shutdown) {
+			zest__sync_wait_empty(&jobs->sync);
+		}
+		zest__sync_unlock(&jobs->sync);
+	}
+}
+
+typedef struct zest_parallel_for_t {
+	zest_parallel_for_callback callback;
+	void *data;
+	zest_uint count;
+	zest_uint batch_size;
+	volatile int next_batch;
+} zest_parallel_for_t;
+
+ZEST_PRIVATE void zest__parallel_for_job(void *data, zest_uint worker_index) {
+	zest_parallel_for_t *parallel_for = (zest_parallel_for_t*)data;
+	zest_uint batch_count = (parallel_for->count + parallel_for->batch_size - 1) / parallel_for->batch_size;
+	for (;;) {
+		zest_uint batch = (zest_uint)zest__atomic_fetch_add(&parallel_for->next_batch, 1);
+		if (batch >= batch_count) break;
+		zest_uint begin = batch * parallel_for->batch_size;
+		zest_uint end = ZEST__MIN(begin + parallel_for->batch_size, parallel_for->count);
+		parallel_for->callback(parallel_for->data, begin, end, worker_index);
+	}
+}
+
+void zest_ParallelFor(zest_device device, zest_uint count, zest_uint batch_size, zest_parallel_for_callback callback, void *data) {
+	ZEST_ASSERT_HANDLE(device);		//Not a valid device handle
+	ZEST_ASSERT(callback);
+	if (!count) return;
+	zest_uint worker_count = zest_GetJobWorkerCount(device);
+	if (!batch_size) {
+		//A few batches per worker so that a slow batch doesn't leave the others idle at the end.
+		batch_size = ZEST__MAX(count / (worker_count * 4), 1u);
+	}
+	zest_parallel_for_t parallel_for = { callback, data, count, batch_size, 0 };
+	zest_uint batch_count = (count + batch_size - 1) / batch_size;
+	zest_uint job_count = ZEST__MIN(batch_count, worker_count);
+	if (job_count <= 1) {
+		zest__parallel_for_job(&parallel_for, zest_GetCurrentJobWorkerIndex(device));
+		return;
+	}
+	//Every job claims batches until there are none left, the calling thread takes part through zest_WaitJobs.
+	zest_job_t jobs[ZEST_MAX_THREADS + 1];
+	for (zest_uint i = 0; i != job_count; ++i) {
+		jobs[i].callback = zest__parallel_for_job;
+		jobs[i].data = &parallel_for;
+	}
+	zest_job_counter_t counter = ZEST__ZERO_INIT(zest_job_counter_t);
+	zest_RunJobs(device, jobs, job_count, &counter);
+	zest_WaitJobs(device, &counter);
+}
+
+zest_uint zest_GetJobWorkerCount(zest_device device) {
+	ZEST_ASSERT_HANDLE(device);		//Not a valid device handle
+	zest_job_system_t *jobs = zest__get_job_system(device);
+	return jobs ? jobs->thread_count + 1 : 1;
+}
+
+zest_uint zest_GetCurrentJobWorkerIndex(zest_device device) {
+	ZEST_ASSERT_HANDLE(device);		//Not a valid device handle
+	return device->job_system ? zest__job_worker_index(device->job_system) : 0;
+}
+
+zloc_thread_cache_t *zest__get_thread_cache(zloc_allocator *allocator) {
+	zest_job_worker_t *worker = zest__current_cache_worker;
+	if (!worker) return NULL;
+	for (int i = 0; i != ZEST_JOB_ALLOCATOR_CACHES; ++i) {
+		zloc_thread_cache_t *cache = &worker->allocator_caches[i];
+		if (cache->allocator == allocator) {
+			return cache;
+		}
+		if (!cache->allocator) {
+			zloc_InitialiseThreadCache(cache, allocator);
+			return cache;
+		}
+	}
+	return NULL;
+}
+
+void zest__add_thread_cache_stats(zloc_thread_cache_stats_t *total, const zloc_thread_cache_stats_t *stats) {
+	total->hits += stats->hits;
+	total->misses += stats->misses;
+	total->bypassed += stats->bypassed;
+	total->refills += stats->refills;
+	total->drains += stats->drains;
+	total->lock_acquisitions += stats->lock_acquisitions;
+	total->lock_spins += stats->lock_spins;
+}
+
+void zest__flush_thread_caches(zest_job_worker_t *worker) {
+	zloc_thread_cache_stats_t stats = ZEST__ZERO_INIT(zloc_thread_cache_stats_t);
+	zest_bool used = ZEST_FALSE;
+	for (int i = 0; i != ZEST_JOB_ALLOCATOR_CACHES; ++i) {
+		zloc_thread_cache_t *cache = &worker->allocator_caches[i];
+		if (!cache->allocator) break;
+		zloc_FlushThreadCache(cache);
+		zest__add_thread_cache_stats(&stats, &cache->stats);
+		//Unbind the slot as well, the next job may be working with a different context.
+		memset(cache, 0, sizeof(zloc_thread_cache_t));
+		used = ZEST_TRUE;
+	}
+	if (used) {
+		zest_job_deque_t *deque = &worker->jobs->deques[worker->worker_index];
+		zest__sync_lock(&deque->sync);
+		zest__add_thread_cache_stats(&worker->allocator_cache_stats, &stats);
+		zest__sync_unlock(&deque->sync);
+	}
+}
+
+zloc_thread_cache_stats_t zest_GetAllocatorCacheStats(zest_device device) {
+	ZEST_ASSERT_HANDLE(device);		//Not a valid device handle
+	zloc_thread_cache_stats_t total = ZEST__ZERO_INIT(zloc_thread_cache_stats_t);
+	zest_job_system_t *jobs = device->job_system;
+	if (!jobs) return total;
+	for (zest_uint i = 0; i != jobs->thread_count; ++i) {
+		zest_job_worker_t *worker = &jobs->workers[i];
+		zest_job_deque_t *deque = &jobs->deques[worker->worker_index];
+		zest__sync_lock(&deque->sync);
+		zest__add_thread_cache_stats(&total, &worker->allocator_cache_stats);
+		zest__sync_unlock(&deque->sync);
+	}
+	return total;
+}
+
+typedef struct zest_parallel_copy_t {
+	char *dst;
+	const char *src;
+	zest_size size;
+	zest_size chunk_size;
+} zest_parallel_copy_t;
+
+ZEST_PRIVATE void zest__parallel_copy_batch(void *data, zest_uint begin, zest_uint end, zest_uint worker_index) {
+	zest_parallel_copy_t *copy = (zest_parallel_copy_t*)data;
+	zest_size offset = (zest_size)begin * copy->chunk_size;
+	zest_size size = ZEST__MIN((zest_size)end * copy->chunk_size, copy->size) - offset;
+	memcpy(copy->dst + offset, copy->src + offset, size);
+}
+
+void zest__parallel_copy(zest_device device, void *dst, const void *src, zest_size size) {
+	//Below a few megabytes the cost of waking the workers outweighs the copy itself.
+	if (size < ZEST_PARALLEL_COPY_THRESHOLD || device->thread_count == 0) {
+		memcpy(dst, src, size);
+		return;
+	}
+	zest_parallel_copy_t copy = { (char*)dst, (const char*)src, size, ZEST_PARALLEL_COPY_CHUNK_SIZE };
+	zest_uint chunk_count = (zest_uint)((size + copy.chunk_size - 1) / copy.chunk_size);
+	zest_ParallelFor(device, chunk_count, 1, zest__parallel_copy_batch, &copy);
+}
+
+// --Buffer & Memory Management
+void *zest_AllocateMemory(zest_device device, zest_size size) {
+    return ZEST__ALLOCATE_ALIGNED(device->allocator, size, 16);
+}
+
+void zest_FreeMemory(zest_device device, void *allocation) {
+    ZEST__FREE(device->allocator, allocation);
+}
+
+void* zest__allocate_aligned(zloc_allocator *allocator, zest_size size, zest_size alignment) {
+    void* allocation = zloc_AllocateAligned(allocator, size, alignment);
+	/*
+	ptrdiff_t offset_from_allocator = (ptrdiff_t)allocation - (ptrdiff_t)allocator;
+	zloc_header *block = zloc__block_from_allocation(allocation);
+	if (offset_from_allocator == 30681568 && block->size == 72) {
+		int d = 0;
+	}
+	*/
+    if (!allocation) {
+		zest__lock_pool_growth(allocator);
+		//Another thread may have added a pool while this one was waiting for the lock
+		allocation = zloc_AllocateAligned(allocator, size, alignment);
+		if (!allocation) {
+			zest__add_memory_pool(allocator, size);
+			allocation = zloc_AllocateAligned(allocator, size, alignment);
+		}
+		zest__unlock_pool_growth(allocator);
+        ZEST_ASSERT(allocation);    //Unable to allocate even after adding a pool
+    }
+    return allocation;
+}
+
+//zloc locks each allocation but the pool arrays on the device and context are not covered by that, so
+//adding a pool is serialised here. Allocation failures are rare so a spin is enough.
+volatile zloc_thread_access *zest__pool_growth_access(zloc_allocator *allocator) {
+	void *user_data = allocator->user_data;
+	switch (ZEST_STRUCT_TYPE(user_data)) {
+		case zest_struct_type_device: return &((zest_device)user_data)->pool_growth_access;
+		case zest_struct_type_context: return &((zest_context)user_data)->pool_growth_access;
+		default: return NULL;
+	}
+}
+
+void zest__lock_pool_growth(zloc_allocator *allocator) {
+	#if defined(ZLOC_THREAD_SAFE)
+	volatile zloc_thread_access *access = zest__pool_growth_access(allocator);
+	if (!access) return;
+	while (0 != zloc__compare_and_exchange(access, 1, 0)) {}
+	#endif
+}
+
+void zest__unlock_pool_growth(zloc_allocator *allocator) {
+	#if defined(ZLOC_THREAD_SAFE)
+	volatile zloc_thread_access *access = zest__pool_growth_access(allocator);
+	if (access) *access = 0;
+	#endif
+}
+
+void zest__add_memory_pool(zloc_allocator *allocator, zest_size requested_size) {
+	void *user_data = (zest_device)allocator->user_data;
+	zest_struct_type struct_type = ZEST_STRUCT_TYPE(user_data);
+	zest_size min_pool_size = zest_GetNextPower(requested_size);
+	switch (struct_type) {
+		case zest_struct_type_device: {
+			zest_device device = (zest_device)allocator->user_data;
+			zest_size pool_size = ZEST__MAX(device->setup_info.memory_pool_size, min_pool_size);
+			if (ZEST__FLAGGED(device->init_flags, zest_device_init_flag_output_memory_pool_info)) {
+				ZEST_REPORT(device, zest_report_memory, "Adding a new device memory pool of size %llu", pool_size);
+			}
+			zest__add_host_memory_pool(device, pool_size);
+			break;
+		}
+		case zest_struct_type_context: {
+			zest_context context = (zest_context)allocator->user_data;
+			zest_size pool_size = ZEST__MAX(context->create_info.memory_pool_size, min_pool_size);
+			if (ZEST__FLAGGED(context->device->init_flags, zest_device_init_flag_output_memory_pool_info)) {
+				ZEST_REPORT(context->device, zest_report_memory, "Adding a new context memory pool of size %llu", pool_size);
+			}
+			zest__add_context_memory_pool(context, pool_size);
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+void zest__add_host_memory_pool(zest_device device, zest_size size) {
+	ZEST_ASSERT(device->memory_pool_count < 32);    //Reached the max number of memory pools
+	zest_size pool_size = device->setup_info.memory_pool_size;
+	if (pool_size <= size) {
+		pool_size = zest_GetNextPower(size);
+	}
+	device->memory_pools[device->memory_pool_count] = ZEST__ALLOCATE_POOL(pool_size);
 	ZEST_ASSERT(device->memory_pools[device->memory_pool_count], "Unable to allocate more memory for the device. Out of memory?");
 	zloc_AddPool(device->allocator, device->memory_pools[device->memory_pool_count], pool_size);
 	device->memory_pool_sizes[device->memory_pool_count] = pool_size;
@@ -10153,7 +12127,8 @@ void zest__add_context_memory_pool(zest_context context, zest_size size) {
 }
 
 void *zest__allocate(zloc_allocator *allocator, zest_size size) {
-	void* allocation = zloc_Allocate(allocator, size);
+	zloc_thread_cache_t *cache = zest__get_thread_cache(allocator);
+	void* allocation = cache ? zloc_CacheAllocate(cache, size) : zloc_Allocate(allocator, size);
 	// If there's something that isn't being freed on zest shutdown and it's of an unknown type then
 	// it should print out the offset from the allocator; compute (allocation - allocator) here and
 	// break on the offending offset to find out what's being allocated.
@@ -10163,13 +12138,28 @@ void *zest__allocate(zloc_allocator *allocator, zest_size size) {
 		int d = 0;
 	}
 	if (!allocation) {
-		zest__add_memory_pool(allocator, size);
+		zest__lock_pool_growth(allocator);
+		//Another thread may have added a pool while this one was waiting for the lock
 		allocation = zloc_Allocate(allocator, size);
+		if (!allocation) {
+			zest__add_memory_pool(allocator, size);
+			allocation = zloc_Allocate(allocator, size);
+		}
+		zest__unlock_pool_growth(allocator);
 		ZEST_ASSERT(allocation);    //Out of memory? Unable to allocate even after trying to add a new pool
 	}
 	return allocation;
 }
 
+void zest__free(zloc_allocator *allocator, void *memory) {
+	zloc_thread_cache_t *cache = zest__get_thread_cache(allocator);
+	if (cache) {
+		zloc_CacheFree(cache, memory);
+	} else {
+		zloc_Free(allocator, memory);
+	}
+}
+
 void *zest__reallocate(zloc_allocator *allocator, void *memory, zest_size size) {
 	void* allocation = zloc_Reallocate(allocator, memory, size);
 	/*
@@ -10180,8 +12170,14 @@ void *zest__reallocate(zloc_allocator *allocator, void *memory, zest_size size)
 	}
 	*/
 	if (!allocation) {
-		zest__add_memory_pool(allocator, size);
+		zest__lock_pool_growth(allocator);
+		//Another thread may have added a pool while this one was waiting for the lock
 		allocation = zloc_Reallocate(allocator, memory, size);
+		if (!allocation) {
+			zest__add_memory_pool(allocator, size);
+			allocation = zloc_Reallocate(allocator, memory, size);
+		}
+		zest__unlock_pool_growth(allocator);
 		ZEST_ASSERT(allocation);    //Unable to allocate even after adding a pool
 	}
 	return allocation;
@@ -10197,6 +12193,10 @@ zest_size zest__get_largest_slab(zloc_linear_allocator_t *allocator) {
 }
 
 void *zest__linear_allocate(zloc_linear_allocator_t *allocator, zest_size size) {
+	//Linear allocators can be hit from pass callbacks on several threads at once when a frame graph is
+	//recorded in parallel. The recording threads set zest__linear_allocator_guard for the duration.
+	zest_sync_t *guard = zest__linear_allocator_guard;
+	if (guard) zest__sync_lock(guard);
 	void *data = zloc_LinearAllocation(allocator, size);
 	if (!data && allocator->user_data) {
 		zest_context context = (zest_context)allocator->user_data;
@@ -10211,6 +12211,7 @@ void *zest__linear_allocate(zloc_linear_allocator_t *allocator, zest_size size)
 		zloc_AddNextLinearAllocator(allocator, next);
 		data = zloc_LinearAllocation(allocator, size);
 	}
+	if (guard) zest__sync_unlock(guard);
 	return data;
 }
 
@@ -10549,19 +12550,9 @@ zest_uint zloc_CountBlocks(zloc_header* first_block) {
     return count;
 }
 
-zest_buffer zest_CreateBuffer(zest_device device, zest_size size, zest_buffer_info_t* buffer_info) {
-	ZEST_ASSERT_OR_VALIDATE((buffer_info->property_flags & zest_memory_property_device_local_bit) ||
-							(buffer_info->property_flags & (zest_memory_property_host_visible_bit | zest_memory_property_host_coherent_bit)) ||
-							(buffer_info->property_flags & (zest_memory_property_host_visible_bit | zest_memory_property_host_cached_bit)),
-							device, "Trying to create buffer with invalid memory usage", NULL);
-	ZEST_ASSERT_OR_VALIDATE(ZEST__NOT_FLAGGED(buffer_info->flags, zest_memory_pool_flag_transient), 
-							device, "Transient buffers are for use in frame graphs only. Just simply zest_FreeBuffer after use if you're done with it.", NULL);
-	if (buffer_info->buffer_usage_flags & zest_buffer_usage_uniform_buffer_bit) {
-		//No need to round the size for uniform buffers specifically: every allocation size is
-		//rounded to the allocator's offset granularity below, which covers the uniform offset
-		//alignment requirement.
-		ZEST_ASSERT_OR_VALIDATE(size <= device->max_uniform_buffer_size, device, "Trying to allocate a uniform buffer large then the maximum size.", NULL);
-	}
+//Find the allocator for a combination of buffer properties, creating it along with its first pool if it
+//doesn't exist yet.
+zest_buffer_allocator zest__get_buffer_allocator(zest_device device, zest_size size, zest_buffer_info_t *buffer_info) {
 	zest_buffer_usage_t usage = ZEST_STRUCT_LITERAL(zest_buffer_usage_t, buffer_info->property_flags);
 	zest_map_buffer_allocators *buffer_allocators = &device->buffer_allocators;
 
@@ -10603,6 +12594,26 @@ zest_buffer zest_CreateBuffer(zest_device device, zest_size size, zest_buffer_in
 	//by, so a request with different bits must never land here (would bind the resource to a memory
 	//type not present in its own bits). Catches key hash collisions.
 	ZEST_ASSERT(buffer_allocator->buffer_info.backend_memory_bits == buffer_info->backend_memory_bits);
+    return buffer_allocator;
+}
+
+zest_buffer zest_CreateBuffer(zest_device device, zest_size size, zest_buffer_info_t* buffer_info) {
+	ZEST_ASSERT_OR_VALIDATE((buffer_info->property_flags & zest_memory_property_device_local_bit) ||
+							(buffer_info->property_flags & (zest_memory_property_host_visible_bit | zest_memory_property_host_coherent_bit)) ||
+							(buffer_info->property_flags & (zest_memory_property_host_visible_bit | zest_memory_property_host_cached_bit)),
+							device, "Trying to create buffer with invalid memory usage", NULL);
+	ZEST_ASSERT_OR_VALIDATE(ZEST__NOT_FLAGGED(buffer_info->flags, zest_memory_pool_flag_transient), 
+							device, "Transient buffers are for use in frame graphs only. Just simply zest_FreeBuffer after use if you're done with it.", NULL);
+	if (buffer_info->buffer_usage_flags & zest_buffer_usage_uniform_buffer_bit) {
+		//No need to round the size for uniform buffers specifically: every allocation size is
+		//rounded to the allocator's offset granularity below, which covers the uniform offset
+		//alignment requirement.
+		ZEST_ASSERT_OR_VALIDATE(size <= device->max_uniform_buffer_size, device, "Trying to allocate a uniform buffer large then the maximum size.", NULL);
+	}
+	zest_buffer_allocator buffer_allocator = zest__get_buffer_allocator(device, size, buffer_info);
+	if (!buffer_allocator) {
+		return 0;
+	}
 	//Round the size to the offset granularity so that sub-allocation offsets in the pool stay
 	//aligned by induction (offsets are byte-exact sums of the preceding block sizes).
 	size = zloc__align_size_up(size, buffer_allocator->offset_granularity);
@@ -10627,11 +12638,54 @@ zest_buffer zest_CreateBuffer(zest_device device, zest_size size, zest_buffer_in
     return buffer;
 }
 
+zest_bool zest__allocate_image_buffers(zest_device device, zest_buffer_info_t *buffer_info, const zest_size *sizes, zest_uint count, zest_buffer *buffers) {
+	ZEST_ASSERT(buffer_info->image_usage_flags);	//Only for image backing, buffers go through zest_CreateBuffer
+	memset(buffers, 0, sizeof(zest_buffer) * count);
+	if (!count) return ZEST_TRUE;
+	zest_size remaining = 0;
+	for (zest_uint i = 0; i != count; ++i) {
+		remaining += sizes[i];
+	}
+	//Every image in the batch shares the same allocator so it's only looked up once. If it's new then its first
+	//pool is sized for the whole batch.
+	zest_buffer_allocator buffer_allocator = zest__get_buffer_allocator(device, remaining, buffer_info);
+	if (!buffer_allocator) {
+		return ZEST_FALSE;
+	}
+	remaining = 0;
+	for (zest_uint i = 0; i != count; ++i) {
+		remaining += zloc__align_size_up(sizes[i], buffer_allocator->offset_granularity);
+	}
+	for (zest_uint i = 0; i != count; ++i) {
+		zest_size size = zloc__align_size_up(sizes[i], buffer_allocator->offset_granularity);
+		zest_buffer buffer = (zest_buffer)zloc_AllocateRemote(buffer_allocator->allocator, size);
+		if (!buffer) {
+			//Add one pool big enough for the rest of the batch rather than growing one pool per image
+			zest_device_memory_pool buffer_pool = 0;
+			if (zest__add_gpu_memory_pool(buffer_allocator, remaining, &buffer_pool) == ZEST_TRUE) {
+				buffer = (zest_buffer)zloc_AllocateRemote(buffer_allocator->allocator, size);
+			}
+		}
+		if (!buffer) {
+			ZEST_APPEND_LOG(device->log_path.str, "Unable to allocate %llu of memory for a batch of images.", remaining);
+			for (zest_uint j = 0; j != i; ++j) {
+				zest_FreeBufferNow(buffers[j]);
+				buffers[j] = 0;
+			}
+			return ZEST_FALSE;
+		}
+		buffer->usage_flags = buffer_info->buffer_usage_flags;
+		buffers[i] = buffer;
+		remaining -= size;
+	}
+	return ZEST_TRUE;
+}
+
 zest_buffer zest_CreateStagingBuffer(zest_device device, zest_size size, void* data) {
     zest_buffer_info_t buffer_info = zest_CreateBufferInfo(zest_buffer_type_staging, zest_memory_usage_cpu_to_gpu);
     zest_buffer buffer = zest_CreateBuffer(device, size, &buffer_info);
     if (data) {
-        memcpy(zest_BufferData(buffer), data, size);
+		zest__parallel_copy(device, zest_BufferData(buffer), data, size);
     }
     return buffer;
 }
@@ -10686,7 +12740,7 @@ zest_buffer zest_CreateDedicatedStagingBuffer(zest_device device, zest_size size
     zest_buffer_info_t buffer_info = zest_CreateBufferInfo(zest_buffer_type_staging, zest_memory_usage_cpu_to_gpu);
     zest_buffer buffer = zest_CreateDedicatedBuffer(device, size, &buffer_info);
     if (buffer && data) {
-        memcpy(zest_BufferData(buffer), data, size);
+		zest__parallel_copy(device, zest_BufferData(buffer), data, size);
     }
     return buffer;
 }
@@ -10786,7 +12840,7 @@ zest_bool zest_imm_CopyBufferToImage(zest_queue queue, zest_buffer src_buffer, z
 void zest_StageData(void *src_data, zest_buffer dst_staging_buffer, zest_size size) {
     ZEST_ASSERT(src_data);                  //No source data to copy!
     ZEST_ASSERT(size <= dst_staging_buffer->size);  //Staging buffer not large enough
-    memcpy(zest_BufferData(dst_staging_buffer), src_data, size);
+	zest__parallel_copy(dst_staging_buffer->memory_pool->allocator->device, zest_BufferData(dst_staging_buffer), src_data, size);
 }
 
 //Shared reallocation path for zest_GrowBuffer/zest_ResizeBuffer (see the contract documented on
@@ -10874,6 +12928,7 @@ zest_buffer_info_t zest_CreateBufferInfo(zest_buffer_type type, zest_memory_usag
 		case zest_memory_usage_gpu_only: buffer_info.property_flags = zest_memory_property_device_local_bit; break;
 		case zest_memory_usage_cpu_to_gpu: buffer_info.property_flags = zest_memory_property_host_visible_bit | zest_memory_property_host_coherent_bit; break;
 		case zest_memory_usage_gpu_to_cpu: buffer_info.property_flags = zest_memory_property_host_visible_bit | zest_memory_property_host_cached_bit; break;
+		case zest_memory_usage_gpu_host_visible: buffer_info.property_flags = zest_memory_property_device_local_bit | zest_memory_property_host_visible_bit | zest_memory_property_host_coherent_bit; break;
 		default: break;
 	}
 
@@ -10930,6 +12985,10 @@ void zest_FreeBufferNow(zest_buffer buffer) {
 }
 
 void zest_AddCopyCommand(zest_context context, zest_buffer_uploader_t *uploader, zest_buffer source_buffer, zest_buffer target_buffer, zest_size size) {
+	zest_AddCopyCommandRegion(context, uploader, source_buffer, target_buffer, 0, 0, size);
+}
+
+void zest_AddCopyCommandRegion(zest_context context, zest_buffer_uploader_t *uploader, zest_buffer source_buffer, zest_buffer target_buffer, zest_size src_offset, zest_size dst_offset, zest_size size) {
     if (uploader->flags & zest_buffer_upload_flag_initialised) {
         ZEST_ASSERT(uploader->source_buffer == source_buffer && uploader->target_buffer == target_buffer);    //Buffer uploads must be to the same source and target ids with each copy. Use a separate BufferUpload for each combination of source and target buffers
     }
@@ -10939,9 +12998,9 @@ void zest_AddCopyCommand(zest_context context, zest_buffer_uploader_t *uploader,
     uploader->flags |= zest_buffer_upload_flag_initialised;
 
     zest_buffer_copy_t buffer_info = ZEST__ZERO_INIT(zest_buffer_copy_t);
-    buffer_info.src_offset = source_buffer->memory_offset;
-    buffer_info.dst_offset = target_buffer->memory_offset;
-    ZEST_ASSERT(size <= target_buffer->size);
+    buffer_info.src_offset = source_buffer->memory_offset + src_offset;
+    buffer_info.dst_offset = target_buffer->memory_offset + dst_offset;
+    ZEST_ASSERT(dst_offset + size <= target_buffer->size);
     buffer_info.size = size;
     zest_vec_linear_push(zest__frame_graph_builder->allocator, uploader->buffer_copies, buffer_info);
 }
@@ -11010,6 +13069,8 @@ zest_bool zest__initialise_context(zest_context context, zest_create_context_inf
     context->memory_pool_sizes[0] = create_info->memory_pool_size;
     context->memory_pool_count = 1;
 
+	zest__initialise_map(context->allocator, &context->cached_pipelines, sizeof(zest_pipeline), 0);
+
 	for (int i = 0; i != zest_max_context_handle_type; ++i) {
 		switch ((zest_context_handle_type)i) {
 			case zest_handle_type_uniform_buffers: 		zest__initialise_store(context->allocator, context, &context->resource_stores[i], sizeof(zest_uniform_buffer_t), zest_struct_type_uniform_buffer); break;
@@ -11088,6 +13149,7 @@ zest_bool zest__initialise_context(zest_context context, zest_create_context_inf
 	if (!context->queues[context->compute_queue_index]) context->queues[context->compute_queue_index] = context->queues[context->graphics_queue_index];
 	if (!context->queues[context->transfer_queue_index]) context->queues[context->transfer_queue_index] = context->queues[context->graphics_queue_index];
 
+	context->frame_graph_block_size = context->create_info.frame_graph_allocator_size;
     zest_ForEachFrameInFlight(fif) {
 		void *frame_graph_linear_memory = ZEST__ALLOCATE(context->allocator, context->create_info.frame_graph_allocator_size);
         int result = zloc_InitialiseLinearAllocator(&context->frame_graph_allocator[fif], frame_graph_linear_memory, context->create_info.frame_graph_allocator_size);
@@ -11208,8 +13270,8 @@ void zest__cleanup_pipeline_layout(zest_pipeline_layout layout) {
 }
 
 void zest__cleanup_pipelines(zest_context context) {
-    zest_map_foreach(i, context->cached_pipelines) {
-        zest_pipeline pipeline = *zest_map_at_index(context->cached_pipelines, i);
+    for (zest_uint i = 0; i != context->cached_pipelines.current_size; ++i) {
+        zest_pipeline pipeline = *(zest_pipeline*)zest__map_at_index(&context->cached_pipelines, i);
         context->device->platform->cleanup_pipeline_backend(pipeline);
         ZEST__FREE(context->allocator, pipeline);
     }
@@ -11256,6 +13318,8 @@ void zest__cleanup_device(zest_device device) {
 	while (zest_vec_size(device->contexts)) {
 		zest_DestroyContext(device->contexts[zest_vec_size(device->contexts) - 1]);
 	}
+	//No context is left to hand work to the job system. It's started again on demand after a device reset.
+	zest__destroy_job_system(device);
 
 	zest_vec_foreach(i, device->queue_families) {
 		zest_queue_manager manager = device->queue_families[i];
@@ -11620,6 +13684,8 @@ void zest__cleanup_context(zest_context context) {
 	if (context->swapchain) {
 		zest__cleanup_swapchain(context->swapchain);
 	}
+    zest__drain_pipeline_requests(context);
+    zest_map_free(context->allocator, context->pipeline_requests);
     zest__cleanup_pipelines(context);
 
 	for (int i = 0; i != zest_max_context_handle_type; ++i) {
@@ -11695,12 +13761,14 @@ void zest__cleanup_context(zest_context context) {
 		context->utility_timeline = 0;
 	}
 
+	//Readbacks still pending never fire their callbacks
+	zest__cleanup_readbacks(context);
+
     zest_map_foreach(i, context->cached_frame_graphs) {
-        zest_cached_frame_graph_t *cached_graph = &context->cached_frame_graphs.data[i];
+        zest_cached_frame_graph_t *cached_graph = &context->cached_frame_graphs.data[zest_map_index(context->cached_frame_graphs, i)];
 		//Cached graphs hold persistent transient images and arena checkouts; retire them first
 		//(the device is idle at this point so the deferred queues below destroy them immediately)
-		zest__release_frame_graph_transients(context, cached_graph->frame_graph);
-        ZEST__FREE(context->allocator, cached_graph->memory);
+		zest__free_cached_frame_graph(context, cached_graph);
     }
 
 	//Destroy anything the arena system still has pending or live. The device is idle during
@@ -11754,7 +13822,7 @@ void zest__cleanup_context(zest_context context) {
 
 	zest__free_context_buffer_allocators(context);
 
-    zest_map_free(context->allocator, context->cached_pipelines);
+    zest__free_map(&context->cached_pipelines);
     zest_map_free(context->allocator, context->cached_frame_graph_semaphores);
     zest_map_free(context->allocator, context->cached_frame_graphs);
     zest_map_free(context->allocator, context->buffer_allocators);
@@ -11770,6 +13838,8 @@ void zest__cleanup_context(zest_context context) {
 	for (int i = 0; i != context->memory_pool_count; i++) {
 		ZEST__FREE(context->device->allocator, context->memory_pools[i]);
 	}
+	zest__sync_cleanup(&context->recording_sync);
+	zest__sync_cleanup(&context->linear_allocator_sync);
 }
 
 zest_bool zest__recreate_swapchain(zest_context context) {
@@ -11792,8 +13862,9 @@ zest_bool zest__recreate_swapchain(zest_context context) {
     zest_vec_free(context->allocator, swapchain->views);
 	ZEST__FREE(context->allocator, swapchain);
 
+    zest__drain_pipeline_requests(context);
     zest__cleanup_pipelines(context);
-    zest_map_free(context->allocator, context->cached_pipelines);
+    zest__free_map(&context->cached_pipelines);
 
 	swapchain = zest__create_swapchain(context, name);
     ZEST__FLAG(swapchain->flags, zest_swapchain_flag_was_recreated);
@@ -12475,7 +14546,7 @@ zest_bool zest__cache_pipeline(zest_pipeline_template pipeline_template, zest_co
 	pipeline->layout = pipeline_template->layout;
     zest_bool result = context->device->platform->build_pipeline(pipeline, command_list);
 	if (result == ZEST_TRUE) {
-		zest_map_insert_key(context->allocator, context->cached_pipelines, pipeline_key, pipeline);
+		zest__insert_key(&context->cached_pipelines, pipeline_key, &pipeline);
 		*out_pipeline = pipeline;
 	} else {
 		ZEST__FLAG(pipeline_template->flags, zest_pipeline_invalid);
@@ -12508,6 +14579,8 @@ zest_pipeline_template zest_CopyPipelineTemplate(const char *name, zest_pipeline
 
 void zest_FreePipelineTemplate(zest_pipeline_template pipeline_template) {
     ZEST_ASSERT_HANDLE(pipeline_template);   //Not a valid pipeline template handle
+    //Background builds read the template so let them finish first
+    zest__drain_device_pipeline_requests(pipeline_template->device);
     zest__unregister_pipeline_template_from_shader_handle(pipeline_template->vertex_shader, pipeline_template);
     zest__unregister_pipeline_template_from_shader_handle(pipeline_template->fragment_shader, pipeline_template);
     zest__cleanup_pipeline_template(pipeline_template);
@@ -12583,6 +14656,164 @@ zest_shader_handle zest_CreateShaderFromFile(zest_device device, const char *fil
     return shader_handle;
 }
 
+void zest__compile_shader_batch_task(void *data, zest_uint worker_index) {
+	zest_shader_batch_slot_t *slot = (zest_shader_batch_slot_t*)data;
+	zest_shader_batch_t *batch = slot->batch;
+	zest_device device = batch->device;
+	//Shaders vary a lot in how long they take so each job keeps claiming the next one until they're all gone
+	for (;;) {
+		int job_index = zest__atomic_fetch_add(&batch->next_job, 1);
+		if (job_index >= (int)batch->job_count) break;
+		zest_shader_compile_job_t *job = &batch->jobs[job_index];
+		zest_microsecs start = zest_Microsecs();
+		device->platform->compile_shader_job(device, job, slot->compiler_index);
+		job->compile_time = zest_Microsecs() - start;
+	}
+}
+
+zest_bool zest_CreateShaders(zest_device device, const zest_shader_source_t *sources, zest_uint count, zest_shader_handle *out_handles, zest_shader_batch_stats_t *stats) {
+	ZEST_ASSERT_HANDLE(device);		//Not a valid device handle
+	ZEST_ASSERT(sources && out_handles);	//You must pass the sources and somewhere to put the handles
+	zest_microsecs start_time = zest_Microsecs();
+	zest_shader_batch_stats_t batch_stats = ZEST__ZERO_INIT(zest_shader_batch_stats_t);
+	batch_stats.shader_count = count;
+	if (stats) {
+		*stats = batch_stats;
+	}
+	if (!count) {
+		return ZEST_TRUE;
+	}
+	zest_bool use_cache = ZEST__FLAGGED(device->init_flags, zest_device_init_flag_cache_shaders);
+
+	//Everything that touches the shader store or the device allocator happens here on the calling thread. Each
+	//source gets a shader and is either loaded from the cache, marked as a duplicate of an earlier source
+	//(primary) or queued to compile (job_of_source).
+	zest_uint *primary = 0;
+	int *job_of_source = 0;
+	zest_map_shader_batch_keys first_source_of_key = ZEST__ZERO_INIT(zest_map_shader_batch_keys);
+	zest_shader_batch_t batch = ZEST__ZERO_INIT(zest_shader_batch_t);
+	batch.device = device;
+	zest_vec_resize(device->allocator, primary, count);
+	zest_vec_resize(device->allocator, job_of_source, count);
+	for (zest_uint i = 0; i != count; ++i) {
+		const zest_shader_source_t *source = &sources[i];
+		ZEST_ASSERT(source->name);		//You must give each shader a name
+		ZEST_ASSERT(source->file || source->shader_code);	//Each shader needs a file or source code
+		primary[i] = i;
+		job_of_source[i] = -1;
+		char *file_code = 0;
+		const char *shader_code = source->shader_code;
+		if (!shader_code) {
+			file_code = zest_ReadEntireFile(device, source->file, ZEST_TRUE);
+			ZEST_ASSERT(file_code, "Unable to load the shader code, check the path is valid.");
+			shader_code = file_code;
+		}
+		out_handles[i] = zest__new_shader(device, source->type);
+		zest_shader shader = (zest_shader)zest__get_store_resource_unsafe(out_handles[i].store, out_handles[i].value);
+		zest_SetText(device->allocator, &shader->name, source->name);
+		zest_SetText(device->allocator, &shader->shader_code, shader_code);
+		shader->cache_key = zest__shader_cache_key(shader_code, source->type, "main", source->options);
+		zest__build_shader_cache_path(device, &shader->cache_path, source->name, shader->cache_key);
+		if (source->file) {
+			zest_SetText(device->allocator, &shader->file_path, source->file);
+			zest__get_file_mtime(source->file, &shader->last_mtime);
+		}
+		zest_vec_free(device->allocator, file_code);
+		if (zest_map_valid_key(first_source_of_key, shader->cache_key)) {
+			primary[i] = *zest_map_at_key(first_source_of_key, shader->cache_key);
+			batch_stats.duplicate_count++;
+			continue;
+		}
+		zest_map_insert_key(device->allocator, first_source_of_key, shader->cache_key, i);
+		if (use_cache && !source->disable_caching && zest__load_cached_shader(device, shader)) {
+			batch_stats.cache_hit_count++;
+			continue;
+		}
+		zest_shader_compile_job_t job = ZEST__ZERO_INIT(zest_shader_compile_job_t);
+		job.options = source->options;
+		job_of_source[i] = (int)zest_vec_size(batch.jobs);
+		zest_vec_push(device->allocator, batch.jobs, job);
+	}
+	zest_map_free(device->allocator, first_source_of_key);
+	batch.job_count = zest_vec_size(batch.jobs);
+
+	if (batch.job_count) {
+		//Adding shaders can move earlier ones in the store so the pointers are only taken once they're all in
+		zest_vec_foreach(i, job_of_source) {
+			if (job_of_source[i] >= 0) {
+				batch.jobs[job_of_source[i]].shader = (zest_shader)zest__get_store_resource_unsafe(out_handles[i].store, out_handles[i].value);
+			}
+		}
+		zest_uint slot_count = ZEST__MIN(zest_GetJobWorkerCount(device), batch.job_count);
+		if (device->platform->prepare_shader_compilers(device, slot_count)) {
+			zest_shader_batch_slot_t *slots = 0;
+			zest_job_t *tasks = 0;
+			zest_vec_resize(device->allocator, slots, slot_count);
+			zest_vec_resize(device->allocator, tasks, slot_count);
+			for (zest_uint slot_index = 0; slot_index != slot_count; ++slot_index) {
+				slots[slot_index].batch = &batch;
+				slots[slot_index].compiler_index = slot_index;
+				tasks[slot_index].callback = zest__compile_shader_batch_task;
+				tasks[slot_index].data = &slots[slot_index];
+			}
+			zest_job_counter_t counter = ZEST__ZERO_INIT(zest_job_counter_t);
+			zest_RunJobs(device, tasks, slot_count, &counter);
+			zest_WaitJobs(device, &counter);
+			zest_vec_free(device->allocator, slots);
+			zest_vec_free(device->allocator, tasks);
+		}
+	}
+
+	//Back on the calling thread: copy the results in to the shaders, then fill in the duplicates and cache
+	zest_bool result = ZEST_TRUE;
+	zest_vec_foreach(i, job_of_source) {
+		if (job_of_source[i] < 0) continue;
+		zest_shader_compile_job_t *job = &batch.jobs[job_of_source[i]];
+		batch_stats.compile_time += job->compile_time;
+		if (device->platform->finish_shader_job(job->shader, job)) {
+			batch_stats.compiled_count++;
+			if (use_cache && !sources[i].disable_caching) {
+				zest__cache_shader(device, job->shader);
+			}
+		}
+	}
+	for (zest_uint i = 0; i != count; ++i) {
+		zest_shader shader = (zest_shader)zest__get_store_resource_unsafe(out_handles[i].store, out_handles[i].value);
+		zest_shader primary_shader = (zest_shader)zest__get_store_resource_unsafe(out_handles[primary[i]].store, out_handles[primary[i]].value);
+		if (primary[i] != i && primary_shader->binary) {
+			zest_vec_resize(device->allocator, shader->binary, zest_vec_size(primary_shader->binary));
+			memcpy(shader->binary, primary_shader->binary, zest_vec_size(primary_shader->binary));
+			shader->binary_size = primary_shader->binary_size;
+			if (use_cache && !sources[i].disable_caching) {
+				zest__cache_shader(device, shader);
+			}
+		}
+	}
+	for (zest_uint i = 0; i != count; ++i) {
+		zest_shader shader = (zest_shader)zest__get_store_resource_unsafe(out_handles[i].store, out_handles[i].value);
+		zest_bool compiled = shader->binary != 0;
+		zest__activate_resource(out_handles[i].store, out_handles[i].value);
+		if (!compiled) {
+			zest_FreeShader(out_handles[i]);
+			out_handles[i] = ZEST__ZERO_INIT(zest_shader_handle);
+			batch_stats.failed_count++;
+			result = ZEST_FALSE;
+		}
+	}
+	zest_vec_free(device->allocator, batch.jobs);
+	zest_vec_free(device->allocator, primary);
+	zest_vec_free(device->allocator, job_of_source);
+
+	batch_stats.elapsed_time = zest_Microsecs() - start_time;
+	ZEST_APPEND_LOG(device->log_path.str, "Created %u shaders in %.2fms: %u compiled (%.2fms of compile time), %u from the cache, %u duplicates, %u failed.",
+		count, (double)batch_stats.elapsed_time / ZEST_MICROSECS_MILLISECOND, batch_stats.compiled_count, (double)batch_stats.compile_time / ZEST_MICROSECS_MILLISECOND,
+		batch_stats.cache_hit_count, batch_stats.duplicate_count, batch_stats.failed_count);
+	if (stats) {
+		*stats = batch_stats;
+	}
+	return result;
+}
+
 zest_bool zest_ReloadShader(zest_shader_handle shader_handle) {
 	zest_shader shader = (zest_shader)zest__get_store_resource_checked(shader_handle.store, shader_handle.value);
     ZEST_ASSERT(zest_TextLength(&shader->file_path));    //The shader must have a file path set.
@@ -12634,34 +14865,138 @@ void zest__build_shader_cache_path(zest_device device, zest_text_t *out, const c
     }
 }
 
-zest_shader_handle zest_CreateShader(zest_device device, const char *shader_code, zest_shader_type type, const char *name, zest_shader_options options, zest_bool disable_caching) {
-	ZEST_ASSERT_HANDLE(device);		//Not a valid device handle
-    ZEST_ASSERT(name);     //You must give the shader a name
-    zest_shader_handle shader_handle = zest__new_shader(device, type);
-    zest_shader shader = (zest_shader)zest__get_store_resource_unsafe(shader_handle.store, shader_handle.value);
-    zest_SetText(device->allocator, &shader->name, name);
-    //Keyed on a hash of the source rather than the name, so editing a shader lands on a different cache file
-    //instead of silently reusing the binary compiled from the old source.
-    shader->cache_key = zest__shader_cache_key(shader_code, type, "main", options);
-    zest__build_shader_cache_path(device, &shader->cache_path, name, shader->cache_key);
-    if (!disable_caching && device->init_flags & zest_device_init_flag_cache_shaders) {
-        shader->binary = zest_ReadEntireFile(device, shader->cache_path.str, ZEST_FALSE);
-        if (shader->binary) {
-            shader->binary_size = zest_vec_size(shader->binary);
-			zest_SetText(device->allocator, &shader->shader_code, shader_code);
-			ZEST_APPEND_LOG(device->log_path.str, "Loaded shader %s from cache (%s).", name, shader->cache_path.str);
-			zest__activate_resource(shader_handle.store, shader_handle.value);
-            return shader_handle;
-        }
-    }
+void zest__build_pipeline_cache_path(zest_device device, zest_text_t *out) {
+    const char *folder = zest_TextSize(&device->cached_shaders_path) ? device->cached_shaders_path.str : "";
+	zest_SetTextf(device->allocator, out, "%s%s", folder, ZEST_PIPELINE_CACHE_FILE_NAME);
+}
 
-	zest_SetText(device->allocator, &shader->shader_code, shader_code);
-	if (!device->platform->compile_shader(shader, shader->shader_code.str, zest_TextLength(&shader->shader_code), type, name, "main", options)) {
-		zest__activate_resource(shader_handle.store, shader_handle.value);
-        zest_FreeShader(shader_handle);
-        ZEST_ASSERT(0, "There's a bug in this shader that needs fixing. You can check the log file for the error message");
+zest_file zest__load_pipeline_cache(zest_device device) {
+	zest_text_t path = ZEST__ZERO_INIT(zest_text_t);
+	zest__build_pipeline_cache_path(device, &path);
+	zest_file file = zest_ReadEntireFile(device, path.str, ZEST_FALSE);
+	if (!file) {
+		ZEST_APPEND_LOG(device->log_path.str, "No pipeline cache found at %s, starting with an empty cache.", path.str);
+		zest_FreeText(device->allocator, &path);
+		return NULL;
 	}
-
+	zest_pipeline_cache_header_t expected = ZEST__ZERO_INIT(zest_pipeline_cache_header_t);
+	device->platform->get_pipeline_cache_identity(device, &expected);
+	zest_pipeline_cache_header_t header = ZEST__ZERO_INIT(zest_pipeline_cache_header_t);
+	zest_uint file_size = zest_vec_size(file);
+	const char *reason = NULL;
+	if (file_size < sizeof(zest_pipeline_cache_header_t)) {
+		reason = "the file is too small";
+	} else {
+		memcpy(&header, file, sizeof(zest_pipeline_cache_header_t));
+		if (header.magic != ZEST__PIPELINE_CACHE_MAGIC || header.version != ZEST__PIPELINE_CACHE_VERSION) {
+			reason = "it was written by a different version of Zest";
+		} else if (header.vendor_id != expected.vendor_id || header.device_id != expected.device_id) {
+			reason = "it was written on a different device";
+		} else if (header.driver_version != expected.driver_version || memcmp(header.cache_uuid, expected.cache_uuid, sizeof(header.cache_uuid)) != 0) {
+			reason = "it was written by a different driver version";
+		} else if (header.data_size != file_size - sizeof(zest_pipeline_cache_header_t) ||
+				   header.data_hash != zest_Hash(file + sizeof(zest_pipeline_cache_header_t), header.data_size, ZEST_HASH_SEED)) {
+			reason = "the data is truncated or corrupt";
+		}
+	}
+	if (reason) {
+		ZEST_APPEND_LOG(device->log_path.str, "Ignoring the pipeline cache at %s because %s.", path.str, reason);
+		zest_vec_free(device->allocator, file);
+		zest_FreeText(device->allocator, &path);
+		return NULL;
+	}
+	//Strip the header so the caller can hand the vec straight to the backend
+	memmove(file, file + sizeof(zest_pipeline_cache_header_t), header.data_size);
+	zest_vec_resize(device->allocator, file, header.data_size);
+	ZEST_APPEND_LOG(device->log_path.str, "Loaded pipeline cache from %s (%u bytes).", path.str, header.data_size);
+	zest_FreeText(device->allocator, &path);
+	return file;
+}
+
+zest_bool zest_SavePipelineCache(zest_device device) {
+	ZEST_ASSERT_HANDLE(device);		//Not a valid device handle
+	if (ZEST__NOT_FLAGGED(device->init_flags, zest_device_init_flag_cache_pipelines)) {
+		return ZEST_FALSE;
+	}
+	zest_size data_size = device->platform->get_pipeline_cache_data(device, NULL, 0);
+	if (!data_size || data_size > 0xFFFFFFFF - sizeof(zest_pipeline_cache_header_t)) {
+		return ZEST_FALSE;
+	}
+	char *buffer = 0;
+	zest_vec_resize(device->allocator, buffer, (zest_uint)(data_size + sizeof(zest_pipeline_cache_header_t)));
+	data_size = device->platform->get_pipeline_cache_data(device, buffer + sizeof(zest_pipeline_cache_header_t), data_size);
+	if (!data_size) {
+		zest_vec_free(device->allocator, buffer);
+		return ZEST_FALSE;
+	}
+	zest_pipeline_cache_header_t header = ZEST__ZERO_INIT(zest_pipeline_cache_header_t);
+	device->platform->get_pipeline_cache_identity(device, &header);
+	header.magic = ZEST__PIPELINE_CACHE_MAGIC;
+	header.version = ZEST__PIPELINE_CACHE_VERSION;
+	header.data_size = (zest_uint)data_size;
+	header.data_hash = zest_Hash(buffer + sizeof(zest_pipeline_cache_header_t), data_size, ZEST_HASH_SEED);
+	memcpy(buffer, &header, sizeof(zest_pipeline_cache_header_t));
+
+    if (zest_TextSize(&device->cached_shaders_path)) {
+        zest__create_folder(device, device->cached_shaders_path.str);
+    }
+	//Write to a temporary file and swap it in so that a crash part way through never leaves a half written
+	//cache behind (the hash would reject it anyway but then the old cache is lost too).
+	zest_text_t path = ZEST__ZERO_INIT(zest_text_t);
+	zest_text_t temp_path = ZEST__ZERO_INIT(zest_text_t);
+	zest__build_pipeline_cache_path(device, &path);
+	zest_SetTextf(device->allocator, &temp_path, "%s.tmp", path.str);
+	zest_bool result = ZEST_FALSE;
+	FILE *cache_file = zest__open_file(temp_path.str, "wb");
+	if (cache_file == NULL) {
+		ZEST_APPEND_LOG(device->log_path.str, "Failed to open file for writing: %s", temp_path.str);
+	} else {
+		size_t total_size = data_size + sizeof(zest_pipeline_cache_header_t);
+		size_t written = fwrite(buffer, 1, total_size, cache_file);
+		fclose(cache_file);
+		if (written != total_size) {
+			ZEST_APPEND_LOG(device->log_path.str, "Failed to write entire pipeline cache to file: %s", temp_path.str);
+			remove(temp_path.str);
+		} else {
+			remove(path.str);
+			if (rename(temp_path.str, path.str) == 0) {
+				ZEST_APPEND_LOG(device->log_path.str, "Saved pipeline cache to %s (%llu bytes).", path.str, (unsigned long long)data_size);
+				result = ZEST_TRUE;
+			} else {
+				ZEST_APPEND_LOG(device->log_path.str, "Failed to move the pipeline cache in to place: %s", path.str);
+				remove(temp_path.str);
+			}
+		}
+	}
+	zest_FreeText(device->allocator, &temp_path);
+	zest_FreeText(device->allocator, &path);
+	zest_vec_free(device->allocator, buffer);
+	return result;
+}
+
+zest_shader_handle zest_CreateShader(zest_device device, const char *shader_code, zest_shader_type type, const char *name, zest_shader_options options, zest_bool disable_caching) {
+	ZEST_ASSERT_HANDLE(device);		//Not a valid device handle
+    ZEST_ASSERT(name);     //You must give the shader a name
+    zest_shader_handle shader_handle = zest__new_shader(device, type);
+    zest_shader shader = (zest_shader)zest__get_store_resource_unsafe(shader_handle.store, shader_handle.value);
+    zest_SetText(device->allocator, &shader->name, name);
+    //Keyed on a hash of the source rather than the name, so editing a shader lands on a different cache file
+    //instead of silently reusing the binary compiled from the old source.
+    shader->cache_key = zest__shader_cache_key(shader_code, type, "main", options);
+    zest__build_shader_cache_path(device, &shader->cache_path, name, shader->cache_key);
+    if (!disable_caching && device->init_flags & zest_device_init_flag_cache_shaders && zest__load_cached_shader(device, shader)) {
+		zest_SetText(device->allocator, &shader->shader_code, shader_code);
+		zest__activate_resource(shader_handle.store, shader_handle.value);
+		return shader_handle;
+    }
+
+	zest_SetText(device->allocator, &shader->shader_code, shader_code);
+	if (!device->platform->compile_shader(shader, shader->shader_code.str, zest_TextLength(&shader->shader_code), type, name, "main", options)) {
+		zest__activate_resource(shader_handle.store, shader_handle.value);
+        zest_FreeShader(shader_handle);
+        ZEST_ASSERT(0, "There's a bug in this shader that needs fixing. You can check the log file for the error message");
+	}
+
     if (!disable_caching && device->init_flags & zest_device_init_flag_cache_shaders) {
         zest__cache_shader(device, shader);
     }
@@ -12669,6 +15004,16 @@ zest_shader_handle zest_CreateShader(zest_device device, const char *shader_code
     return shader_handle;
 }
 
+zest_bool zest__load_cached_shader(zest_device device, zest_shader shader) {
+    shader->binary = zest_ReadEntireFile(device, shader->cache_path.str, ZEST_FALSE);
+    if (!shader->binary) {
+        return ZEST_FALSE;
+    }
+    shader->binary_size = zest_vec_size(shader->binary);
+    ZEST_APPEND_LOG(device->log_path.str, "Loaded shader %s from cache (%s).", shader->name.str, shader->cache_path.str);
+    return ZEST_TRUE;
+}
+
 void zest__cache_shader(zest_device device, zest_shader shader) {
     if (!zest_TextSize(&shader->cache_path)) {
         return;
@@ -12784,16 +15129,14 @@ zest_size zest_GetCompiledShaderSize(zest_shader shader) {
 ZEST_PRIVATE void zest__invalidate_graphics_template_caches(zest_device device, zest_pipeline_template pipeline_template) {
     //Walk every live context and evict any cached pipelines that reference this template. The VkPipeline
     //handles are destroyed via the platform cleanup hook. Callers must have drained in-flight work first
-    //(zest_WaitForIdleDevice) so the pipelines are no longer referenced by the GPU. We iterate the map
-    //(not the data array) because data slots can be stale after removes — only map entries are live.
+    //(zest_WaitForIdleDevice) so the pipelines are no longer referenced by the GPU. We iterate backwards
+    //because a remove moves the last entry in to the removed entry's place.
     zest_vec_foreach(ci, device->contexts) {
         zest_context context = device->contexts[ci];
-        for (int mi = (int)zest_vec_size(context->cached_pipelines.map) - 1; mi >= 0; --mi) {
-            zest_uint data_index = context->cached_pipelines.map[mi].index;
-            zest_pipeline pipeline = context->cached_pipelines.data[data_index];
+        for (int mi = (int)context->cached_pipelines.current_size - 1; mi >= 0; --mi) {
+            zest_pipeline pipeline = *(zest_pipeline*)zest__map_at_index(&context->cached_pipelines, mi);
             if (!pipeline || pipeline->pipeline_template != pipeline_template) continue;
-            zest_key key = context->cached_pipelines.map[mi].key;
-            zest_map_remove_key(context->allocator, context->cached_pipelines, key);
+            zest__remove_key(&context->cached_pipelines, zest__map_key_at_index(&context->cached_pipelines, mi));
             zest__cleanup_pipeline(pipeline);
         }
     }
@@ -12836,6 +15179,9 @@ zest_uint zest_CheckShaderHotReload(zest_device device) {
         zest_SetText(device->allocator, &shader->shader_code, new_code);
         zest_vec_free(device->allocator, new_code);
 
+        //Background pipeline builds read shader->binary so they have to finish before it's rewritten.
+        zest__drain_device_pipeline_requests(device);
+
         //Compile into a new binary. On failure the shader->binary is untouched so rendering keeps using the last good binary.
         //compile_shader rewrites shader->binary via zest_vec_resize, which is not an atomic swap; however pipelines that already
         //hold backend pipeline handles don't read shader->binary again — only rebuilt pipelines do. So a failed compile leaves the
@@ -12941,18 +15287,220 @@ zest_pipeline zest_GetPipeline(zest_pipeline_template pipeline_template, const z
 		ZEST_REPORT(context->device, zest_report_unused_pass, "You're trying to build a pipeline (%s) that has been marked as invalid. This means that the last time this pipeline was created it failed with errors. You can check for validation errors to see what they were.", pipeline_template->name);
 		return NULL;
 	}
-    zest_key pipeline_key = (zest_key)pipeline_template;
-	zest_key cached_pipeline_key = zest_Hash(&command_list->rendering_info, sizeof(zest_rendering_info_t), pipeline_key);
-    if (zest_map_valid_key(context->cached_pipelines, cached_pipeline_key)) {
-		return *zest_map_at_key(context->cached_pipelines, cached_pipeline_key); 
-    }
+	zest_key cached_pipeline_key = zest__pipeline_cache_key(context->device, pipeline_template, &command_list->rendering_info);
+	//Pass callbacks may be fetching pipelines from worker threads (see zest_EnableParallelRecording)
+	zest_bool locked = zest__lock_recording(context);
     zest_pipeline pipeline = 0;
-	if (!zest__cache_pipeline(pipeline_template, command_list, cached_pipeline_key, &pipeline)) {
+	zest_pipeline *cached_pipeline = (zest_pipeline*)zest__at_key(&context->cached_pipelines, cached_pipeline_key);
+    if (cached_pipeline) {
+		pipeline = *cached_pipeline;
+    } else if (!zest__cache_pipeline(pipeline_template, command_list, cached_pipeline_key, &pipeline)) {
 		ZEST_ALERT("ERROR: Unable to build and cache pipeline [%s]. Check the log and validation errors for the most recent errors.", pipeline_template->name);
 	}
+	zest__unlock_recording(context, locked);
+	return pipeline;
+}
+
+zest_key zest__pipeline_cache_key(zest_device device, zest_pipeline_template pipeline_template, const zest_rendering_info_t *rendering_info) {
+	//Copy field by field in to zeroed memory so that padding can't change the hash
+	zest_rendering_info_t key_info;
+	memset(&key_info, 0, sizeof(zest_rendering_info_t));
+	key_info.color_attachment_count = rendering_info->color_attachment_count;
+	memcpy(key_info.color_attachment_formats, rendering_info->color_attachment_formats, sizeof(key_info.color_attachment_formats));
+	key_info.depth_attachment_format = rendering_info->depth_attachment_format;
+	key_info.stencil_attachment_format = rendering_info->stencil_attachment_format;
+	key_info.sample_count = rendering_info->sample_count;
+	key_info.view_mask = rendering_info->view_mask;
+	//With dynamic rendering the pipeline only depends on the formats, so leaving out the render pass key lets a
+	//pipeline precompiled from the formats alone be found by every pass that uses them.
+	if (zest__using_legacy_render_pass(device)) {
+		key_info.render_pass_key = rendering_info->render_pass_key;
+	}
+	return zest_Hash(&key_info, sizeof(zest_rendering_info_t), (zest_key)pipeline_template);
+}
+
+zest_bool zest__queue_pipeline_request(zest_context context, zest_pipeline_template pipeline_template, const zest_rendering_info_t *rendering_info, zest_key key) {
+	zest_device device = context->device;
+	if (!ZEST_VALID_HANDLE(pipeline_template->layout, zest_struct_type_pipeline_layout)) {
+		ZEST_ALERT("ERROR: You're trying to build a pipeline (%s) that has no pipeline layout configured. You can add descriptor layouts when building the pipeline with zest_SetPipelineLayout.", pipeline_template->name);
+		return ZEST_FALSE;
+	}
+	void *scratch_memory = ZEST__ALLOCATE(context->allocator, ZEST_PIPELINE_SCRATCH_SIZE);
+	if (!scratch_memory) {
+		return ZEST_FALSE;
+	}
+	zest_pipeline_request_t *request = (zest_pipeline_request_t*)ZEST__ALLOCATE(context->allocator, sizeof(zest_pipeline_request_t));
+	*request = ZEST__ZERO_INIT(zest_pipeline_request_t);
+	request->pipeline = zest__create_pipeline(context);
+	request->pipeline->pipeline_template = pipeline_template;
+	request->pipeline->layout = pipeline_template->layout;
+	request->vert_shader = (zest_shader)zest__get_store_resource_checked(pipeline_template->vertex_shader.store, pipeline_template->vertex_shader.value);
+	if (pipeline_template->fragment_shader.value) {
+		request->frag_shader = (zest_shader)zest__get_store_resource_checked(pipeline_template->fragment_shader.store, pipeline_template->fragment_shader.value);
+	}
+	request->rendering_info = *rendering_info;
+	request->scratch_memory = scratch_memory;
+	zloc_InitialiseLinearAllocator(&request->scratch, scratch_memory, ZEST_PIPELINE_SCRATCH_SIZE);
+	request->state = zest_pipeline_status_pending;
+	zest_map_insert_key(context->allocator, context->pipeline_requests, key, request);
+	zest_job_t job = { zest__build_pipeline_task, request };
+	zest_RunJobs(device, &job, 1, &context->pipeline_jobs);
+	return ZEST_TRUE;
+}
+
+void zest__build_pipeline_task(void *data, zest_uint worker_index) {
+	zest_pipeline_request_t *request = (zest_pipeline_request_t*)data;
+	zest_device device = request->pipeline->context->device;
+	zest_bool result = device->platform->build_pipeline_background(request->pipeline, &request->rendering_info, request->vert_shader, request->frag_shader, &request->scratch);
+	zest__atomic_store(&request->state, result ? zest_pipeline_status_ready : zest_pipeline_status_failed);
+}
+
+void zest__collect_pipeline_requests(zest_context context) {
+	//Walk the map rather than the data array, data slots can be stale after removes.
+	for (int mi = (int)zest_vec_size(context->pipeline_requests.map) - 1; mi >= 0; --mi) {
+		zest_pipeline_request_t *request = context->pipeline_requests.data[context->pipeline_requests.map[mi].index];
+		int state = zest__atomic_load(&request->state);
+		if (state == zest_pipeline_status_pending) continue;
+		zest_key key = context->pipeline_requests.map[mi].key;
+		zest_pipeline_template pipeline_template = request->pipeline->pipeline_template;
+		if (state == zest_pipeline_status_ready && !zest__at_key(&context->cached_pipelines, key)) {
+			zest__insert_key(&context->cached_pipelines, key, &request->pipeline);
+			ZEST_APPEND_LOG(context->device->log_path.str, "Built pipeline %s in the background", pipeline_template->name);
+		} else {
+			//Either it failed or zest_GetPipeline built the same pipeline in the meantime
+			if (state == zest_pipeline_status_failed) {
+				ZEST__FLAG(pipeline_template->flags, zest_pipeline_invalid);
+				ZEST_APPEND_LOG(context->device->log_path.str, "Unable to build pipeline %s in the background. Check the validation errors for the reason.", pipeline_template->name);
+			}
+			zest__cleanup_pipeline(request->pipeline);
+		}
+		zest_map_remove_key(context->allocator, context->pipeline_requests, key);
+		ZEST__FREE(context->allocator, request->scratch_memory);
+		ZEST__FREE(context->allocator, request);
+	}
+}
+
+void zest__drain_pipeline_requests(zest_context context) {
+	if (!zest_vec_size(context->pipeline_requests.map)) return;
+	zest_WaitJobs(context->device, &context->pipeline_jobs);
+	zest__collect_pipeline_requests(context);
+}
+
+void zest__drain_device_pipeline_requests(zest_device device) {
+	zest_vec_foreach(i, device->contexts) {
+		zest__drain_pipeline_requests(device->contexts[i]);
+	}
+}
+
+zest_bool zest_PrecompilePipeline(zest_context context, zest_pipeline_template pipeline_template, const zest_rendering_info_t *rendering_info) {
+	ZEST_ASSERT_HANDLE(context);			//Not a valid context handle
+	ZEST_ASSERT_HANDLE(pipeline_template);	//Not a valid pipeline template handle
+	ZEST_ASSERT(rendering_info);			//You must pass the rendering info of the pass that will use the pipeline
+	if (zest__using_legacy_render_pass(context->device) || !zest_PipelineIsValid(pipeline_template)) {
+		return ZEST_FALSE;
+	}
+	zest_key key = zest__pipeline_cache_key(context->device, pipeline_template, rendering_info);
+	zest_bool locked = zest__lock_recording(context);
+	zest_bool result = ZEST_TRUE;
+	if (!zest__at_key(&context->cached_pipelines, key) && !zest_map_valid_key(context->pipeline_requests, key)) {
+		result = zest__queue_pipeline_request(context, pipeline_template, rendering_info, key);
+	}
+	zest__unlock_recording(context, locked);
+	return result;
+}
+
+zest_pipeline zest__request_pipeline(zest_pipeline_template pipeline_template, const zest_command_list command_list) {
+	zest_context context = command_list->context;
+	zest_key key = zest__pipeline_cache_key(context->device, pipeline_template, &command_list->rendering_info);
+	zest_bool locked = zest__lock_recording(context);
+	zest__collect_pipeline_requests(context);
+	zest_pipeline pipeline = 0;
+	zest_pipeline *cached_pipeline = (zest_pipeline*)zest__at_key(&context->cached_pipelines, key);
+	if (cached_pipeline) {
+		pipeline = *cached_pipeline;
+	} else if (zest_PipelineIsValid(pipeline_template) && !zest_map_valid_key(context->pipeline_requests, key)) {
+		if (zest__queue_pipeline_request(context, pipeline_template, &command_list->rendering_info, key)) {
+			//Without any worker threads the job has already run
+			zest__collect_pipeline_requests(context);
+			cached_pipeline = (zest_pipeline*)zest__at_key(&context->cached_pipelines, key);
+			if (cached_pipeline) {
+				pipeline = *cached_pipeline;
+			}
+		}
+	}
+	zest__unlock_recording(context, locked);
+	return pipeline;
+}
+
+zest_pipeline zest_RequestPipeline(zest_pipeline_template pipeline_template, const zest_command_list command_list) {
+	ZEST_ASSERT_HANDLE(pipeline_template);	//Not a valid pipeline template handle
+	zest_context context = command_list->context;
+	if (zest__using_legacy_render_pass(context->device)) {
+		//Legacy pipelines need the render pass that's only available while recording so they're built on demand
+		return zest_GetPipeline(pipeline_template, command_list);
+	}
+	//zest_SetPipelineFallback rejects cycles but the depth limit still bounds the walk
+	zest_pipeline pipeline = 0;
+	for (zest_uint depth = 0; pipeline_template && !pipeline && depth != ZEST_MAX_PIPELINE_FALLBACK_DEPTH; ++depth) {
+		pipeline = zest__request_pipeline(pipeline_template, command_list);
+		pipeline_template = pipeline_template->fallback;
+	}
 	return pipeline;
 }
 
+void zest_SetPipelineFallback(zest_pipeline_template pipeline_template, zest_pipeline_template fallback) {
+	ZEST_ASSERT_HANDLE(pipeline_template);	//Not a valid pipeline template handle
+	zest_uint depth = 1;
+	for (zest_pipeline_template next = fallback; next; next = next->fallback, ++depth) {
+		ZEST_ASSERT_OR_VALIDATE(next != pipeline_template, pipeline_template->device, "Pipeline fallbacks can't form a cycle, the fallback leads back to this pipeline.", );
+		ZEST_ASSERT_OR_VALIDATE(depth < ZEST_MAX_PIPELINE_FALLBACK_DEPTH, pipeline_template->device, "Chain of pipeline fallbacks is longer than ZEST_MAX_PIPELINE_FALLBACK_DEPTH.", );
+	}
+	pipeline_template->fallback = fallback;
+}
+
+zest_pipeline_status zest_GetPipelineStatus(zest_context context, zest_pipeline_template pipeline_template, const zest_rendering_info_t *rendering_info) {
+	ZEST_ASSERT_HANDLE(context);			//Not a valid context handle
+	ZEST_ASSERT_HANDLE(pipeline_template);	//Not a valid pipeline template handle
+	zest_key key = zest__pipeline_cache_key(context->device, pipeline_template, rendering_info);
+	zest_bool locked = zest__lock_recording(context);
+	zest__collect_pipeline_requests(context);
+	zest_pipeline_status status = zest_pipeline_status_not_requested;
+	if (zest__at_key(&context->cached_pipelines, key)) {
+		status = zest_pipeline_status_ready;
+	} else if (zest_map_valid_key(context->pipeline_requests, key)) {
+		status = zest_pipeline_status_pending;
+	} else if (!zest_PipelineIsValid(pipeline_template)) {
+		status = zest_pipeline_status_failed;
+	}
+	zest__unlock_recording(context, locked);
+	return status;
+}
+
+zest_uint zest_GetPendingPipelineCount(zest_context context) {
+	ZEST_ASSERT_HANDLE(context);			//Not a valid context handle
+	zest_bool locked = zest__lock_recording(context);
+	zest__collect_pipeline_requests(context);
+	zest_uint count = zest_vec_size(context->pipeline_requests.map);
+	zest__unlock_recording(context, locked);
+	return count;
+}
+
+void zest_WaitForPipelines(zest_context context) {
+	ZEST_ASSERT_HANDLE(context);			//Not a valid context handle
+	zest__drain_pipeline_requests(context);
+}
+
+zest_rendering_info_t zest_CreateRenderingInfo(zest_format color_format, zest_format depth_format) {
+	zest_rendering_info_t rendering_info = ZEST__ZERO_INIT(zest_rendering_info_t);
+	if (color_format != zest_format_undefined) {
+		rendering_info.color_attachment_formats[0] = color_format;
+		rendering_info.color_attachment_count = 1;
+	}
+	rendering_info.depth_attachment_format = depth_format;
+	rendering_info.sample_count = zest_sample_count_1_bit;
+	return rendering_info;
+}
+
 zest_extent2d_t zest_GetSwapChainExtent(zest_context context) { return context->swapchain->size; }
 zest_extent2d_t zest_GetWindowExtent(zest_context context) { return context->window_extent; }
 zest_uint zest_ScreenWidth(zest_context context) { return (zest_uint)context->swapchain->size.width; }
@@ -13195,6 +15743,14 @@ zest_bool zest_DeviceHasMemoryBudget(zest_device device) {
 	return zest_GetDeviceMemoryBudget(device).supported;
 }
 
+zest_bool zest_DeviceHasHostVisibleDeviceMemory(zest_device device) {
+	ZEST_ASSERT_HANDLE(device);	//Not a valid device handle
+	zest_uint heap_index = 0;
+	zest_size heap_size = 0;
+	zest_memory_property_flags property_flags = zest_memory_property_device_local_bit | zest_memory_property_host_visible_bit | zest_memory_property_host_coherent_bit;
+	return device->platform->find_memory_heap && device->platform->find_memory_heap(device, property_flags, &heap_index, &heap_size);
+}
+
 zest_memory_budget_t zest_GetDeviceMemoryBudget(zest_device device) {
 	ZEST_ASSERT_HANDLE(device);	//Not a valid device handle
 	zest_memory_budget_t budget = ZEST__ZERO_INIT(zest_memory_budget_t);
@@ -13498,94 +16054,123 @@ int zest_GetDeviceResourceCount(zest_device device, zest_device_handle_type type
 	return store->data.current_size - zest_vec_size(store->free_slots);
 }
 
-void zest__initialise_map(zest_context context, zest_map_t *map, zest_uint element_size, zest_uint capacity) {
+void zest__initialise_map(zloc_allocator *allocator, zest_map_t *map, zest_uint element_size, zest_uint capacity) {
 	*map = ZEST__ZERO_INIT(zest_map_t);
+	map->allocator = allocator;
 	map->element_size = element_size;
-	map->capacity = capacity;
-	map->table = zest__allocate(context->allocator, (element_size + sizeof(zest_key)) * capacity);
-	map->filled_slots = (zest_uint*)zest__allocate(context->allocator, sizeof(zest_uint) * capacity);
-	memset(map->table, 0, (map->element_size + sizeof(zest_key)) * capacity);
-	memset(map->filled_slots, 0, sizeof(zest_uint) * capacity);
-}
-
-zest_bool zest__insert_key(zest_map_t *map, zest_key key, void *value) {
-	// Check if key already exists first
-	void *existing_value;
-	if (zest__find_key(map, key, &existing_value)) {
-		// Key exists, update the value
-		memcpy(existing_value, value, map->element_size);
+	if (capacity) {
+		zest__ensure_capacity(map, capacity);
+	}
+}
+
+void zest__initialise_linear_map(zloc_linear_allocator_t *allocator, zest_map_t *map, zest_uint element_size, zest_uint capacity) {
+	*map = ZEST__ZERO_INIT(zest_map_t);
+	map->linear_allocator = allocator;
+	map->element_size = element_size;
+	if (capacity) {
+		zest__ensure_capacity(map, capacity);
+	}
+}
+
+ZEST_PRIVATE inline zest_byte zest__map_control(zest_key key) {
+	return (zest_byte)(0x80 | (key >> 57));
+}
+
+ZEST_PRIVATE inline void *zest__map_value(zest_map_t *map, zest_uint slot) {
+	return (char*)map->values + (zest_size)map->element_size * slot;
+}
+
+//The slot holding key or ZEST_INVALID if it's not in the map
+ZEST_PRIVATE zest_uint zest__map_find_slot(zest_map_t *map, zest_key key) {
+	if (!map->current_size) return ZEST_INVALID;
+	zest_uint mask = map->capacity - 1;
+	zest_byte control = zest__map_control(key);
+	zest_uint slot = (zest_uint)key & mask;
+	//The table is never full so there's always an empty slot to stop at
+	while (map->control[slot]) {
+		if (map->control[slot] == control && map->keys[slot] == key) {
+			return slot;
+		}
+		slot = (slot + 1) & mask;
+	}
+	return ZEST_INVALID;
+}
+
+//Put a key that isn't in the table yet in to the first free slot from its home slot
+ZEST_PRIVATE zest_uint zest__map_place_key(zest_map_t *map, zest_key key) {
+	zest_uint mask = map->capacity - 1;
+	zest_uint slot = (zest_uint)key & mask;
+	while (map->control[slot]) {
+		map->collisions++;
+		slot = (slot + 1) & mask;
+	}
+	map->control[slot] = zest__map_control(key);
+	map->keys[slot] = key;
+	map->filled_slots[map->current_size] = slot;
+	map->filled_index[slot] = map->current_size;
+	map->current_size++;
+	return slot;
+}
+
+zest_bool zest__ensure_capacity(zest_map_t *map, zest_uint required_capacity) {
+	//Keep the load under 7/8 so probe runs stay short and there's always an empty slot
+	if (map->capacity && required_capacity <= map->capacity - (map->capacity >> 3)) {
 		return ZEST_TRUE;
 	}
-	
-	// Check for capacity overflow
-	if (map->current_size >= map->capacity) {
+	zest_uint capacity = ZEST__MAX(map->capacity, 16u);
+	while (required_capacity > capacity - (capacity >> 3)) {
+		capacity <<= 1;
+	}
+	zest_size keys_size = sizeof(zest_key) * capacity;
+	zest_size values_size = ((zest_size)map->element_size * capacity + 7) & ~(zest_size)7;
+	zest_size slots_size = sizeof(zest_uint) * capacity;
+	zest_size total_size = keys_size + values_size + slots_size * 2 + capacity;
+	char *memory = map->allocator ? (char*)ZEST__ALLOCATE(map->allocator, total_size) : (char*)zest__linear_allocate(map->linear_allocator, total_size);
+	if (!memory) {
 		return ZEST_FALSE;
 	}
-	
-	zest_uint index = key % map->capacity;
-	zest_uint size = map->element_size + sizeof(zest_key);
-	zest_key *element = (zest_key*)((char*)map->table + size * index);
-	zest_uint probe = 1;
-	
-	// Find empty slot using quadratic probing
-	while (*element != 0) {
-		map->collisions++;
-		index = (index + probe * probe) % map->capacity;
-		element = (zest_key*)((char*)map->table + size * index);
-		probe++;
-		
-		// Safety check to prevent infinite loop
-		if (probe > map->capacity) {
+	zest_map_t old_map = *map;
+	map->keys = (zest_key*)memory;
+	map->values = memory + keys_size;
+	map->filled_slots = (zest_uint*)(memory + keys_size + values_size);
+	map->filled_index = (zest_uint*)(memory + keys_size + values_size + slots_size);
+	map->control = (zest_byte*)(memory + keys_size + values_size + slots_size * 2);
+	memset(map->control, 0, capacity);
+	map->capacity = capacity;
+	map->current_size = 0;
+	//Re-insert in the old order so that iteration order survives growing
+	for (zest_uint i = 0; i != old_map.current_size; ++i) {
+		zest_uint old_slot = old_map.filled_slots[i];
+		zest_uint slot = zest__map_place_key(map, old_map.keys[old_slot]);
+		memcpy(zest__map_value(map, slot), zest__map_value(&old_map, old_slot), map->element_size);
+	}
+	if (old_map.keys && map->allocator) {
+		ZEST__FREE(map->allocator, old_map.keys);
+	}
+	return ZEST_TRUE;
+}
+
+zest_bool zest__insert_key(zest_map_t *map, zest_key key, const void *value) {
+	zest_uint slot = zest__map_find_slot(map, key);
+	if (slot == ZEST_INVALID) {
+		if (!zest__ensure_capacity(map, map->current_size + 1)) {
 			return ZEST_FALSE;
 		}
+		slot = zest__map_place_key(map, key);
 	}
-	
-	// Store the key and value
-	*element = key;
-	memcpy((char*)element + sizeof(zest_key), value, map->element_size);
-	map->filled_slots[map->current_size] = index;
-	map->current_size++;
+	memcpy(zest__map_value(map, slot), value, map->element_size);
 	return ZEST_TRUE;
 }
 
-zest_bool zest__insert(zest_map_t *map, const char *name, void *value) {
+zest_bool zest__insert(zest_map_t *map, const char *name, const void *value) {
 	if (!name) return ZEST_FALSE;
 	zest_key key = zest_Hash(name, strlen(name), ZEST_HASH_SEED);
 	return zest__insert_key(map, key, value);
 }
 
 void *zest__at_key(zest_map_t *map, zest_key key) {
-	if (map->current_size == 0) return NULL;
-	
-	zest_uint index = key % map->capacity;
-	zest_uint size = map->element_size + sizeof(zest_key);
-	zest_key *element = (zest_key*)((char*)map->table + size * index);
-	zest_uint probe = 1;
-	
-	while (*element != 0) {
-		if (key == *element) {
-			return (char*)element + sizeof(zest_key);
-		}
-		index = (index + probe * probe) % map->capacity;
-		element = (zest_key*)((char*)map->table + size * index);
-		probe++;
-		
-		// Safety check to prevent infinite loop
-		if (probe > map->capacity) {
-			return NULL;
-		}
-	}
-	
-	// Key not found
-	return NULL;
-}
-
-void *zest__at_index(zest_map_t *map, zest_uint index) {
-	if (index >= map->capacity) return NULL;
-	
-	zest_uint size = map->element_size + sizeof(zest_key);
-	zest_key *element = (zest_key*)((char*)map->table + size * index);
-	return (char*)element + sizeof(zest_key);
+	zest_uint slot = zest__map_find_slot(map, key);
+	return slot == ZEST_INVALID ? NULL : zest__map_value(map, slot);
 }
 
 void *zest__at(zest_map_t *map, const char *name) {
@@ -13594,31 +16179,20 @@ void *zest__at(zest_map_t *map, const char *name) {
 	return zest__at_key(map, key);
 }
 
+void *zest__map_at_index(zest_map_t *map, zest_uint index) {
+	ZEST_ASSERT(index < map->current_size);	//Index out of range
+	return zest__map_value(map, map->filled_slots[index]);
+}
+
+zest_key zest__map_key_at_index(zest_map_t *map, zest_uint index) {
+	ZEST_ASSERT(index < map->current_size);	//Index out of range
+	return map->keys[map->filled_slots[index]];
+}
+
 zest_bool zest__find_key(zest_map_t *map, zest_key key, void **out_value) {
-	if (!out_value || map->current_size == 0) return ZEST_FALSE;
-	
-	zest_uint index = key % map->capacity;
-	zest_uint size = map->element_size + sizeof(zest_key);
-	zest_key *element = (zest_key*)((char*)map->table + size * index);
-	zest_uint probe = 1;
-	
-	while (*element != 0) {
-		if (key == *element) {
-			*out_value = (char*)element + sizeof(zest_key);
-			return ZEST_TRUE;
-		}
-		index = (index + probe * probe) % map->capacity;
-		element = (zest_key*)((char*)map->table + size * index);
-		probe++;
-		
-		// Safety check to prevent infinite loop
-		if (probe > map->capacity) {
-			break;
-		}
-	}
-	
-	*out_value = NULL;
-	return ZEST_FALSE;
+	if (!out_value) return ZEST_FALSE;
+	*out_value = zest__at_key(map, key);
+	return *out_value != NULL;
 }
 
 zest_bool zest__find(zest_map_t *map, const char *name, void **out_value) {
@@ -13627,32 +16201,62 @@ zest_bool zest__find(zest_map_t *map, const char *name, void **out_value) {
 	return zest__find_key(map, key, out_value);
 }
 
-zest_bool zest__ensure_capacity(zest_map_t *map, zest_uint required_capacity) {
-	if (required_capacity <= map->capacity) {
-		return ZEST_TRUE;
+zest_bool zest__remove_key(zest_map_t *map, zest_key key) {
+	zest_uint slot = zest__map_find_slot(map, key);
+	if (slot == ZEST_INVALID) {
+		return ZEST_FALSE;
 	}
-	
-	// Needs implementing
-	ZEST_ALERT("WARNING: zest__ensure_capacity called but not implemented. Current capacity: %u, Required: %u", 
-		map->capacity, required_capacity);
-	return ZEST_FALSE;
+	//Move the last entry in to the gap in the filled list
+	zest_uint position = map->filled_index[slot];
+	zest_uint last_slot = map->filled_slots[map->current_size - 1];
+	map->filled_slots[position] = last_slot;
+	map->filled_index[last_slot] = position;
+	map->current_size--;
+	//Shift back any entries after the gap that would no longer be found by probing from their home slot
+	zest_uint mask = map->capacity - 1;
+	zest_uint gap = slot;
+	zest_uint next = (gap + 1) & mask;
+	while (map->control[next]) {
+		zest_uint home = (zest_uint)map->keys[next] & mask;
+		//Distance from home to the entry and from home to the gap, both wrapping around the table
+		if (((next - home) & mask) >= ((next - gap) & mask)) {
+			map->control[gap] = map->control[next];
+			map->keys[gap] = map->keys[next];
+			memcpy(zest__map_value(map, gap), zest__map_value(map, next), map->element_size);
+			map->filled_index[gap] = map->filled_index[next];
+			map->filled_slots[map->filled_index[gap]] = gap;
+			gap = next;
+		}
+		next = (next + 1) & mask;
+	}
+	map->control[gap] = 0;
+	return ZEST_TRUE;
 }
 
-void zest__free_map(zest_context context, zest_map_t *map) {
-	if (!map) return;
-	
-	if (map->table) {
-		ZEST__FREE(context->allocator, map->table);
-		map->table = NULL;
+zest_bool zest__remove(zest_map_t *map, const char *name) {
+	if (!name) return ZEST_FALSE;
+	zest_key key = zest_Hash(name, strlen(name), ZEST_HASH_SEED);
+	return zest__remove_key(map, key);
+}
+
+void zest__clear_map(zest_map_t *map) {
+	if (map->control) {
+		memset(map->control, 0, map->capacity);
 	}
-	
-	if (map->filled_slots) {
-		ZEST__FREE(context->allocator, map->filled_slots);
-		map->filled_slots = NULL;
+	map->current_size = 0;
+}
+
+void zest__free_map(zest_map_t *map) {
+	if (map->keys && map->allocator) {
+		ZEST__FREE(map->allocator, map->keys);
 	}
-	
-	// Reset all fields
-	memset(map, 0, sizeof(zest_map_t));
+	zloc_allocator *allocator = map->allocator;
+	zloc_linear_allocator_t *linear_allocator = map->linear_allocator;
+	zest_uint element_size = map->element_size;
+	*map = ZEST__ZERO_INIT(zest_map_t);
+	map->allocator = allocator;
+	map->linear_allocator = linear_allocator;
+	map->element_size = element_size;
 }
 
 void zest_SetText(zloc_allocator *allocator, zest_text_t* buffer, const char* text) {
@@ -14371,6 +16975,9 @@ zest_create_context_info_t zest_CreateContextInfo(void) {
 	create_info.color_format = zest_format_b8g8r8a8_unorm;
 	create_info.flags = 0;
 	create_info.memory_pool_size = zloc__MEGABYTE(8);
+	create_info.frame_graph_cache_budget = zloc__MEGABYTE(4);
+	create_info.max_cached_frame_graphs = 0;
+	create_info.readback_ring_size = zloc__MEGABYTE(8);
     return create_info;
 }
 
@@ -14459,6 +17066,7 @@ zest_frame_graph zest__new_frame_graph(zest_context context, const char *name, z
 	//and pass bucket arrays are actually done with a linear allocator for the frame graph.
     zest_bucket_array_init(context->allocator, &frame_graph->resources, zest_resource_node_t, 8);
     zest_bucket_array_init(context->allocator, &frame_graph->potential_passes, zest_pass_node_t, 8);
+	zest__initialise_linear_map(allocator, &frame_graph->resource_names, sizeof(zest_resource_node), 32);
     return frame_graph;
 }
 
@@ -14477,52 +17085,267 @@ zest_bool zest__using_legacy_render_pass(zest_device device) {
 void zest__cache_frame_graph(zest_frame_graph frame_graph) {
     ZEST_ASSERT_HANDLE(frame_graph);        //Not a valid frame graph! Make sure you called BeginRenderGraph or BeginRenderToScreen
 	zest_context context = zest__frame_graph_builder->context;
-	//Don't cache the frame graph if the frame graph allocator had to be increased in size.
+    if (!frame_graph->cache_key) return;    //Only cache if there's a key
+    if (frame_graph->error_status) return;  //Don't cache a frame graph that had errors
+	/*
+	Graphs with a cache key are built in a linear block of their own (see zest__begin_graph) so nothing
+	else that was built this frame ends up in it. Caching is then just a case of promoting that block to
+	persistent memory, which trims the free space off the end, and pointing the builder at the frame
+	allocator for whatever is left to do in the execution. If the graph didn't fit in the block then it's
+	spread over more than one and can't be promoted, so the block size is grown to fit next time.
+	*/
 	zloc_linear_allocator_t *allocator = zest__frame_graph_builder->allocator;
+	ZEST_ASSERT(zest__frame_graph_builder->owns_allocator);	//Graphs with a cache key should always get their own block
 	if (allocator->next) {
 		zest_size capacity = zloc_GetLinearAllocatorCapacity(allocator);
-		ZEST_ALERT("Cannot cache the frame graph this frame as the frame graph allocator was not big enough. Consider increasing the size of the frame graph allocator by setting frame_graph_allocation_size in the create info of the context when you create it. The current capacity of the frame graph after being grown is %llu bytes.", capacity);
+		context->frame_graph_block_size = ZEST__MAX(context->frame_graph_block_size, capacity);
+		context->frame_graph_cache_stats.uncacheable++;
+		ZEST_ALERT("Cannot cache the frame graph [%s] this time as it didn't fit in the frame graph allocator. It will be cached the next time it's built using a block of %llu bytes. Consider increasing frame_graph_allocator_size in the create info of the context.", frame_graph->name, capacity);
 		return;
 	}
-    if (!frame_graph->cache_key) return;    //Only cache if there's a key
-    if (frame_graph->error_status) return;  //Don't cache a frame graph that had errors
-	/*
-	Improvement required here: If you execute multiple frame graphs in a frame and one is cached but the 
-	prior frame graphs were not cached then this doesn't currently take into account the fact that the start
-	of the allocation space will be filled with a frame graph that is unused and therefore shouldn't be included
-	in the cached memory. Care also needs to be taken to preserve the memory of the old frame graphs so that 
-	any deferred resources for destruction can be taken care of. So the likely solution will be to create a new 
-	block starting from the caching frame graph offset for it's capacity, trimming the free space at the end 
-	then setting the capacity of the linear allocator to the offset of the frame graph that was cached. Then 
-	when the allocator is reset n frames in the future it should check the capacity of the allocator, if it's 
-	lower then what it should be then free it and re-allocate. 
-	If frame graphs are then continued to be created after that the linear allocator will be at capacity so therefore
-	caching will not be possible at that point until the allocator is consolidated and remade. I don't know if
-	this is a problem or not, need tests to experiment.
-
-	Aside from that caching is very fast as all we do is promote the linear memory space that the frame graph
-	used and promote it to persistent memory, then allocate a new linear allocator for other graphs to use.
-	*/
 	zest_size offset = allocator->current_offset;
 	frame_graph->cached_size = offset;
-    zest_cached_frame_graph_t new_cached_graph = {
-        zloc_PromoteLinearBlock(context->allocator, allocator->data, allocator->current_offset),
-        frame_graph
-    };
+    zest_cached_frame_graph_t new_cached_graph = ZEST__ZERO_INIT(zest_cached_frame_graph_t);
+	new_cached_graph.memory = zloc_PromoteLinearBlock(context->allocator, allocator->data, offset);
+	new_cached_graph.frame_graph = frame_graph;
+	new_cached_graph.size = offset;
+	ZEST_ASSERT(new_cached_graph.memory, "Unable to promote the frame graph block to cache it.");
     ZEST__FLAG(frame_graph->flags, zest_frame_graph_is_cached);
-	void *frame_graph_linear_memory = ZEST__ALLOCATE(context->allocator, context->create_info.frame_graph_allocator_size);
-	int result = zloc_InitialiseLinearAllocator(allocator, frame_graph_linear_memory, context->create_info.frame_graph_allocator_size);
-	ZEST_ASSERT(result, "Unable to allocate a new frame graph allocator.");
+	ZEST__FREE(context->allocator, allocator);
+	zest__frame_graph_builder->allocator = &context->frame_graph_allocator[context->current_fif];
+	zest__frame_graph_builder->owns_allocator = ZEST_FALSE;
     if (zest_map_valid_key(context->cached_frame_graphs, frame_graph->cache_key)) {
         zest_cached_frame_graph_t *cached_graph = zest_map_at_key(context->cached_frame_graphs, frame_graph->cache_key);
-		//The graph being replaced holds persistent transient images and arena checkouts - retire
-		//them (deferred) before its memory goes away.
-		zest__release_frame_graph_transients(context, cached_graph->frame_graph);
-        ZEST__FREE(context->allocator, cached_graph->memory);
+		zest__free_cached_frame_graph(context, cached_graph);
         *cached_graph = new_cached_graph;
+		zest__touch_cached_frame_graph(context, cached_graph);
     } else {
+		zest__touch_cached_frame_graph(context, &new_cached_graph);
         zest_map_insert_key(context->allocator, context->cached_frame_graphs, frame_graph->cache_key, new_cached_graph);
     }
+	context->frame_graph_cache_stats.compiles++;
+	zest__evict_cached_frame_graphs(context, frame_graph->cache_key);
+}
+
+void zest__free_cached_frame_graph(zest_context context, zest_cached_frame_graph_t *cached_graph) {
+	//Retire the graph's persistent transient images (deferred - the GPU may still be using
+	//them) and return its arena checkouts before the graph memory is freed.
+	zest__release_frame_graph_transients(context, cached_graph->frame_graph);
+	ZEST__FREE(context->allocator, cached_graph->memory);
+	cached_graph->memory = 0;
+	cached_graph->frame_graph = 0;
+}
+
+void zest__touch_cached_frame_graph(zest_context context, zest_cached_frame_graph_t *cached_graph) {
+	cached_graph->last_used = ++context->frame_graph_cache_tick;
+	cached_graph->last_used_frame = context->frame_counter;
+}
+
+//Evict the least recently used graphs until the cache is back within the budget set in the create info
+//or with zest_SetFrameGraphCacheBudget. Frame graphs used in the current frame are still waiting for
+//zest_EndFrame so they're skipped, as is the graph that's just been cached, which means the budget can
+//be over for a frame if there's nothing else to evict.
+void zest__evict_cached_frame_graphs(zest_context context, zest_key keep_key) {
+	zest_size budget = context->create_info.frame_graph_cache_budget;
+	zest_uint max_graphs = context->create_info.max_cached_frame_graphs;
+	if (!budget && !max_graphs) return;
+	for (;;) {
+		zest_size cached_bytes = 0;
+		zest_uint cached_count = 0;
+		zest_key lru_key = 0;
+		zest_u64 lru_tick = 0;
+		zest_bool found = ZEST_FALSE;
+		zest_map_foreach(i, context->cached_frame_graphs) {
+			zest_hash_pair *pair = &context->cached_frame_graphs.map[i];
+			zest_cached_frame_graph_t *cached_graph = &context->cached_frame_graphs.data[pair->index];
+			cached_bytes += cached_graph->size;
+			cached_count++;
+			if (pair->key == keep_key) continue;
+			if (ZEST__NOT_FLAGGED(cached_graph->frame_graph->flags, zest_frame_graph_is_command_graph) && cached_graph->last_used_frame == context->frame_counter) continue;
+			if (!found || cached_graph->last_used < lru_tick) {
+				lru_key = pair->key;
+				lru_tick = cached_graph->last_used;
+				found = ZEST_TRUE;
+			}
+		}
+		zest_bool over_budget = (budget && cached_bytes > budget) || (max_graphs && cached_count > max_graphs);
+		if (!over_budget || !found) return;
+		zest__free_cached_frame_graph(context, zest_map_at_key(context->cached_frame_graphs, lru_key));
+		zest_map_remove_key(context->allocator, context->cached_frame_graphs, lru_key);
+		context->frame_graph_cache_stats.evictions++;
+	}
+}
+
+//Hashes everything in the declarations of a graph that the compiled structure depends on: the
+//passes, their queues and resource usages, and the resources with their formats, mips, layers and
+//identity if imported. Sizes, clear colors, pass callbacks, providers and user data are left out
+//as they're read when the graph executes, so graphs that only differ by those can share a compile.
+zest_key zest__hash_frame_graph_structure(zest_frame_graph frame_graph) {
+	zest_hasher_t hasher;
+	zest__hash_initialise(&hasher, ZEST_HASH_SEED);
+	if (frame_graph->name) zest__hasher_add(&hasher, frame_graph->name, strlen(frame_graph->name));
+	zest_frame_graph_flags flags = frame_graph->flags & (zest_frame_graph_expecting_swap_chain_usage | zest_frame_graph_is_command_graph);
+	zest__hasher_add(&hasher, &flags, sizeof(flags));
+	zest_bool timelines[2] = { frame_graph->wait_on_timeline != 0, frame_graph->signal_timeline != 0 };
+	zest__hasher_add(&hasher, timelines, sizeof(timelines));
+	zest__hasher_add(&hasher, &frame_graph->pipeline_layout, sizeof(zest_pipeline_layout));
+	zest_vec_foreach(i, frame_graph->descriptor_sets) {
+		zest__hasher_add(&hasher, &frame_graph->descriptor_sets[i], sizeof(zest_descriptor_set));
+	}
+	zest__hasher_add(&hasher, &frame_graph->swapchain, sizeof(zest_swapchain));
+
+	zest_bucket_array_foreach(i, frame_graph->resources) {
+		zest_resource_node resource = zest_bucket_array_get(&frame_graph->resources, zest_resource_node_t, i);
+		if (resource->name) zest__hasher_add(&hasher, resource->name, strlen(resource->name));
+		zest__hasher_add(&hasher, &resource->type, sizeof(zest_resource_type));
+		zest__hasher_add(&hasher, &resource->id, sizeof(zest_id));
+		zest__hasher_add(&hasher, &resource->version, sizeof(zest_uint));
+		zest__hasher_add(&hasher, &resource->original_id, sizeof(zest_uint));
+		zest__hasher_add(&hasher, &resource->flags, sizeof(zest_resource_node_flags));
+		zest__hasher_add(&hasher, &resource->buffer_desc.buffer_info.buffer_usage_flags, sizeof(zest_buffer_usage_flags));
+		zest__hasher_add(&hasher, &resource->buffer_desc.buffer_info.property_flags, sizeof(zest_memory_property_flags));
+		zest__hasher_add(&hasher, &resource->buffer_desc.buffer_info.flags, sizeof(zest_memory_pool_flags));
+		zest_image_info_t *info = &resource->image.info;
+		zest_uint image_state[6] = { info->mip_levels, info->layer_count, (zest_uint)info->format, (zest_uint)info->aspect_flags, (zest_uint)info->sample_count, (zest_uint)info->flags };
+		zest__hasher_add(&hasher, image_state, sizeof(image_state));
+		zest__hasher_add(&hasher, &resource->swapchain, sizeof(zest_swapchain));
+		zest_bool providers[2] = { resource->buffer_provider != 0, resource->image_provider != 0 };
+		zest__hasher_add(&hasher, providers, sizeof(providers));
+		//Imported resources keep their identity so a different buffer or image means a recompile,
+		//unless a provider hands over the buffer or view when the graph executes (the swapchain)
+		if (ZEST__FLAGGED(resource->flags, zest_resource_node_flag_imported) && !providers[0] && !providers[1]) {
+			zest__hasher_add(&hasher, &resource->storage_buffer, sizeof(zest_buffer));
+			zest__hasher_add(&hasher, &resource->image.backend, sizeof(zest_image_backend));
+			zest__hasher_add(&hasher, &resource->view, sizeof(zest_image_view));
+			zest__hasher_add(&hasher, &resource->linked_layout, sizeof(zest_image_layout*));
+		}
+	}
+
+	zest_bucket_array_foreach(i, frame_graph->potential_passes) {
+		zest_pass_node pass = zest_bucket_array_get(&frame_graph->potential_passes, zest_pass_node_t, i);
+		if (pass->name) zest__hasher_add(&hasher, pass->name, strlen(pass->name));
+		zest__hasher_add(&hasher, &pass->id, sizeof(zest_id));
+		zest__hasher_add(&hasher, &pass->queue_info.queue_type, sizeof(pass->queue_info.queue_type));
+		zest__hasher_add(&hasher, &pass->queue_info.timeline_wait_stage, sizeof(zest_pipeline_stage_flags));
+		zest__hasher_add(&hasher, &pass->output_key, sizeof(zest_key));
+		zest__hasher_add(&hasher, &pass->flags, sizeof(zest_pass_flags));
+		zest__hasher_add(&hasher, &pass->type, sizeof(zest_pass_type));
+		zest__hasher_add(&hasher, &pass->bind_point, sizeof(zest_pipeline_bind_point));
+		for (int direction = 0; direction != 2; ++direction) {
+			zest_map_resource_usages *usages = direction ? &pass->outputs : &pass->inputs;
+			zest_uint usage_count = zest_map_size((*usages));
+			zest__hasher_add(&hasher, &usage_count, sizeof(zest_uint));
+			zest_vec_foreach(u, usages->data) {
+				zest_resource_usage_t *usage = &usages->data[u];
+				zest_uint usage_state[11] = {
+					usage->resource_node->id, (zest_uint)usage->stage_mask, (zest_uint)usage->image_layout,
+					(zest_uint)usage->aspect_flags, (zest_uint)usage->purpose, (zest_uint)usage->access_mask,
+					(zest_uint)usage->load_op, (zest_uint)usage->store_op, (zest_uint)usage->stencil_load_op,
+					(zest_uint)usage->stencil_store_op, (zest_uint)usage->is_output
+				};
+				zest__hasher_add(&hasher, usage_state, sizeof(usage_state));
+			}
+		}
+	}
+	return (zest_key)zest__get_hash(&hasher);
+}
+
+//Look for a cached graph that was compiled from the same structure as a graph that's just been
+//declared. The cached graph for the same cache key is preferred if there is one.
+zest_frame_graph zest__find_cached_frame_graph_with_structure(zest_context context, zest_frame_graph frame_graph) {
+	if (zest_map_valid_key(context->cached_frame_graphs, frame_graph->cache_key)) {
+		zest_cached_frame_graph_t *cached_graph = zest_map_at_key(context->cached_frame_graphs, frame_graph->cache_key);
+		if (cached_graph->frame_graph->structure_hash == frame_graph->structure_hash) {
+			return cached_graph->frame_graph;
+		}
+	}
+	zest_map_foreach(i, context->cached_frame_graphs) {
+		zest_cached_frame_graph_t *cached_graph = &context->cached_frame_graphs.data[context->cached_frame_graphs.map[i].index];
+		if (cached_graph->frame_graph->structure_hash == frame_graph->structure_hash) {
+			return cached_graph->frame_graph;
+		}
+	}
+	return NULL;
+}
+
+//Bring a cached graph up to date with a graph that has the same structure but a different cache key,
+//so that it can be used instead of compiling. The waves, barriers and transient schedule all carry
+//over, only the values that are read at execution time are copied: transient sizes (placement is
+//redone every execution anyway), clear values, pass callbacks, providers and user data. The cached
+//graph is then moved to the new cache key.
+void zest__reuse_cached_frame_graph(zest_context context, zest_frame_graph cached_graph, zest_frame_graph frame_graph) {
+	ZEST_ASSERT(zest_bucket_array_size(&cached_graph->resources) == zest_bucket_array_size(&frame_graph->resources));
+	ZEST_ASSERT(zest_bucket_array_size(&cached_graph->potential_passes) == zest_bucket_array_size(&frame_graph->potential_passes));
+	zest_bucket_array_foreach(i, frame_graph->resources) {
+		zest_resource_node resource = zest_bucket_array_get(&frame_graph->resources, zest_resource_node_t, i);
+		zest_resource_node cached_resource = zest_bucket_array_get(&cached_graph->resources, zest_resource_node_t, i);
+		cached_resource->buffer_desc.size = resource->buffer_desc.size;
+		cached_resource->image.info.extent = resource->image.info.extent;
+		cached_resource->clear_color = resource->clear_color;
+		cached_resource->buffer_provider = resource->buffer_provider;
+		cached_resource->image_provider = resource->image_provider;
+		cached_resource->user_data = resource->user_data;
+	}
+	zest_bucket_array_foreach(i, frame_graph->potential_passes) {
+		zest_pass_node pass = zest_bucket_array_get(&frame_graph->potential_passes, zest_pass_node_t, i);
+		zest_pass_node cached_pass = zest_bucket_array_get(&cached_graph->potential_passes, zest_pass_node_t, i);
+		cached_pass->execution_callback = pass->execution_callback;
+		//Compiling adds resource versions to the usage maps of a pass so match them up by key
+		for (int direction = 0; direction != 2; ++direction) {
+			zest_map_resource_usages *usages = direction ? &pass->outputs : &pass->inputs;
+			zest_map_resource_usages *cached_usages = direction ? &cached_pass->outputs : &cached_pass->inputs;
+			zest_map_foreach(u, (*usages)) {
+				zest_key key = usages->map[u].key;
+				if (zest_map_valid_key((*cached_usages), key)) {
+					zest_resource_usage_t *cached_usage = zest_map_at_key((*cached_usages), key);
+					cached_usage->clear_value = usages->data[usages->map[u].index].clear_value;
+				}
+			}
+		}
+	}
+	//Pass groups hold copies of the usages of their passes, and the depth clear value is copied in to
+	//the render pass when it's prepared
+	zest_map_foreach(i, cached_graph->final_passes) {
+		zest_pass_group_t *group = &cached_graph->final_passes.data[i];
+		zest_vec_foreach(p, group->passes) {
+			zest_pass_node pass = group->passes[p];
+			zest_map_foreach(o, pass->outputs) {
+				zest_key key = pass->outputs.map[o].key;
+				if (zest_map_valid_key(group->outputs, key)) {
+					zest_resource_usage_t *group_usage = zest_map_at_key(group->outputs, key);
+					group_usage->clear_value = pass->outputs.data[pass->outputs.map[o].index].clear_value;
+					if (group_usage->purpose == zest_purpose_depth_stencil_attachment_write && group->execution_details.depth_attachment.image_view) {
+						group->execution_details.depth_attachment.clear_value = group_usage->clear_value;
+					}
+				}
+			}
+		}
+	}
+	cached_graph->user_data = frame_graph->user_data;
+	cached_graph->semaphores = frame_graph->semaphores;
+	cached_graph->command_list.backend = frame_graph->command_list.backend;
+	if (frame_graph->wait_on_timeline) {
+		cached_graph->wait_on_timeline = frame_graph->wait_on_timeline;
+	}
+	if (frame_graph->signal_timeline) {
+		cached_graph->signal_timeline = frame_graph->signal_timeline;
+	}
+	if (cached_graph->cache_key != frame_graph->cache_key) {
+		zest_cached_frame_graph_t entry = *zest_map_at_key(context->cached_frame_graphs, cached_graph->cache_key);
+		zest_map_remove_key(context->allocator, context->cached_frame_graphs, cached_graph->cache_key);
+		if (zest_map_valid_key(context->cached_frame_graphs, frame_graph->cache_key)) {
+			//A graph with a different structure was cached under the new key, it's replaced
+			zest_cached_frame_graph_t *replaced = zest_map_at_key(context->cached_frame_graphs, frame_graph->cache_key);
+			zest__free_cached_frame_graph(context, replaced);
+			*replaced = entry;
+		} else {
+			zest_map_insert_key(context->allocator, context->cached_frame_graphs, frame_graph->cache_key, entry);
+		}
+		cached_graph->cache_key = frame_graph->cache_key;
+	}
+	zest__touch_cached_frame_graph(context, zest_map_at_key(context->cached_frame_graphs, cached_graph->cache_key));
+	context->frame_graph_cache_stats.compile_reuses++;
+	ZEST__FLAG(cached_graph->flags, zest_frame_graph_reused_compile);
 }
 
 zest_image_view zest__swapchain_resource_provider(zest_context context, zest_resource_node resource) {
@@ -14562,22 +17385,41 @@ zest_frame_graph zest_GetCachedFrameGraph(zest_context context, zest_frame_graph
 	zest_key key = zest__hash_frame_graph_cache_key(cache_key);
     if (zest_map_valid_key(context->cached_frame_graphs, key)) {
         zest_cached_frame_graph_t *cached_graph = zest_map_at_key(context->cached_frame_graphs, key);
+		zest__touch_cached_frame_graph(context, cached_graph);
+		context->frame_graph_cache_stats.hits++;
         return cached_graph->frame_graph;
     }
+	context->frame_graph_cache_stats.misses++;
     return NULL;
 }
 
 void zest_FlushCachedFrameGraphs(zest_context context) {
+	//Removed keys leave their slot in data so only go through the slots that the map points to
 	zest_map_foreach(i, context->cached_frame_graphs) {
-		zest_cached_frame_graph_t cached_graph = context->cached_frame_graphs.data[i];
-		//Retire the graph's persistent transient images (deferred - the GPU may still be using
-		//them) and return its arena checkouts before the graph memory is freed.
-		zest__release_frame_graph_transients(context, cached_graph.frame_graph);
-		ZEST__FREE(context->allocator, cached_graph.memory);
+		zest__free_cached_frame_graph(context, &context->cached_frame_graphs.data[zest_map_index(context->cached_frame_graphs, i)]);
 	}
 	zest_map_clear(context->cached_frame_graphs);
 }
 
+void zest_SetFrameGraphCacheBudget(zest_context context, zest_size budget, zest_uint max_graphs) {
+	context->create_info.frame_graph_cache_budget = budget;
+	context->create_info.max_cached_frame_graphs = max_graphs;
+	zest__evict_cached_frame_graphs(context, 0);
+}
+
+zest_frame_graph_cache_stats_t zest_GetFrameGraphCacheStats(zest_context context) {
+	zest_frame_graph_cache_stats_t stats = context->frame_graph_cache_stats;
+	stats.cached_count = 0;
+	stats.cached_bytes = 0;
+	zest_map_foreach(i, context->cached_frame_graphs) {
+		stats.cached_bytes += context->cached_frame_graphs.data[zest_map_index(context->cached_frame_graphs, i)].size;
+		stats.cached_count++;
+	}
+	stats.budget = context->create_info.frame_graph_cache_budget;
+	stats.max_graphs = context->create_info.max_cached_frame_graphs;
+	return stats;
+}
+
 zest_frame_graph_cache_key_t zest_InitialiseCacheKey(zest_context context, const void *user_state, zest_size user_state_size) {
     zest_frame_graph_cache_key_t key = ZEST__ZERO_INIT(zest_frame_graph_cache_key_t);
 	if (context->swapchain) {
@@ -14601,17 +17443,22 @@ zest_bool zest__begin_graph(zest_context context, const char *name, zest_frame_g
 	//did you call EndFrameGraph?
 
 	zest_device device = context->device;
-	if (!is_command_graph && ZEST__FLAGGED(context->flags, zest_context_flag_frame_started)) {
+	if (!is_command_graph && !cache_key && ZEST__FLAGGED(context->flags, zest_context_flag_frame_started)) {
 		zloc_linear_allocator_t *allocator = &context->frame_graph_allocator[context->current_fif];
 		zest__frame_graph_builder = (zest_frame_graph_builder)zest__linear_allocate(allocator, sizeof(zest_frame_graph_builder_t));
 		zest__frame_graph_builder->allocator = allocator;
+		zest__frame_graph_builder->owns_allocator = ZEST_FALSE;
 	} else {
-		void *linear_memory_block = ZEST__ALLOCATE(context->allocator, context->create_info.frame_graph_allocator_size);
+		//Command graphs and graphs that might be cached get a block of their own, see zest__cache_frame_graph
+		zest_size block_size = cache_key ? context->frame_graph_block_size : context->create_info.frame_graph_allocator_size;
+		void *linear_memory_block = ZEST__ALLOCATE(context->allocator, block_size);
 		zloc_linear_allocator_t *allocator = (zloc_linear_allocator_t*)ZEST__ALLOCATE(context->allocator, sizeof(zloc_linear_allocator_t));
 		*allocator = ZEST__ZERO_INIT(zloc_linear_allocator_t);
-		zloc_InitialiseLinearAllocator(allocator, linear_memory_block, context->create_info.frame_graph_allocator_size);
+		zloc_InitialiseLinearAllocator(allocator, linear_memory_block, block_size);
+		zloc_SetLinearAllocatorUserData(allocator, context);
 		zest__frame_graph_builder = (zest_frame_graph_builder)zest__linear_allocate(allocator, sizeof(zest_frame_graph_builder_t));
 		zest__frame_graph_builder->allocator = allocator;
+		zest__frame_graph_builder->owns_allocator = ZEST_TRUE;
 	}
 	zest__frame_graph_builder->context = context;
 	zest__frame_graph_builder->current_pass = 0;
@@ -14924,6 +17771,9 @@ zest_frame_graph zest__compile_frame_graph() {
 	zest_context context = zest__frame_graph_builder->context;
 	ZEST_ASSERT_HANDLE(frame_graph);        //Not a valid frame graph! Make sure you called BeginRenderGraph or BeginRenderToScreen
 	ZEST_CPU_PROFILE_BEGIN(context, "Compile %s", frame_graph->name);
+	frame_graph->timings = ZEST__ZERO_INIT(zest_frame_graph_timings_t);
+	zest_microsecs compile_start = zest_Microsecs();
+	zest_microsecs lap_start = compile_start;
 
 	//Early exit if the frame graph is already invalid - ie., duplicate names in graph
 	if (frame_graph->error_status & ZEST_FGS_FATAL) {
@@ -14936,6 +17786,11 @@ zest_frame_graph zest__compile_frame_graph() {
 		zest_SignalTimeline(timeline);
 	}
 
+	//Readback callbacks fire once the timeline that the graph signals reaches the value it was submitted with
+	if (ZEST__FLAGGED(frame_graph->flags, zest_frame_graph_has_readbacks) && !frame_graph->signal_timeline) {
+		zest_SignalTimeline(zest_GetUtilityTimeline(context));
+	}
+
 	zloc_linear_allocator_t *allocator = zest__frame_graph_builder->allocator;
 
 	//Cyclic-dependency detection is folded into the Kahn-style wave build below: any pass that
@@ -15033,6 +17888,8 @@ zest_frame_graph zest__compile_frame_graph() {
         }
     }
 
+    frame_graph->timings.culling = zest__lap_microsecs(&lap_start);
+
     //Now group the potential passes in to final passes by ignoring any culled passes and grouping together passes that
     //have the same output. We need to be careful here though to make sure that even though 2 passes might share the same output
     //they might have conflicting dependencies. Output keys are generated by hashing the usage options for the resource.
@@ -15225,7 +18082,7 @@ zest_frame_graph zest__compile_frame_graph() {
                 if (!zest_map_valid_name(pass_node->inputs, resource->name)) {
                     //If not then add the resource as input for correct dependency chain with default usages
                     zest_resource_usage_t input_usage = ZEST__ZERO_INIT(zest_resource_usage_t);
-                    switch (pass_node->queue_info.queue_type) {
+                    switch (output_usage->purpose == zest_purpose_transfer_image_write ? zest_queue_transfer : pass_node->queue_info.queue_type) {
 						case zest_queue_graphics: {
 							if (resource->image.info.flags & zest_image_flag_depth_stencil_attachment) {
 								input_usage = zest__configure_image_usage(resource, zest_purpose_depth_stencil_attachment_read_write, resource->image.info.format, output_usage->load_op, output_usage->stencil_load_op, output_usage->stage_mask);
@@ -15235,9 +18092,17 @@ zest_frame_graph zest__compile_frame_graph() {
 							break;
 						}
 						case zest_queue_compute:
-						case zest_queue_transfer:
 							input_usage = zest__configure_image_usage(resource, zest_purpose_storage_image_read, resource->image.info.format, output_usage->load_op, output_usage->stencil_load_op, output_usage->stage_mask);
 							break;
+						case zest_queue_transfer:
+							if (output_usage->purpose == zest_purpose_transfer_image_write) {
+								//Keep the copy destination layout so the earlier contents carry into this write
+								input_usage = zest__configure_image_usage(resource, zest_purpose_transfer_image_write, resource->image.info.format, output_usage->load_op, output_usage->stencil_load_op, output_usage->stage_mask);
+								input_usage.is_output = ZEST_FALSE;
+							} else {
+								input_usage = zest__configure_image_usage(resource, zest_purpose_storage_image_read, resource->image.info.format, output_usage->load_op, output_usage->stencil_load_op, output_usage->stage_mask);
+							}
+							break;
                     }
                     input_usage.store_op = output_usage->store_op;
                     input_usage.stencil_store_op = output_usage->stencil_store_op;
@@ -15286,6 +18151,8 @@ zest_frame_graph zest__compile_frame_graph() {
         }
     }
     
+	frame_graph->timings.dependencies = zest__lap_microsecs(&lap_start);
+
 	//[Create_execution_waves]
 	zest_execution_wave_t *initial_waves = 0;
     zest_execution_wave_t first_wave = ZEST__ZERO_INIT(zest_execution_wave_t);
@@ -15693,6 +18560,8 @@ zest_frame_graph zest__compile_frame_graph() {
 		}
     }
 
+    frame_graph->timings.waves = zest__lap_microsecs(&lap_start);
+
     //Plan_transient_buffers
     zest_bucket_array_foreach(resource_index, frame_graph->resources) {
         zest_resource_node resource = zest_bucket_array_get(&frame_graph->resources, zest_resource_node_t, resource_index);
@@ -15813,6 +18682,8 @@ zest_frame_graph zest__compile_frame_graph() {
         }
     }
 
+    frame_graph->timings.transient_planning = zest__lap_microsecs(&lap_start);
+
     //Plan_resource_barriers
     zest_bucket_array_foreach(resource_index, frame_graph->resources) {
         zest_resource_node resource = zest_bucket_array_get(&frame_graph->resources, zest_resource_node_t, resource_index);
@@ -15983,6 +18854,8 @@ zest_frame_graph zest__compile_frame_graph() {
         }
     }
 
+    frame_graph->timings.barriers = zest__lap_microsecs(&lap_start);
+
     //Process_compiled_execution_order
 	//Prepare_render_pass
     zest_vec_foreach(submission_index, frame_graph->submissions) {
@@ -16034,6 +18907,8 @@ zest_frame_graph zest__compile_frame_graph() {
 		zest_SetDescriptorSets(context->device->pipeline_layout, &set, 1);
 	}
 
+	frame_graph->timings.render_passes = zest__lap_microsecs(&lap_start);
+	frame_graph->timings.compile = lap_start - compile_start;
 	ZEST_CPU_PROFILE_END(context);
     return frame_graph;
 }
@@ -16143,8 +19018,21 @@ void zest__prepare_render_pass(zest_pass_group_t *pass, zest_execution_details_t
 
 zest_frame_graph zest_EndFrameGraph(void) {
 	if (!zest__frame_graph_builder) return NULL;
-    zest_frame_graph frame_graph = zest__compile_frame_graph();
 	zest_context context = zest__frame_graph_builder->context;
+	zest_frame_graph declared_graph = zest__frame_graph_builder->frame_graph;
+	//A graph with a cache key that has the same structure as one already cached, for example
+	//when only a transient size or pass callback changed, reuses that compile rather than running
+	//a new one. Compiling adds to the declarations so the structure is hashed first.
+	if (declared_graph->cache_key && !declared_graph->error_status && !zest__frame_graph_builder->current_pass) {
+		declared_graph->structure_hash = zest__hash_frame_graph_structure(declared_graph);
+		zest_frame_graph cached_graph = zest__find_cached_frame_graph_with_structure(context, declared_graph);
+		if (cached_graph) {
+			zest__reuse_cached_frame_graph(context, cached_graph, declared_graph);
+			zest__frame_graph_builder->frame_graph = cached_graph;
+			return cached_graph;
+		}
+	}
+    zest_frame_graph frame_graph = zest__compile_frame_graph();
 
     ZEST_MAYBE_REPORT(context->device, zest__frame_graph_builder->current_pass, zest_report_missing_end_pass, "Warning in frame graph [%s]: The current pass in the frame graph context is not null. This means that a call to zest_EndPass is missing in the frame graph setup.", frame_graph->name);
     zest__frame_graph_builder->current_pass = 0;
@@ -16250,6 +19138,10 @@ zest_semaphore_status zest_FlushFrameGraph(zest_frame_graph frame_graph) {
 	zest__cleanup_frame_graph_builder();
 	zloc_ResetLinearAllocator(&context->frame_graph_allocator[context->current_fif]);
 
+	if (status == zest_semaphore_status_success) {
+		zest_PollReadbacks(context);
+	}
+
 	return status;
 }
 
@@ -16376,8 +19268,7 @@ void zest__deferr_view_array_destruction(zest_context context, zest_frame_graph
 void zest__cleanup_frame_graph_builder() {
 	if (zest__frame_graph_builder) {
 		zest_context context = zest__frame_graph_builder->context;
-		zest_frame_graph frame_graph = zest__frame_graph_builder->frame_graph;
-		if (ZEST__FLAGGED(frame_graph->flags, zest_frame_graph_is_command_graph)) {
+		if (zest__frame_graph_builder->owns_allocator) {
 			zloc_linear_allocator_t *allocator = zest__frame_graph_builder->allocator->next;
 			while (allocator) {
 				zloc_linear_allocator_t *next_allocator = allocator->next;
@@ -16394,9 +19285,311 @@ void zest__cleanup_frame_graph_builder() {
 	}
 }
 
+void zest__bind_frame_graph_descriptor_sets(zest_frame_graph frame_graph, zest_command_list command_list, zest_submission_batch_t *batch, zest_bool using_legacy_render_pass) {
+	// Bind the global bindless descriptor set for graphics and compute queues
+	if (batch->queue_type == zest_queue_transfer || !frame_graph->descriptor_sets) {
+		return;
+	}
+	if (batch->queue_type == zest_queue_graphics && !using_legacy_render_pass) {
+		// Graphics queue can do both graphics and compute
+		// If it's a legacy render pass on vulkan then we bind inside the render pass (see zest__record_pass_group)
+		zest_cmd_BindDescriptorSets(command_list, zest_bind_point_graphics, frame_graph->pipeline_layout, frame_graph->descriptor_sets, zest_vec_size(frame_graph->descriptor_sets), 0);
+		zest_cmd_BindDescriptorSets(command_list, zest_bind_point_compute, frame_graph->pipeline_layout, frame_graph->descriptor_sets, zest_vec_size(frame_graph->descriptor_sets), 0);
+	} else {
+		// Compute queue is compute-only
+		zest_cmd_BindDescriptorSets(command_list, zest_bind_point_compute, frame_graph->pipeline_layout, frame_graph->descriptor_sets, zest_vec_size(frame_graph->descriptor_sets), 0);
+	}
+}
+
+zest_bool zest__reserve_pass_group_gpu_profile(zest_context context, zest_submission_batch_t *batch, zest_pass_group_t *grouped_pass, zest_uint *query_index) {
+	// GPU profiling: reserve the query pair for this grouped pass immediately so user sub-region calls don't collide
+	if (ZEST__NOT_FLAGGED(context->flags, zest_context_flag_gpu_profiling_enabled) || !context->gpu_profiler.enabled) {
+		return ZEST_FALSE;
+	}
+	zest_gpu_profiler_t *gpu_profiler = &context->gpu_profiler;
+	zest_uint fif = context->current_fif;
+	zest_uint gpu_profile_query_index = gpu_profiler->query_count[fif];
+	if (gpu_profile_query_index + 2 > gpu_profiler->max_queries) {
+		return ZEST_FALSE;
+	}
+	zest_uint pair_index = gpu_profile_query_index / 2;
+	const char *pass_name = zest_vec_size(grouped_pass->passes) > 0 ? grouped_pass->passes[0]->name : "unknown";
+	snprintf(gpu_profiler->query_map[fif][pair_index].name, ZEST_GPU_PROFILE_NAME_LENGTH, "%s", pass_name);
+	gpu_profiler->query_map[fif][pair_index].queue_type = batch->queue_type;
+	gpu_profiler->query_map[fif][pair_index].depth = 0;
+	gpu_profiler->query_count[fif] += 2;
+	*query_index = gpu_profile_query_index;
+	return ZEST_TRUE;
+}
+
+void zest__record_pass_group(zest_context context, zest_frame_graph frame_graph, zest_command_list command_list, zest_pass_group_t *grouped_pass, zest_bool gpu_profile_active, zest_uint gpu_profile_query_index, zest_bool using_legacy_render_pass) {
+	zest_device device = context->device;
+	zest_execution_details_t *exe_details = &grouped_pass->execution_details;
+	//The CPU profiler isn't thread safe so pass timings are skipped when recording on worker threads
+	zest_bool on_worker = ZEST__FLAGGED(context->flags, zest_context_flag_recording_in_parallel);
+
+	//Transient resources were placed and materialised before recording started (see
+	//zest__place_transient_resources), so there is nothing to create per pass here.
+
+	//Batch execute acquire barriers for images and buffers
+	device->platform->acquire_barrier(command_list, exe_details);
+
+	// GPU profiling: write begin timestamp for this grouped pass
+	if (gpu_profile_active) {
+		device->platform->write_timestamp(command_list, command_list->gpu_profiler, context->current_fif, gpu_profile_query_index, ZEST_FALSE);
+	}
+
+	zest_bool has_render_pass = exe_details->requires_render_pass;
+
+	//Begin the render pass if the pass has one
+	if (has_render_pass) {
+		device->platform->begin_render_pass(command_list, exe_details);
+
+		// Bind the global bindless descriptor set for graphics and compute queues
+		if (frame_graph->descriptor_sets && using_legacy_render_pass) {
+			// Have to bind the descriptors here otherwise it can throw a validation error
+			// with legacy render passes
+			// Graphics queue can do both graphics and compute
+			zest_cmd_BindDescriptorSets(command_list, zest_bind_point_graphics, frame_graph->pipeline_layout, frame_graph->descriptor_sets, zest_vec_size(frame_graph->descriptor_sets), 0);
+			zest_cmd_BindDescriptorSets(command_list, zest_bind_point_compute, frame_graph->pipeline_layout, frame_graph->descriptor_sets, zest_vec_size(frame_graph->descriptor_sets), 0);
+		}
+
+		command_list->rendering_info = exe_details->rendering_info;
+		command_list->began_rendering = ZEST_TRUE;
+	}
+
+	// CPU profiling: begin timing for this grouped pass
+	zest_bool cpu_profile_active = ZEST_FALSE;
+	if (!on_worker && ZEST__FLAGGED(context->flags, zest_context_flag_cpu_profiling_enabled) && context->cpu_profiler.enabled) {
+		const char *cpu_pass_name = zest_vec_size(grouped_pass->passes) > 0 ? grouped_pass->passes[0]->name : "unknown";
+		ZEST_CPU_PROFILE_BEGIN(context, "%s", cpu_pass_name);
+		cpu_profile_active = ZEST_TRUE;
+	}
+
+	//Execute the callbacks in the pass
+	zest_vec_foreach(pass_callback_index, grouped_pass->passes) {
+		zest_pass_node pass = grouped_pass->passes[pass_callback_index];
+
+		if (pass->type == zest_pass_type_graphics && !command_list->began_rendering) {
+			ZEST_REPORT(device, zest_report_render_pass_skipped, "Pass execution was skipped for pass [%s] becuase rendering did not start. Check for validation errors.", pass->name);
+			continue;
+		}
+		command_list->pass_node = pass;
+		command_list->frame_graph = frame_graph;
+		command_list->rendering_info.render_pass_key = exe_details->render_pass_key;
+		pass->execution_callback.callback(command_list, pass->execution_callback.user_data);
+	}
+
+	// CPU profiling: end timing for this grouped pass
+	if (cpu_profile_active) {
+		ZEST_CPU_PROFILE_END(context);
+	}
+
+	// GPU profiling: draw built-in overlay if both profiling and debug overlay are enabled
+	if (gpu_profile_active && ZEST__FLAGGED(context->flags, zest_context_flag_debug_overlay_enabled) && ZEST__FLAGGED(grouped_pass->flags, zest_pass_flag_outputs_to_swapchain)) {
+		zest__draw_gpu_profile_overlay(context);
+	}
+
+	// CPU profiling: draw built-in overlay
+	if (ZEST__FLAGGED(context->flags, zest_context_flag_cpu_profiling_enabled) && ZEST__FLAGGED(context->flags, zest_context_flag_debug_overlay_enabled) && ZEST__FLAGGED(grouped_pass->flags, zest_pass_flag_outputs_to_swapchain)) {
+		zest__draw_cpu_profile_overlay(context);
+	}
+
+	if (ZEST__FLAGGED(context->flags, zest_context_flag_debug_overlay_enabled) && context->db_overlay.vertex_count > 0 && ZEST__FLAGGED(grouped_pass->flags, zest_pass_flag_outputs_to_swapchain)) {
+		zest__draw_debug_overlay(command_list);
+	}
+
+	// GPU profiling: write end timestamp for this grouped pass
+	if (gpu_profile_active) {
+		device->platform->write_timestamp(command_list, command_list->gpu_profiler, context->current_fif, gpu_profile_query_index + 1, ZEST_TRUE);
+	}
+
+	zest_map_foreach(pass_input_index, grouped_pass->inputs) {
+		zest_resource_node resource = grouped_pass->inputs.data[pass_input_index].resource_node;
+		if (resource->aliased_resource) {
+			resource->aliased_resource->current_state_index++;
+		} else {
+			resource->current_state_index++;
+		}
+	}
+
+	zest_map_foreach(pass_output_index, grouped_pass->outputs) {
+		zest_resource_node resource = grouped_pass->outputs.data[pass_output_index].resource_node;
+		if (resource->aliased_resource) {
+			resource->aliased_resource->current_state_index++;
+		} else {
+			resource->current_state_index++;
+		}
+	}
+
+	if (has_render_pass) {
+		device->platform->end_render_pass(command_list);
+		command_list->began_rendering = ZEST_FALSE;
+	}
+
+	//Batch execute release barriers for images and buffers
+	device->platform->release_barrier(command_list, exe_details);
+}
+
+zest_uint zest__partition_batch_pass_groups(zest_frame_graph frame_graph, zest_submission_batch_t *batch, zest_uint group_count, zloc_linear_allocator_t *allocator, zest_uint **task_of_group) {
+	//Union find over the pass groups in the batch. Groups that touch the same resource (or the resource
+	//it aliases) have to be recorded by the same worker, in order, so that the resource state indexes
+	//advance exactly as they would when recording serially. The root of each set is its lowest group.
+	zest_uint *parent = (zest_uint*)zest__linear_allocate(allocator, sizeof(zest_uint) * group_count);
+	zest_uint *tasks = (zest_uint*)zest__linear_allocate(allocator, sizeof(zest_uint) * group_count);
+	zest_map_resource_owners owners = ZEST__ZERO_INIT(zest_map_resource_owners);
+	for (zest_uint group = 0; group != group_count; ++group) {
+		parent[group] = group;
+	}
+	for (zest_uint group = 0; group != group_count; ++group) {
+		zest_pass_group_t *grouped_pass = &frame_graph->final_passes.data[batch->pass_indices[group]];
+		for (int is_output = 0; is_output != 2; ++is_output) {
+			zest_map_resource_usages *usages = is_output ? &grouped_pass->outputs : &grouped_pass->inputs;
+			zest_map_foreach(usage_index, (*usages)) {
+				zest_resource_node resource = usages->data[usage_index].resource_node;
+				if (resource->aliased_resource) {
+					resource = resource->aliased_resource;
+				}
+				zest_key key = (zest_key)resource;
+				if (!zest_map_valid_key(owners, key)) {
+					zest_map_insert_linear_key(allocator, owners, key, group);
+					continue;
+				}
+				zest_uint a = *zest_map_at_key(owners, key);
+				zest_uint b = group;
+				while (parent[a] != a) a = parent[a] = parent[parent[a]];
+				while (parent[b] != b) b = parent[b] = parent[parent[b]];
+				if (a < b) parent[b] = a;
+				else if (b < a) parent[a] = b;
+			}
+		}
+	}
+	zest_uint task_count = 0;
+	for (zest_uint group = 0; group != group_count; ++group) {
+		zest_uint root = group;
+		while (parent[root] != root) root = parent[root];
+		//Roots are always the lowest group in their set so they've been assigned by the time we get here
+		tasks[group] = root == group ? task_count++ : tasks[root];
+	}
+	*task_of_group = tasks;
+	return task_count;
+}
+
+zest_bool zest__lock_recording(zest_context context) {
+	if (ZEST__FLAGGED(context->flags, zest_context_flag_recording_in_parallel)) {
+		zest__sync_lock(&context->recording_sync);
+		return ZEST_TRUE;
+	}
+	return ZEST_FALSE;
+}
+
+void zest__unlock_recording(zest_context context, zest_bool locked) {
+	if (locked) {
+		zest__sync_unlock(&context->recording_sync);
+	}
+}
+
+void zest__record_pass_group_task(void *data, zest_uint worker_index) {
+	zest_pass_group_recording_t *task = (zest_pass_group_recording_t*)data;
+	zest_context context = task->context;
+	zest_device device = context->device;
+	zest_frame_graph frame_graph = task->frame_graph;
+	zest_submission_batch_t *batch = task->batch;
+	//Pass callbacks and the bindless helpers they call expect to find the frame graph builder, which is
+	//thread local, so the worker borrows the dispatching thread's builder while it records.
+	zest_frame_graph_builder previous_builder = zest__frame_graph_builder;
+	zest_sync_t *previous_guard = zest__linear_allocator_guard;
+	zest__frame_graph_builder = task->builder;
+	zest__linear_allocator_guard = &context->linear_allocator_sync;
+	zest_vec_foreach(i, task->group_positions) {
+		zest_uint position = task->group_positions[i];
+		zest_command_list command_list = &frame_graph->batch_command_lists[position];
+		if (!device->platform->set_worker_command_buffer(command_list, batch->queue, task->slot) || !device->platform->begin_command_buffer(command_list)) {
+			task->failed = ZEST_TRUE;
+			break;
+		}
+		zest__bind_frame_graph_descriptor_sets(frame_graph, command_list, batch, ZEST_FALSE);
+		zest_pass_group_t *grouped_pass = &frame_graph->final_passes.data[batch->pass_indices[position]];
+		zest__record_pass_group(context, frame_graph, command_list, grouped_pass, task->gpu_profile_active[position], task->gpu_profile_query_indexes[position], ZEST_FALSE);
+		device->platform->end_command_buffer(command_list);
+	}
+	zest__frame_graph_builder = previous_builder;
+	zest__linear_allocator_guard = previous_guard;
+}
+
+zest_bool zest__record_batch_in_parallel(zest_context context, zest_frame_graph frame_graph, zest_submission_batch_t *batch, zest_uint group_count, zest_uint task_count, zest_uint *task_of_group) {
+	zest_device device = context->device;
+	zloc_linear_allocator_t *allocator = zest__frame_graph_builder->allocator;
+	//There's no point in more tasks than there are threads to run them, and capping them means each task
+	//can own a worker command pool regardless of which thread ends up running it (threads outside the job
+	//system all share worker index 0 so that can't be used to pick a pool). Independent sets can always
+	//be folded together as each task records its groups in batch order.
+	task_count = ZEST__MIN(task_count, zest_GetJobWorkerCount(device));
+	if (!device->platform->prepare_worker_command_pools(context, batch->queue, task_count)) {
+		return ZEST_FALSE;
+	}
+
+	//Everything that isn't thread safe is set up here before any work is handed out: the command lists
+	//and their backends, the GPU profiler queries and the task lists.
+	zest_vec_linear_resize(allocator, frame_graph->batch_command_lists, group_count);
+	zest_uint *gpu_profile_query_indexes = (zest_uint*)zest__linear_allocate(allocator, sizeof(zest_uint) * group_count);
+	zest_bool *gpu_profile_active = (zest_bool*)zest__linear_allocate(allocator, sizeof(zest_bool) * group_count);
+	zest_gpu_profiler_t *gpu_profiler = ZEST__FLAGGED(context->flags, zest_context_flag_gpu_profiling_enabled) ? &context->gpu_profiler : 0;
+	for (zest_uint group = 0; group != group_count; ++group) {
+		zest_command_list command_list = &frame_graph->batch_command_lists[group];
+		*command_list = frame_graph->command_list;
+		command_list->backend = (zest_command_list_backend)device->platform->new_frame_graph_context_backend(context);
+		command_list->gpu_profiler = gpu_profiler;
+		command_list->began_rendering = ZEST_FALSE;
+		zest_pass_group_t *grouped_pass = &frame_graph->final_passes.data[batch->pass_indices[group]];
+		gpu_profile_query_indexes[group] = 0;
+		gpu_profile_active[group] = zest__reserve_pass_group_gpu_profile(context, batch, grouped_pass, &gpu_profile_query_indexes[group]);
+	}
+
+	zest_pass_group_recording_t *tasks = (zest_pass_group_recording_t*)zest__linear_allocate(allocator, sizeof(zest_pass_group_recording_t) * task_count);
+	for (zest_uint t = 0; t != task_count; ++t) {
+		zest_pass_group_recording_t *task = &tasks[t];
+		*task = ZEST__ZERO_INIT(zest_pass_group_recording_t);
+		task->context = context;
+		task->frame_graph = frame_graph;
+		task->builder = zest__frame_graph_builder;
+		task->batch = batch;
+		task->slot = t;
+		task->gpu_profile_query_indexes = gpu_profile_query_indexes;
+		task->gpu_profile_active = gpu_profile_active;
+	}
+	for (zest_uint group = 0; group != group_count; ++group) {
+		zest_vec_linear_push(allocator, tasks[task_of_group[group] % task_count].group_positions, group);
+	}
+
+	ZEST__FLAG(context->flags, zest_context_flag_recording_in_parallel);
+	zest__linear_allocator_guard = &context->linear_allocator_sync;
+	zest_job_t *jobs = (zest_job_t*)zest__linear_allocate(allocator, sizeof(zest_job_t) * task_count);
+	for (zest_uint t = 0; t != task_count; ++t) {
+		jobs[t].callback = zest__record_pass_group_task;
+		jobs[t].data = &tasks[t];
+	}
+	zest_job_counter_t counter = ZEST__ZERO_INIT(zest_job_counter_t);
+	zest_RunJobs(device, jobs, task_count, &counter);
+	zest_WaitJobs(device, &counter);
+	zest__linear_allocator_guard = NULL;
+	ZEST__UNFLAG(context->flags, zest_context_flag_recording_in_parallel);
+
+	for (zest_uint t = 0; t != task_count; ++t) {
+		if (tasks[t].failed) {
+			return ZEST_FALSE;
+		}
+	}
+	return ZEST_TRUE;
+}
+
 zest_bool zest__execute_frame_graph(zest_context context, zest_frame_graph frame_graph) {
     ZEST_ASSERT_HANDLE(frame_graph);        //Not a valid frame graph! Make sure you called BeginRenderGraph or BeginRenderToScreen
 	ZEST_CPU_PROFILE_BEGIN(context, "Run %s", frame_graph->name);
+	zest_microsecs execute_start = zest_Microsecs();
+	frame_graph->timings.transient_placement = 0;
+	frame_graph->timings.recording = 0;
+	frame_graph->timings.execute = 0;
 
 	zest_device device = context->device;
 
@@ -16458,6 +19651,7 @@ zest_bool zest__execute_frame_graph(zest_context context, zest_frame_graph frame
 	//Place the transients for this execution now that the providers have fixed this frame's
 	//sizes: pack them into the context's arenas and materialise buffers and images.
 	ZEST_CPU_PROFILE_BEGIN(context, "Place Transients");
+	zest_microsecs lap_start = zest_Microsecs();
 	if (!zest__place_transient_resources(context, frame_graph, allocator)) {
 		frame_graph->error_status |= zest_fgs_transient_resource_failure;
 		//Placement may have checked out arenas and bound some images before failing; return the
@@ -16470,6 +19664,7 @@ zest_bool zest__execute_frame_graph(zest_context context, zest_frame_graph frame
 		ZEST_CPU_PROFILE_END(context);
 		return ZEST_FALSE;
 	}
+	frame_graph->timings.transient_placement = zest__lap_microsecs(&lap_start);
 	ZEST_CPU_PROFILE_END(context);
 
 	zest_bool using_legacy_render_pass = zest__using_legacy_render_pass(device);
@@ -16492,180 +19687,71 @@ zest_bool zest__execute_frame_graph(zest_context context, zest_frame_graph frame
 
             zest_pipeline_stage_flags timeline_wait_stage;
 
-            // 1. acquire an appropriate command buffer
             switch (batch->queue_type) {
 				case zest_queue_graphics:
-					ZEST_CLEANUP_ON_FALSE(device->platform->set_next_command_buffer(&frame_graph->command_list, batch->queue));
 					timeline_wait_stage = zest_pipeline_stage_vertex_input_bit | zest_pipeline_stage_transfer_bit;
 					break;
 				case zest_queue_compute:
-					ZEST_CLEANUP_ON_FALSE(device->platform->set_next_command_buffer(&frame_graph->command_list, batch->queue));
 					timeline_wait_stage = zest_pipeline_stage_compute_shader_bit;
 					break;
 				case zest_queue_transfer:
-					ZEST_CLEANUP_ON_FALSE(device->platform->set_next_command_buffer(&frame_graph->command_list, batch->queue));
 					timeline_wait_stage = zest_pipeline_stage_transfer_bit;
 					break;
 				default:
 					ZEST_ASSERT(0); //Unknown queue type for batch. Corrupt memory perhaps?!
             }
 
-            ZEST_CLEANUP_ON_FALSE(device->platform->begin_command_buffer(&frame_graph->command_list));
-			command_buffer_open = ZEST_TRUE;
-
-			// Bind the global bindless descriptor set for graphics and compute queues
-			if (batch->queue_type != zest_queue_transfer && frame_graph->descriptor_sets) {
-				if (batch->queue_type == zest_queue_graphics && !using_legacy_render_pass) {
-					// Graphics queue can do both graphics and compute
-					// If it's a legacy render pass on vulkan then we bind inside the render pass below
-					zest_cmd_BindDescriptorSets(&frame_graph->command_list, zest_bind_point_graphics, frame_graph->pipeline_layout, frame_graph->descriptor_sets, zest_vec_size(frame_graph->descriptor_sets), 0);
-					zest_cmd_BindDescriptorSets(&frame_graph->command_list, zest_bind_point_compute, frame_graph->pipeline_layout, frame_graph->descriptor_sets, zest_vec_size(frame_graph->descriptor_sets), 0);
-				} else {
-					// Compute queue is compute-only
-					zest_cmd_BindDescriptorSets(&frame_graph->command_list, zest_bind_point_compute, frame_graph->pipeline_layout, frame_graph->descriptor_sets, zest_vec_size(frame_graph->descriptor_sets), 0);
-				}
-			}
-
-			// Set up GPU profiler pointer on the command list
-			frame_graph->command_list.gpu_profiler = ZEST__FLAGGED(context->flags, zest_context_flag_gpu_profiling_enabled) ? &context->gpu_profiler : 0;
+			frame_graph->command_list.submission_index = submission_index;
+			frame_graph->command_list.timeline_wait_stage = timeline_wait_stage;
+			frame_graph->command_list.queue_index = queue_index;
+			frame_graph->batch_command_lists = 0;
 
-            zest_vec_foreach(i, batch->pass_indices) {
-				ZEST_CPU_PROFILE_BEGIN(context, "Pass %i", i);
-                zest_uint pass_index = batch->pass_indices[i];
-                zest_pass_group_t *grouped_pass = &frame_graph->final_passes.data[pass_index];
-                zest_execution_details_t *exe_details = &grouped_pass->execution_details;
-
-                frame_graph->command_list.submission_index = submission_index;
-                frame_graph->command_list.timeline_wait_stage = timeline_wait_stage;
-                frame_graph->command_list.queue_index = queue_index;
-
-				if (grouped_pass->flags & zest_pass_flag_sync_only) {
+			//A sync only pass group ends the recording for the batch
+			zest_uint group_count = 0;
+			zest_vec_foreach(i, batch->pass_indices) {
+				if (frame_graph->final_passes.data[batch->pass_indices[i]].flags & zest_pass_flag_sync_only) {
 					break;
 				}
+				group_count++;
+			}
 
-                //Transient resources were placed and materialised before recording started (see
-                //zest__place_transient_resources), so there is nothing to create per pass here.
-
-                //Batch execute acquire barriers for images and buffers
-				device->platform->acquire_barrier(&frame_graph->command_list, exe_details);
-
-				// GPU profiling: write begin timestamp for this grouped pass
-				// Reserve the query pair immediately so user sub-region calls don't collide
-				zest_gpu_profiler_t *gpu_profiler = frame_graph->command_list.gpu_profiler;
-				zest_uint gpu_profile_query_index = 0;
-				zest_bool gpu_profile_active = ZEST_FALSE;
-				if (gpu_profiler && gpu_profiler->enabled) {
-					zest_uint fif = context->current_fif;
-					gpu_profile_query_index = gpu_profiler->query_count[fif];
-					if (gpu_profile_query_index + 2 <= gpu_profiler->max_queries) {
-						device->platform->write_timestamp(&frame_graph->command_list, gpu_profiler, fif, gpu_profile_query_index, ZEST_FALSE);
-						zest_uint pair_index = gpu_profile_query_index / 2;
-						const char *pass_name = zest_vec_size(grouped_pass->passes) > 0 ? grouped_pass->passes[0]->name : "unknown";
-						snprintf(gpu_profiler->query_map[fif][pair_index].name, ZEST_GPU_PROFILE_NAME_LENGTH, "%s", pass_name);
-						gpu_profiler->query_map[fif][pair_index].queue_type = batch->queue_type;
-						gpu_profiler->query_map[fif][pair_index].depth = 0;
-						gpu_profiler->query_count[fif] += 2;
-						gpu_profile_active = ZEST_TRUE;
-					}
-				}
-
-                zest_bool has_render_pass = exe_details->requires_render_pass;
-
-                //Begin the render pass if the pass has one
-                if (has_render_pass) {
-                    device->platform->begin_render_pass(&frame_graph->command_list, exe_details);
-
-					// Bind the global bindless descriptor set for graphics and compute queues
-					if (frame_graph->descriptor_sets && using_legacy_render_pass) {
-						// Have to bind the descriptors here otherwise it can throw a validation error
-						// with legacy render passes
-						// Graphics queue can do both graphics and compute
-						zest_cmd_BindDescriptorSets(&frame_graph->command_list, zest_bind_point_graphics, frame_graph->pipeline_layout, frame_graph->descriptor_sets, zest_vec_size(frame_graph->descriptor_sets), 0);
-						zest_cmd_BindDescriptorSets(&frame_graph->command_list, zest_bind_point_compute, frame_graph->pipeline_layout, frame_graph->descriptor_sets, zest_vec_size(frame_graph->descriptor_sets), 0);
-					}
-
-					frame_graph->command_list.rendering_info = exe_details->rendering_info;
-					frame_graph->command_list.began_rendering = ZEST_TRUE;
-                }
-
-                // CPU profiling: begin timing for this grouped pass
-                zest_bool cpu_profile_active = ZEST_FALSE;
-                if (ZEST__FLAGGED(context->flags, zest_context_flag_cpu_profiling_enabled) && context->cpu_profiler.enabled) {
-                    const char *cpu_pass_name = zest_vec_size(grouped_pass->passes) > 0 ? grouped_pass->passes[0]->name : "unknown";
-                    ZEST_CPU_PROFILE_BEGIN(context, "%s", cpu_pass_name);
-                    cpu_profile_active = ZEST_TRUE;
-                }
-
-                //Execute the callbacks in the pass
-                zest_vec_foreach(pass_callback_index, grouped_pass->passes) {
-                    zest_pass_node pass = grouped_pass->passes[pass_callback_index];
-
-                    if (pass->type == zest_pass_type_graphics && !frame_graph->command_list.began_rendering) {
-                        ZEST_REPORT(device, zest_report_render_pass_skipped, "Pass execution was skipped for pass [%s] becuase rendering did not start. Check for validation errors.", pass->name);
-                        continue;
-                    }
-                    frame_graph->command_list.pass_node = pass;
-                    frame_graph->command_list.frame_graph = frame_graph;
-					frame_graph->command_list.rendering_info.render_pass_key = exe_details->render_pass_key;
-                    pass->execution_callback.callback(&frame_graph->command_list, pass->execution_callback.user_data);
-                }
-
-                // CPU profiling: end timing for this grouped pass
-                if (cpu_profile_active) {
-                    ZEST_CPU_PROFILE_END(context);
-                }
-
-				// GPU profiling: draw built-in overlay if both profiling and debug overlay are enabled
-				if (gpu_profile_active && ZEST__FLAGGED(context->flags, zest_context_flag_debug_overlay_enabled) && ZEST__FLAGGED(grouped_pass->flags, zest_pass_flag_outputs_to_swapchain)) {
-					zest__draw_gpu_profile_overlay(context);
-				}
-
-				// CPU profiling: draw built-in overlay
-				if (ZEST__FLAGGED(context->flags, zest_context_flag_cpu_profiling_enabled) && ZEST__FLAGGED(context->flags, zest_context_flag_debug_overlay_enabled) && ZEST__FLAGGED(grouped_pass->flags, zest_pass_flag_outputs_to_swapchain)) {
-					zest__draw_cpu_profile_overlay(context);
-				}
+			zest_uint parallel_task_count = 0;
+			zest_uint *task_of_group = 0;
+			if (ZEST__FLAGGED(context->flags, zest_context_flag_parallel_recording) && !using_legacy_render_pass && group_count > 1 && zest__get_job_system(device)) {
+				parallel_task_count = zest__partition_batch_pass_groups(frame_graph, batch, group_count, allocator, &task_of_group);
+			}
 
-				if (ZEST__FLAGGED(context->flags, zest_context_flag_debug_overlay_enabled) && context->db_overlay.vertex_count > 0 && ZEST__FLAGGED(grouped_pass->flags, zest_pass_flag_outputs_to_swapchain)) {
-					zest__draw_debug_overlay(&frame_graph->command_list);
+			if (parallel_task_count > 1) {
+				ZEST_CPU_PROFILE_BEGIN(context, "Parallel Record (%u tasks)", parallel_task_count);
+				zest_bool recorded = zest__record_batch_in_parallel(context, frame_graph, batch, group_count, parallel_task_count, task_of_group);
+				ZEST_CPU_PROFILE_END(context);
+				if (!recorded) {
+					ZEST_REPORT(device, zest_report_submission_failure, "Failed to record the pass groups in parallel for frame graph [%s]. Aborting execution.", frame_graph->name);
+					ZEST_CPU_PROFILE_END(context); //Batch queue profile
+					goto cleanup;
 				}
-
-				// GPU profiling: write end timestamp for this grouped pass
-				if (gpu_profile_active) {
-					device->platform->write_timestamp(&frame_graph->command_list, gpu_profiler, context->current_fif, gpu_profile_query_index + 1, ZEST_TRUE);
+			} else {
+				// 1. acquire an appropriate command buffer
+				ZEST_CLEANUP_ON_FALSE(device->platform->set_next_command_buffer(&frame_graph->command_list, batch->queue));
+				ZEST_CLEANUP_ON_FALSE(device->platform->begin_command_buffer(&frame_graph->command_list));
+				command_buffer_open = ZEST_TRUE;
+
+				zest__bind_frame_graph_descriptor_sets(frame_graph, &frame_graph->command_list, batch, using_legacy_render_pass);
+
+				// Set up GPU profiler pointer on the command list
+				frame_graph->command_list.gpu_profiler = ZEST__FLAGGED(context->flags, zest_context_flag_gpu_profiling_enabled) ? &context->gpu_profiler : 0;
+
+				for (zest_uint i = 0; i != group_count; ++i) {
+					ZEST_CPU_PROFILE_BEGIN(context, "Pass %i", i);
+					zest_pass_group_t *grouped_pass = &frame_graph->final_passes.data[batch->pass_indices[i]];
+					zest_uint gpu_profile_query_index = 0;
+					zest_bool gpu_profile_active = zest__reserve_pass_group_gpu_profile(context, batch, grouped_pass, &gpu_profile_query_index);
+					zest__record_pass_group(context, frame_graph, &frame_graph->command_list, grouped_pass, gpu_profile_active, gpu_profile_query_index, using_legacy_render_pass);
+					ZEST_CPU_PROFILE_END(context); //Pass profile
 				}
-
-                zest_map_foreach(pass_input_index, grouped_pass->inputs) {
-                    zest_resource_node resource = grouped_pass->inputs.data[pass_input_index].resource_node;
-                    if (resource->aliased_resource) {
-                        resource->aliased_resource->current_state_index++;
-                    } else {
-                        resource->current_state_index++;
-                    }
-                }
-
-                zest_map_foreach(pass_output_index, grouped_pass->outputs) {
-                    zest_resource_node resource = grouped_pass->outputs.data[pass_output_index].resource_node;
-                    if (resource->aliased_resource) {
-                        resource->aliased_resource->current_state_index++;
-                    } else {
-                        resource->current_state_index++;
-                    }
-                }
-
-                if (has_render_pass) {
-                    device->platform->end_render_pass(&frame_graph->command_list);
-					frame_graph->command_list.began_rendering = ZEST_FALSE;
-                }
-
-                //Batch execute release barriers for images and buffers
-
-				device->platform->release_barrier(&frame_graph->command_list, exe_details);
-
-                //End pass
-				ZEST_CPU_PROFILE_END(context); //Pass profile
-            }
-			device->platform->end_command_buffer(&frame_graph->command_list);
-			command_buffer_open = ZEST_FALSE;
+				device->platform->end_command_buffer(&frame_graph->command_list);
+				command_buffer_open = ZEST_FALSE;
+			}
 			ZEST_CPU_PROFILE_BEGIN(context, "Submit Batch");
             if (!device->platform->submit_frame_graph_batch(frame_graph, backend, batch, &queues)) {
                 //Submission failed (e.g. device lost). Flag it and bail to the rescue path so any
@@ -16692,6 +19778,7 @@ zest_bool zest__execute_frame_graph(zest_context context, zest_frame_graph frame
         zest_context_queue queue = queues.data[i];
         queue->fif = (queue->fif + 1) % ZEST_MAX_FIF;
     }
+	frame_graph->timings.recording = zest__lap_microsecs(&lap_start);
 
 	ZEST_CPU_PROFILE_BEGIN(context, "Reset Resources");
 	zest_bucket_array_foreach(index, frame_graph->resources) {
@@ -16732,7 +19819,13 @@ zest_bool zest__execute_frame_graph(zest_context context, zest_frame_graph frame
 	//backing before they next execute, the backing id changes and the images recreate lazily.
 	zest__return_frame_graph_arenas(context, frame_graph);
 
+	if (ZEST__FLAGGED(frame_graph->flags, zest_frame_graph_has_readbacks)) {
+		zest__stamp_submitted_readbacks(context, frame_graph->signal_timeline);
+	}
+
     ZEST__FLAG(frame_graph->flags, zest_frame_graph_is_executed);
+	frame_graph->timings.execute = zest_Microsecs() - execute_start;
+	context->last_frame_graph_timings = frame_graph->timings;
 
 	ZEST_CPU_PROFILE_END(context);
     return ZEST_TRUE;
@@ -16759,6 +19852,8 @@ zest_bool zest__execute_frame_graph(zest_context context, zest_frame_graph frame
 			zest__retire_frame_graph_images(context, frame_graph);
 		}
 		zest__return_frame_graph_arenas(context, frame_graph);
+		//Readback copies recorded by this graph will never run
+		zest__discard_unsubmitted_readbacks(context);
 		//Mark the context so the application can detect that this frame's work did not complete
 		//normally and take recovery action (e.g. skip presenting, or reset the device).
 		ZEST__FLAG(context->flags, zest_context_flag_critical_error);
@@ -16830,6 +19925,16 @@ zest_uint zest_GetFrameGraphCulledPassesCount(zest_frame_graph frame_graph) {
     return frame_graph->culled_passes_count;
 }
 
+zest_frame_graph_timings_t zest_GetFrameGraphTimings(zest_frame_graph frame_graph) {
+    ZEST_ASSERT_HANDLE(frame_graph);        //Not a valid frame graph! Make sure you called BeginRenderGraph or BeginRenderToScreen
+    return frame_graph->timings;
+}
+
+zest_frame_graph_timings_t zest_GetLastFrameGraphTimings(zest_context context) {
+	ZEST_ASSERT_HANDLE(context);	//Not a valid context handle
+	return context->last_frame_graph_timings;
+}
+
 zest_uint zest_GetFrameGraphSubmissionCount(zest_frame_graph frame_graph) {
     ZEST_ASSERT_HANDLE(frame_graph);        //Not a valid frame graph! Make sure you called BeginRenderGraph or BeginRenderToScreen
     return zest_vec_size(frame_graph->submissions);
@@ -17828,12 +20933,12 @@ zest_resource_node zest__add_frame_graph_resource(zest_resource_node resource) {
     *node = *resource;
 	//Check for duplicate names, all resources in the framegraph must be unique otherwise the frame
 	//graph is invalid
-	if (zest_map_valid_name(frame_graph->resource_names, node->name)) {
+	if (zest__at(&frame_graph->resource_names, node->name)) {
 		zest__log_validation_error(context->device, zest_message_duplicate_resource_name);
 		ZEST_REPORT(context->device, zest_report_invalid_resource, zest_message_duplicate_resource_name_report, frame_graph->name, node->name);
 		frame_graph->error_status |= zest_fgs_critical_error;
 	} else {
-		zest_map_linear_insert(allocator, frame_graph->resource_names, node->name, node);
+		zest__insert(&frame_graph->resource_names, node->name, &node);
 	}
     for (int i = 0; i != zest_max_global_binding_number; ++i) {
         node->bindless_index[i] = ZEST_INVALID;
@@ -17963,7 +21068,7 @@ zest_uint zest_GetTransientSampledImageBindlessIndex(const zest_command_list com
     ZEST_ASSERT_HANDLE(resource);            // Not a valid resource handle
     ZEST_ASSERT(resource->type & zest_resource_type_is_image);  //Must be an image resource type
     if (resource->bindless_index[binding_number] != ZEST_INVALID) return resource->bindless_index[binding_number];
-	zest_context context = zest__frame_graph_builder->context;
+	zest_context context = command_list->context;
 	zest_device device = context->device;
     zest_frame_graph frame_graph = command_list->frame_graph;
     zest_set_layout bindless_layout = frame_graph->bindless_layout;
@@ -17975,10 +21080,12 @@ zest_uint zest_GetTransientSampledImageBindlessIndex(const zest_command_list com
     }
 
 	zest_descriptor_type descriptor_type = binding_number == zest_storage_image_binding ? zest_descriptor_type_storage_image : zest_descriptor_type_sampled_image;
+	zest_bool locked = zest__lock_recording(context);
     device->platform->update_bindless_image_descriptor(device, binding_number, bindless_index, descriptor_type, &resource->image, resource->view, 0, frame_graph->bindless_set);
 
     zest_binding_index_for_release_t binding_index = { frame_graph->bindless_layout, bindless_index, (zest_uint)binding_number };
 	zest_vec_push(context->allocator, frame_graph->deferred_resource_freeing_list->transient_binding_indexes[context->current_fif], binding_index);
+	zest__unlock_recording(context, locked);
 
     return bindless_index;
 }
@@ -17992,7 +21099,7 @@ zest_uint *zest_GetTransientSampledMipBindlessIndexes(const zest_command_list co
 		return resource->mip_level_bindless_indexes[binding_number];
 	}
     zest_frame_graph frame_graph = command_list->frame_graph;
-	zest_context context = zest__frame_graph_builder->context;
+	zest_context context = command_list->context;
 	zest_device device = context->device;
 
     zloc_linear_allocator_t *allocator = zest__frame_graph_builder->allocator;
@@ -18010,10 +21117,12 @@ zest_uint *zest_GetTransientSampledMipBindlessIndexes(const zest_command_list co
 		}
 		zest_vec_linear_push(allocator, resource->mip_level_bindless_indexes[binding_number], bindless_index);
 
+		zest_bool locked = zest__lock_recording(context);
         device->platform->update_bindless_image_descriptor(device, binding_number, bindless_index, descriptor_type, &resource->image, &resource->view_array->views[mip_index], 0, frame_graph->bindless_set);
 
 		zest_binding_index_for_release_t mip_binding_index = { frame_graph->bindless_layout, bindless_index, (zest_uint)binding_number };
 		zest_vec_push(context->allocator, frame_graph->deferred_resource_freeing_list->transient_binding_indexes[context->current_fif], mip_binding_index);
+		zest__unlock_recording(context, locked);
 	}
 	return resource->mip_level_bindless_indexes[binding_number];
 }
@@ -18027,7 +21136,7 @@ zest_uint zest_GetTransientBufferBindlessIndex(const zest_command_list command_l
 	//	zest_GetPassOutputResource if it was used as output
 									
     ZEST_ASSERT(resource->type & zest_resource_type_buffer);   //Must be a buffer resource type for this bindlesss index acquisition
-	zest_context context = zest__frame_graph_builder->context;
+	zest_context context = command_list->context;
 	zest_device device = context->device;
 	//A transient buffer can resolve to zero size for this execution (e.g. an instance/dynamic layer
 	//with nothing to draw) and so have no backing buffer. Guard the descriptor update against that:
@@ -18044,10 +21153,12 @@ zest_uint zest_GetTransientBufferBindlessIndex(const zest_command_list command_l
 	zest_uint bindless_index = zest__acquire_bindless_index(bindless_layout, zest_storage_buffer_binding);
 	if (bindless_index == ZEST_INVALID) return bindless_index;
 
+	zest_bool locked = zest__lock_recording(context);
     device->platform->update_bindless_storage_buffer_descriptor(device, zest_storage_buffer_binding, bindless_index, resource->storage_buffer, frame_graph->bindless_set);
 
 	zest_binding_index_for_release_t binding_index = { frame_graph->bindless_layout, bindless_index, zest_storage_buffer_binding };
 	zest_vec_push(context->allocator, frame_graph->deferred_resource_freeing_list->transient_binding_indexes[context->current_fif], binding_index);
+	zest__unlock_recording(context, locked);
     resource->bindless_index[0] = bindless_index;
     return bindless_index;
 }
@@ -18353,6 +21464,14 @@ zest_resource_usage_t zest__configure_image_usage(zest_resource_node resource, z
 			usage.is_output = ZEST_FALSE;
 			break;
 
+		case zest_purpose_transfer_image_write:
+			usage.image_layout = zest_image_layout_transfer_dst_optimal;
+			usage.access_mask = zest_access_transfer_write_bit;
+			usage.stage_mask = zest_pipeline_stage_transfer_bit;
+			resource->image.info.flags |= zest_image_flag_transfer_dst;
+			usage.is_output = ZEST_TRUE;
+			break;
+
 		case zest_purpose_present_src:
 			usage.image_layout = zest_image_layout_present;
 			usage.access_mask = 0; // No specific GPU access by the pass itself for this state.
@@ -18530,7 +21649,7 @@ void zest_ConnectOutput(zest_resource_node resource) {
 				break;
 			}
 			case zest_pass_type_transfer: {
-				zest__add_pass_image_usage(pass, resource, zest_purpose_transfer_image, zest_pipeline_stage_compute_shader_bit,
+				zest__add_pass_image_usage(pass, resource, zest_purpose_transfer_image_write, zest_pipeline_stage_transfer_bit,
 										   ZEST_FALSE, zest_load_op_dont_care, zest_store_op_dont_care,
 										   zest_load_op_dont_care, zest_store_op_dont_care, ZEST__ZERO_INIT(zest_clear_value_t));
 				break;
@@ -18699,129 +21818,608 @@ void zest__draw_instance_mesh_layer(zest_command_list command_list, zest_layer l
 	ZEST_ASSERT(device_buffer, "Transient buffer not found in the layer. Make sure you're passing in the correct layer in the user data and you connected the layer resource as input.");
 	zest_cmd_BindVertexBuffer(command_list, 1, 1, device_buffer);
 
-	zest_device device = command_list->context->device;
+	zest_layer_draw_state_t state;
+	zest__begin_layer_draw_state(layer, &state);
 
-	zest_pipeline current_pipeline = 0;
-	zest_pipeline pipeline = 0;
-	if (ZEST_VALID_HANDLE(pipeline_template, zest_struct_type_pipeline_template)) {
-		pipeline = zest_GetPipeline(pipeline_template, command_list);
-		if (pipeline) {
-			zest_cmd_BindPipeline(command_list, pipeline);
-			current_pipeline = pipeline;
+	if (ZEST__FLAGGED(layer->flags, zest_layer_flag_multi_draw_indirect) && layer->memory_refs[layer->fif].indirect_commands) {
+		if (zest__layer_cull_is_active(layer, command_list->frame_graph)) {
+			//Only the instances that survived the cull pass are drawn, it counted them in to the indirect commands
+			zest_cmd_BindVertexBuffer(command_list, 1, 1, layer->culled_instances_node->storage_buffer);
 		}
+		zest__draw_instance_mesh_layer_indirect(command_list, layer, &state, pipeline_template);
+		return;
 	}
 
+	//A pipeline passed in overrides the pipelines in the instructions
+	zest_bool override_pipeline = ZEST_VALID_HANDLE(pipeline_template, zest_struct_type_pipeline_template);
+
     zest_bool has_instruction_view_port = ZEST_FALSE;
     zest_vec_foreach(i, layer->draw_instructions[layer->fif]) {
         zest_layer_instruction_t *current = &layer->draw_instructions[layer->fif][i];
+		if (current->lod_level && current->lod_radius > 0.f) {
+			//Only drawn from the cull pass, the first level draws everything without it
+			continue;
+		}
 
 		zest_mesh_offset_data_t *mesh_offsets = &layer->mesh_offsets[current->mesh_index];
 
         if (current->draw_mode == zest_draw_mode_viewport) {
-			zest_cmd_Scissor(command_list, &current->scissor);
-            zest_cmd_ViewPort(command_list, &current->viewport);
+			zest__set_layer_draw_viewport(command_list, layer, &state, &current->viewport, &current->scissor);
             has_instruction_view_port = ZEST_TRUE;
             continue;
         } else if(!has_instruction_view_port) {
-			zest_cmd_Scissor(command_list, &layer->scissor);
-            zest_cmd_ViewPort(command_list, &layer->viewport);
+			zest__set_layer_draw_viewport(command_list, layer, &state, &layer->viewport, &layer->scissor);
         }
 
-        pipeline = !pipeline ? zest_GetPipeline(current->pipeline_template, command_list) : pipeline;
-        if (pipeline && pipeline != current_pipeline) {
-			zest_cmd_BindPipeline(command_list, pipeline);
-			current_pipeline = pipeline;
-        } else if(!pipeline) {
+		if (!zest__bind_layer_draw_pipeline(command_list, layer, &state, override_pipeline ? pipeline_template : current->pipeline_template)) {
             continue;
         }
 
-		zest_cmd_SendPushConstants(command_list, (void*)current->push_constant, ZEST_MAX_PUSH_SIZE);
+		zest__send_layer_draw_push_constants(command_list, layer, &state, current->push_constant);
 
 		zest_cmd_DrawIndexed(command_list, mesh_offsets->index_count, current->total_instances, mesh_offsets->index_offset, mesh_offsets->vertex_offset, current->start_index);
+		layer->draw_stats.draws++;
     }
 }
 
-zest_layer_handle zest_CreateMeshLayer(zest_context context, const char* name, zest_size vertex_struct_size, zest_size vertex_capacity, zest_size index_capacity) {
-    zest_layer layer;
-    zest_layer_handle handle = zest__new_layer(context, &layer);
-    layer->name = name;
-    zest__initialise_mesh_layer(context, layer, vertex_struct_size, 1000);
-	zest__activate_resource(handle.store, handle.value);
-    return handle;
-}
+void zest__draw_instance_mesh_layer_indirect(zest_command_list command_list, zest_layer layer, zest_layer_draw_state_t *state, zest_pipeline_template pipeline_template) {
+	zest_device device = command_list->context->device;
+	zest_layer_buffers_t *buffers = &layer->memory_refs[layer->fif];
+	zest_layer_instruction_t *instructions = layer->draw_instructions[layer->fif];
+	zest_uint instruction_count = zest_vec_size(instructions);
+	zest_uint stride = sizeof(zest_draw_indexed_indirect_command_t);
+	//The draw counts live after the commands
+	zest_uint *draw_counts = (zest_uint *)((zest_byte *)zest_BufferData(buffers->indirect_commands) + buffers->indirect_capacity * stride);
+	zest_size count_offset = (zest_size)buffers->indirect_capacity * stride;
+	zest_bool multi_draw = zest_DeviceFeatureEnabled(device, zest_capability_multi_draw_indirect);
+	zest_bool count_from_buffer = multi_draw && zest_DeviceFeatureEnabled(device, zest_capability_draw_indirect_count);
+	zest_bool override_pipeline = ZEST_VALID_HANDLE(pipeline_template, zest_struct_type_pipeline_template);
 
-zest_layer_handle zest_CreateInstanceMeshLayer(zest_context context, const char *name, zest_size instance_struct_size, zest_size vertex_capacity, zest_size index_capacity) {
-    zest_layer layer;
-    zest_layer_handle handle = zest__new_layer(context, &layer);
-    layer->name = name;
-    zest__initialise_instance_layer(context, layer, instance_struct_size, 1000);
-	zest_buffer_info_t vertex_info = zest_CreateBufferInfo(zest_buffer_type_vertex, zest_memory_usage_gpu_only);
-	zest_buffer_info_t index_info = zest_CreateBufferInfo(zest_buffer_type_index, zest_memory_usage_gpu_only);
-	layer->vertex_data = zest_CreateBuffer(context->device, vertex_capacity, &vertex_info);
-	layer->index_data = zest_CreateBuffer(context->device, index_capacity, &index_info);
-	zest__activate_resource(handle.store, handle.value);
-    return handle;
-}
+    zest_bool has_instruction_view_port = ZEST_FALSE;
+	zest_uint run_count = 0;
+	zest_uint i = 0;
+	while (i < instruction_count) {
+        zest_layer_instruction_t *current = &instructions[i];
+        if (current->draw_mode == zest_draw_mode_viewport) {
+			zest__set_layer_draw_viewport(command_list, layer, state, &current->viewport, &current->scissor);
+            has_instruction_view_port = ZEST_TRUE;
+			i++;
+            continue;
+        } else if(!has_instruction_view_port) {
+			zest__set_layer_draw_viewport(command_list, layer, state, &layer->viewport, &layer->scissor);
+        }
 
-// --Texture and Image functions
-zest_image_handle zest__new_image(zest_device device) {
-	zest_resource_store_t *store = &device->resource_stores[zest_handle_type_images];
-    zest_image_handle handle = ZEST_STRUCT_LITERAL(zest_image_handle, zest__add_store_resource(store), store );
-	handle.store = store;
-    zest_image image = (zest_image)zest__get_store_resource_unsafe(store, handle.value);
-    *image = ZEST__ZERO_INIT(zest_image_t);
-    image->magic = zest_INIT_MAGIC(zest_struct_type_image);
-    image->backend = (zest_image_backend)device->platform->new_image_backend(device);
-    for (int i = 0; i != zest_max_global_binding_number; ++i) {
-        image->bindless_index[i] = ZEST_INVALID;
-    }
-	image->handle = handle;
-    return handle;
+		//Take in every following instruction that can be drawn without binding anything new
+		zest_uint run_end = i + 1;
+		while (run_end < instruction_count) {
+			zest_layer_instruction_t *next = &instructions[run_end];
+			if (next->draw_mode == zest_draw_mode_viewport) break;
+			if (!override_pipeline && next->pipeline_template != current->pipeline_template) break;
+			if (memcmp(next->push_constant, current->push_constant, state->push_constant_size)) break;
+			run_end++;
+		}
+
+		if (!zest__bind_layer_draw_pipeline(command_list, layer, state, override_pipeline ? pipeline_template : current->pipeline_template)) {
+			i = run_end;
+            continue;
+        }
+		zest__send_layer_draw_push_constants(command_list, layer, state, current->push_constant);
+
+		zest_uint draw_count = run_end - i;
+		if (count_from_buffer) {
+			draw_counts[run_count] = draw_count;
+			zest_cmd_DrawIndexedIndirectCount(command_list, buffers->indirect_commands, i, buffers->indirect_commands, count_offset + run_count * sizeof(zest_uint), draw_count, stride);
+			layer->draw_stats.draws++;
+		} else if (multi_draw) {
+			zest_cmd_DrawIndexedIndirect(command_list, buffers->indirect_commands, i, draw_count, stride);
+			layer->draw_stats.draws++;
+		} else {
+			for (zest_uint draw = i; draw != run_end; ++draw) {
+				zest_cmd_DrawIndexedIndirect(command_list, buffers->indirect_commands, draw, 1, stride);
+				layer->draw_stats.draws++;
+			}
+		}
+		run_count++;
+		i = run_end;
+	}
 }
 
-ZEST_PRIVATE zest_image_handle zest__create_image(zest_device device, zest_image_info_t *create_info) {
-	zest_image_handle null_handle = ZEST__ZERO_INIT(zest_image_handle);
-	ZEST_ASSERT_OR_VALIDATE(create_info->extent.width * create_info->extent.height * create_info->extent.depth > 0,
-		device, "Image has 0 dimensions", null_handle);
-	ZEST_ASSERT_OR_VALIDATE(create_info->flags,
-		device, "You must set flags in the image info to specify how the image will be used", null_handle);
-	ZEST_ASSERT_OR_VALIDATE(create_info->format > zest_format_undefined && create_info->format < zest_max_format,
-		device, "Invalid image format specified", null_handle);
-	//Validate format/usage compatibility
-	if (zest__is_depth_stencil_format(create_info->format)) {
-		ZEST_ASSERT_OR_VALIDATE(!ZEST__FLAGGED(create_info->flags, zest_image_flag_color_attachment),
-			device, "Depth/stencil format cannot be used as color attachment", null_handle);
-	} else {
-		ZEST_ASSERT_OR_VALIDATE(!ZEST__FLAGGED(create_info->flags, zest_image_flag_depth_stencil_attachment),
-			device, "Color format cannot be used as depth/stencil attachment", null_handle);
+zest_bool zest__reserve_layer_indirect_commands(zest_layer layer, zest_uint count) {
+	zest_layer_buffers_t *buffers = &layer->memory_refs[layer->fif];
+	if (buffers->indirect_commands && count <= buffers->indirect_capacity) {
+		return ZEST_TRUE;
 	}
-	if (zest__is_compressed_format(create_info->format)) {
-		ZEST_ASSERT_OR_VALIDATE(!ZEST__FLAGGED(create_info->flags, zest_image_flag_color_attachment) &&
-			!ZEST__FLAGGED(create_info->flags, zest_image_flag_depth_stencil_attachment),
-			device, "Compressed format cannot be used as render attachment", null_handle);
-		ZEST_ASSERT_OR_VALIDATE(!ZEST__FLAGGED(create_info->flags, zest_image_flag_generate_mipmaps),
-			device, "Cannot generate mipmaps for compressed formats. Use pre-compressed mipmaps in KTX files instead.", null_handle);
+	//Room for a command and a draw count per instruction
+	zest_uint capacity = ZEST__MAX(buffers->indirect_capacity + buffers->indirect_capacity / 2, 64u);
+	capacity = ZEST__MAX(capacity, count);
+	zest_size size = (zest_size)capacity * (sizeof(zest_draw_indexed_indirect_command_t) + sizeof(zest_uint));
+	if (ZEST__FLAGGED(layer->flags, zest_layer_flag_gpu_culling)) {
+		//The LOD view goes after the cull view
+		size += (zest_size)capacity * sizeof(zest_layer_cull_draw_t) + sizeof(zest_layer_cull_view_t) + sizeof(zest_vec4);
+	}
+	if (!buffers->indirect_commands) {
+		zest_buffer_info_t buffer_info = zest_CreateBufferInfo(zest_buffer_type_indirect, zest_memory_usage_cpu_to_gpu);
+		buffers->indirect_commands = zest_CreateBuffer(layer->context->device, size, &buffer_info);
+	} else if (buffers->indirect_commands->size < size && !zest_ResizeBuffer(&buffers->indirect_commands, size)) {
+		ZEST_REPORT(layer->context->device, zest_report_layers, "Unable to grow the indirect command buffer in layer [%s].", layer->name);
+		return ZEST_FALSE;
 	}
-	if (ZEST__FLAGGED(create_info->flags, zest_image_flag_cubemap)) {
-		ZEST_ASSERT_OR_VALIDATE(create_info->layer_count > 0 && create_info->layer_count % 6 == 0,
-			device, "Cubemap must have layers in multiples of 6", null_handle);
+	if (!buffers->indirect_commands) {
+		return ZEST_FALSE;
 	}
-	if (create_info->extent.depth > 1) {
-		ZEST_ASSERT_OR_VALIDATE(create_info->layer_count <= 1,
-			device, "3D images (extent.depth > 1) must have layer_count of 1. Vulkan does not support arrays of 3D images.", null_handle);
-		ZEST_ASSERT_OR_VALIDATE(!ZEST__FLAGGED(create_info->flags, zest_image_flag_cubemap),
-			device, "3D images cannot be cubemaps", null_handle);
-		ZEST_ASSERT_OR_VALIDATE(!ZEST__FLAGGED(create_info->flags, zest_image_flag_generate_mipmaps),
-			device, "Automatic mipmap generation is not supported for 3D images. Provide pre-generated mips or specify mip_levels = 1.", null_handle);
+	buffers->indirect_capacity = capacity;
+	return ZEST_TRUE;
+}
+
+void zest__write_layer_indirect_command(zest_layer layer, zest_uint index) {
+	if (!zest__reserve_layer_indirect_commands(layer, index + 1)) {
+		//Without room for the command the layer has to go back to drawing each instruction directly
+		ZEST__UNFLAG(layer->flags, zest_layer_flag_multi_draw_indirect);
+		return;
 	}
-	//Check if the format is supported with the requested flags
-	ZEST_ASSERT_OR_VALIDATE(device->platform->is_image_format_supported(device, create_info->format, create_info->flags),
-		device, "Image format is not supported with the requested usage flags", null_handle);
-	//For example you could use zest_image_preset_texture. Lookup the zest_image_flag_bits enum
-	//to see all the flags available.
-	zest_image_handle handle = zest__new_image(device);
-    zest_image image = (zest_image)zest__get_store_resource_unsafe(handle.store, handle.value);
-    image->info = *create_info;
+	zest_layer_instruction_t *instruction = &layer->draw_instructions[layer->fif][index];
+	zest_draw_indexed_indirect_command_t *command = (zest_draw_indexed_indirect_command_t *)zest_BufferData(layer->memory_refs[layer->fif].indirect_commands) + index;
+	*command = ZEST__ZERO_INIT(zest_draw_indexed_indirect_command_t);
+	if (instruction->draw_mode == zest_draw_mode_viewport) {
+		//Never drawn but the slot keeps commands lined up with the instructions
+		return;
+	}
+	ZEST_ASSERT(instruction->mesh_index < zest_vec_size(layer->mesh_offsets), "Mesh index is out of bounds in an indirect mesh layer instruction.");
+	zest_mesh_offset_data_t *mesh_offsets = &layer->mesh_offsets[instruction->mesh_index];
+	command->index_count = mesh_offsets->index_count;
+	//Levels after the first of a GPU picked LOD chain only get the instances that the cull pass gives them
+	command->instance_count = instruction->lod_level && instruction->lod_radius > 0.f ? 0 : instruction->total_instances;
+	command->first_index = mesh_offsets->index_offset;
+	command->vertex_offset = (int32_t)mesh_offsets->vertex_offset;
+	command->first_instance = instruction->start_index;
+}
+
+void zest_EnableLayerMultiDrawIndirect(zest_layer layer) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	ZEST_ASSERT(layer->vertex_data && layer->index_data, "Multi draw indirect is only for instance mesh layers, create the layer with zest_CreateInstanceMeshLayer.");
+	ZEST_ASSERT(zest_vec_size(layer->draw_instructions[layer->fif]) == 0, "Enable multi draw indirect before recording any instructions in to the layer.");
+	ZEST__FLAG(layer->flags, zest_layer_flag_multi_draw_indirect);
+}
+
+zest_buffer zest_GetLayerIndirectBuffer(zest_layer layer) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	if (ZEST__NOT_FLAGGED(layer->flags, zest_layer_flag_multi_draw_indirect)) {
+		return 0;
+	}
+	return layer->memory_refs[layer->fif].indirect_commands;
+}
+
+zest_bool zest_EnableLayerGPUCulling(zest_layer layer, zest_uint position_offset, zest_uint scale_offset) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	ZEST_ASSERT(layer->instance_struct_size % 4 == 0 && position_offset % 4 == 0 && (scale_offset == ZEST_INVALID || scale_offset % 4 == 0),
+				"The cull shader reads instances a word at a time so the instance struct size and the position and scale offsets must be multiples of 4.");
+	ZEST_ASSERT(position_offset + sizeof(zest_vec3) <= layer->instance_struct_size, "The position offset is outside of the instance struct.");
+	ZEST_ASSERT(scale_offset == ZEST_INVALID || scale_offset + sizeof(zest_vec3) <= layer->instance_struct_size, "The scale offset is outside of the instance struct.");
+	zest_device device = layer->context->device;
+	if (!zest_IsValidHandle(&device->layer_cull_compute)) {
+		zest_shader_handle shader = device->platform->get_layer_cull_shader(device);
+		if (zest_IsValidHandle(&shader)) {
+			device->layer_cull_compute = zest_CreateCompute(device, "Layer Cull", shader);
+		}
+		if (!zest_IsValidHandle(&device->layer_cull_compute)) {
+			ZEST_REPORT(device, zest_report_layers, "Unable to create the cull shader, GPU culling was not enabled for layer [%s].", layer->name);
+			return ZEST_FALSE;
+		}
+	}
+	ZEST_ASSERT(ZEST__NOT_FLAGGED(layer->flags, zest_layer_flag_mesh_lods) || (layer->cull_position_offset == position_offset && layer->cull_scale_offset == scale_offset),
+				"The layer's LODs use different position and scale offsets, culling and LODs must read the same ones.");
+	zest_EnableLayerMultiDrawIndirect(layer);
+	ZEST__FLAG(layer->flags, zest_layer_flag_gpu_culling);
+	layer->cull_position_offset = position_offset;
+	layer->cull_scale_offset = scale_offset;
+	//Planes that everything is in front of until the view is set
+	layer->cull_view = ZEST__ZERO_INIT(zest_layer_cull_view_t);
+	for (int i = 0; i != 6; ++i) {
+		layer->cull_view.planes[i].w = 1.f;
+	}
+	zest_ForEachFrameInFlight(fif) {
+		//Indirect buffers made before now have no room for the cull data so make them grow when they're next used
+		layer->memory_refs[fif].indirect_capacity = 0;
+	}
+	return ZEST_TRUE;
+}
+
+void zest_SetLayerMeshBounds(zest_layer layer, zest_uint mesh_index, zest_bounding_box_t bounds) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	ZEST_ASSERT(mesh_index < zest_vec_size(layer->mesh_offsets), "Mesh index is out of bounds. Make sure you add all your meshes to the layer with zest_AddMeshToLayer");
+	//A sphere around the instance origin that holds the box however the instance is rotated
+	zest_vec3 center = zest_ScaleVec3(zest_AddVec3(bounds.min_bounds, bounds.max_bounds), .5f);
+	zest_vec3 extent = zest_SubVec3(bounds.max_bounds, center);
+	layer->mesh_offsets[mesh_index].cull_radius = zest_LengthVec3(center) + zest_LengthVec3(extent);
+}
+
+void zest_SetLayerCullView(zest_layer layer, const zest_layer_cull_view_t *view) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	ZEST_ASSERT(view, "The cull view can't be null.");
+	layer->cull_view = *view;
+}
+
+zest_resource_node zest_AddLayerCullPass(zest_layer layer, zest_resource_node layer_resource, zest_resource_node hiz_pyramid) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	ZEST_ASSERT_HANDLE(layer_resource);	//Not a valid resource handle, use the resource from zest_AddTransientLayerResource
+	ZEST_ASSERT(ZEST__FLAGGED(layer->flags, zest_layer_flag_gpu_culling), "Call zest_EnableLayerGPUCulling before adding a cull pass for the layer.");
+	//The indirect buffer is imported so it has to exist now, the provider picks the right one when the graph executes
+	if (!zest__reserve_layer_indirect_commands(layer, 1)) {
+		return NULL;
+	}
+	zest_buffer_resource_info_t culled_info = ZEST__ZERO_INIT(zest_buffer_resource_info_t);
+	culled_info.size = layer_resource->buffer_desc.size;
+	culled_info.usage_hints = zest_resource_usage_hint_vertex_buffer;
+	zest_resource_node culled = zest_AddTransientBufferResource("Layer Culled Instances", &culled_info);
+	culled->buffer_provider = zest__layer_culled_instances_provider;
+	culled->user_data = layer;
+	zest_resource_node commands = zest_ImportBufferResource("Layer Cull Commands", layer->memory_refs[layer->fif].indirect_commands, zest__layer_cull_commands_provider);
+	commands->user_data = layer;
+	layer->culled_instances_node = culled;
+	layer->cull_commands_node = commands;
+	layer->cull_hiz_name = hiz_pyramid ? hiz_pyramid->name : 0;
+
+	zest_BeginComputePass("Layer Cull");
+	zest_ConnectInput(layer_resource);
+	if (hiz_pyramid) {
+		zest_ConnectInput(hiz_pyramid);
+	}
+	zest_ConnectOutput(culled);
+	zest_ConnectOutput(commands);
+	zest_SetPassTask(zest__layer_cull_task, layer);
+	zest_EndPass();
+	return culled;
+}
+
+void zest_ConnectLayerCullInputs(zest_layer layer) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	ZEST_ASSERT(layer->culled_instances_node && layer->cull_commands_node, "Add the layer's cull pass with zest_AddLayerCullPass before connecting its outputs.");
+	zest_ConnectInput(layer->culled_instances_node);
+	zest_ConnectInput(layer->cull_commands_node);
+}
+
+void zest_EnableLayerMeshLODs(zest_layer layer, zest_uint position_offset, zest_uint scale_offset) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	ZEST_ASSERT(layer->vertex_data && layer->index_data, "LODs are only for instance mesh layers, create the layer with zest_CreateInstanceMeshLayer.");
+	ZEST_ASSERT(ZEST__NOT_FLAGGED(layer->flags, zest_layer_flag_instance_store), "Instances are sorted in to levels so LODs can't be used with an instance store.");
+	ZEST_ASSERT(position_offset % 4 == 0 && (scale_offset == ZEST_INVALID || scale_offset % 4 == 0), "The cull shader reads instances a word at a time so the position and scale offsets must be multiples of 4.");
+	ZEST_ASSERT(position_offset + sizeof(zest_vec3) <= layer->instance_struct_size, "The position offset is outside of the instance struct.");
+	ZEST_ASSERT(scale_offset == ZEST_INVALID || scale_offset + sizeof(zest_vec3) <= layer->instance_struct_size, "The scale offset is outside of the instance struct.");
+	ZEST_ASSERT(ZEST__NOT_FLAGGED(layer->flags, zest_layer_flag_gpu_culling) || (layer->cull_position_offset == position_offset && layer->cull_scale_offset == scale_offset),
+				"The layer's GPU culling uses different position and scale offsets, culling and LODs must read the same ones.");
+	ZEST__FLAG(layer->flags, zest_layer_flag_mesh_lods);
+	layer->cull_position_offset = position_offset;
+	layer->cull_scale_offset = scale_offset;
+}
+
+zest_uint zest_AddLayerMeshLODChain(zest_layer layer, const zest_uint *mesh_indexes, const float *min_screen_sizes, zest_uint level_count) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	ZEST_ASSERT(ZEST__FLAGGED(layer->flags, zest_layer_flag_mesh_lods), "Call zest_EnableLayerMeshLODs before adding LOD chains to the layer.");
+	ZEST_ASSERT(level_count > 0 && level_count <= ZEST_MAX_MESH_LODS, "A LOD chain needs between 1 and ZEST_MAX_MESH_LODS levels.");
+	zest_mesh_lod_chain_t chain = ZEST__ZERO_INIT(zest_mesh_lod_chain_t);
+	for (zest_uint level = 0; level != level_count; ++level) {
+		ZEST_ASSERT(zest_LayerHasMesh(layer, mesh_indexes[level]), "A mesh in the LOD chain isn't in the layer. Add the meshes with zest_AddMeshToLayer first.");
+		ZEST_ASSERT(level == 0 || min_screen_sizes[level] < min_screen_sizes[level - 1], "Each level of a LOD chain must have a smaller screen size than the one before.");
+		chain.levels[level].mesh_index = mesh_indexes[level];
+		chain.levels[level].min_screen_size = min_screen_sizes[level];
+	}
+	chain.level_count = level_count;
+	zest_vec_push(layer->context->allocator, layer->lod_chains, chain);
+	return zest_vec_size(layer->lod_chains) - 1;
+}
+
+void zest_SetLayerLODView(zest_layer layer, zest_vec3 position, float lod_scale) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	layer->lod_view = zest_Vec4Set(position.x, position.y, position.z, lod_scale);
+}
+
+//The radius that the screen sizes of a chain are worked out from, which the cull shader reads from each level's draw
+ZEST_PRIVATE float zest__mesh_lod_radius(zest_layer layer, zest_mesh_lod_chain_t *chain) {
+	float radius = layer->mesh_offsets[chain->levels[0].mesh_index].cull_radius;
+	return radius > 0.f ? radius : 1.f;
+}
+
+//Keep this in step with the LOD test in the cull shader
+ZEST_PRIVATE float zest__layer_instance_screen_size(zest_layer layer, const zest_byte *instance, float radius) {
+	if (layer->lod_view.w <= 0.f) {
+		return ZEST_MAX_FLOAT;
+	}
+	zest_vec3 position;
+	memcpy(&position, instance + layer->cull_position_offset, sizeof(zest_vec3));
+	if (layer->cull_scale_offset != ZEST_INVALID) {
+		zest_vec3 scale;
+		memcpy(&scale, instance + layer->cull_scale_offset, sizeof(zest_vec3));
+		radius *= ZEST__MAX(ZEST__MAX(fabsf(scale.x), fabsf(scale.y)), fabsf(scale.z));
+	}
+	float distance = zest_LengthVec3(zest_SubVec3(position, zest_Vec3Set(layer->lod_view.x, layer->lod_view.y, layer->lod_view.z)));
+	return radius / ZEST__MAX(distance, 0.0001f) * layer->lod_view.w;
+}
+
+ZEST_PRIVATE void zest__push_lod_instruction(zest_layer layer, zest_layer_instruction_t *instruction) {
+	zest_vec_push_aligned(layer->context->device->allocator, layer->draw_instructions[layer->fif], *instruction, 16);
+	if (ZEST__FLAGGED(layer->flags, zest_layer_flag_multi_draw_indirect)) {
+		zest__write_layer_indirect_command(layer, zest_vec_size(layer->draw_instructions[layer->fif]) - 1);
+	}
+}
+
+void zest__end_lod_instructions(zest_layer layer) {
+	zest_layer_instruction_t group = layer->current_instruction;
+	zest_mesh_lod_chain_t *chain = &layer->lod_chains[layer->lod_chain];
+	layer->lod_drawing = ZEST_FALSE;
+	layer->last_draw_mode = zest_draw_mode_none;
+	layer->current_instruction.total_instances = 0;
+	layer->current_instruction.start_index = 0;
+	if (!group.total_instances) {
+		return;
+	}
+	float radius = zest__mesh_lod_radius(layer, chain);
+	if (ZEST__FLAGGED(layer->flags, zest_layer_flag_gpu_culling)) {
+		//The cull shader picks the level of each instance so every level gets a draw with room for all of them
+		for (zest_uint level = 0; level != chain->level_count; ++level) {
+			zest_layer_instruction_t instruction = group;
+			instruction.mesh_index = chain->levels[level].mesh_index;
+			instruction.lod_level = level;
+			instruction.lod_radius = radius;
+			instruction.lod_min = chain->levels[level].min_screen_size;
+			instruction.lod_max = level ? chain->levels[level - 1].min_screen_size : -1.f;
+			zest__push_lod_instruction(layer, &instruction);
+		}
+		return;
+	}
+
+	//Sort the instances in to a run for each level. Instances that are too small for every level go at the end
+	//and are dropped.
+	zest_context context = layer->context;
+	zest_layer_buffers_t *buffers = &layer->memory_refs[layer->fif];
+	zest_size instance_size = layer->instance_struct_size;
+	zest_uint count = group.total_instances;
+	zest_byte *instances = (zest_byte*)zest_BufferData(buffers->staging_instance_data) + group.start_index * instance_size;
+	zest_uint level_counts[ZEST_MAX_MESH_LODS + 1] = { 0 };
+	zest_uint level_starts[ZEST_MAX_MESH_LODS + 1];
+	zest_vec_resize(context->allocator, layer->lod_levels, count);
+	zest_vec_resize(context->allocator, layer->lod_scratch, count * instance_size);
+	for (zest_uint i = 0; i != count; ++i) {
+		float screen_size = zest__layer_instance_screen_size(layer, instances + i * instance_size, radius);
+		zest_uint level = 0;
+		while (level != chain->level_count && screen_size < chain->levels[level].min_screen_size) {
+			level++;
+		}
+		layer->lod_levels[i] = level;
+		level_counts[level]++;
+	}
+	zest_uint start = 0;
+	for (zest_uint level = 0; level <= chain->level_count; ++level) {
+		level_starts[level] = start;
+		start += level_counts[level];
+	}
+	for (zest_uint i = 0; i != count; ++i) {
+		memcpy(layer->lod_scratch + level_starts[layer->lod_levels[i]]++ * instance_size, instances + i * instance_size, instance_size);
+	}
+	zest_uint dropped = level_counts[chain->level_count];
+	memcpy(instances, layer->lod_scratch, (count - dropped) * instance_size);
+	if (dropped) {
+		buffers->instance_count -= dropped;
+		buffers->instance_ptr = (zest_byte*)buffers->instance_ptr - dropped * instance_size;
+	}
+	if (ZEST__FLAGGED(layer->flags, zest_layer_flag_delta_upload)) {
+		zest__mark_layer_pages_dirty(layer, group.start_index * instance_size, (count - dropped) * instance_size);
+	}
+
+	zest_uint start_index = group.start_index;
+	for (zest_uint level = 0; level != chain->level_count; ++level) {
+		if (!level_counts[level]) continue;
+		zest_layer_instruction_t instruction = group;
+		instruction.mesh_index = chain->levels[level].mesh_index;
+		instruction.lod_level = level;
+		instruction.start_index = start_index;
+		instruction.total_instances = level_counts[level];
+		zest__push_lod_instruction(layer, &instruction);
+		start_index += level_counts[level];
+	}
+}
+
+zest_bool zest__layer_cull_is_active(zest_layer layer, zest_frame_graph frame_graph) {
+	if (ZEST__NOT_FLAGGED(layer->flags, zest_layer_flag_gpu_culling) || ZEST__NOT_FLAGGED(layer->flags, zest_layer_flag_multi_draw_indirect)) {
+		return ZEST_FALSE;
+	}
+	//The resource nodes belong to whichever graph last ran the cull pass so check that it's this one
+	if (layer->cull_frame_graph != frame_graph) {
+		return ZEST_FALSE;
+	}
+	return layer->culled_instances_node->storage_buffer && layer->cull_commands_node->storage_buffer;
+}
+
+zest_buffer zest__layer_culled_instances_provider(zest_context context, zest_resource_node resource) {
+	zest_layer layer = (zest_layer)resource->user_data;
+	layer->culled_instances_node = resource;
+	layer->cull_frame_graph = resource->frame_graph;
+	zest__end_instance_instructions(layer); //Make sure the staging buffer memory in use is up to date
+	//The same size as the layer's instances so that each draw keeps its start index, plus room after them for the
+	//levels of LOD chains after the first, which could each get every instance in the chain's draw
+	zest_uint instance_count = layer->memory_refs[layer->fif].instance_count;
+	zest_vec_foreach(i, layer->draw_instructions[layer->fif]) {
+		zest_layer_instruction_t *instruction = &layer->draw_instructions[layer->fif][i];
+		if (instruction->lod_level && instruction->lod_radius > 0.f) {
+			instance_count += instruction->total_instances;
+		}
+	}
+	resource->buffer_desc.size = instance_count * layer->instance_struct_size;
+	return NULL;
+}
+
+zest_buffer zest__layer_cull_commands_provider(zest_context context, zest_resource_node resource) {
+	zest_layer layer = (zest_layer)resource->user_data;
+	layer->cull_commands_node = resource;
+	if (!zest__reserve_layer_indirect_commands(layer, 1)) {
+		return NULL;
+	}
+	zest_buffer buffer = layer->memory_refs[layer->fif].indirect_commands;
+	resource->buffer_desc.size = buffer->size;
+	return buffer;
+}
+
+void zest__layer_cull_task(const zest_command_list command_list, void *user_data) {
+	zest_layer layer = (zest_layer)user_data;
+	zest_device device = command_list->context->device;
+	if (!zest__layer_cull_is_active(layer, command_list->frame_graph) || !zest_ResourceBufferIsValid(layer->vertex_buffer_node)) {
+		return;
+	}
+	zest_layer_buffers_t *buffers = &layer->memory_refs[layer->fif];
+	zest_layer_instruction_t *instructions = layer->draw_instructions[layer->fif];
+	zest_uint instruction_count = zest_vec_size(instructions);
+	zest_size draws_offset = (zest_size)buffers->indirect_capacity * (sizeof(zest_draw_indexed_indirect_command_t) + sizeof(zest_uint));
+	zest_size view_offset = draws_offset + (zest_size)buffers->indirect_capacity * sizeof(zest_layer_cull_draw_t);
+	zest_byte *data = (zest_byte *)zest_BufferData(buffers->indirect_commands);
+	zest_draw_indexed_indirect_command_t *commands = (zest_draw_indexed_indirect_command_t *)data;
+	zest_layer_cull_draw_t *draws = (zest_layer_cull_draw_t *)(data + draws_offset);
+
+	//The buffer is host visible and this frame in flight isn't in use so the cull data can be written straight in
+	zest_uint max_instances = 0;
+	zest_uint lod_target = buffers->instance_count;
+	for (zest_uint i = 0; i != instruction_count; ++i) {
+		zest_layer_instruction_t *instruction = &instructions[i];
+		draws[i] = ZEST__ZERO_INIT(zest_layer_cull_draw_t);
+		if (instruction->draw_mode == zest_draw_mode_viewport) {
+			continue;
+		}
+		draws[i].first_instance = instruction->start_index;
+		draws[i].instance_count = instruction->total_instances;
+		draws[i].radius = layer->mesh_offsets[instruction->mesh_index].cull_radius;
+		draws[i].target_instance = instruction->start_index;
+		if (instruction->lod_radius > 0.f) {
+			draws[i].lod_radius = instruction->lod_radius;
+			draws[i].lod_min = instruction->lod_min;
+			draws[i].lod_max = instruction->lod_max;
+			if (instruction->lod_level) {
+				//Each level after the first is compacted after the layer's instances, see zest__layer_culled_instances_provider
+				draws[i].target_instance = lod_target;
+				lod_target += instruction->total_instances;
+			}
+		}
+		//Counted back up by the shader for each instance that's visible
+		commands[i].instance_count = 0;
+		commands[i].first_instance = draws[i].target_instance;
+		max_instances = ZEST__MAX(max_instances, instruction->total_instances);
+	}
+	memcpy(data + view_offset, &layer->cull_view, sizeof(zest_layer_cull_view_t));
+	memcpy(data + view_offset + sizeof(zest_layer_cull_view_t), &layer->lod_view, sizeof(zest_vec4));
+	if (!max_instances) {
+		return;
+	}
+
+	zest_layer_cull_push_t push = ZEST__ZERO_INIT(zest_layer_cull_push_t);
+	push.instances_index = zest_GetTransientBufferBindlessIndex(command_list, layer->vertex_buffer_node);
+	push.culled_index = zest_GetTransientBufferBindlessIndex(command_list, layer->culled_instances_node);
+	push.commands_index = zest_GetTransientBufferBindlessIndex(command_list, layer->cull_commands_node);
+	push.hiz_index = ZEST_INVALID;
+	if (layer->cull_hiz_name) {
+		zest_resource_node hiz = zest_GetPassInputResource(command_list, layer->cull_hiz_name);
+		if (hiz) {
+			push.hiz_index = zest_GetTransientSampledImageBindlessIndex(command_list, hiz, zest_texture_2d_binding);
+			push.hiz_sampler_index = layer->cull_view.hiz_sampler_index;
+		}
+	}
+	push.instance_words = (zest_uint)(layer->instance_struct_size / 4);
+	push.position_word = layer->cull_position_offset / 4;
+	push.scale_word = layer->cull_scale_offset == ZEST_INVALID ? ZEST_INVALID : layer->cull_scale_offset / 4;
+	push.draws_word = (zest_uint)(draws_offset / 4);
+	push.view_word = (zest_uint)(view_offset / 4);
+	push.lod_word = (zest_uint)((view_offset + sizeof(zest_layer_cull_view_t)) / 4);
+
+	zest_cmd_BindComputePipeline(command_list, zest_GetCompute(device->layer_cull_compute));
+	zest_cmd_SendPushConstants(command_list, &push, sizeof(zest_layer_cull_push_t));
+	//A row of workgroups for each instruction
+	zest_cmd_DispatchCompute(command_list, (max_instances + 63) / 64, instruction_count, 1);
+}
+
+zest_layer_handle zest_CreateMeshLayer(zest_context context, const char* name, zest_size vertex_struct_size, zest_size vertex_capacity, zest_size index_capacity) {
+    zest_layer layer;
+    zest_layer_handle handle = zest__new_layer(context, &layer);
+    layer->name = name;
+    zest__initialise_mesh_layer(context, layer, vertex_struct_size, 1000);
+	zest__activate_resource(handle.store, handle.value);
+    return handle;
+}
+
+zest_layer_handle zest_CreateInstanceMeshLayer(zest_context context, const char *name, zest_size instance_struct_size, zest_size vertex_capacity, zest_size index_capacity) {
+    zest_layer layer;
+    zest_layer_handle handle = zest__new_layer(context, &layer);
+    layer->name = name;
+    zest__initialise_instance_layer(context, layer, instance_struct_size, 1000);
+	zest_buffer_info_t vertex_info = zest_CreateBufferInfo(zest_buffer_type_vertex, zest_memory_usage_gpu_only);
+	zest_buffer_info_t index_info = zest_CreateBufferInfo(zest_buffer_type_index, zest_memory_usage_gpu_only);
+	layer->vertex_data = zest_CreateBuffer(context->device, vertex_capacity, &vertex_info);
+	layer->index_data = zest_CreateBuffer(context->device, index_capacity, &index_info);
+	zest__activate_resource(handle.store, handle.value);
+    return handle;
+}
+
+zest_layer_handle zest_CreateFIFInstanceMeshLayer(zest_context context, const char *name, zest_size instance_struct_size, zest_size vertex_capacity, zest_size index_capacity) {
+	zest_layer_handle handle = zest_CreateInstanceMeshLayer(context, name, instance_struct_size, vertex_capacity, index_capacity);
+	zest_layer layer = (zest_layer)zest__get_store_resource_checked(handle.store, handle.value);
+	zest__create_fif_instance_device_buffers(layer);
+	ZEST__FLAG(layer->flags, zest_layer_flag_manual_fif);
+	return handle;
+}
+
+// --Texture and Image functions
+zest_image_handle zest__new_image(zest_device device) {
+	zest_resource_store_t *store = &device->resource_stores[zest_handle_type_images];
+    zest_image_handle handle = ZEST_STRUCT_LITERAL(zest_image_handle, zest__add_store_resource(store), store );
+	handle.store = store;
+    zest_image image = (zest_image)zest__get_store_resource_unsafe(store, handle.value);
+    *image = ZEST__ZERO_INIT(zest_image_t);
+    image->magic = zest_INIT_MAGIC(zest_struct_type_image);
+    image->backend = (zest_image_backend)device->platform->new_image_backend(device);
+    for (int i = 0; i != zest_max_global_binding_number; ++i) {
+        image->bindless_index[i] = ZEST_INVALID;
+    }
+	image->handle = handle;
+    return handle;
+}
+
+zest_bool zest__validate_image_info(zest_device device, zest_image_info_t *create_info) {
+	ZEST_ASSERT_OR_VALIDATE(create_info->extent.width * create_info->extent.height * create_info->extent.depth > 0,
+		device, "Image has 0 dimensions", ZEST_FALSE);
+	ZEST_ASSERT_OR_VALIDATE(create_info->flags,
+		device, "You must set flags in the image info to specify how the image will be used", ZEST_FALSE);
+	ZEST_ASSERT_OR_VALIDATE(create_info->format > zest_format_undefined && create_info->format < zest_max_format,
+		device, "Invalid image format specified", ZEST_FALSE);
+	//Validate format/usage compatibility
+	if (zest__is_depth_stencil_format(create_info->format)) {
+		ZEST_ASSERT_OR_VALIDATE(!ZEST__FLAGGED(create_info->flags, zest_image_flag_color_attachment),
+			device, "Depth/stencil format cannot be used as color attachment", ZEST_FALSE);
+	} else {
+		ZEST_ASSERT_OR_VALIDATE(!ZEST__FLAGGED(create_info->flags, zest_image_flag_depth_stencil_attachment),
+			device, "Color format cannot be used as depth/stencil attachment", ZEST_FALSE);
+	}
+	if (zest__is_compressed_format(create_info->format)) {
+		ZEST_ASSERT_OR_VALIDATE(!ZEST__FLAGGED(create_info->flags, zest_image_flag_color_attachment) &&
+			!ZEST__FLAGGED(create_info->flags, zest_image_flag_depth_stencil_attachment),
+			device, "Compressed format cannot be used as render attachment", ZEST_FALSE);
+		ZEST_ASSERT_OR_VALIDATE(!ZEST__FLAGGED(create_info->flags, zest_image_flag_generate_mipmaps),
+			device, "Cannot generate mipmaps for compressed formats. Use pre-compressed mipmaps in KTX files instead.", ZEST_FALSE);
+	}
+	if (ZEST__FLAGGED(create_info->flags, zest_image_flag_cubemap)) {
+		ZEST_ASSERT_OR_VALIDATE(create_info->layer_count > 0 && create_info->layer_count % 6 == 0,
+			device, "Cubemap must have layers in multiples of 6", ZEST_FALSE);
+	}
+	if (create_info->extent.depth > 1) {
+		ZEST_ASSERT_OR_VALIDATE(create_info->layer_count <= 1,
+			device, "3D images (extent.depth > 1) must have layer_count of 1. Vulkan does not support arrays of 3D images.", ZEST_FALSE);
+		ZEST_ASSERT_OR_VALIDATE(!ZEST__FLAGGED(create_info->flags, zest_image_flag_cubemap),
+			device, "3D images cannot be cubemaps", ZEST_FALSE);
+		ZEST_ASSERT_OR_VALIDATE(!ZEST__FLAGGED(create_info->flags, zest_image_flag_generate_mipmaps),
+			device, "Automatic mipmap generation is not supported for 3D images. Provide pre-generated mips or specify mip_levels = 1.", ZEST_FALSE);
+	}
+	//Check if the format is supported with the requested flags
+	ZEST_ASSERT_OR_VALIDATE(device->platform->is_image_format_supported(device, create_info->format, create_info->flags),
+		device, "Image format is not supported with the requested usage flags", ZEST_FALSE);
+	return ZEST_TRUE;
+}
+
+void zest__set_image_info(zest_image image, zest_image_info_t *create_info) {
+    image->info = *create_info;
     image->info.aspect_flags = zest__determine_aspect_flag_for_view(create_info->format);
     image->info.mip_levels = create_info->mip_levels > 0 ? create_info->mip_levels : 1;
     if (image->info.layer_count == 0) {
@@ -18830,6 +22428,17 @@ ZEST_PRIVATE zest_image_handle zest__create_image(zest_device device, zest_image
     if (ZEST__FLAGGED(create_info->flags, zest_image_flag_generate_mipmaps) && image->info.mip_levels == 1) {
         image->info.mip_levels = (zest_uint)floor(log2(ZEST__MAX(create_info->extent.width, create_info->extent.height))) + 1;
     }
+}
+
+ZEST_PRIVATE zest_image_handle zest__create_image(zest_device device, zest_image_info_t *create_info) {
+	if (!zest__validate_image_info(device, create_info)) {
+		return ZEST__ZERO_INIT(zest_image_handle);
+	}
+	//For example you could use zest_image_preset_texture. Lookup the zest_image_flag_bits enum
+	//to see all the flags available.
+	zest_image_handle handle = zest__new_image(device);
+    zest_image image = (zest_image)zest__get_store_resource_unsafe(handle.store, handle.value);
+	zest__set_image_info(image, create_info);
     if (!device->platform->create_image(device, 0, image, image->info.layer_count, zest_sample_count_1_bit, create_info->flags)) {
         zest__cleanup_image(image);
         return ZEST__ZERO_INIT(zest_image_handle);
@@ -18955,6 +22564,32 @@ void zest__cleanup_execution_timeline(zest_execution_timeline timeline) {
 	ZEST__FREE(timeline->device->allocator, timeline);
 }
 
+zest_size zest_GetImageMipLevelSize(zest_format format, zest_extent3d_t extent, zest_uint mip_level, zest_uint layer_count) {
+	int channels, bytes_per_pixel, block_width, block_height, bytes_per_block;
+	zest_GetFormatPixelData(format, &channels, &bytes_per_pixel, &block_width, &block_height, &bytes_per_block);
+	zest_size width = ZEST__MAX(extent.width >> mip_level, 1u);
+	zest_size height = ZEST__MAX(extent.height >> mip_level, 1u);
+	zest_size depth = ZEST__MAX(extent.depth >> mip_level, 1u);
+	zest_size blocks_x = (width + block_width - 1) / block_width;
+	zest_size blocks_y = (height + block_height - 1) / block_height;
+	return blocks_x * blocks_y * depth * bytes_per_block * ZEST__MAX(layer_count, 1u);
+}
+
+zest_size zest_GetImageMipChainSize(const zest_image_info_t *create_info) {
+	zest_uint mip_levels = ZEST__MAX(create_info->mip_levels, 1u);
+	zest_size size = 0;
+	for (zest_uint mip = 0; mip != mip_levels; ++mip) {
+		size += zest_GetImageMipLevelSize(create_info->format, create_info->extent, mip, create_info->layer_count);
+	}
+	return size;
+}
+
+zest_bool zest_IsImageFormatSupported(zest_device device, zest_format format, zest_image_flags flags) {
+	ZEST_ASSERT_HANDLE(device);	//Not a valid device handle
+	if (format == zest_format_undefined) return ZEST_FALSE;
+	return device->platform->is_image_format_supported(device, format, flags);
+}
+
 void zest_GetFormatPixelData(zest_format format, int *channels, int *bytes_per_pixel, int *block_width, int *block_height, int *bytes_per_block) {
 	*channels = 0;
 	*bytes_per_pixel = 0;
@@ -19334,6 +22969,52 @@ zest_image_handle zest_CreateImage(zest_device device, zest_image_info_t *create
     return image_handle;
 } 
 
+zest_bool zest_CreateImages(zest_device device, zest_image_info_t *create_infos, zest_uint count, zest_image_handle *handles) {
+	ZEST_ASSERT_HANDLE(device);	//Not a valid device handle
+	ZEST_ASSERT(create_infos && handles, "You must pass an array of image infos and an array of handles to fill in.");
+	memset(handles, 0, sizeof(zest_image_handle) * count);
+	if (!count) return ZEST_TRUE;
+	for (zest_uint i = 0; i != count; ++i) {
+		if (!zest__validate_image_info(device, &create_infos[i])) {
+			return ZEST_FALSE;
+		}
+	}
+	zest_image *images = (zest_image*)ZEST__ALLOCATE(device->allocator, sizeof(zest_image) * count);
+	zest_bool has_storage = ZEST_FALSE;
+	for (zest_uint i = 0; i != count; ++i) {
+		handles[i] = zest__new_image(device);
+		images[i] = (zest_image)zest__get_store_resource_unsafe(handles[i].store, handles[i].value);
+		zest__set_image_info(images[i], &create_infos[i]);
+		has_storage |= ZEST__FLAGGED(create_infos[i].flags, zest_image_flag_storage);
+	}
+	if (!device->platform->create_images(device, images, count)) {
+		for (zest_uint i = 0; i != count; ++i) {
+			zest__cleanup_image(images[i]);
+		}
+		ZEST__FREE(device->allocator, images);
+		memset(handles, 0, sizeof(zest_image_handle) * count);
+		return ZEST_FALSE;
+	}
+	//Storage images are transitioned together in one submission instead of one each
+	zest_queue queue = has_storage ? zest_imm_BeginCommandBuffer(device, zest_queue_graphics) : 0;
+	for (zest_uint i = 0; i != count; ++i) {
+		zest_image image = images[i];
+		image->layout = zest_image_layout_undefined;
+		if (queue && ZEST__FLAGGED(image->info.flags, zest_image_flag_storage)) {
+			zest_imm_TransitionImage(queue, image, zest_resource_state_unordered_access, 0, ZEST__ALL_MIPS, 0, ZEST__ALL_LAYERS);
+		}
+		zest_image_view_type view_type = zest__get_image_view_type(image);
+		image->default_view = device->platform->create_image_view(device, image, view_type, image->info.mip_levels, 0, 0, image->info.layer_count, 0);
+		image->default_view->handle.store = &device->resource_stores[zest_handle_type_views];
+		zest__activate_resource(handles[i].store, handles[i].value);
+	}
+	if (queue) {
+		zest_imm_EndCommandBuffer(queue);
+	}
+	ZEST__FREE(device->allocator, images);
+	return ZEST_TRUE;
+}
+
 zest_image_handle zest_CreateImageWithPixels(zest_device device, void *pixels, zest_size size, zest_image_info_t *create_info) {
 	int channels, bytes_per_pixel, block_width, block_height, bytes_per_block;
 	zest_GetFormatPixelData(create_info->format, &channels, &bytes_per_pixel, &block_width, &block_height, &bytes_per_block);
@@ -19351,46 +23032,1155 @@ zest_image_handle zest_CreateImageWithPixels(zest_device device, void *pixels, z
 	return image_handle;
 }
 
-zest_image zest_GetImage(zest_image_handle handle) {
-	zest_image image = (zest_image)zest__get_store_resource_checked(handle.store, handle.value);
-	return image;
+zest_image_handle zest_CreateImageWithMipChain(zest_device device, void *pixels, zest_size size, zest_image_info_t *create_info) {
+	ZEST_ASSERT_HANDLE(device);	//Not a valid device handle
+	ZEST_ASSERT(pixels, "No pixel data was passed in to upload to the image.");
+	zest_image_handle null_handle = ZEST__ZERO_INIT(zest_image_handle);
+	ZEST_ASSERT_OR_VALIDATE(ZEST__NOT_FLAGGED(create_info->flags, zest_image_flag_generate_mipmaps), device,
+		"zest_CreateImageWithMipChain uploads the mip levels that you pass in. Remove zest_image_flag_generate_mipmaps from the image flags.", null_handle);
+	zest_uint mip_levels = ZEST__MAX(create_info->mip_levels, 1u);
+	zest_uint layer_count = ZEST__MAX(create_info->layer_count, 1u);
+	ZEST_ASSERT_OR_VALIDATE(mip_levels <= ZEST_MAX_IMAGE_MIP_LEVELS, device,
+		"Too many mip levels for zest_CreateImageWithMipChain.", null_handle);
+	ZEST_ASSERT_OR_VALIDATE(size == zest_GetImageMipChainSize(create_info), device,
+		"Size of pixels memory does not match the mip chain described by the image info. Use zest_GetImageMipChainSize to check the expected size.", null_handle);
+
+	zest_buffer_image_copy_t regions[ZEST_MAX_IMAGE_MIP_LEVELS];
+	zest_size offset = 0;
+	for (zest_uint mip = 0; mip != mip_levels; ++mip) {
+		zest_buffer_image_copy_t *region = &regions[mip];
+		*region = ZEST__ZERO_INIT(zest_buffer_image_copy_t);
+		region->buffer_offset = offset;
+		region->image_aspect = zest_image_aspect_color_bit;
+		region->mip_level = mip;
+		region->base_array_layer = 0;
+		region->layer_count = layer_count;
+		region->image_extent.width = ZEST__MAX(create_info->extent.width >> mip, 1u);
+		region->image_extent.height = ZEST__MAX(create_info->extent.height >> mip, 1u);
+		region->image_extent.depth = ZEST__MAX(create_info->extent.depth >> mip, 1u);
+		offset += zest_GetImageMipLevelSize(create_info->format, create_info->extent, mip, layer_count);
+	}
+
+	zest_buffer staging_buffer = zest_CreateDedicatedStagingBuffer(device, size, pixels);
+	if (!staging_buffer) {
+		ZEST_REPORT(device, zest_report_memory, "Unable to create a %llu byte staging buffer to upload a mip chain.", size);
+		return null_handle;
+	}
+	zest_image_handle image_handle = zest__create_image(device, create_info);
+	if (!image_handle.value) {
+		zest_FreeBufferNow(staging_buffer);
+		return null_handle;
+	}
+	zest_image image = zest__get_image_unsafe(image_handle);
+	zest__activate_resource(image_handle.store, image_handle.value);
+
+	//Every level goes in one copy between two transitions rather than a copy and a blit chain per level.
+	zest_queue queue = zest_imm_BeginCommandBuffer(device, zest_queue_graphics);
+	zest_bool uploaded = queue != 0;
+	uploaded = uploaded && zest_imm_TransitionImage(queue, image, zest_resource_state_copy_dst, 0, mip_levels, 0, layer_count);
+	uploaded = uploaded && zest_imm_CopyBufferRegionsToImage(queue, regions, mip_levels, staging_buffer, image);
+	uploaded = uploaded && zest_imm_TransitionImage(queue, image, zest_resource_state_shader_read, 0, mip_levels, 0, layer_count);
+	if (queue) {
+		uploaded = zest_imm_EndCommandBuffer(queue) && uploaded;
+	}
+	zest_FreeBufferNow(staging_buffer);
+	if (!uploaded) {
+		zest_FreeImageNow(image_handle);
+		return null_handle;
+	}
+	return image_handle;
 }
 
-void zest_FreeImage(zest_image_handle handle) {
-	if (!handle.value) return;
-    zest_image image = (zest_image)zest__get_store_resource_checked(handle.store, handle.value);
-	ZEST_ASSERT(image, "The image that you're trying to free is stale. Make sure that it wasn't already freed at some point.");
-	zest_device device = (zest_device)handle.store->origin;
-	zest_uint index = device->frame_counter % ZEST_MAX_FIF;
-    zest_vec_push(device->allocator, device->deferred_resource_freeing_list.resources[index], image);
+// -- Image_streaming
+zest_image_streamer_info_t zest_CreateImageStreamerInfo(void) {
+	zest_image_streamer_info_t info = ZEST__ZERO_INIT(zest_image_streamer_info_t);
+	info.ring_size = zloc__MEGABYTE(64);
+	info.frame_budget = zloc__MEGABYTE(8);
+	return info;
 }
 
-void zest_FreeImageNow(zest_image_handle handle) {
-	if (!handle.value) return;
-    zest_image image = (zest_image)zest__get_store_resource_checked(handle.store, handle.value);
-	zest_device device = (zest_device)handle.store->origin;
-	zest__free_handle(device->allocator, image);
+zest_queue_manager zest__find_stream_transfer_manager(zest_device device) {
+	//Prefer a family that can only transfer so that uploads run alongside rendering, then any other family that
+	//isn't graphics, and finally the graphics family itself in which case there's no ownership transfer.
+	zest_queue_manager graphics_manager = device->queue_pool[zest_queue_graphics]->managers[0];
+	zest_queue_manager fallback = 0;
+	zest_vec_foreach(i, device->queue_families) {
+		zest_queue_manager queue_manager = device->queue_families[i];
+		if (!queue_manager || ZEST__NOT_FLAGGED(queue_manager->type, zest_queue_transfer)) continue;
+		if (queue_manager->type == zest_queue_transfer) return queue_manager;
+		if (queue_manager != graphics_manager && !fallback) fallback = queue_manager;
+	}
+	return fallback ? fallback : graphics_manager;
 }
 
-void zest_FreeImageView(zest_image_view_handle handle) {
-	if (!handle.value) return;
-    zest_image_view view = *(zest_image_view*)zest__get_store_resource_checked(handle.store, handle.value);
-	zest_device device = (zest_device)handle.store->origin;
-	zest_uint index = device->frame_counter % ZEST_MAX_FIF;
-    zest_vec_push(device->allocator, device->deferred_resource_freeing_list.resources[index], view);
+zest_image_streamer zest_CreateImageStreamer(zest_device device, zest_image_streamer_info_t *info) {
+	ZEST_ASSERT_HANDLE(device);	//Not a valid device handle
+	ZEST_ASSERT(info && info->ring_size > 0, "An image streamer needs a staging ring size. Use zest_CreateImageStreamerInfo to get the defaults.");
+	ZEST_ASSERT(device->queue_pool[zest_queue_graphics], "The device has no graphics queue to stream images with.");
+	zest_image_streamer streamer = ZEST__NEW(device->allocator, zest_image_streamer);
+	*streamer = ZEST__ZERO_INIT(zest_image_streamer_t);
+	streamer->magic = zest_INIT_MAGIC(zest_struct_type_image_streamer);
+	streamer->device = device;
+	streamer->ring_size = info->ring_size;
+	streamer->frame_budget = info->frame_budget;
+	streamer->next_ticket = 1;
+	streamer->graphics_manager = device->queue_pool[zest_queue_graphics]->managers[0];
+	streamer->transfer_manager = zest__find_stream_transfer_manager(device);
+	streamer->staging_ring = zest_CreateDedicatedStagingBuffer(device, info->ring_size, 0);
+	streamer->timeline = zest_CreateExecutionTimeline(device);
+	if (!streamer->staging_ring || !streamer->timeline || !device->platform->create_image_streamer_backend(streamer)) {
+		ZEST_REPORT(device, zest_report_memory, "Unable to create an image streamer with a %llu byte staging ring.", info->ring_size);
+		zest__free_image_streamer(streamer);
+		return NULL;
+	}
+	return streamer;
 }
 
-void zest_FreeImageViewNow(zest_image_view_handle handle) {
-	if (!handle.value) return;
-    zest_image_view view = *(zest_image_view*)zest__get_store_resource_checked(handle.store, handle.value);
-	zest_device device = (zest_device)handle.store->origin;
-	zest__free_handle(device->allocator, view);
+void zest__free_image_streamer(zest_image_streamer streamer) {
+	zest_device device = streamer->device;
+	if (streamer->backend) {
+		device->platform->cleanup_image_streamer_backend(streamer);
+	}
+	if (streamer->staging_ring) {
+		zest_FreeBufferNow(streamer->staging_ring);
+	}
+	if (streamer->timeline) {
+		zest__cleanup_execution_timeline(streamer->timeline);
+	}
+	zest_vec_free(device->allocator, streamer->queued_uploads);
+	ZEST__FREE(device->allocator, streamer);
 }
 
-void zest_FreeImageViewArray(zest_image_view_array_handle handle) {
-	if (!handle.value) return;
-    zest_image_view_array view = *(zest_image_view_array*)zest__get_store_resource_checked(handle.store, handle.value);
-	zest_device device = (zest_device)handle.store->origin;
+void zest_FreeImageStreamer(zest_image_streamer streamer) {
+	ZEST_ASSERT_HANDLE(streamer);	//Not a valid image streamer handle
+	if (streamer->batches_in_flight) {
+		streamer->device->platform->wait_for_timeline(streamer->timeline, ZEST_SECONDS_IN_MICROSECONDS(1000));
+	}
+	zest__free_image_streamer(streamer);
+}
+
+zest_size zest__image_stream_size(zest_image_info_t *info, zest_size *bytes_per_block) {
+	int channels, bytes_per_pixel, block_width, block_height, block_bytes;
+	zest_GetFormatPixelData(info->format, &channels, &bytes_per_pixel, &block_width, &block_height, &block_bytes);
+	zest_size blocks_x = (info->extent.width + block_width - 1) / block_width;
+	zest_size blocks_y = (info->extent.height + block_height - 1) / block_height;
+	zest_size depth = info->extent.depth > 0 ? info->extent.depth : 1;
+	zest_size layers = info->layer_count > 0 ? info->layer_count : 1;
+	*bytes_per_block = block_bytes;
+	return blocks_x * blocks_y * depth * layers * block_bytes;
+}
+
+zest_bool zest__ring_allocate(zest_size ring_size, zest_size *head, zest_size *tail, zest_size size, zest_size alignment, zest_size *offset) {
+	//Copy offsets have to be a multiple of 4 and of the texel block size
+	zest_size start = (*head + 15) & ~(zest_size)15;
+	while (alignment && start % alignment) start += 16;
+	//The head never catches up with the tail exactly so that head == tail only ever means the ring is empty
+	if (*head >= *tail) {
+		if (start + size <= ring_size) {
+			*offset = start;
+			*head = start + size;
+			return ZEST_TRUE;
+		}
+		//Wrap around to the start of the ring, behind the oldest copy that's still using it
+		if (size < *tail) {
+			*offset = 0;
+			*head = size;
+			return ZEST_TRUE;
+		}
+		return ZEST_FALSE;
+	}
+	if (start + size < *tail) {
+		*offset = start;
+		*head = start + size;
+		return ZEST_TRUE;
+	}
+	return ZEST_FALSE;
+}
+
+zest_bool zest__stream_ring_allocate(zest_image_streamer streamer, zest_size size, zest_size alignment, zest_size *offset) {
+	if (!streamer->outstanding_uploads) {
+		streamer->ring_head = 0;
+		streamer->ring_tail = 0;
+	}
+	return zest__ring_allocate(streamer->ring_size, &streamer->ring_head, &streamer->ring_tail, size, alignment, offset);
+}
+
+void zest__retire_image_stream_batches(zest_image_streamer streamer) {
+	if (!streamer->batches_in_flight) return;
+	zest_u64 gpu_value = streamer->device->platform->get_timeline_value(streamer->timeline);
+	while (streamer->batches_in_flight) {
+		zest_image_stream_batch_t *batch = &streamer->batches[streamer->oldest_batch];
+		if (batch->timeline_value > gpu_value) break;
+		streamer->completed_ticket = batch->last_ticket;
+		streamer->ring_tail = batch->ring_end;
+		streamer->outstanding_uploads -= batch->request_count;
+		streamer->oldest_batch = (streamer->oldest_batch + 1) % ZEST_STREAM_BATCHES_IN_FLIGHT;
+		streamer->batches_in_flight--;
+	}
+}
+
+zest_uint zest__submit_image_stream_batch(zest_image_streamer streamer, zest_size budget) {
+	zest_uint queued = zest_vec_size(streamer->queued_uploads) - streamer->queued_start;
+	if (!queued || streamer->batches_in_flight == ZEST_STREAM_BATCHES_IN_FLIGHT) {
+		return 0;
+	}
+	zest_image_stream_request_t *requests = streamer->queued_uploads + streamer->queued_start;
+	zest_uint count = 0;
+	zest_size bytes = 0;
+	//Always take at least one upload so that an image bigger than the budget still goes through
+	while (count < queued && (count == 0 || bytes + requests[count].size <= budget)) {
+		bytes += requests[count].size;
+		count++;
+	}
+	zest_uint slot = (streamer->oldest_batch + streamer->batches_in_flight) % ZEST_STREAM_BATCHES_IN_FLIGHT;
+	zest_image_stream_batch_t *batch = &streamer->batches[slot];
+	*batch = ZEST__ZERO_INIT(zest_image_stream_batch_t);
+	batch->index = slot;
+	batch->request_count = count;
+	batch->bytes = bytes;
+	batch->last_ticket = requests[count - 1].ticket;
+	batch->ring_end = requests[count - 1].ring_offset + requests[count - 1].size;
+	if (!streamer->device->platform->submit_image_stream_batch(streamer, batch, requests, count)) {
+		//The queues were busy, try again on the next update
+		return 0;
+	}
+	streamer->batches_in_flight++;
+	streamer->queued_start += count;
+	if (streamer->queued_start == zest_vec_size(streamer->queued_uploads)) {
+		zest_vec_clear(streamer->queued_uploads);
+		streamer->queued_start = 0;
+	}
+	streamer->total_uploads += count;
+	streamer->total_bytes += bytes;
+	streamer->last_update_bytes = bytes;
+	return count;
+}
+
+zest_stream_ticket zest_StreamPixelsToImage(zest_image_streamer streamer, zest_image_handle image_handle, const void *pixels, zest_size size) {
+	ZEST_ASSERT_HANDLE(streamer);	//Not a valid image streamer handle
+	ZEST_ASSERT(pixels, "Pixels must not be null");
+	zest_device device = streamer->device;
+	zest_image image = zest_GetImage(image_handle);
+	ZEST_ASSERT(image, "The image that you're trying to stream to is stale or was never created.");
+	zest_size bytes_per_block = 0;
+	zest_size expected_size = zest__image_stream_size(&image->info, &bytes_per_block);
+	ZEST_ASSERT(size == expected_size, "Size of pixels memory does not match the image. Streaming uploads the base level of every layer, make sure the format, extent and layer count are correct.");
+	if (size > streamer->ring_size) {
+		ZEST_REPORT(device, zest_report_memory, "An image of %llu bytes can't be streamed through a %llu byte staging ring. Create the streamer with a bigger ring_size.", size, streamer->ring_size);
+		return 0;
+	}
+	zest_size offset = 0;
+	if (!zest__stream_ring_allocate(streamer, size, bytes_per_block, &offset)) {
+		streamer->ring_full_count++;
+		return 0;
+	}
+	zest__parallel_copy(device, (char*)zest_BufferData(streamer->staging_ring) + offset, pixels, size);
+	zest_image_stream_request_t request = ZEST__ZERO_INIT(zest_image_stream_request_t);
+	request.image = image;
+	request.ring_offset = offset;
+	request.size = size;
+	request.ticket = streamer->next_ticket++;
+	zest_vec_push(device->allocator, streamer->queued_uploads, request);
+	streamer->outstanding_uploads++;
+	return request.ticket;
+}
+
+zest_image_handle zest_StreamImageWithPixels(zest_image_streamer streamer, void *pixels, zest_size size, zest_image_info_t *create_info, zest_stream_ticket *ticket) {
+	ZEST_ASSERT_HANDLE(streamer);	//Not a valid image streamer handle
+	zest_image_handle image_handle = ZEST__ZERO_INIT(zest_image_handle);
+	if (ticket) *ticket = 0;
+	zest_size bytes_per_block = 0;
+	zest_size expected_size = zest__image_stream_size(create_info, &bytes_per_block);
+	ZEST_ASSERT(size == expected_size, "Size of pixels memory does not match the image info passed in to the function. Make sure you choose the correct format and width/height/depth of the image.");
+	//Check the ring has room before creating the image so that a full ring doesn't leave an empty image behind
+	zest_size head = streamer->ring_head;
+	zest_size tail = streamer->ring_tail;
+	zest_size offset = 0;
+	if (size > streamer->ring_size) {
+		ZEST_REPORT(streamer->device, zest_report_memory, "An image of %llu bytes can't be streamed through a %llu byte staging ring. Create the streamer with a bigger ring_size.", size, streamer->ring_size);
+		return image_handle;
+	}
+	if (!zest__stream_ring_allocate(streamer, size, bytes_per_block, &offset)) {
+		streamer->ring_full_count++;
+		return image_handle;
+	}
+	streamer->ring_head = head;
+	streamer->ring_tail = tail;
+	image_handle = zest_CreateImage(streamer->device, create_info);
+	if (!image_handle.value) {
+		return image_handle;
+	}
+	zest_stream_ticket image_ticket = zest_StreamPixelsToImage(streamer, image_handle, pixels, size);
+	if (ticket) *ticket = image_ticket;
+	return image_handle;
+}
+
+zest_uint zest_UpdateImageStreamer(zest_image_streamer streamer) {
+	ZEST_ASSERT_HANDLE(streamer);	//Not a valid image streamer handle
+	streamer->last_update_bytes = 0;
+	zest__retire_image_stream_batches(streamer);
+	return zest__submit_image_stream_batch(streamer, streamer->frame_budget);
+}
+
+zest_bool zest_ImageStreamIsComplete(zest_image_streamer streamer, zest_stream_ticket ticket) {
+	ZEST_ASSERT_HANDLE(streamer);	//Not a valid image streamer handle
+	if (!ticket) return ZEST_FALSE;
+	if (ticket > streamer->completed_ticket) {
+		zest__retire_image_stream_batches(streamer);
+	}
+	return ticket <= streamer->completed_ticket;
+}
+
+zest_semaphore_status zest_FlushImageStreamer(zest_image_streamer streamer, zest_microsecs timeout) {
+	ZEST_ASSERT_HANDLE(streamer);	//Not a valid image streamer handle
+	zest_platform platform = streamer->device->platform;
+	zest_semaphore_status status = zest_semaphore_status_success;
+	while (zest_vec_size(streamer->queued_uploads) > streamer->queued_start) {
+		zest__retire_image_stream_batches(streamer);
+		if (streamer->batches_in_flight == ZEST_STREAM_BATCHES_IN_FLIGHT) {
+			status = platform->wait_for_timeline(streamer->timeline, timeout);
+			if (status != zest_semaphore_status_success) return status;
+			continue;
+		}
+		if (!zest__submit_image_stream_batch(streamer, (zest_size)-1)) {
+			return zest_semaphore_status_error;
+		}
+	}
+	if (streamer->batches_in_flight) {
+		status = platform->wait_for_timeline(streamer->timeline, timeout);
+		zest__retire_image_stream_batches(streamer);
+	}
+	return status;
+}
+
+zest_execution_timeline zest_GetImageStreamerTimeline(zest_image_streamer streamer) {
+	ZEST_ASSERT_HANDLE(streamer);	//Not a valid image streamer handle
+	return streamer->timeline;
+}
+
+zest_image_streamer_stats_t zest_GetImageStreamerStats(zest_image_streamer streamer) {
+	ZEST_ASSERT_HANDLE(streamer);	//Not a valid image streamer handle
+	zest_image_streamer_stats_t stats = ZEST__ZERO_INIT(zest_image_streamer_stats_t);
+	for (zest_uint i = streamer->queued_start; i < zest_vec_size(streamer->queued_uploads); ++i) {
+		stats.queued_uploads++;
+		stats.queued_bytes += streamer->queued_uploads[i].size;
+	}
+	stats.batches_in_flight = streamer->batches_in_flight;
+	stats.outstanding_uploads = streamer->outstanding_uploads;
+	stats.completed_ticket = streamer->completed_ticket;
+	stats.total_uploads = streamer->total_uploads;
+	stats.total_bytes = streamer->total_bytes;
+	stats.last_update_bytes = streamer->last_update_bytes;
+	stats.ring_full_count = streamer->ring_full_count;
+	stats.ownership_transfer = streamer->transfer_manager != streamer->graphics_manager;
+	return stats;
+}
+// -- End Image_streaming
+
+// -- Readbacks
+zest_bool zest__prepare_readback_ring(zest_context context) {
+	zest_readback_ring_t *ring = &context->readbacks;
+	if (ring->buffer) return ZEST_TRUE;
+	zest_device device = context->device;
+	ring->size = context->create_info.readback_ring_size ? context->create_info.readback_ring_size : zloc__MEGABYTE(8);
+	ring->next_ticket = 1;
+	zest_buffer_info_t buffer_info = zest_CreateBufferInfo(zest_buffer_type_staging, zest_memory_usage_gpu_to_cpu);
+	ring->buffer = zest_CreateDedicatedBuffer(device, ring->size, &buffer_info);
+	ring->timeline = zest_CreateExecutionTimeline(device);
+	if (!ring->buffer || !ring->timeline || !device->platform->create_readback_backend(context)) {
+		ZEST_REPORT(device, zest_report_memory, "Unable to create a %llu byte readback ring.", ring->size);
+		zest__cleanup_readbacks(context);
+		return ZEST_FALSE;
+	}
+	return ZEST_TRUE;
+}
+
+void zest__cleanup_readbacks(zest_context context) {
+	zest_readback_ring_t *ring = &context->readbacks;
+	if (ring->backend) {
+		context->device->platform->cleanup_readback_backend(context);
+	}
+	if (ring->buffer) {
+		zest_FreeBufferNow(ring->buffer);
+	}
+	if (ring->timeline) {
+		zest__cleanup_execution_timeline(ring->timeline);
+	}
+	zest_vec_free(context->allocator, ring->pending);
+	*ring = ZEST__ZERO_INIT(zest_readback_ring_t);
+}
+
+zest_readback_t *zest__push_readback(zest_context context, zest_size size, zest_size alignment, zest_readback_callback callback, void *user_data) {
+	if (!zest__prepare_readback_ring(context)) {
+		return NULL;
+	}
+	zest_readback_ring_t *ring = &context->readbacks;
+	if (size > ring->size) {
+		ZEST_REPORT(context->device, zest_report_memory, "A readback of %llu bytes can't fit in the %llu byte readback ring. Set a bigger readback_ring_size when creating the context.", size, ring->size);
+		ring->ring_full_count++;
+		return NULL;
+	}
+	if (ring->pending_start == zest_vec_size(ring->pending)) {
+		zest_vec_clear(ring->pending);
+		ring->pending_start = 0;
+		ring->head = 0;
+		ring->tail = 0;
+	}
+	zest_size offset = 0;
+	if (!zest__ring_allocate(ring->size, &ring->head, &ring->tail, size, alignment, &offset)) {
+		ring->ring_full_count++;
+		return NULL;
+	}
+	zest_readback_t readback = ZEST__ZERO_INIT(zest_readback_t);
+	readback.ticket = ring->next_ticket++;
+	readback.ring_offset = offset;
+	readback.size = size;
+	readback.callback = callback;
+	readback.user_data = user_data;
+	zest_vec_push(context->allocator, ring->pending, readback);
+	ring->total_readbacks++;
+	ring->total_bytes += size;
+	return &zest_vec_back(ring->pending);
+}
+
+zest_size zest__image_readback_size(zest_image_info_t *info, zest_image_readback_region_t *region, zest_size *bytes_per_block) {
+	int channels, bytes_per_pixel, block_width, block_height, block_bytes;
+	zest_GetFormatPixelData(info->format, &channels, &bytes_per_pixel, &block_width, &block_height, &block_bytes);
+	ZEST_ASSERT(region->mip_level < ZEST__MAX(1u, info->mip_levels), "The readback mip level is out of range for the image.");
+	zest_uint mip_width = ZEST__MAX(1u, info->extent.width >> region->mip_level);
+	zest_uint mip_height = ZEST__MAX(1u, info->extent.height >> region->mip_level);
+	if (!region->layer_count) region->layer_count = 1;
+	if (!region->width) region->width = mip_width - region->x;
+	if (!region->height) region->height = mip_height - region->y;
+	ZEST_ASSERT(region->base_layer + region->layer_count <= ZEST__MAX(1u, info->layer_count), "The readback layers are out of range for the image.");
+	ZEST_ASSERT(region->x + region->width <= mip_width && region->y + region->height <= mip_height, "The readback region goes outside of the mip level.");
+	zest_size blocks_x = (region->width + block_width - 1) / block_width;
+	zest_size blocks_y = (region->height + block_height - 1) / block_height;
+	*bytes_per_block = block_bytes;
+	return blocks_x * blocks_y * region->layer_count * block_bytes;
+}
+
+void zest__readback_pass_task(const zest_command_list command_list, void *user_data) {
+	zest_readback_pass_t *task = (zest_readback_pass_t*)user_data;
+	zest_context context = command_list->context;
+	zest_resource_node resource = task->resource;
+	zest_readback_copy_t copy = ZEST__ZERO_INIT(zest_readback_copy_t);
+	zest_size alignment = 4;
+	if (resource->type & zest_resource_type_is_image_or_depth) {
+		copy.image = &resource->image;
+		copy.image_layout = resource->journey[resource->current_state_index].usage.image_layout;
+		copy.region = task->region;
+		copy.size = zest__image_readback_size(&resource->image.info, &copy.region, &alignment);
+	} else {
+		//A transient buffer that resolved to 0 bytes this execution has nothing to read back
+		if (!resource->storage_buffer) return;
+		copy.buffer = resource->storage_buffer;
+		copy.buffer_offset = task->buffer_offset;
+		copy.size = task->size ? task->size : copy.buffer->size - task->buffer_offset;
+		ZEST_ASSERT(copy.buffer_offset + copy.size <= copy.buffer->size, "The readback range goes past the end of the buffer.");
+	}
+	//Readback passes can be recorded on worker threads
+	zest_bool locked = zest__lock_recording(context);
+	zest_readback_t *readback = zest__push_readback(context, copy.size, alignment, task->callback, task->user_data);
+	if (readback) {
+		copy.ring_offset = readback->ring_offset;
+	}
+	zest__unlock_recording(context, locked);
+	if (readback) {
+		context->device->platform->cmd_readback(command_list, &copy);
+	}
+}
+
+void zest__stamp_submitted_readbacks(zest_context context, zest_execution_timeline timeline) {
+	zest_readback_ring_t *ring = &context->readbacks;
+	for (zest_uint i = zest_vec_size(ring->pending); i > ring->pending_start; --i) {
+		zest_readback_t *readback = &ring->pending[i - 1];
+		if (readback->timeline) break;
+		readback->timeline = timeline;
+		readback->timeline_value = timeline->current_value;
+	}
+}
+
+void zest__discard_unsubmitted_readbacks(zest_context context) {
+	zest_readback_ring_t *ring = &context->readbacks;
+	//Unsubmitted readbacks are always the newest so popping them hands their ring space straight back
+	while (zest_vec_size(ring->pending) > ring->pending_start && !zest_vec_back(ring->pending).timeline) {
+		zest_readback_t readback = zest_vec_pop(ring->pending);
+		ring->head = readback.ring_offset;
+		ring->next_ticket = readback.ticket;
+		ring->total_readbacks--;
+		ring->total_bytes -= readback.size;
+	}
+}
+
+zest_pass_node zest_AddImageReadbackPass(const char *name, zest_resource_node image, zest_image_readback_region_t *region, zest_readback_callback callback, void *user_data) {
+    ZEST_ASSERT_HANDLE(zest__frame_graph_builder->frame_graph);        //This function must be called within a Begin/EndFrameGraph block
+	zest_context context = zest__frame_graph_builder->context;
+    ZEST_ASSERT_OR_VALIDATE(ZEST_VALID_HANDLE(image, zest_struct_type_resource_node) && (image->type & zest_resource_type_is_image_or_depth),
+							context->device, "zest_AddImageReadbackPass needs a valid image resource node.", NULL);
+	zest_readback_pass_t *task = (zest_readback_pass_t*)zest__linear_allocate(zest__frame_graph_builder->allocator, sizeof(zest_readback_pass_t));
+	*task = ZEST__ZERO_INIT(zest_readback_pass_t);
+	task->resource = image;
+	if (region) {
+		task->region = *region;
+	}
+	task->callback = callback;
+	task->user_data = user_data;
+	zest_pass_node pass = zest_BeginTransferPass(name);
+	zest_ConnectInput(image);
+	zest_SetPassTask(zest__readback_pass_task, task);
+	zest_DoNotCull();
+	zest_EndPass();
+	ZEST__FLAG(zest__frame_graph_builder->frame_graph->flags, zest_frame_graph_has_readbacks);
+	return pass;
+}
+
+zest_pass_node zest_AddBufferReadbackPass(const char *name, zest_resource_node buffer, zest_size offset, zest_size size, zest_readback_callback callback, void *user_data) {
+    ZEST_ASSERT_HANDLE(zest__frame_graph_builder->frame_graph);        //This function must be called within a Begin/EndFrameGraph block
+	zest_context context = zest__frame_graph_builder->context;
+    ZEST_ASSERT_OR_VALIDATE(ZEST_VALID_HANDLE(buffer, zest_struct_type_resource_node) && (buffer->type & zest_resource_type_buffer),
+							context->device, "zest_AddBufferReadbackPass needs a valid buffer resource node.", NULL);
+	zest_readback_pass_t *task = (zest_readback_pass_t*)zest__linear_allocate(zest__frame_graph_builder->allocator, sizeof(zest_readback_pass_t));
+	*task = ZEST__ZERO_INIT(zest_readback_pass_t);
+	task->resource = buffer;
+	task->buffer_offset = offset;
+	task->size = size;
+	task->callback = callback;
+	task->user_data = user_data;
+	zest_pass_node pass = zest_BeginTransferPass(name);
+	zest_ConnectInput(buffer);
+	zest_SetPassTask(zest__readback_pass_task, task);
+	zest_DoNotCull();
+	zest_EndPass();
+	ZEST__FLAG(zest__frame_graph_builder->frame_graph->flags, zest_frame_graph_has_readbacks);
+	return pass;
+}
+
+zest_readback_ticket zest__submit_readback(zest_context context, zest_readback_copy_t *copy, zest_size alignment, zest_readback_callback callback, void *user_data) {
+	ZEST_ASSERT(!zest__frame_graph_builder || !zest__frame_graph_builder->current_pass, "Standalone readbacks can't be made while a frame graph pass is being recorded, use zest_AddImageReadbackPass or zest_AddBufferReadbackPass instead.");
+	if (!zest__prepare_readback_ring(context)) {
+		return 0;
+	}
+	zest_readback_ring_t *ring = &context->readbacks;
+	zest_platform platform = context->device->platform;
+	//Each standalone readback has its own command buffer which can only be reused once the GPU is done with it
+	zest_uint slot = ring->next_submit;
+	if (ring->submit_values[slot] > platform->get_timeline_value(ring->timeline)) {
+		return 0;
+	}
+	zest_readback_t *readback = zest__push_readback(context, copy->size, alignment, callback, user_data);
+	if (!readback) {
+		return 0;
+	}
+	copy->ring_offset = readback->ring_offset;
+	zest_u64 signal_value = ring->timeline->current_value + 1;
+	if (!platform->submit_readback(context, copy, slot, signal_value)) {
+		zest__discard_unsubmitted_readbacks(context);
+		return 0;
+	}
+	ring->timeline->current_value = signal_value;
+	ring->submit_values[slot] = signal_value;
+	ring->next_submit = (slot + 1) % ZEST_READBACK_SUBMITS_IN_FLIGHT;
+	readback->timeline = ring->timeline;
+	readback->timeline_value = signal_value;
+	return readback->ticket;
+}
+
+zest_readback_ticket zest_ReadbackImage(zest_context context, zest_image image, zest_image_readback_region_t *region, zest_readback_callback callback, void *user_data) {
+	ZEST_ASSERT_HANDLE(context);	//Not a valid context handle
+	ZEST_ASSERT_HANDLE(image);		//Not a valid image handle
+	ZEST_ASSERT(ZEST__FLAGGED(image->info.flags, zest_image_flag_transfer_src), "If you want to read back an image then you must flag that image as transfer_src when creating the image.");
+	zest_readback_copy_t copy = ZEST__ZERO_INIT(zest_readback_copy_t);
+	zest_size alignment = 4;
+	copy.image = image;
+	copy.image_layout = image->layout;
+	if (region) {
+		copy.region = *region;
+	}
+	copy.size = zest__image_readback_size(&image->info, &copy.region, &alignment);
+	return zest__submit_readback(context, &copy, alignment, callback, user_data);
+}
+
+zest_readback_ticket zest_ReadbackBuffer(zest_context context, zest_buffer buffer, zest_size offset, zest_size size, zest_readback_callback callback, void *user_data) {
+	ZEST_ASSERT_HANDLE(context);	//Not a valid context handle
+	ZEST_ASSERT(buffer, "Buffer pointer was null");
+	zest_readback_copy_t copy = ZEST__ZERO_INIT(zest_readback_copy_t);
+	copy.buffer = buffer;
+	copy.buffer_offset = offset;
+	copy.size = size ? size : buffer->size - offset;
+	ZEST_ASSERT(offset + copy.size <= buffer->size, "The readback range goes past the end of the buffer.");
+	return zest__submit_readback(context, &copy, 4, callback, user_data);
+}
+
+zest_uint zest_PollReadbacks(zest_context context) {
+	ZEST_ASSERT_HANDLE(context);	//Not a valid context handle
+	zest_readback_ring_t *ring = &context->readbacks;
+	zest_platform platform = context->device->platform;
+	zest_execution_timeline timeline = 0;
+	zest_u64 gpu_value = 0;
+	zest_uint fired = 0;
+	while (ring->pending_start < zest_vec_size(ring->pending)) {
+		//Copy the entry out, callbacks are free to make new readbacks which can grow the pending list
+		zest_readback_t readback = ring->pending[ring->pending_start];
+		//Recorded by a frame graph that hasn't been submitted yet
+		if (!readback.timeline) break;
+		if (readback.timeline != timeline) {
+			timeline = readback.timeline;
+			gpu_value = platform->get_timeline_value(timeline);
+		}
+		if (readback.timeline_value > gpu_value) break;
+		platform->invalidate_buffer(ring->buffer, readback.ring_offset, readback.size);
+		if (readback.callback) {
+			readback.callback((char*)zest_BufferData(ring->buffer) + readback.ring_offset, readback.size, readback.user_data);
+		}
+		//Only give the ring space back once the callback is done reading it
+		ring->tail = readback.ring_offset + readback.size;
+		ring->completed_ticket = readback.ticket;
+		ring->pending_start++;
+		fired++;
+	}
+	return fired;
+}
+
+zest_bool zest_ReadbackIsComplete(zest_context context, zest_readback_ticket ticket) {
+	ZEST_ASSERT_HANDLE(context);	//Not a valid context handle
+	if (!ticket) return ZEST_FALSE;
+	if (ticket > context->readbacks.completed_ticket) {
+		zest_PollReadbacks(context);
+	}
+	return ticket <= context->readbacks.completed_ticket;
+}
+
+zest_semaphore_status zest_FlushReadbacks(zest_context context, zest_microsecs timeout) {
+	ZEST_ASSERT_HANDLE(context);	//Not a valid context handle
+	zest_readback_ring_t *ring = &context->readbacks;
+	zest_semaphore_status status = zest_semaphore_status_success;
+	zest_execution_timeline waited = 0;
+	for (zest_uint i = ring->pending_start; i < zest_vec_size(ring->pending); ++i) {
+		zest_execution_timeline timeline = ring->pending[i].timeline;
+		if (!timeline || timeline == waited) continue;
+		//Waiting on the latest value of each timeline covers every readback that signals it
+		status = context->device->platform->wait_for_timeline(timeline, timeout);
+		if (status != zest_semaphore_status_success) return status;
+		waited = timeline;
+	}
+	zest_PollReadbacks(context);
+	return status;
+}
+
+zest_readback_stats_t zest_GetReadbackStats(zest_context context) {
+	ZEST_ASSERT_HANDLE(context);	//Not a valid context handle
+	zest_readback_ring_t *ring = &context->readbacks;
+	zest_readback_stats_t stats = ZEST__ZERO_INIT(zest_readback_stats_t);
+	for (zest_uint i = ring->pending_start; i < zest_vec_size(ring->pending); ++i) {
+		stats.pending_readbacks++;
+		stats.pending_bytes += ring->pending[i].size;
+	}
+	stats.completed_ticket = ring->completed_ticket;
+	stats.total_readbacks = ring->total_readbacks;
+	stats.total_bytes = ring->total_bytes;
+	stats.ring_full_count = ring->ring_full_count;
+	stats.ring_size = ring->buffer ? ring->size : (context->create_info.readback_ring_size ? context->create_info.readback_ring_size : zloc__MEGABYTE(8));
+	return stats;
+}
+// -- End Readbacks
+
+// -- Virtual_textures
+zest_virtual_texture_info_t zest_CreateVirtualTextureInfo(zest_uint width, zest_uint height) {
+	zest_virtual_texture_info_t info = ZEST__ZERO_INIT(zest_virtual_texture_info_t);
+	info.width = width;
+	info.height = height;
+	info.page_size = 128;
+	info.page_border = 4;
+	info.format = zest_format_r8g8b8a8_unorm;
+	info.cache_pages_x = 16;
+	info.cache_pages_y = 16;
+	info.upload_budget = 16;
+	return info;
+}
+
+zest_virtual_texture zest_CreateVirtualTexture(zest_context context, zest_virtual_texture_info_t *info) {
+	ZEST_ASSERT_HANDLE(context);	//Not a valid context handle
+	ZEST_ASSERT(info && info->load_page, "A virtual texture needs a load_page callback to fill in its pages. Use zest_CreateVirtualTextureInfo to get the defaults.");
+	ZEST_ASSERT(info->page_size > 0 && info->width % info->page_size == 0 && info->height % info->page_size == 0, "The width and height of a virtual texture must be multiples of the page size.");
+	zest_uint pages_x = info->width / info->page_size;
+	zest_uint pages_y = info->height / info->page_size;
+	ZEST_ASSERT(pages_x && !(pages_x & (pages_x - 1)) && pages_y && !(pages_y & (pages_y - 1)), "A virtual texture must be a power of 2 pages across and down so that every mip level is a whole number of pages.");
+	ZEST_ASSERT(info->cache_pages_x > 0 && info->cache_pages_x <= 256 && info->cache_pages_y > 0 && info->cache_pages_y <= 256, "The page cache can be at most 256 pages each way because the page table stores cache positions in 8 bits.");
+	ZEST_ASSERT(info->upload_budget > 0, "The upload budget must be at least 1 page.");
+	int channels, bytes_per_pixel, block_width, block_height, bytes_per_block;
+	zest_GetFormatPixelData(info->format, &channels, &bytes_per_pixel, &block_width, &block_height, &bytes_per_block);
+	ZEST_ASSERT(block_width == 1 && block_height == 1 && bytes_per_block > 0, "Virtual textures don't support block compressed formats.");
+	zest_device device = context->device;
+
+	zest_virtual_texture virtual_texture = ZEST__NEW(context->allocator, zest_virtual_texture);
+	*virtual_texture = ZEST__ZERO_INIT(zest_virtual_texture_t);
+	virtual_texture->magic = zest_INIT_MAGIC(zest_struct_type_virtual_texture);
+	virtual_texture->context = context;
+	virtual_texture->info = *info;
+	virtual_texture->pages_x = pages_x;
+	virtual_texture->pages_y = pages_y;
+	//Stop at the first level that's a single page in either direction, that level stays resident
+	zest_uint mip_count = 1;
+	while (mip_count < ZEST_MAX_VIRTUAL_TEXTURE_MIPS && (pages_x >> mip_count) && (pages_y >> mip_count)) {
+		mip_count++;
+	}
+	virtual_texture->mip_count = mip_count;
+	zest_uint total_pages = 0;
+	for (zest_uint mip = 0; mip != mip_count; ++mip) {
+		virtual_texture->mip_offsets[mip] = total_pages;
+		total_pages += (pages_x >> mip) * (pages_y >> mip);
+	}
+	virtual_texture->mip_offsets[mip_count] = total_pages;
+	virtual_texture->total_pages = total_pages;
+	zest_uint cache_slots = info->cache_pages_x * info->cache_pages_y;
+	zest_uint pinned_pages = total_pages - virtual_texture->mip_offsets[mip_count - 1];
+	ZEST_ASSERT(pinned_pages < cache_slots, "The page cache needs room for more than the coarsest mip level of the virtual texture which always stays resident.");
+
+	//Page offsets in the staging buffer have to be a multiple of 4 and of the texel size
+	virtual_texture->slot_size = info->page_size + info->page_border * 2;
+	virtual_texture->page_bytes = (zest_size)virtual_texture->slot_size * virtual_texture->slot_size * bytes_per_block;
+	zest_size stride = (virtual_texture->page_bytes + 15) & ~(zest_size)15;
+	while (stride % bytes_per_block) stride += 16;
+	virtual_texture->page_stride = stride;
+	virtual_texture->page_table_offset = stride * info->upload_budget;
+	zest_size frame_size = virtual_texture->page_table_offset + total_pages * sizeof(zest_uint);
+	frame_size = (frame_size + 15) & ~(zest_size)15;
+	while (frame_size % bytes_per_block) frame_size += 16;
+	virtual_texture->frame_staging_size = frame_size;
+
+	zest_vec_resize(context->allocator, virtual_texture->page_slots, total_pages);
+	zest_vec_resize(context->allocator, virtual_texture->page_table_texels, total_pages);
+	zest_vec_resize(context->allocator, virtual_texture->needed, total_pages);
+	zest_vec_resize(context->allocator, virtual_texture->slots, cache_slots);
+	memset(virtual_texture->page_slots, 0xFF, total_pages * sizeof(zest_uint));
+	memset(virtual_texture->page_table_texels, 0, total_pages * sizeof(zest_uint));
+	memset(virtual_texture->needed, 0, total_pages);
+	for (zest_uint slot = cache_slots; slot-- > 0;) {
+		zest_virtual_page_slot_t *page_slot = &virtual_texture->slots[slot];
+		*page_slot = ZEST__ZERO_INIT(zest_virtual_page_slot_t);
+		page_slot->page = ZEST_INVALID;
+		page_slot->prev = ZEST_INVALID;
+		page_slot->next = ZEST_INVALID;
+		//Pop from the back so that the cache fills from slot 0
+		zest_vec_push(context->allocator, virtual_texture->free_slots, slot);
+	}
+	virtual_texture->lru_head = ZEST_INVALID;
+	virtual_texture->lru_tail = ZEST_INVALID;
+	virtual_texture->shader_info.feedback_index = ZEST_INVALID;
+	//The coarsest level is loaded before anything else so that there's always something to fall back on
+	for (zest_uint page = virtual_texture->mip_offsets[mip_count - 1]; page != total_pages; ++page) {
+		zest_vec_push(context->allocator, virtual_texture->requests, page);
+	}
+	virtual_texture->page_table_dirty = ZEST_TRUE;
+
+	zest_image_info_t table_info = zest_CreateImageInfo(pages_x, pages_y);
+	table_info.mip_levels = mip_count;
+	table_info.format = zest_format_r8g8b8a8_unorm;
+	table_info.flags = zest_image_preset_texture | zest_image_flag_transfer_src;
+	virtual_texture->page_table = zest_CreateImage(device, &table_info);
+	zest_image_info_t cache_info = zest_CreateImageInfo(info->cache_pages_x * virtual_texture->slot_size, info->cache_pages_y * virtual_texture->slot_size);
+	cache_info.format = info->format;
+	cache_info.flags = zest_image_preset_texture | zest_image_flag_transfer_src;
+	virtual_texture->page_cache = zest_CreateImage(device, &cache_info);
+	zest_buffer_info_t feedback_info = zest_CreateBufferInfo(zest_buffer_type_storage, zest_memory_usage_gpu_only);
+	virtual_texture->feedback = zest_CreateBuffer(device, total_pages * sizeof(zest_uint), &feedback_info);
+	virtual_texture->staging = zest_CreateDedicatedStagingBuffer(device, frame_size * ZEST_MAX_FIF, 0);
+	if (!virtual_texture->page_table.value || !virtual_texture->page_cache.value || !virtual_texture->feedback || !virtual_texture->staging) {
+		ZEST_REPORT(device, zest_report_memory, "Unable to create a virtual texture with a %u x %u page cache.", info->cache_pages_x, info->cache_pages_y);
+		zest__free_virtual_texture(virtual_texture);
+		return NULL;
+	}
+
+	zest_virtual_texture_shader_info_t *shader_info = &virtual_texture->shader_info;
+	shader_info->page_table_index = zest_AcquireSampledImageIndex(device, zest_GetImage(virtual_texture->page_table), zest_texture_2d_binding);
+	shader_info->page_cache_index = zest_AcquireSampledImageIndex(device, zest_GetImage(virtual_texture->page_cache), zest_texture_2d_binding);
+	shader_info->feedback_index = zest_AcquireStorageBufferIndex(device, virtual_texture->feedback);
+	shader_info->page_size = info->page_size;
+	shader_info->page_border = info->page_border;
+	shader_info->pages_x = pages_x;
+	shader_info->pages_y = pages_y;
+	shader_info->mip_count = mip_count;
+	shader_info->cache_texel_width = 1.f / (float)cache_info.extent.width;
+	shader_info->cache_texel_height = 1.f / (float)cache_info.extent.height;
+	return virtual_texture;
+}
+
+void zest__free_virtual_texture(zest_virtual_texture virtual_texture) {
+	zest_context context = virtual_texture->context;
+	zest_device device = context->device;
+	//Feedback that's still on its way back would call in to the freed virtual texture
+	zest_readback_ring_t *ring = &context->readbacks;
+	for (zest_uint i = ring->pending_start; i < zest_vec_size(ring->pending); ++i) {
+		if (ring->pending[i].callback == zest__virtual_texture_feedback && ring->pending[i].user_data == virtual_texture) {
+			ring->pending[i].callback = 0;
+		}
+	}
+	if (virtual_texture->page_table.value) {
+		zest_ReleaseAllImageIndexes(device, zest_GetImage(virtual_texture->page_table));
+		zest_FreeImage(virtual_texture->page_table);
+	}
+	if (virtual_texture->page_cache.value) {
+		zest_ReleaseAllImageIndexes(device, zest_GetImage(virtual_texture->page_cache));
+		zest_FreeImage(virtual_texture->page_cache);
+	}
+	if (virtual_texture->feedback) {
+		if (virtual_texture->shader_info.feedback_index != ZEST_INVALID) {
+			zest_ReleaseStorageBufferIndex(device, virtual_texture->shader_info.feedback_index);
+		}
+		zest_FreeBuffer(virtual_texture->feedback);
+	}
+	if (virtual_texture->staging) {
+		zest_FreeBuffer(virtual_texture->staging);
+	}
+	zest_vec_free(context->allocator, virtual_texture->page_slots);
+	zest_vec_free(context->allocator, virtual_texture->page_table_texels);
+	zest_vec_free(context->allocator, virtual_texture->needed);
+	zest_vec_free(context->allocator, virtual_texture->slots);
+	zest_vec_free(context->allocator, virtual_texture->free_slots);
+	zest_vec_free(context->allocator, virtual_texture->requests);
+	for (zest_uint fif = 0; fif != ZEST_MAX_FIF; ++fif) {
+		zest_vec_free(context->allocator, virtual_texture->uploads[fif]);
+	}
+	ZEST__FREE(context->allocator, virtual_texture);
+}
+
+void zest_FreeVirtualTexture(zest_virtual_texture virtual_texture) {
+	ZEST_ASSERT_HANDLE(virtual_texture);	//Not a valid virtual texture handle
+	zest__free_virtual_texture(virtual_texture);
+}
+
+void zest__virtual_page_coords(zest_virtual_texture virtual_texture, zest_uint page, zest_uint *mip_level, zest_uint *page_x, zest_uint *page_y) {
+	zest_uint mip = 0;
+	while (page >= virtual_texture->mip_offsets[mip + 1]) mip++;
+	zest_uint pages_x = virtual_texture->pages_x >> mip;
+	zest_uint index = page - virtual_texture->mip_offsets[mip];
+	*mip_level = mip;
+	*page_x = index % pages_x;
+	*page_y = index / pages_x;
+}
+
+void zest__unlink_virtual_page_slot(zest_virtual_texture virtual_texture, zest_uint slot) {
+	zest_virtual_page_slot_t *page_slot = &virtual_texture->slots[slot];
+	if (page_slot->prev != ZEST_INVALID) virtual_texture->slots[page_slot->prev].next = page_slot->next;
+	else virtual_texture->lru_head = page_slot->next;
+	if (page_slot->next != ZEST_INVALID) virtual_texture->slots[page_slot->next].prev = page_slot->prev;
+	else virtual_texture->lru_tail = page_slot->prev;
+	page_slot->prev = ZEST_INVALID;
+	page_slot->next = ZEST_INVALID;
+}
+
+void zest__touch_virtual_page_slot(zest_virtual_texture virtual_texture, zest_uint slot) {
+	zest_virtual_page_slot_t *page_slot = &virtual_texture->slots[slot];
+	page_slot->last_used = virtual_texture->feedback_serial;
+	if (page_slot->pinned) return;
+	//Move to the most recently used end of the list
+	if (virtual_texture->lru_tail == slot) return;
+	if (page_slot->prev != ZEST_INVALID || virtual_texture->lru_head == slot) {
+		zest__unlink_virtual_page_slot(virtual_texture, slot);
+	}
+	page_slot->prev = virtual_texture->lru_tail;
+	if (virtual_texture->lru_tail != ZEST_INVALID) virtual_texture->slots[virtual_texture->lru_tail].next = slot;
+	else virtual_texture->lru_head = slot;
+	virtual_texture->lru_tail = slot;
+}
+
+zest_uint zest__acquire_virtual_page_slot(zest_virtual_texture virtual_texture) {
+	if (zest_vec_size(virtual_texture->free_slots)) {
+		return zest_vec_pop(virtual_texture->free_slots);
+	}
+	zest_uint slot = virtual_texture->lru_head;
+	//Evicting a page that the latest feedback asked for would only see it requested again straight away
+	if (slot == ZEST_INVALID || virtual_texture->slots[slot].last_used == virtual_texture->feedback_serial) {
+		return ZEST_INVALID;
+	}
+	zest__unlink_virtual_page_slot(virtual_texture, slot);
+	zest_virtual_page_slot_t *page_slot = &virtual_texture->slots[slot];
+	virtual_texture->page_slots[page_slot->page] = ZEST_INVALID;
+	page_slot->page = ZEST_INVALID;
+	virtual_texture->resident_pages--;
+	virtual_texture->total_evictions++;
+	virtual_texture->page_table_dirty = ZEST_TRUE;
+	return slot;
+}
+
+void zest__rebuild_virtual_page_table(zest_virtual_texture virtual_texture) {
+	//Texels are rgba8: cache page x, cache page y, the mip level of the page that was found and 255 once any
+	//page covers the texel. Missing pages take the entry of the page above them.
+	zest_uint cache_pages_x = virtual_texture->info.cache_pages_x;
+	zest_uint *texels = virtual_texture->page_table_texels;
+	for (zest_uint mip = virtual_texture->mip_count; mip-- > 0;) {
+		zest_uint pages_x = virtual_texture->pages_x >> mip;
+		zest_uint pages_y = virtual_texture->pages_y >> mip;
+		zest_uint offset = virtual_texture->mip_offsets[mip];
+		for (zest_uint y = 0; y != pages_y; ++y) {
+			for (zest_uint x = 0; x != pages_x; ++x) {
+				zest_uint page = offset + y * pages_x + x;
+				zest_uint slot = virtual_texture->page_slots[page];
+				if (slot != ZEST_INVALID) {
+					texels[page] = (slot % cache_pages_x) | ((slot / cache_pages_x) << 8) | (mip << 16) | 0xFF000000u;
+				} else if (mip + 1 < virtual_texture->mip_count) {
+					texels[page] = texels[virtual_texture->mip_offsets[mip + 1] + (y >> 1) * (pages_x >> 1) + (x >> 1)];
+				} else {
+					texels[page] = 0;
+				}
+			}
+		}
+	}
+}
+
+void zest__virtual_texture_feedback(const void *data, zest_size size, void *user_data) {
+	zest_virtual_texture virtual_texture = (zest_virtual_texture)user_data;
+	const zest_uint *feedback = (const zest_uint*)data;
+	zest_uint count = (zest_uint)ZEST__MIN((zest_size)virtual_texture->total_pages, size / sizeof(zest_uint));
+	zest_byte *needed = virtual_texture->needed;
+	virtual_texture->feedback_serial++;
+	memset(needed, 0, virtual_texture->total_pages);
+	//Mark each page asked for along with the pages above it up to the first one that's resident so that there's
+	//always a coarser page to fall back on
+	for (zest_uint page = 0; page != count; ++page) {
+		if (!feedback[page] || needed[page]) continue;
+		zest_uint mip, x, y;
+		zest__virtual_page_coords(virtual_texture, page, &mip, &x, &y);
+		zest_uint index = page;
+		while (!needed[index]) {
+			needed[index] = 1;
+			if (virtual_texture->page_slots[index] != ZEST_INVALID || mip + 1 == virtual_texture->mip_count) break;
+			mip++;
+			x >>= 1;
+			y >>= 1;
+			index = virtual_texture->mip_offsets[mip] + y * (virtual_texture->pages_x >> mip) + x;
+		}
+	}
+	//Replace the requests with the latest ones, coarsest first
+	zest_vec_clear(virtual_texture->requests);
+	virtual_texture->request_start = 0;
+	virtual_texture->visible_pages = 0;
+	for (zest_uint page = virtual_texture->total_pages; page-- > 0;) {
+		if (!needed[page]) continue;
+		virtual_texture->visible_pages++;
+		zest_uint slot = virtual_texture->page_slots[page];
+		if (slot != ZEST_INVALID) {
+			zest__touch_virtual_page_slot(virtual_texture, slot);
+		} else {
+			zest_vec_push(virtual_texture->context->allocator, virtual_texture->requests, page);
+		}
+	}
+}
+
+zest_uint zest_UpdateVirtualTexture(zest_virtual_texture virtual_texture) {
+	ZEST_ASSERT_HANDLE(virtual_texture);	//Not a valid virtual texture handle
+	zest_context context = virtual_texture->context;
+	zest_uint fif = context->current_fif;
+	char *staging = (char*)zest_BufferData(virtual_texture->staging) + fif * virtual_texture->frame_staging_size;
+	//Pages staged by an earlier update that no upload pass has copied yet stay queued, new pages go after them
+	zest_uint pending = zest_vec_size(virtual_texture->uploads[fif]);
+	zest_uint loaded = 0;
+	while (virtual_texture->request_start < zest_vec_size(virtual_texture->requests) && pending + loaded < virtual_texture->info.upload_budget) {
+		zest_uint page = virtual_texture->requests[virtual_texture->request_start];
+		if (virtual_texture->page_slots[page] != ZEST_INVALID) {
+			virtual_texture->request_start++;
+			continue;
+		}
+		zest_uint slot = zest__acquire_virtual_page_slot(virtual_texture);
+		if (slot == ZEST_INVALID) {
+			//Everything in the cache is on screen, leave the rest of the requests for when that changes
+			virtual_texture->cache_full_count++;
+			break;
+		}
+		virtual_texture->request_start++;
+		zest_uint mip, x, y;
+		zest__virtual_page_coords(virtual_texture, page, &mip, &x, &y);
+		zest_size staging_offset = (zest_size)(pending + loaded) * virtual_texture->page_stride;
+		if (!virtual_texture->info.load_page(virtual_texture, mip, x, y, staging + staging_offset, virtual_texture->page_bytes, virtual_texture->info.user_data)) {
+			zest_vec_push(context->allocator, virtual_texture->free_slots, slot);
+			continue;
+		}
+		zest_virtual_page_slot_t *page_slot = &virtual_texture->slots[slot];
+		page_slot->page = page;
+		page_slot->pinned = mip + 1 == virtual_texture->mip_count;
+		zest__touch_virtual_page_slot(virtual_texture, slot);
+		virtual_texture->page_slots[page] = slot;
+		zest_virtual_page_upload_t upload = { slot, staging_offset };
+		zest_vec_push(context->allocator, virtual_texture->uploads[fif], upload);
+		virtual_texture->resident_pages++;
+		virtual_texture->total_loads++;
+		virtual_texture->page_table_dirty = ZEST_TRUE;
+		loaded++;
+	}
+	if (virtual_texture->page_table_dirty) {
+		zest__rebuild_virtual_page_table(virtual_texture);
+		memcpy(staging + virtual_texture->page_table_offset, virtual_texture->page_table_texels, virtual_texture->total_pages * sizeof(zest_uint));
+		virtual_texture->upload_page_table[fif] = ZEST_TRUE;
+		virtual_texture->page_table_dirty = ZEST_FALSE;
+	}
+	virtual_texture->last_update_loads = loaded;
+	return loaded;
+}
+
+zest_virtual_texture_resources_t zest_ImportVirtualTexture(zest_virtual_texture virtual_texture) {
+	ZEST_ASSERT_HANDLE(virtual_texture);	//Not a valid virtual texture handle
+    ZEST_ASSERT_HANDLE(zest__frame_graph_builder->frame_graph);        //This function must be called within a Begin/EndFrameGraph block
+	zest_virtual_texture_resources_t resources = ZEST__ZERO_INIT(zest_virtual_texture_resources_t);
+	resources.page_table = zest_ImportImageResource("Virtual Page Table", zest_GetImage(virtual_texture->page_table), 0);
+	resources.page_cache = zest_ImportImageResource("Virtual Page Cache", zest_GetImage(virtual_texture->page_cache), 0);
+	resources.feedback = zest_ImportBufferResource("Virtual Texture Feedback", virtual_texture->feedback, 0);
+	return resources;
+}
+
+void zest__virtual_texture_upload_task(const zest_command_list command_list, void *user_data) {
+	zest_virtual_texture_pass_t *task = (zest_virtual_texture_pass_t*)user_data;
+	zest_virtual_texture virtual_texture = task->virtual_texture;
+	zest_uint fif = command_list->context->current_fif;
+	command_list->context->device->platform->cmd_update_virtual_texture(command_list, virtual_texture, &task->resources, fif);
+	//Only upload once, a frame without a zest_UpdateVirtualTexture has nothing new to copy
+	zest_vec_clear(virtual_texture->uploads[fif]);
+	virtual_texture->upload_page_table[fif] = ZEST_FALSE;
+}
+
+void zest__virtual_texture_feedback_task(const zest_command_list command_list, void *user_data) {
+	zest_virtual_texture_pass_t *task = (zest_virtual_texture_pass_t*)user_data;
+	//The frame graph only knows about the transfer writes of the clear, not the shader writes after it
+	command_list->context->device->platform->cmd_shader_write_barrier(command_list, task->virtual_texture->feedback);
+	zest__readback_pass_task(command_list, &task->readback);
+}
+
+zest_pass_node zest_AddVirtualTextureUploadPass(zest_virtual_texture virtual_texture, zest_virtual_texture_resources_t *resources) {
+	ZEST_ASSERT_HANDLE(virtual_texture);	//Not a valid virtual texture handle
+    ZEST_ASSERT_HANDLE(zest__frame_graph_builder->frame_graph);        //This function must be called within a Begin/EndFrameGraph block
+	zest_context context = zest__frame_graph_builder->context;
+    ZEST_ASSERT_OR_VALIDATE(resources && resources->page_table && resources->page_cache && resources->feedback,
+							context->device, "zest_AddVirtualTextureUploadPass needs the resources from zest_ImportVirtualTexture.", NULL);
+	zest_virtual_texture_pass_t *task = (zest_virtual_texture_pass_t*)zest__linear_allocate(zest__frame_graph_builder->allocator, sizeof(zest_virtual_texture_pass_t));
+	*task = ZEST__ZERO_INIT(zest_virtual_texture_pass_t);
+	task->virtual_texture = virtual_texture;
+	task->resources = *resources;
+	zest_pass_node pass = zest_BeginTransferPass("Virtual Texture Upload");
+	//Both images are copy destinations, the graph transitions them and keeps the pages already in them
+	zest_ConnectOutput(resources->page_table);
+	zest_ConnectOutput(resources->page_cache);
+	zest_ConnectOutput(resources->feedback);
+	zest_SetPassTask(zest__virtual_texture_upload_task, task);
+	zest_DoNotCull();
+	zest_EndPass();
+	return pass;
+}
+
+zest_pass_node zest_AddVirtualTextureFeedbackPass(zest_virtual_texture virtual_texture, zest_virtual_texture_resources_t *resources) {
+	ZEST_ASSERT_HANDLE(virtual_texture);	//Not a valid virtual texture handle
+    ZEST_ASSERT_HANDLE(zest__frame_graph_builder->frame_graph);        //This function must be called within a Begin/EndFrameGraph block
+	zest_context context = zest__frame_graph_builder->context;
+    ZEST_ASSERT_OR_VALIDATE(resources && resources->feedback,
+							context->device, "zest_AddVirtualTextureFeedbackPass needs the resources from zest_ImportVirtualTexture.", NULL);
+	zest_virtual_texture_pass_t *task = (zest_virtual_texture_pass_t*)zest__linear_allocate(zest__frame_graph_builder->allocator, sizeof(zest_virtual_texture_pass_t));
+	*task = ZEST__ZERO_INIT(zest_virtual_texture_pass_t);
+	task->virtual_texture = virtual_texture;
+	task->resources = *resources;
+	task->readback.resource = resources->feedback;
+	task->readback.size = virtual_texture->total_pages * sizeof(zest_uint);
+	task->readback.callback = zest__virtual_texture_feedback;
+	task->readback.user_data = virtual_texture;
+	zest_pass_node pass = zest_BeginTransferPass("Virtual Texture Feedback");
+	zest_ConnectInput(resources->feedback);
+	zest_SetPassTask(zest__virtual_texture_feedback_task, task);
+	zest_DoNotCull();
+	zest_EndPass();
+	ZEST__FLAG(zest__frame_graph_builder->frame_graph->flags, zest_frame_graph_has_readbacks);
+	return pass;
+}
+
+zest_virtual_texture_shader_info_t zest_GetVirtualTextureShaderInfo(zest_virtual_texture virtual_texture) {
+	ZEST_ASSERT_HANDLE(virtual_texture);	//Not a valid virtual texture handle
+	return virtual_texture->shader_info;
+}
+
+zest_image_handle zest_GetVirtualTexturePageTable(zest_virtual_texture virtual_texture) {
+	ZEST_ASSERT_HANDLE(virtual_texture);	//Not a valid virtual texture handle
+	return virtual_texture->page_table;
+}
+
+zest_image_handle zest_GetVirtualTexturePageCache(zest_virtual_texture virtual_texture) {
+	ZEST_ASSERT_HANDLE(virtual_texture);	//Not a valid virtual texture handle
+	return virtual_texture->page_cache;
+}
+
+zest_buffer zest_GetVirtualTextureFeedbackBuffer(zest_virtual_texture virtual_texture) {
+	ZEST_ASSERT_HANDLE(virtual_texture);	//Not a valid virtual texture handle
+	return virtual_texture->feedback;
+}
+
+zest_bool zest_VirtualPageIsResident(zest_virtual_texture virtual_texture, zest_uint mip_level, zest_uint page_x, zest_uint page_y) {
+	ZEST_ASSERT_HANDLE(virtual_texture);	//Not a valid virtual texture handle
+	if (mip_level >= virtual_texture->mip_count) return ZEST_FALSE;
+	zest_uint pages_x = virtual_texture->pages_x >> mip_level;
+	zest_uint pages_y = virtual_texture->pages_y >> mip_level;
+	if (page_x >= pages_x || page_y >= pages_y) return ZEST_FALSE;
+	return virtual_texture->page_slots[virtual_texture->mip_offsets[mip_level] + page_y * pages_x + page_x] != ZEST_INVALID;
+}
+
+zest_virtual_texture_stats_t zest_GetVirtualTextureStats(zest_virtual_texture virtual_texture) {
+	ZEST_ASSERT_HANDLE(virtual_texture);	//Not a valid virtual texture handle
+	zest_virtual_texture_stats_t stats = ZEST__ZERO_INIT(zest_virtual_texture_stats_t);
+	int channels, bytes_per_pixel, block_width, block_height, bytes_per_block;
+	zest_GetFormatPixelData(virtual_texture->info.format, &channels, &bytes_per_pixel, &block_width, &block_height, &bytes_per_block);
+	zest_size page_texels = (zest_size)virtual_texture->info.page_size * virtual_texture->info.page_size;
+	stats.resident_pages = virtual_texture->resident_pages;
+	stats.cache_pages = zest_vec_size(virtual_texture->slots);
+	stats.visible_pages = virtual_texture->visible_pages;
+	for (zest_uint i = virtual_texture->request_start; i < zest_vec_size(virtual_texture->requests); ++i) {
+		if (virtual_texture->page_slots[virtual_texture->requests[i]] == ZEST_INVALID) stats.requested_pages++;
+	}
+	stats.last_update_loads = virtual_texture->last_update_loads;
+	stats.total_loads = virtual_texture->total_loads;
+	stats.total_evictions = virtual_texture->total_evictions;
+	stats.feedback_count = virtual_texture->feedback_serial;
+	stats.cache_full_count = virtual_texture->cache_full_count;
+	stats.cache_bytes = (zest_size)stats.cache_pages * virtual_texture->slot_size * virtual_texture->slot_size * bytes_per_block;
+	stats.virtual_bytes = (zest_size)virtual_texture->total_pages * page_texels * bytes_per_block;
+	return stats;
+}
+// -- End Virtual_textures
+
+zest_image zest_GetImage(zest_image_handle handle) {
+	zest_image image = (zest_image)zest__get_store_resource_checked(handle.store, handle.value);
+	return image;
+}
+
+void zest_FreeImage(zest_image_handle handle) {
+	if (!handle.value) return;
+    zest_image image = (zest_image)zest__get_store_resource_checked(handle.store, handle.value);
+	ZEST_ASSERT(image, "The image that you're trying to free is stale. Make sure that it wasn't already freed at some point.");
+	zest_device device = (zest_device)handle.store->origin;
+	zest_uint index = device->frame_counter % ZEST_MAX_FIF;
+    zest_vec_push(device->allocator, device->deferred_resource_freeing_list.resources[index], image);
+}
+
+void zest_FreeImageNow(zest_image_handle handle) {
+	if (!handle.value) return;
+    zest_image image = (zest_image)zest__get_store_resource_checked(handle.store, handle.value);
+	zest_device device = (zest_device)handle.store->origin;
+	zest__free_handle(device->allocator, image);
+}
+
+void zest_FreeImageView(zest_image_view_handle handle) {
+	if (!handle.value) return;
+    zest_image_view view = *(zest_image_view*)zest__get_store_resource_checked(handle.store, handle.value);
+	zest_device device = (zest_device)handle.store->origin;
+	zest_uint index = device->frame_counter % ZEST_MAX_FIF;
+    zest_vec_push(device->allocator, device->deferred_resource_freeing_list.resources[index], view);
+}
+
+void zest_FreeImageViewNow(zest_image_view_handle handle) {
+	if (!handle.value) return;
+    zest_image_view view = *(zest_image_view*)zest__get_store_resource_checked(handle.store, handle.value);
+	zest_device device = (zest_device)handle.store->origin;
+	zest__free_handle(device->allocator, view);
+}
+
+void zest_FreeImageViewArray(zest_image_view_array_handle handle) {
+	if (!handle.value) return;
+    zest_image_view_array view = *(zest_image_view_array*)zest__get_store_resource_checked(handle.store, handle.value);
+	zest_device device = (zest_device)handle.store->origin;
 	zest_uint index = device->frame_counter % ZEST_MAX_FIF;
     zest_vec_push(device->allocator, device->deferred_resource_freeing_list.resources[index], view);
 }
@@ -19516,6 +24306,13 @@ void zest_UploadInstanceLayerData(const zest_command_list command_list, void *us
 
     if (ZEST_VALID_HANDLE(layer, zest_struct_type_layer)) {  //You must pass in the zest_layer in the user data
 
+		if (ZEST__FLAGGED(layer->flags, zest_layer_flag_device_local_direct)) {
+			//Instances are written straight in to the device buffer
+			layer->dirty[layer->fif] = 0;
+			layer->last_upload_size = 0;
+			return;
+		}
+
         if (!layer->dirty[layer->fif]) {
             return;
         }
@@ -19526,10 +24323,17 @@ void zest_UploadInstanceLayerData(const zest_command_list command_list, void *us
         zest_buffer_uploader_t instance_upload = { 0, staging_buffer, device_buffer, 0 };
 
         layer->dirty[layer->fif] = 0;
+		layer->last_upload_size = 0;
 
 		zest_size memory_in_use = layer->memory_refs[layer->fif].vertex_memory_in_use;
         if (memory_in_use && device_buffer) {
-            zest_AddCopyCommand(command_list->context, &instance_upload, staging_buffer, device_buffer, memory_in_use);
+			if (ZEST__FLAGGED(layer->flags, zest_layer_flag_delta_upload)) {
+				layer->last_upload_size = zest__add_dirty_layer_copies(command_list->context, layer, &instance_upload, staging_buffer, device_buffer, memory_in_use);
+				if (!layer->last_upload_size) return;
+			} else {
+				zest_AddCopyCommand(command_list->context, &instance_upload, staging_buffer, device_buffer, memory_in_use);
+				layer->last_upload_size = memory_in_use;
+			}
         } else {
             return;
         }
@@ -19572,16 +24376,27 @@ zest_uint zest_GetInstanceLayerCount(zest_layer layer) {
 
 zest_bool zest__grow_instance_buffer(zest_layer layer, zest_size type_size, zest_size minimum_size) {
     zest_bool grown = 0;
+	if (ZEST__FLAGGED(layer->flags, zest_layer_flag_device_local_direct)) {
+		zest_size size = layer->memory_refs[layer->fif].staging_instance_data->size;
+		if (minimum_size && size > minimum_size) {
+			return ZEST_FALSE;
+		}
+		zest_size units = size / type_size;
+		zest_size new_size = ZEST__MAX((units ? units + units / 2 : 8) * type_size, minimum_size);
+		if (zest__grow_direct_instance_buffer(layer, layer->fif, new_size)) {
+			return ZEST_TRUE;
+		}
+		//Out of host visible device memory so carry on as a normal frame in flight layer
+		zest__demote_direct_instance_layer(layer);
+	}
     if (ZEST__FLAGGED(layer->flags, zest_layer_flag_manual_fif)) {
 		grown = zest_GrowBuffer(&layer->memory_refs[layer->fif].staging_instance_data, type_size, minimum_size);
-        zest_GrowBuffer(&layer->memory_refs[layer->fif].device_vertex_data, type_size, layer->memory_refs[layer->fif].staging_instance_data->size);
+        if (zest_GrowBuffer(&layer->memory_refs[layer->fif].device_vertex_data, type_size, layer->memory_refs[layer->fif].staging_instance_data->size)) {
+			//The contents of a device buffer don't move with it
+			layer->memory_refs[layer->fif].all_pages_dirty = ZEST_TRUE;
+		}
 		layer->memory_refs[layer->fif].staging_instance_data = layer->memory_refs[layer->fif].staging_instance_data;
-		zest_uint array_index = layer->memory_refs[layer->fif].descriptor_array_index;
-        if (ZEST__FLAGGED(layer->flags, zest_layer_flag_using_global_bindless_layout) && array_index != ZEST_INVALID) {
-            zest_buffer instance_buffer = layer->memory_refs[layer->fif].device_vertex_data;
-			zest_context context = (zest_context)layer->handle.store->origin;
-			context->device->platform->update_bindless_storage_buffer_descriptor(layer->context->device, zest_storage_buffer_binding, array_index, instance_buffer, layer->bindless_set);
-        }
+		zest__update_layer_buffer_descriptor(layer, layer->fif);
     } else {
 		grown = zest_GrowBuffer(&layer->memory_refs[layer->fif].staging_instance_data, type_size, minimum_size);
 		layer->memory_refs[layer->fif].staging_instance_data = layer->memory_refs[layer->fif].staging_instance_data;
@@ -19589,17 +24404,234 @@ zest_bool zest__grow_instance_buffer(zest_layer layer, zest_size type_size, zest
     return grown;
 }
 
+//Host visible buffers keep their contents when they're reallocated so growing a direct layer's buffer only
+//needs the descriptor updating.
+zest_bool zest__grow_direct_instance_buffer(zest_layer layer, zest_uint fif, zest_size new_size) {
+	zest_device device = layer->context->device;
+	zest_layer_buffers_t *buffers = &layer->memory_refs[fif];
+	zest_size old_size = buffers->staging_instance_data->size;
+	if (new_size <= old_size) {
+		return ZEST_TRUE;
+	}
+	if (!zest__reserve_direct_layer_memory(device, new_size - old_size)) {
+		return ZEST_FALSE;
+	}
+	zest_size offset = (zest_byte*)buffers->instance_ptr - (zest_byte*)zest_BufferData(buffers->staging_instance_data);
+	if (!zest_ResizeBuffer(&buffers->staging_instance_data, new_size)) {
+		device->direct_layer_memory -= new_size - old_size;
+		return ZEST_FALSE;
+	}
+	layer->direct_memory_size += new_size - old_size;
+	buffers->device_vertex_data = buffers->staging_instance_data;
+	buffers->instance_ptr = (zest_byte*)zest_BufferData(buffers->staging_instance_data) + offset;
+	zest__update_layer_buffer_descriptor(layer, fif);
+	return ZEST_TRUE;
+}
+
+//A direct layer that can't get the host visible device memory it needs goes back to writing in to staging
+//buffers and uploading them. The instances written so far are copied across and get a full upload.
+void zest__demote_direct_instance_layer(zest_layer layer) {
+	zest_device device = layer->context->device;
+	zest_buffer_info_t staging_buffer_info = zest_CreateBufferInfo(zest_buffer_type_staging, zest_memory_usage_cpu_to_gpu);
+	zest_ForEachFrameInFlight(fif) {
+		zest_layer_buffers_t *buffers = &layer->memory_refs[fif];
+		zest_buffer direct_buffer = buffers->device_vertex_data;
+		zest_size offset = (zest_byte*)buffers->instance_ptr - (zest_byte*)zest_BufferData(direct_buffer);
+		buffers->staging_instance_data = zest_CreateBuffer(device, direct_buffer->size, &staging_buffer_info);
+		memcpy(zest_BufferData(buffers->staging_instance_data), zest_BufferData(direct_buffer), buffers->instance_count * layer->instance_struct_size);
+		buffers->instance_ptr = (zest_byte*)zest_BufferData(buffers->staging_instance_data) + offset;
+		buffers->all_pages_dirty = ZEST_TRUE;
+		layer->dirty[fif] = 1;
+		zest_FreeBuffer(direct_buffer);
+	}
+	device->direct_layer_memory -= layer->direct_memory_size;
+	layer->direct_memory_size = 0;
+	ZEST__UNFLAG(layer->flags, zest_layer_flag_device_local_direct);
+	zest__create_fif_instance_device_buffers(layer);
+	zest_ForEachFrameInFlight(fif) {
+		zest__update_layer_buffer_descriptor(layer, fif);
+	}
+	ZEST_REPORT(device, zest_report_memory, "Direct layer [%s] ran out of host visible device memory so it's using staging buffers and uploads from now on. Use zest_InstanceLayerNeedsUpload to add the upload pass to the frame graph.", layer->name);
+}
+
+void zest__update_layer_buffer_descriptor(zest_layer layer, zest_uint fif) {
+	zest_uint array_index = layer->memory_refs[fif].descriptor_array_index;
+	if (ZEST__FLAGGED(layer->flags, zest_layer_flag_using_global_bindless_layout) && array_index != ZEST_INVALID) {
+		zest_buffer instance_buffer = layer->memory_refs[fif].device_vertex_data;
+		zest_context context = (zest_context)layer->handle.store->origin;
+		context->device->platform->update_bindless_storage_buffer_descriptor(layer->context->device, zest_storage_buffer_binding, array_index, instance_buffer, layer->bindless_set);
+	}
+}
+
+//Marks the pages covering a byte range of the instance data as changed in every frame in flight, as each
+//device buffer needs the change when it's next uploaded.
+void zest__mark_layer_pages_dirty(zest_layer layer, zest_size offset, zest_size size) {
+	if (!size) return;
+	zest_context context = layer->context;
+	zest_size first_page = offset / layer->delta_page_size;
+	zest_size last_page = (offset + size - 1) / layer->delta_page_size;
+	zest_uint word_count = (zest_uint)(last_page >> 5) + 1;
+	zest_ForEachFrameInFlight(fif) {
+		zest_layer_buffers_t *buffers = &layer->memory_refs[fif];
+		layer->dirty[fif] = 1;
+		if (buffers->all_pages_dirty) continue;
+		zest_uint current_count = zest_vec_size(buffers->dirty_pages);
+		if (current_count < word_count) {
+			zest_vec_resize(context->allocator, buffers->dirty_pages, word_count);
+			memset(buffers->dirty_pages + current_count, 0, (word_count - current_count) * sizeof(zest_uint));
+		}
+		for (zest_size page = first_page; page <= last_page; ++page) {
+			buffers->dirty_pages[page >> 5] |= 1u << (page & 31);
+		}
+	}
+}
+
+//Step through the runs of dirty pages in a frame in flight's buffers, returning the byte range of each run
+//clamped to limit. page is the cursor and should start at 0.
+zest_bool zest__next_dirty_layer_range(zest_layer_buffers_t *buffers, zest_size page_size, zest_size limit, zest_size *page, zest_size *offset, zest_size *size) {
+	zest_size page_count = (zest_size)zest_vec_size(buffers->dirty_pages) * 32;
+	while (*page < page_count && *page * page_size < limit) {
+		zest_uint word = buffers->dirty_pages[*page >> 5] >> (*page & 31);
+		if (!word) {
+			*page = (*page | 31) + 1;
+			continue;
+		}
+		if (!(word & 1)) {
+			(*page)++;
+			continue;
+		}
+		zest_size first_page = *page;
+		while (*page < page_count && (buffers->dirty_pages[*page >> 5] & (1u << (*page & 31)))) {
+			(*page)++;
+		}
+		*offset = first_page * page_size;
+		*size = ZEST__MIN(*page * page_size, limit) - *offset;
+		return ZEST_TRUE;
+	}
+	return ZEST_FALSE;
+}
+
+//Add a copy region for each run of pages that changed since the current frame in flight's device buffer
+//was last uploaded and return the number of bytes copied.
+zest_size zest__add_dirty_layer_copies(zest_context context, zest_layer layer, zest_buffer_uploader_t *uploader, zest_buffer staging_buffer, zest_buffer device_buffer, zest_size memory_in_use) {
+	zest_layer_buffers_t *buffers = &layer->memory_refs[layer->fif];
+	zest_size uploaded = 0;
+	if (buffers->all_pages_dirty) {
+		zest_AddCopyCommand(context, uploader, staging_buffer, device_buffer, memory_in_use);
+		uploaded = memory_in_use;
+	} else {
+		zest_size page = 0, offset = 0, size = 0;
+		while (zest__next_dirty_layer_range(buffers, layer->delta_page_size, memory_in_use, &page, &offset, &size)) {
+			zest_AddCopyCommandRegion(context, uploader, staging_buffer, device_buffer, offset, offset, size);
+			uploaded += size;
+		}
+	}
+	if (buffers->dirty_pages) {
+		memset(buffers->dirty_pages, 0, zest_vec_size_in_bytes(buffers->dirty_pages));
+	}
+	buffers->all_pages_dirty = ZEST_FALSE;
+	return uploaded;
+}
+
+//Delta upload layers keep their instances when they flip to the next frame in flight. Staging buffers are
+//per frame in flight so the pages that changed while the next one wasn't current are copied over from the
+//one that was. Those are exactly the pages still marked dirty for it because its own changes were cleared
+//when it was last uploaded.
+void zest__carry_over_instance_layer(zest_layer layer, zest_uint from_fif, zest_uint to_fif) {
+	zest_context context = layer->context;
+	zest_layer_buffers_t *from = &layer->memory_refs[from_fif];
+	zest_layer_buffers_t *to = &layer->memory_refs[to_fif];
+	if (ZEST__FLAGGED(layer->flags, zest_layer_flag_device_local_direct)) {
+		if (!zest__grow_direct_instance_buffer(layer, to_fif, from->staging_instance_data->size)) {
+			zest__demote_direct_instance_layer(layer);
+		}
+	}
+	if (to->staging_instance_data->size < from->staging_instance_data->size) {
+		zest_ResizeBuffer(&to->staging_instance_data, from->staging_instance_data->size);
+	}
+	if (to->device_vertex_data->size < to->staging_instance_data->size) {
+		zest_ResizeBuffer(&to->device_vertex_data, to->staging_instance_data->size);
+		to->all_pages_dirty = ZEST_TRUE;
+		zest__update_layer_buffer_descriptor(layer, to_fif);
+	}
+	zest_size memory_in_use = from->instance_count * layer->instance_struct_size;
+	zest_byte *src = (zest_byte*)zest_BufferData(from->staging_instance_data);
+	zest_byte *dst = (zest_byte*)zest_BufferData(to->staging_instance_data);
+	if (to->all_pages_dirty) {
+		memcpy(dst, src, memory_in_use);
+	} else {
+		zest_size page = 0, offset = 0, size = 0;
+		while (zest__next_dirty_layer_range(to, layer->delta_page_size, memory_in_use, &page, &offset, &size)) {
+			memcpy(dst + offset, src + offset, size);
+		}
+	}
+	if (ZEST__FLAGGED(layer->flags, zest_layer_flag_device_local_direct)) {
+		//The copy went straight in to the device buffer so there's nothing left to upload. The pages marked
+		//in from are its own changes which it already has.
+		if (to->dirty_pages) {
+			memset(to->dirty_pages, 0, zest_vec_size_in_bytes(to->dirty_pages));
+		}
+		if (from->dirty_pages) {
+			memset(from->dirty_pages, 0, zest_vec_size_in_bytes(from->dirty_pages));
+		}
+		to->all_pages_dirty = ZEST_FALSE;
+	}
+	to->instance_count = from->instance_count;
+	to->vertex_memory_in_use = memory_in_use;
+	to->instance_ptr = dst + memory_in_use;
+	zest_vec_clear(layer->draw_instructions[to_fif]);
+	zest_vec_foreach(i, layer->draw_instructions[from_fif]) {
+		zest_vec_push_aligned(context->device->allocator, layer->draw_instructions[to_fif], layer->draw_instructions[from_fif][i], 16);
+	}
+	//Each frame in flight has its own indirect buffer which still holds the commands from the last time it was
+	//current, so they're written again for the instructions that came over
+	if (ZEST__FLAGGED(layer->flags, zest_layer_flag_multi_draw_indirect)) {
+		ZEST_ASSERT(layer->fif == to_fif);	//Commands are written to the current frame in flight's buffer
+		zest_vec_foreach(i, layer->draw_instructions[to_fif]) {
+			zest__write_layer_indirect_command(layer, i);
+			if (ZEST__NOT_FLAGGED(layer->flags, zest_layer_flag_multi_draw_indirect)) break;
+		}
+	}
+}
+
 void zest__cleanup_layer(zest_layer layer) {
 	zest_context context = (zest_context)layer->handle.store->origin;
+	if (ZEST__FLAGGED(layer->flags, zest_layer_flag_device_local_direct)) {
+		//The device buffer doubles as the staging buffer
+		zest_ForEachFrameInFlight(fif) {
+			layer->memory_refs[fif].staging_instance_data = 0;
+		}
+		context->device->direct_layer_memory -= layer->direct_memory_size;
+	}
 	zest_ForEachFrameInFlight(fif) {
 		zest_FreeBuffer(layer->memory_refs[fif].device_vertex_data);
 		zest_FreeBuffer(layer->memory_refs[fif].staging_vertex_data);
 		zest_FreeBuffer(layer->memory_refs[fif].staging_index_data);
+		zest_FreeBuffer(layer->memory_refs[fif].indirect_commands);
 		zest_vec_free(context->device->allocator, layer->draw_instructions[fif]);
+		zest_vec_free(context->allocator, layer->memory_refs[fif].dirty_pages);
 	}
+	zest_vec_foreach(i, layer->instance_writers) {
+		if (layer->instance_writers[i].data) {
+			ZEST__FREE(context->allocator, layer->instance_writers[i].data);
+		}
+	}
+	zest_vec_free(context->allocator, layer->instance_writers);
+	zest_vec_free(context->allocator, layer->store_slots);
+	zest_vec_free(context->allocator, layer->store_generations);
+	zest_vec_free(context->allocator, layer->store_ids);
+	zest_vec_free(context->allocator, layer->store_free_ids);
 	zest_FreeBuffer(layer->vertex_data);
 	zest_FreeBuffer(layer->index_data);
 	zest_vec_free(context->allocator, layer->mesh_offsets);
+	zest_vec_free(context->allocator, layer->free_vertex_ranges);
+	zest_vec_free(context->allocator, layer->free_index_ranges);
+	zest_vec_free(context->allocator, layer->pending_mesh_frees);
+	zest_vec_free(context->allocator, layer->mesh_moves);
+	zest_vec_free(context->allocator, layer->free_mesh_indexes);
+	zest_vec_free(context->allocator, layer->lod_chains);
+	zest_vec_free(context->allocator, layer->lod_levels);
+	zest_vec_free(context->allocator, layer->lod_scratch);
     zest__remove_store_resource(layer->handle.store, layer->handle.value);
 }
 
@@ -19621,6 +24653,75 @@ void zest__start_instance_instructions(zest_layer layer) {
 void zest__set_layer_push_constants(zest_layer layer, void *push_constants, zest_size size) {
     ZEST_ASSERT(size <= 128);   //Push constant size must not exceed 128 bytes
     memcpy(layer->current_instruction.push_constant, push_constants, size);
+	//Push constant ranges must be a multiple of 4
+	zest_uint aligned_size = (zest_uint)((size + 3) & ~(zest_size)3);
+	layer->push_constant_size = ZEST__MAX(layer->push_constant_size, aligned_size);
+}
+
+void zest__begin_layer_draw_state(zest_layer layer, zest_layer_draw_state_t *state) {
+	memset(state, 0, sizeof(zest_layer_draw_state_t));
+	memset(&layer->draw_stats, 0, sizeof(zest_layer_draw_stats_t));
+	//Push constants may have been written directly through a pointer in which case the size isn't known
+	state->push_constant_size = layer->push_constant_size ? layer->push_constant_size : ZEST_MAX_PUSH_SIZE;
+}
+
+zest_pipeline zest__bind_layer_draw_pipeline(zest_command_list command_list, zest_layer layer, zest_layer_draw_state_t *state, zest_pipeline_template pipeline_template) {
+	zest_pipeline pipeline = 0;
+	zest_bool found = ZEST_FALSE;
+	for (zest_uint i = 0; i != ZEST_LAYER_DRAW_PIPELINE_SLOTS; ++i) {
+		if (state->templates[i] && state->templates[i] == pipeline_template) {
+			pipeline = state->pipelines[i];
+			found = ZEST_TRUE;
+			break;
+		}
+	}
+	if (!found) {
+		pipeline = zest_GetPipeline(pipeline_template, command_list);
+		layer->draw_stats.pipeline_lookups++;
+		state->templates[state->next_slot] = pipeline_template;
+		state->pipelines[state->next_slot] = pipeline;
+		state->next_slot = (state->next_slot + 1) % ZEST_LAYER_DRAW_PIPELINE_SLOTS;
+	}
+	if (!pipeline) {
+		return 0;
+	}
+	if (pipeline != state->bound_pipeline) {
+		zest_cmd_BindPipeline(command_list, pipeline);
+		state->bound_pipeline = pipeline;
+		layer->draw_stats.pipeline_binds++;
+	} else {
+		layer->draw_stats.elided++;
+	}
+	return pipeline;
+}
+
+void zest__set_layer_draw_viewport(zest_command_list command_list, zest_layer layer, zest_layer_draw_state_t *state, const zest_viewport_t *viewport, const zest_scissor_rect_t *scissor) {
+	//Dynamic viewport and scissor state persists across pipeline binds so it only needs setting when it changes
+	if (!state->viewport || memcmp(state->viewport, viewport, sizeof(zest_viewport_t))) {
+		zest_cmd_ViewPort(command_list, (zest_viewport_t*)viewport);
+		state->viewport = viewport;
+		layer->draw_stats.viewport_updates++;
+	} else {
+		layer->draw_stats.elided++;
+	}
+	if (!state->scissor || memcmp(state->scissor, scissor, sizeof(zest_scissor_rect_t))) {
+		zest_cmd_Scissor(command_list, (zest_scissor_rect_t*)scissor);
+		state->scissor = scissor;
+		layer->draw_stats.scissor_updates++;
+	} else {
+		layer->draw_stats.elided++;
+	}
+}
+
+void zest__send_layer_draw_push_constants(zest_command_list command_list, zest_layer layer, zest_layer_draw_state_t *state, const char *push_constant) {
+	//All pipelines share the device pipeline layout so push constants stay valid when the pipeline changes
+	if (!state->push_constant || memcmp(state->push_constant, push_constant, state->push_constant_size)) {
+		zest_cmd_SendPushConstants(command_list, (void*)push_constant, state->push_constant_size);
+		state->push_constant = push_constant;
+		layer->draw_stats.push_constant_updates++;
+	} else {
+		layer->draw_stats.elided++;
+	}
 }
 
 void zest_ResetLayer(zest_layer layer) {
@@ -19634,6 +24735,11 @@ void zest_ResetInstanceLayer(zest_layer layer) {
 	//if you want to manually reset the layer
     layer->prev_fif = layer->fif;
     layer->fif = (layer->fif + 1) % ZEST_MAX_FIF;
+	if (ZEST__FLAGGED(layer->flags, zest_layer_flag_delta_upload)) {
+		//Only what's changed needs uploading, which zest__mark_layer_pages_dirty has flagged already
+		zest__carry_over_instance_layer(layer, layer->prev_fif, layer->fif);
+		return;
+	}
     layer->dirty[layer->fif] = 1;
     zest__reset_instance_layer_drawing(layer);
 }
@@ -19650,14 +24756,22 @@ void zest__end_instance_instructions(zest_layer layer) {
 		}
         layer->fif = context->current_fif;
     }
-    if (layer->current_instruction.total_instances) {
+	if (layer->lod_drawing) {
+		zest__end_lod_instructions(layer);
+	} else if (layer->current_instruction.total_instances) {
         layer->last_draw_mode = zest_draw_mode_none;
         zest_vec_push_aligned(context->device->allocator, layer->draw_instructions[layer->fif], layer->current_instruction, 16);
+		if (ZEST__FLAGGED(layer->flags, zest_layer_flag_multi_draw_indirect)) {
+			zest__write_layer_indirect_command(layer, zest_vec_size(layer->draw_instructions[layer->fif]) - 1);
+		}
         layer->current_instruction.total_instances = 0;
         layer->current_instruction.start_index = 0;
     }
     else if (layer->current_instruction.draw_mode == zest_draw_mode_viewport) {
         zest_vec_push_aligned(context->device->allocator, layer->draw_instructions[layer->fif], layer->current_instruction, 16);
+		if (ZEST__FLAGGED(layer->flags, zest_layer_flag_multi_draw_indirect)) {
+			zest__write_layer_indirect_command(layer, zest_vec_size(layer->draw_instructions[layer->fif]) - 1);
+		}
         layer->last_draw_mode = zest_draw_mode_none;
     }
     layer->memory_refs[layer->fif].vertex_memory_in_use = layer->memory_refs[layer->fif].instance_count * layer->instance_struct_size;
@@ -19675,14 +24789,22 @@ void zest_EndInstanceInstructions(zest_layer layer) {
 zest_bool zest_MaybeEndInstanceInstructions(zest_layer layer) {
 	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
 	zest_context context = layer->context;
-    if (layer->current_instruction.total_instances) {
+	if (layer->lod_drawing) {
+		zest__end_lod_instructions(layer);
+	} else if (layer->current_instruction.total_instances) {
         layer->last_draw_mode = zest_draw_mode_none;
         zest_vec_push_aligned(context->device->allocator, layer->draw_instructions[layer->fif], layer->current_instruction, 16);
+		if (ZEST__FLAGGED(layer->flags, zest_layer_flag_multi_draw_indirect)) {
+			zest__write_layer_indirect_command(layer, zest_vec_size(layer->draw_instructions[layer->fif]) - 1);
+		}
         layer->current_instruction.total_instances = 0;
         layer->current_instruction.start_index = 0;
     }
     else if (layer->current_instruction.draw_mode == zest_draw_mode_viewport) {
         zest_vec_push_aligned(context->device->allocator, layer->draw_instructions[layer->fif], layer->current_instruction, 16);
+		if (ZEST__FLAGGED(layer->flags, zest_layer_flag_multi_draw_indirect)) {
+			zest__write_layer_indirect_command(layer, zest_vec_size(layer->draw_instructions[layer->fif]) - 1);
+		}
         layer->last_draw_mode = zest_draw_mode_none;
     }
     return 1;
@@ -19753,9 +24875,255 @@ void *zest_NextInstance(zest_layer layer) {
         layer->memory_refs[layer->fif].instance_count++;
     }
     layer->memory_refs[layer->fif].instance_ptr = instance_ptr;
+	if (ZEST__FLAGGED(layer->flags, zest_layer_flag_delta_upload)) {
+		zest__mark_layer_pages_dirty(layer, (zest_byte *)instance_ptr - layer->instance_struct_size - (zest_byte *)zest_BufferData(layer->memory_refs[layer->fif].staging_instance_data), layer->instance_struct_size);
+	}
 	return (zest_byte *)instance_ptr - layer->instance_struct_size;
 }
 
+void zest_EnableInstanceLayerDeltaUploads(zest_layer layer, zest_size page_size) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+    ZEST_ASSERT(ZEST__FLAGGED(layer->flags, zest_layer_flag_manual_fif));   //Delta uploads need the device buffers to persist, create the layer with zest_CreateFIFInstanceLayer
+	layer->delta_page_size = page_size ? page_size : ZEST_LAYER_DELTA_PAGE_SIZE;
+	ZEST__FLAG(layer->flags, zest_layer_flag_delta_upload);
+	//Nothing is known about what's in the buffers yet so they all get a full upload the first time
+	zest_ForEachFrameInFlight(fif) {
+		layer->memory_refs[fif].all_pages_dirty = ZEST_TRUE;
+		layer->dirty[fif] = 1;
+	}
+}
+
+void *zest_UpdateInstance(zest_layer layer, zest_uint index) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	ZEST_ASSERT(index < layer->memory_refs[layer->fif].instance_count);	//Not an instance in the layer
+	zest_size offset = index * layer->instance_struct_size;
+	if (ZEST__FLAGGED(layer->flags, zest_layer_flag_delta_upload)) {
+		zest__mark_layer_pages_dirty(layer, offset, layer->instance_struct_size);
+	} else {
+		layer->dirty[layer->fif] = 1;
+	}
+	return (zest_byte *)zest_BufferData(layer->memory_refs[layer->fif].staging_instance_data) + offset;
+}
+
+void zest_MarkInstancesChanged(zest_layer layer, zest_uint first_instance, zest_uint instance_count) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	if (ZEST__FLAGGED(layer->flags, zest_layer_flag_delta_upload)) {
+		zest__mark_layer_pages_dirty(layer, first_instance * layer->instance_struct_size, instance_count * layer->instance_struct_size);
+	} else {
+		layer->dirty[layer->fif] = 1;
+	}
+}
+
+zest_size zest_GetLayerLastUploadSize(zest_layer layer) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	return layer->last_upload_size;
+}
+
+void *zest_ReserveInstances(zest_layer layer, zest_uint count) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	zest_layer_buffers_t *buffers = &layer->memory_refs[layer->fif];
+	zest_size offset = buffers->instance_count * layer->instance_struct_size;
+	zest_size size_in_bytes = count * layer->instance_struct_size;
+	//There must always be room for the next instance after the reserved ones, see zest_NextInstance
+	if (offset + size_in_bytes >= buffers->staging_instance_data->size) {
+		if (!zest__grow_instance_buffer(layer, layer->instance_struct_size, offset + size_in_bytes + layer->instance_struct_size)) {
+			return NULL;
+		}
+	}
+	zest_byte *first_instance = (zest_byte *)zest_BufferData(buffers->staging_instance_data) + offset;
+	buffers->instance_count += count;
+	buffers->instance_ptr = first_instance + size_in_bytes;
+	layer->current_instruction.total_instances += count;
+	if (ZEST__FLAGGED(layer->flags, zest_layer_flag_delta_upload)) {
+		zest__mark_layer_pages_dirty(layer, offset, size_in_bytes);
+	}
+	return first_instance;
+}
+
+zest_instance_writer_t *zest_BeginParallelInstances(zest_layer layer, zest_uint writer_count) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	ZEST_ASSERT(writer_count);	//Need at least one writer
+	zest_context context = layer->context;
+	zest_uint current_count = zest_vec_size(layer->instance_writers);
+	if (current_count < writer_count) {
+		zest_vec_resize(context->allocator, layer->instance_writers, writer_count);
+		memset(layer->instance_writers + current_count, 0, (writer_count - current_count) * sizeof(zest_instance_writer_t));
+	}
+	//Writers past writer_count keep their memory for next time but aren't merged
+	for (zest_uint i = 0; i != writer_count; ++i) {
+		layer->instance_writers[i].layer = layer;
+		layer->instance_writers[i].instance_count = 0;
+	}
+	layer->instance_writer_count = writer_count;
+	return layer->instance_writers;
+}
+
+void *zest_NextWriterInstance(zest_instance_writer_t *writer) {
+	zest_size struct_size = writer->layer->instance_struct_size;
+	zest_size offset = writer->instance_count * struct_size;
+	if (offset + struct_size > writer->capacity) {
+		zest_size capacity = writer->capacity ? writer->capacity * 2 : struct_size * 64;
+		zest_byte *data = (zest_byte *)ZEST__REALLOCATE(writer->layer->context->allocator, writer->data, capacity);
+		if (!data) {
+			return NULL;
+		}
+		writer->data = data;
+		writer->capacity = capacity;
+	}
+	writer->instance_count++;
+	return writer->data + offset;
+}
+
+zest_uint zest_EndParallelInstances(zest_layer layer) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	zest_uint total = 0;
+	for (zest_uint i = 0; i != layer->instance_writer_count; ++i) {
+		total += layer->instance_writers[i].instance_count;
+	}
+	if (!total) return 0;
+	//Reserve everything in one go so that the buffer grows at most once
+	zest_byte *dst = (zest_byte *)zest_ReserveInstances(layer, total);
+	if (!dst) return 0;
+	for (zest_uint i = 0; i != layer->instance_writer_count; ++i) {
+		zest_instance_writer_t *writer = &layer->instance_writers[i];
+		zest_size size = writer->instance_count * layer->instance_struct_size;
+		memcpy(dst, writer->data, size);
+		dst += size;
+		writer->instance_count = 0;
+	}
+	return total;
+}
+
+void zest_EnableInstanceStore(zest_layer layer, zest_pipeline_template pipeline) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	ZEST_ASSERT_HANDLE(pipeline); //ERROR: Not a valid pipeline template pointer
+	ZEST_ASSERT(ZEST__FLAGGED(layer->flags, zest_layer_flag_manual_fif), "An instance store needs the device buffers to persist, create the layer with zest_CreateFIFInstanceLayer or zest_CreateFIFInstanceMeshLayer.");
+	ZEST_ASSERT(layer->memory_refs[layer->fif].instance_count == 0, "Enable the instance store before adding any instances to the layer.");
+	if (ZEST__NOT_FLAGGED(layer->flags, zest_layer_flag_delta_upload)) {
+		zest_EnableInstanceLayerDeltaUploads(layer, 0);
+	}
+	//Every instance is drawn with a single instruction built from this one
+	layer->store_instruction = layer->current_instruction;
+	layer->store_instruction.pipeline_template = pipeline;
+	layer->store_instruction.draw_mode = zest_draw_mode_instance;
+	layer->store_instruction.start_index = 0;
+	layer->store_instruction.total_instances = 0;
+	ZEST__FLAG(layer->flags, zest_layer_flag_instance_store);
+}
+
+zest_uint zest__store_instance_slot(zest_layer layer, zest_instance_id id) {
+	zest_uint index = ZEST_HANDLE_INDEX(id);
+	if (index >= zest_vec_size(layer->store_slots) || layer->store_generations[index] != ZEST_HANDLE_GENERATION(id)) {
+		return ZEST_INVALID;
+	}
+	return layer->store_slots[index];
+}
+
+void zest__sync_instance_store(zest_layer layer) {
+	zest_context context = layer->context;
+	zest_layer_buffers_t *buffers = &layer->memory_refs[layer->fif];
+	buffers->vertex_memory_in_use = buffers->instance_count * layer->instance_struct_size;
+	buffers->instance_ptr = (zest_byte *)zest_BufferData(buffers->staging_instance_data) + buffers->vertex_memory_in_use;
+	zest_vec_clear(layer->draw_instructions[layer->fif]);
+	if (buffers->instance_count) {
+		zest_layer_instruction_t instruction = layer->store_instruction;
+		instruction.total_instances = buffers->instance_count;
+		zest_vec_push_aligned(context->device->allocator, layer->draw_instructions[layer->fif], instruction, 16);
+		if (ZEST__FLAGGED(layer->flags, zest_layer_flag_multi_draw_indirect)) {
+			zest__write_layer_indirect_command(layer, 0);
+		}
+	}
+}
+
+void *zest_AddStoreInstance(zest_layer layer, zest_instance_id *id) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	ZEST_ASSERT(ZEST__FLAGGED(layer->flags, zest_layer_flag_instance_store), "Call zest_EnableInstanceStore before adding instances to the store.");
+	zest_context context = layer->context;
+	zest_layer_buffers_t *buffers = &layer->memory_refs[layer->fif];
+	zest_size struct_size = layer->instance_struct_size;
+	zest_uint slot = buffers->instance_count;
+	zest_size offset = slot * struct_size;
+	//There must always be room for the next instance after this one, see zest_NextInstance
+	if (offset + struct_size >= buffers->staging_instance_data->size) {
+		if (!zest__grow_instance_buffer(layer, struct_size, offset + struct_size * 2)) {
+			return NULL;
+		}
+	}
+	zest_uint index;
+	if (zest_vec_size(layer->store_free_ids)) {
+		index = zest_vec_pop(layer->store_free_ids);
+	} else {
+		index = zest_vec_size(layer->store_slots);
+		zest_vec_push(context->allocator, layer->store_slots, ZEST_INVALID);
+		zest_vec_push(context->allocator, layer->store_generations, 1);
+	}
+	layer->store_slots[index] = slot;
+	if (slot < zest_vec_size(layer->store_ids)) {
+		layer->store_ids[slot] = index;
+	} else {
+		zest_vec_push(context->allocator, layer->store_ids, index);
+	}
+	buffers->instance_count++;
+	zest__mark_layer_pages_dirty(layer, offset, struct_size);
+	zest__sync_instance_store(layer);
+	if (id) {
+		*id = ZEST_CREATE_HANDLE(layer->store_generations[index], index);
+	}
+	return (zest_byte *)zest_BufferData(buffers->staging_instance_data) + offset;
+}
+
+void *zest_UpdateStoreInstance(zest_layer layer, zest_instance_id id) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	zest_uint slot = zest__store_instance_slot(layer, id);
+	ZEST_ASSERT(slot != ZEST_INVALID, "Not a valid instance id, the instance may have been removed from the store.");
+	void *instance = zest_UpdateInstance(layer, slot);
+	//The store instruction and its indirect command are rebuilt for the current frame in flight as well so that
+	//an update is never drawn with a command left from another frame
+	zest__sync_instance_store(layer);
+	return instance;
+}
+
+void zest_RemoveStoreInstance(zest_layer layer, zest_instance_id id) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	zest_context context = layer->context;
+	zest_uint slot = zest__store_instance_slot(layer, id);
+	if (slot == ZEST_INVALID) {
+		ZEST_REPORT(context->device, zest_report_layers, "Tried to remove an instance from the store in layer [%s] that was already removed.", layer->name);
+		return;
+	}
+	zest_layer_buffers_t *buffers = &layer->memory_refs[layer->fif];
+	zest_size struct_size = layer->instance_struct_size;
+	zest_uint last_slot = buffers->instance_count - 1;
+	if (slot != last_slot) {
+		zest_byte *data = (zest_byte *)zest_BufferData(buffers->staging_instance_data);
+		memcpy(data + slot * struct_size, data + last_slot * struct_size, struct_size);
+		zest_uint moved_index = layer->store_ids[last_slot];
+		layer->store_ids[slot] = moved_index;
+		layer->store_slots[moved_index] = slot;
+		zest__mark_layer_pages_dirty(layer, slot * struct_size, struct_size);
+	}
+	zest_uint index = ZEST_HANDLE_INDEX(id);
+	layer->store_slots[index] = ZEST_INVALID;
+	//Generation 0 is skipped so that 0 is never a valid id
+	layer->store_generations[index] = (layer->store_generations[index] + 1) & 0xFFFFFF;
+	if (!layer->store_generations[index]) {
+		layer->store_generations[index] = 1;
+	}
+	zest_vec_push(context->allocator, layer->store_free_ids, index);
+	buffers->instance_count--;
+	zest__sync_instance_store(layer);
+}
+
+zest_bool zest_StoreInstanceIsValid(zest_layer layer, zest_instance_id id) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	return zest__store_instance_slot(layer, id) != ZEST_INVALID;
+}
+
+zest_uint zest_GetStoreInstanceSlot(zest_layer layer, zest_instance_id id) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	return zest__store_instance_slot(layer, id);
+}
+
 zest_draw_buffer_result zest_DrawInstanceBuffer(zest_layer layer, void *src, zest_uint amount) {
 	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
 	zest_context context = layer->context;
@@ -19777,6 +25145,9 @@ zest_draw_buffer_result zest_DrawInstanceBuffer(zest_layer layer, void *src, zes
         }
     }
     memcpy(instance_ptr, src, size_in_bytes_to_copy);
+	if (ZEST__FLAGGED(layer->flags, zest_layer_flag_delta_upload)) {
+		zest__mark_layer_pages_dirty(layer, layer->memory_refs[layer->fif].instance_count * layer->instance_struct_size, size_in_bytes_to_copy);
+	}
     layer->memory_refs[layer->fif].instance_count += amount;
     layer->current_instruction.total_instances += amount;
     instance_ptr += size_in_bytes_to_copy;
@@ -19786,6 +25157,9 @@ zest_draw_buffer_result zest_DrawInstanceBuffer(zest_layer layer, void *src, zes
 
 void zest_DrawInstanceInstruction(zest_layer layer, zest_uint amount) {
 	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	if (ZEST__FLAGGED(layer->flags, zest_layer_flag_delta_upload)) {
+		zest__mark_layer_pages_dirty(layer, layer->memory_refs[layer->fif].instance_count * layer->instance_struct_size, amount * layer->instance_struct_size);
+	}
     layer->memory_refs[layer->fif].instance_count += amount;
     layer->current_instruction.total_instances += amount;
     zest_size size_in_bytes_to_draw = amount * layer->instance_struct_size;
@@ -19887,6 +25261,13 @@ void zest_UploadLayerStagingData(zest_layer layer, const zest_command_list comma
 
     if (ZEST_VALID_HANDLE(layer, zest_struct_type_layer)) {  //You must pass in the zest_layer in the user data
 
+		if (ZEST__FLAGGED(layer->flags, zest_layer_flag_device_local_direct)) {
+			//Instances are written straight in to the device buffer
+			layer->dirty[layer->fif] = 0;
+			layer->last_upload_size = 0;
+			return;
+		}
+
         if (!layer->dirty[layer->fif]) {
             return;
         }
@@ -19900,9 +25281,17 @@ void zest_UploadLayerStagingData(zest_layer layer, const zest_command_list comma
         zest_buffer_uploader_t instance_upload = { 0, staging_buffer, device_buffer, 0 };
 
         layer->dirty[layer->fif] = 0;
+		layer->last_upload_size = 0;
 
-		if (layer->memory_refs[layer->fif].vertex_memory_in_use) {
-			zest_AddCopyCommand(context, &instance_upload, staging_buffer, device_buffer, layer->memory_refs[layer->fif].vertex_memory_in_use);
+		zest_size memory_in_use = layer->memory_refs[layer->fif].vertex_memory_in_use;
+		if (memory_in_use) {
+			if (ZEST__FLAGGED(layer->flags, zest_layer_flag_delta_upload)) {
+				layer->last_upload_size = zest__add_dirty_layer_copies(context, layer, &instance_upload, staging_buffer, device_buffer, memory_in_use);
+				if (!layer->last_upload_size) return;
+			} else {
+				zest_AddCopyCommand(context, &instance_upload, staging_buffer, device_buffer, memory_in_use);
+				layer->last_upload_size = memory_in_use;
+			}
         } else {
             return;
         }
@@ -19938,6 +25327,16 @@ zest_buffer zest_GetLayerStagingIndexBuffer(zest_layer layer) {
     return layer->memory_refs[layer->fif].staging_index_data;
 }
 
+zest_buffer zest_GetLayerMeshVertexBuffer(zest_layer layer) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	return layer->vertex_data;
+}
+
+zest_buffer zest_GetLayerMeshIndexBuffer(zest_layer layer) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	return layer->index_data;
+}
+
 const zest_mesh_offset_data_t *zest_GetLayerMeshOffsets(zest_layer layer, zest_uint mesh_index) {
 	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
 	ZEST_ASSERT(mesh_index < zest_vec_size(layer->mesh_offsets), "The mesh index is out of bounds when trying to fetch mesh offsets from the layer.");
@@ -19963,9 +25362,16 @@ zest_viewport_t zest_GetLayerViewport(zest_layer layer) {
 	return layer->viewport;
 }
 
+zest_layer_draw_stats_t zest_GetLayerDrawStats(zest_layer layer) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	return layer->draw_stats;
+}
+
 char *zest_GetLayerInstructionPushConstants(zest_layer layer, zest_uint index) {
 	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
 	ZEST_ASSERT(index < zest_vec_size(layer->draw_instructions[layer->fif]));
+	//The caller can write any amount so the whole push constant range has to be sent from now on
+	layer->push_constant_size = ZEST_MAX_PUSH_SIZE;
 	return layer->draw_instructions[layer->fif][index].push_constant;
 }
 
@@ -19998,33 +25404,29 @@ void zest_DrawInstanceLayer(const zest_command_list command_list, void *user_dat
 	zest_buffer device_buffer = layer->vertex_buffer_node->storage_buffer;
 	zest_cmd_BindVertexBuffer(command_list, 0, 1, device_buffer);
 
-	zest_pipeline current_pipeline = 0;
+	zest_layer_draw_state_t state;
+	zest__begin_layer_draw_state(layer, &state);
 
     zest_bool has_instruction_view_port = ZEST_FALSE;
     zest_vec_foreach(i, layer->draw_instructions[layer->fif]) {
         zest_layer_instruction_t* current = &layer->draw_instructions[layer->fif][i];
 
         if (current->draw_mode == zest_draw_mode_viewport) {
-			zest_cmd_ViewPort(command_list, &current->viewport);
-			zest_cmd_Scissor(command_list, &current->scissor);
+			zest__set_layer_draw_viewport(command_list, layer, &state, &current->viewport, &current->scissor);
             has_instruction_view_port = ZEST_TRUE;
             continue;
         } else if(!has_instruction_view_port) {
-			zest_cmd_ViewPort(command_list, &layer->viewport);
-			zest_cmd_Scissor(command_list, &layer->scissor);
+			zest__set_layer_draw_viewport(command_list, layer, &state, &layer->viewport, &layer->scissor);
         }
 
-        zest_pipeline pipeline = zest_GetPipeline(current->pipeline_template, command_list);
-        if (pipeline && pipeline != current_pipeline) {
-			zest_cmd_BindPipeline(command_list, pipeline);
-			current_pipeline = pipeline;
-        } else if(!pipeline) {
+		if (!zest__bind_layer_draw_pipeline(command_list, layer, &state, current->pipeline_template)) {
             continue;
         }
 
-		zest_cmd_SendPushConstants(command_list, current->push_constant, ZEST_MAX_PUSH_SIZE);
+		zest__send_layer_draw_push_constants(command_list, layer, &state, current->push_constant);
 
 		zest_cmd_Draw(command_list, 6, current->total_instances, 0, current->start_index);
+		layer->draw_stats.draws++;
     }
 }
 //-- End Draw Layers
@@ -20043,13 +25445,90 @@ ZEST_API zest_layer zest_GetLayer(zest_layer_handle layer_handle) {
 zest_layer_handle zest_CreateFIFInstanceLayer(zest_context context, const char* name, zest_size type_size, zest_uint max_instances) {
     zest_layer_handle layer_handle = zest_CreateInstanceLayer(context, name, type_size, max_instances);
     zest_layer layer = (zest_layer)zest__get_store_resource_checked(layer_handle.store, layer_handle.value);
+	zest__create_fif_instance_device_buffers(layer);
+    ZEST__FLAG(layer->flags, zest_layer_flag_manual_fif);
+    return layer_handle;
+}
+
+zest_layer_handle zest_CreateDirectFIFInstanceLayer(zest_context context, const char* name, zest_size type_size, zest_uint max_instances) {
+    zest_layer_handle layer_handle = zest_CreateInstanceLayer(context, name, type_size, max_instances);
+    zest_layer layer = (zest_layer)zest__get_store_resource_checked(layer_handle.store, layer_handle.value);
+	if (!zest__create_direct_instance_buffers(layer)) {
+		ZEST_APPEND_LOG(context->device->log_path.str, "No host visible device memory available for direct layer %s, using staging buffers instead.", name);
+		zest__create_fif_instance_device_buffers(layer);
+	}
+    ZEST__FLAG(layer->flags, zest_layer_flag_manual_fif);
+    return layer_handle;
+}
+
+zest_bool zest_InstanceLayerNeedsUpload(zest_layer layer) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	return ZEST__NOT_FLAGGED(layer->flags, zest_layer_flag_device_local_direct);
+}
+
+void zest__create_fif_instance_device_buffers(zest_layer layer) {
+	zest_context context = layer->context;
     zest_ForEachFrameInFlight(fif) {
 		zest_buffer_info_t buffer_info = zest_CreateBufferInfo(zest_buffer_type_vertex_storage, zest_memory_usage_gpu_only);
 		buffer_info.frame_in_flight = fif;
         layer->memory_refs[fif].device_vertex_data = zest_CreateBuffer(context->device, layer->memory_refs[fif].staging_instance_data->size, &buffer_info);
     }
-    ZEST__FLAG(layer->flags, zest_layer_flag_manual_fif);
-    return layer_handle;
+}
+
+//Host visible device memory can come from a small heap (the 256MB BAR window when resizable BAR is off) that
+//the driver uses too, so direct layers check there's room before taking any. The driver's budget is used
+//when the device has the query, otherwise direct layers are limited to half of the heap between them.
+zest_bool zest__reserve_direct_layer_memory(zest_device device, zest_size size) {
+	zest_uint heap_index = 0;
+	zest_size heap_size = 0;
+	zest_memory_property_flags property_flags = zest_memory_property_device_local_bit | zest_memory_property_host_visible_bit | zest_memory_property_host_coherent_bit;
+	if (!device->platform->find_memory_heap || !device->platform->find_memory_heap(device, property_flags, &heap_index, &heap_size)) {
+		return ZEST_FALSE;
+	}
+	zest_memory_budget_t budget = zest_GetDeviceMemoryBudget(device);
+	if (budget.supported && heap_index < budget.heap_count) {
+		if (budget.heaps[heap_index].usage + size > budget.heaps[heap_index].budget) {
+			return ZEST_FALSE;
+		}
+	} else if (device->direct_layer_memory + size > heap_size / 2) {
+		return ZEST_FALSE;
+	}
+	device->direct_layer_memory += size;
+	return ZEST_TRUE;
+}
+
+//Replace the staging buffers of a new layer with host visible device buffers. Each one stands in for both
+//the staging and the device buffer of its frame in flight.
+zest_bool zest__create_direct_instance_buffers(zest_layer layer) {
+	zest_device device = layer->context->device;
+	zest_size buffer_size = layer->memory_refs[0].staging_instance_data->size;
+	zest_size reserve_size = buffer_size * ZEST_MAX_FIF;
+	if (!zest__reserve_direct_layer_memory(device, reserve_size)) {
+		return ZEST_FALSE;
+	}
+	zest_buffer direct_buffers[ZEST_MAX_FIF] = { 0 };
+	zest_buffer_info_t buffer_info = zest_CreateBufferInfo(zest_buffer_type_vertex_storage, zest_memory_usage_gpu_host_visible);
+	zest_ForEachFrameInFlight(fif) {
+		buffer_info.frame_in_flight = fif;
+		direct_buffers[fif] = zest_CreateBuffer(device, buffer_size, &buffer_info);
+		if (!direct_buffers[fif]) {
+			zest_ForEachFrameInFlight(i) {
+				zest_FreeBuffer(direct_buffers[i]);
+			}
+			device->direct_layer_memory -= reserve_size;
+			return ZEST_FALSE;
+		}
+	}
+	zest_ForEachFrameInFlight(fif) {
+		zest_layer_buffers_t *buffers = &layer->memory_refs[fif];
+		zest_FreeBuffer(buffers->staging_instance_data);
+		buffers->staging_instance_data = direct_buffers[fif];
+		buffers->device_vertex_data = direct_buffers[fif];
+		buffers->instance_ptr = zest_BufferData(direct_buffers[fif]);
+	}
+	layer->direct_memory_size = reserve_size;
+	ZEST__FLAG(layer->flags, zest_layer_flag_device_local_direct);
+	return ZEST_TRUE;
 }
 
 void zest__initialise_instance_layer(zest_context context, zest_layer layer, zest_size type_size, zest_uint instance_pool_size) {
@@ -20115,6 +25594,7 @@ void zest_SetLayerPushConstants(zest_layer layer, void *push_constants, zest_siz
 
 void *zest_GetLayerPushConstants(zest_layer layer) {
 	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	layer->push_constant_size = ZEST_MAX_PUSH_SIZE;
 	return (void*)layer->current_instruction.push_constant;
 }
 
@@ -20236,6 +25716,7 @@ zest_instruction_id zest_StartInstanceMeshDrawing(zest_layer layer, zest_uint me
 	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
     ZEST_ASSERT_HANDLE(pipeline);	//Not a valid handle!
 	ZEST_ASSERT(mesh_index < zest_vec_size(layer->mesh_offsets), "Mesh index is out of bounds. Make sure you add all your meshes to the layer with zest_AddMeshToLayer");
+	ZEST_ASSERT(!layer->mesh_offsets[mesh_index].is_free, "The mesh was removed from the layer with zest_RemoveMeshFromLayer.");
     zest__end_instance_instructions(layer);
     zest__start_instance_instructions(layer);
     layer->current_instruction.pipeline_template = pipeline;
@@ -20247,6 +25728,15 @@ zest_instruction_id zest_StartInstanceMeshDrawing(zest_layer layer, zest_uint me
 	return zest_vec_size(layer->draw_instructions[layer->fif]);
 }
 
+zest_instruction_id zest_StartInstanceMeshLODDrawing(zest_layer layer, zest_uint lod_chain, zest_pipeline_template pipeline) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	ZEST_ASSERT(lod_chain < zest_vec_size(layer->lod_chains), "LOD chain index is out of bounds. Make sure you add the chain to the layer with zest_AddLayerMeshLODChain");
+	zest_instruction_id id = zest_StartInstanceMeshDrawing(layer, layer->lod_chains[lod_chain].levels[0].mesh_index, pipeline);
+	layer->lod_drawing = ZEST_TRUE;
+	layer->lod_chain = lod_chain;
+	return id;
+}
+
 void zest_PushMeshIndex(zest_mesh mesh, zest_uint index) {
 	ZEST_ASSERT_HANDLE(mesh);	//Not a valid mesh handle
     ZEST_ASSERT(index < mesh->vertex_count); //Add vertices first before triangles to make sure you're indexing vertices that exist
@@ -20255,12 +25745,8 @@ void zest_PushMeshIndex(zest_mesh mesh, zest_uint index) {
 
 void zest_PushMeshTriangle(zest_mesh mesh, zest_uint i1, zest_uint i2, zest_uint i3) {
 	ZEST_ASSERT_HANDLE(mesh);	//Not a valid mesh handle
-    ZEST_ASSERT(i1 < mesh->vertex_count);	//Add vertices first before triangles to make sure you're indexing vertices that exist
-    ZEST_ASSERT(i2 < mesh->vertex_count);	//Add vertices first before triangles to make sure you're indexing vertices that exist
-    ZEST_ASSERT(i3 < mesh->vertex_count);	//Add vertices first before triangles to make sure you're indexing vertices that exist
-    zest_vec_push(mesh->context->device->allocator, mesh->indexes, i1);
-    zest_vec_push(mesh->context->device->allocator, mesh->indexes, i2);
-    zest_vec_push(mesh->context->device->allocator, mesh->indexes, i3);
+	zest_uint triangle[3] = { i1, i2, i3 };
+	zest_AppendMeshIndexes(mesh, triangle, 3, 0);
 }
 
 zest_mesh zest_NewMesh(zest_context context, zest_size vertex_struct_size) {
@@ -20316,6 +25802,40 @@ void zest_ReserveMeshVertices(zest_mesh mesh, zest_uint count) {
     mesh->vertex_capacity = count;
 }
 
+void zest_ReserveMeshIndexes(zest_mesh mesh, zest_uint count) {
+	ZEST_ASSERT_HANDLE(mesh);	//Not a valid mesh handle
+	zest_vec_reserve(mesh->context->device->allocator, mesh->indexes, count);
+}
+
+zest_uint zest_AppendMeshVertices(zest_mesh mesh, const void *vertices, zest_uint count) {
+	ZEST_ASSERT_HANDLE(mesh);	//Not a valid mesh handle
+	zest_uint first_vertex = mesh->vertex_count;
+	if (!count) return first_vertex;
+	zest_uint required = mesh->vertex_count + count;
+	if (required > mesh->vertex_capacity) {
+		zest_ReserveMeshVertices(mesh, ZEST__MAX(required, mesh->vertex_capacity * 2));
+	}
+	memcpy((char*)mesh->vertex_data + mesh->vertex_count * mesh->vertex_struct_size, vertices, count * mesh->vertex_struct_size);
+	mesh->vertex_count = required;
+	return first_vertex;
+}
+
+void zest_AppendMeshIndexes(zest_mesh mesh, const zest_uint *indexes, zest_uint count, zest_uint base_vertex) {
+	ZEST_ASSERT_HANDLE(mesh);	//Not a valid mesh handle
+	if (!count) return;
+	zest_uint first = zest_vec_size(mesh->indexes);
+	zest_uint required = first + count;
+	if (required > zest_vec_capacity(mesh->indexes)) {
+		zest_uint capacity = ZEST__MAX(required, zest_vec_capacity(mesh->indexes) * 2);
+		zest_vec_reserve(mesh->context->device->allocator, mesh->indexes, capacity);
+	}
+	zest_vec_resize(mesh->context->device->allocator, mesh->indexes, required);
+	for (zest_uint i = 0; i != count; ++i) {
+		ZEST_ASSERT(indexes[i] + base_vertex < mesh->vertex_count);	//Add vertices first before triangles to make sure you're indexing vertices that exist
+		mesh->indexes[first + i] = indexes[i] + base_vertex;
+	}
+}
+
 void zest_PushMeshVertexData(zest_mesh mesh, const void* vertex_data) {
 	ZEST_ASSERT_HANDLE(mesh);	//Not a valid mesh handle
     if (mesh->vertex_count >= mesh->vertex_capacity) {
@@ -20397,36 +25917,748 @@ void *zest_MeshVertexData(zest_mesh mesh) {
 	return mesh->vertex_data;
 }
 
+//Vertex normals and tangents are built in two passes so that they can be split across the job system without
+//threads writing to the same vertex: the first works out an attribute for each triangle, 4 triangles at a time,
+//and the second goes over the vertices and sums the triangles that use them.
+#if defined(ZEST_INTEL)
+typedef __m128 zest__float4;
+ZEST_PRIVATE zest__float4 zest__f4_load(const float *f) { return _mm_loadu_ps(f); }
+ZEST_PRIVATE void zest__f4_store(float *f, zest__float4 v) { _mm_storeu_ps(f, v); }
+ZEST_PRIVATE zest__float4 zest__f4_add(zest__float4 a, zest__float4 b) { return _mm_add_ps(a, b); }
+ZEST_PRIVATE zest__float4 zest__f4_sub(zest__float4 a, zest__float4 b) { return _mm_sub_ps(a, b); }
+ZEST_PRIVATE zest__float4 zest__f4_mul(zest__float4 a, zest__float4 b) { return _mm_mul_ps(a, b); }
+ZEST_PRIVATE zest__float4 zest__f4_div(zest__float4 a, zest__float4 b) { return _mm_div_ps(a, b); }
+ZEST_PRIVATE zest__float4 zest__f4_sqrt(zest__float4 a) { return _mm_sqrt_ps(a); }
+//a / b in the lanes where b is more than 0 and 0 in the others
+ZEST_PRIVATE zest__float4 zest__f4_safe_div(zest__float4 a, zest__float4 b) {
+	__m128 mask = _mm_cmpgt_ps(b, _mm_setzero_ps());
+	return _mm_and_ps(mask, _mm_div_ps(a, _mm_or_ps(b, _mm_andnot_ps(mask, _mm_set1_ps(1.f)))));
+}
+#elif defined(ZEST_ARM) && defined(__aarch64__)
+typedef float32x4_t zest__float4;
+ZEST_PRIVATE zest__float4 zest__f4_load(const float *f) { return vld1q_f32(f); }
+ZEST_PRIVATE void zest__f4_store(float *f, zest__float4 v) { vst1q_f32(f, v); }
+ZEST_PRIVATE zest__float4 zest__f4_add(zest__float4 a, zest__float4 b) { return vaddq_f32(a, b); }
+ZEST_PRIVATE zest__float4 zest__f4_sub(zest__float4 a, zest__float4 b) { return vsubq_f32(a, b); }
+ZEST_PRIVATE zest__float4 zest__f4_mul(zest__float4 a, zest__float4 b) { return vmulq_f32(a, b); }
+ZEST_PRIVATE zest__float4 zest__f4_div(zest__float4 a, zest__float4 b) { return vdivq_f32(a, b); }
+ZEST_PRIVATE zest__float4 zest__f4_sqrt(zest__float4 a) { return vsqrtq_f32(a); }
+ZEST_PRIVATE zest__float4 zest__f4_safe_div(zest__float4 a, zest__float4 b) {
+	uint32x4_t mask = vcgtq_f32(b, vdupq_n_f32(0.f));
+	return vbslq_f32(mask, vdivq_f32(a, vbslq_f32(mask, b, vdupq_n_f32(1.f))), vdupq_n_f32(0.f));
+}
+#else
+typedef struct zest__float4 { float v[4]; } zest__float4;
+ZEST_PRIVATE zest__float4 zest__f4_load(const float *f) { zest__float4 r; memcpy(r.v, f, sizeof(r.v)); return r; }
+ZEST_PRIVATE void zest__f4_store(float *f, zest__float4 v) { memcpy(f, v.v, sizeof(v.v)); }
+ZEST_PRIVATE zest__float4 zest__f4_add(zest__float4 a, zest__float4 b) { for (int i = 0; i != 4; ++i) a.v[i] += b.v[i]; return a; }
+ZEST_PRIVATE zest__float4 zest__f4_sub(zest__float4 a, zest__float4 b) { for (int i = 0; i != 4; ++i) a.v[i] -= b.v[i]; return a; }
+ZEST_PRIVATE zest__float4 zest__f4_mul(zest__float4 a, zest__float4 b) { for (int i = 0; i != 4; ++i) a.v[i] *= b.v[i]; return a; }
+ZEST_PRIVATE zest__float4 zest__f4_div(zest__float4 a, zest__float4 b) { for (int i = 0; i != 4; ++i) a.v[i] /= b.v[i]; return a; }
+ZEST_PRIVATE zest__float4 zest__f4_sqrt(zest__float4 a) { for (int i = 0; i != 4; ++i) a.v[i] = sqrtf(a.v[i]); return a; }
+ZEST_PRIVATE zest__float4 zest__f4_safe_div(zest__float4 a, zest__float4 b) { for (int i = 0; i != 4; ++i) a.v[i] = b.v[i] > 0.f ? a.v[i] / b.v[i] : 0.f; return a; }
+#endif
+
+typedef struct zest_mesh_attribute_job_t {
+	zest_byte *vertices;
+	zest_size stride;
+	const zest_uint *indexes;
+	zest_uint triangle_count;
+	zest_uint position_offset;
+	zest_uint normal_offset;
+	zest_uint uv_offset;
+	zest_uint tangent_offset;
+	zest_format tangent_format;
+	float *faces;						//Attributes of each triangle, one array per component
+	zest_uint face_stride;				//Triangle count rounded up to 4
+	zest_uint *vertex_corners;			//Where each vertex's corners start in corners, vertex_count + 1
+	zest_uint *corners;					//Index of every triangle corner (triangle * 3 + corner) grouped by vertex
+} zest_mesh_attribute_job_t;
+
+ZEST_PRIVATE zest_vec3 zest__mesh_vertex_vec3(zest_mesh_attribute_job_t *job, zest_uint vertex, zest_uint offset) {
+	zest_vec3 v;
+	memcpy(&v, job->vertices + vertex * job->stride + offset, sizeof(zest_vec3));
+	return v;
+}
+
+//Gather a component of the 3 corners of 4 triangles in to lanes, triangles past the end are zeroed
+ZEST_PRIVATE void zest__gather_mesh_triangles(zest_mesh_attribute_job_t *job, zest_uint first_triangle, zest_uint offset, zest_uint components, float out[3][3][4]) {
+	for (zest_uint lane = 0; lane != 4; ++lane) {
+		zest_uint triangle = first_triangle + lane;
+		for (zest_uint corner = 0; corner != 3; ++corner) {
+			float value[3] = { 0.f, 0.f, 0.f };
+			if (triangle < job->triangle_count) {
+				memcpy(value, job->vertices + job->indexes[triangle * 3 + corner] * job->stride + offset, components * sizeof(float));
+			}
+			for (zest_uint c = 0; c != components; ++c) {
+				out[corner][c][lane] = value[c];
+			}
+		}
+	}
+}
+
+ZEST_PRIVATE void zest__mesh_face_normals(void *data, zest_uint begin, zest_uint end, zest_uint worker_index) {
+	zest_mesh_attribute_job_t *job = (zest_mesh_attribute_job_t*)data;
+	float p[3][3][4];
+	float *nx = job->faces, *ny = job->faces + job->face_stride, *nz = job->faces + job->face_stride * 2;
+	for (zest_uint group = begin; group != end; ++group) {
+		zest_uint first = group * 4;
+		zest__gather_mesh_triangles(job, first, job->position_offset, 3, p);
+		zest__float4 e1x = zest__f4_sub(zest__f4_load(p[1][0]), zest__f4_load(p[0][0]));
+		zest__float4 e1y = zest__f4_sub(zest__f4_load(p[1][1]), zest__f4_load(p[0][1]));
+		zest__float4 e1z = zest__f4_sub(zest__f4_load(p[1][2]), zest__f4_load(p[0][2]));
+		zest__float4 e2x = zest__f4_sub(zest__f4_load(p[2][0]), zest__f4_load(p[0][0]));
+		zest__float4 e2y = zest__f4_sub(zest__f4_load(p[2][1]), zest__f4_load(p[0][1]));
+		zest__float4 e2z = zest__f4_sub(zest__f4_load(p[2][2]), zest__f4_load(p[0][2]));
+		zest__float4 x = zest__f4_sub(zest__f4_mul(e1y, e2z), zest__f4_mul(e2y, e1z));
+		zest__float4 y = zest__f4_sub(zest__f4_mul(e1z, e2x), zest__f4_mul(e2z, e1x));
+		zest__float4 z = zest__f4_sub(zest__f4_mul(e1x, e2y), zest__f4_mul(e2x, e1y));
+		zest__float4 length = zest__f4_sqrt(zest__f4_add(zest__f4_add(zest__f4_mul(x, x), zest__f4_mul(y, y)), zest__f4_mul(z, z)));
+		zest__f4_store(nx + first, zest__f4_safe_div(x, length));
+		zest__f4_store(ny + first, zest__f4_safe_div(y, length));
+		zest__f4_store(nz + first, zest__f4_safe_div(z, length));
+	}
+}
+
+ZEST_PRIVATE void zest__mesh_vertex_normals(void *data, zest_uint begin, zest_uint end, zest_uint worker_index) {
+	zest_mesh_attribute_job_t *job = (zest_mesh_attribute_job_t*)data;
+	float *nx = job->faces, *ny = job->faces + job->face_stride, *nz = job->faces + job->face_stride * 2;
+	for (zest_uint vertex = begin; vertex != end; ++vertex) {
+		zest_vec3 normal = zest_Vec3Set(0.f, 0.f, 0.f);
+		for (zest_uint i = job->vertex_corners[vertex]; i != job->vertex_corners[vertex + 1]; ++i) {
+			zest_uint triangle = job->corners[i] / 3;
+			normal.x += nx[triangle];
+			normal.y += ny[triangle];
+			normal.z += nz[triangle];
+		}
+		float length = zest_LengthVec3(normal);
+		if (length > 0.f) {
+			normal = zest_Vec3Set(normal.x / length, normal.y / length, normal.z / length);
+		}
+		memcpy(job->vertices + vertex * job->stride + job->normal_offset, &normal, sizeof(zest_vec3));
+	}
+}
+
+ZEST_PRIVATE void zest__mesh_face_tangents(void *data, zest_uint begin, zest_uint end, zest_uint worker_index) {
+	zest_mesh_attribute_job_t *job = (zest_mesh_attribute_job_t*)data;
+	float p[3][3][4], uv[3][3][4];
+	zest_uint fs = job->face_stride;
+	for (zest_uint group = begin; group != end; ++group) {
+		zest_uint first = group * 4;
+		zest__gather_mesh_triangles(job, first, job->position_offset, 3, p);
+		zest__gather_mesh_triangles(job, first, job->uv_offset, 2, uv);
+		zest__float4 e1x = zest__f4_sub(zest__f4_load(p[1][0]), zest__f4_load(p[0][0]));
+		zest__float4 e1y = zest__f4_sub(zest__f4_load(p[1][1]), zest__f4_load(p[0][1]));
+		zest__float4 e1z = zest__f4_sub(zest__f4_load(p[1][2]), zest__f4_load(p[0][2]));
+		zest__float4 e2x = zest__f4_sub(zest__f4_load(p[2][0]), zest__f4_load(p[0][0]));
+		zest__float4 e2y = zest__f4_sub(zest__f4_load(p[2][1]), zest__f4_load(p[0][1]));
+		zest__float4 e2z = zest__f4_sub(zest__f4_load(p[2][2]), zest__f4_load(p[0][2]));
+		zest__float4 du1 = zest__f4_sub(zest__f4_load(uv[1][0]), zest__f4_load(uv[0][0]));
+		zest__float4 dv1 = zest__f4_sub(zest__f4_load(uv[1][1]), zest__f4_load(uv[0][1]));
+		zest__float4 du2 = zest__f4_sub(zest__f4_load(uv[2][0]), zest__f4_load(uv[0][0]));
+		zest__float4 dv2 = zest__f4_sub(zest__f4_load(uv[2][1]), zest__f4_load(uv[0][1]));
+		//Only the direction of the tangent and bitangent matter, but the sign of the uv area flips both so
+		//that a mirrored uv layout gets a bitangent pointing the other way
+		zest__float4 area = zest__f4_sub(zest__f4_mul(du1, dv2), zest__f4_mul(du2, dv1));
+		zest__float4 sign = zest__f4_safe_div(area, zest__f4_sqrt(zest__f4_mul(area, area)));
+		zest__f4_store(job->faces + fs * 0 + first, zest__f4_mul(zest__f4_sub(zest__f4_mul(e1x, dv2), zest__f4_mul(e2x, dv1)), sign));
+		zest__f4_store(job->faces + fs * 1 + first, zest__f4_mul(zest__f4_sub(zest__f4_mul(e1y, dv2), zest__f4_mul(e2y, dv1)), sign));
+		zest__f4_store(job->faces + fs * 2 + first, zest__f4_mul(zest__f4_sub(zest__f4_mul(e1z, dv2), zest__f4_mul(e2z, dv1)), sign));
+		zest__f4_store(job->faces + fs * 3 + first, zest__f4_mul(zest__f4_sub(zest__f4_mul(e2x, du1), zest__f4_mul(e1x, du2)), sign));
+		zest__f4_store(job->faces + fs * 4 + first, zest__f4_mul(zest__f4_sub(zest__f4_mul(e2y, du1), zest__f4_mul(e1y, du2)), sign));
+		zest__f4_store(job->faces + fs * 5 + first, zest__f4_mul(zest__f4_sub(zest__f4_mul(e2z, du1), zest__f4_mul(e1z, du2)), sign));
+	}
+}
+
+//Project v on to the plane of the normal and normalise it, or return 0 if nothing is left
+ZEST_PRIVATE zest_vec3 zest__orthogonalise(zest_vec3 normal, zest_vec3 v) {
+	v = zest_SubVec3(v, zest_ScaleVec3(normal, zest_DotProduct3(normal, v)));
+	float length = zest_LengthVec3(v);
+	return length > 0.f ? zest_ScaleVec3(v, 1.f / length) : zest_Vec3Set(0.f, 0.f, 0.f);
+}
+
+ZEST_PRIVATE void zest__mesh_vertex_tangents(void *data, zest_uint begin, zest_uint end, zest_uint worker_index) {
+	zest_mesh_attribute_job_t *job = (zest_mesh_attribute_job_t*)data;
+	zest_uint fs = job->face_stride;
+	for (zest_uint vertex = begin; vertex != end; ++vertex) {
+		zest_vec3 normal = zest__mesh_vertex_vec3(job, vertex, job->normal_offset);
+		zest_vec3 position = zest__mesh_vertex_vec3(job, vertex, job->position_offset);
+		zest_vec3 tangent = zest_Vec3Set(0.f, 0.f, 0.f);
+		zest_vec3 bitangent = zest_Vec3Set(0.f, 0.f, 0.f);
+		for (zest_uint i = job->vertex_corners[vertex]; i != job->vertex_corners[vertex + 1]; ++i) {
+			zest_uint triangle = job->corners[i] / 3;
+			zest_uint corner = job->corners[i] % 3;
+			//Each triangle is weighted by its angle at this corner, as MikkTSpace does
+			zest_vec3 a = zest__orthogonalise(normal, zest_SubVec3(zest__mesh_vertex_vec3(job, job->indexes[triangle * 3 + (corner + 1) % 3], job->position_offset), position));
+			zest_vec3 b = zest__orthogonalise(normal, zest_SubVec3(zest__mesh_vertex_vec3(job, job->indexes[triangle * 3 + (corner + 2) % 3], job->position_offset), position));
+			float cosine = zest_DotProduct3(a, b);
+			float angle = acosf(ZEST__CLAMP(cosine, -1.f, 1.f));
+			zest_vec3 face_tangent = zest_Vec3Set(job->faces[fs * 0 + triangle], job->faces[fs * 1 + triangle], job->faces[fs * 2 + triangle]);
+			zest_vec3 face_bitangent = zest_Vec3Set(job->faces[fs * 3 + triangle], job->faces[fs * 4 + triangle], job->faces[fs * 5 + triangle]);
+			tangent = zest_AddVec3(tangent, zest_ScaleVec3(zest__orthogonalise(normal, face_tangent), angle));
+			bitangent = zest_AddVec3(bitangent, zest_ScaleVec3(zest__orthogonalise(normal, face_bitangent), angle));
+		}
+		tangent = zest__orthogonalise(normal, tangent);
+		if (zest_LengthVec3NS(tangent) == 0.f) {
+			//No uvs to go by so any direction along the surface will do
+			tangent = zest__orthogonalise(normal, fabsf(normal.x) < .9f ? zest_Vec3Set(1.f, 0.f, 0.f) : zest_Vec3Set(0.f, 1.f, 0.f));
+		}
+		float w = zest_DotProduct3(zest_CrossProduct(normal, tangent), bitangent) < 0.f ? -1.f : 1.f;
+		zest_byte *dst = job->vertices + vertex * job->stride + job->tangent_offset;
+		if (job->tangent_format == zest_format_r16g16b16a16_snorm) {
+			zest_u64 packed = zest_Pack16bit4SNorm(tangent.x, tangent.y, tangent.z, w);
+			memcpy(dst, &packed, sizeof(zest_u64));
+		} else {
+			zest_vec4 unpacked = zest_Vec4Set(tangent.x, tangent.y, tangent.z, w);
+			memcpy(dst, &unpacked, sizeof(zest_vec4));
+		}
+	}
+}
+
+ZEST_PRIVATE void zest__end_mesh_attribute_job(zest_mesh mesh, zest_mesh_attribute_job_t *job) {
+	zest_device device = mesh->context->device;
+	if (job->faces) ZEST__FREE(device->allocator, job->faces);
+	if (job->vertex_corners) ZEST__FREE(device->allocator, job->vertex_corners);
+	if (job->corners) ZEST__FREE(device->allocator, job->corners);
+}
+
+//Sets up the scratch memory for working out normals or tangents, with face_components floats for each triangle
+//and a list of the triangle corners that use each vertex. Returns ZEST_FALSE if there's nothing to do.
+ZEST_PRIVATE zest_bool zest__begin_mesh_attribute_job(zest_mesh mesh, zest_mesh_attribute_job_t *job, zest_uint face_components) {
+	zest_device device = mesh->context->device;
+	*job = ZEST__ZERO_INIT(zest_mesh_attribute_job_t);
+	job->triangle_count = zest_MeshIndexCount(mesh) / 3;
+	if (!job->triangle_count || !mesh->vertex_count) {
+		return ZEST_FALSE;
+	}
+	job->vertices = (zest_byte*)mesh->vertex_data;
+	job->stride = mesh->vertex_struct_size;
+	job->indexes = mesh->indexes;
+	job->face_stride = (job->triangle_count + 3) & ~3u;
+	job->faces = (float*)ZEST__ALLOCATE(device->allocator, job->face_stride * face_components * sizeof(float));
+	job->vertex_corners = (zest_uint*)ZEST__ALLOCATE(device->allocator, (mesh->vertex_count + 1) * sizeof(zest_uint));
+	job->corners = (zest_uint*)ZEST__ALLOCATE(device->allocator, job->triangle_count * 3 * sizeof(zest_uint));
+	if (!job->faces || !job->vertex_corners || !job->corners) {
+		ZEST_REPORT(device, zest_report_memory, "Unable to allocate the scratch memory for working out the normals or tangents of a mesh with %u triangles.", job->triangle_count);
+		zest__end_mesh_attribute_job(mesh, job);
+		return ZEST_FALSE;
+	}
+	//Counting sort of the corners by vertex, which keeps each vertex's triangles in index order
+	zest_uint corner_count = job->triangle_count * 3;
+	memset(job->vertex_corners, 0, (mesh->vertex_count + 1) * sizeof(zest_uint));
+	for (zest_uint i = 0; i != corner_count; ++i) {
+		ZEST_ASSERT(job->indexes[i] < mesh->vertex_count, "The mesh has an index to a vertex that doesn't exist.");
+		job->vertex_corners[job->indexes[i] + 1]++;
+	}
+	for (zest_uint v = 0; v != mesh->vertex_count; ++v) {
+		job->vertex_corners[v + 1] += job->vertex_corners[v];
+	}
+	for (zest_uint i = 0; i != corner_count; ++i) {
+		job->corners[job->vertex_corners[job->indexes[i]]++] = i;
+	}
+	for (zest_uint v = mesh->vertex_count; v != 0; --v) {
+		job->vertex_corners[v] = job->vertex_corners[v - 1];
+	}
+	job->vertex_corners[0] = 0;
+	return ZEST_TRUE;
+}
+
+void zest_CalculateMeshNormals(zest_mesh mesh, zest_uint position_offset, zest_uint normal_offset) {
+	ZEST_ASSERT_HANDLE(mesh);	//Not a valid mesh handle
+	ZEST_ASSERT(position_offset + sizeof(zest_vec3) <= mesh->vertex_struct_size && normal_offset + sizeof(zest_vec3) <= mesh->vertex_struct_size, "The position or normal offset is outside of the mesh's vertex struct.");
+	zest_device device = mesh->context->device;
+	zest_mesh_attribute_job_t job;
+	if (!zest__begin_mesh_attribute_job(mesh, &job, 3)) {
+		return;
+	}
+	job.position_offset = position_offset;
+	job.normal_offset = normal_offset;
+	zest_ParallelFor(device, job.face_stride / 4, ZEST_MESH_ATTRIBUTE_BATCH / 4, zest__mesh_face_normals, &job);
+	zest_ParallelFor(device, mesh->vertex_count, ZEST_MESH_ATTRIBUTE_BATCH, zest__mesh_vertex_normals, &job);
+	zest__end_mesh_attribute_job(mesh, &job);
+}
+
+void zest_CalculateMeshTangents(zest_mesh mesh, zest_uint position_offset, zest_uint normal_offset, zest_uint uv_offset, zest_uint tangent_offset, zest_format tangent_format) {
+	ZEST_ASSERT_HANDLE(mesh);	//Not a valid mesh handle
+	ZEST_ASSERT(tangent_format == zest_format_r32g32b32a32_sfloat || tangent_format == zest_format_r16g16b16a16_snorm, "Tangents can only be written as zest_format_r32g32b32a32_sfloat or zest_format_r16g16b16a16_snorm.");
+	ZEST_ASSERT(uv_offset + sizeof(zest_vec2) <= mesh->vertex_struct_size && tangent_offset + (tangent_format == zest_format_r16g16b16a16_snorm ? sizeof(zest_u64) : sizeof(zest_vec4)) <= mesh->vertex_struct_size, "The uv or tangent offset is outside of the mesh's vertex struct.");
+	zest_device device = mesh->context->device;
+	zest_mesh_attribute_job_t job;
+	if (!zest__begin_mesh_attribute_job(mesh, &job, 6)) {
+		return;
+	}
+	job.position_offset = position_offset;
+	job.normal_offset = normal_offset;
+	job.uv_offset = uv_offset;
+	job.tangent_offset = tangent_offset;
+	job.tangent_format = tangent_format;
+	zest_ParallelFor(device, job.face_stride / 4, ZEST_MESH_ATTRIBUTE_BATCH / 4, zest__mesh_face_tangents, &job);
+	zest_ParallelFor(device, mesh->vertex_count, ZEST_MESH_ATTRIBUTE_BATCH, zest__mesh_vertex_tangents, &job);
+	zest__end_mesh_attribute_job(mesh, &job);
+}
+
+zest_mesh zest_CreateSimplifiedMesh(zest_mesh mesh, zest_uint position_offset, float cell_size) {
+	ZEST_ASSERT_HANDLE(mesh);	//Not a valid mesh handle
+	ZEST_ASSERT(position_offset + sizeof(zest_vec3) <= mesh->vertex_struct_size, "The position offset is outside of the mesh's vertex struct.");
+	ZEST_ASSERT(cell_size > 0.f, "The cell size must be more than 0.");
+	zest_device device = mesh->context->device;
+	zest_mesh result = zest_NewMesh(mesh->context, mesh->vertex_struct_size);
+	zest_uint vertex_count = mesh->vertex_count;
+	zest_uint index_count = zest_MeshIndexCount(mesh);
+	if (!vertex_count || !index_count) {
+		return result;
+	}
+	zest_byte *vertices = (zest_byte*)mesh->vertex_data;
+	zest_size stride = mesh->vertex_struct_size;
+	zest_vec3 min_bounds;
+	memcpy(&min_bounds, vertices + position_offset, sizeof(zest_vec3));
+	for (zest_uint v = 1; v != vertex_count; ++v) {
+		zest_vec3 position;
+		memcpy(&position, vertices + v * stride + position_offset, sizeof(zest_vec3));
+		min_bounds = zest_Vec3Set(ZEST__MIN(min_bounds.x, position.x), ZEST__MIN(min_bounds.y, position.y), ZEST__MIN(min_bounds.z, position.z));
+	}
+
+	//Cells are found with an open addressing table that's at least twice the size of the vertex count
+	zest_uint table_size = 16;
+	while (table_size < vertex_count * 2) {
+		table_size <<= 1;
+	}
+	zest_u64 *cell_keys = (zest_u64*)ZEST__ALLOCATE(device->allocator, table_size * sizeof(zest_u64));
+	zest_uint *cell_clusters = (zest_uint*)ZEST__ALLOCATE(device->allocator, table_size * sizeof(zest_uint));
+	zest_uint *remap = (zest_uint*)ZEST__ALLOCATE(device->allocator, vertex_count * sizeof(zest_uint));
+	zest_uint *cluster_counts = (zest_uint*)ZEST__ALLOCATE(device->allocator, vertex_count * sizeof(zest_uint));
+	zest_vec3 *cluster_positions = (zest_vec3*)ZEST__ALLOCATE(device->allocator, vertex_count * sizeof(zest_vec3));
+	if (cell_keys && cell_clusters && remap && cluster_counts && cluster_positions) {
+		memset(cell_clusters, 0xFF, table_size * sizeof(zest_uint));
+		zest_uint cluster_count = 0;
+		for (zest_uint v = 0; v != vertex_count; ++v) {
+			zest_vec3 position;
+			memcpy(&position, vertices + v * stride + position_offset, sizeof(zest_vec3));
+			//21 bits for each axis
+			zest_u64 x = (zest_u64)((position.x - min_bounds.x) / cell_size) & 0x1FFFFF;
+			zest_u64 y = (zest_u64)((position.y - min_bounds.y) / cell_size) & 0x1FFFFF;
+			zest_u64 z = (zest_u64)((position.z - min_bounds.z) / cell_size) & 0x1FFFFF;
+			zest_u64 key = x | (y << 21) | (z << 42);
+			zest_uint slot = (zest_uint)((key * 0x9E3779B97F4A7C15ull) >> 32) & (table_size - 1);
+			while (cell_clusters[slot] != ZEST_INVALID && cell_keys[slot] != key) {
+				slot = (slot + 1) & (table_size - 1);
+			}
+			if (cell_clusters[slot] == ZEST_INVALID) {
+				cell_keys[slot] = key;
+				cell_clusters[slot] = cluster_count;
+				cluster_counts[cluster_count] = 0;
+				cluster_positions[cluster_count] = zest_Vec3Set(0.f, 0.f, 0.f);
+				zest_AppendMeshVertices(result, vertices + v * stride, 1);
+				cluster_count++;
+			}
+			zest_uint cluster = cell_clusters[slot];
+			remap[v] = cluster;
+			cluster_counts[cluster]++;
+			cluster_positions[cluster] = zest_AddVec3(cluster_positions[cluster], position);
+		}
+		for (zest_uint c = 0; c != cluster_count; ++c) {
+			zest_vec3 position = zest_ScaleVec3(cluster_positions[c], 1.f / (float)cluster_counts[c]);
+			memcpy((zest_byte*)result->vertex_data + c * stride + position_offset, &position, sizeof(zest_vec3));
+		}
+		zest_ReserveMeshIndexes(result, index_count);
+		for (zest_uint i = 0; i + 2 < index_count; i += 3) {
+			zest_uint triangle[3] = { remap[mesh->indexes[i]], remap[mesh->indexes[i + 1]], remap[mesh->indexes[i + 2]] };
+			if (triangle[0] != triangle[1] && triangle[1] != triangle[2] && triangle[0] != triangle[2]) {
+				zest_AppendMeshIndexes(result, triangle, 3, 0);
+			}
+		}
+	} else {
+		ZEST_REPORT(device, zest_report_memory, "Unable to allocate the scratch memory for simplifying a mesh with %u vertices.", vertex_count);
+	}
+	if (cell_keys) ZEST__FREE(device->allocator, cell_keys);
+	if (cell_clusters) ZEST__FREE(device->allocator, cell_clusters);
+	if (remap) ZEST__FREE(device->allocator, remap);
+	if (cluster_counts) ZEST__FREE(device->allocator, cluster_counts);
+	if (cluster_positions) ZEST__FREE(device->allocator, cluster_positions);
+	return result;
+}
+
+//-- Mesh pool
+//Meshes in an instance mesh layer are given ranges of the layer's vertex and index buffers. Freed ranges go on a
+//list sorted by offset and are merged with their neighbours, and a range at the end of the used space is given
+//back so that used_vertex_data and used_index_data are always the end of the last mesh.
+ZEST_PRIVATE zest_uint zest__mesh_pool_allocate(zest_mesh_pool_range_t **free_ranges, zest_size *used, zest_size unit_size, zest_size capacity, zest_uint count) {
+	zest_mesh_pool_range_t *ranges = *free_ranges;
+	zest_vec_foreach(i, ranges) {
+		zest_mesh_pool_range_t *range = &ranges[i];
+		if (range->count >= count) {
+			zest_uint offset = range->offset;
+			range->offset += count;
+			range->count -= count;
+			if (!range->count) {
+				zest_vec_erase(ranges, range);
+			}
+			return offset;
+		}
+	}
+	if (*used + count * unit_size > capacity) {
+		return ZEST_INVALID;
+	}
+	zest_uint offset = (zest_uint)(*used / unit_size);
+	*used += count * unit_size;
+	return offset;
+}
+
+ZEST_PRIVATE void zest__mesh_pool_release(zest_layer layer, zest_mesh_pool_range_t **free_ranges, zest_size *used, zest_size unit_size, zest_mesh_pool_range_t range) {
+	if (!range.count) return;
+	zest_mesh_pool_range_t *ranges = *free_ranges;
+	zest_uint i = 0;
+	while (i < zest_vec_size(ranges) && ranges[i].offset < range.offset) {
+		i++;
+	}
+	zest_vec_insert(layer->context->allocator, ranges, ranges + i, range);
+	if (i + 1 < zest_vec_size(ranges) && ranges[i].offset + ranges[i].count == ranges[i + 1].offset) {
+		ranges[i].count += ranges[i + 1].count;
+		zest_vec_erase(ranges, ranges + i + 1);
+	}
+	if (i > 0 && ranges[i - 1].offset + ranges[i - 1].count == ranges[i].offset) {
+		ranges[i - 1].count += ranges[i].count;
+		zest_vec_erase(ranges, ranges + i);
+	}
+	zest_mesh_pool_range_t last = zest_vec_back(ranges);
+	if ((last.offset + last.count) * unit_size == *used) {
+		*used = last.offset * unit_size;
+		zest_vec_pop(ranges);
+	}
+	*free_ranges = ranges;
+}
+
+//Ranges that were freed can still be read by frames in flight so they're only reused once those are done
+ZEST_PRIVATE void zest__release_pending_mesh_frees(zest_layer layer) {
+	zest_device device = layer->context->device;
+	zest_uint kept = 0;
+	zest_vec_foreach(i, layer->pending_mesh_frees) {
+		zest_mesh_pool_free_t *pending = &layer->pending_mesh_frees[i];
+		if (device->frame_counter - pending->frame < ZEST_MAX_FIF) {
+			layer->pending_mesh_frees[kept++] = *pending;
+			continue;
+		}
+		zest__mesh_pool_release(layer, &layer->free_vertex_ranges, &layer->used_vertex_data, layer->mesh_vertex_struct_size, pending->vertices);
+		zest__mesh_pool_release(layer, &layer->free_index_ranges, &layer->used_index_data, sizeof(zest_uint), pending->indexes);
+	}
+	if (layer->pending_mesh_frees) {
+		zest__vec_header(layer->pending_mesh_frees)->current_size = kept;
+	}
+}
+
+ZEST_PRIVATE void zest__free_mesh_ranges(zest_layer layer, zest_uint vertex_offset, zest_uint vertex_count, zest_uint index_offset, zest_uint index_count) {
+	zest_mesh_pool_free_t pending;
+	pending.vertices.offset = vertex_offset;
+	pending.vertices.count = vertex_count;
+	pending.indexes.offset = index_offset;
+	pending.indexes.count = index_count;
+	pending.frame = layer->context->device->frame_counter;
+	zest_vec_push(layer->context->allocator, layer->pending_mesh_frees, pending);
+}
+
+//Swap a mesh buffer for a bigger one with the used part copied over. The old buffer is freed once the frames
+//in flight are done with it.
+ZEST_PRIVATE zest_bool zest__grow_mesh_pool_buffer(zest_layer layer, zest_buffer *buffer, zest_buffer_type type, zest_size used, zest_size minimum_size) {
+	zest_device device = layer->context->device;
+	zest_size new_size = ZEST__MAX(minimum_size, (*buffer)->size + (*buffer)->size / 2);
+	zest_buffer_info_t buffer_info = zest_CreateBufferInfo(type, zest_memory_usage_gpu_only);
+	zest_buffer new_buffer = zest_CreateBuffer(device, new_size, &buffer_info);
+	if (!new_buffer) {
+		ZEST_REPORT(device, zest_report_layers, "Unable to grow a mesh buffer in layer [%s] to %llu bytes.", layer->name, (unsigned long long)new_size);
+		return ZEST_FALSE;
+	}
+	if (used) {
+		zest_queue queue = zest_imm_BeginCommandBuffer(device, zest_queue_transfer);
+		zest_imm_CopyBufferRegion(queue, *buffer, 0, new_buffer, 0, used);
+		zest_imm_EndCommandBuffer(queue);
+	}
+	zest_FreeBuffer(*buffer);
+	*buffer = new_buffer;
+	//The used part keeps the same offsets in the new buffer so indirect commands that point in to it are still right.
+	//Copies already recorded by the defragment pass went in to the old buffer so they're made again in the new one
+	layer->mesh_moves_recorded = ZEST_FALSE;
+	return ZEST_TRUE;
+}
+
+zest_bool zest_LayerHasMesh(zest_layer layer, zest_uint mesh_index) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	return mesh_index < zest_vec_size(layer->mesh_offsets) && !layer->mesh_offsets[mesh_index].is_free;
+}
+
+void zest_RemoveMeshFromLayer(zest_layer layer, zest_uint mesh_index) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	if (!zest_LayerHasMesh(layer, mesh_index)) {
+		ZEST_REPORT(layer->context->device, zest_report_layers, "Tried to remove mesh %u from layer [%s] but there's no mesh with that index.", mesh_index, layer->name);
+		return;
+	}
+	zest_mesh_offset_data_t *mesh = &layer->mesh_offsets[mesh_index];
+	zest__free_mesh_ranges(layer, mesh->vertex_offset, mesh->vertex_count, mesh->index_offset, mesh->index_count);
+	//Drop any move of the mesh that the defragment pass hasn't finished, the copy might still be writing its new range
+	zest_uint kept = 0;
+	zest_vec_foreach(i, layer->mesh_moves) {
+		zest_mesh_pool_move_t *move = &layer->mesh_moves[i];
+		if (move->mesh_index != mesh_index) {
+			layer->mesh_moves[kept++] = *move;
+		} else if (move->indexes) {
+			zest__free_mesh_ranges(layer, 0, 0, move->to, move->from.count);
+		} else {
+			zest__free_mesh_ranges(layer, move->to, move->from.count, 0, 0);
+		}
+	}
+	if (layer->mesh_moves) {
+		zest__vec_header(layer->mesh_moves)->current_size = kept;
+	}
+	*mesh = ZEST__ZERO_INIT(zest_mesh_offset_data_t);
+	mesh->cull_radius = -1.f;
+	mesh->is_free = ZEST_TRUE;
+	zest_vec_push(layer->context->allocator, layer->free_mesh_indexes, mesh_index);
+}
+
+//Find the lowest free range that a block of count units above it could move in to
+ZEST_PRIVATE zest_mesh_pool_range_t *zest__mesh_pool_lower_fit(zest_mesh_pool_range_t *free_ranges, zest_uint offset, zest_uint count) {
+	zest_vec_foreach(i, free_ranges) {
+		if (free_ranges[i].offset >= offset) break;
+		if (free_ranges[i].count >= count) return &free_ranges[i];
+	}
+	return NULL;
+}
+
+ZEST_PRIVATE zest_bool zest__mesh_is_moving(zest_layer layer, zest_uint mesh_index, zest_bool indexes) {
+	zest_vec_foreach(i, layer->mesh_moves) {
+		if (layer->mesh_moves[i].mesh_index == mesh_index && layer->mesh_moves[i].indexes == indexes) return ZEST_TRUE;
+	}
+	return ZEST_FALSE;
+}
+
+//Point the indirect commands that every frame in flight already has at the meshes' current ranges. Instructions
+//persist across frames in delta layers and instance stores so their commands would otherwise keep the old ranges
+//after they're freed. A frame still in flight that reads a command while it's being written draws the same geometry
+//either way because the old ranges hold the same data until the pending frees are released.
+ZEST_PRIVATE void zest__update_layer_mesh_indirect_commands(zest_layer layer) {
+	if (ZEST__NOT_FLAGGED(layer->flags, zest_layer_flag_multi_draw_indirect)) {
+		return;
+	}
+	zest_ForEachFrameInFlight(fif) {
+		zest_layer_buffers_t *buffers = &layer->memory_refs[fif];
+		if (!buffers->indirect_commands) continue;
+		zest_draw_indexed_indirect_command_t *commands = (zest_draw_indexed_indirect_command_t *)zest_BufferData(buffers->indirect_commands);
+		zest_vec_foreach(i, layer->draw_instructions[fif]) {
+			//Commands past the capacity were never written
+			if (i >= buffers->indirect_capacity) break;
+			zest_layer_instruction_t *instruction = &layer->draw_instructions[fif][i];
+			if (instruction->draw_mode == zest_draw_mode_viewport || instruction->mesh_index >= zest_vec_size(layer->mesh_offsets)) continue;
+			zest_mesh_offset_data_t *mesh = &layer->mesh_offsets[instruction->mesh_index];
+			if (mesh->is_free) continue;
+			commands[i].first_index = mesh->index_offset;
+			commands[i].vertex_offset = (int32_t)mesh->vertex_offset;
+		}
+	}
+}
+
+//Once the frames in flight have finished the copies recorded by the defragment pass, the meshes are pointed at their
+//new ranges. Frames recorded before now can still be drawing from the old ranges so those wait as well.
+void zest__complete_mesh_moves(zest_layer layer) {
+	zest_device device = layer->context->device;
+	if (!layer->mesh_moves_recorded || device->frame_counter - layer->mesh_moves_frame < ZEST_MAX_FIF) {
+		return;
+	}
+	zest_vec_foreach(i, layer->mesh_moves) {
+		zest_mesh_pool_move_t *move = &layer->mesh_moves[i];
+		zest_mesh_offset_data_t *mesh = &layer->mesh_offsets[move->mesh_index];
+		if (move->indexes) {
+			zest__free_mesh_ranges(layer, 0, 0, mesh->index_offset, mesh->index_count);
+			mesh->index_offset = move->to;
+		} else {
+			zest__free_mesh_ranges(layer, mesh->vertex_offset, mesh->vertex_count, 0, 0);
+			mesh->vertex_offset = move->to;
+		}
+	}
+	zest__update_layer_mesh_indirect_commands(layer);
+	zest_vec_clear(layer->mesh_moves);
+	layer->mesh_moves_recorded = ZEST_FALSE;
+}
+
+zest_size zest_DefragmentLayerMeshes(zest_layer layer, zest_size max_bytes) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	zest__complete_mesh_moves(layer);
+	zest__release_pending_mesh_frees(layer);
+	if (zest_vec_size(layer->mesh_moves)) {
+		//The last batch hasn't been copied yet
+		return 0;
+	}
+	if (!zest_vec_size(layer->free_vertex_ranges) && !zest_vec_size(layer->free_index_ranges)) {
+		return 0;
+	}
+	zloc_allocator *allocator = layer->context->allocator;
+	zest_size vertex_size = layer->mesh_vertex_struct_size;
+	zest_size moved = 0;
+	//Plan moves of the highest meshes in to the lowest gaps. The new ranges are reserved now and the copies are made
+	//by the defragment pass, the meshes keep drawing from where they are until zest__complete_mesh_moves.
+	while (moved < max_bytes) {
+		zest_uint vertex_mesh = ZEST_INVALID, index_mesh = ZEST_INVALID;
+		zest_vec_foreach(i, layer->mesh_offsets) {
+			zest_mesh_offset_data_t *mesh = &layer->mesh_offsets[i];
+			if (mesh->is_free) continue;
+			if (mesh->vertex_count && (vertex_mesh == ZEST_INVALID || mesh->vertex_offset > layer->mesh_offsets[vertex_mesh].vertex_offset) &&
+				!zest__mesh_is_moving(layer, i, ZEST_FALSE) && zest__mesh_pool_lower_fit(layer->free_vertex_ranges, mesh->vertex_offset, mesh->vertex_count)) {
+				vertex_mesh = i;
+			}
+			if (mesh->index_count && (index_mesh == ZEST_INVALID || mesh->index_offset > layer->mesh_offsets[index_mesh].index_offset) &&
+				!zest__mesh_is_moving(layer, i, ZEST_TRUE) && zest__mesh_pool_lower_fit(layer->free_index_ranges, mesh->index_offset, mesh->index_count)) {
+				index_mesh = i;
+			}
+		}
+		if (vertex_mesh == ZEST_INVALID && index_mesh == ZEST_INVALID) break;
+		//The first fit is the lowest free range so it's always below the mesh being moved
+		if (vertex_mesh != ZEST_INVALID) {
+			zest_mesh_offset_data_t *mesh = &layer->mesh_offsets[vertex_mesh];
+			zest_mesh_pool_move_t move = { vertex_mesh, { mesh->vertex_offset, mesh->vertex_count }, 0, ZEST_FALSE };
+			move.to = zest__mesh_pool_allocate(&layer->free_vertex_ranges, &layer->used_vertex_data, vertex_size, layer->vertex_data->size, mesh->vertex_count);
+			zest_vec_push(allocator, layer->mesh_moves, move);
+			moved += mesh->vertex_count * vertex_size;
+		}
+		if (index_mesh != ZEST_INVALID) {
+			zest_mesh_offset_data_t *mesh = &layer->mesh_offsets[index_mesh];
+			zest_mesh_pool_move_t move = { index_mesh, { mesh->index_offset, mesh->index_count }, 0, ZEST_TRUE };
+			move.to = zest__mesh_pool_allocate(&layer->free_index_ranges, &layer->used_index_data, sizeof(zest_uint), layer->index_data->size, mesh->index_count);
+			zest_vec_push(allocator, layer->mesh_moves, move);
+			moved += mesh->index_count * sizeof(zest_uint);
+		}
+	}
+	return moved;
+}
+
+zest_buffer zest__layer_mesh_vertices_provider(zest_context context, zest_resource_node resource) {
+	zest_layer layer = (zest_layer)resource->user_data;
+	resource->buffer_desc.size = layer->vertex_data->size;
+	return layer->vertex_data;
+}
+
+zest_buffer zest__layer_mesh_indexes_provider(zest_context context, zest_resource_node resource) {
+	zest_layer layer = (zest_layer)resource->user_data;
+	resource->buffer_desc.size = layer->index_data->size;
+	return layer->index_data;
+}
+
+void zest__layer_mesh_defragment_task(const zest_command_list command_list, void *user_data) {
+	zest_layer layer = (zest_layer)user_data;
+	if (!zest_vec_size(layer->mesh_moves) || layer->mesh_moves_recorded) {
+		return;
+	}
+	zest_context context = command_list->context;
+	zest_size vertex_size = layer->mesh_vertex_struct_size;
+	//The new ranges were free so nothing in flight reads them, and they never overlap the ranges being copied
+	zest_buffer_uploader_t vertex_moves = { 0, layer->vertex_data, layer->vertex_data, 0 };
+	zest_buffer_uploader_t index_moves = { 0, layer->index_data, layer->index_data, 0 };
+	zest_vec_foreach(i, layer->mesh_moves) {
+		zest_mesh_pool_move_t *move = &layer->mesh_moves[i];
+		if (move->indexes) {
+			zest_AddCopyCommandRegion(context, &index_moves, layer->index_data, layer->index_data, move->from.offset * sizeof(zest_uint), move->to * sizeof(zest_uint), move->from.count * sizeof(zest_uint));
+		} else {
+			zest_AddCopyCommandRegion(context, &vertex_moves, layer->vertex_data, layer->vertex_data, move->from.offset * vertex_size, move->to * vertex_size, move->from.count * vertex_size);
+		}
+	}
+	zest_cmd_UploadBuffer(command_list, &vertex_moves);
+	zest_cmd_UploadBuffer(command_list, &index_moves);
+	layer->mesh_moves_recorded = ZEST_TRUE;
+	layer->mesh_moves_frame = context->device->frame_counter;
+}
+
+zest_pass_node zest_AddLayerMeshDefragmentPass(zest_layer layer) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+    ZEST_ASSERT_HANDLE(zest__frame_graph_builder->frame_graph);        //This function must be called within a Begin/EndFrameGraph block
+	zest_context context = zest__frame_graph_builder->context;
+    ZEST_ASSERT_OR_VALIDATE(layer->vertex_data && layer->index_data, context->device,
+							"zest_AddLayerMeshDefragmentPass is only for instance mesh layers, create the layer with zest_CreateInstanceMeshLayer.", NULL);
+	zest_resource_node vertices = zest_ImportBufferResource("Layer Mesh Vertices", layer->vertex_data, zest__layer_mesh_vertices_provider);
+	vertices->user_data = layer;
+	zest_resource_node indexes = zest_ImportBufferResource("Layer Mesh Indexes", layer->index_data, zest__layer_mesh_indexes_provider);
+	indexes->user_data = layer;
+	zest_pass_node pass = zest_BeginTransferPass("Layer Mesh Defragment");
+	zest_ConnectOutput(vertices);
+	zest_ConnectOutput(indexes);
+	zest_SetPassTask(zest__layer_mesh_defragment_task, layer);
+	zest_DoNotCull();
+	zest_EndPass();
+	return pass;
+}
+
+zest_layer_mesh_pool_stats_t zest_GetLayerMeshPoolStats(zest_layer layer) {
+	ZEST_ASSERT_HANDLE(layer); //ERROR: Not a valid layer pointer
+	zest_layer_mesh_pool_stats_t stats = ZEST__ZERO_INIT(zest_layer_mesh_pool_stats_t);
+	stats.vertex_capacity = layer->vertex_data ? layer->vertex_data->size : 0;
+	stats.index_capacity = layer->index_data ? layer->index_data->size : 0;
+	stats.vertex_used = layer->used_vertex_data;
+	stats.index_used = layer->used_index_data;
+	zest_vec_foreach(i, layer->free_vertex_ranges) {
+		stats.vertex_free += layer->free_vertex_ranges[i].count * layer->mesh_vertex_struct_size;
+	}
+	zest_vec_foreach(i, layer->free_index_ranges) {
+		stats.index_free += layer->free_index_ranges[i].count * sizeof(zest_uint);
+	}
+	stats.vertex_free_ranges = zest_vec_size(layer->free_vertex_ranges);
+	stats.index_free_ranges = zest_vec_size(layer->free_index_ranges);
+	stats.pending_frees = zest_vec_size(layer->pending_mesh_frees);
+	zest_vec_foreach(i, layer->mesh_offsets) {
+		stats.mesh_count += !layer->mesh_offsets[i].is_free;
+	}
+	return stats;
+}
+//-- End Mesh pool
+
 zest_uint zest_AddMeshToLayer(zest_layer layer, zest_mesh src_mesh, zest_uint texture_index) {
 	ZEST_ASSERT_HANDLE(layer); 			//ERROR: Not a valid layer pointer
 	ZEST_ASSERT(layer->vertex_data);	//ERROR: No vertex buffer found. Make sure you call zest_CreateInstanceMeshLayer with appropriate capacity
 	ZEST_ASSERT(layer->index_data); 	//ERROR: No index buffer found. Make sure you call zest_CreateInstanceMeshLayer with appropriate capacity
 	zest_device device = layer->context->device;
+	if (!layer->mesh_vertex_struct_size) {
+		layer->mesh_vertex_struct_size = src_mesh->vertex_struct_size;
+	}
+	ZEST_ASSERT(src_mesh->vertex_struct_size == layer->mesh_vertex_struct_size, "All the meshes in a layer must use the same vertex struct.");
+	zest_uint vertex_count = zest_MeshVertexCount(src_mesh);
+	zest_uint index_count = zest_MeshIndexCount(src_mesh);
 	zest_size src_mesh_vertex_size = zest_MeshVertexDataSize(src_mesh);
 	zest_size src_mesh_index_size = zest_MeshIndexDataSize(src_mesh);
-	ZEST_ASSERT(layer->vertex_data->size - layer->used_vertex_data >= src_mesh_vertex_size, "Not enough space left in the layer vertex buffer to add this mesh data.");
-	ZEST_ASSERT(layer->index_data->size - layer->used_index_data >= src_mesh_index_size, "Not enough space left in the layer index buffer to add this mesh data.");
+	zest__complete_mesh_moves(layer);
+	zest__release_pending_mesh_frees(layer);
+	zest_uint vertex_offset = zest__mesh_pool_allocate(&layer->free_vertex_ranges, &layer->used_vertex_data, layer->mesh_vertex_struct_size, layer->vertex_data->size, vertex_count);
+	if (vertex_offset == ZEST_INVALID) {
+		if (!zest__grow_mesh_pool_buffer(layer, &layer->vertex_data, zest_buffer_type_vertex, layer->used_vertex_data, layer->used_vertex_data + src_mesh_vertex_size)) {
+			return ZEST_INVALID;
+		}
+		vertex_offset = zest__mesh_pool_allocate(&layer->free_vertex_ranges, &layer->used_vertex_data, layer->mesh_vertex_struct_size, layer->vertex_data->size, vertex_count);
+	}
+	zest_uint index_offset = zest__mesh_pool_allocate(&layer->free_index_ranges, &layer->used_index_data, sizeof(zest_uint), layer->index_data->size, index_count);
+	if (index_offset == ZEST_INVALID) {
+		if (!zest__grow_mesh_pool_buffer(layer, &layer->index_data, zest_buffer_type_index, layer->used_index_data, layer->used_index_data + src_mesh_index_size)) {
+			//Nothing has been written to the vertex range so it can be given straight back
+			zest_mesh_pool_range_t vertex_range = { vertex_offset, vertex_count };
+			zest__mesh_pool_release(layer, &layer->free_vertex_ranges, &layer->used_vertex_data, layer->mesh_vertex_struct_size, vertex_range);
+			return ZEST_INVALID;
+		}
+		index_offset = zest__mesh_pool_allocate(&layer->free_index_ranges, &layer->used_index_data, sizeof(zest_uint), layer->index_data->size, index_count);
+	}
     zest_buffer vertex_staging_buffer = zest_CreateDedicatedStagingBuffer(device, src_mesh_vertex_size, src_mesh->vertex_data);
     zest_buffer index_staging_buffer = zest_CreateDedicatedStagingBuffer(device, src_mesh_index_size, src_mesh->indexes);
 	zest_queue queue = zest_imm_BeginCommandBuffer(device, zest_queue_transfer);
-    zest_imm_CopyBufferRegion(queue, vertex_staging_buffer, 0, layer->vertex_data, layer->used_vertex_data, src_mesh_vertex_size);
-    zest_imm_CopyBufferRegion(queue, index_staging_buffer, 0, layer->index_data, layer->used_index_data, src_mesh_index_size);
+    zest_imm_CopyBufferRegion(queue, vertex_staging_buffer, 0, layer->vertex_data, vertex_offset * layer->mesh_vertex_struct_size, src_mesh_vertex_size);
+    zest_imm_CopyBufferRegion(queue, index_staging_buffer, 0, layer->index_data, index_offset * sizeof(zest_uint), src_mesh_index_size);
 	zest_imm_EndCommandBuffer(queue);
-	zest_mesh_offset_data_t last_mesh_offsets = ZEST__ZERO_INIT(zest_mesh_offset_data_t);
-	if (zest_vec_size(layer->mesh_offsets)) {
-		last_mesh_offsets = zest_vec_back(layer->mesh_offsets);
-	}
-	zest_mesh_offset_data_t offset_data = {
-		last_mesh_offsets.vertex_offset + last_mesh_offsets.vertex_count,
-		last_mesh_offsets.index_offset + last_mesh_offsets.index_count,
-		zest_MeshVertexCount(src_mesh),
-		zest_MeshIndexCount(src_mesh),
-		texture_index
-	};
-	zest_uint index = zest_vec_size(layer->mesh_offsets);
-	zest_vec_push(layer->context->allocator, layer->mesh_offsets, offset_data);
-	layer->used_vertex_data += src_mesh_vertex_size;
-	layer->used_index_data += src_mesh_index_size;
+	zest_mesh_offset_data_t offset_data = ZEST__ZERO_INIT(zest_mesh_offset_data_t);
+	offset_data.vertex_offset = vertex_offset;
+	offset_data.index_offset = index_offset;
+	offset_data.vertex_count = vertex_count;
+	offset_data.index_count = index_count;
+	offset_data.texture_index = texture_index;
+	offset_data.cull_radius = -1.f;
+	zest_uint index;
+	if (zest_vec_size(layer->free_mesh_indexes)) {
+		index = zest_vec_pop(layer->free_mesh_indexes);
+		layer->mesh_offsets[index] = offset_data;
+	} else {
+		index = zest_vec_size(layer->mesh_offsets);
+		zest_vec_push(layer->context->allocator, layer->mesh_offsets, offset_data);
+	}
     zest_FreeBufferNow(vertex_staging_buffer);
     zest_FreeBufferNow(index_staging_buffer);
 	return index;
@@ -21518,6 +27750,20 @@ void zest_EnableCPUProfiling(zest_context context, zest_bool enabled) {
 	}
 }
 
+void zest_EnableParallelRecording(zest_context context, zest_bool enabled) {
+	ZEST_ASSERT_HANDLE(context);	//Not a valid context handle
+	if (enabled) {
+		ZEST__FLAG(context->flags, zest_context_flag_parallel_recording);
+	} else {
+		ZEST__UNFLAG(context->flags, zest_context_flag_parallel_recording);
+	}
+}
+
+zest_bool zest_ParallelRecordingEnabled(zest_context context) {
+	ZEST_ASSERT_HANDLE(context);	//Not a valid context handle
+	return ZEST__FLAGGED(context->flags, zest_context_flag_parallel_recording) ? ZEST_TRUE : ZEST_FALSE;
+}
+
 void zest__draw_cpu_profile_overlay(zest_context context) {
 	zest_cpu_profiler_t *profiler = &context->cpu_profiler;
 	if (!profiler->enabled || profiler->smoothed_count == 0) return;
@@ -21749,6 +27995,13 @@ void zest_cmd_DrawIndexedIndirect(const zest_command_list command_list, zest_buf
 	command_list->context->device->platform->draw_indexed_indirect(command_list, buffer, offset, draw_count, stride);
 }
 
+void zest_cmd_DrawIndexedIndirectCount(const zest_command_list command_list, zest_buffer buffer, zest_size offset, zest_buffer count_buffer, zest_size count_offset, zest_uint max_draw_count, zest_uint stride) {
+	ZEST_ASSERT(buffer && count_buffer, "Src buffer is NULL. If the resource node your creating ends up creating a 0 sized buffer then buffer will be NULL. Use zest_ResourceBufferIsValid to check before calling functions that use the buffer first and early exit or do something else.");
+    ZEST_ASSERT_HANDLE(command_list);        //Not valid command_list, this command must be called within a frame graph execution callback
+	ZEST_ASSERT(zest_DeviceFeatureEnabled(command_list->context->device, zest_capability_draw_indirect_count), "Drawing with a count buffer needs zest_capability_draw_indirect_count which isn't enabled on this device.");
+	command_list->context->device->platform->draw_indexed_indirect_count(command_list, buffer, offset, count_buffer, count_offset, max_draw_count, stride);
+}
+
 void zest_cmd_DrawIndirect(const zest_command_list command_list, zest_buffer buffer, zest_size offset, zest_uint draw_count, zest_uint stride) {
 	ZEST_ASSERT(buffer, "Src buffer is NULL. If the resource node your creating ends up creating a 0 sized buffer then buffer will be NULL. Use zest_ResourceBufferIsValid to check before calling functions that use the buffer first and early exit or do something else.");
     ZEST_ASSERT_HANDLE(command_list);        //Not valid command_list, this command must be called within a frame graph execution callback
@@ -122,6 +122,64 @@ ZEST_PRIVATE int64_t zest__tinyktxCallbackTell(void *user);
 ZEST_API zest_image_collection_t zest__load_ktx(zest_device device, const char *file_path);
 ZEST_API zest_image_handle zest_LoadKTX(zest_device device, const char *name, const char *file_name);
 
+//KTX2 files are parsed directly (tinyktx only reads KTX1) and every mip level stored in the file is uploaded as is
+//with zest_CreateImageWithMipChain, so block compressed textures keep their pre-built mips and nothing is blitted
+//at load time. Levels that are supercompressed (zstd/zlib) or stored in a universal format (Basis ETC1S/UASTC)
+//are handed to a transcoder callback that you supply, usually a thin wrapper around the basisu transcoder and
+//zstd. Levels are transcoded in parallel on the device job system, one job per level.
+typedef enum zest_ktx2_supercompression {
+	zest_ktx2_supercompression_none = 0,
+	zest_ktx2_supercompression_basis_lz = 1,
+	zest_ktx2_supercompression_zstd = 2,
+	zest_ktx2_supercompression_zlib = 3,
+} zest_ktx2_supercompression;
+
+typedef enum zest_ktx2_source {
+	zest_ktx2_source_raw = 0,				//Level data is in the file's vkFormat, maybe supercompressed
+	zest_ktx2_source_etc1s,					//Basis ETC1S, always with BasisLZ supercompression
+	zest_ktx2_source_uastc,					//Basis UASTC, maybe with zstd supercompression
+} zest_ktx2_source;
+
+typedef struct zest_ktx2_transcode_job_t {
+	zest_uint mip_level;
+	zest_uint width;						//Pixel size of this mip level
+	zest_uint height;
+	zest_uint layer_count;					//Array layers * cube faces stored in the level
+	zest_ktx2_source source;
+	zest_ktx2_supercompression supercompression;
+	zest_format src_format;					//The vkFormat in the file, undefined for ETC1S and UASTC
+	const zest_byte *src;					//The level data exactly as it's stored in the file
+	zest_size src_size;
+	zest_size uncompressed_size;			//uncompressedByteLength from the level index
+	const zest_byte *global_data;			//Supercompression global data (BasisLZ codebooks and image descs), or 0
+	zest_size global_data_size;
+	zest_format dst_format;
+	zest_byte *dst;							//Write the level here, all layers tightly packed
+	zest_size dst_size;
+	zest_uint worker_index;					//The job worker running the transcode for per worker scratch memory
+} zest_ktx2_transcode_job_t;
+
+//Called from job threads, so it must be thread safe. Return ZEST_FALSE if the level couldn't be transcoded.
+typedef zest_bool (*zest_ktx2_transcoder)(const zest_ktx2_transcode_job_t *job, void *user_data);
+
+//Use zest_CreateKTX2LoadInfo to get the defaults.
+typedef struct zest_ktx2_load_info_t {
+	zest_ktx2_transcoder transcoder;		//Needed for supercompressed and Basis files, raw files load without one
+	void *user_data;
+	zest_format target_format;				//What ETC1S/UASTC transcode to. Undefined picks with zest_ChooseTranscodeFormat
+	zest_image_flags image_flags;
+} zest_ktx2_load_info_t;
+
+ZEST_PRIVATE zest_bool zest__is_ktx2_file(const char *file_path);
+ZEST_PRIVATE void zest__ktx2_transcode_levels(void *data, zest_uint begin, zest_uint end, zest_uint worker_index);
+ZEST_API zest_ktx2_load_info_t zest_CreateKTX2LoadInfo(void);
+//The best format the device can sample that a universal texture can be transcoded to: BC7 first, then BC3 (alpha)
+//or BC1, then ASTC 4x4 and ETC2, and finally uncompressed RGBA if the device has no block compression at all.
+ZEST_API zest_format zest_ChooseTranscodeFormat(zest_device device, zest_bool has_alpha, zest_bool srgb);
+ZEST_API zest_image_collection_t zest__load_ktx2(zest_device device, const char *file_path, const zest_ktx2_load_info_t *info);
+//Load a KTX2 file and upload all of its mip levels. zest_LoadKTX forwards KTX2 files here with the default info.
+ZEST_API zest_image_handle zest_LoadKTX2(zest_device device, const char *name, const char *file_name, const zest_ktx2_load_info_t *info);
+
 //MSDF header
 typedef enum zest_character_flag_bits {
 	zest_character_flag_none = 0,
@@ -291,6 +349,8 @@ ZEST_API zest_matrix4 zest_RotateMesh(zest_mesh mesh, float pitch, float yaw, fl
 ZEST_API zest_matrix4 zest_TransformMesh(zest_mesh mesh, float pitch, float yaw, float roll, float x, float y, float z, float sx, float sy, float sz);
 //Calculate normals for a mesh (requires zest_vertex_t format)
 ZEST_API void zest_CalculateNormals(zest_mesh mesh);
+//Calculate tangents for a mesh after its normals, see zest_CalculateMeshTangents (requires zest_vertex_t format)
+ZEST_API void zest_CalculateTangents(zest_mesh mesh);
 //Calculate the bounding box of a mesh (requires zest_vertex_t format)
 ZEST_API zest_bounding_box_t zest_GetMeshBoundingBox(zest_mesh mesh);
 //Set the group id for every vertex in the mesh (requires zest_vertex_t format)
@@ -696,6 +756,10 @@ zest_image_collection_t zest__load_ktx(zest_device device, const char *file_path
 }
 
 zest_image_handle zest_LoadKTX(zest_device device, const char *name, const char *file_name) {
+	if (zest__is_ktx2_file(file_name)) {
+		zest_ktx2_load_info_t ktx2_info = zest_CreateKTX2LoadInfo();
+		return zest_LoadKTX2(device, name, file_name, &ktx2_info);
+	}
     zest_image_collection_t image_collection = zest__load_ktx(device, file_name);
 
     if (!(image_collection.flags & zest_image_collection_flag_initialised)) {
@@ -768,6 +832,262 @@ zest_image_handle zest_LoadKTX(zest_device device, const char *name, const char
 	zest_FreeImageCollection(&image_collection);
     return ZEST__ZERO_INIT(zest_image_handle);
 }
+
+#define ZEST__KTX2_HEADER_SIZE 80
+#define ZEST__KTX2_LEVEL_INDEX_SIZE 24
+#define ZEST__KTX2_DF_MODEL_ETC1S 163
+#define ZEST__KTX2_DF_MODEL_UASTC 166
+#define ZEST__KTX2_DF_TRANSFER_SRGB 2
+//Array layers * faces that a KTX2 file can have, the Vulkan limit on most desktop GPUs
+#define ZEST__KTX2_MAX_LAYERS 2048
+
+static const zest_byte zest__ktx2_identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+typedef struct zest_ktx2_transcode_context_t {
+	zest_ktx2_transcode_job_t jobs[ZEST_MAX_IMAGE_MIP_LEVELS];
+	zest_bool results[ZEST_MAX_IMAGE_MIP_LEVELS];
+	zest_ktx2_transcoder transcoder;
+	void *user_data;
+} zest_ktx2_transcode_context_t;
+
+static zest_uint zest__ktx2_u32(const zest_byte *data) {
+	zest_uint value;
+	memcpy(&value, data, sizeof(zest_uint));
+	return value;
+}
+
+static zest_u64 zest__ktx2_u64(const zest_byte *data) {
+	zest_u64 value;
+	memcpy(&value, data, sizeof(zest_u64));
+	return value;
+}
+
+zest_bool zest__is_ktx2_file(const char *file_path) {
+	FILE *file = zest__open_file(file_path, "rb");
+	if (!file) return ZEST_FALSE;
+	zest_byte identifier[12];
+	zest_bool is_ktx2 = fread(identifier, 1, sizeof(identifier), file) == sizeof(identifier) &&
+		memcmp(identifier, zest__ktx2_identifier, sizeof(identifier)) == 0;
+	fclose(file);
+	return is_ktx2;
+}
+
+void zest__ktx2_transcode_levels(void *data, zest_uint begin, zest_uint end, zest_uint worker_index) {
+	zest_ktx2_transcode_context_t *context = (zest_ktx2_transcode_context_t*)data;
+	for (zest_uint i = begin; i != end; ++i) {
+		zest_ktx2_transcode_job_t *job = &context->jobs[i];
+		job->worker_index = worker_index;
+		if (job->source == zest_ktx2_source_raw && job->supercompression == zest_ktx2_supercompression_none) {
+			//Already in the upload format, the transcoder doesn't need to see it.
+			memcpy(job->dst, job->src, job->dst_size);
+			context->results[i] = ZEST_TRUE;
+		} else {
+			context->results[i] = context->transcoder(job, context->user_data);
+		}
+	}
+}
+
+zest_ktx2_load_info_t zest_CreateKTX2LoadInfo(void) {
+	zest_ktx2_load_info_t info = ZEST__ZERO_INIT(zest_ktx2_load_info_t);
+	info.image_flags = zest_image_preset_texture;
+	return info;
+}
+
+zest_format zest_ChooseTranscodeFormat(zest_device device, zest_bool has_alpha, zest_bool srgb) {
+	static const zest_format alpha_formats[2][5] = {
+		{ zest_format_bc7_unorm_block, zest_format_bc3_unorm_block, zest_format_astc_4X4_unorm_block, zest_format_etc2_r8g8b8a8_unorm_block, zest_format_r8g8b8a8_unorm },
+		{ zest_format_bc7_srgb_block, zest_format_bc3_srgb_block, zest_format_astc_4X4_srgb_block, zest_format_etc2_r8g8b8a8_srgb_block, zest_format_r8g8b8a8_srgb },
+	};
+	static const zest_format opaque_formats[2][5] = {
+		{ zest_format_bc7_unorm_block, zest_format_bc1_rgb_unorm_block, zest_format_astc_4X4_unorm_block, zest_format_etc2_r8g8b8_unorm_block, zest_format_r8g8b8a8_unorm },
+		{ zest_format_bc7_srgb_block, zest_format_bc1_rgb_srgb_block, zest_format_astc_4X4_srgb_block, zest_format_etc2_r8g8b8_srgb_block, zest_format_r8g8b8a8_srgb },
+	};
+	const zest_format *candidates = has_alpha ? alpha_formats[srgb ? 1 : 0] : opaque_formats[srgb ? 1 : 0];
+	for (int i = 0; i != 5; ++i) {
+		if (zest_IsImageFormatSupported(device, candidates[i], zest_image_preset_texture)) {
+			return candidates[i];
+		}
+	}
+	return zest_format_undefined;
+}
+
+zest_image_collection_t zest__load_ktx2(zest_device device, const char *file_path, const zest_ktx2_load_info_t *info) {
+	zest_image_collection_t image_collection = ZEST__ZERO_INIT(zest_image_collection_t);
+	zest_file file = zest_ReadEntireFile(device, file_path, ZEST_FALSE);
+	if (!file) {
+		ZEST_PRINT("Failed to open KTX2 file: %s", file_path);
+		return image_collection;
+	}
+	const zest_byte *data = (const zest_byte*)file;
+	zest_size file_size = zest_vec_size(file);
+	if (file_size < ZEST__KTX2_HEADER_SIZE || memcmp(data, zest__ktx2_identifier, sizeof(zest__ktx2_identifier)) != 0) {
+		ZEST_PRINT("Not a KTX2 file: %s", file_path);
+		zest_FreeFile(device, file);
+		return image_collection;
+	}
+
+	zest_format file_format = (zest_format)zest__ktx2_u32(data + 12);
+	zest_uint width = zest__ktx2_u32(data + 20);
+	zest_uint height = ZEST__MAX(zest__ktx2_u32(data + 24), 1u);
+	zest_uint depth = ZEST__MAX(zest__ktx2_u32(data + 28), 1u);
+	zest_uint array_layers = zest__ktx2_u32(data + 32);
+	zest_uint face_count = zest__ktx2_u32(data + 36);
+	//A level count of 0 asks the loader to generate mips, we only upload what's in the file.
+	zest_uint level_count = ZEST__MAX(zest__ktx2_u32(data + 40), 1u);
+	zest_ktx2_supercompression supercompression = (zest_ktx2_supercompression)zest__ktx2_u32(data + 44);
+	zest_uint dfd_offset = zest__ktx2_u32(data + 48);
+	zest_uint dfd_length = zest__ktx2_u32(data + 52);
+	zest_u64 sgd_offset = zest__ktx2_u64(data + 64);
+	zest_u64 sgd_length = zest__ktx2_u64(data + 72);
+	const zest_byte *level_index = data + ZEST__KTX2_HEADER_SIZE;
+
+	//Image collections don't carry a depth so 3D textures aren't loaded. The size limits keep the level sizes
+	//worked out from the header well inside a zest_size. Offsets are checked as offset <= size and
+	//length <= size - offset so that a huge offset or length can't wrap around.
+	zest_uint max_dimension = 1u << (ZEST_MAX_IMAGE_MIP_LEVELS - 1);
+	zest_bool valid = width > 0 && width <= max_dimension && height <= max_dimension && depth == 1 &&
+		level_count <= ZEST_MAX_IMAGE_MIP_LEVELS && (face_count == 1 || face_count == 6) &&
+		array_layers <= ZEST__KTX2_MAX_LAYERS / face_count &&
+		ZEST__KTX2_HEADER_SIZE + (zest_size)level_count * ZEST__KTX2_LEVEL_INDEX_SIZE <= file_size &&
+		dfd_offset <= file_size && dfd_length <= file_size - dfd_offset &&
+		sgd_offset <= file_size && sgd_length <= file_size - sgd_offset;
+	for (zest_uint i = 0; valid && i != level_count; ++i) {
+		zest_u64 level_offset = zest__ktx2_u64(level_index + i * ZEST__KTX2_LEVEL_INDEX_SIZE);
+		zest_u64 level_length = zest__ktx2_u64(level_index + i * ZEST__KTX2_LEVEL_INDEX_SIZE + 8);
+		valid = level_offset <= file_size && level_length <= file_size - level_offset;
+	}
+	if (!valid) {
+		ZEST_PRINT("KTX2 file has an invalid header or level index: %s", file_path);
+		zest_FreeFile(device, file);
+		return image_collection;
+	}
+	zest_uint layer_count = ZEST__MAX(array_layers, 1u) * face_count;
+
+	//Universal textures have no vkFormat, the data format descriptor says which one it is.
+	zest_ktx2_source source = zest_ktx2_source_raw;
+	zest_bool has_alpha = ZEST_FALSE;
+	zest_bool srgb = ZEST_FALSE;
+	if (file_format == zest_format_undefined && dfd_length >= 28) {
+		const zest_byte *block = data + dfd_offset + 4;
+		zest_uint color_model = block[8];
+		srgb = block[10] == ZEST__KTX2_DF_TRANSFER_SRGB;
+		zest_uint block_size = zest__ktx2_u32(block + 4) >> 16;
+		zest_uint sample_count = block_size > 24 ? (block_size - 24) / 16 : 0;
+		if (color_model == ZEST__KTX2_DF_MODEL_ETC1S) {
+			source = zest_ktx2_source_etc1s;
+		} else if (color_model == ZEST__KTX2_DF_MODEL_UASTC) {
+			source = zest_ktx2_source_uastc;
+		}
+		for (zest_uint i = 0; i != sample_count && 28 + (i + 1) * 16 <= dfd_length; ++i) {
+			zest_uint channel = block[24 + i * 16 + 3] & 0xF;
+			//ETC1S stores alpha in an AAA (15) or GGG (4) slice, UASTC uses RGBA (3) or RRRG (5) channel ids.
+			if (source == zest_ktx2_source_etc1s && (channel == 15 || channel == 4)) has_alpha = ZEST_TRUE;
+			if (source == zest_ktx2_source_uastc && (channel == 3 || channel == 5)) has_alpha = ZEST_TRUE;
+		}
+	}
+	if (file_format == zest_format_undefined && source == zest_ktx2_source_raw) {
+		ZEST_PRINT("KTX2 file has no vkFormat and isn't ETC1S or UASTC: %s", file_path);
+		zest_FreeFile(device, file);
+		return image_collection;
+	}
+
+	zest_format dst_format = file_format;
+	if (source != zest_ktx2_source_raw) {
+		dst_format = info->target_format != zest_format_undefined ? info->target_format : zest_ChooseTranscodeFormat(device, has_alpha, srgb);
+	}
+	zest_bool needs_transcoder = source != zest_ktx2_source_raw || supercompression != zest_ktx2_supercompression_none;
+	if (dst_format == zest_format_undefined || (needs_transcoder && !info->transcoder)) {
+		ZEST_PRINT("KTX2 file needs transcoding but no transcoder was set in the load info: %s", file_path);
+		zest_FreeFile(device, file);
+		return image_collection;
+	}
+
+	zest_image_collection_flags flags = zest_image_collection_flag_ktx_data;
+	if (face_count == 6) flags |= zest_image_collection_flag_is_cube_map;
+	if (array_layers > 0) flags |= zest_image_collection_flag_is_array;
+	image_collection = zest_CreateImageCollection(dst_format, 0, level_count, flags);
+	image_collection.array_layers = layer_count;
+
+	zest_extent3d_t extent = { width, height, 1 };
+	zest_size offset = 0;
+	for (zest_uint i = 0; i != level_count; ++i) {
+		zest_size level_size = zest_GetImageMipLevelSize(dst_format, extent, i, layer_count);
+		zest_SetImageCollectionBitmapMeta(&image_collection, i, ZEST__MAX(width >> i, 1u), ZEST__MAX(height >> i, 1u), 0, 0, level_size, offset);
+		offset += level_size;
+	}
+	if (!zest_AllocateImageCollectionBitmapArray(&image_collection)) {
+		ZEST_PRINT("Unable to allocate %llu bytes for the mip levels of KTX2 file: %s", (unsigned long long)offset, file_path);
+		zest_FreeBitmapArray(&image_collection.bitmap_array);
+		zest_FreeImageCollection(&image_collection);
+		zest_FreeFile(device, file);
+		return image_collection;
+	}
+	zest_bitmap_array_t *bitmap_array = zest_GetImageCollectionBitmapArray(&image_collection);
+
+	zest_ktx2_transcode_context_t *context = (zest_ktx2_transcode_context_t*)ZEST_UTILITIES_MALLOC(sizeof(zest_ktx2_transcode_context_t));
+	*context = ZEST__ZERO_INIT(zest_ktx2_transcode_context_t);
+	context->transcoder = info->transcoder;
+	context->user_data = info->user_data;
+	for (zest_uint i = 0; i != level_count; ++i) {
+		zest_ktx2_transcode_job_t *job = &context->jobs[i];
+		job->mip_level = i;
+		job->width = bitmap_array->meta[i].width;
+		job->height = bitmap_array->meta[i].height;
+		job->layer_count = layer_count;
+		job->source = source;
+		job->supercompression = supercompression;
+		job->src_format = file_format;
+		job->src = data + zest__ktx2_u64(level_index + i * ZEST__KTX2_LEVEL_INDEX_SIZE);
+		job->src_size = zest__ktx2_u64(level_index + i * ZEST__KTX2_LEVEL_INDEX_SIZE + 8);
+		job->uncompressed_size = zest__ktx2_u64(level_index + i * ZEST__KTX2_LEVEL_INDEX_SIZE + 16);
+		job->global_data = sgd_length ? data + sgd_offset : 0;
+		job->global_data_size = sgd_length;
+		job->dst_format = dst_format;
+		job->dst = bitmap_array->data + bitmap_array->meta[i].offset;
+		job->dst_size = bitmap_array->meta[i].size;
+		if (!needs_transcoder && job->src_size != job->dst_size) {
+			valid = ZEST_FALSE;
+		}
+	}
+
+	//Level 0 is the biggest and comes first so the batches claimed on demand stay balanced.
+	if (valid) {
+		zest_ParallelFor(device, level_count, 1, zest__ktx2_transcode_levels, context);
+		for (zest_uint i = 0; i != level_count; ++i) {
+			valid = valid && context->results[i];
+		}
+	}
+	ZEST_UTILITIES_FREE(context);
+	zest_FreeFile(device, file);
+	if (!valid) {
+		ZEST_PRINT("Failed to transcode the mip levels of KTX2 file: %s", file_path);
+		zest_FreeBitmapArray(bitmap_array);
+		zest_FreeImageCollection(&image_collection);
+		return image_collection;
+	}
+	image_collection.flags |= zest_image_collection_flag_initialised;
+	return image_collection;
+}
+
+zest_image_handle zest_LoadKTX2(zest_device device, const char *name, const char *file_name, const zest_ktx2_load_info_t *info) {
+	zest_image_collection_t image_collection = zest__load_ktx2(device, file_name, info);
+	if (!(image_collection.flags & zest_image_collection_flag_initialised)) {
+		return ZEST__ZERO_INIT(zest_image_handle);
+	}
+	zest_bitmap_array_t *bitmap_array = &image_collection.bitmap_array;
+	zest_image_info_t create_info = zest_CreateImageInfo(bitmap_array->meta[0].width, bitmap_array->meta[0].height);
+	create_info.mip_levels = bitmap_array->size_of_array;
+	create_info.layer_count = image_collection.array_layers;
+	create_info.format = image_collection.format;
+	create_info.flags = info->image_flags & ~zest_image_flag_generate_mipmaps;
+	if (image_collection.flags & zest_image_collection_flag_is_cube_map) {
+		create_info.flags |= zest_image_flag_cubemap;
+	}
+	zest_image_handle image_handle = zest_CreateImageWithMipChain(device, bitmap_array->data, bitmap_array->total_mem_size, &create_info);
+	zest_FreeBitmapArray(bitmap_array);
+	zest_FreeImageCollection(&image_collection);
+	return image_handle;
+}
 //End Zest_ktx_helper_implementation
 
 #ifdef __cplusplus
@@ -1743,6 +2063,10 @@ zest_bool zest_AllocateImageCollectionBitmapArray(zest_image_collection_t *image
 	}
 	bitmap_array->total_mem_size = total_size;
     bitmap_array->data = (zest_byte*)ZEST_UTILITIES_MALLOC(bitmap_array->total_mem_size);
+	if (!bitmap_array->data) {
+		bitmap_array->total_mem_size = 0;
+		return ZEST_FALSE;
+	}
 	return ZEST_TRUE;
 }
 
@@ -2681,38 +3005,12 @@ zest_matrix4 zest_TransformMesh(zest_mesh mesh, float pitch, float yaw, float ro
 
 void zest_CalculateNormals(zest_mesh mesh) {
     ZEST_ASSERT(mesh->vertex_struct_size == sizeof(zest_vertex_t));
-    zest_vertex_t* vertices = (zest_vertex_t*)mesh->vertex_data;
-
-    // Zero out all normals first
-    for (zest_uint i = 0; i < mesh->vertex_count; ++i) {
-        vertices[i].normal = zest_Vec3Set(0.f, 0.f, 0.f);
-    }
-
-    // Calculate face normals and add them to each vertex of the face
-    for (zest_uint i = 0; i < zest_MeshIndexCount(mesh); i += 3) {
-        zest_uint i0 = mesh->indexes[i + 0];
-        zest_uint i1 = mesh->indexes[i + 1];
-        zest_uint i2 = mesh->indexes[i + 2];
-
-        zest_vertex_t v0 = vertices[i0];
-        zest_vertex_t v1 = vertices[i1];
-        zest_vertex_t v2 = vertices[i2];
-
-        zest_vec3 edge1 = zest_SubVec3(v1.pos, v0.pos);
-        zest_vec3 edge2 = zest_SubVec3(v2.pos, v0.pos);
-
-        zest_vec3 normal = zest_CrossProduct(edge1, edge2);
-        normal = zest_NormalizeVec3(normal);
-
-        vertices[i0].normal = zest_AddVec3(vertices[i0].normal, normal);
-        vertices[i1].normal = zest_AddVec3(vertices[i1].normal, normal);
-        vertices[i2].normal = zest_AddVec3(vertices[i2].normal, normal);
-    }
+    zest_CalculateMeshNormals(mesh, offsetof(zest_vertex_t, pos), offsetof(zest_vertex_t, normal));
+}
 
-    // Normalize all the vertex normals
-    for (zest_uint i = 0; i < mesh->vertex_count; ++i) {
-        vertices[i].normal = zest_NormalizeVec3(vertices[i].normal);
-    }
+void zest_CalculateTangents(zest_mesh mesh) {
+    ZEST_ASSERT(mesh->vertex_struct_size == sizeof(zest_vertex_t));
+    zest_CalculateMeshTangents(mesh, offsetof(zest_vertex_t, pos), offsetof(zest_vertex_t, normal), offsetof(zest_vertex_t, uv), offsetof(zest_vertex_t, tangent), zest_format_r16g16b16a16_snorm);
 }
 
 zest_bounding_box_t zest_GetMeshBoundingBox(zest_mesh mesh) {
@@ -2755,9 +3053,7 @@ void zest_AddMeshToMesh(zest_mesh dst_mesh, zest_mesh src_mesh) {
     dst_mesh->vertex_count = dst_vertex_count + src_vertex_count;
 
     // Copy and offset indices
-    for (zest_uint i = 0; i < src_index_size; ++i) {
-        zest_PushMeshIndex(dst_mesh, src_mesh->indexes[i] + dst_vertex_count);
-    }
+    zest_AppendMeshIndexes(dst_mesh, src_mesh->indexes, src_index_size, dst_vertex_count);
 }
 
 zest_mesh zest_CreateCylinder(zest_context context, int sides, float radius, float height, zest_color_t color, zest_bool cap) {
@@ -113,6 +113,137 @@ void main()
 
 );
 
+//----------------------
+//Instance mesh layer cull compute shader
+//----------------------
+static const char *zest_shader_layer_cull_comp = ZEST_GLSL(450,
+
+layout(local_size_x = 64) in;
+
+layout(set = 0, binding = 0) uniform sampler samplers[];
+layout(set = 0, binding = 1) uniform texture2D textures[];
+layout(std430, set = 0, binding = 5) buffer LayerCullWords {
+	uint data[];
+} buffers[];
+
+layout(push_constant) uniform layer_cull_push
+{
+	uint instances_index;
+	uint culled_index;
+	uint commands_index;
+	uint hiz_index;
+	uint hiz_sampler_index;
+	uint instance_words;
+	uint position_word;
+	uint scale_word;
+	uint draws_word;
+	uint view_word;
+	uint lod_word;
+} pc;
+
+float read_float(uint buffer_index, uint word) {
+	return uintBitsToFloat(buffers[buffer_index].data[word]);
+}
+
+vec3 read_vec3(uint buffer_index, uint word) {
+	return vec3(read_float(buffer_index, word), read_float(buffer_index, word + 1), read_float(buffer_index, word + 2));
+}
+
+vec4 read_vec4(uint buffer_index, uint word) {
+	return vec4(read_vec3(buffer_index, word), read_float(buffer_index, word + 3));
+}
+
+bool in_frustum(vec3 position, float radius) {
+	for (uint i = 0; i < 6; i++) {
+		vec4 plane = read_vec4(pc.commands_index, pc.view_word + i * 4);
+		if (dot(plane.xyz, position) + plane.w <= -radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+float hiz_depth(vec2 uv, float mip) {
+	return textureLod(sampler2D(textures[pc.hiz_index], samplers[pc.hiz_sampler_index]), uv, mip).r;
+}
+
+bool occluded(vec3 position, float radius) {
+	uint view = pc.view_word + 24;
+	mat4 view_proj = mat4(read_vec4(pc.commands_index, view), read_vec4(pc.commands_index, view + 4), read_vec4(pc.commands_index, view + 8), read_vec4(pc.commands_index, view + 12));
+	vec2 hiz_size = vec2(read_float(pc.commands_index, view + 16), read_float(pc.commands_index, view + 17));
+	float mip_count = float(buffers[pc.commands_index].data[view + 18]);
+	vec2 uv_min = vec2(1.0);
+	vec2 uv_max = vec2(0.0);
+	float nearest = 1.0;
+	for (int i = 0; i < 8; i++) {
+		vec3 corner = position + radius * vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+		vec4 clip = view_proj * vec4(corner, 1.0);
+		if (clip.w <= 0.0) {
+			return false;
+		}
+		vec3 ndc = clip.xyz / clip.w;
+		uv_min = min(uv_min, ndc.xy * 0.5 + 0.5);
+		uv_max = max(uv_max, ndc.xy * 0.5 + 0.5);
+		nearest = min(nearest, ndc.z);
+	}
+	uv_min = clamp(uv_min, vec2(0.0), vec2(1.0));
+	uv_max = clamp(uv_max, vec2(0.0), vec2(1.0));
+	vec2 size = (uv_max - uv_min) * hiz_size;
+	float mip = clamp(ceil(log2(max(max(size.x, size.y), 1.0))), 0.0, max(mip_count - 1.0, 0.0));
+	float farthest = max(max(hiz_depth(uv_min, mip), hiz_depth(vec2(uv_max.x, uv_min.y), mip)), max(hiz_depth(vec2(uv_min.x, uv_max.y), mip), hiz_depth(uv_max, mip)));
+	return nearest > farthest;
+}
+
+void main() {
+	uint draw = gl_WorkGroupID.y;
+	uint info = pc.draws_word + draw * 8;
+	uint first = buffers[pc.commands_index].data[info];
+	uint count = buffers[pc.commands_index].data[info + 1];
+	float radius = read_float(pc.commands_index, info + 2);
+	uint target_first = buffers[pc.commands_index].data[info + 3];
+	float lod_radius = read_float(pc.commands_index, info + 4);
+	if (gl_GlobalInvocationID.x >= count) {
+		return;
+	}
+	uint source = (first + gl_GlobalInvocationID.x) * pc.instance_words;
+	vec3 position = read_vec3(pc.instances_index, source + pc.position_word);
+	float scale_factor = 1.0;
+	if (pc.scale_word != 0xFFFFFFFFu) {
+		vec3 scale = abs(read_vec3(pc.instances_index, source + pc.scale_word));
+		scale_factor = max(max(scale.x, scale.y), scale.z);
+	}
+	if (lod_radius > 0.0) {
+		//Every level of a LOD chain has a draw over the same instances and each instance is only kept by the level
+		//that its screen size falls in. Keep this in step with zest__layer_instance_screen_size.
+		vec4 lod_view = read_vec4(pc.commands_index, pc.lod_word);
+		float screen_size = 3.402823466e+38;
+		if (lod_view.w > 0.0) {
+			screen_size = lod_radius * scale_factor / max(distance(position, lod_view.xyz), 0.0001) * lod_view.w;
+		}
+		float lod_min = read_float(pc.commands_index, info + 5);
+		float lod_max = read_float(pc.commands_index, info + 6);
+		if (screen_size < lod_min || (lod_max >= 0.0 && screen_size >= lod_max)) {
+			return;
+		}
+	}
+	if (radius >= 0.0) {
+		radius *= scale_factor;
+		if (!in_frustum(position, radius)) {
+			return;
+		}
+		if (pc.hiz_index != 0xFFFFFFFFu && occluded(position, radius)) {
+			return;
+		}
+	}
+	uint slot = atomicAdd(buffers[pc.commands_index].data[draw * 5 + 1], 1u);
+	uint target = (target_first + slot) * pc.instance_words;
+	for (uint word = 0; word < pc.instance_words; word++) {
+		buffers[pc.culled_index].data[target + word] = buffers[pc.instances_index].data[source + word];
+	}
+}
+
+);
+
 // -- End Shader_code
 
 ZEST_API VkInstance zest_GetVKInstance(zest_context context);
@@ -186,6 +317,8 @@ ZEST_PRIVATE const char *zest__vulkan_error_string(VkResult errorCode);
 // --Frame_graph_platform_functions
 ZEST_PRIVATE zest_bool zest__vk_begin_command_buffer(const zest_command_list command_list);
 ZEST_PRIVATE zest_bool zest__vk_set_next_command_buffer(zest_command_list command_list, zest_context_queue queue);
+ZEST_PRIVATE zest_bool zest__vk_prepare_worker_command_pools(zest_context context, zest_context_queue queue, zest_uint worker_count);
+ZEST_PRIVATE zest_bool zest__vk_set_worker_command_buffer(zest_command_list command_list, zest_context_queue queue, zest_uint worker_index);
 ZEST_PRIVATE void zest__vk_submit_buffer_barrier_runs(zest_command_list command_list, VkBufferMemoryBarrier2 *barriers, zest_resource_node *nodes, zest_uint buffer_count, VkImageMemoryBarrier2 *image_barriers, zest_uint image_count);
 ZEST_PRIVATE void zest__vk_acquire_barrier(zest_command_list command_list, zest_execution_details_t *exe_details);
 ZEST_PRIVATE void zest__vk_release_barrier(zest_command_list command_list, zest_execution_details_t *exe_details);
@@ -222,6 +355,8 @@ ZEST_PRIVATE zest_uint zest__vk_get_buffer_queue_family_index(zest_buffer buffer
 
 //Pipelines
 ZEST_PRIVATE zest_bool zest__vk_build_pipeline(zest_pipeline pipeline, zest_command_list command_list);
+ZEST_PRIVATE zest_bool zest__vk_build_pipeline_background(zest_pipeline pipeline, const zest_rendering_info_t *rendering_info, zest_shader vert_shader, zest_shader frag_shader, zloc_linear_allocator_t *scratch);
+ZEST_PRIVATE zest_bool zest__vk_build_pipeline_with(zest_pipeline pipeline, const zest_rendering_info_t *rendering_info, zest_shader vert_shader, zest_shader frag_shader, zloc_linear_allocator_t *scratch, zest_bool background);
 ZEST_PRIVATE zest_bool zest__vk_build_pipeline_legacy(zest_pipeline pipeline, zest_command_list command_list);
 ZEST_PRIVATE zest_bool zest__vk_build_pipeline_layout(zest_device device, zest_pipeline_layout pipeline_layout, zest_pipeline_layout_info_t *info);
 
@@ -257,10 +392,14 @@ ZEST_PRIVATE void zest__vk_add_instance_extension(zest_device device, const char
 //Shader compiling with shaderc
 ZEST_PRIVATE zest_bool zest__vk_validate_shader(zest_device device, const char *shader_code, zest_shader_type type, const char *name);
 ZEST_PRIVATE zest_bool zest__vk_compile_shader(zest_shader shader, const char *code, zest_uint code_length, zest_shader_type, const char *name, const char *entry_point, zest_shader_options options);
+ZEST_PRIVATE zest_bool zest__vk_prepare_shader_compilers(zest_device device, zest_uint count);
+ZEST_PRIVATE void zest__vk_compile_shader_job(zest_device device, zest_shader_compile_job_t *job, zest_uint compiler_index);
+ZEST_PRIVATE zest_bool zest__vk_finish_shader_job(zest_shader shader, zest_shader_compile_job_t *job);
 
 //Semaphores
 ZEST_PRIVATE zest_semaphore_status zest__vk_wait_for_renderer_semaphore(zest_context context);
 ZEST_PRIVATE zest_semaphore_status zest__vk_wait_for_timeline(zest_execution_timeline timeline, zest_microsecs timeout);
+ZEST_PRIVATE zest_u64 zest__vk_get_timeline_value(zest_execution_timeline timeline);
 
 //Command buffers/queues
 ZEST_PRIVATE void zest__vk_reset_queue_command_pool(zest_context context, zest_context_queue queue, zest_bool release_resources);
@@ -308,6 +447,7 @@ ZEST_PRIVATE void zest__vk_cleanup_memory_backend(zest_device_memory memory);
 ZEST_PRIVATE void zest__vk_cleanup_buffer_allocator_backend(zest_buffer_allocator buffer_allocator);
 ZEST_PRIVATE void zest__vk_cleanup_device_backend(zest_device device);
 ZEST_PRIVATE void zest__vk_get_memory_budget(zest_device device, zest_memory_budget_t *budget);
+ZEST_PRIVATE zest_bool zest__vk_find_memory_heap(zest_device device, zest_memory_property_flags property_flags, zest_uint *heap_index, zest_size *heap_size);
 ZEST_PRIVATE zest_bool zest__vk_reinit_logical_device(zest_device device);
 ZEST_PRIVATE void zest__vk_cleanup_context_backend(zest_context context);
 ZEST_PRIVATE void zest__vk_destroy_context_surface(zest_context context);
@@ -319,9 +459,13 @@ ZEST_PRIVATE VkFramebuffer zest__vk_create_legacy_framebuffer(zest_context conte
 ZEST_PRIVATE void zest__vk_cleanup_legacy_render_pass_cache(zest_device device);
 ZEST_PRIVATE zest_bool zest__vk_create_window_surface(zest_context context);
 ZEST_PRIVATE zest_bool zest__vk_initialise_device(zest_device device);
+ZEST_PRIVATE zest_bool zest__vk_create_pipeline_cache(zest_device device, const void *initial_data, zest_size initial_size);
+ZEST_PRIVATE void zest__vk_get_pipeline_cache_identity(zest_device device, zest_pipeline_cache_header_t *header);
+ZEST_PRIVATE zest_size zest__vk_get_pipeline_cache_data(zest_device device, void *data, zest_size size);
 ZEST_PRIVATE zest_bool zest__vk_initialise_swapchain(zest_context context);
 ZEST_PRIVATE zest_bool zest__vk_initialise_context_queue_backend(zest_context context, zest_context_queue queue);
 ZEST_PRIVATE zest_shader_handle	zest__vk_get_db_overlay_vertex_shader(zest_device device);
+ZEST_PRIVATE zest_shader_handle	zest__vk_get_layer_cull_shader(zest_device device);
 ZEST_PRIVATE zest_shader_handle	zest__vk_get_db_overlay_fragment_shader(zest_device device);
 
 ZEST_PRIVATE zest_bool zest__vk_create_instance(zest_device device);
@@ -331,6 +475,8 @@ ZEST_PRIVATE void zest__vk_setup_validation(zest_device device);
 ZEST_PRIVATE zest_bool zest__vk_pick_physical_device(zest_device device);
 ZEST_PRIVATE zest_bool zest__vk_is_image_format_supported(zest_device device, zest_format format, zest_image_flags flags);
 ZEST_PRIVATE zest_bool zest__vk_create_image(zest_device device, zest_context context, zest_image image, zest_uint layer_count, zest_sample_count_flags num_samples, zest_image_flags flags);
+ZEST_PRIVATE zest_bool zest__vk_create_images(zest_device device, zest_image *images, zest_uint count);
+ZEST_PRIVATE int zest__vk_compare_pooled_images(const void *a, const void *b);
 ZEST_PRIVATE zest_bool zest__vk_create_transient_image_unbound(zest_device device, zest_context context, zest_image image, zest_uint layer_count, zest_sample_count_flags num_samples, zest_image_flags flags, zest_transient_memory_info_t *info);
 ZEST_PRIVATE zest_bool zest__vk_bind_image_arena(zest_device device, zest_image image, zest_device_memory_pool backing, zest_size offset);
 ZEST_PRIVATE zest_device_memory_pool zest__vk_create_arena_backing(zest_device device, zest_context context, zest_uint category, zest_size size);
@@ -346,6 +492,17 @@ ZEST_PRIVATE int zest__vk_get_image_raw_layout(zest_image image);
 ZEST_PRIVATE zest_bool zest__vk_image_layout_is_valid_for_desriptor(zest_image image);
 ZEST_PRIVATE zest_bool zest__vk_copy_buffer_to_image(zest_queue queue, zest_buffer buffer, zest_size src_offset, zest_image image, zest_uint width, zest_uint height);
 ZEST_PRIVATE zest_bool zest__vk_generate_mipmaps(zest_queue queue, zest_image image);
+ZEST_PRIVATE zest_bool zest__vk_create_image_streamer_backend(zest_image_streamer streamer);
+ZEST_PRIVATE void zest__vk_cleanup_image_streamer_backend(zest_image_streamer streamer);
+ZEST_PRIVATE zest_bool zest__vk_submit_image_stream_batch(zest_image_streamer streamer, zest_image_stream_batch_t *batch, zest_image_stream_request_t *requests, zest_uint request_count);
+ZEST_PRIVATE zest_bool zest__vk_create_readback_backend(zest_context context);
+ZEST_PRIVATE void zest__vk_cleanup_readback_backend(zest_context context);
+ZEST_PRIVATE void zest__vk_record_readback(zest_device device, VkCommandBuffer command_buffer, zest_readback_copy_t *copy, VkImageLayout image_layout, zest_buffer ring);
+ZEST_PRIVATE void zest__vk_cmd_readback(const zest_command_list command_list, zest_readback_copy_t *copy);
+ZEST_PRIVATE zest_bool zest__vk_submit_readback(zest_context context, zest_readback_copy_t *copy, zest_uint slot, zest_u64 signal_value);
+ZEST_PRIVATE void zest__vk_invalidate_buffer(zest_buffer buffer, zest_size offset, zest_size size);
+ZEST_PRIVATE void zest__vk_cmd_update_virtual_texture(const zest_command_list command_list, zest_virtual_texture virtual_texture, zest_virtual_texture_resources_t *resources, zest_uint fif);
+ZEST_PRIVATE void zest__vk_cmd_shader_write_barrier(const zest_command_list command_list, zest_buffer buffer);
 ZEST_PRIVATE zest_bool zest__vk_create_execution_timeline_backend(zest_device device, zest_execution_timeline timeline);
 ZEST_PRIVATE void zest__vk_cleanup_execution_timeline_backend(zest_execution_timeline timeline);
 ZEST_PRIVATE void zest__vk_add_image_barrier(zest_resource_node resource, zest_execution_barriers_t *barriers, zest_bool acquire, 
@@ -369,6 +526,7 @@ ZEST_PRIVATE void zest__vk_create_test_render_pass(zest_device device, const zes
 zest_bool zest__vk_upload_buffer(const zest_command_list command_list, zest_buffer_uploader_t *uploader);
 void zest__vk_draw_indexed(const zest_command_list command_list, zest_uint index_count, zest_uint instance_count, zest_uint first_index, int32_t vertex_offset, zest_uint first_instance);
 void zest__vk_draw_indexed_indirect(const zest_command_list command_list, zest_buffer buffer, zest_size offset, zest_uint draw_count, zest_uint stride);
+void zest__vk_draw_indexed_indirect_count(const zest_command_list command_list, zest_buffer buffer, zest_size offset, zest_buffer count_buffer, zest_size count_offset, zest_uint max_draw_count, zest_uint stride);
 void zest__vk_draw_indirect(const zest_command_list command_list, zest_buffer buffer, zest_size offset, zest_uint draw_count, zest_uint stride);
 void zest__vk_set_depth_bias(const zest_command_list command_list, float factor, float clamp, float slope);
 void zest__vk_copy_buffer(const zest_command_list command_list, zest_buffer src_buffer, zest_buffer dst_buffer, zest_size size);
@@ -401,10 +559,35 @@ typedef struct zest_queue_backend_t {
     VkCommandBuffer command_buffer;
 } zest_queue_backend_t;
 
+//The streamer has its own pools so that batches can stay pending on the GPU after the queues they were
+//submitted on have been handed back. transfer_pool is null when uploads run on the graphics family.
+typedef struct zest_image_streamer_backend_t {
+    VkCommandPool transfer_pool;
+    VkCommandPool graphics_pool;
+    VkCommandBuffer transfer_buffers[ZEST_STREAM_BATCHES_IN_FLIGHT];
+    VkCommandBuffer graphics_buffers[ZEST_STREAM_BATCHES_IN_FLIGHT];
+} zest_image_streamer_backend_t;
+
+//Command buffers for standalone readbacks, one per slot so that they can stay pending after the queue is released
+typedef struct zest_readback_backend_t {
+    VkCommandPool command_pool;
+    VkCommandBuffer command_buffers[ZEST_READBACK_SUBMITS_IN_FLIGHT];
+} zest_readback_backend_t;
+
 // -- Backend_structs
+//A command pool for one recording task when pass groups are recorded in parallel. Command pools can't
+//be used from more than one thread at a time so each task gets its own.
+typedef struct zest_worker_command_pool_t {
+    VkCommandPool command_pool;
+    VkCommandBuffer *command_buffers;
+    zest_uint next_buffer;
+} zest_worker_command_pool_t;
+
 typedef struct zest_context_queue_backend_t {
     VkCommandPool command_pool[ZEST_MAX_FIF];
     VkCommandBuffer *command_buffers[ZEST_MAX_FIF];
+    //Created on demand by zest__vk_prepare_worker_command_pools, indexed by recording task slot
+    zest_worker_command_pool_t *worker_pools[ZEST_MAX_FIF];
 } zest_context_queue_backend_t;
 
 typedef struct zest_execution_backend_t {
@@ -479,6 +662,7 @@ typedef struct zest_device_backend_t {
     VkFormat color_format;
     VkResult last_result;
 	shaderc_compiler_t shaderc_compiler;
+	shaderc_compiler_t *shaderc_compilers;          //One per job for zest_CreateShaders (vec)
     VkPipelineCache pipeline_cache;
     zest_bool has_dynamic_rendering;
     zest_bool has_memory_budget;
@@ -650,6 +834,8 @@ void zest__vk_initialise_platform_callbacks(zest_platform_t *platform) {
     platform->begin_command_buffer                          = zest__vk_begin_command_buffer;
     platform->end_command_buffer                            = zest__vk_end_command_buffer;
     platform->set_next_command_buffer                       = zest__vk_set_next_command_buffer;
+    platform->prepare_worker_command_pools                  = zest__vk_prepare_worker_command_pools;
+    platform->set_worker_command_buffer                     = zest__vk_set_worker_command_buffer;
     platform->acquire_barrier                               = zest__vk_acquire_barrier;
     platform->release_barrier                               = zest__vk_release_barrier;
     platform->get_frame_graph_semaphores                    = zest__vk_get_frame_graph_semaphores;
@@ -674,6 +860,7 @@ void zest__vk_initialise_platform_callbacks(zest_platform_t *platform) {
     platform->create_image_memory_pool                      = zest__vk_create_image_memory_pool;
     platform->create_device_memory		                    = zest__vk_create_device_memory;
     platform->get_memory_budget                             = zest__vk_get_memory_budget;
+    platform->find_memory_heap                              = zest__vk_find_memory_heap;
     platform->map_memory                                    = zest__vk_map_memory;
     platform->unmap_memory                                  = zest__vk_unmap_memory;
     platform->flush_used_buffers                            = zest__vk_flush_used_buffers;
@@ -681,6 +868,7 @@ void zest__vk_initialise_platform_callbacks(zest_platform_t *platform) {
 
 	platform->is_image_format_supported					    = zest__vk_is_image_format_supported;
 	platform->create_image 								    = zest__vk_create_image;
+	platform->create_images 							    = zest__vk_create_images;
 	platform->create_transient_image_unbound			    = zest__vk_create_transient_image_unbound;
 	platform->bind_image_arena							    = zest__vk_bind_image_arena;
 	platform->create_arena_backing						    = zest__vk_create_arena_backing;
@@ -696,6 +884,7 @@ void zest__vk_initialise_platform_callbacks(zest_platform_t *platform) {
 	platform->generate_mipmaps		 					    = zest__vk_generate_mipmaps;
 
     platform->build_pipeline                                = zest__vk_build_pipeline;
+    platform->build_pipeline_background                     = zest__vk_build_pipeline_background;
     platform->build_pipeline_layout                         = zest__vk_build_pipeline_layout;
     platform->finish_compute                                = zest__vk_finish_compute;
 
@@ -703,6 +892,17 @@ void zest__vk_initialise_platform_callbacks(zest_platform_t *platform) {
 	platform->wait_for_fif_semaphore					    = zest__vk_wait_for_fif_semaphore;
 	platform->queue_wait_idle							    = zest__vk_queue_wait_idle;
 	platform->wait_for_timeline							    = zest__vk_wait_for_timeline;
+	platform->get_timeline_value						    = zest__vk_get_timeline_value;
+	platform->create_image_streamer_backend				    = zest__vk_create_image_streamer_backend;
+	platform->cleanup_image_streamer_backend			    = zest__vk_cleanup_image_streamer_backend;
+	platform->submit_image_stream_batch					    = zest__vk_submit_image_stream_batch;
+	platform->create_readback_backend					    = zest__vk_create_readback_backend;
+	platform->cleanup_readback_backend					    = zest__vk_cleanup_readback_backend;
+	platform->cmd_readback								    = zest__vk_cmd_readback;
+	platform->submit_readback							    = zest__vk_submit_readback;
+	platform->invalidate_buffer							    = zest__vk_invalidate_buffer;
+	platform->cmd_update_virtual_texture				    = zest__vk_cmd_update_virtual_texture;
+	platform->cmd_shader_write_barrier					    = zest__vk_cmd_shader_write_barrier;
 
     platform->create_set_layout                             = zest__vk_create_set_layout;
     platform->create_set_pool                               = zest__vk_create_set_pool;
@@ -719,6 +919,7 @@ void zest__vk_initialise_platform_callbacks(zest_platform_t *platform) {
     platform->initialise_context_queue_backend			    = zest__vk_initialise_context_queue_backend;
     platform->get_db_overlay_vertex_shader			    	= zest__vk_get_db_overlay_vertex_shader;
     platform->get_db_overlay_fragment_shader			    = zest__vk_get_db_overlay_fragment_shader;
+    platform->get_layer_cull_shader					    	= zest__vk_get_layer_cull_shader;
     platform->create_test_render_pass					    = zest__vk_create_test_render_pass;
 
 	platform->set_object_name                               = zest__vk_set_object_name;
@@ -727,10 +928,15 @@ void zest__vk_initialise_platform_callbacks(zest_platform_t *platform) {
 
 	platform->wait_for_idle_device                          = zest__vk_wait_for_idle_device;
 	platform->initialise_device                      	    = zest__vk_initialise_device;
+	platform->get_pipeline_cache_identity                   = zest__vk_get_pipeline_cache_identity;
+	platform->get_pipeline_cache_data                       = zest__vk_get_pipeline_cache_data;
 	platform->create_window_surface 				        = zest__vk_create_window_surface;
 
 	platform->validate_shader 							    = zest__vk_validate_shader;
 	platform->compile_shader 							    = zest__vk_compile_shader;
+	platform->prepare_shader_compilers 					    = zest__vk_prepare_shader_compilers;
+	platform->compile_shader_job 						    = zest__vk_compile_shader_job;
+	platform->finish_shader_job 						    = zest__vk_finish_shader_job;
 
 	platform->reset_queue_command_pool 					    = zest__vk_reset_queue_command_pool;
 
@@ -793,6 +999,7 @@ void zest__vk_initialise_platform_callbacks(zest_platform_t *platform) {
 	platform->upload_buffer                                 = zest__vk_upload_buffer;
 	platform->draw_indexed                                  = zest__vk_draw_indexed;
 	platform->draw_indexed_indirect                         = zest__vk_draw_indexed_indirect;
+	platform->draw_indexed_indirect_count                   = zest__vk_draw_indexed_indirect_count;
 	platform->draw_indirect			                        = zest__vk_draw_indirect;
 	platform->set_depth_bias                                = zest__vk_set_depth_bias;
 	platform->copy_buffer                                   = zest__vk_copy_buffer;
@@ -1587,6 +1794,11 @@ zest_shader_handle zest__vk_get_db_overlay_fragment_shader(zest_device device) {
 	return shader;
 }
 
+zest_shader_handle zest__vk_get_layer_cull_shader(zest_device device) {
+	zest_shader_handle shader = zest_CreateShader(device, zest_shader_layer_cull_comp, zest_compute_shader, "Layer Cull", NULL, ZEST_TRUE);
+	return shader;
+}
+
 // -- Swapchain_presenting
 zest_bool zest__vk_dummy_submit_for_present_only(zest_context context) {
     ZEST_RETURN_FALSE_ON_FAIL(context->device, vkResetCommandPool(context->device->backend->logical_device, context->backend->utility_command_pool[context->current_fif], 0));
@@ -1776,12 +1988,56 @@ zest_bool zest__vk_initialise_device(zest_device device) {
 	zest__vk_set_limit_data(device);
 	zest__set_default_pool_sizes(device);
 
+	zest_file cache_data = NULL;
+	if (ZEST__FLAGGED(device->init_flags, zest_device_init_flag_cache_pipelines)) {
+		cache_data = zest__load_pipeline_cache(device);
+	}
+	zest_bool result = zest__vk_create_pipeline_cache(device, cache_data, zest_vec_size(cache_data));
+	zest_vec_free(device->allocator, cache_data);
+
+    return result;
+}
+
+zest_bool zest__vk_create_pipeline_cache(zest_device device, const void *initial_data, zest_size initial_size) {
 	VkPipelineCacheCreateInfo pipeline_cache_create_info = ZEST__ZERO_INIT(VkPipelineCacheCreateInfo);
 	pipeline_cache_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	pipeline_cache_create_info.initialDataSize = initial_data ? (size_t)initial_size : 0;
+	pipeline_cache_create_info.pInitialData = initial_data;
 	ZEST_SET_MEMORY_CONTEXT(device, zest_memory_context_context, zest_command_pipeline_cache);
-	ZEST_RETURN_FALSE_ON_FAIL(device, vkCreatePipelineCache(device->backend->logical_device, &pipeline_cache_create_info, &device->backend->allocation_callbacks, &device->backend->pipeline_cache));
+	VkResult result = vkCreatePipelineCache(device->backend->logical_device, &pipeline_cache_create_info, &device->backend->allocation_callbacks, &device->backend->pipeline_cache);
+	if (result != VK_SUCCESS && initial_data) {
+		//The header checks should catch anything the driver won't accept, but if it still refuses the data
+		//then an empty cache is better than no device.
+		ZEST_APPEND_LOG(device->log_path.str, "The driver rejected the saved pipeline cache, starting with an empty cache.");
+		pipeline_cache_create_info.initialDataSize = 0;
+		pipeline_cache_create_info.pInitialData = NULL;
+		result = vkCreatePipelineCache(device->backend->logical_device, &pipeline_cache_create_info, &device->backend->allocation_callbacks, &device->backend->pipeline_cache);
+	}
+	ZEST_RETURN_FALSE_ON_FAIL(device, result);
+	return ZEST_TRUE;
+}
 
-    return ZEST_TRUE;
+void zest__vk_get_pipeline_cache_identity(zest_device device, zest_pipeline_cache_header_t *header) {
+	VkPhysicalDeviceProperties *properties = &device->backend->properties;
+	header->vendor_id = properties->vendorID;
+	header->device_id = properties->deviceID;
+	header->driver_version = properties->driverVersion;
+	zloc__static_assert(sizeof(header->cache_uuid) == VK_UUID_SIZE);
+	memcpy(header->cache_uuid, properties->pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+zest_size zest__vk_get_pipeline_cache_data(zest_device device, void *data, zest_size size) {
+	if (device->backend->pipeline_cache == VK_NULL_HANDLE) {
+		return 0;
+	}
+	size_t data_size = (size_t)size;
+	VkResult result = vkGetPipelineCacheData(device->backend->logical_device, device->backend->pipeline_cache, &data_size, data);
+	//VK_INCOMPLETE means the cache grew between the size query and the copy, which would leave a partial
+	//cache so treat it as a failure.
+	if (result != VK_SUCCESS) {
+		return 0;
+	}
+	return (zest_size)data_size;
 }
 
 static VKAPI_ATTR VkBool32 VKAPI_CALL zest__vk_debug_callback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageType, const VkDebugUtilsMessengerCallbackDataEXT *pCallbackData, void *pUserData) {
@@ -2297,6 +2553,8 @@ zest_bool zest__vk_query_device_capabilities(zest_device device) {
     if (base->geometryShader)                                     supported |= zest_capability_geometry_shader;
     if (base->shaderInt64)                                        supported |= zest_capability_shader_int64;
     if (base->fragmentStoresAndAtomics)                           supported |= zest_capability_fragment_stores_and_atomics;
+    if (features_12.drawIndirectCount)                            supported |= zest_capability_draw_indirect_count;
+    if (features_11.shaderDrawParameters)                         supported |= zest_capability_shader_draw_parameters;
     device->capabilities.supported = supported;
 
     // --- Bindless descriptor ceilings ---
@@ -2334,6 +2592,8 @@ zest_bool zest__vk_query_device_capabilities(zest_device device) {
     ZEST_APPEND_LOG(log, "  nonuniform_sampled_image_indexing: %s",   (supported & zest_capability_nonuniform_sampled_image_indexing) ? "yes" : "no");
     ZEST_APPEND_LOG(log, "  anisotropic_filtering: %s",               (supported & zest_capability_anisotropic_filtering) ? "yes" : "no");
     ZEST_APPEND_LOG(log, "  wireframe: %s",                           (supported & zest_capability_wireframe) ? "yes" : "no");
+    ZEST_APPEND_LOG(log, "  draw_indirect_count: %s",                 (supported & zest_capability_draw_indirect_count) ? "yes" : "no");
+    ZEST_APPEND_LOG(log, "  shader_draw_parameters: %s",              (supported & zest_capability_shader_draw_parameters) ? "yes" : "no");
     ZEST_APPEND_LOG(log, "  tessellation (opt-in): %s",               (supported & zest_capability_tessellation) ? "yes" : "no");
     ZEST_APPEND_LOG(log, "  geometry_shader (opt-in): %s",            (supported & zest_capability_geometry_shader) ? "yes" : "no");
     ZEST_APPEND_LOG(log, "  shader_int64 (opt-in): %s",               (supported & zest_capability_shader_int64) ? "yes" : "no");
@@ -2486,11 +2746,13 @@ zest_bool zest__vk_create_logical_device(zest_device device) {
     device_features_12.shaderStorageBufferArrayNonUniformIndexing = (enabled & zest_capability_nonuniform_storage_buffer_indexing) ? VK_TRUE : VK_FALSE;
     device_features_12.shaderUniformBufferArrayNonUniformIndexing = (enabled & zest_capability_nonuniform_uniform_buffer_indexing) ? VK_TRUE : VK_FALSE;
     device_features_12.bufferDeviceAddress = (enabled & zest_capability_buffer_device_address) ? VK_TRUE : VK_FALSE;
+    device_features_12.drawIndirectCount = (enabled & zest_capability_draw_indirect_count) ? VK_TRUE : VK_FALSE;
 
 	VkPhysicalDeviceVulkan11Features device_features_11 = ZEST__ZERO_INIT(VkPhysicalDeviceVulkan11Features);
 	device_features_11.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
 	device_features_11.pNext = NULL;
 	device_features_11.multiview = supported_11->multiview;    // core 1.1, enable if present
+	device_features_11.shaderDrawParameters = (enabled & zest_capability_shader_draw_parameters) ? VK_TRUE : VK_FALSE;
 
 	VkPhysicalDeviceSynchronization2FeaturesKHR sync2_features = ZEST__ZERO_INIT(VkPhysicalDeviceSynchronization2FeaturesKHR);
 	sync2_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
@@ -2829,6 +3091,12 @@ void zest__vk_cleanup_context_queue_backend(zest_context context, zest_context_q
         //vkDestroySemaphore(context->device->backend->logical_device, context_queue->backend->semaphore[fif], &context->backend->allocation_callbacks);
         vkDestroyCommandPool(context->device->backend->logical_device, context_queue->backend->command_pool[fif], &context->backend->allocation_callbacks);
         zest_vec_free(context->allocator, context_queue->backend->command_buffers[fif]);
+        zest_vec_foreach(worker_index, context_queue->backend->worker_pools[fif]) {
+            zest_worker_command_pool_t *worker_pool = &context_queue->backend->worker_pools[fif][worker_index];
+            vkDestroyCommandPool(context->device->backend->logical_device, worker_pool->command_pool, &context->backend->allocation_callbacks);
+            zest_vec_free(context->allocator, worker_pool->command_buffers);
+        }
+        zest_vec_free(context->allocator, context_queue->backend->worker_pools[fif]);
     }
     ZEST__FREE(context->allocator, context_queue->backend);
     context_queue->backend = 0;
@@ -2971,6 +3239,10 @@ void zest__vk_cleanup_device_backend(zest_device device) {
 	if (device->backend->shaderc_compiler) {
 		shaderc_compiler_release(device->backend->shaderc_compiler);
 	}
+	zest_vec_foreach(i, device->backend->shaderc_compilers) {
+		shaderc_compiler_release(device->backend->shaderc_compilers[i]);
+	}
+	zest_vec_free(device->allocator, device->backend->shaderc_compilers);
     if (device->backend->debug_messenger != VK_NULL_HANDLE) {
         PFN_vkDestroyDebugUtilsMessengerEXT destroyDebugUtilsMessenger =
             (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(device->backend->instance, "vkDestroyDebugUtilsMessengerEXT");
@@ -2997,7 +3269,16 @@ zest_bool zest__vk_reinit_logical_device(zest_device device) {
     zest_WaitForIdleDevice(device);
 
     zest__vk_cleanup_legacy_render_pass_cache(device);
+    //The physical device and driver don't change so the pipeline cache contents carry straight over to the
+    //new logical device.
+    zest_file cache_data = NULL;
+    zest_size cache_size = zest__vk_get_pipeline_cache_data(device, NULL, 0);
+    if (cache_size) {
+        zest_vec_resize(device->allocator, cache_data, (zest_uint)cache_size);
+        cache_size = zest__vk_get_pipeline_cache_data(device, cache_data, cache_size);
+    }
     vkDestroyPipelineCache(device->backend->logical_device, device->backend->pipeline_cache, &device->backend->allocation_callbacks);
+    device->backend->pipeline_cache = VK_NULL_HANDLE;
 
     zest_vec_foreach(i, device->queue_families) {
         zest_queue_manager manager = device->queue_families[i];
@@ -3025,15 +3306,13 @@ zest_bool zest__vk_reinit_logical_device(zest_device device) {
     device->backend->logical_device = VK_NULL_HANDLE;
 
     if (!zest__vk_create_logical_device(device)) {
+        zest_vec_free(device->allocator, cache_data);
         return ZEST_FALSE;
     }
 
-    VkPipelineCacheCreateInfo pipeline_cache_create_info = ZEST__ZERO_INIT(VkPipelineCacheCreateInfo);
-    pipeline_cache_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-    ZEST_SET_MEMORY_CONTEXT(device, zest_memory_context_context, zest_command_pipeline_cache);
-    ZEST_RETURN_FALSE_ON_FAIL(device, vkCreatePipelineCache(device->backend->logical_device, &pipeline_cache_create_info, &device->backend->allocation_callbacks, &device->backend->pipeline_cache));
-
-    return ZEST_TRUE;
+    zest_bool result = zest__vk_create_pipeline_cache(device, cache_size ? cache_data : NULL, cache_size);
+    zest_vec_free(device->allocator, cache_data);
+    return result;
 }
 
 void zest__vk_cleanup_context_backend(zest_context context) {
@@ -3091,11 +3370,23 @@ zest_semaphore_status zest__vk_wait_for_timeline(zest_execution_timeline timelin
 	} 
 	return zest_semaphore_status_error;
 }
+
+zest_u64 zest__vk_get_timeline_value(zest_execution_timeline timeline) {
+	zest_u64 value = 0;
+	vkGetSemaphoreCounterValue(timeline->device->backend->logical_device, timeline->backend->semaphore, &value);
+	return value;
+}
 // -- End Fences
 
 // -- Command_pools
 void zest__vk_reset_queue_command_pool(zest_context context, zest_context_queue queue, zest_bool release_resources) {
-    vkResetCommandPool(context->device->backend->logical_device, queue->backend->command_pool[context->current_fif], release_resources ? VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT : 0);
+    VkCommandPoolResetFlags flags = release_resources ? VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT : 0;
+    vkResetCommandPool(context->device->backend->logical_device, queue->backend->command_pool[context->current_fif], flags);
+    zest_vec_foreach(worker_index, queue->backend->worker_pools[context->current_fif]) {
+        zest_worker_command_pool_t *worker_pool = &queue->backend->worker_pools[context->current_fif][worker_index];
+        vkResetCommandPool(context->device->backend->logical_device, worker_pool->command_pool, flags);
+        worker_pool->next_buffer = 0;
+    }
 }
 // -- End Command_pools
 
@@ -3203,6 +3494,18 @@ void zest__vk_get_memory_budget(zest_device device, zest_memory_budget_t *budget
     }
 }
 
+zest_bool zest__vk_find_memory_heap(zest_device device, zest_memory_property_flags property_flags, zest_uint *heap_index, zest_size *heap_size) {
+    VkPhysicalDeviceMemoryProperties *memory_properties = &device->backend->memory_properties;
+    for (zest_uint i = 0; i != memory_properties->memoryTypeCount; ++i) {
+        if ((memory_properties->memoryTypes[i].propertyFlags & property_flags) == property_flags) {
+            *heap_index = memory_properties->memoryTypes[i].heapIndex;
+            *heap_size = (zest_size)memory_properties->memoryHeaps[*heap_index].size;
+            return ZEST_TRUE;
+        }
+    }
+    return ZEST_FALSE;
+}
+
 zest_bool zest__vk_add_buffer_memory_pool(zest_device device, zest_context context, zest_size size, zest_buffer_allocator buffer_allocator, zest_device_memory_pool memory_pool) {
     VkBufferCreateInfo create_buffer_info = ZEST__ZERO_INIT(VkBufferCreateInfo);
     create_buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -3688,10 +3991,27 @@ zest_bool zest__vk_build_pipeline_layout(zest_device device, zest_pipeline_layou
 
 zest_bool zest__vk_build_pipeline(zest_pipeline pipeline, zest_command_list command_list) {
 	zest_context context = command_list->context;
-
     zloc_linear_allocator_t *scratch = zest__get_scratch_arena(context->device);
+    zest_pipeline_template pipeline_template = pipeline->pipeline_template;
+    zest_shader vert_shader = (zest_shader)zest__get_store_resource_checked(pipeline_template->vertex_shader.store, pipeline_template->vertex_shader.value);
+	zest_shader frag_shader = 0;
+	if (pipeline_template->fragment_shader.value) {
+		frag_shader = (zest_shader)zest__get_store_resource_checked(pipeline_template->fragment_shader.store, pipeline_template->fragment_shader.value);
+	}
+	return zest__vk_build_pipeline_with(pipeline, &command_list->rendering_info, vert_shader, frag_shader, scratch, ZEST_FALSE);
+}
+
+zest_bool zest__vk_build_pipeline_background(zest_pipeline pipeline, const zest_rendering_info_t *rendering_info, zest_shader vert_shader, zest_shader frag_shader, zloc_linear_allocator_t *scratch) {
+	return zest__vk_build_pipeline_with(pipeline, rendering_info, vert_shader, frag_shader, scratch, ZEST_TRUE);
+}
 
+zest_bool zest__vk_build_pipeline_with(zest_pipeline pipeline, const zest_rendering_info_t *rendering_info, zest_shader vert_shader, zest_shader frag_shader, zloc_linear_allocator_t *scratch, zest_bool background) {
+	zest_context context = pipeline->context;
     zest_pipeline_template pipeline_template = pipeline->pipeline_template;
+	//Background builds still allocate through the context and device allocators, which are safe to use from
+	//job threads. They skip ZEST_SET_MEMORY_CONTEXT though as that tag is shared by every thread.
+	const VkAllocationCallbacks *pipeline_callbacks = &context->backend->allocation_callbacks;
+	const VkAllocationCallbacks *module_callbacks = &context->device->backend->allocation_callbacks;
 
     VkPipelineInputAssemblyStateCreateInfo input_assembly = ZEST__ZERO_INIT(VkPipelineInputAssemblyStateCreateInfo);
     VkPipelineViewportStateCreateInfo viewport_state = ZEST__ZERO_INIT(VkPipelineViewportStateCreateInfo);
@@ -3709,42 +4029,45 @@ zest_bool zest__vk_build_pipeline(zest_pipeline pipeline, zest_command_list comm
     VkVertexInputBindingDescription *binding_descriptions = 0;
     VkVertexInputAttributeDescription *attribute_descriptions = 0;
 	VkPipelineShaderStageCreateInfo shaderStages[2];
-	zest_shader frag_shader = 0;
 
     VkShaderModule vert_shader_module = ZEST__ZERO_INIT(VkShaderModule);
     VkShaderModule frag_shader_module = ZEST__ZERO_INIT(VkShaderModule);
 	zest_uint stage_count = 0;
-    zest_shader vert_shader = (zest_shader)zest__get_store_resource_checked(pipeline_template->vertex_shader.store, pipeline_template->vertex_shader.value);
+    VkShaderModuleCreateInfo module_info = ZEST__ZERO_INIT(VkShaderModuleCreateInfo);
+    module_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
     VkPipelineShaderStageCreateInfo vert_shader_stage_info = ZEST__ZERO_INIT(VkPipelineShaderStageCreateInfo);
 	VkResult result = VK_SUCCESS;
     if (ZEST_VALID_HANDLE(vert_shader, zest_struct_type_shader)) {
         if (!vert_shader->binary) {
-            ZEST_APPEND_LOG(context->device->log_path.str, "Vertex shader [%s] in pipeline [%s] did not have any spv data, make sure it's compiled.", vert_shader->name.str, pipeline_template->name);
+            if (!background) ZEST_APPEND_LOG(context->device->log_path.str, "Vertex shader [%s] in pipeline [%s] did not have any spv data, make sure it's compiled.", vert_shader->name.str, pipeline_template->name);
             result = VK_ERROR_UNKNOWN;
             goto cleanup;
         }
-        result = zest__vk_create_shader_module(context->device, vert_shader->binary, &vert_shader_module);
+        module_info.codeSize = zest_vec_size(vert_shader->binary);
+        module_info.pCode = (zest_uint*)vert_shader->binary;
+        if (!background) ZEST_SET_MEMORY_CONTEXT(context->device, zest_memory_context_device, zest_command_shader_module);
+        result = vkCreateShaderModule(context->device->backend->logical_device, &module_info, module_callbacks, &vert_shader_module);
         vert_shader_stage_info.module = vert_shader_module;
 		stage_count++;
     }
 
-	if (pipeline_template->fragment_shader.value) {
-		frag_shader = (zest_shader)zest__get_store_resource_checked(pipeline_template->fragment_shader.store, pipeline_template->fragment_shader.value);
-	}
     if (ZEST_VALID_HANDLE(frag_shader, zest_struct_type_shader)) {
         if (!frag_shader->binary) {
-            ZEST_APPEND_LOG(context->device->log_path.str, "Vertex shader [%s] in pipeline [%s] did not have any spv data, make sure it's compiled.", frag_shader->name.str, pipeline_template->name);
+            if (!background) ZEST_APPEND_LOG(context->device->log_path.str, "Vertex shader [%s] in pipeline [%s] did not have any spv data, make sure it's compiled.", frag_shader->name.str, pipeline_template->name);
             result = VK_ERROR_UNKNOWN;
             goto cleanup;
         }
-        result = zest__vk_create_shader_module(context->device, frag_shader->binary, &frag_shader_module);
+        module_info.codeSize = zest_vec_size(frag_shader->binary);
+        module_info.pCode = (zest_uint*)frag_shader->binary;
+        if (!background) ZEST_SET_MEMORY_CONTEXT(context->device, zest_memory_context_device, zest_command_shader_module);
+        result = vkCreateShaderModule(context->device->backend->logical_device, &module_info, module_callbacks, &frag_shader_module);
         frag_shader_stage_info.module = frag_shader_module;
 		frag_shader_stage_info.pName = pipeline_template->fragShaderFunctionName;
 		stage_count++;
     }
 
     if (result != VK_SUCCESS) {
-        ZEST_VK_PRINT_RESULT(context->device, result);
+        if (!background) ZEST_VK_PRINT_RESULT(context->device, result);
         goto cleanup;
     }
 
@@ -3832,7 +4155,7 @@ zest_bool zest__vk_build_pipeline(zest_pipeline pipeline, zest_command_list comm
 
 	//Todo: The pipeline should allow for a Number of color blend attachments
 	if (stage_count == 2) {
-		for (int i = 0; i != command_list->rendering_info.color_attachment_count; ++i) {
+		for (int i = 0; i != rendering_info->color_attachment_count; ++i) {
 			VkPipelineColorBlendAttachmentState color_attachment = ZEST__ZERO_INIT(VkPipelineColorBlendAttachmentState);
 			color_attachment.blendEnable = pipeline_template->color_blend_attachment.blend_enable;
 			color_attachment.srcColorBlendFactor = (VkBlendFactor)pipeline_template->color_blend_attachment.src_color_blend_factor;
@@ -3857,12 +4180,12 @@ zest_bool zest__vk_build_pipeline(zest_pipeline pipeline, zest_command_list comm
     color_blending.blendConstants[3] = 0.0f;
 
 	vk_rendering_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
-	vk_rendering_info.colorAttachmentCount = command_list->rendering_info.color_attachment_count;
-	vk_rendering_info.depthAttachmentFormat = zest__to_vk_format(command_list->rendering_info.depth_attachment_format);
-	vk_rendering_info.stencilAttachmentFormat = zest__to_vk_format(command_list->rendering_info.stencil_attachment_format);
+	vk_rendering_info.colorAttachmentCount = rendering_info->color_attachment_count;
+	vk_rendering_info.depthAttachmentFormat = zest__to_vk_format(rendering_info->depth_attachment_format);
+	vk_rendering_info.stencilAttachmentFormat = zest__to_vk_format(rendering_info->stencil_attachment_format);
 	VkFormat color_formats[ZEST_MAX_ATTACHMENTS];
-	for (int i = 0; i != command_list->rendering_info.color_attachment_count; ++i) {
-		color_formats[i] = zest__to_vk_format(command_list->rendering_info.color_attachment_formats[i]);
+	for (int i = 0; i != rendering_info->color_attachment_count; ++i) {
+		color_formats[i] = zest__to_vk_format(rendering_info->color_attachment_formats[i]);
 	}
 	vk_rendering_info.pColorAttachmentFormats = color_formats;
 	vk_rendering_info.viewMask = pipeline_template->view_mask;
@@ -3884,20 +4207,26 @@ zest_bool zest__vk_build_pipeline(zest_pipeline pipeline, zest_command_list comm
 	pipeline_info.pDynamicState = &dynamic_state;
 	pipeline_info.pNext = &vk_rendering_info;
 
-	ZEST_SET_MEMORY_CONTEXT(context, zest_memory_context_context, zest_command_pipelines);
-    result = vkCreateGraphicsPipelines(context->device->backend->logical_device, context->device->backend->pipeline_cache, 1, &pipeline_info, &context->backend->allocation_callbacks, &pipeline->backend->vk_pipeline);
+	if (!background) ZEST_SET_MEMORY_CONTEXT(context, zest_memory_context_context, zest_command_pipelines);
+    result = vkCreateGraphicsPipelines(context->device->backend->logical_device, context->device->backend->pipeline_cache, 1, &pipeline_info, pipeline_callbacks, &pipeline->backend->vk_pipeline);
     if (result != VK_SUCCESS) {
-        ZEST_VK_PRINT_RESULT(context->device, result);
-		ZEST__FLAG(pipeline_template->flags, zest_pipeline_invalid);
-		vkDestroyPipeline(context->device->backend->logical_device, pipeline->backend->vk_pipeline, &context->backend->allocation_callbacks);
-    } else {
-        ZEST_APPEND_LOG(context->device->log_path.str, "Built pipeline %s", pipeline_template->name);
-		ZEST__UNFLAG(pipeline_template->flags, zest_pipeline_invalid);
+		vkDestroyPipeline(context->device->backend->logical_device, pipeline->backend->vk_pipeline, pipeline_callbacks);
+		pipeline->backend->vk_pipeline = VK_NULL_HANDLE;
     }
+	//Background builds leave logging and the template flags to the main thread when it collects the result
+	if (!background) {
+		if (result != VK_SUCCESS) {
+			ZEST_VK_PRINT_RESULT(context->device, result);
+			ZEST__FLAG(pipeline_template->flags, zest_pipeline_invalid);
+		} else {
+			ZEST_APPEND_LOG(context->device->log_path.str, "Built pipeline %s", pipeline_template->name);
+			ZEST__UNFLAG(pipeline_template->flags, zest_pipeline_invalid);
+		}
+	}
 
 	cleanup:
-	vkDestroyShaderModule(context->device->backend->logical_device, frag_shader_module, &context->device->backend->allocation_callbacks);
-	vkDestroyShaderModule(context->device->backend->logical_device, vert_shader_module, &context->device->backend->allocation_callbacks);
+	vkDestroyShaderModule(context->device->backend->logical_device, frag_shader_module, module_callbacks);
+	vkDestroyShaderModule(context->device->backend->logical_device, vert_shader_module, module_callbacks);
     zloc_ResetLinearAllocator(scratch);
     return result == VK_SUCCESS ? ZEST_TRUE : ZEST_FALSE;
 }
@@ -4431,6 +4760,158 @@ zest_bool zest__vk_create_image(zest_device device, zest_context context, zest_i
     return ZEST_TRUE;
 }
 
+//One image in a zest__vk_create_images batch
+typedef struct zest_vk_batch_image_t {
+    VkMemoryRequirements requirements;
+    VkMemoryPropertyFlags properties;
+    VkImageUsageFlags usage;
+    zest_uint index;
+} zest_vk_batch_image_t;
+
+//A format and flags combination in a batch. Images in the same class have the same usage, tiling and create
+//flags so the driver gives them all the same answer to the dedicated allocation query.
+typedef struct zest_vk_image_class_t {
+    zest_format format;
+    zest_image_flags flags;
+    zest_bool driver_dedicated;
+} zest_vk_image_class_t;
+
+//Pooled images sort in to runs that share an image allocator (memory bits, alignment and properties), largest first
+int zest__vk_compare_pooled_images(const void *a, const void *b) {
+    const zest_vk_batch_image_t *image_a = (const zest_vk_batch_image_t*)a;
+    const zest_vk_batch_image_t *image_b = (const zest_vk_batch_image_t*)b;
+    if (image_a->requirements.memoryTypeBits != image_b->requirements.memoryTypeBits) return image_a->requirements.memoryTypeBits < image_b->requirements.memoryTypeBits ? -1 : 1;
+    if (image_a->requirements.alignment != image_b->requirements.alignment) return image_a->requirements.alignment < image_b->requirements.alignment ? -1 : 1;
+    if (image_a->properties != image_b->properties) return image_a->properties < image_b->properties ? -1 : 1;
+    if (image_a->requirements.size != image_b->requirements.size) return image_a->requirements.size > image_b->requirements.size ? -1 : 1;
+    return image_a->index < image_b->index ? -1 : 1;
+}
+
+zest_bool zest__vk_create_images(zest_device device, zest_image *images, zest_uint count) {
+    zloc_allocator *allocator = device->allocator;
+    zest_vk_batch_image_t *batch = (zest_vk_batch_image_t*)ZEST__ALLOCATE(allocator, sizeof(zest_vk_batch_image_t) * count);
+    zest_vk_batch_image_t *pooled = (zest_vk_batch_image_t*)ZEST__ALLOCATE(allocator, sizeof(zest_vk_batch_image_t) * count);
+    zest_size *sizes = (zest_size*)ZEST__ALLOCATE(allocator, sizeof(zest_size) * count);
+    zest_buffer *buffers = (zest_buffer*)ZEST__ALLOCATE(allocator, sizeof(zest_buffer) * count);
+    VkBindImageMemoryInfo *bind_infos = (VkBindImageMemoryInfo*)ZEST__ALLOCATE(allocator, sizeof(VkBindImageMemoryInfo) * count);
+    zest_vk_image_class_t *classes = 0;
+    zest_uint pooled_count = 0;
+    zest_bool result = ZEST_FALSE;
+
+    //Create every VkImage first. Only the first image of each class makes the dedicated allocation query.
+    for (zest_uint i = 0; i != count; ++i) {
+        zest_image image = images[i];
+        zest_vk_batch_image_t *entry = &batch[i];
+        entry->index = i;
+        if (!zest__vk_create_image_handle(device, image, image->info.layer_count, zest_sample_count_1_bit, image->info.flags, &entry->requirements, &entry->properties, &entry->usage)) {
+            goto cleanup;
+        }
+        if (entry->properties == 0) {
+            entry->properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        }
+        #ifdef ZEST_DEBUGGING
+        image->buffer_identifier = (void*)image->backend->vk_image;
+        #endif
+        zest_vk_image_class_t *image_class = 0;
+        zest_vec_foreach(c, classes) {
+            if (classes[c].format == image->info.format && classes[c].flags == image->info.flags) {
+                image_class = &classes[c];
+                break;
+            }
+        }
+        if (!image_class) {
+            VkMemoryDedicatedRequirements dedicated_requirements = ZEST__ZERO_INIT(VkMemoryDedicatedRequirements);
+            dedicated_requirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+            VkImageMemoryRequirementsInfo2 requirements_info = ZEST__ZERO_INIT(VkImageMemoryRequirementsInfo2);
+            requirements_info.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+            requirements_info.image = image->backend->vk_image;
+            VkMemoryRequirements2 requirements_2 = ZEST__ZERO_INIT(VkMemoryRequirements2);
+            requirements_2.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+            requirements_2.pNext = &dedicated_requirements;
+            vkGetImageMemoryRequirements2(device->backend->logical_device, &requirements_info, &requirements_2);
+            zest_vk_image_class_t new_class = { image->info.format, image->info.flags,
+                dedicated_requirements.requiresDedicatedAllocation != VK_FALSE || dedicated_requirements.prefersDedicatedAllocation != VK_FALSE };
+            zest_vec_push(allocator, classes, new_class);
+            image_class = &zest_vec_back(classes);
+        }
+        //The same rules as zest__vk_create_image for which images get their own allocation
+        zest_bool dedicated = image_class->driver_dedicated ||
+            entry->requirements.size >= device->setup_info.dedicated_image_memory_threshold ||
+            (entry->properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+        if (dedicated) {
+            zest_buffer_info_t buffer_info = ZEST__ZERO_INIT(zest_buffer_info_t);
+            buffer_info.image_usage_flags = entry->usage;
+            buffer_info.property_flags = entry->properties;
+            buffer_info.alignment = entry->requirements.alignment;
+            zest_device_memory memory = zest__create_device_memory(device, entry->requirements.size, &buffer_info, entry->requirements.memoryTypeBits);
+            if (!memory) {
+                goto cleanup;
+            }
+            image->buffer = (void*)memory;
+            image->info.flags |= zest_image_flag_dedicated_memory;
+        } else {
+            pooled[pooled_count++] = *entry;
+        }
+    }
+
+    //Sub-allocate the pooled images one allocator at a time, biggest first so that they're placed before the
+    //free space gets broken up by the small ones.
+    qsort(pooled, pooled_count, sizeof(zest_vk_batch_image_t), zest__vk_compare_pooled_images);
+    for (zest_uint run_start = 0; run_start != pooled_count;) {
+        zest_uint run_end = run_start + 1;
+        while (run_end != pooled_count &&
+               pooled[run_end].requirements.memoryTypeBits == pooled[run_start].requirements.memoryTypeBits &&
+               pooled[run_end].requirements.alignment == pooled[run_start].requirements.alignment &&
+               pooled[run_end].properties == pooled[run_start].properties) {
+            run_end++;
+        }
+        zest_buffer_info_t buffer_info = ZEST__ZERO_INIT(zest_buffer_info_t);
+        buffer_info.image_usage_flags = pooled[run_start].usage;
+        buffer_info.property_flags = pooled[run_start].properties;
+        buffer_info.alignment = pooled[run_start].requirements.alignment;
+        buffer_info.backend_memory_bits = pooled[run_start].requirements.memoryTypeBits;
+        for (zest_uint i = run_start; i != run_end; ++i) {
+            sizes[i - run_start] = pooled[i].requirements.size;
+        }
+        if (!zest__allocate_image_buffers(device, &buffer_info, sizes, run_end - run_start, buffers)) {
+            goto cleanup;
+        }
+        for (zest_uint i = run_start; i != run_end; ++i) {
+            images[pooled[i].index]->buffer = (void*)buffers[i - run_start];
+        }
+        run_start = run_end;
+    }
+
+    //Bind everything with one call
+    for (zest_uint i = 0; i != count; ++i) {
+        zest_image image = images[i];
+        VkBindImageMemoryInfo *bind_info = &bind_infos[i];
+        *bind_info = ZEST__ZERO_INIT(VkBindImageMemoryInfo);
+        bind_info->sType = VK_STRUCTURE_TYPE_BIND_IMAGE_MEMORY_INFO;
+        bind_info->image = image->backend->vk_image;
+        if (ZEST__FLAGGED(image->info.flags, zest_image_flag_dedicated_memory)) {
+            bind_info->memory = ((zest_device_memory)image->buffer)->backend->memory;
+            bind_info->memoryOffset = 0;
+        } else {
+            zest_buffer buffer = (zest_buffer)image->buffer;
+            bind_info->memory = zest__vk_get_buffer_device_memory(buffer);
+            bind_info->memoryOffset = buffer->memory_offset;
+        }
+    }
+    ZEST_CLEANUP_ON_FAIL(device, vkBindImageMemory2(device->backend->logical_device, count, bind_infos));
+    result = ZEST_TRUE;
+
+    cleanup:
+    //On failure the images keep whatever backing they got and zest__cleanup_image frees it along with the VkImage
+    zest_vec_free(allocator, classes);
+    ZEST__FREE(allocator, bind_infos);
+    ZEST__FREE(allocator, buffers);
+    ZEST__FREE(allocator, sizes);
+    ZEST__FREE(allocator, pooled);
+    ZEST__FREE(allocator, batch);
+    return result;
+}
+
 int zest__vk_get_image_raw_layout(zest_image image) {
     return (int)image->backend->vk_current_layout;
 }
@@ -4903,6 +5384,415 @@ zest_bool zest__vk_generate_mipmaps(zest_queue queue, zest_image image) {
 
     return ZEST_TRUE;
 }
+
+zest_bool zest__vk_create_image_streamer_backend(zest_image_streamer streamer) {
+	zest_device device = streamer->device;
+	ZEST_SET_MEMORY_CONTEXT(device, zest_memory_context_device, zest_command_command_pool);
+	streamer->backend = (zest_image_streamer_backend)ZEST__NEW(device->allocator, zest_image_streamer_backend);
+	*streamer->backend = ZEST__ZERO_INIT(zest_image_streamer_backend_t);
+	zest_image_streamer_backend backend = streamer->backend;
+
+	//Command buffers are only reused once the batch that used them is done so each one is reset on begin
+	VkCommandPoolCreateInfo cmd_info_pool = ZEST__ZERO_INIT(VkCommandPoolCreateInfo);
+	cmd_info_pool.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	cmd_info_pool.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	cmd_info_pool.queueFamilyIndex = streamer->graphics_manager->family_index;
+	ZEST_RETURN_FALSE_ON_FAIL(device, vkCreateCommandPool(device->backend->logical_device, &cmd_info_pool, &device->backend->allocation_callbacks, &backend->graphics_pool));
+
+	VkCommandBufferAllocateInfo alloc_info = ZEST__ZERO_INIT(VkCommandBufferAllocateInfo);
+	alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	alloc_info.commandPool = backend->graphics_pool;
+	alloc_info.commandBufferCount = ZEST_STREAM_BATCHES_IN_FLIGHT;
+	ZEST_SET_MEMORY_CONTEXT(device, zest_memory_context_device, zest_command_command_buffer);
+	ZEST_RETURN_FALSE_ON_FAIL(device, vkAllocateCommandBuffers(device->backend->logical_device, &alloc_info, backend->graphics_buffers));
+
+	if (streamer->transfer_manager == streamer->graphics_manager) {
+		memcpy(backend->transfer_buffers, backend->graphics_buffers, sizeof(backend->transfer_buffers));
+		return ZEST_TRUE;
+	}
+
+	cmd_info_pool.queueFamilyIndex = streamer->transfer_manager->family_index;
+	ZEST_SET_MEMORY_CONTEXT(device, zest_memory_context_device, zest_command_command_pool);
+	ZEST_RETURN_FALSE_ON_FAIL(device, vkCreateCommandPool(device->backend->logical_device, &cmd_info_pool, &device->backend->allocation_callbacks, &backend->transfer_pool));
+	alloc_info.commandPool = backend->transfer_pool;
+	ZEST_SET_MEMORY_CONTEXT(device, zest_memory_context_device, zest_command_command_buffer);
+	ZEST_RETURN_FALSE_ON_FAIL(device, vkAllocateCommandBuffers(device->backend->logical_device, &alloc_info, backend->transfer_buffers));
+	return ZEST_TRUE;
+}
+
+void zest__vk_cleanup_image_streamer_backend(zest_image_streamer streamer) {
+	zest_device device = streamer->device;
+	zest_image_streamer_backend backend = streamer->backend;
+	//Destroying the pools frees their command buffers
+	if (backend->transfer_pool) {
+		vkDestroyCommandPool(device->backend->logical_device, backend->transfer_pool, &device->backend->allocation_callbacks);
+	}
+	if (backend->graphics_pool) {
+		vkDestroyCommandPool(device->backend->logical_device, backend->graphics_pool, &device->backend->allocation_callbacks);
+	}
+	ZEST__FREE(device->allocator, backend);
+	streamer->backend = 0;
+}
+
+zest_bool zest__vk_submit_image_stream_batch(zest_image_streamer streamer, zest_image_stream_batch_t *batch, zest_image_stream_request_t *requests, zest_uint request_count) {
+	zest_device device = streamer->device;
+	zest_image_streamer_backend backend = streamer->backend;
+	zest_bool transfer_ownership = streamer->transfer_manager != streamer->graphics_manager;
+
+	//Queues are only held for as long as it takes to submit, the command buffers belong to the streamer
+	zest_queue transfer_queue = zest__acquire_manager_queue(streamer->transfer_manager);
+	if (!transfer_queue) {
+		return ZEST_FALSE;
+	}
+	zest_queue graphics_queue = transfer_queue;
+	if (transfer_ownership) {
+		graphics_queue = zest__acquire_manager_queue(streamer->graphics_manager);
+		if (!graphics_queue) {
+			zest__release_queue(transfer_queue);
+			return ZEST_FALSE;
+		}
+	}
+
+	VkCommandBuffer transfer_buffer = backend->transfer_buffers[batch->index];
+	VkCommandBuffer graphics_buffer = backend->graphics_buffers[batch->index];
+	VkCommandBuffer graphics_queue_buffer = graphics_queue->backend->command_buffer;
+	zest_bool result = ZEST_FALSE;
+
+	VkCommandBufferBeginInfo begin_info = ZEST__ZERO_INIT(VkCommandBufferBeginInfo);
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	ZEST_CLEANUP_ON_FAIL(device, vkBeginCommandBuffer(transfer_buffer, &begin_info));
+	if (transfer_ownership) {
+		ZEST_CLEANUP_ON_FAIL(device, vkBeginCommandBuffer(graphics_buffer, &begin_info));
+	}
+
+	//The mip generation and layout helpers record in to whatever command buffer the queue holds
+	graphics_queue->backend->command_buffer = graphics_buffer;
+
+	for (zest_uint i = 0; i != request_count; ++i) {
+		zest_image_stream_request_t *request = &requests[i];
+		zest_image image = request->image;
+
+		VkImageMemoryBarrier barrier = ZEST__ZERO_INIT(VkImageMemoryBarrier);
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.image = image->backend->vk_image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.levelCount = image->info.mip_levels;
+		barrier.subresourceRange.layerCount = image->info.layer_count;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(transfer_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, ZEST_NULL, 0, ZEST_NULL, 1, &barrier);
+
+		VkBufferImageCopy region = ZEST__ZERO_INIT(VkBufferImageCopy);
+		region.bufferOffset = streamer->staging_ring->memory_offset + request->ring_offset;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = image->info.layer_count;
+		region.imageExtent.width = image->info.extent.width;
+		region.imageExtent.height = image->info.extent.height;
+		region.imageExtent.depth = image->info.extent.depth > 1 ? image->info.extent.depth : 1;
+		vkCmdCopyBufferToImage(transfer_buffer, streamer->staging_ring->memory_pool->backend->vk_buffer, image->backend->vk_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+		if (transfer_ownership) {
+			//Release from the transfer family and acquire on the graphics family. The layout stays as transfer
+			//dst so that the graphics queue can blit the mips straight away.
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcQueueFamilyIndex = streamer->transfer_manager->family_index;
+			barrier.dstQueueFamilyIndex = streamer->graphics_manager->family_index;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = 0;
+			vkCmdPipelineBarrier(transfer_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, ZEST_NULL, 0, ZEST_NULL, 1, &barrier);
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+			vkCmdPipelineBarrier(graphics_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, ZEST_NULL, 0, ZEST_NULL, 1, &barrier);
+		}
+
+		image->backend->vk_current_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		image->layout = zest_image_layout_transfer_dst_optimal;
+		if (image->info.mip_levels <= 1 || !zest__vk_generate_mipmaps(graphics_queue, image)) {
+			zest__vk_transition_image_layout(graphics_queue, image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0, image->info.mip_levels, 0, image->info.layer_count);
+		}
+	}
+
+	graphics_queue->backend->command_buffer = graphics_queue_buffer;
+	ZEST_CLEANUP_ON_FAIL(device, vkEndCommandBuffer(transfer_buffer));
+	if (transfer_ownership) {
+		ZEST_CLEANUP_ON_FAIL(device, vkEndCommandBuffer(graphics_buffer));
+	}
+
+	{
+		zest_execution_timeline timeline = streamer->timeline;
+		VkCommandBufferSubmitInfo buffer_submit_info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO };
+		buffer_submit_info.commandBuffer = transfer_buffer;
+		VkSemaphoreSubmitInfo signal_info = { VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
+		signal_info.semaphore = timeline->backend->semaphore;
+		signal_info.value = timeline->current_value + 1;
+		signal_info.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		VkSubmitInfo2 submit_info = { VK_STRUCTURE_TYPE_SUBMIT_INFO_2 };
+		submit_info.commandBufferInfoCount = 1;
+		submit_info.pCommandBufferInfos = &buffer_submit_info;
+		submit_info.signalSemaphoreInfoCount = 1;
+		submit_info.pSignalSemaphoreInfos = &signal_info;
+		ZEST_CLEANUP_ON_FAIL(device, device->backend->pfn_vkQueueSubmit2(transfer_queue->backend->vk_queue, 1, &submit_info, VK_NULL_HANDLE));
+		timeline->current_value++;
+
+		if (transfer_ownership) {
+			//The graphics half waits on the GPU for the copies, the CPU never waits on either
+			VkSemaphoreSubmitInfo wait_info = signal_info;
+			wait_info.stageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+			signal_info.value = timeline->current_value + 1;
+			buffer_submit_info.commandBuffer = graphics_buffer;
+			submit_info.waitSemaphoreInfoCount = 1;
+			submit_info.pWaitSemaphoreInfos = &wait_info;
+			ZEST_CLEANUP_ON_FAIL(device, device->backend->pfn_vkQueueSubmit2(graphics_queue->backend->vk_queue, 1, &submit_info, VK_NULL_HANDLE));
+			timeline->current_value++;
+		}
+		batch->timeline_value = timeline->current_value;
+	}
+	result = ZEST_TRUE;
+
+cleanup:
+	graphics_queue->backend->command_buffer = graphics_queue_buffer;
+	if (transfer_ownership) {
+		zest__release_queue(graphics_queue);
+	}
+	zest__release_queue(transfer_queue);
+	return result;
+}
+
+zest_bool zest__vk_create_readback_backend(zest_context context) {
+	zest_device device = context->device;
+	ZEST_SET_MEMORY_CONTEXT(device, zest_memory_context_device, zest_command_command_pool);
+	context->readbacks.backend = (zest_readback_backend)ZEST__NEW(device->allocator, zest_readback_backend);
+	*context->readbacks.backend = ZEST__ZERO_INIT(zest_readback_backend_t);
+	zest_readback_backend backend = context->readbacks.backend;
+
+	VkCommandPoolCreateInfo cmd_info_pool = ZEST__ZERO_INIT(VkCommandPoolCreateInfo);
+	cmd_info_pool.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	cmd_info_pool.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	cmd_info_pool.queueFamilyIndex = device->queue_pool[zest_queue_graphics]->managers[0]->family_index;
+	ZEST_RETURN_FALSE_ON_FAIL(device, vkCreateCommandPool(device->backend->logical_device, &cmd_info_pool, &device->backend->allocation_callbacks, &backend->command_pool));
+
+	VkCommandBufferAllocateInfo alloc_info = ZEST__ZERO_INIT(VkCommandBufferAllocateInfo);
+	alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	alloc_info.commandPool = backend->command_pool;
+	alloc_info.commandBufferCount = ZEST_READBACK_SUBMITS_IN_FLIGHT;
+	ZEST_SET_MEMORY_CONTEXT(device, zest_memory_context_device, zest_command_command_buffer);
+	ZEST_RETURN_FALSE_ON_FAIL(device, vkAllocateCommandBuffers(device->backend->logical_device, &alloc_info, backend->command_buffers));
+	return ZEST_TRUE;
+}
+
+void zest__vk_cleanup_readback_backend(zest_context context) {
+	zest_device device = context->device;
+	zest_readback_backend backend = context->readbacks.backend;
+	if (backend->command_pool) {
+		vkDestroyCommandPool(device->backend->logical_device, backend->command_pool, &device->backend->allocation_callbacks);
+	}
+	ZEST__FREE(device->allocator, backend);
+	context->readbacks.backend = 0;
+}
+
+void zest__vk_record_readback(zest_device device, VkCommandBuffer command_buffer, zest_readback_copy_t *copy, VkImageLayout image_layout, zest_buffer ring) {
+	VkBuffer ring_buffer = ring->memory_pool->backend->vk_buffer;
+	if (copy->image) {
+		zest_image image = copy->image;
+		VkBufferImageCopy region = ZEST__ZERO_INIT(VkBufferImageCopy);
+		region.bufferOffset = ring->memory_offset + copy->ring_offset;
+		//Only one aspect can be copied at a time, depth/stencil images read back their depth
+		region.imageSubresource.aspectMask = (image->info.aspect_flags & VK_IMAGE_ASPECT_DEPTH_BIT) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = copy->region.mip_level;
+		region.imageSubresource.baseArrayLayer = copy->region.base_layer;
+		region.imageSubresource.layerCount = copy->region.layer_count;
+		region.imageOffset.x = (int32_t)copy->region.x;
+		region.imageOffset.y = (int32_t)copy->region.y;
+		region.imageExtent.width = copy->region.width;
+		region.imageExtent.height = copy->region.height;
+		region.imageExtent.depth = 1;
+		vkCmdCopyImageToBuffer(command_buffer, image->backend->vk_image, image_layout, ring_buffer, 1, &region);
+	} else {
+		VkBufferCopy region = ZEST__ZERO_INIT(VkBufferCopy);
+		region.srcOffset = copy->buffer->memory_offset + copy->buffer_offset;
+		region.dstOffset = ring->memory_offset + copy->ring_offset;
+		region.size = copy->size;
+		vkCmdCopyBuffer(command_buffer, copy->buffer->memory_pool->backend->vk_buffer, ring_buffer, 1, &region);
+	}
+	//Make the copy visible to the host once the timeline wait says it's done
+	VkBufferMemoryBarrier2 host_barrier = zest__vk_create_buffer_memory_barrier(ring_buffer,
+		VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+		VK_ACCESS_2_HOST_READ_BIT, VK_PIPELINE_STAGE_2_HOST_BIT,
+		ring->memory_offset + copy->ring_offset, copy->size);
+	zest__vk_pipeline_barrier2(device, command_buffer, 0, 0, 0, 1, &host_barrier, 0, 0);
+}
+
+void zest__vk_cmd_readback(const zest_command_list command_list, zest_readback_copy_t *copy) {
+	//The frame graph has already moved the source in to a transfer read state for the pass
+	zest__vk_record_readback(command_list->device, command_list->backend->command_buffer, copy, (VkImageLayout)copy->image_layout, command_list->context->readbacks.buffer);
+}
+
+zest_bool zest__vk_submit_readback(zest_context context, zest_readback_copy_t *copy, zest_uint slot, zest_u64 signal_value) {
+	zest_device device = context->device;
+	zest_readback_backend backend = context->readbacks.backend;
+	VkCommandBuffer command_buffer = backend->command_buffers[slot];
+	zest_queue queue = zest__acquire_manager_queue(device->queue_pool[zest_queue_graphics]->managers[0]);
+	if (!queue) {
+		return ZEST_FALSE;
+	}
+	zest_bool result = ZEST_FALSE;
+
+	VkCommandBufferBeginInfo begin_info = ZEST__ZERO_INIT(VkCommandBufferBeginInfo);
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	ZEST_CLEANUP_ON_FAIL(device, vkBeginCommandBuffer(command_buffer, &begin_info));
+
+	if (copy->image) {
+		//Move the layers being read to transfer src and back again afterwards so the image is left as it was found
+		zest_image image = copy->image;
+		VkImageLayout original_layout = image->backend->vk_current_layout;
+		VkImageMemoryBarrier2 barrier = zest__vk_create_image_memory_barrier(image->backend->vk_image,
+			VK_ACCESS_2_MEMORY_WRITE_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+			VK_ACCESS_2_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+			original_layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			image->info.aspect_flags, copy->region.mip_level, 1, copy->region.layer_count);
+		barrier.subresourceRange.baseArrayLayer = copy->region.base_layer;
+		zest__vk_pipeline_barrier2(device, command_buffer, 0, 0, 0, 0, 0, 1, &barrier);
+		zest__vk_record_readback(device, command_buffer, copy, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, context->readbacks.buffer);
+		barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+		barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+		barrier.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT;
+		barrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.newLayout = original_layout;
+		zest__vk_pipeline_barrier2(device, command_buffer, 0, 0, 0, 0, 0, 1, &barrier);
+	} else {
+		VkBufferMemoryBarrier2 barrier = zest__vk_create_buffer_memory_barrier(copy->buffer->memory_pool->backend->vk_buffer,
+			VK_ACCESS_2_MEMORY_WRITE_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+			VK_ACCESS_2_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+			copy->buffer->memory_offset + copy->buffer_offset, copy->size);
+		zest__vk_pipeline_barrier2(device, command_buffer, 0, 0, 0, 1, &barrier, 0, 0);
+		zest__vk_record_readback(device, command_buffer, copy, VK_IMAGE_LAYOUT_UNDEFINED, context->readbacks.buffer);
+	}
+	ZEST_CLEANUP_ON_FAIL(device, vkEndCommandBuffer(command_buffer));
+
+	{
+		VkCommandBufferSubmitInfo buffer_submit_info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO };
+		buffer_submit_info.commandBuffer = command_buffer;
+		VkSemaphoreSubmitInfo signal_info = { VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
+		signal_info.semaphore = context->readbacks.timeline->backend->semaphore;
+		signal_info.value = signal_value;
+		signal_info.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		VkSubmitInfo2 submit_info = { VK_STRUCTURE_TYPE_SUBMIT_INFO_2 };
+		submit_info.commandBufferInfoCount = 1;
+		submit_info.pCommandBufferInfos = &buffer_submit_info;
+		submit_info.signalSemaphoreInfoCount = 1;
+		submit_info.pSignalSemaphoreInfos = &signal_info;
+		ZEST_CLEANUP_ON_FAIL(device, device->backend->pfn_vkQueueSubmit2(queue->backend->vk_queue, 1, &submit_info, VK_NULL_HANDLE));
+	}
+	result = ZEST_TRUE;
+
+cleanup:
+	zest__release_queue(queue);
+	return result;
+}
+
+void zest__vk_invalidate_buffer(zest_buffer buffer, zest_size offset, zest_size size) {
+	zest_device_memory_pool pool = buffer->memory_pool;
+	zest_device device = pool->device;
+	VkMemoryPropertyFlags properties = device->backend->memory_properties.memoryTypes[pool->backend->memory_type_index].propertyFlags;
+	if (properties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {
+		return;
+	}
+	//Ranges have to be aligned to nonCoherentAtomSize, rounding out can only ever cover more of the pool
+	zest_size atom = ZEST__MAX((zest_size)1, (zest_size)device->backend->properties.limits.nonCoherentAtomSize);
+	zest_size start = (buffer->memory_offset + offset) / atom * atom;
+	zest_size end = (buffer->memory_offset + offset + size + atom - 1) / atom * atom;
+	VkMappedMemoryRange range = ZEST__ZERO_INIT(VkMappedMemoryRange);
+	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	range.memory = pool->backend->memory;
+	range.offset = start;
+	range.size = end >= pool->size ? VK_WHOLE_SIZE : end - start;
+	vkInvalidateMappedMemoryRanges(device->backend->logical_device, 1, &range);
+}
+void zest__vk_cmd_update_virtual_texture(const zest_command_list command_list, zest_virtual_texture virtual_texture, zest_virtual_texture_resources_t *resources, zest_uint fif) {
+	zest_device device = command_list->device;
+	VkCommandBuffer command_buffer = command_list->backend->command_buffer;
+	VkBuffer staging_buffer = virtual_texture->staging->memory_pool->backend->vk_buffer;
+	zest_size frame_offset = virtual_texture->staging->memory_offset + fif * virtual_texture->frame_staging_size;
+
+	//Clear the feedback for the passes that sample the virtual texture this frame. The feedback pass of the last
+	//frame has already copied out what it needed.
+	zest_buffer feedback = virtual_texture->feedback;
+	VkBuffer feedback_buffer = feedback->memory_pool->backend->vk_buffer;
+	zest_size feedback_size = virtual_texture->total_pages * sizeof(zest_uint);
+	VkBufferMemoryBarrier2 feedback_barrier = zest__vk_create_buffer_memory_barrier(feedback_buffer,
+		VK_ACCESS_2_MEMORY_READ_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+		VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+		feedback->memory_offset, feedback_size);
+	zest__vk_pipeline_barrier2(device, command_buffer, 0, 0, 0, 1, &feedback_barrier, 0, 0);
+	vkCmdFillBuffer(command_buffer, feedback_buffer, feedback->memory_offset, feedback_size, 0);
+	feedback_barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+	feedback_barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+	feedback_barrier.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+	feedback_barrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+	zest__vk_pipeline_barrier2(device, command_buffer, 0, 0, 0, 1, &feedback_barrier, 0, 0);
+
+	//The page cache and page table are outputs of the upload pass, so the frame graph has already put them in
+	//TRANSFER_DST_OPTIMAL and moves them on to whatever the sampling passes need afterwards.
+	zest_virtual_page_upload_t *uploads = virtual_texture->uploads[fif];
+	if (zest_vec_size(uploads)) {
+		//Only the pages being replaced are written, the rest of the cache keeps its contents
+		zest_image cache = &resources->page_cache->image;
+		VkBufferImageCopy regions[32];
+		zest_uint region_count = 0;
+		zest_uint slot_size = virtual_texture->slot_size;
+		zest_vec_foreach(i, uploads) {
+			VkBufferImageCopy *region = &regions[region_count++];
+			*region = ZEST__ZERO_INIT(VkBufferImageCopy);
+			region->bufferOffset = frame_offset + uploads[i].staging_offset;
+			region->imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region->imageSubresource.layerCount = 1;
+			region->imageOffset.x = (int32_t)((uploads[i].slot % virtual_texture->info.cache_pages_x) * slot_size);
+			region->imageOffset.y = (int32_t)((uploads[i].slot / virtual_texture->info.cache_pages_x) * slot_size);
+			region->imageExtent.width = slot_size;
+			region->imageExtent.height = slot_size;
+			region->imageExtent.depth = 1;
+			if (region_count == 32 || i + 1 == zest_vec_size(uploads)) {
+				vkCmdCopyBufferToImage(command_buffer, staging_buffer, cache->backend->vk_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, region_count, regions);
+				region_count = 0;
+			}
+		}
+	}
+
+	if (virtual_texture->upload_page_table[fif]) {
+		//Every level of the page table is staged in one block, one texel per page
+		zest_image table = &resources->page_table->image;
+		VkBufferImageCopy regions[ZEST_MAX_VIRTUAL_TEXTURE_MIPS];
+		for (zest_uint mip = 0; mip != virtual_texture->mip_count; ++mip) {
+			VkBufferImageCopy *region = &regions[mip];
+			*region = ZEST__ZERO_INIT(VkBufferImageCopy);
+			region->bufferOffset = frame_offset + virtual_texture->page_table_offset + virtual_texture->mip_offsets[mip] * sizeof(zest_uint);
+			region->imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region->imageSubresource.mipLevel = mip;
+			region->imageSubresource.layerCount = 1;
+			region->imageExtent.width = virtual_texture->pages_x >> mip;
+			region->imageExtent.height = virtual_texture->pages_y >> mip;
+			region->imageExtent.depth = 1;
+		}
+		vkCmdCopyBufferToImage(command_buffer, staging_buffer, table->backend->vk_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, virtual_texture->mip_count, regions);
+	}
+}
+
+void zest__vk_cmd_shader_write_barrier(const zest_command_list command_list, zest_buffer buffer) {
+	VkBufferMemoryBarrier2 barrier = zest__vk_create_buffer_memory_barrier(buffer->memory_pool->backend->vk_buffer,
+		VK_ACCESS_2_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+		VK_ACCESS_2_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+		buffer->memory_offset, buffer->size);
+	zest__vk_pipeline_barrier2(command_list->device, command_list->backend->command_buffer, 0, 0, 0, 1, &barrier, 0, 0);
+}
 // -- End images
 
 // -- General_helpers
@@ -5193,6 +6083,47 @@ zest_bool zest__vk_set_next_command_buffer(zest_command_list command_list, zest_
 	return ZEST_FALSE;
 }
 
+zest_bool zest__vk_prepare_worker_command_pools(zest_context context, zest_context_queue queue, zest_uint worker_count) {
+    zest_worker_command_pool_t **worker_pools = &queue->backend->worker_pools[context->current_fif];
+    zest_uint existing_count = zest_vec_size(*worker_pools);
+    if (existing_count >= worker_count) {
+        return ZEST_TRUE;
+    }
+	VkCommandPoolCreateInfo cmd_info_pool = ZEST__ZERO_INIT(VkCommandPoolCreateInfo);
+	cmd_info_pool.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	cmd_info_pool.queueFamilyIndex = queue->queue_manager->family_index;
+	cmd_info_pool.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    for (zest_uint worker_index = existing_count; worker_index != worker_count; ++worker_index) {
+        zest_worker_command_pool_t worker_pool = ZEST__ZERO_INIT(zest_worker_command_pool_t);
+		ZEST_SET_MEMORY_CONTEXT(context, zest_memory_context_context, zest_command_command_pool);
+		ZEST_RETURN_FALSE_ON_FAIL(context->device, vkCreateCommandPool(context->device->backend->logical_device, &cmd_info_pool, &context->backend->allocation_callbacks, &worker_pool.command_pool));
+        zest_vec_push(context->allocator, *worker_pools, worker_pool);
+    }
+    return ZEST_TRUE;
+}
+
+zest_bool zest__vk_set_worker_command_buffer(zest_command_list command_list, zest_context_queue queue, zest_uint worker_index) {
+	zest_context context = command_list->context;
+    ZEST_ASSERT(worker_index < zest_vec_size(queue->backend->worker_pools[context->current_fif]));   //Call prepare_worker_command_pools first
+    zest_worker_command_pool_t *worker_pool = &queue->backend->worker_pools[context->current_fif][worker_index];
+    if (zest_vec_size(worker_pool->command_buffers) <= worker_pool->next_buffer) {
+		VkCommandBufferAllocateInfo alloc_info = ZEST__ZERO_INIT(VkCommandBufferAllocateInfo);
+		alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		alloc_info.commandBufferCount = 1;
+		alloc_info.commandPool = worker_pool->command_pool;
+        VkCommandBuffer new_command_buffer;
+        VkResult result = vkAllocateCommandBuffers(context->device->backend->logical_device, &alloc_info, &new_command_buffer);
+        if (result != VK_SUCCESS) {
+            ZEST_VK_PRINT_RESULT(context->device, result);
+			return ZEST_FALSE;
+        }
+        zest_vec_push(context->allocator, worker_pool->command_buffers, new_command_buffer);
+    }
+    command_list->backend->command_buffer = worker_pool->command_buffers[worker_pool->next_buffer++];
+    return ZEST_TRUE;
+}
+
 void *zest__vk_new_execution_backend(zloc_linear_allocator_t *allocator) {
     zest_execution_backend backend = (zest_execution_backend)zest__linear_allocate(allocator, sizeof(zest_execution_backend_t));
     *backend = ZEST__ZERO_INIT(zest_execution_backend_t);
@@ -5714,20 +6645,31 @@ zest_bool zest__vk_submit_frame_graph_batch(zest_frame_graph frame_graph, zest_e
     VkSemaphore batch_semaphore = frame_graph->semaphores->backend->vk_semaphores[context->current_fif][queue_index];
     zest_size *batch_value = &frame_graph->semaphores->values[context->current_fif][queue_index];
 
-    VkCommandBuffer command_buffer = frame_graph->command_list.backend->command_buffer;
+    zloc_linear_allocator_t *allocator = &context->frame_graph_allocator[context->current_fif];
 
+	//A batch recorded in parallel has a command buffer per pass group. They're submitted in the order of
+	//the pass groups, so barriers recorded in one still apply to the ones after it in the submission.
 	VkCommandBufferSubmitInfo command_buffer_info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO };
-	command_buffer_info.commandBuffer = command_buffer;
+	command_buffer_info.commandBuffer = frame_graph->command_list.backend->command_buffer;
+	VkCommandBufferSubmitInfo *command_buffer_infos = 0;
+	zest_vec_foreach(i, frame_graph->batch_command_lists) {
+		VkCommandBufferSubmitInfo info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO };
+		info.commandBuffer = frame_graph->batch_command_lists[i].backend->command_buffer;
+		zest_vec_linear_push(allocator, command_buffer_infos, info);
+	}
 
 	VkSubmitInfo2 submit_info2 = { VK_STRUCTURE_TYPE_SUBMIT_INFO_2 };
-	submit_info2.commandBufferInfoCount = 1;
-	submit_info2.pCommandBufferInfos = &command_buffer_info;
+	if (command_buffer_infos) {
+		submit_info2.commandBufferInfoCount = zest_vec_size(command_buffer_infos);
+		submit_info2.pCommandBufferInfos = command_buffer_infos;
+	} else {
+		submit_info2.commandBufferInfoCount = 1;
+		submit_info2.pCommandBufferInfos = &command_buffer_info;
+	}
 
     // Set signal semaphores for this batch
     zest_context_queue queue = batch->queue;
 
-    zloc_linear_allocator_t *allocator = &context->frame_graph_allocator[context->current_fif];
-
     //Track which queues this frame graph used so their frame-in-flight indexes cycle at the end
     //of execution. (An interframe timeline wait was once computed here but never attached to any
     //semaphore; cross-frame transient safety is handled by per-FIF arenas instead.)
@@ -5939,6 +6881,12 @@ void zest__vk_draw_indexed_indirect(const zest_command_list command_list, zest_b
     vkCmdDrawIndexedIndirect(command_list->backend->command_buffer, buffer->memory_pool->backend->vk_buffer, buffer->memory_offset + draw_offset, draw_count, stride);
 }
 
+void zest__vk_draw_indexed_indirect_count(const zest_command_list command_list, zest_buffer buffer, zest_size offset, zest_buffer count_buffer, zest_size count_offset, zest_uint max_draw_count, zest_uint stride) {
+	zest_size draw_offset = offset * stride;
+    vkCmdDrawIndexedIndirectCount(command_list->backend->command_buffer, buffer->memory_pool->backend->vk_buffer, buffer->memory_offset + draw_offset,
+		count_buffer->memory_pool->backend->vk_buffer, count_buffer->memory_offset + count_offset, max_draw_count, stride);
+}
+
 void zest__vk_draw_indirect(const zest_command_list command_list, zest_buffer buffer, zest_size offset, zest_uint draw_count, zest_uint stride) {
 	zest_size draw_offset = offset * stride;
     vkCmdDrawIndirect(command_list->backend->command_buffer, buffer->memory_pool->backend->vk_buffer, buffer->memory_offset + draw_offset, draw_count, stride);
@@ -6948,6 +7896,61 @@ zest_bool zest__vk_compile_shader(zest_shader shader, const char *code, zest_uin
 	return ZEST_TRUE;
 }
 
+zest_bool zest__vk_prepare_shader_compilers(zest_device device, zest_uint count) {
+	while (zest_vec_size(device->backend->shaderc_compilers) < count) {
+		shaderc_compiler_t compiler = shaderc_compiler_initialize();
+		if (!compiler) {
+			ZEST_APPEND_LOG(device->log_path.str, "Unable to create a shader compiler for batch compiling.");
+			return ZEST_FALSE;
+		}
+		zest_vec_push(device->allocator, device->backend->shaderc_compilers, compiler);
+	}
+	return ZEST_TRUE;
+}
+
+void zest__vk_compile_shader_job(zest_device device, zest_shader_compile_job_t *job, zest_uint compiler_index) {
+	//Runs on a job thread: shaderc allocates for itself so nothing here touches the device allocator
+	zest_shader shader = job->shader;
+	shaderc_compiler_t compiler = device->backend->shaderc_compilers[compiler_index];
+    shaderc_compile_options_t shaderc_options = shaderc_compile_options_initialize();
+	if (job->options) {
+		zest_vec_foreach(i, job->options->macro_definitions) {
+			zest_macro_definition_t *definition = &job->options->macro_definitions[i];
+			shaderc_compile_options_add_macro_definition(shaderc_options, definition->name.str, zest_TextLength(&definition->name), definition->value.str, zest_TextLength(&definition->value));
+		}
+	}
+    shaderc_compilation_result_t result = shaderc_compile_into_spv(compiler, shader->shader_code.str, zest_TextLength(&shader->shader_code), zest__to_shaderc_shader_kind(shader->type), shader->name.str, "main", shaderc_options);
+	shaderc_compile_options_release(shaderc_options);
+	job->result = result;
+	job->succeeded = result && shaderc_result_get_compilation_status(result) == shaderc_compilation_status_success;
+}
+
+zest_bool zest__vk_finish_shader_job(zest_shader shader, zest_shader_compile_job_t *job) {
+	zest_device device = (zest_device)shader->handle.store->origin;
+	shaderc_compilation_result_t result = (shaderc_compilation_result_t)job->result;
+	job->result = 0;
+	if (!result) {
+        zest_SetText(device->allocator, &shader->last_error, "Shader compiler unavailable");
+        ZEST_APPEND_LOG(device->log_path.str, "The shader compiler was unavailable so shader %s could not be compiled", shader->name.str);
+		return ZEST_FALSE;
+	}
+	if (!job->succeeded) {
+        const char *err = shaderc_result_get_error_message(result);
+        zest_SetText(device->allocator, &shader->last_error, err ? err : "Unknown compile error");
+		ZEST_APPEND_LOG(device->log_path.str, "Shader compilation failed: %s, %s", shader->name.str, err);
+		ZEST_ALERT("Shader compilation failed: %s, %s", shader->name.str, err);
+        shaderc_result_release(result);
+		return ZEST_FALSE;
+	}
+    zest_FreeText(device->allocator, &shader->last_error);
+    zest_uint spv_size = (zest_uint)shaderc_result_get_length(result);
+    zest_vec_resize(device->allocator, shader->binary, spv_size);
+    memcpy(shader->binary, shaderc_result_get_bytes(result), spv_size);
+    shader->binary_size = spv_size;
+    shaderc_result_release(result);
+	return ZEST_TRUE;
+}
+
 // -- End Shader_compiling
 
 // -- Debug_functions